@@ -2,18 +2,107 @@
 #define _AD5940_H_
 
 #include <Arduino.h>
-#include <SPI.h>
+#include "hal/hal.h"
 
-// AD5940 Register Definitions
-#define AD5940_SPIREG_M_READY       0x20000000
-#define AD5940_SPIREG_M_OVERFLOW    0x40000000
-#define AD5940_SPIREG_M_UNDERFLOW   0x80000000
+// SPI framing: SETADDR + 16-bit address, then WRITEREG or READREG (one
+// dummy byte) + data. Registers 0x1000-0x3014 are 32 bits wide, the rest 16.
+#define AD5940_SPICMD_SETADDR       0x20
+#define AD5940_SPICMD_READREG       0x6D
+#define AD5940_SPICMD_WRITEREG      0x2D
+#define AD5940_SPICMD_READFIFO      0x5F
+#define AD5940_FIFO_DUMMY_BYTES     6          // Clocked out after READFIFO before the first word
+#define AD5940_FIFO_TAIL_BYTE       0x44       // Sent while the last two FIFO words are clocked out
 
-// AD5940 Commands
-#define AD5940_SPICMD_GETID         0x62
-#define AD5940_SPICMD_RESET         0x63
-#define AD5940_SPICMD_SETREG        0x20
-#define AD5940_SPICMD_GETREG        0x60
+// Always-on domain: GPIO, identification, reset, clocks and sequence triggers
+#define AD5940_REG_GP0CON           0x0000
+#define AD5940_REG_GP0OEN           0x0004
+#define AD5940_REG_CHIPID           0x0404
+#define AD5940_REG_CLKSEL           0x0414
+#define AD5940_REG_SWRSTCON         0x0424
+#define AD5940_REG_TRIGSEQ          0x0430
+
+// Analog front end
+#define AD5940_REG_AFECON           0x2000
+#define AD5940_REG_SEQCON           0x2004
+#define AD5940_REG_FIFOCON          0x2008
+#define AD5940_REG_SWCON            0x200C
+#define AD5940_REG_HSDACCON         0x2010
+#define AD5940_REG_WGCON            0x2014
+#define AD5940_REG_WGFCW            0x2030     // Sine frequency word: f = WGFCW * 16 MHz / 2^30
+#define AD5940_REG_WGPHASE          0x2034
+#define AD5940_REG_WGOFFSET         0x2038
+#define AD5940_REG_WGAMPLITUDE      0x203C
+#define AD5940_REG_ADCFILTERCON     0x2044
+#define AD5940_REG_DATAFIFORD       0x206C
+#define AD5940_REG_CMDFIFOWRITE     0x2070
+#define AD5940_REG_DFTCON           0x20D0
+#define AD5940_REG_HSRTIACON        0x20F0
+#define AD5940_REG_HSTIACON         0x20FC
+#define AD5940_REG_DSWFULLCON       0x2150
+#define AD5940_REG_NSWFULLCON       0x2154
+#define AD5940_REG_PSWFULLCON       0x2158
+#define AD5940_REG_TSWFULLCON       0x215C
+#define AD5940_REG_ADCCON           0x21A8
+#define AD5940_REG_SEQ0INFO         0x21CC     // Sequence 0: length << 16 | start address
+#define AD5940_REG_CMDFIFOWADDR     0x21D4
+#define AD5940_REG_CMDDATACON       0x21D8
+#define AD5940_REG_FIFOCNTSTA       0x2200     // Data FIFO word count in bits 26:16
+#define AD5940_REG_PMBW             0x22F0
+#define AD5940_REG_INTCPOL          0x3000
+#define AD5940_REG_INTCCLR          0x3004
+#define AD5940_REG_INTCSEL0         0x3008
+#define AD5940_REG_INTCFLG0         0x3010
+
+#define AD5940_CHIPID               0x5502
+#define AD5940_SWRST_KEY            0xA158
+
+#define AD5940_AFECON_DACEN         0x00000040
+#define AD5940_AFECON_ADCEN         0x00000080
+#define AD5940_AFECON_ADCCONVEN     0x00000100
+#define AD5940_AFECON_EXBUFEN       0x00000200
+#define AD5940_AFECON_INAMPEN       0x00000400
+#define AD5940_AFECON_TIAEN         0x00000800
+#define AD5940_AFECON_WAVEGENEN     0x00004000
+#define AD5940_AFECON_DFTEN         0x00008000
+#define AD5940_AFECON_DACREFEN      0x00100000
+#define AD5940_FIFOCON_DFT          0x00004800 // Data FIFO on, fed by the DFT
+#define AD5940_INT_ENDSEQ           0x00008000 // A sequence ran to its end
+
+// Excitation: 16 MHz HSDAC update rate, sine generator at full scale (~800 mVpp)
+#define AD5940_HSDACCON_RATE_16MHZ  (7 << 1)
+#define AD5940_WGCON_SINE           (2 << 1)
+#define AD5940_WG_AMPLITUDE         2047
+#define AD5940_PMBW_LP_250KHZ       (3 << 2)   // Low-power mode, 250 kHz analog bandwidth
+
+// Board wiring: excitation out on CE0, current back through AIN1 into a
+// 1 kOhm RTIA, the body voltage sensed between AIN2 and AIN3
+#define AD5940_SWCON_FULLCON        0x00010000 // Switches from the *SWFULLCON registers
+#define AD5940_SWD_CE0              0x00000010
+#define AD5940_SWP_CE0              0x00000010
+#define AD5940_SWN_AIN1             0x00000002
+#define AD5940_SWT_AIN1             0x00000002
+#define AD5940_SWT_TRTIA            0x00000100
+#define AD5940_HSRTIA_1K            0x00000001
+#define AD5940_ADCCON_AIN2_AIN3     (0x06 | (0x07 << 8))   // PGA gain 1
+
+// ADC at 800 kSPS through SINC3 (OSR 2) into a Hanning-windowed DFT
+#define AD5940_ADCFILTER_800KSPS    0x00000001
+#define AD5940_ADCFILTER_SINC3_OSR2 (2 << 12)
+#define AD5940_ADCFILTER_LPF_BYPASS 0x00000010
+#define AD5940_DFT_SAMPLE_HZ        400000UL
+#define AD5940_DFTCON_HANNING       0x00000001
+#define AD5940_DFTCON_SINC3         (1UL << 20)
+#define AD5940_DFTCON_NUM(code)     ((uint32_t)(code) << 4)  // 4 << code samples
+#define AD5940_DFTNUM_MAX_CODE      12
+
+// Sequencer SRAM split: 2 kB of commands, 4 kB of data FIFO
+#define AD5940_CMDDATACON_SEQ_FIFO  (1 | (1 << 3) | (2 << 6) | (2 << 9))
+#define AD5940_GP0_INT0             0x00000000
+
+// Sequencer commands: write a 24-bit value to an AFE register, or wait
+#define AD5940_SEQ_WR(addr, data)   (0x80000000UL | ((uint32_t)(((addr) & 0x1FF) >> 2) << 24) | ((data) & 0xFFFFFF))
+#define AD5940_SEQ_WAIT(clocks)     ((uint32_t)(clocks) & 0x3FFFFFFF)
+#define AD5940_SYSCLK_HZ            16000000UL
 
 // BIA Configuration
 #define BIA_MAX_DATACOUNT           6000
@@ -21,6 +110,12 @@
 #define BIA_FREQ_END                100000.0f  // End frequency in Hz
 #define BIA_FREQ_POINTS             100        // Number of frequency points
 
+// Hardware-sequenced sweeps
+#define AD5940_SWEEP_MAX_POINTS     16         // Points per sequence (two FIFO words each)
+#define AD5940_SWEEP_SETTLE_US      1000       // Excitation on before the DFT starts
+#define AD5940_SWEEP_DFT_US         2000       // DFT window, stretched to 4 periods at low frequencies
+#define AD5940_SWEEP_DFT_MARGIN_US  100        // Past the last DFT sample before the result is taken
+
 // Data structures
 typedef struct {
     float Real;
@@ -47,27 +142,42 @@ public:
     
     // BIA specific functions
     bool initializeBIA();
-    bool startBIA();
-    bool stopBIA();
-    bool getBIAData(fFreqPoint* data, uint32_t* count);
     fImpPolar calculateImpedance(uint32_t realData, uint32_t imagData);
     
+    // Hardware-sequenced sweep: the frequency table is loaded once into the
+    // sequencer's SRAM, then every sweep is one trigger. The AD5940 steps
+    // through the points on its own, queues each DFT result (real, imaginary)
+    // in its data FIFO and raises INT at the end of the sequence.
+    bool loadSweep(const float* frequencies, uint32_t count);
+    bool startSweep();
+    bool isSweepDone();                         // The INT flag, or INTCFLG0 without an INT pin
+    bool waitForSweep(uint32_t timeoutMs);      // Sleeps on the interrupt where there is one
+    bool stopSweep();                           // Sequencer off, FIFO flushed, after a timeout
+    // The whole FIFO in one SPI burst: real, imaginary for each point in turn,
+    // sign-extended from 18 bits. Returns the words read.
+    uint32_t readSweepResults(uint32_t* words, uint32_t maxWords);
+    static void onInterrupt();
+    
     // Low level functions
     bool writeRegister(uint16_t addr, uint32_t data);
     uint32_t readRegister(uint16_t addr);
-    bool isReady();
     
 private:
     int _csPin;
     int _resetPin;
     int _intPin;
     bool _initialized;
+    uint32_t _sweepPoints;
+    volatile bool _sweepDone;
+#ifdef ARDUINO
+    volatile TaskHandle_t _sweepWaiter;     // Task blocked in waitForSweep(), if any
+#endif
     
+    void writeWord(uint16_t addr, uint32_t data);   // No read-back, for FIFOs and self-clearing bits
+    void setAddress(uint16_t addr);
     void selectChip();
     void deselectChip();
     uint8_t spiTransfer(uint8_t data);
-    void spiWrite16(uint16_t data);
-    uint32_t spiRead32();
     
     // BIA configuration
     bool configureClock();
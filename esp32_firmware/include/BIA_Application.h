@@ -39,8 +39,26 @@ public:
     // Data acquisition
     bool getResult(BIAResult& result);
     bool performSingleMeasurement(float frequency, BIAResult& result);
+    
+    // Non-blocking single measurement: begin, poll, finish (a one-point sweep)
+    bool beginMeasurement(float frequency);
+    bool isResultReady();
+    bool finishMeasurement(BIAResult& result);
     bool performFrequencySweep(BIAResult* results, uint32_t maxResults, uint32_t* actualCount);
     
+    // Hardware-sequenced sweep of up to AD5940_SWEEP_MAX_POINTS frequencies:
+    // begin, wait for INT (isSweepReady() costs no bus traffic with an INT
+    // pin), finish with one FIFO read. The table is only reloaded when it changes.
+    bool beginSweep(const float* frequencies, uint32_t count);
+    bool isSweepReady();
+    uint32_t finishSweep(BIAResult* results, uint32_t maxResults);   // Results in table order
+    bool performSweep(const float* frequencies, uint32_t count, BIAResult* results, uint32_t* actualCount,
+                      uint32_t timeoutMs = 1000);
+    void cancelSweep();             // Stops the sequencer and flushes the FIFO after a timeout
+    
+    // DFT real/imaginary words to a calibrated result (Frequency left as is)
+    void processRawData(uint32_t realData, uint32_t imagData, BIAResult& result);
+    
     // Calibration
     bool calibrate(float knownResistance = 1000.0f);
     bool setCalibrationFactors(float gainFactor, float phaseOffset);
@@ -52,14 +70,14 @@ public:
 private:
     BIAConfig _config;
     bool _initialized;
-    bool _measuring;
     float _calibrationGain;
     float _calibrationPhase;
     uint32_t _currentFreqIndex;
+    float _sweepFrequencies[AD5940_SWEEP_MAX_POINTS];
+    uint32_t _sweepPoints;          // Loaded into the sequencer, 0 for none
+    bool _sweeping;
     
-    bool setFrequency(float frequency);
-    bool waitForResult(uint32_t timeoutMs = 1000);
-    void processRawData(uint32_t realData, uint32_t imagData, BIAResult& result);
+    void applyCalibration(const fImpPolar& impedance, BIAResult& result);
 };
 
 #endif // _BIA_APPLICATION_H_
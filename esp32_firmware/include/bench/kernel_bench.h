@@ -0,0 +1,109 @@
+#ifndef BENCH_KERNEL_BENCH_H
+#define BENCH_KERNEL_BENCH_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+// Microbenchmarks of the hot kernels, on the ESP32 and on the host.
+// Each kernel is called in batches, doubling until a batch takes a tenth of
+// the time budget, then batch after batch until the budget is spent; the
+// fastest batch is reported, as the one least disturbed by interrupts and
+// the scheduler. On the ESP32 the CPU cycle counter (CCOUNT) is read around
+// every batch, so results are in cycles per sample as well as ns per op.
+// Results come out as JSON (see kernelBenchJSON()) so two runs, say of two
+// firmware versions, can be compared mechanically.
+
+struct KernelBenchResult {
+    std::string name;
+    uint32_t samplesPerOp;      // Samples one call processes, 1 for per-call kernels
+    uint64_t ops;               // Calls timed in all batches
+    double nsPerOp;             // Fastest batch
+    double cyclesPerOp;         // Same batch, -1 without a cycle counter
+
+    double nsPerSample() const { return nsPerOp / samplesPerOp; }
+    double cyclesPerSample() const { return cyclesPerOp < 0 ? -1 : cyclesPerOp / samplesPerOp; }
+};
+
+// A fresh reading of the clocks
+struct KernelBenchStamp {
+    uint64_t ns;
+    uint32_t cycles;            // CCOUNT, wraps every ~18 s at 240 MHz
+};
+
+KernelBenchStamp kernelBenchNow();
+bool kernelBenchHasCycles();
+uint32_t kernelBenchCpuMhz();  // 0 where unknown
+
+class KernelBench {
+public:
+    explicit KernelBench(double secondsPerKernel = 0.25) : budgetNs(secondsPerKernel * 1e9) {}
+
+    // Only kernels whose name starts with the filter run (empty runs all)
+    void setFilter(const std::string& prefix) { filter = prefix; }
+
+    // Times op(), which processes samplesPerOp samples per call
+    template <typename Op>
+    void run(const char* name, uint32_t samplesPerOp, Op op) {
+        if (!filter.empty() && std::string(name).compare(0, filter.size(), filter) != 0) {
+            return;
+        }
+        op();   // Warm the caches and any lazy state
+        KernelBenchResult result = {name, samplesPerOp, 0, 0, -1};
+        uint32_t batch = 1;
+        double spentNs = 0;
+        double bestNs = -1;
+        double bestCycles = -1;
+        while (spentNs < budgetNs) {
+            KernelBenchStamp start = kernelBenchNow();
+            for (uint32_t i = 0; i < batch; i++) {
+                op();
+            }
+            KernelBenchStamp end = kernelBenchNow();
+            double ns = (double)(end.ns - start.ns);
+            spentNs += ns;
+            result.ops += batch;
+            if (ns < budgetNs / 10 && batch < (1u << 24)) {
+                batch *= 2;     // Still ramping up: too short to trust
+                continue;
+            }
+            if (bestNs < 0 || ns / batch < bestNs) {
+                bestNs = ns / batch;
+                bestCycles = kernelBenchHasCycles() ? (double)(uint32_t)(end.cycles - start.cycles) / batch : -1;
+            }
+        }
+        result.nsPerOp = bestNs;
+        result.cyclesPerOp = bestCycles;
+        results.push_back(result);
+    }
+
+    const std::vector<KernelBenchResult>& getResults() const { return results; }
+
+private:
+    double budgetNs;
+    std::string filter;
+    std::vector<KernelBenchResult> results;
+};
+
+// The results as one JSON object:
+//   {"suite":"biotrack-kernels","firmware":"1.0.2","platform":"esp32","cpu_mhz":240,
+//    "kernels":[{"name":"ecg_bandpass","samples_per_op":25,"ops":4096,
+//                "ns_per_op":...,"ns_per_sample":...,"cycles_per_op":...,"cycles_per_sample":...},...]}
+// The cycle fields are null where there is no cycle counter.
+std::string kernelBenchJSON(const std::vector<KernelBenchResult>& results);
+
+// Every kernel of the firmware's hot paths, on the synthetic workload
+void runDspKernels(KernelBench& bench);
+
+#ifndef ARDUINO
+// Reads back what kernelBenchJSON() wrote; false if it isn't that format
+bool parseKernelBenchJSON(const std::string& json, std::vector<KernelBenchResult>& results);
+
+// Kernels in both runs that got slower by more than tolerancePercent, in
+// cycles per sample when both runs have them and ns per sample otherwise.
+// Appends a line per kernel to report; returns the number of regressions.
+int compareKernelBench(const std::vector<KernelBenchResult>& baseline, const std::vector<KernelBenchResult>& current,
+                       float tolerancePercent, std::string& report);
+#endif
+
+#endif // BENCH_KERNEL_BENCH_H
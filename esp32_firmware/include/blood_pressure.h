@@ -2,6 +2,19 @@
 #define BLOOD_PRESSURE_H
 
 #include <Arduino.h>
+#include "sensors/spsc_ring.h"
+#include "dsp/peak_timing.h"
+#include "dsp/bandpass_designs.h"
+#include "dsp/pipeline.h"
+#include "dsp/qrs_detector.h"
+#include "dsp/ppg_fiducials.h"
+#include "dsp/beat_pairer.h"
+#include "dsp/rolling_median.h"
+#include "dsp/ecg_ppg_correlator.h"
+#include "dsp/hrv_engine.h"
+#include "dsp/signal_quality.h"
+#include "sensors/ppg_acquisition.h"
+#include "config.h"
 
 // Forward declaration to avoid circular dependency
 struct SensorReadings;
@@ -24,6 +37,8 @@ struct BloodPressureData {
     float signalQuality;     // Overall signal quality (0-100%)
     int correlationCoeff;    // ECG-PPG correlation (-100 to +100)
     bool rhythmRegular;      // Heart rhythm regularity
+    float correlationPTT;    // PTT from the ECG-PPG correlation lag (ms), 0 without a full window
+    HrvMetrics hrv;          // Time and frequency domain HRV over the last ~2 minutes
 };
 
 struct CalibrationPoint {
@@ -44,65 +59,93 @@ private:
     float diastolicIntercept = 120.0;
       // Signal processing buffers
     static const int BP_BUFFER_SIZE = 200;
-    static const int ECG_SAMPLE_RATE = 200; // 200 Hz
-    static const int PPG_SAMPLE_RATE = 100; // 100 Hz
+    static const int ECG_SAMPLE_RATE = ECG_STREAM_SAMPLE_RATE; // Hz, AD8232 timer stream
+    static const int PPG_SAMPLE_RATE = PPG_STREAM_SAMPLE_RATE; // Hz, MAX30102 FIFO stream
+    
+    // Filtered sample history (newest BP_BUFFER_SIZE samples of each signal)
+    struct Sample {
+        float value;
+        uint64_t timestampUs;
+    };
+    typedef SpscRing<Sample, spscRingCapacityFor(BP_BUFFER_SIZE)> SampleHistory;
     
     // ECG processing
-    float ecgBuffer[BP_BUFFER_SIZE];
-    int ecgBufferIndex = 0;
-    unsigned long ecgTimestamps[BP_BUFFER_SIZE];
+    SampleHistory ecgBuffer;
+    int ecgSampleCount = 0;     // Samples seen since reset, used as peak index
     
     // PPG processing  
-    float ppgBuffer[BP_BUFFER_SIZE];
-    int ppgBufferIndex = 0;
-    unsigned long ppgTimestamps[BP_BUFFER_SIZE];
-    
-    // Peak detection
-    struct Peak {
-        int index;
-        float value;
-        unsigned long timestamp;
-    };
+    SampleHistory ppgBuffer;
+    int ppgSampleCount = 0;
     
-    Peak ecgPeaks[20];      // Store last 20 ECG R-peaks
-    Peak ppgPeaks[20];      // Store last 20 PPG peaks
+    static const int PPG_BLOCK_SIZE = 32;     // Samples filtered and searched per pass
     int ecgPeakCount = 0;
     int ppgPeakCount = 0;
     
-    // Heart rate variability
-    float rrIntervals[50];   // R-R intervals for HRV
-    int rrCount = 0;
-    
-    // Adaptive thresholds
-    float ecgThreshold = 1500;
-    float ppgThreshold = 50000;
-    bool adaptiveThresholding = true;
-    
-    // Quality assessment
+    // PTT: each R-peak pairs with the first pulse 50-500 ms after it, as the
+    // events arrive. Strictly this is the pulse arrival time (it includes the
+    // pre-ejection period), which is what the calibration maps to BP.
+    static const int PTT_HISTORY = 32;
+    static const int PTT_MIN_PAIRS = 3;
+    BeatPairer beatPairer = BeatPairer(50000, 500000);
+    RollingMedian<PTT_HISTORY> pttHistory;      // µs, median/MAD kept current
+    uint32_t pttOutliers = 0;
+    int pttOutlierRun = 0;                      // Consecutive outliers, to follow a real step
+    
+    // Second PTT estimate from the lag of the whole-waveform correlation,
+    // which also scores how well the two signals line up
+    EcgPpgCorrelator ecgPpgCorrelator;
+    static const uint32_t PTT_AGREEMENT_US = 40000;
+    
+    // Heart rate variability, updated on every R-peak
+    HrvEngine hrvEngine = HrvEngine(HRV_SPECTRUM_INTERVAL_MS);
+    
+    // Which pulse fiducial PTT is measured to
+    PulseFiducial pttFiducial = PulseFiducial::MAX_SLOPE;
+    
+    // Quality assessment: the streams' latest SQI windows for each channel
+    SignalQualityIndex ecgQuality = {};
+    SignalQualityIndex ppgQuality = {};
     float lastSignalQuality = 0;
     unsigned long lastValidReading = 0;
     
-    // Advanced filtering
-    float ecgFilterBuffer[10];
-    float ppgFilterBuffer[10];
-    int filterIndex = 0;
+    // Band-pass filters (0.5-40 Hz ECG, 0.5-8 Hz PPG), designed at compile
+    // time for the stream rates and primed from the first sample after a
+    // reset. The filtered signal is tapped for the history and correlator;
+    // the PPG then goes on to the pulse fiducials, interpolated on sample time.
+    // The shifts scale each signal into Q15 on the fixed-point back end.
+    enum { TAP_FILTERED };
+    static const int ECG_Q15_SHIFT = 3;         // 12-bit ADC counts
+    static const int PPG_Q15_SHIFT = -4;        // 18-bit MAX30102 counts
+    typedef ECGBandpass<ECG_SAMPLE_RATE> ECGFilterDesign;
+    typedef PPGBandpass<PPG_SAMPLE_RATE> PPGFilterDesign;
+    Pipeline<BandpassStage<ECGFilterDesign, ECG_Q15_SHIFT>, TapStage<TAP_FILTERED> > ecgPipeline;
+    Pipeline<BandpassStage<PPGFilterDesign, PPG_Q15_SHIFT>, TapStage<TAP_FILTERED>, PulseFiducialStage> ppgPipeline;
+    
+    struct ECGEvents {
+        BloodPressureMonitor& monitor;
+        void on(const TappedBlock<TAP_FILTERED>& tap);
+    };
+    struct PPGEvents {
+        BloodPressureMonitor& monitor;
+        void on(const TappedBlock<TAP_FILTERED>& tap);
+        void on(const PulseFiducials& beat);
+    };
+    PulseFiducialDetector& pulseFiducials() { return ppgPipeline.stage<2>().detector(); }
     
     // Methods
-    void updateECGBuffer(float value, unsigned long timestamp);
-    void updatePPGBuffer(float value, unsigned long timestamp);
+    void updateECGBuffer(float value, uint64_t timestampUs);
+    void updatePPGBuffer(float value, uint64_t timestampUs);
     
-    bool detectECGPeak(float value, int index);
-    bool detectPPGPeak(float value, int index);
     
-    float calculatePTT();
+    void addPairedBeat(const PairedBeat& pair);
+    float calculatePTT();   // Median PTT in microseconds, -1 until enough beats pair up
     float calculatePWV(float ptt);
-    float calculateHRV();
+    float calculateHRV();   // RMSSD (ms)
     float assessSignalQuality();
     int calculateCorrelation();
+    float calculateCorrelationPTT();    // Lag in microseconds, -1 without a usable peak
     bool checkRhythmRegularity();
     
-    float applyBandpassFilter(float* buffer, float newValue);
-    void adaptThresholds();
     void updateCalibration();
     
     // Machine learning-inspired features
@@ -117,9 +160,24 @@ public:
     bool begin();
     void reset();
     
-    // Data input (called from sensor readings)
-    void addECGSample(float ecgValue, unsigned long timestamp);
-    void addPPGSample(float irValue, float redValue, unsigned long timestamp);
+    // Data input. Timestamps are the 64-bit esp_timer microseconds at which
+    // each sample was acquired.
+    // Raw ECG: band-passed into the ECG buffer and the correlator only. It
+    // finds no R-peaks, so HRV, PTT and the peak count stay put unless the
+    // caller also runs a QrsDetector and forwards its beats to addRPeak().
+    void addECGSample(float ecgValue, uint64_t timestampUs);
+    // ECG already band-passed 0.5-40 Hz at ECG_SAMPLE_RATE (the stream's QRS path)
+    void addFilteredECG(const float* values, const uint64_t* timestampsUs, size_t count);
+    void addPPGSample(float irValue, float redValue, uint64_t timestampUs);
+    void addPPGBlock(const PPGSample* samples, size_t count);   // A FIFO burst in one pass
+    
+    // R-peaks from the shared QrsDetector, for HRV and PTT. They arrive a
+    // couple of hundred ms after the R-wave, stamped with its source time.
+    void addRPeak(const QrsEvent& beat);
+    
+    // SQI of the ECG and PPG as the streams last assessed them; beats and
+    // readings are skipped while either channel scores below SQI_MIN_SCORE
+    void setSignalQuality(const SignalQualityIndex& ecg, const SignalQualityIndex& ppg);
     
     // Main processing
     BloodPressureData calculateBloodPressure();
@@ -137,7 +195,10 @@ public:
     String getVascularHealthIndex();
     
     // Configuration
-    void setAdaptiveMode(bool enable) { adaptiveThresholding = enable; }
+    void setAdaptiveMode(bool enable) { pulseFiducials().setAdaptive(enable); }
+    void setPTTFiducial(PulseFiducial fiducial);
+    PulseFiducial getPTTFiducial() const { return pttFiducial; }
+    const HrvMetrics& getHRV() const { return hrvEngine.getMetrics(); }
     void setSampleRates(int ecgRate, int ppgRate);
     void setPersonalParameters(int age, float height, bool isMale);
     
@@ -3,6 +3,7 @@
 
 #include <Arduino.h>
 #include "BIA_Application.h"
+#include "dsp/signal_quality.h"
 
 // User profile for body composition calculations
 struct UserProfile {
@@ -77,7 +78,8 @@ public:
     
     // Validation and quality assessment
     bool validateBIAData(const BIAResult& result);
-    float assessMeasurementQuality(const BIAResult* results, int count);
+    float assessMeasurementQuality(const BIAResult* results, int count);   // Feeds the sweep's SQI; its score
+    const SignalQualityIndex& getSweepQuality() const { return sweepQuality.getIndex(); }
     
     // Health categorization
     BMICategory getBMICategory(float bmi) const;
@@ -98,6 +100,11 @@ private:
     bool profileSet;
     bool athleteModeEnabled;
     
+    // Each sweep's phase spectrum is one SQI window and one beat, matched
+    // against the previous sweeps; points failing validateBIAData() count as clipped
+    static const uint16_t QUALITY_SWEEP_POINTS = 5;     // The 1-100 kHz sweep
+    SignalQualityEngine sweepQuality;
+    
     // Equation parameters (can be calibrated)
     float fatFreeMassConstant;  // Typically around 0.593 for adults
     float fatMassConstant;      // Typically around 0.146 for adults
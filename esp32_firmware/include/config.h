@@ -82,16 +82,29 @@
 // ===================================================
 // Board pin references for ESP32 WROOM-32 DevKit v1
 
-// MAX30102 Sensor (Single sensor - software staged testing)
-// Connected to GPIO 21 (SDA) and GPIO 22 (SCL) for all measurement modes
+// MAX30102 Sensor (Single sensor shared by HR/SpO2, glucose and BP)
+// Connected to GPIO 21 (SDA) and GPIO 22 (SCL)
 #define MAX30102_SDA_PIN 21      // GPIO21 - I2C0 SDA (Board Pin D21)
 #define MAX30102_SCL_PIN 22      // GPIO22 - I2C0 SCL (Board Pin D22)
-
-// Staged Testing Configuration - Single MAX30102 sensor modes:
-// Mode 1: Heart Rate & SpO2 measurement (primary function)
-// Mode 2: Glucose estimation (PPG morphology analysis) 
-// Mode 3: Blood pressure estimation (PPG for PTT calculation)
-// Note: Software switches between measurement modes, no hardware changes needed
+#define MAX30102_INT_PIN 27      // GPIO27 - FIFO almost-full interrupt, active low (Board Pin D27)
+
+// MAX30102 FIFO streaming (INT-driven burst reads into a ring buffer)
+#define PPG_STREAM_SAMPLE_RATE 200       // Hz (50-400 in SpO2 mode)
+#define PPG_STREAM_TASK_STACK 2048
+#define PPG_STREAM_TASK_PRIORITY 4       // Above SensorTask so the FIFO never overflows
+#define PPG_STREAM_RED_AMPLITUDE 0x0A    // Initial LED1_PA (Red)
+#define PPG_STREAM_IR_AMPLITUDE 0x1F     // Initial LED2_PA (IR)
+
+// One stream feeds HR/SpO2, glucose features and BP/PTT at the same time.
+// The part is only reprogrammed when a consumer needs a faster rate than the
+// stream runs at, or the DC level leaves the range every consumer can use.
+#define PPG_HR_MIN_SAMPLE_RATE 100       // Hz needed by each consumer
+#define PPG_GLUCOSE_MIN_SAMPLE_RATE 50
+#define PPG_BP_MIN_SAMPLE_RATE 200       // Peak times are interpolated, so 200 Hz is enough for PTT
+#define PPG_DC_LOW 50000                 // Raise LED current below this DC level (HR finger threshold)
+#define PPG_DC_HIGH 140000               // Lower it above this (under GLUCOSE_MAX_SIGNAL)
+#define PPG_NO_CONTACT_DC 10000          // Nothing on the sensor: leave the current alone
+#define PPG_LED_RANGING_WINDOW_MS 2000   // DC level is judged over this window
 
 // GPIO 13 and 18 are now available for other sensors
 // Previous glucose-specific pins removed - using single MAX30102 for all modes
@@ -117,6 +130,23 @@
 #define LO_PLUS_PIN 32           // GPIO32 - Leads-off detect + (Board Pin D32/ADC1_CH4)
 #define LO_MINUS_PIN 33          // GPIO33 - Leads-off detect - (Board Pin D33/ADC1_CH5)
 
+// AD8232 continuous sampling (hardware timer -> sampling task -> block ring buffer)
+#define ECG_STREAM_SAMPLE_RATE 250       // Hz (250-500)
+#define ECG_STREAM_BLOCK_SIZE 25         // Frames per block handed to consumers (100 ms at 250 Hz)
+#define ECG_STREAM_TIMER 1               // Hardware timer index (1 MHz tick)
+#define ECG_STREAM_TASK_STACK 2048
+#define ECG_STREAM_TASK_PRIORITY 5       // Highest sensor priority, one ADC read per tick
+#define HRV_SPECTRUM_INTERVAL_MS 5000    // LF/HF re-evaluated this often (time-domain HRV every beat)
+
+// Heart rate fused from ECG R-R, the PPG spectrum and Maxim's spo2_algorithm
+#define HR_FUSION_MAX_AGE_MS 5000        // A source that hasn't reported for this long drops out
+#define HR_FUSION_ECG_CONFIDENCE 0.9f    // QRS detector past its learning phase, leads on
+#define HR_FUSION_MAXIM_CONFIDENCE 0.4f  // Peak counting over 4 s, coarse and prone to doubling
+
+// Signal quality indices (dsp/signal_quality.h) for ECG, PPG and BIA
+#define SQI_WINDOW_SECONDS 4             // ECG and PPG assessed over windows this long
+#define SQI_MIN_SCORE 50.0f              // Windows scoring below this (0-100) are skipped
+
 // Available GPIO pins (freed up from glucose I2C)
 #define AVAILABLE_PIN_13 13      // GPIO13 - Available for expansion (Board Pin D13)
 #define AVAILABLE_PIN_18 18      // GPIO18 - Available for expansion (Board Pin D18)
@@ -130,11 +160,31 @@
 // Measurement Intervals (milliseconds)
 #define HEART_RATE_INTERVAL 5000    // 5 seconds
 #define TEMPERATURE_INTERVAL 5000   // 5 seconds (updated for faster DS18B20 readings)
+#define DS18B20_RESOLUTION 12            // 9-12 bits; 12-bit conversions take 750 ms
+#define DS18B20_CONVERSION_INTERVAL 1000 // Start-to-start spacing of async conversions (ms)
 #define WEIGHT_INTERVAL 2000        // 2 seconds
 #define BIOIMPEDANCE_INTERVAL 15000 // 15 seconds
 #define ECG_INTERVAL 5000           // 5 seconds
-#define GLUCOSE_INTERVAL 10000      // 10 seconds
+#define GLUCOSE_INTERVAL 5000       // 5 seconds
 #define SENSOR_SAMPLE_RATE 5000     // 5 seconds for general sensor sampling
+#define BLOOD_PRESSURE_INTERVAL 5000 // 5 seconds
+
+// Sensor scheduler (each sensor is a non-blocking job released at its own interval)
+#define SENSOR_SCHEDULER_TICK_MS 20       // sensorTask period
+#define SENSOR_SCHEDULER_BUDGET_US 5000   // CPU time one tick may spend stepping jobs
+#define SENSOR_SCHEDULER_STAGGER_MS 150   // Offset between first releases so jobs don't pile up
+#define BIA_SWEEP_TIMEOUT_MS 1000         // Give up on a sequenced sweep the AD5940 never completes
+
+// Task-per-sensor manager (TaskSafeSensorManager) instead of the scheduler above.
+// Build with -DUSE_TASK_SAFE_SENSOR_MANAGER=1 (pio run -e esp32dev_tasksafe) to compare.
+#ifndef USE_TASK_SAFE_SENSOR_MANAGER
+#define USE_TASK_SAFE_SENSOR_MANAGER 0
+#endif
+#define TASK_SAFE_AGGREGATOR_PERIOD_MS 1000  // Fixed cadence of aggregated SensorReadings
+#define TASK_SAFE_I2C_CORE 0                 // MAX30102 and DS18B20 tasks
+#define TASK_SAFE_SPI_CORE 1                 // AD5940, HX711 and aggregator tasks
+#define TASK_SAFE_SENSOR_TASK_PRIORITY 3
+#define TASK_SAFE_AGGREGATOR_PRIORITY 4      // Above the sensor tasks so the cadence holds
 
 // Glucose Monitor Configuration
 #define GLUCOSE_WINDOW_SIZE 10
@@ -191,7 +241,7 @@
  * GPIO 23: AD5941_MOSI_PIN               (Board Pin D23/MOSI) - BIA sensor SPI data out
  * GPIO 25: AD5941_RESET_PIN              (Board Pin D25) - BIA sensor reset
  * GPIO 26: AD5941_INT_PIN                (Board Pin D26) - BIA sensor interrupt
- * GPIO 27: [UNUSED]                       (Board Pin D27) - Available for future use
+ * GPIO 27: MAX30102_INT_PIN              (Board Pin D27) - MAX30102 FIFO interrupt
  * GPIO 32: LO_PLUS_PIN                   (Board Pin D32/ADC1_CH4) - ECG lead off +
  * GPIO 33: LO_MINUS_PIN                  (Board Pin D33/ADC1_CH5) - ECG lead off -
  * GPIO 36: ECG_PIN                       (Board Pin VP/ADC1_CH0) - ECG analog input (input only)
@@ -231,7 +281,7 @@
  * - No hardware pump needed - purely algorithmic approach
  * - Requires calibration with reference BP measurements
  * - Accuracy depends on signal quality and individual calibration
- * - GPIO 12 and 27 are now available for other sensors if needed
+ * - GPIO 12 is now available for other sensors if needed
  *
  * Available for future use: GPIO 15 (WROOM-32 safe)
  * 
@@ -241,46 +291,6 @@
  * GPIO 34,35,39: Input only (GPIO 36 used for ECG input)
  */
 
-// ===================================================
-// MAX30102 Staged Testing Configuration
-// ===================================================
-// Single sensor operation modes - software controlled
-
-enum MAX30102_Mode {
-    MODE_HEART_RATE_SPO2 = 0,    // Primary: Heart rate and SpO2 measurement
-    MODE_GLUCOSE_ESTIMATION = 1,  // PPG morphology analysis for glucose
-    MODE_BLOOD_PRESSURE = 2,     // PPG for pulse transit time calculation
-    MODE_CALIBRATION = 3         // Sensor calibration and baseline measurement
-};
-
-// Current mode tracking
-extern MAX30102_Mode currentMAX30102Mode;
-
-// Mode switching functions
-inline void setMAX30102Mode(MAX30102_Mode mode) {
-    currentMAX30102Mode = mode;
-}
-
-inline MAX30102_Mode getMAX30102Mode() {
-    return currentMAX30102Mode;
-}
-
-// Mode-specific measurement intervals (milliseconds)
-#define HR_SPO2_SAMPLE_RATE 1000      // 1 second for heart rate/SpO2
-#define GLUCOSE_SAMPLE_RATE 5000      // 5 seconds for glucose estimation  
-#define BP_PPG_SAMPLE_RATE 500        // 500ms for blood pressure PTT
-#define CALIBRATION_SAMPLE_RATE 2000  // 2 seconds for calibration
-
-// Mode switching intervals (how long to stay in each mode)
-#define MODE_DURATION_HR_SPO2 30000   // 30 seconds
-#define MODE_DURATION_GLUCOSE 20000   // 20 seconds
-#define MODE_DURATION_BP 15000        // 15 seconds
-#define MODE_DURATION_CALIBRATION 10000 // 10 seconds
-
-// Auto-cycling configuration
-#define ENABLE_AUTO_MODE_CYCLING true
-#define TOTAL_CYCLE_TIME 75000        // 75 seconds for complete cycle
-
 // WROOM-32 Board Validation Function
 inline bool isValidWROOMPin(int pin) {
     // Unusable pins on WROOM-32
@@ -323,6 +333,7 @@ inline bool validatePinConfiguration() {    // Array of all pin assignments for
         23,  // AD5941_MOSI_PIN
         25,  // AD5941_RESET_PIN
         26,  // AD5941_INT_PIN
+        27,  // MAX30102_INT_PIN
         32,  // LO_PLUS_PIN
         33,  // LO_MINUS_PIN
         36   // ECG_PIN (input-only)
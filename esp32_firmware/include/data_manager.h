@@ -3,9 +3,8 @@
 
 #include <Arduino.h>
 #include <ArduinoJson.h>
-#include <SPIFFS.h>
-#include <NTPClient.h>
-#include "sensors.h"
+#include "hal/hal.h"
+#include "sensor_readings.h"
 #include "config.h"
 
 // Data storage structures
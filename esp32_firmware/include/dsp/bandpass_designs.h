@@ -0,0 +1,50 @@
+#ifndef DSP_BANDPASS_DESIGNS_H
+#define DSP_BANDPASS_DESIGNS_H
+
+#include "dsp/biquad.h"
+
+// Band-pass designs for the biosignal channels
+// Each band is a 2nd-order Butterworth high-pass at the lower edge followed
+// by a 4th-order Butterworth low-pass at the upper edge. The high-pass comes
+// first so the fixed-point back end never sees the DC offset. Tables are
+// instantiated per sample rate and evaluated at compile time:
+//
+//   BiquadCascade<ECGBandpass<ECG_STREAM_SAMPLE_RATE>::SECTIONS>
+//       filter(ECGBandpass<ECG_STREAM_SAMPLE_RATE>::coeffs);
+
+template <uint32_t SampleRateHz, uint32_t LowCutMilliHz, uint32_t HighCutMilliHz>
+struct ButterworthBandpass {
+    static_assert(LowCutMilliHz < HighCutMilliHz, "Band edges out of order");
+    static_assert(HighCutMilliHz < SampleRateHz * 500u, "Upper band edge must be below Nyquist");
+
+    static constexpr size_t SECTIONS = 3;
+    static constexpr double LOW_CUT_HZ = LowCutMilliHz / 1000.0;
+    static constexpr double HIGH_CUT_HZ = HighCutMilliHz / 1000.0;
+
+    static constexpr BiquadCoeffs coeffs[SECTIONS] = {
+        BiquadDesign::highpass(LOW_CUT_HZ, SampleRateHz, BiquadDesign::butterworthQ(2, 0)),
+        BiquadDesign::lowpass(HIGH_CUT_HZ, SampleRateHz, BiquadDesign::butterworthQ(4, 0)),
+        BiquadDesign::lowpass(HIGH_CUT_HZ, SampleRateHz, BiquadDesign::butterworthQ(4, 1)),
+    };
+    static constexpr BiquadCoeffsQ14 coeffsQ14[SECTIONS] = {
+        BiquadDesign::toQ14(coeffs[0]),
+        BiquadDesign::toQ14(coeffs[1]),
+        BiquadDesign::toQ14(coeffs[2]),
+    };
+};
+
+// Out-of-class definitions so the tables can be bound by reference under C++11/14
+template <uint32_t R, uint32_t L, uint32_t H>
+constexpr BiquadCoeffs ButterworthBandpass<R, L, H>::coeffs[];
+template <uint32_t R, uint32_t L, uint32_t H>
+constexpr BiquadCoeffsQ14 ButterworthBandpass<R, L, H>::coeffsQ14[];
+
+// AD8232 ECG: baseline wander below 0.5 Hz, EMG and mains above 40 Hz
+template <uint32_t SampleRateHz>
+using ECGBandpass = ButterworthBandpass<SampleRateHz, 500, 40000>;
+
+// MAX30102 PPG: respiration/motion drift below 0.5 Hz, pulse harmonics up to 8 Hz
+template <uint32_t SampleRateHz>
+using PPGBandpass = ButterworthBandpass<SampleRateHz, 500, 8000>;
+
+#endif // DSP_BANDPASS_DESIGNS_H
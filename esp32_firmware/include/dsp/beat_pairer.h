@@ -0,0 +1,58 @@
+#ifndef DSP_BEAT_PAIRER_H
+#define DSP_BEAT_PAIRER_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Event-driven pairing of ECG R-peaks with PPG pulse fiducials
+// Every R-peak opens a window minUs..maxUs after it, and the first pulse
+// inside the oldest open window closes it. Beats are paired one to one and
+// each event is handled in constant time (the queues are a few entries).
+//
+// Both detectors report late, by different amounts (QRS ~200 ms, pulse
+// fiducials once the upstroke tops out), so a pulse may arrive before the
+// R-peak it belongs to. Such pulses wait in a short queue until the next
+// R-peak arrives and claims it, or shows it can't belong to any beat.
+// Event times are source timestamps, and each stream is in time order.
+
+struct PairedBeat {
+    uint64_t rPeakUs;
+    uint64_t pulseUs;
+    uint32_t transitUs;
+};
+
+class BeatPairer {
+public:
+    BeatPairer(uint32_t minUs, uint32_t maxUs);
+
+    // Each returns true when the event completed a pair
+    bool addRPeak(uint64_t timeUs, PairedBeat& pair);
+    bool addPulse(uint64_t timeUs, PairedBeat& pair);
+    void reset();
+
+    uint32_t getPairedCount() const { return paired; }
+    uint32_t getUnpairedRPeaks() const { return unpairedRPeaks; }     // Window closed without a pulse
+    uint32_t getUnpairedPulses() const { return unpairedPulses; }     // Pulse no R-peak could claim
+
+private:
+    static const size_t QUEUE = 4;          // Open windows / early pulses kept, power of two
+
+    uint32_t minUs;
+    uint32_t maxUs;
+
+    uint64_t openRPeaks[QUEUE];             // Oldest at rHead
+    uint32_t rHead;
+    uint32_t rTail;
+    uint64_t earlyPulses[QUEUE];
+    uint32_t pHead;
+    uint32_t pTail;
+
+    uint32_t paired;
+    uint32_t unpairedRPeaks;
+    uint32_t unpairedPulses;
+
+    void expireRPeaks(uint64_t nowUs);
+    bool makePair(uint64_t rPeakUs, uint64_t pulseUs, PairedBeat& pair);
+};
+
+#endif // DSP_BEAT_PAIRER_H
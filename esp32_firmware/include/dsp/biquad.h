@@ -0,0 +1,258 @@
+#ifndef DSP_BIQUAD_H
+#define DSP_BIQUAD_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Cascaded biquad (second-order section) IIR filters
+// Coefficients are designed with the bilinear transform in constexpr code,
+// so a design for a fixed sample rate ends up as a table in flash instead of
+// start-up work. Every filter instance owns its delay line: two channels
+// never share state, whatever order their samples arrive in.
+//
+// Two back ends run the same coefficient table:
+//   BiquadCascade<N>     float, transposed direct form II (ESP32 has a single-precision FPU)
+//   BiquadCascadeQ15<N>  int16 samples, Q2.14 coefficients, direct form I with
+//                        second-order error feedback, for fixed-point builds
+
+// One section, a0 normalised to 1:
+// y[n] = b0 x[n] + b1 x[n-1] + b2 x[n-2] - a1 y[n-1] - a2 y[n-2]
+struct BiquadCoeffs {
+    float b0, b1, b2;
+    float a1, a2;
+};
+
+// Same section quantised for BiquadCascadeQ15 (|coefficient| < 2)
+struct BiquadCoeffsQ14 {
+    int16_t b0, b1, b2;
+    int16_t a1, a2;
+};
+
+namespace BiquadDesign {
+    constexpr double pi = 3.14159265358979323846;   // Arduino.h defines PI as a macro
+
+    // Taylor series, accurate to double precision for |x| <= pi/2 (std::tan is not constexpr)
+    constexpr double sinTerms(double x2, double term, int n) {
+        return n > 12 ? term : term + sinTerms(x2, -term * x2 / ((2.0 * n) * (2.0 * n + 1.0)), n + 1);
+    }
+    constexpr double cosTerms(double x2, double term, int n) {
+        return n > 12 ? term : term + cosTerms(x2, -term * x2 / ((2.0 * n - 1.0) * (2.0 * n)), n + 1);
+    }
+    constexpr double sin(double x) { return sinTerms(x * x, x, 1); }
+    constexpr double cos(double x) { return cosTerms(x * x, 1.0, 1); }
+    constexpr double tan(double x) { return sin(x) / cos(x); }
+
+    // Q of section k (0-based) of an even-order Butterworth filter
+    constexpr double butterworthQ(int order, int section) {
+        return 1.0 / (2.0 * cos(pi * (2 * section + 1) / (2.0 * order)));
+    }
+
+    // Pre-warped analogue corner, so the digital corner lands on cutoffHz
+    constexpr double warp(double cutoffHz, double sampleRateHz) {
+        return tan(pi * cutoffHz / sampleRateHz);
+    }
+
+    // 1 / a0 of a bilinear-transformed section with pre-warped corner k
+    constexpr double inverseA0(double k, double q) {
+        return 1.0 / (1.0 + k / q + k * k);
+    }
+    constexpr BiquadCoeffs lowpassSection(double k, double q, double n) {
+        return {static_cast<float>(k * k * n), static_cast<float>(2.0 * k * k * n), static_cast<float>(k * k * n),
+                static_cast<float>(2.0 * (k * k - 1.0) * n), static_cast<float>((1.0 - k / q + k * k) * n)};
+    }
+    constexpr BiquadCoeffs highpassSection(double k, double q, double n) {
+        return {static_cast<float>(n), static_cast<float>(-2.0 * n), static_cast<float>(n),
+                static_cast<float>(2.0 * (k * k - 1.0) * n), static_cast<float>((1.0 - k / q + k * k) * n)};
+    }
+
+    constexpr BiquadCoeffs lowpass(double cutoffHz, double sampleRateHz, double q) {
+        return lowpassSection(warp(cutoffHz, sampleRateHz), q, inverseA0(warp(cutoffHz, sampleRateHz), q));
+    }
+    constexpr BiquadCoeffs highpass(double cutoffHz, double sampleRateHz, double q) {
+        return highpassSection(warp(cutoffHz, sampleRateHz), q, inverseA0(warp(cutoffHz, sampleRateHz), q));
+    }
+
+    constexpr int16_t toQ14(float value) {
+        return value >= 32767.0f / 16384.0f ? (int16_t)32767
+             : value <= -2.0f ? (int16_t)-32768
+             : (int16_t)(value * 16384.0f + (value >= 0 ? 0.5f : -0.5f));
+    }
+    // High-/low-pass numerators (b1 = -/+2 b0) keep their exact zeros: rounding
+    // b1 on its own leaves a residual DC gain that the 0.5 Hz poles amplify a
+    // hundredfold
+    constexpr int16_t numeratorQ14(const BiquadCoeffs& c) {
+        return c.b1 == -2.0f * c.b0 ? (int16_t)(-2 * toQ14(c.b0))
+             : c.b1 == 2.0f * c.b0 ? (int16_t)(2 * toQ14(c.b0))
+             : toQ14(c.b1);
+    }
+    constexpr BiquadCoeffsQ14 toQ14(const BiquadCoeffs& c) {
+        return {toQ14(c.b0), numeratorQ14(c), toQ14(c.b2), toQ14(c.a1), toQ14(c.a2)};
+    }
+}
+
+template <size_t Sections>
+class BiquadCascade {
+public:
+    explicit BiquadCascade(const BiquadCoeffs (&coeffs)[Sections]) : coeffs(coeffs) {
+        reset();
+    }
+
+    float process(float x) {
+        for (size_t s = 0; s < Sections; s++) {
+            const BiquadCoeffs& c = coeffs[s];
+            float y = c.b0 * x + z1[s];
+            z1[s] = c.b1 * x - c.a1 * y + z2[s];
+            z2[s] = c.b2 * x - c.a2 * y;
+            x = y;
+        }
+        return x;
+    }
+
+    // Section by section over the block: each section's coefficients and
+    // state stay in registers for the whole inner loop. in and out may alias.
+    void processBlock(const float* in, float* out, size_t count) {
+        if (in != out) {
+            for (size_t i = 0; i < count; i++) out[i] = in[i];
+        }
+        for (size_t s = 0; s < Sections; s++) {
+            const BiquadCoeffs c = coeffs[s];
+            float s1 = z1[s];
+            float s2 = z2[s];
+            for (size_t i = 0; i < count; i++) {
+                float x = out[i];
+                float y = c.b0 * x + s1;
+                s1 = c.b1 * x - c.a1 * y + s2;
+                s2 = c.b2 * x - c.a2 * y;
+                out[i] = y;
+            }
+            z1[s] = s1;
+            z2[s] = s2;
+        }
+    }
+
+    void reset() {
+        for (size_t s = 0; s < Sections; s++) {
+            z1[s] = 0;
+            z2[s] = 0;
+        }
+    }
+
+    // Sets the state to the steady state for a constant input x, so the
+    // first samples of a signal with a large DC level (raw PPG counts, the
+    // AD8232 mid-rail) don't ring through the high-pass for seconds
+    void prime(float x) {
+        for (size_t s = 0; s < Sections; s++) {
+            const BiquadCoeffs& c = coeffs[s];
+            float y = x * (c.b0 + c.b1 + c.b2) / (1.0f + c.a1 + c.a2);
+            z2[s] = c.b2 * x - c.a2 * y;
+            z1[s] = y - c.b0 * x;
+            x = y;
+        }
+    }
+
+    static constexpr size_t SECTIONS = Sections;
+
+private:
+    const BiquadCoeffs (&coeffs)[Sections];
+    float z1[Sections];
+    float z2[Sections];
+};
+
+template <size_t Sections>
+class BiquadCascadeQ15 {
+public:
+    explicit BiquadCascadeQ15(const BiquadCoeffsQ14 (&coeffs)[Sections]) : coeffs(coeffs) {
+        reset();
+    }
+
+    int16_t process(int16_t x) {
+        for (size_t s = 0; s < Sections; s++) {
+            const BiquadCoeffsQ14& c = coeffs[s];
+            State& st = state[s];
+            // Five Q15 x Q14 products can exceed 32 bits. The remainders of the
+            // last two shifts are fed back with (1 - z^-1)^2 shaping, which
+            // cancels the pole pair near z = 1 of a 0.5 Hz high-pass: without
+            // it that section amplifies its own rounding by ~70 dB at DC
+            int64_t acc = (int64_t)c.b0 * x + (int64_t)c.b1 * st.x1 + (int64_t)c.b2 * st.x2
+                        - (int64_t)c.a1 * st.y1 - (int64_t)c.a2 * st.y2
+                        + 2 * (int64_t)st.e1 - st.e2;
+            int64_t y = acc >> 14;
+            st.e2 = st.e1;
+            st.e1 = (int32_t)(acc - (y << 14));
+            if (y > 32767) y = 32767;
+            if (y < -32768) y = -32768;
+
+            st.x2 = st.x1;
+            st.x1 = x;
+            st.y2 = st.y1;
+            st.y1 = (int16_t)y;
+            x = (int16_t)y;
+        }
+        return x;
+    }
+
+    // Section by section with the state in registers: process()'s
+    // arithmetic in a different order, so bit for bit the same output
+    void processBlock(const int16_t* in, int16_t* out, size_t count) {
+        if (in != out) {
+            for (size_t i = 0; i < count; i++) out[i] = in[i];
+        }
+        for (size_t s = 0; s < Sections; s++) {
+            const BiquadCoeffsQ14 c = coeffs[s];
+            int32_t x1 = state[s].x1, x2 = state[s].x2;
+            int32_t y1 = state[s].y1, y2 = state[s].y2;
+            int32_t e1 = state[s].e1, e2 = state[s].e2;
+            for (size_t i = 0; i < count; i++) {
+                int32_t x = out[i];
+                int64_t acc = (int64_t)c.b0 * x + (int64_t)c.b1 * x1 + (int64_t)c.b2 * x2
+                            - (int64_t)c.a1 * y1 - (int64_t)c.a2 * y2
+                            + 2 * (int64_t)e1 - e2;
+                int64_t y = acc >> 14;
+                e2 = e1;
+                e1 = (int32_t)(acc - (y << 14));
+                if (y > 32767) y = 32767;
+                if (y < -32768) y = -32768;
+                x2 = x1;
+                x1 = x;
+                y2 = y1;
+                y1 = (int32_t)y;
+                out[i] = (int16_t)y;
+            }
+            state[s] = {(int16_t)x1, (int16_t)x2, (int16_t)y1, (int16_t)y2, e1, e2};
+        }
+    }
+
+    void reset() {
+        for (size_t s = 0; s < Sections; s++) {
+            state[s] = {0, 0, 0, 0, 0, 0};
+        }
+    }
+
+    // Steady state for a constant input, as BiquadCascade::prime()
+    void prime(int16_t x) {
+        for (size_t s = 0; s < Sections; s++) {
+            const BiquadCoeffsQ14& c = coeffs[s];
+            int32_t num = (int32_t)c.b0 + c.b1 + c.b2;
+            int32_t den = 16384 + (int32_t)c.a1 + c.a2;
+            int32_t y = den != 0 ? (int32_t)((int64_t)x * num / den) : 0;
+            if (y > 32767) y = 32767;
+            if (y < -32768) y = -32768;
+            state[s] = {x, x, (int16_t)y, (int16_t)y, 0, 0};
+            x = (int16_t)y;
+        }
+    }
+
+    static constexpr size_t SECTIONS = Sections;
+
+private:
+    struct State {
+        int16_t x1, x2;
+        int16_t y1, y2;
+        int32_t e1, e2;     // Shift remainders, in 2^-14 LSB
+    };
+
+    const BiquadCoeffsQ14 (&coeffs)[Sections];
+    State state[Sections];
+};
+
+#endif // DSP_BIQUAD_H
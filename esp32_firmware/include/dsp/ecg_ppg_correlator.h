@@ -0,0 +1,139 @@
+#ifndef DSP_ECG_PPG_CORRELATOR_H
+#define DSP_ECG_PPG_CORRELATOR_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "dsp/fixed_point.h"
+
+// Streaming normalised cross-correlation between ECG and PPG
+// The two streams run at different rates and arrive in bursts, so each is
+// reduced to a beat-shaped feature on a shared 50 Hz grid of source time:
+// the ECG's squared slope (the QRS energy) and the PPG's rising slope (the
+// systolic upstroke; the runoff's falling slope would drag the peak early),
+// averaged into 20 ms bins and over the last 100 ms. Both get the same
+// treatment, so its delays cancel. The PPG feature is then correlated
+// against the ECG feature delayed by every lag from 40 to 520 ms over the
+// last 8 s, and the best lag is the delay from the QRS to the steepest part
+// of the upstroke: a PTT estimate independent of beat detection.
+//
+// Each lag keeps running sums (the product and the ECG value and square),
+// updated as a bin enters and leaves the window, so a bin costs a few
+// operations per lag however long the window. On the float back end the
+// sums are doubles: the rounding left behind by adding and later removing a
+// value stays far below the float resolution of the result over days of
+// running. The fixed-point back end (DSP_FIXED_POINT) quantises the features
+// to integers and keeps the sums in int64, which add and remove exactly.
+//
+// Inputs are the band-passed signals with systole rising on the PPG, each
+// sample stamped with its 64-bit source time in microseconds.
+
+struct CorrelationPeak {
+    float coefficient;      // Highest normalised correlation over the lag range (-1..1)
+    float lagUs;            // Its lag, interpolated between bins; -1 at the edge of the range
+    bool valid;             // A full window has been correlated
+};
+
+// Feature and sum types of each back end
+template <typename Precision>
+struct CorrelatorArithmetic;
+
+template <>
+struct CorrelatorArithmetic<FloatPrecision> {
+    typedef float Feature;
+    typedef double Sum;
+    static Feature quantise(float value, bool) { return value; }
+    static float coefficient(uint32_t n, Sum sumX, Sum sumXX, Sum sumY, Sum sumYY, Sum sumXY);
+};
+
+template <>
+struct CorrelatorArithmetic<FixedPrecision> {
+    typedef int32_t Feature;
+    typedef int64_t Sum;
+    // ECG squared slope in counts^2, PPG rising slope in 1/256 count per
+    // sample; both clamped below 2^20 to keep correlationQ15() in range
+    static Feature quantise(float value, bool squared) {
+        float scaled = squared ? value : value * 256.0f;
+        return scaled >= 1048575.0f ? 1048575 : (Feature)(scaled + 0.5f);
+    }
+    static float coefficient(uint32_t n, Sum sumX, Sum sumXX, Sum sumY, Sum sumYY, Sum sumXY) {
+        return correlationQ15(n, sumX, sumXX, sumY, sumYY, sumXY) / 32768.0f;
+    }
+};
+
+template <typename Precision>
+class BasicEcgPpgCorrelator {
+public:
+    static const uint32_t BIN_US = 20000;       // Shared grid, 50 Hz
+    static const uint32_t WINDOW = 400;         // Bins correlated, 8 s
+    static const uint32_t MIN_LAG = 2;          // Bins, 40 ms
+    static const uint32_t MAX_LAG = 26;         // Bins, 520 ms
+    static const uint32_t LAGS = MAX_LAG - MIN_LAG + 1;
+
+    BasicEcgPpgCorrelator();
+
+    void addECG(float value, uint64_t timestampUs);
+    void addPPG(float value, uint64_t timestampUs);
+    void addPPGBlock(const float* values, const uint64_t* timestampsUs, size_t count);
+    void reset();
+
+    bool isReady() const { return windowBins == WINDOW; }
+    CorrelationPeak getPeak() const;
+    float coefficientAt(uint32_t lagBins) const;    // MIN_LAG..MAX_LAG, 0 outside
+
+private:
+    static const uint32_t RING = 512;           // Window + lags + skew between the streams, power of two
+    static const uint32_t SMOOTH = 5;           // Bins averaged, 100 ms
+    static const uint32_t MAX_GAP_BINS = 5;     // Held across; longer gaps restart
+
+    typedef CorrelatorArithmetic<Precision> Arithmetic;
+    typedef typename Arithmetic::Feature Feature;
+    typedef typename Arithmetic::Sum Sum;
+
+    struct Channel {
+        bool squared;           // Squared slope (ECG), else the rising slope (PPG)
+        bool havePrevious;
+        float previous;
+        uint64_t previousUs;
+
+        bool binOpen;
+        uint32_t bin;           // Bin number (source time / BIN_US) being filled
+        float binSum;
+        uint32_t binCount;
+        float binMean;          // Of the last closed bin, held across short gaps
+
+        float recent[SMOOTH];   // Bin means for the smoother
+        uint32_t recentCount;
+
+        bool started;           // firstBin is set
+        uint32_t firstBin;      // Oldest bin the correlation may use
+        uint32_t nextBin;       // One past the newest smoothed bin
+        Feature feature[RING];  // Smoothed feature by bin number
+    };
+
+    Channel ecg;
+    Channel ppg;
+
+    // Correlation state: bins before correlatedBin are in the sums
+    bool active;
+    uint32_t correlatedBin;
+    uint32_t windowBins;
+    // Per lag, longest first: ECG bins in the order they sit in the ring
+    Sum sumY;
+    Sum sumYY;
+    Sum sumX[LAGS];
+    Sum sumXX[LAGS];
+    Sum sumXY[LAGS];
+
+    void addSample(Channel& channel, float value, uint64_t timestampUs);
+    void emitBin(Channel& channel, uint32_t bin, float mean);
+    void resetChannel(Channel& channel);
+    void restartCorrelation();
+    void advance();
+    void correlateBin(uint32_t bin);
+    template <bool Subtract>
+    void updateLagSums(uint32_t bin, Feature y);
+};
+
+typedef BasicEcgPpgCorrelator<DspPrecision> EcgPpgCorrelator;
+
+#endif // DSP_ECG_PPG_CORRELATOR_H
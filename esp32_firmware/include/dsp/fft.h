@@ -0,0 +1,73 @@
+#ifndef DSP_FFT_H
+#define DSP_FFT_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <math.h>
+
+// In-place radix-2 complex FFT of a fixed power-of-two size
+// The twiddle factors and the bit-reversal permutation are tabulated once
+// in the constructor, so a transform is only loads, multiplies and adds:
+// no trigonometry and no allocation per call. Single precision throughout,
+// which the ESP32 does in hardware (doubles are emulated).
+
+template <size_t N>
+class Radix2FFT {
+    static_assert(N >= 4 && (N & (N - 1)) == 0, "Radix2FFT needs a power-of-two size");
+
+public:
+    static constexpr size_t SIZE = N;
+
+    Radix2FFT() {
+        for (size_t k = 0; k < N / 2; k++) {
+            double angle = -2.0 * 3.14159265358979323846 * (double)k / (double)N;
+            twiddleCos[k] = (float)cos(angle);
+            twiddleSin[k] = (float)sin(angle);
+        }
+        size_t bits = 0;
+        while (((size_t)1 << bits) < N) bits++;
+        for (size_t i = 0; i < N; i++) {
+            size_t reversed = 0;
+            for (size_t b = 0; b < bits; b++) {
+                if (i & ((size_t)1 << b)) reversed |= (size_t)1 << (bits - 1 - b);
+            }
+            reversal[i] = (uint16_t)reversed;
+        }
+    }
+
+    // Forward transform, X[k] = sum x[n] e^(-2 pi i k n / N)
+    void forward(float* re, float* im) const {
+        for (size_t i = 0; i < N; i++) {
+            size_t j = reversal[i];
+            if (j > i) {
+                float t = re[i]; re[i] = re[j]; re[j] = t;
+                t = im[i]; im[i] = im[j]; im[j] = t;
+            }
+        }
+        for (size_t size = 2; size <= N; size <<= 1) {
+            size_t half = size / 2;
+            size_t stride = N / size;
+            for (size_t start = 0; start < N; start += size) {
+                for (size_t j = 0; j < half; j++) {
+                    float wr = twiddleCos[j * stride];
+                    float wi = twiddleSin[j * stride];
+                    size_t a = start + j;
+                    size_t b = a + half;
+                    float tr = re[b] * wr - im[b] * wi;
+                    float ti = re[b] * wi + im[b] * wr;
+                    re[b] = re[a] - tr;
+                    im[b] = im[a] - ti;
+                    re[a] += tr;
+                    im[a] += ti;
+                }
+            }
+        }
+    }
+
+private:
+    float twiddleCos[N / 2];
+    float twiddleSin[N / 2];
+    uint16_t reversal[N];
+};
+
+#endif // DSP_FFT_H
@@ -0,0 +1,145 @@
+#ifndef DSP_FIXED_POINT_H
+#define DSP_FIXED_POINT_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Fixed-point back end for the filter and correlation kernels
+// The ESP32 has a single-precision FPU and runs double in software, and the
+// same core carries the Wi-Fi/TLS stack. With DSP_FIXED_POINT=1 the band-pass
+// stages run BiquadCascadeQ15 on Q15 samples and the ECG/PPG correlator keeps
+// exact 64-bit sums of Q31 features instead of doubles; 0 (the default on
+// every env) keeps float. The Q15 band-pass converts each float sample in and
+// out, so it only pays if the target bench says so: the kernel bench times
+// both back ends, as *_bandpass and *_bandpass_q15.
+// Tests and benches instantiate both through FloatPrecision/FixedPrecision.
+//
+// Integer kernels give the same bits on every compiler, so each one has a
+// portable reference (the definition of its result) and a variant unrolled
+// for the target's integer pipeline, selected by DSP_TARGET_KERNELS. Both
+// build on the host, where the tests compare them bit for bit.
+
+#ifndef DSP_FIXED_POINT
+#define DSP_FIXED_POINT 0
+#endif
+
+#ifndef DSP_TARGET_KERNELS
+#if defined(ESP_PLATFORM) || defined(ARDUINO_ARCH_ESP32)
+#define DSP_TARGET_KERNELS 1
+#else
+#define DSP_TARGET_KERNELS 0
+#endif
+#endif
+
+struct FloatPrecision {
+    static const bool FIXED = false;
+};
+struct FixedPrecision {
+    static const bool FIXED = true;
+};
+
+#if DSP_FIXED_POINT
+typedef FixedPrecision DspPrecision;
+#else
+typedef FloatPrecision DspPrecision;
+#endif
+
+// Value * 2^shift, rounded to nearest and saturated to int16
+inline int16_t toQ15(float value, int shift) {
+    float scaled = shift >= 0 ? value * (float)(1 << shift) : value / (float)(1 << -shift);
+    if (scaled >= 32767.0f) return 32767;
+    if (scaled <= -32768.0f) return -32768;
+    return (int16_t)(scaled >= 0 ? scaled + 0.5f : scaled - 0.5f);
+}
+
+inline float fromQ15(int16_t value, int shift) {
+    return shift >= 0 ? value / (float)(1 << shift) : value * (float)(1 << -shift);
+}
+
+// Floor of the square root, exact for every input
+uint32_t isqrt64(uint64_t value);
+
+// Pearson correlation from exact sums over n pairs, in Q15 (-32767..32767);
+// 0 when either side is flat. |sums| must stay below 2^29 * n and the sums
+// of squares below 2^49 so nothing overflows (features < 2^20, n <= 512).
+int16_t correlationQ15(uint32_t n, int64_t sumX, int64_t sumXX, int64_t sumY, int64_t sumYY, int64_t sumXY);
+
+// Lag sums of a sliding cross-correlation: for j < count,
+//   sumX[j] +/-= x[j], sumXX[j] +/-= x[j]^2, sumXY[j] +/-= x[j] * y
+// Subtract takes a pair back out of the window.
+template <bool Subtract>
+inline void lagSumsReference(const int32_t* x, int32_t y, int64_t* sumX, int64_t* sumXX, int64_t* sumXY,
+                             size_t count) {
+    for (size_t j = 0; j < count; j++) {
+        int64_t v = x[j];
+        if (Subtract) {
+            sumX[j] -= v;
+            sumXX[j] -= v * v;
+            sumXY[j] -= v * y;
+        } else {
+            sumX[j] += v;
+            sumXX[j] += v * v;
+            sumXY[j] += v * y;
+        }
+    }
+}
+
+// Four lags per pass: independent accumulators keep the multiplier busy
+// and the loads ahead of their use
+template <bool Subtract>
+inline void lagSumsUnrolled(const int32_t* __restrict x, int32_t y, int64_t* __restrict sumX,
+                            int64_t* __restrict sumXX, int64_t* __restrict sumXY, size_t count) {
+    const int64_t sign = Subtract ? -1 : 1;
+    const int64_t signedY = sign * y;
+    size_t j = 0;
+    for (; j + 4 <= count; j += 4) {
+        int64_t v0 = x[j], v1 = x[j + 1], v2 = x[j + 2], v3 = x[j + 3];
+        int64_t s0 = sign * v0, s1 = sign * v1, s2 = sign * v2, s3 = sign * v3;
+        sumX[j] += s0;
+        sumX[j + 1] += s1;
+        sumX[j + 2] += s2;
+        sumX[j + 3] += s3;
+        sumXX[j] += s0 * v0;
+        sumXX[j + 1] += s1 * v1;
+        sumXX[j + 2] += s2 * v2;
+        sumXX[j + 3] += s3 * v3;
+        sumXY[j] += v0 * signedY;
+        sumXY[j + 1] += v1 * signedY;
+        sumXY[j + 2] += v2 * signedY;
+        sumXY[j + 3] += v3 * signedY;
+    }
+    for (; j < count; j++) {
+        int64_t v = x[j];
+        sumX[j] += sign * v;
+        sumXX[j] += sign * v * v;
+        sumXY[j] += v * signedY;
+    }
+}
+
+template <bool Subtract>
+inline void lagSums(const int32_t* x, int32_t y, int64_t* sumX, int64_t* sumXX, int64_t* sumXY, size_t count) {
+#if DSP_TARGET_KERNELS
+    lagSumsUnrolled<Subtract>(x, y, sumX, sumXX, sumXY, count);
+#else
+    lagSumsReference<Subtract>(x, y, sumX, sumXX, sumXY, count);
+#endif
+}
+
+// Float back end of the same kernel, summing in double
+template <bool Subtract>
+inline void lagSums(const float* x, float y, double* sumX, double* sumXX, double* sumXY, size_t count) {
+    for (size_t j = 0; j < count; j++) {
+        double v = x[j];
+        if (Subtract) {
+            sumX[j] -= v;
+            sumXX[j] -= v * v;
+            sumXY[j] -= v * y;
+        } else {
+            sumX[j] += v;
+            sumXX[j] += v * v;
+            sumXY[j] += v * y;
+        }
+    }
+}
+
+#endif // DSP_FIXED_POINT_H
@@ -0,0 +1,58 @@
+#ifndef DSP_HEART_RATE_FUSION_H
+#define DSP_HEART_RATE_FUSION_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// One heart rate from several estimators
+// Each source (ECG R-R, PPG spectrum, Maxim's PPG peak counting) reports its
+// latest rate with a confidence in 0-1 and the source time it refers to.
+// fuse() takes the most confident fresh source as the anchor and averages,
+// weighted by confidence, every fresh source that agrees with it. A source
+// that disagrees is left out rather than pulling the average halfway to a
+// doubled or halved rate.
+
+enum HeartRateSource : uint8_t {
+    HR_SOURCE_ECG = 0,
+    HR_SOURCE_PPG_SPECTRAL,
+    HR_SOURCE_PPG_MAXIM,
+    HR_SOURCE_COUNT
+};
+
+struct HeartRateEstimate {
+    float bpm;
+    float confidence;       // 0-1
+    uint64_t timeUs;        // Source time of the estimate
+    bool valid;
+};
+
+struct FusedHeartRate {
+    float bpm;
+    float confidence;       // Of the anchor source
+    uint8_t sources;        // Bit per HeartRateSource that went into bpm
+    bool valid;
+};
+
+const char* heartRateSourceName(HeartRateSource source);
+
+class HeartRateFusion {
+public:
+    static constexpr float AGREEMENT_BPM = 8.0f;
+    static constexpr float MIN_BPM = 30.0f;
+    static constexpr float MAX_BPM = 220.0f;
+
+    explicit HeartRateFusion(uint32_t maxAgeMs = 5000);
+
+    void update(HeartRateSource source, float bpm, float confidence, uint64_t timeUs);
+    void invalidate(HeartRateSource source);
+    void reset();
+
+    FusedHeartRate fuse(uint64_t nowUs) const;
+    const HeartRateEstimate& getSource(HeartRateSource source) const { return estimates[source]; }
+
+private:
+    uint64_t maxAgeUs;
+    HeartRateEstimate estimates[HR_SOURCE_COUNT];
+};
+
+#endif // DSP_HEART_RATE_FUSION_H
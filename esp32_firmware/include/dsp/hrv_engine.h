@@ -0,0 +1,109 @@
+#ifndef DSP_HRV_ENGINE_H
+#define DSP_HRV_ENGINE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Heart rate variability over the newest WINDOW RR intervals
+// Each beat adds one interval and, once the window is full, evicts the
+// oldest; the time-domain sums (RR, RR^2, successive differences) follow in
+// constant time. They are kept in integer microseconds, so adding and later
+// removing a value is exact and nothing drifts.
+//
+// The spectrum is a Lomb-Scargle periodogram, which takes the intervals at
+// their own (uneven) beat times instead of resampling them. For every
+// frequency of a fixed 1/256 Hz grid over 0.04-0.4 Hz the engine keeps the
+// six sums the periodogram is built from, updated as beats enter and leave:
+// a beat costs one sine/cosine plus a rotation per frequency. LF and HF
+// power are only assembled from the sums every spectrum interval.
+//
+// Intervals outside 300-2000 ms, or more than 20% from the last accepted
+// one, are treated as missed or ectopic beats: they are left out and no
+// successive difference is taken across them. After three in a row the rate
+// is taken to have really changed and the next one is accepted.
+
+struct HrvMetrics {
+    uint32_t intervals;     // RR intervals in the window
+    float meanRRMs;
+    float sdnnMs;
+    float rmssdMs;
+    float pnn50;            // % of successive differences over 50 ms
+    bool spectrumValid;     // Window spans long enough for LF
+    float lfPower;          // ms^2, 0.04-0.15 Hz
+    float hfPower;          // ms^2, 0.15-0.4 Hz
+    float lfHfRatio;
+};
+
+class HrvEngine {
+public:
+    static const uint32_t WINDOW = 128;                 // RR intervals, ~2 minutes
+    static const uint32_t SPECTRUM_PERIOD_S = 256;      // Grid spacing is 1 / this
+    static const uint32_t FIRST_BIN = 10;               // 0.039 Hz
+    static const uint32_t LF_HF_BIN = 38;               // 0.148 Hz, first HF bin
+    static const uint32_t LAST_BIN = 102;               // 0.398 Hz
+    static const uint32_t BINS = LAST_BIN - FIRST_BIN + 1;
+
+    explicit HrvEngine(uint32_t spectrumIntervalMs = 5000);
+
+    // R-peak time; returns true when it added an interval
+    bool addBeat(uint64_t timeUs);
+    void reset();
+
+    void setSpectrumInterval(uint32_t intervalMs) { spectrumIntervalUs = (uint64_t)intervalMs * 1000; }
+    const HrvMetrics& getMetrics() const { return metrics; }
+    uint32_t getRejectedCount() const { return rejected; }
+
+    // Periodogram bin (FIRST_BIN..LAST_BIN) in ms^2/Hz from the current sums
+    float spectrumAt(uint32_t bin) const;
+
+private:
+    struct Interval {
+        uint64_t timeUs;        // Beat that ended the interval
+        uint32_t rrUs;
+        int32_t diffUs;         // From the interval before, when hasDiff
+        bool hasDiff;
+    };
+
+    // Periodogram sums for one frequency
+    struct Bin {
+        double yCos;
+        double ySin;
+        double cos1;
+        double sin1;
+        double cos2;
+        double sin2;
+    };
+
+    uint64_t spectrumIntervalUs;
+
+    Interval window[WINDOW];
+    uint32_t head;              // Oldest entry
+    uint32_t count;
+
+    uint64_t sumRR;
+    uint64_t sumRR2;
+    uint64_t sumDiff2;
+    uint32_t diffCount;
+    uint32_t nn50Count;
+
+    Bin bins[BINS];
+    double sumY;                // RR (ms) for the periodogram mean
+
+    bool haveLastBeat;
+    uint64_t lastBeatUs;
+    uint32_t lastAcceptedUs;    // Last accepted interval, 0 after a gap
+    bool previousAccepted;      // The interval just before this one was accepted
+    int rejectRun;
+    uint32_t rejected;
+
+    uint64_t lastSpectrumUs;
+    HrvMetrics metrics;
+
+    void addInterval(uint64_t timeUs, uint32_t rrUs);
+    void evictOldest();
+    void updateSpectrumSums(const Interval& interval, double sign);
+    void updateTimeDomain();
+    void updateSpectrum();
+};
+
+#endif // DSP_HRV_ENGINE_H
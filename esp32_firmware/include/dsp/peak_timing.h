@@ -0,0 +1,56 @@
+#ifndef DSP_PEAK_TIMING_H
+#define DSP_PEAK_TIMING_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Sub-sample peak timing for the pulse transit time path
+// Every sample carries the 64-bit microsecond time it was acquired at, so a
+// peak is stamped from the signal itself rather than from whenever the
+// processing code happened to run. A parabola through the local maximum and
+// its two neighbours then places the peak between samples.
+
+struct TimedPeak {
+    uint64_t timeUs;    // Interpolated peak time
+    float value;        // Interpolated peak amplitude
+    uint32_t index;     // Sample number of the local maximum
+};
+
+// Vertex of the parabola through (-1, previous), (0, peak), (1, next).
+// Returns the offset in samples (-0.5..0.5); 0 when the points are not a maximum.
+float parabolicPeakOffset(float previous, float peak, float next, float* vertexValue = nullptr);
+
+// Local-maximum detector with an amplitude threshold and a refractory period,
+// both evaluated on sample time. A peak is reported one sample late, once the
+// following sample confirms the slope has turned.
+class PeakDetector {
+public:
+    PeakDetector(float threshold, uint32_t refractoryUs);
+
+    void setThreshold(float value) { threshold = value; }
+    float getThreshold() const { return threshold; }
+    // Disabling interpolation stamps peaks with the time of the maximum sample
+    void setInterpolation(bool enable) { interpolate = enable; }
+
+    bool addSample(float value, uint64_t timestampUs, TimedPeak& peak);
+    void reset();
+
+private:
+    float threshold;
+    uint32_t refractoryUs;
+    bool interpolate;
+
+    float values[3];        // [0] oldest .. [2] newest
+    uint64_t times[3];
+    uint32_t sampleCount;
+    bool havePeak;
+    uint64_t lastPeakUs;
+};
+
+// Mean delay from each R-peak to the first pulse peak minUs..maxUs after it.
+// Both lists are in chronological order. Returns -1 when no beat pairs up.
+float meanPulseTransitUs(const uint64_t* rPeaksUs, size_t rCount,
+                         const uint64_t* pulsePeaksUs, size_t pulseCount,
+                         uint32_t minUs, uint32_t maxUs);
+
+#endif // DSP_PEAK_TIMING_H
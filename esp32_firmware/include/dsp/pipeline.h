@@ -0,0 +1,326 @@
+#ifndef DSP_PIPELINE_H
+#define DSP_PIPELINE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <tuple>
+#include <type_traits>
+#include "dsp/biquad.h"
+#include "dsp/fixed_point.h"
+#include "dsp/qrs_detector.h"
+#include "dsp/ppg_fiducials.h"
+
+// Biosignal processing chains composed at compile time
+// A pipeline is a type listing its stages in order:
+//
+//   typedef Pipeline<BandpassStage<ECGBandpass<250>>,
+//                    TapStage<ECG_TAP_FILTERED>,
+//                    QrsStage<250>> ECGPipeline;
+//
+// process() hands a block of samples to each stage in turn. Stages are
+// concrete members and every call is resolved at compile time, so the whole
+// chain inlines into one function with no per-sample dispatch. Filters
+// rewrite the block in place; a decimator shortens it; detectors and taps
+// leave it alone and report what they find through the events object passed
+// to process(), by calling events.on(x) with a type per kind of result:
+//
+//   QrsEvent             QrsStage, per confirmed R-peak
+//   PulseFiducials       PulseFiducialStage, per completed pulse
+//   TappedBlock<Port>    TapStage<Port>, the block as it reached the tap
+//
+// An events type only needs overloads for what its pipeline produces, so
+// one pipeline can report to different owners (the stream, a bench test).
+
+// Samples flowing through a pipeline, rewritten in place
+struct SampleBlock {
+    float* values;
+    uint64_t* timestampsUs;     // Source time of each sample (esp_timer clock)
+    size_t count;
+};
+
+template <int Port>
+struct TappedBlock {
+    const SampleBlock& block;
+};
+
+// For a pipeline whose results are only read back through its stages
+struct NoPipelineEvents {
+    template <typename Event>
+    void on(const Event&) {}
+};
+
+template <typename... Stages>
+class Pipeline;
+
+template <>
+class Pipeline<> {
+public:
+    template <typename Events>
+    void process(SampleBlock&, Events&) {}
+    void reset() {}
+};
+
+template <typename First, typename... Rest>
+class Pipeline<First, Rest...> {
+public:
+    static constexpr size_t STAGES = 1 + sizeof...(Rest);
+
+    template <typename Events>
+    void process(SampleBlock& block, Events& events) {
+        // A decimator can leave nothing for the stages after it
+        if (block.count == 0) {
+            return;
+        }
+        first.process(block, events);
+        rest.process(block, events);
+    }
+
+    void process(SampleBlock& block) {
+        NoPipelineEvents events;
+        process(block, events);
+    }
+
+    void reset() {
+        first.reset();
+        rest.reset();
+    }
+
+    // Stage I (0-based), for its detector state or settings
+    template <size_t I>
+    typename std::tuple_element<I, std::tuple<First, Rest...> >::type& stage() {
+        return at(std::integral_constant<size_t, I>());
+    }
+    template <size_t I>
+    const typename std::tuple_element<I, std::tuple<First, Rest...> >::type& stage() const {
+        return const_cast<Pipeline*>(this)->at(std::integral_constant<size_t, I>());
+    }
+
+private:
+    template <typename...> friend class Pipeline;
+
+    First& at(std::integral_constant<size_t, 0>) { return first; }
+    template <size_t I>
+    typename std::tuple_element<I, std::tuple<First, Rest...> >::type& at(std::integral_constant<size_t, I>) {
+        return rest.at(std::integral_constant<size_t, I - 1>());
+    }
+
+    First first;
+    Pipeline<Rest...> rest;
+};
+
+// Band-pass (or any biquad design with SECTIONS and coeffs, see
+// bandpass_designs.h). The first block after a reset primes the delay line
+// with its first sample, so a large DC level doesn't ring through.
+// On the fixed-point back end the block is scaled by 2^InputShift into Q15
+// and runs through BiquadCascadeQ15 on the design's coeffsQ14; the shift
+// should bring the signal near full scale (AD8232 counts << 3, PPG >> 4).
+template <typename Design, int InputShift = 0, typename Precision = DspPrecision>
+class BandpassStage {
+public:
+    template <typename Events>
+    void process(SampleBlock& block, Events&) {
+        if (!primed) {
+            filter.prime(block.values[0]);
+            primed = true;
+        }
+        filter.processBlock(block.values, block.values, block.count);
+    }
+
+    void reset() { primed = false; }
+
+private:
+    BiquadCascade<Design::SECTIONS> filter{Design::coeffs};
+    bool primed = false;
+};
+
+template <typename Design, int InputShift>
+class BandpassStage<Design, InputShift, FixedPrecision> {
+public:
+    template <typename Events>
+    void process(SampleBlock& block, Events&) {
+        if (!primed) {
+            filter.prime(toQ15(block.values[0], InputShift));
+            primed = true;
+        }
+        for (size_t start = 0; start < block.count; start += CHUNK) {
+            size_t n = block.count - start < CHUNK ? block.count - start : CHUNK;
+            float* values = block.values + start;
+            for (size_t i = 0; i < n; i++) q15[i] = toQ15(values[i], InputShift);
+            filter.processBlock(q15, q15, n);
+            for (size_t i = 0; i < n; i++) values[i] = fromQ15(q15[i], InputShift);
+        }
+    }
+
+    void reset() {
+        filter.reset();
+        primed = false;
+    }
+
+private:
+    static const size_t CHUNK = 32;
+
+    BiquadCascadeQ15<Design::SECTIONS> filter{Design::coeffsQ14};
+    int16_t q15[CHUNK];
+    bool primed = false;
+};
+
+// Mean of the newest N samples (fewer until N have arrived). A running
+// float sum, re-added from the window once per lap so rounding can't build up.
+template <size_t N>
+class MovingAverageStage {
+    static_assert(N >= 1, "Moving average needs at least one sample");
+
+public:
+    template <typename Events>
+    void process(SampleBlock& block, Events&) {
+        for (size_t i = 0; i < block.count; i++) {
+            float value = block.values[i];
+            sum += value - window[next];
+            window[next] = value;
+            if (filled < N) filled++;
+            if (++next == N) {
+                next = 0;
+                float exact = 0;
+                for (size_t k = 0; k < N; k++) exact += window[k];
+                sum = exact;
+            }
+            block.values[i] = filled == N ? sum * (1.0f / N) : sum / filled;
+        }
+    }
+
+    void reset() {
+        for (size_t k = 0; k < N; k++) window[k] = 0;
+        sum = 0;
+        next = 0;
+        filled = 0;
+    }
+
+private:
+    float window[N] = {};
+    float sum = 0;
+    size_t next = 0;
+    size_t filled = 0;
+};
+
+// Averages each run of Factor samples into one, stamped at the run's
+// middle. A run can span blocks; the block shrinks to the completed runs.
+template <size_t Factor>
+class DecimateStage {
+    static_assert(Factor >= 1, "Decimation factor must be at least 1");
+
+public:
+    template <typename Events>
+    void process(SampleBlock& block, Events&) {
+        size_t out = 0;
+        for (size_t i = 0; i < block.count; i++) {
+            if (pending == 0) firstUs = block.timestampsUs[i];
+            sum += block.values[i];
+            if (++pending == Factor) {
+                block.values[out] = sum / Factor;
+                block.timestampsUs[out] = firstUs + (block.timestampsUs[i] - firstUs) / 2;
+                out++;
+                sum = 0;
+                pending = 0;
+            }
+        }
+        block.count = out;
+    }
+
+    void reset() {
+        sum = 0;
+        pending = 0;
+    }
+
+private:
+    float sum = 0;
+    size_t pending = 0;
+    uint64_t firstUs = 0;
+};
+
+// Pan-Tompkins R-peaks of a band-passed ECG; relearns after a reset
+template <uint32_t SampleRateHz>
+class QrsStage {
+public:
+    template <typename Events>
+    void process(SampleBlock& block, Events& events) {
+        QrsEvent beat;
+        for (size_t i = 0; i < block.count; i++) {
+            if (qrs.addSample(block.values[i], block.timestampsUs[i], beat)) {
+                events.on(beat);
+            }
+        }
+    }
+
+    void reset() { qrs.reset(); }
+
+    QrsDetector& detector() { return qrs; }
+    const QrsDetector& detector() const { return qrs; }
+
+private:
+    QrsDetector qrs{SampleRateHz};
+};
+
+// Foot, max slope and peak of every pulse of a band-passed, systole-up PPG
+class PulseFiducialStage {
+public:
+    template <typename Events>
+    void process(SampleBlock& block, Events& events) {
+        PulseFiducials beat;
+        for (size_t i = 0; i < block.count; i++) {
+            if (fiducials.addSample(block.values[i], block.timestampsUs[i], beat)) {
+                events.on(beat);
+            }
+        }
+    }
+
+    void reset() { fiducials.reset(); }
+
+    PulseFiducialDetector& detector() { return fiducials; }
+    const PulseFiducialDetector& detector() const { return fiducials; }
+
+private:
+    PulseFiducialDetector fiducials;
+};
+
+// Reports the block as it is at this point of the chain
+template <int Port>
+class TapStage {
+public:
+    template <typename Events>
+    void process(SampleBlock& block, Events& events) {
+        TappedBlock<Port> tapped = {block};
+        events.on(tapped);
+    }
+
+    void reset() {}
+};
+
+// Runs its own stages on a copy, leaving the block for the stages after it
+// untouched. Blocks longer than Capacity go through in pieces.
+template <size_t Capacity, typename... Stages>
+class BranchStage {
+public:
+    template <typename Events>
+    void process(SampleBlock& block, Events& events) {
+        for (size_t start = 0; start < block.count; start += Capacity) {
+            size_t n = block.count - start < Capacity ? block.count - start : Capacity;
+            for (size_t i = 0; i < n; i++) {
+                values[i] = block.values[start + i];
+                timestampsUs[i] = block.timestampsUs[start + i];
+            }
+            SampleBlock copy = {values, timestampsUs, n};
+            branch.process(copy, events);
+        }
+    }
+
+    void reset() { branch.reset(); }
+
+    Pipeline<Stages...>& pipeline() { return branch; }
+
+private:
+    Pipeline<Stages...> branch;
+    float values[Capacity];
+    uint64_t timestampsUs[Capacity];
+};
+
+#endif // DSP_PIPELINE_H
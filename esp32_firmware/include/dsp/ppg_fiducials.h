@@ -0,0 +1,101 @@
+#ifndef DSP_PPG_FIDUCIALS_H
+#define DSP_PPG_FIDUCIALS_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Streaming PPG pulse fiducials for pulse transit time
+// Each beat yields three timing points, all interpolated between samples:
+//   - foot: where the tangent at the steepest upslope meets the horizontal
+//     through the minimum the upstroke starts from (intersecting tangent)
+//   - max slope: vertex of a parabola through the centred-difference slopes
+//   - peak: vertex of a parabola through the systolic maximum
+// The foot and max slope sit on the sharp upstroke, so they jitter far less
+// than the rounded peak and barely move with vascular tone.
+//
+// The input is the band-passed pulse with systole rising (negate raw
+// MAX30102 counts, which dip as blood volume rises). An upstroke starts when
+// the slope exceeds half the running max-slope level, and a beat is kept when
+// its amplitude is at least a third of the running level. Work per sample is
+// constant; processBlock() runs a FIFO burst in one call.
+
+enum class PulseFiducial : uint8_t {
+    FOOT,
+    MAX_SLOPE,
+    PEAK
+};
+
+struct PulseFiducials {
+    uint64_t footUs;
+    uint64_t maxSlopeUs;
+    uint64_t peakUs;
+    float footValue;        // Level of the preceding minimum
+    float peakValue;
+    float maxSlope;         // Input units per second
+    uint32_t peakIndex;     // Input sample number of the systolic maximum
+
+    uint64_t timeOf(PulseFiducial fiducial) const {
+        return fiducial == PulseFiducial::FOOT ? footUs : (fiducial == PulseFiducial::MAX_SLOPE ? maxSlopeUs : peakUs);
+    }
+    float amplitude() const { return peakValue - footValue; }
+};
+
+const char* pulseFiducialName(PulseFiducial fiducial);
+
+class PulseFiducialDetector {
+public:
+    static const uint32_t MAX_SAMPLE_RATE_HZ = 400;     // Full foot search window up to this rate
+
+    PulseFiducialDetector();
+
+    // Returns true when a beat completed; at most one per sample
+    bool addSample(float value, uint64_t timestampUs, PulseFiducials& beat);
+    // Runs count samples and stores up to maxBeats completed beats; returns how many
+    size_t processBlock(const float* values, const uint64_t* timestampsUs, size_t count,
+                        PulseFiducials* beats, size_t maxBeats);
+    void reset();
+
+    // With adaptation off the levels stay at what the learning phase found
+    void setAdaptive(bool enable) { adaptive = enable; }
+
+    bool isLearning() const { return learning; }
+    uint32_t getBeatCount() const { return beats; }
+
+private:
+    static const uint32_t HISTORY = 256;    // 640 ms at MAX_SAMPLE_RATE_HZ, power of two
+
+    struct HistoryEntry {
+        float value;
+        uint32_t timeLowUs;                 // Low 32 bits of the sample time
+    };
+
+    bool adaptive;
+
+    HistoryEntry history[HISTORY];
+    uint32_t sampleCount;
+    uint64_t latestTimeUs;
+    uint64_t firstTimeUs;
+
+    bool learning;
+    float slopeLevel;                       // Running max upslope, per sample
+    float amplitudeLevel;                   // Running foot-to-peak amplitude
+
+    // Current upstroke
+    bool rising;
+    uint64_t riseStartUs;
+    float maxSlope;
+    uint32_t maxSlopeIndex;
+
+    uint32_t beats;
+    uint64_t lastPeakUs;
+    uint32_t lastPeakIndex;
+    uint64_t levelCheckUs;                  // Last beat, or last time the levels were lowered
+
+    bool finishBeat(uint32_t peakIndex, PulseFiducials& beat);
+    float slopeAt(uint32_t index) const;
+    uint64_t timeAt(uint32_t index, float offset) const;   // Sample index plus a fraction (may be negative)
+    uint64_t fullTime(uint32_t timeLowUs) const;
+    const HistoryEntry& entry(uint32_t index) const { return history[index & (HISTORY - 1)]; }
+};
+
+#endif // DSP_PPG_FIDUCIALS_H
@@ -0,0 +1,145 @@
+#ifndef DSP_QRS_DETECTOR_H
+#define DSP_QRS_DETECTOR_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "dsp/biquad.h"
+
+// Streaming Pan-Tompkins QRS detector
+// Every sample goes through a 5-15 Hz band-pass, the five-point derivative,
+// squaring and a 150 ms moving-window integral, each with constant work.
+// Peaks of the integral are classified against adaptive signal/noise levels
+// kept for both the integral and the band-passed signal (the dual
+// thresholds); a T-wave is rejected by its slope, and a beat missed for 1.66
+// average RR intervals is recovered by search-back at the lower threshold.
+//
+// The input is the 0.5-40 Hz band-passed ECG (zero-mean). An accepted beat
+// is located on that input within a fixed window before the integral peak,
+// so it is reported roughly 150-250 ms late, stamped with the source time of
+// the R-peak and interpolated between samples.
+
+struct QrsEvent {
+    uint64_t timeUs;        // R-peak time, interpolated between samples
+    float amplitude;        // Input value at the R-peak (negative for an inverted lead)
+    uint32_t index;         // Input sample number of the R-peak
+    float rrMs;             // Interval from the previous beat, 0 for the first
+    bool searchBack;        // Recovered at the lower threshold
+};
+
+class QrsDetector {
+public:
+    static const uint32_t MAX_SAMPLE_RATE_HZ = 500;
+
+    explicit QrsDetector(uint32_t sampleRateHz);
+
+    // Returns true when a beat was confirmed; at most one per sample
+    bool addSample(float value, uint64_t timestampUs, QrsEvent& event);
+    void reset();
+
+    uint32_t getSampleRate() const { return sampleRate; }
+    bool isLearning() const { return learning; }
+    uint32_t getBeatCount() const { return beats; }
+    float getAverageRRMs() const { return rrAverage2Us / 1000.0f; }
+    float getHeartRate() const { return rrAverage2Us > 0 ? 60000000.0f / rrAverage2Us : 0; }
+
+private:
+    // The band-pass state points at the member coefficient table
+    QrsDetector(const QrsDetector&) = delete;
+    QrsDetector& operator=(const QrsDetector&) = delete;
+
+    static const uint32_t HISTORY = 256;        // Search window + peak hold at MAX_SAMPLE_RATE_HZ, power of two
+    static const uint32_t MWI_MAX = 128;        // >= 150 ms at MAX_SAMPLE_RATE_HZ
+    static const int RR_COUNT = 8;
+
+    struct HistoryEntry {
+        float input;
+        float bandpassed;
+        uint32_t timeLowUs;     // Low 32 bits of the sample time
+    };
+
+    // A classified peak of the integral, located on the input
+    struct Candidate {
+        bool valid;
+        float integral;         // Peak of the moving-window integral
+        float bandpassedPeak;   // Largest |band-passed| value in the search window
+        float slope;            // Steepest band-passed slope in the search window
+        uint32_t index;
+        uint64_t timeUs;
+        float amplitude;
+    };
+
+    uint32_t sampleRate;
+    BiquadCoeffs bandpassCoeffs[2];
+    BiquadCascade<2> bandpass;
+
+    // Sample-rate derived lengths
+    uint32_t mwiLength;
+    uint32_t searchSamples;
+    uint32_t learningSamples;
+    uint32_t refractoryUs;
+    uint32_t tWaveUs;
+    uint32_t peakHoldSamples;
+
+    HistoryEntry history[HISTORY];
+    uint32_t sampleCount;
+    uint64_t latestTimeUs;
+    float derivativeInput[4];               // Previous band-passed samples, [0] newest
+
+    float mwiRing[MWI_MAX];
+    uint32_t mwiIndex;
+    float mwiSum;
+    float mwiLapSum;                        // Exact sum of the current lap, replaces mwiSum on wrap
+    float previousIntegral;
+
+    // Peak tracking on the integral
+    bool peakArmed;
+    float peakIntegral;
+    uint32_t peakIndex;
+    bool deferredPending;
+    float deferredIntegral;
+    uint32_t deferredIndex;
+
+    // Learning phase (first two seconds)
+    bool learning;
+    float learningIntegralMax;
+    float learningIntegralSum;
+    float learningBandpassedMax;
+    float learningBandpassedSum;
+
+    // Signal and noise levels: integral (I) and band-passed (F)
+    float signalLevelI;
+    float noiseLevelI;
+    float signalLevelF;
+    float noiseLevelF;
+
+    // Beats
+    uint32_t beats;
+    uint64_t lastBeatUs;
+    float lastBeatSlope;
+    bool irregular;
+    int irregularRun;                       // Consecutive intervals outside the regular limits
+    Candidate searchBackCandidate;
+
+    // RR averages: the last eight intervals, and the last eight regular ones
+    uint32_t rrAll[RR_COUNT];
+    uint32_t rrRegular[RR_COUNT];
+    int rrAllCount;
+    int rrRegularCount;
+    int rrAllNext;
+    int rrRegularNext;
+    uint64_t rrAllSum;
+    uint64_t rrRegularSum;
+    float rrAverage1Us;
+    float rrAverage2Us;
+
+    float integrate(float squared);
+    void finishLearning();
+    bool classify(float integral, uint32_t index, QrsEvent& event);
+    Candidate locate(float integral, uint32_t index) const;
+    void acceptBeat(const Candidate& beat, bool searchBack, QrsEvent& event);
+    void updateRR(uint32_t rrUs);
+    uint64_t fullTime(uint32_t timeLowUs) const;
+    const HistoryEntry& entry(uint32_t index) const { return history[index & (HISTORY - 1)]; }
+};
+
+#endif // DSP_QRS_DETECTOR_H
@@ -0,0 +1,129 @@
+#ifndef DSP_ROLLING_MEDIAN_H
+#define DSP_ROLLING_MEDIAN_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+// Median and median absolute deviation over the newest N values
+// The window is kept sorted as values arrive: push() evicts the oldest value
+// and inserts the new one by binary search plus one memmove each, then
+// re-derives the median directly and the MAD with a single merge of the
+// deviations either side of it (already in order, so no sort). Both are
+// then plain reads. N is small (tens), so the moves are short, and nothing
+// allocates.
+
+template <size_t N>
+class RollingMedian {
+    static_assert(N >= 1, "RollingMedian needs a window of at least one value");
+
+public:
+    static constexpr size_t WINDOW = N;
+
+    RollingMedian() { clear(); }
+
+    void clear() {
+        filled = 0;
+        next = 0;
+        medianValue = 0;
+        madValue = 0;
+    }
+
+    void push(float value) {
+        if (filled == N) {
+            removeSorted(arrival[next]);
+        }
+        filled++;
+        arrival[next] = value;
+        next = (next + 1) % N;
+        insertSorted(value);
+        update();
+    }
+
+    size_t count() const { return filled; }
+    bool full() const { return filled == N; }
+    float median() const { return medianValue; }
+    float mad() const { return madValue; }
+    // MAD scaled to a standard deviation for normally distributed values
+    float robustSigma() const { return 1.4826f * madValue; }
+    float newest() const { return arrival[(next + N - 1) % N]; }
+    float minimum() const { return filled ? sorted[0] : 0.0f; }
+    float maximum() const { return filled ? sorted[filled - 1] : 0.0f; }
+
+    // Further than k robust sigmas from the median (never, with a zero MAD
+    // and the value on the median)
+    bool isOutlier(float value, float k) const {
+        float deviation = value > medianValue ? value - medianValue : medianValue - value;
+        return deviation > k * robustSigma();
+    }
+
+private:
+    float arrival[N];       // Ring in arrival order, for eviction
+    float sorted[N];        // The same values, ascending
+    size_t filled;
+    size_t next;
+    float medianValue;
+    float madValue;
+
+    // First position whose value is >= value
+    size_t lowerBound(float value) const {
+        size_t low = 0;
+        size_t high = filled;
+        while (low < high) {
+            size_t mid = (low + high) / 2;
+            if (sorted[mid] < value) low = mid + 1;
+            else high = mid;
+        }
+        return low;
+    }
+
+    // Called with filled already counting the new value
+    void insertSorted(float value) {
+        size_t used = filled - 1;
+        size_t low = 0;
+        size_t high = used;
+        while (low < high) {
+            size_t mid = (low + high) / 2;
+            if (sorted[mid] <= value) low = mid + 1;
+            else high = mid;
+        }
+        memmove(&sorted[low + 1], &sorted[low], (used - low) * sizeof(float));
+        sorted[low] = value;
+    }
+
+    // Called with filled still counting the evicted value
+    void removeSorted(float value) {
+        size_t at = lowerBound(value);
+        memmove(&sorted[at], &sorted[at + 1], (filled - at - 1) * sizeof(float));
+        filled--;
+    }
+
+    void update() {
+        size_t half = filled / 2;
+        medianValue = (filled & 1) ? sorted[half] : 0.5f * (sorted[half - 1] + sorted[half]);
+
+        // Deviations below the median, walking left, and above it, walking
+        // right, are each ascending: merge until the middle one(s)
+        size_t left = half;             // sorted[left - 1] is the next one down
+        size_t right = half;            // sorted[right] is the next one up
+        size_t target = (filled - 1) / 2;
+        float previous = 0;
+        float current = 0;
+        for (size_t k = 0; k <= filled / 2; k++) {
+            float down = left > 0 ? medianValue - sorted[left - 1] : 0;
+            float up = right < filled ? sorted[right] - medianValue : 0;
+            previous = current;
+            if (right >= filled || (left > 0 && down <= up)) {
+                current = down;
+                left--;
+            } else {
+                current = up;
+                right++;
+            }
+            if (k == target && (filled & 1)) break;
+        }
+        madValue = (filled & 1) ? current : 0.5f * (previous + current);
+    }
+};
+
+#endif // DSP_ROLLING_MEDIAN_H
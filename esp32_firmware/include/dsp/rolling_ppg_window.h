@@ -0,0 +1,54 @@
+#ifndef DSP_ROLLING_PPG_WINDOW_H
+#define DSP_ROLLING_PPG_WINDOW_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "sensors/ppg_acquisition.h"
+
+// Red/IR window for Maxim's spo2_algorithm, which expects 100 samples at 25 Hz
+// Samples are averaged into 40 ms bins of source time, so the stream can run
+// at any rate. Once 100 bins are in, a window is ready every 25 new bins (1 s)
+// and is read in place: the arrays hold 125 bins and slide down by 25 when
+// full, one 100-entry move per second, nothing copied or allocated per update.
+// Short gaps repeat the last bin; longer gaps, or time going backwards,
+// start the window over.
+
+class RollingPPGWindow {
+public:
+    static const uint32_t BIN_US = 40000;       // 25 Hz, spo2_algorithm's FreqS
+    static const uint32_t LENGTH = 100;         // spo2_algorithm's BUFFER_SIZE
+    static const uint32_t STEP = 25;            // New bins between windows
+
+    RollingPPGWindow();
+
+    // Returns true when the sample completed a new window
+    bool addSample(uint32_t red, uint32_t ir, uint64_t timestampUs);
+    void reset();
+
+    // Oldest first, LENGTH entries, valid until the next addSample()
+    uint32_t* irWindow() { return irBuffer + count - LENGTH; }
+    uint32_t* redWindow() { return redBuffer + count - LENGTH; }
+    // Source time at the end of the newest bin in the window
+    uint64_t windowEndUs() const { return (uint64_t)(bin) * BIN_US; }
+    uint32_t getWindowCount() const { return windows; }
+
+private:
+    static const uint32_t CAPACITY = LENGTH + STEP;
+    static const uint32_t MAX_GAP_BINS = 3;
+
+    uint32_t irBuffer[CAPACITY];
+    uint32_t redBuffer[CAPACITY];
+    uint32_t count;
+    uint32_t fresh;                             // Bins since the last window
+
+    bool binOpen;
+    uint32_t bin;
+    uint64_t redSum;
+    uint64_t irSum;
+    uint32_t binCount;
+    uint32_t windows;
+
+    bool pushBin(uint32_t red, uint32_t ir);
+};
+
+#endif // DSP_ROLLING_PPG_WINDOW_H
@@ -0,0 +1,117 @@
+#ifndef DSP_SIGNAL_QUALITY_H
+#define DSP_SIGNAL_QUALITY_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Streaming signal quality indices (SQI), one engine per channel
+// Fed the signal the estimators see, the raw level it came from and the
+// beats found in it, the engine keeps over each window, sample by sample:
+//
+//   kurtosis, skewness   central moments (Welford/Terriberry update). A clean
+//                        ECG is peaky (kurtosis > 5); a clean systole-up PPG
+//                        is skewed; noise and motion tend to Gaussian.
+//   perfusion index      pulse amplitude over the raw DC level, % (PPG)
+//   template match       correlation of each beat with the running average beat
+//   clipping             share of raw samples at the converter's rails
+//
+// and when the window closes publishes them with a 0-100 score: the worst of
+// the indices that matter for the channel's kind, each mapped onto 0-1.
+// Estimators check isLowQuality() and skip windows that would only cost CPU
+// and uplink. A BIA sweep is one window and one beat: the phase spectrum,
+// matched against the previous sweeps, with out-of-range points as clipped.
+
+enum class SignalKind : uint8_t {
+    ECG,
+    PPG,
+    BIA
+};
+
+struct SignalQualityIndex {
+    float kurtosis;         // 3 for Gaussian noise
+    float skewness;
+    float perfusionIndex;   // %, 0 without a DC level (ECG, BIA)
+    float templateMatch;    // Mean beat-to-template correlation (-1..1), 0 without beats
+    float clippingRatio;    // 0..1
+    uint16_t beats;         // Beats matched in the window
+    float score;            // 0-100
+    bool valid;             // A window has been assessed
+};
+
+// An assessed window scored below minScore; unassessed isn't low
+inline bool isLowQuality(const SignalQualityIndex& index, float minScore) {
+    return index.valid && index.score < minScore;
+}
+
+struct SignalQualityConfig {
+    SignalKind kind;
+    float sampleRateHz;         // Places beats reported by time
+    uint32_t windowSamples;     // Published every this many samples; 0 to close with endWindow()
+    float railLow;              // Raw samples at or beyond the rails count as clipped
+    float railHigh;
+    uint16_t templateSamples;   // Beat template length, up to MAX_TEMPLATE; 0 without beats
+    uint16_t templateLead;      // Of those, samples before the beat
+};
+
+class SignalQualityEngine {
+public:
+    static const uint32_t MAX_TEMPLATE = 64;
+    static const uint32_t HISTORY = 256;        // Samples kept for beats reported late, power of two
+    static const uint32_t MAX_PENDING = 4;      // Beats waiting for the rest of their template
+    static const uint32_t TEMPLATE_BEATS = 8;   // Running average over about this many beats
+
+    explicit SignalQualityEngine(const SignalQualityConfig& config);
+
+    // The raw level as acquired, for clipping and the perfusion index's DC
+    void addRaw(float raw, bool clipped);
+    void addRawBlock(const float* raw, size_t count);      // Clipped at the configured rails
+
+    // The signal itself; true when this closed a window
+    bool addSample(float value, uint64_t timestampUs);
+    bool addBlock(const float* values, const uint64_t* timestampsUs, size_t count);
+
+    // A beat at this source time, reported up to HISTORY samples late
+    void addBeat(uint64_t timeUs);
+    // Or at a sample number (sampleCount() just before that sample was added)
+    void addBeatAt(uint32_t sample);
+
+    // Closes the window early and drops beats still waiting for samples
+    bool endWindow();
+    void reset();
+
+    const SignalQualityIndex& getIndex() const { return index; }
+    uint32_t sampleCount() const { return samples; }
+
+    bool isLowQuality(float minScore) const { return ::isLowQuality(index, minScore); }
+
+private:
+    SignalQualityConfig config;
+    SignalQualityIndex index;
+
+    // Current window
+    uint32_t count;
+    float mean, m2, m3, m4;
+    float minimum, maximum;
+    double rawSum;
+    uint32_t rawCount;
+    uint32_t clippedCount;
+    float matchSum;
+    uint16_t matchedBeats;
+
+    // Signal history and beats
+    float history[HISTORY];
+    uint32_t samples;           // Added since reset; the next sample's number
+    uint64_t lastUs;
+    uint32_t pending[MAX_PENDING];
+    uint32_t pendingCount;
+    float beatTemplate[MAX_TEMPLATE];
+    uint32_t templateBeats;
+
+    void matchReadyBeats();
+    void matchBeat(uint32_t start);
+    bool publish();
+    void clearWindow();
+    float score() const;
+};
+
+#endif // DSP_SIGNAL_QUALITY_H
@@ -0,0 +1,164 @@
+#ifndef DSP_SLIDING_WINDOW_STATS_H
+#define DSP_SLIDING_WINDOW_STATS_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <math.h>
+#include <type_traits>
+
+// Minimum, maximum, mean and variance over the newest N values
+// Every push() is O(1) amortised, whatever N is. The minimum and maximum
+// come from monotonic queues of window positions: a new value first drops
+// every queued value it beats (none of them can be the extreme again while
+// it is in the window), so the front is always the answer and each value is
+// queued and dropped at most once. Sum and spread are kept as running
+// moments: exact 64-bit sums for integer types, a sliding Welford update in
+// double for floating point, so neither drifts over a long run.
+// Before the window fills, the statistics cover what has arrived.
+
+namespace sliding_window_detail {
+
+// Integer samples: exact sums, variance from n*sum(x^2) - sum(x)^2
+template <typename T, bool Integral = std::is_integral<T>::value>
+struct Moments {
+    typedef int64_t Sum;
+    int64_t sum;
+    int64_t sumSquares;
+
+    void clear() { sum = 0; sumSquares = 0; }
+    void add(T value, size_t) {
+        sum += value;
+        sumSquares += (int64_t)value * value;
+    }
+    void replace(T evicted, T value, size_t) {
+        sum += (int64_t)value - evicted;
+        sumSquares += (int64_t)value * value - (int64_t)evicted * evicted;
+    }
+    double mean(size_t n) const { return (double)sum / n; }
+    double variance(size_t n) const {
+        return (double)((int64_t)n * sumSquares - sum * sum) / ((double)n * (n - 1));
+    }
+};
+
+// Floating point: Welford's running mean and squared deviations, slid
+template <typename T>
+struct Moments<T, false> {
+    typedef double Sum;
+    double average;
+    double squaredDeviations;
+    double sum;
+
+    void clear() { average = 0; squaredDeviations = 0; sum = 0; }
+    void add(T value, size_t n) {
+        double delta = value - average;
+        average += delta / n;
+        squaredDeviations += delta * (value - average);
+        sum = average * n;
+    }
+    void replace(T evicted, T value, size_t n) {
+        double previous = average;
+        average += ((double)value - evicted) / n;
+        squaredDeviations += ((double)value - evicted) * ((double)value - average + evicted - previous);
+        if (squaredDeviations < 0) squaredDeviations = 0;
+        sum = average * n;
+    }
+    double mean(size_t) const { return average; }
+    double variance(size_t n) const { return squaredDeviations / (n - 1); }
+};
+
+}  // namespace sliding_window_detail
+
+template <typename T, size_t N>
+class SlidingWindowStats {
+    static_assert(N >= 1, "SlidingWindowStats needs a window of at least one value");
+
+public:
+    static constexpr size_t WINDOW = N;
+    typedef typename sliding_window_detail::Moments<T>::Sum Sum;
+
+    SlidingWindowStats() { clear(); }
+
+    void clear() {
+        filled = 0;
+        next = 0;
+        minHead = 0;
+        minCount = 0;
+        maxHead = 0;
+        maxCount = 0;
+        moments.clear();
+    }
+
+    // Returns the value that left the window (0 until it is full)
+    T push(T value) {
+        T evicted = 0;
+        if (filled == N) {
+            evicted = values[next];
+            // The slot about to be reused holds the oldest value
+            if (minQueue[minHead] == next) popFront(minHead, minCount);
+            if (maxQueue[maxHead] == next) popFront(maxHead, maxCount);
+            moments.replace(evicted, value, N);
+        } else {
+            filled++;
+            moments.add(value, filled);
+        }
+        values[next] = value;
+
+        while (minCount > 0 && values[back(minHead, minCount, minQueue)] > value) minCount--;
+        pushBack(minQueue, minHead, minCount, next);
+        while (maxCount > 0 && values[back(maxHead, maxCount, maxQueue)] < value) maxCount--;
+        pushBack(maxQueue, maxHead, maxCount, next);
+
+        next = next + 1 == N ? 0 : next + 1;
+        return evicted;
+    }
+
+    size_t count() const { return filled; }
+    bool full() const { return filled == N; }
+    T minimum() const { return filled ? values[minQueue[minHead]] : 0; }
+    T maximum() const { return filled ? values[maxQueue[maxHead]] : 0; }
+    T range() const { return maximum() - minimum(); }
+    T newest() const { return filled ? values[next == 0 ? N - 1 : next - 1] : 0; }
+    // i = 0 is the oldest value in the window
+    T at(size_t i) const { return values[(next + (filled == N ? i : N - filled + i)) % N]; }
+
+    Sum sum() const { return filled ? moments.sum : 0; }
+    float mean() const { return filled ? (float)moments.mean(filled) : 0.0f; }
+    // Sample variance (n - 1), 0 with fewer than two values
+    float variance() const {
+        if (filled < 2) return 0.0f;
+        double v = moments.variance(filled);
+        return v > 0 ? (float)v : 0.0f;
+    }
+    float standardDeviation() const { return sqrtf(variance()); }
+
+private:
+    T values[N];            // Ring in arrival order
+    size_t filled;
+    size_t next;            // Slot the next value goes into
+
+    // Window positions, values ascending (min) or descending (max) from the front
+    size_t minQueue[N];
+    size_t minHead;
+    size_t minCount;
+    size_t maxQueue[N];
+    size_t maxHead;
+    size_t maxCount;
+
+    sliding_window_detail::Moments<T> moments;
+
+    static size_t back(size_t head, size_t count, const size_t* queue) {
+        size_t at = head + count - 1;
+        return queue[at >= N ? at - N : at];
+    }
+    static void pushBack(size_t* queue, size_t head, size_t& count, size_t position) {
+        size_t at = head + count;
+        queue[at >= N ? at - N : at] = position;
+        count++;
+    }
+    static void popFront(size_t& head, size_t& count) {
+        head = head + 1 == N ? 0 : head + 1;
+        count--;
+    }
+};
+
+#endif // DSP_SLIDING_WINDOW_STATS_H
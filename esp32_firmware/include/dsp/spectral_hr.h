@@ -0,0 +1,92 @@
+#ifndef DSP_SPECTRAL_HR_H
+#define DSP_SPECTRAL_HR_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "dsp/fft.h"
+#include "sensors/ppg_acquisition.h"
+
+// Heart rate from the PPG spectrum, and SpO2 from the ratio of ratios
+// Samples are averaged into 40 ms bins of source time (25 Hz whatever the
+// stream rate) and the newest 10.24 s of IR is kept in a ring. Every 1.28 s
+// the window is Hann-weighted, zero-padded to 512 points and transformed;
+// the heart rate is the spectral peak in 35-210 BPM, placed between bins by
+// a parabola through the log power. Once locked, the peak is tracked from
+// window to window: a strong enough peak near the last rate wins over a
+// slightly stronger one elsewhere (a motion burst or the dicrotic
+// harmonic). Window and twiddles are tabulated once.
+//
+// For SpO2 each channel keeps a running DC level and AC power (exponential
+// averages, a few operations per bin), and R = (AC/DC red) / (AC/DC IR)
+// maps to SpO2 through Maxim's MAX30102 calibration curve.
+
+struct SpectralEstimate {
+    float heartRateBpm;     // 0 until the first full window
+    float confidence;       // Share of the 35-210 BPM power in the peak (0-1)
+    float ratio;            // Ratio of ratios R
+    float spo2;             // %
+    bool heartRateValid;
+    bool spo2Valid;
+    uint32_t updates;       // Windows analysed since reset
+};
+
+class SpectralHeartRate {
+public:
+    static const uint32_t BIN_US = 40000;       // 25 Hz
+    static const uint32_t WINDOW = 256;         // Bins analysed, 10.24 s
+    static const uint32_t HOP = 32;             // Bins between analyses, 1.28 s
+    static const uint32_t FFT_SIZE = 512;       // Zero-padded, 2.9 BPM per bin
+
+    SpectralHeartRate();
+
+    // Returns true when the sample completed a window analysis
+    bool addSample(uint32_t red, uint32_t ir, uint64_t timestampUs);
+    size_t addBlock(const PPGSample* samples, size_t count);     // Analyses completed
+    void reset();
+
+    const SpectralEstimate& getEstimate() const { return estimate; }
+    // Power of one FFT bin from the last analysis (for tests and diagnostics)
+    float powerAt(uint32_t bin) const { return bin < FFT_SIZE / 2 ? power[bin] : 0; }
+
+private:
+    static const uint32_t MAX_GAP_BINS = 3;     // Held across; longer gaps restart
+    static const uint32_t LOW_BIN = 12;         // 0.59 Hz, 35 BPM
+    static const uint32_t HIGH_BIN = 72;        // 3.52 Hz, 211 BPM
+
+    Radix2FFT<FFT_SIZE> fft;
+    float window[WINDOW];                       // Hann weights
+    float re[FFT_SIZE];
+    float im[FFT_SIZE];
+    float power[FFT_SIZE / 2];
+
+    float ring[WINDOW];                         // IR bin means, oldest at head once full
+    uint32_t head;
+    uint32_t filled;
+    uint32_t sinceAnalysis;
+
+    // Bin being filled
+    bool binOpen;
+    uint32_t bin;
+    uint64_t redSum;
+    uint64_t irSum;
+    uint32_t binCount;
+    float lastRed;
+    float lastIr;
+
+    // Running DC level and AC power per channel
+    bool levelsPrimed;
+    float dcRed;
+    float dcIr;
+    float acPowerRed;
+    float acPowerIr;
+
+    SpectralEstimate estimate;
+
+    bool pushBin(float red, float ir);
+    void restart();
+    void analyse();
+    uint32_t strongestPeak(uint32_t low, uint32_t high) const;
+    void updateSpO2();
+};
+
+#endif // DSP_SPECTRAL_HR_H
@@ -0,0 +1,93 @@
+#ifndef HAL_HAL_H
+#define HAL_HAL_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Thin hardware abstraction for code that also builds off-target
+// One implementation of each interface per platform: hal_esp32.cpp (Arduino
+// core, SPI, SPIFFS) on the ESP32 and hal_native.cpp (Linux
+// stubs, a directory for the filesystem) on a host. Modules reach them
+// through hal::clock() and friends; a test installs its own with setClock()
+// etc. and restores the platform's by passing nullptr.
+//
+// On the host, include/hal/native/Arduino.h maps the Arduino calls the
+// portable modules still make (millis(), delay(), pinMode(), Serial) onto
+// the same interfaces.
+
+namespace hal {
+
+class Clock {
+public:
+    virtual ~Clock() {}
+    virtual uint32_t millis() = 0;
+    virtual uint64_t micros() = 0;          // 64-bit, the esp_timer clock on target
+    virtual void delayMs(uint32_t ms) = 0;
+    virtual void delayUs(uint32_t us) = 0;
+};
+
+class Gpio {
+public:
+    enum Mode : uint8_t { MODE_INPUT, MODE_OUTPUT, MODE_INPUT_PULLUP };
+    virtual ~Gpio() {}
+    virtual void setMode(uint8_t pin, Mode mode) = 0;
+    virtual bool read(uint8_t pin) = 0;
+    virtual void write(uint8_t pin, bool high) = 0;
+    virtual int readAnalog(uint8_t pin) = 0;    // Raw ADC counts
+};
+
+// The shared SPI bus; chip select stays with the driver (Gpio)
+class Spi {
+public:
+    virtual ~Spi() {}
+    virtual void beginTransaction(uint32_t clockHz, uint8_t mode) = 0;
+    virtual void endTransaction() = 0;
+    virtual uint8_t transfer(uint8_t value) = 0;
+    // Full duplex; tx or rx may be null (zeros out, or discarded in)
+    virtual void transfer(const uint8_t* tx, uint8_t* rx, size_t length) {
+        for (size_t i = 0; i < length; i++) {
+            uint8_t in = transfer(tx ? tx[i] : 0);
+            if (rx) rx[i] = in;
+        }
+    }
+};
+
+// Flat files by path, as SPIFFS holds them
+class FileSystem {
+public:
+    virtual ~FileSystem() {}
+    virtual bool mount() = 0;
+    virtual bool exists(const char* path) = 0;
+    virtual long size(const char* path) = 0;    // -1 if missing
+    // The file front to back in one open, a chunk per call to sink until the
+    // end or sink returns false. Chunks are NUL-terminated; false if missing
+    typedef bool (*ChunkSink)(void* context, const char* data, size_t length);
+    static const size_t READ_CHUNK_BYTES = 256;
+    virtual bool read(const char* path, ChunkSink sink, void* context) = 0;
+    virtual bool write(const char* path, const char* data, size_t length, bool append) = 0;
+    virtual bool remove(const char* path) = 0;
+    virtual size_t totalBytes() = 0;
+    virtual size_t usedBytes() = 0;
+};
+
+Clock& clock();
+Gpio& gpio();
+Spi& spi();
+FileSystem& fileSystem();
+uint32_t freeHeapBytes();
+
+void setClock(Clock* clock);
+void setGpio(Gpio* gpio);
+void setSpi(Spi* spi);
+void setFileSystem(FileSystem* fileSystem);
+
+// The platform's own implementations
+Clock& platformClock();
+Gpio& platformGpio();
+Spi& platformSpi();
+FileSystem& platformFileSystem();
+uint32_t platformFreeHeapBytes();
+
+} // namespace hal
+
+#endif // HAL_HAL_H
@@ -0,0 +1,166 @@
+#ifndef HAL_NATIVE_ARDUINO_H
+#define HAL_NATIVE_ARDUINO_H
+
+// The slice of the Arduino core the portable modules use, for the native
+// build only (on its include path ahead of everything else). Timing and
+// pins go through the HAL, Serial to stdout.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <math.h>
+#include <cmath>
+#include <string>
+#include <algorithm>
+#include "hal/hal.h"
+
+using std::abs;
+using std::max;
+using std::min;
+
+#ifndef PI
+#define PI 3.1415926535897932384626433832795
+#endif
+#define DEG_TO_RAD 0.017453292519943295769236907684886
+#define RAD_TO_DEG 57.295779513082320876798154814105
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+#define IRAM_ATTR
+
+#define LOW 0x0
+#define HIGH 0x1
+#define INPUT 0x01
+#define OUTPUT 0x03
+#define INPUT_PULLUP 0x05
+
+inline unsigned long millis() { return hal::clock().millis(); }
+inline unsigned long micros() { return (unsigned long)hal::clock().micros(); }
+inline void delay(uint32_t ms) { hal::clock().delayMs(ms); }
+inline void delayMicroseconds(uint32_t us) { hal::clock().delayUs(us); }
+
+inline void pinMode(uint8_t pin, uint8_t mode) {
+    hal::gpio().setMode(pin, mode == OUTPUT ? hal::Gpio::MODE_OUTPUT
+                             : (mode == INPUT_PULLUP ? hal::Gpio::MODE_INPUT_PULLUP : hal::Gpio::MODE_INPUT));
+}
+inline int digitalRead(uint8_t pin) { return hal::gpio().read(pin) ? HIGH : LOW; }
+inline void digitalWrite(uint8_t pin, uint8_t value) { hal::gpio().write(pin, value != LOW); }
+inline int analogRead(uint8_t pin) { return hal::gpio().readAnalog(pin); }
+
+inline long map(long x, long inMin, long inMax, long outMin, long outMax) {
+    return (x - inMin) * (outMax - outMin) / (inMax - inMin) + outMin;
+}
+
+// Arduino's String over std::string, enough for the modules and ArduinoJson
+class String {
+public:
+    String(const char* text = "") : text(text ? text : "") {}
+    String(const std::string& text) : text(text) {}
+    explicit String(char c) : text(1, c) {}
+    String(int value, unsigned char base = 10);
+    String(unsigned int value, unsigned char base = 10);
+    String(long value, unsigned char base = 10);
+    String(unsigned long value, unsigned char base = 10);
+    String(float value, unsigned int decimals = 2);
+    String(double value, unsigned int decimals = 2);
+
+    const char* c_str() const { return text.c_str(); }
+    unsigned int length() const { return (unsigned int)text.length(); }
+    bool isEmpty() const { return text.empty(); }
+    void reserve(unsigned int size) { text.reserve(size); }
+    bool concat(const String& other) {
+        text += other.text;
+        return true;
+    }
+    bool concat(const char* other) {
+        if (other) text += other;
+        return true;
+    }
+    bool concat(char c) {
+        text += c;
+        return true;
+    }
+
+    String& operator+=(const String& other) {
+        text += other.text;
+        return *this;
+    }
+    String& operator+=(const char* other) {
+        concat(other);
+        return *this;
+    }
+    String& operator+=(char c) {
+        text += c;
+        return *this;
+    }
+    char operator[](unsigned int index) const { return index < text.length() ? text[index] : 0; }
+    bool operator==(const String& other) const { return text == other.text; }
+    bool operator==(const char* other) const { return text == (other ? other : ""); }
+    bool operator!=(const String& other) const { return text != other.text; }
+    bool operator<(const String& other) const { return text < other.text; }
+    bool equals(const String& other) const { return text == other.text; }
+
+    int indexOf(char c, unsigned int from = 0) const;
+    int indexOf(const String& other, unsigned int from = 0) const;
+    String substring(unsigned int from) const { return substring(from, length()); }
+    String substring(unsigned int from, unsigned int to) const;
+    long toInt() const { return atol(text.c_str()); }
+    float toFloat() const { return (float)atof(text.c_str()); }
+
+private:
+    std::string text;
+};
+
+inline String operator+(const String& a, const String& b) {
+    String sum(a);
+    sum += b;
+    return sum;
+}
+inline String operator+(const String& a, const char* b) {
+    String sum(a);
+    sum += b;
+    return sum;
+}
+inline String operator+(const char* a, const String& b) {
+    String sum(a);
+    sum += b;
+    return sum;
+}
+
+#define DEC 10
+#define HEX 16
+
+class HardwareSerial {
+public:
+    // Host only: where the output goes, nullptr to drop it
+    void setOutput(FILE* stream) { output = stream; }
+    void begin(unsigned long) {}
+    void flush();
+    int available() { return 0; }
+    int read() { return -1; }
+    size_t print(const char* text);
+    size_t print(const String& text) { return print(text.c_str()); }
+    size_t print(char c);
+    size_t print(int value, int base = DEC) { return print(String(value, (unsigned char)base)); }
+    size_t print(unsigned int value, int base = DEC) { return print(String(value, (unsigned char)base)); }
+    size_t print(long value, int base = DEC) { return print(String(value, (unsigned char)base)); }
+    size_t print(unsigned long value, int base = DEC) { return print(String(value, (unsigned char)base)); }
+    size_t print(double value, int decimals = 2) { return print(String(value, (unsigned int)decimals)); }
+    size_t println() { return print("\n"); }
+    template <typename T>
+    size_t println(const T& value) {
+        return print(value) + println();
+    }
+    template <typename T>
+    size_t println(const T& value, int format) {
+        return print(value, format) + println();
+    }
+    size_t printf(const char* format, ...) __attribute__((format(printf, 2, 3)));
+
+private:
+    FILE* output = stdout;
+};
+
+extern HardwareSerial Serial;
+
+#endif // HAL_NATIVE_ARDUINO_H
@@ -0,0 +1,172 @@
+#ifndef REPLAY_SIGNAL_REPLAY_H
+#define REPLAY_SIGNAL_REPLAY_H
+
+#include <stdint.h>
+#include <vector>
+#include <chrono>
+#include "hal/hal.h"
+#include "replay/trace.h"
+#include "blood_pressure.h"
+#include "body_composition.h"
+#include "dsp/pipeline.h"
+#include "dsp/signal_quality.h"
+#include "sensors/ppg_acquisition.h"
+#include "config.h"
+
+// Host replay of recorded traces through the estimators, as fast as the CPU
+// goes. The records are wired the way SensorManager wires the live streams:
+// ECG in ECG_STREAM_BLOCK_SIZE blocks through the band-pass and QRS chain
+// into the SQI engine and BloodPressureMonitor, PPG in FIFO bursts into the
+// monitor and its own SQI chain, and BIA sweeps into BodyCompositionAnalyzer
+// (a sweep ends where the frequency stops rising or after SWEEP_GAP_MS without
+// a point).
+// A blood pressure estimate is taken every bpIntervalMs of trace time.
+// While it runs, the HAL clock is a virtual one set to each record's time,
+// so millis() and the timestamps the modules stamp follow the trace.
+// The filters are designed for the stream rates, so traces must be recorded
+// at ECG_STREAM_SAMPLE_RATE and PPG_STREAM_SAMPLE_RATE.
+
+// Trace time: jumps to each record, delays move it on without sleeping
+class ReplayClock : public hal::Clock {
+public:
+    uint64_t nowUs = 0;
+
+    uint32_t millis() override { return (uint32_t)(nowUs / 1000); }
+    uint64_t micros() override { return nowUs; }
+    void delayMs(uint32_t ms) override { nowUs += (uint64_t)ms * 1000; }
+    void delayUs(uint32_t us) override { nowUs += us; }
+};
+
+struct ReplayConfig {
+    UserProfile profile = {35, 175.0f, 70.0f, true, 3, false};
+    uint32_t bpIntervalMs = BLOOD_PRESSURE_INTERVAL;
+    bool moduleOutput = false;      // Let the modules' Serial logging through
+};
+
+enum ReplayStage {
+    REPLAY_STAGE_ECG_CHAIN,         // Band-pass, QRS, SQI and the monitor's ECG side
+    REPLAY_STAGE_PPG_MONITOR,       // BloodPressureMonitor::addPPGBlock()
+    REPLAY_STAGE_PPG_QUALITY,       // The PPG SQI chain
+    REPLAY_STAGE_BP_ESTIMATE,       // calculateBloodPressure()
+    REPLAY_STAGE_BIA_ANALYSIS,      // analyzeBodyComposition() per sweep
+    REPLAY_STAGE_COUNT
+};
+
+// Wall time spent in one stage
+struct ReplayStageStats {
+    uint32_t calls;
+    uint64_t samples;
+    double totalSeconds;
+    double maxSeconds;              // Slowest single call
+};
+
+struct ReplayReport {
+    uint64_t records[3];            // Per TraceChannel
+    uint64_t firstUs;
+    uint64_t lastUs;
+    double wallSeconds;             // begin() to finish(), reading the trace included
+    uint32_t rPeaks;
+    uint32_t pulses;
+    uint32_t leadOffResets;
+    float ecgRateHz;                // Measured from the timestamps
+    float ppgRateHz;
+
+    std::vector<BloodPressureData> bloodPressure;   // Estimates taken once the monitor was ready
+    std::vector<BodyComposition> bodyComposition;   // One per sweep
+    HrvMetrics hrv;
+    float heartRateBPM;             // From the QRS detector at the end
+    SignalQualityIndex ecgQuality;
+    SignalQualityIndex ppgQuality;
+
+    ReplayStageStats stages[REPLAY_STAGE_COUNT];
+
+    double traceSeconds() const { return lastUs > firstUs ? (lastUs - firstUs) / 1e6 : 0; }
+    uint64_t totalRecords() const { return records[0] + records[1] + records[2]; }
+    double samplesPerSecond() const { return wallSeconds > 0 ? totalRecords() / wallSeconds : 0; }
+    double speedup() const { return wallSeconds > 0 ? traceSeconds() / wallSeconds : 0; }
+};
+
+const char* replayStageName(ReplayStage stage);
+
+class SignalReplay {
+public:
+    explicit SignalReplay(const ReplayConfig& config = ReplayConfig());
+
+    // Whole trace from a file (CSV or binary)
+    bool run(const char* path);
+
+    // Or record by record: begin() installs the virtual clock, finish()
+    // flushes the partial blocks and sweep and puts the platform clock back
+    void begin();
+    void addRecord(const TraceRecord& record);
+    void finish();
+
+    const ReplayReport& getReport() const { return report; }
+    BloodPressureMonitor& getBloodPressureMonitor() { return bpMonitor; }
+    uint32_t getSkippedRecords() const { return skippedRecords; }
+
+    void printReport() const;
+
+private:
+    ReplayConfig config;
+    ReplayClock clock;
+    ReplayReport report;
+    uint32_t skippedRecords = 0;
+    bool running = false;
+
+    BloodPressureMonitor bpMonitor;
+    BodyCompositionAnalyzer bodyComposition;
+
+    // The stream chains from SensorManager, less the display branch
+    enum ECGTap { ECG_TAP_RAW, ECG_TAP_FILTERED };
+    Pipeline<TapStage<ECG_TAP_RAW>,
+             BandpassStage<ECGBandpass<ECG_STREAM_SAMPLE_RATE>, 3>,
+             TapStage<ECG_TAP_FILTERED>,
+             QrsStage<ECG_STREAM_SAMPLE_RATE> > ecgPipeline;
+    QrsDetector& ecgQrs() { return ecgPipeline.stage<3>().detector(); }
+    SignalQualityEngine ecgQuality;
+    SignalQualityEngine ppgQuality;
+    enum PPGQualityTap { PPG_TAP_FILTERED };
+    Pipeline<BandpassStage<PPGBandpass<PPG_STREAM_SAMPLE_RATE>, -4>,
+             TapStage<PPG_TAP_FILTERED>,
+             PulseFiducialStage> ppgQualityPipeline;
+
+    struct ECGEvents {
+        SignalReplay& self;
+        void on(const TappedBlock<ECG_TAP_RAW>& tap);
+        void on(const TappedBlock<ECG_TAP_FILTERED>& tap);
+        void on(const QrsEvent& beat);
+    };
+    struct PPGQualityEvents {
+        SignalReplay& self;
+        void on(const TappedBlock<PPG_TAP_FILTERED>& tap);
+        void on(const PulseFiducials& beat);
+    };
+
+    // Pending blocks, handed on when full like the acquisition tasks do
+    static const size_t PPG_BURST_SIZE = MAX30102Reg::FIFO_DEPTH - 15;     // PPGAcquisitionConfig::almostFullFree
+    static const int MAX_SWEEP_POINTS = 32;
+    static const uint32_t SWEEP_GAP_MS = 2000;
+    float ecgValues[ECG_STREAM_BLOCK_SIZE];
+    uint64_t ecgTimes[ECG_STREAM_BLOCK_SIZE];
+    size_t ecgCount = 0;
+    PPGSample ppgBurst[PPG_BURST_SIZE];
+    size_t ppgCount = 0;
+    BIAResult sweep[MAX_SWEEP_POINTS];
+    int sweepCount = 0;
+    uint64_t sweepLastUs = 0;
+    uint64_t nextEstimateUs = 0;
+    uint64_t channelFirstUs[3] = {};
+    uint64_t channelLastUs[3] = {};
+    bool ecgFed = false;
+    std::chrono::steady_clock::time_point wallStart;
+
+    void flushECG();
+    void flushPPG();
+    void flushSweep();
+    void estimateBloodPressure();
+    void shareSignalQuality();
+    void countStage(ReplayStage stage, uint64_t samples, double seconds);
+};
+
+#endif // REPLAY_SIGNAL_REPLAY_H
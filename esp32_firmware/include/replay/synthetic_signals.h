@@ -0,0 +1,173 @@
+#ifndef REPLAY_SYNTHETIC_SIGNALS_H
+#define REPLAY_SYNTHETIC_SIGNALS_H
+
+#include <stdint.h>
+#include <vector>
+#include "replay/trace.h"
+#include "config.h"
+
+class SignalReplay;
+
+// Deterministic synthetic ECG, PPG and BIA with known ground truth, for load
+// and accuracy runs on the host. The same config and seed give the same
+// records bit for bit.
+//   ECG  P-QRS-T as a sum of Gaussians, in raw AD8232 counts around mid-rail.
+//        RR intervals carry respiratory sinus arrhythmia plus random jitter;
+//        premature ventricular beats (wide QRS, no P, inverted T) come early
+//        and are followed by a compensatory pause.
+//   PPG  IR and Red pulses (half-cosine rise, exponential runoff, dicrotic
+//        wave) in raw MAX30102 polarity, with the steepest upstroke PTT after
+//        each R-peak. The Red AC/DC follows the usual R = (110 - SpO2) / 25.
+//   BIA  Sweeps of a Cole tissue model, Z = Rinf + (R0 - Rinf) / (1 + (jf/fc)^alpha),
+//        with the reactance as the positive capacitive value the analyzer expects.
+// Baseline wander, white noise, motion artefacts and lead-off intervals are
+// layered on top. Records come out merged in time order, ready for
+// TraceWriter or SignalReplay::addRecord() on the host; the generator itself
+// also builds for the ESP32, where it feeds the kernel benchmarks.
+
+struct ColeModel {
+    float r0 = 620.0f;              // Ohm, at DC (extracellular path)
+    float rInf = 420.0f;            // Ohm, at infinite frequency (both paths)
+    float fcHz = 50000.0f;          // Characteristic frequency
+    float alpha = 0.75f;            // Dispersion, 1 for an ideal RC
+
+    // Resistance and (positive) capacitive reactance at frequencyHz
+    void impedanceAt(float frequencyHz, float& resistance, float& reactance) const;
+};
+
+// Seconds from the start of the trace
+struct SyntheticInterval {
+    double start;
+    double end;
+
+    bool contains(double t) const { return t >= start && t < end; }
+};
+
+struct SyntheticConfig {
+    uint32_t seed = 1;
+    double seconds = 60;
+    uint64_t startUs = 5000000;     // Time stamped on the first record
+    double ecgRateHz = ECG_STREAM_SAMPLE_RATE;
+    double ppgRateHz = PPG_STREAM_SAMPLE_RATE;
+
+    // Rhythm
+    float heartRateBPM = 70;
+    float rsaFraction = 0.04f;      // Peak RR modulation by breathing
+    float respirationHz = 0.25f;
+    float rrJitterMs = 15;          // Gaussian, per beat
+    float ectopicFraction = 0;      // Share of beats that are premature ventricular
+    float ectopicCoupling = 0.65f;  // Premature RR as a fraction of the normal one
+
+    // ECG, in mV at the electrodes
+    float rAmplitudeMv = 0.8f;
+    float ecgNoiseMv = 0.01f;
+    float baselineWanderMv = 0.15f;
+    float mainsMv = 0;              // 50 Hz pickup
+
+    // PPG, in raw counts
+    float pttMs = 200;              // R-peak to the steepest upstroke
+    float pttSwingMs = 0;           // Respiratory modulation of the PTT, peak
+    float ppgDcCounts = 100000;
+    float ppgAmplitudeCounts = 1500;
+    float ppgRiseMs = 120;
+    float ppgNoiseCounts = 3;
+    float ppgWanderFraction = 0.002f;   // Respiratory DC swing, of the DC
+    float spo2 = 97;                // Sets the Red AC/DC against the IR
+    float redDcFraction = 0.8f;     // Red DC against the IR DC
+    float ectopicPulseScale = 0.4f; // Stroke volume of a premature beat
+
+    // Artefacts
+    std::vector<SyntheticInterval> motion;
+    float motionMv = 0.3f;          // ECG electrode motion and EMG
+    float motionCounts = 6000;      // PPG sensor movement
+    std::vector<SyntheticInterval> leadOff;     // ECG reads the rail with the flag set
+
+    // BIA
+    ColeModel cole;
+    std::vector<double> sweepTimes;             // Seconds, one sweep starts at each
+    std::vector<float> sweepFrequencies = {5000, 10000, 50000, 100000, 200000};
+    float sweepPointMs = 150;       // Between points of a sweep
+    float biaNoiseOhms = 0;         // Gaussian, on R and X
+};
+
+// ECG scale: AD8232 gain 1100 into the 12-bit ADC over 3.3 V
+static const float SYNTHETIC_ECG_COUNTS_PER_MV = 1100.0f * 4096.0f / 3300.0f;
+static const float SYNTHETIC_ECG_MIDRAIL = 2048.0f;
+
+struct SyntheticBeat {
+    double rPeak;                   // Seconds from the start of the trace
+    double ppgMaxSlope;             // Steepest upstroke of its pulse
+    bool ectopic;
+
+    double pttMs() const { return (ppgMaxSlope - rPeak) * 1e3; }
+};
+
+struct SyntheticTruth {
+    std::vector<SyntheticBeat> beats;   // The last may peak just after the end
+    std::vector<double> sweepEnds;  // Time of each sweep's last point
+
+    // Over the beats inside [from, to) seconds
+    float meanHeartRateBPM(double from = 0, double to = 1e9) const;
+    float meanPttMs(double from = 0, double to = 1e9) const;
+    uint32_t beatsBetween(double from, double to) const;
+    uint32_t ectopicBeats() const;
+};
+
+class SyntheticSignals {
+public:
+    explicit SyntheticSignals(const SyntheticConfig& config = SyntheticConfig());
+
+    // False after config.seconds; restart() replays the same records
+    bool next(TraceRecord& record);
+    void restart();
+
+    const SyntheticConfig& getConfig() const { return config; }
+    const SyntheticTruth& getTruth() const { return truth; }
+
+#ifndef ARDUINO
+    // The whole trace into a file (CSV or binary) or a running replay;
+    // record counts, 0 if the file fails
+    uint64_t writeTo(const char* path, bool binary);
+    uint64_t feed(SignalReplay& replay);
+#endif
+
+    // Noise-free signals at t seconds, artefacts and lead-off left out
+    float ecgCountsAt(double t) const;
+    void ppgCountsAt(double t, float& ir, float& red) const;
+
+private:
+    // Seeded and portable, so traces match across hosts and compilers
+    struct Random {
+        uint64_t state;
+
+        void seed(uint64_t value) { state = value * 0x9E3779B97F4A7C15ULL + 1; }
+        uint32_t nextU32();
+        double uniform();           // [0, 1)
+        double gaussian();
+    };
+
+    SyntheticConfig config;
+    SyntheticTruth truth;
+    Random ecgNoise;
+    Random ppgNoise;
+    Random biaNoise;
+    std::vector<double> motionPhases;   // Three per motion interval
+
+    uint64_t ecgIndex = 0;
+    uint64_t ppgIndex = 0;
+    size_t sweepIndex = 0;
+    size_t sweepPoint = 0;
+    // First beat that can still reach the current sample, per channel
+    size_t ecgBeat = 0;
+    size_t ppgBeat = 0;
+
+    void buildBeats();
+    double pttSecondsAt(double t) const;
+    double ecgMvAt(double t, size_t& firstBeat) const;
+    double pulseVolumeAt(double t, size_t& firstBeat) const;
+    double respirationAt(double t) const;
+    double motionAt(double t, double& envelope) const;
+    uint64_t timeUs(double t) const;
+};
+
+#endif // REPLAY_SYNTHETIC_SIGNALS_H
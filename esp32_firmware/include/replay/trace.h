@@ -0,0 +1,70 @@
+#ifndef REPLAY_TRACE_H
+#define REPLAY_TRACE_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+// Recorded sensor traces for host replay (see test/data/traces/README.md)
+// One record per sample, with the time the firmware stamped on it:
+//   ECG  values[0] raw ADC counts, values[1] non-zero while the leads are off
+//   PPG  values[0] IR counts, values[1] Red counts
+//   BIA  values[0] frequency (Hz), values[1] resistance, values[2] reactance (ohm)
+// CSV is "time_us,channel,value..." after '#' header lines; binary is the
+// 8-byte magic then 24-byte little-endian records (time, channel, 3 floats).
+// The reader tells them apart by the magic.
+
+enum class TraceChannel : uint8_t {
+    ECG,
+    PPG,
+    BIA
+};
+
+struct TraceRecord {
+    uint64_t timeUs;
+    TraceChannel channel;
+    float values[3];
+};
+
+const char* traceChannelName(TraceChannel channel);
+
+class TraceReader {
+public:
+    TraceReader() {}
+    ~TraceReader() { close(); }
+
+    bool open(const char* path);
+    void close();
+
+    // False at the end of the trace; malformed CSV lines are skipped and counted
+    bool next(TraceRecord& record);
+
+    bool isBinary() const { return binary; }
+    uint32_t getSkippedLines() const { return skippedLines; }
+
+private:
+    FILE* file = nullptr;
+    bool binary = false;
+    uint32_t skippedLines = 0;
+
+    TraceReader(const TraceReader&);
+    TraceReader& operator=(const TraceReader&);
+};
+
+class TraceWriter {
+public:
+    TraceWriter() {}
+    ~TraceWriter() { close(); }
+
+    bool open(const char* path, bool binary);
+    bool close();
+    bool write(const TraceRecord& record);
+
+private:
+    FILE* file = nullptr;
+    bool binary = false;
+
+    TraceWriter(const TraceWriter&);
+    TraceWriter& operator=(const TraceWriter&);
+};
+
+#endif // REPLAY_TRACE_H
@@ -0,0 +1,84 @@
+#ifndef SENSOR_READINGS_H
+#define SENSOR_READINGS_H
+
+// The readings SensorManager produces, apart from the drivers so that
+// DataManager and the host build can use them without the sensor libraries
+
+#include <Arduino.h>
+#include "blood_pressure.h"
+#include "body_composition.h"
+#include "dsp/heart_rate_fusion.h"
+#include "dsp/signal_quality.h"
+
+// Sensor data structures
+struct HeartRateData {
+    float heartRate;
+    float spO2;
+    bool validReading;
+    unsigned long timestamp;
+    uint8_t sources;        // HeartRateSource bits fused into heartRate
+};
+
+struct TemperatureData {
+    float temperature;
+    bool validReading;
+    unsigned long timestamp;
+};
+
+struct WeightData {
+    float weight;
+    bool validReading;
+    bool stable;
+    unsigned long timestamp;
+};
+
+struct BioimpedanceData {
+    float resistance;
+    float reactance;
+    float impedance;
+    float phase;
+    float frequency;        // Add frequency
+    bool validReading;
+    unsigned long timestamp;
+};
+
+struct ECGData {
+    float avgFilteredValue;
+    int avgBPM;
+    int peakCount;
+    bool validReading;
+    bool leadOff;           // Lead-off detection
+    unsigned long timestamp;
+};
+
+struct GlucoseData {
+    float glucoseLevel;     // mg/dL
+    float irValue;
+    float redValue;    float ratio;            // Red/IR ratio
+    float signalQuality;    // PPG SQI score (0-100)
+    bool validReading;
+    bool stable;           // Signal stability
+    unsigned long timestamp;
+};
+
+// Per-channel SQI of the latest assessed windows (dsp/signal_quality.h)
+struct SignalQualityReport {
+    SignalQualityIndex ecg;
+    SignalQualityIndex ppg;
+    SignalQualityIndex bia;     // The last sweep
+};
+
+struct SensorReadings {
+    HeartRateData heartRate;
+    TemperatureData temperature;
+    WeightData weight;
+    BioimpedanceData bioimpedance;
+    ECGData ecg;
+    GlucoseData glucose;
+    BloodPressureData bloodPressure;  // Add blood pressure data
+    BodyComposition bodyComposition;  // Add body composition analysis
+    SignalQualityReport quality;
+    unsigned long systemTimestamp;
+};
+
+#endif // SENSOR_READINGS_H
@@ -14,93 +14,147 @@
 #include "BIA_Application.h"
 #include "blood_pressure.h"  // Add blood pressure monitor
 #include "body_composition.h"  // Add body composition analysis
+#include "sensors/ppg_acquisition.h"
+#include "sensors/ppg_fanout.h"
+#include "sensors/max30102_wire_bus.h"
+#include "sensors/ecg_acquisition.h"
+#include "sensors/ad8232_front_end.h"
+#include "sensors/ds18b20_pipeline.h"
+#include "sensors/dallas_temperature_bus.h"
+#include "sensors/sensor_scheduler.h"
+#include "sensors/stream_quality.h"
+#include "dsp/qrs_detector.h"
+#include "dsp/pipeline.h"
+#include "dsp/spectral_hr.h"
+#include "dsp/rolling_ppg_window.h"
+#include "dsp/heart_rate_fusion.h"
+#include "dsp/sliding_window_stats.h"
+#include "dsp/signal_quality.h"
+#include "sensor_readings.h"
 #include "config.h"
 
-// Sensor data structures
-struct HeartRateData {
-    float heartRate;
-    float spO2;
-    bool validReading;
-    unsigned long timestamp;
-};
-
-struct TemperatureData {
-    float temperature;
-    bool validReading;
-    unsigned long timestamp;
-};
-
-struct WeightData {
-    float weight;
-    bool validReading;
-    bool stable;
-    unsigned long timestamp;
-};
-
-struct BioimpedanceData {
-    float resistance;
-    float reactance;
-    float impedance;
-    float phase;
-    float frequency;        // Add frequency
-    bool validReading;
-    unsigned long timestamp;
-};
-
-struct ECGData {
-    float avgFilteredValue;
-    int avgBPM;
-    int peakCount;
-    bool validReading;
-    bool leadOff;           // Lead-off detection
-    unsigned long timestamp;
-};
-
-struct GlucoseData {
-    float glucoseLevel;     // mg/dL
-    float irValue;
-    float redValue;    float ratio;            // Red/IR ratio
-    float signalQuality;    // Signal variation percentage
-    bool validReading;
-    bool stable;           // Signal stability
-    unsigned long timestamp;
-};
-
-struct SensorReadings {
-    HeartRateData heartRate;
-    TemperatureData temperature;
-    WeightData weight;
-    BioimpedanceData bioimpedance;
-    ECGData ecg;
-    GlucoseData glucose;
-    BloodPressureData bloodPressure;  // Add blood pressure data
-    BodyComposition bodyComposition;  // Add body composition analysis
-    unsigned long systemTimestamp;
-};
-
 class SensorManager {
 private:    // Sensor objects
     MAX30105 heartRateSensor;
-    MAX30105 glucoseSensor;     // Second MAX30105 for glucose monitoring
     OneWire oneWire;
     DallasTemperature temperatureSensor;
     HX711_ADC loadCell;    BIAApplication biaApp;  // Add BIA Application
     BloodPressureMonitor bpMonitor;  // Add blood pressure monitor
     BodyCompositionAnalyzer bodyCompositionAnalyzer;  // Add body composition analyzer
     
-    // Data buffers
-    uint32_t irBuffer[100];
-    uint32_t redBuffer[100];
-    
-    // Glucose monitoring buffers
-    float glucoseIrReadings[GLUCOSE_WINDOW_SIZE];
-    float glucoseRedReadings[GLUCOSE_WINDOW_SIZE];
-    int glucoseReadIndex = 0;
-    uint32_t glucoseMaxIR = 0;
-    uint32_t glucoseMinIR = UINT32_MAX;
-    uint32_t glucoseMaxRed = 0;
-    uint32_t glucoseMinRed = UINT32_MAX;
+    // MAX30102 FIFO streaming (INT-driven acquisition task -> ring buffer)
+    MAX30102WireBus ppgBus;
+    PPGAcquisition ppgAcquisition;
+    TaskHandle_t ppgTaskHandle = NULL;
+    bool ppgStreaming = false;
+    PPGSample latestPPG = {0, 0, 0};
+    uint64_t ppgWindowIrSum = 0;     // IR accumulated since the last HR/SpO2 read (finger check)
+    uint32_t ppgWindowCount = 0;
+    SpectralHeartRate spectralHeartRate;   // HR and SpO2 from the same stream
+    RollingPPGWindow spo2Window;           // 4 s at 25 Hz for spo2_algorithm, every second
+    int32_t maximSpO2 = 0;
+    bool maximSpO2Valid = false;
+    HeartRateFusion heartRateFusion = HeartRateFusion(HR_FUSION_MAX_AGE_MS);
+    
+    // One PPG stream shared by HR/SpO2, glucose and BP/PTT (no mode time-slicing)
+    PPGFanout ppgFanout;
+    int ppgHeartRateConsumer = -1;
+    int ppgGlucoseConsumer = -1;
+    int ppgBloodPressureConsumer = -1;
+    int ppgQualityConsumer = -1;
+    PPGAcquisitionConfig pendingPPGConfig;          // Applied by the acquisition task
+    std::atomic<bool> ppgReconfigurePending{false};
+    
+    // AD8232 continuous sampling (timer-driven sampling task -> block ring buffer)
+    AD8232FrontEnd ecgFrontEnd;
+    ECGAcquisition ecgAcquisition;
+    TaskHandle_t ecgTaskHandle = NULL;
+    hw_timer_t* ecgTimer = NULL;
+    bool ecgStreaming = false;
+    
+    // ECG chain shared by the stream, testAD8232ECG() and runECGMonitor(): a
+    // moving average of the raw counts on a branch for display, then the
+    // 0.5-40 Hz band-pass (also what the BP monitor stores) and Pan-Tompkins
+    static const int ECG_FILTER_SIZE = 10;
+    enum ECGTap { ECG_TAP_RAW, ECG_TAP_AVERAGED, ECG_TAP_FILTERED };
+    typedef Pipeline<TapStage<ECG_TAP_RAW>,
+                     BranchStage<ECG_STREAM_BLOCK_SIZE, MovingAverageStage<ECG_FILTER_SIZE>, TapStage<ECG_TAP_AVERAGED> >,
+                     BandpassStage<ECGBandpass<ECG_STREAM_SAMPLE_RATE>, 3>,    // 12-bit counts into Q15
+                     TapStage<ECG_TAP_FILTERED>,
+                     QrsStage<ECG_STREAM_SAMPLE_RATE> > ECGPipeline;
+    ECGPipeline ecgPipeline;
+    bool ecgPipelineFed = false;        // Samples went in since the last reset
+    QrsDetector& ecgQrs() { return ecgPipeline.stage<4>().detector(); }
+    
+    // Where the stream's ECG results go
+    struct ECGStreamEvents {
+        SensorManager& self;
+        void on(const TappedBlock<ECG_TAP_RAW>& tap);
+        void on(const TappedBlock<ECG_TAP_AVERAGED>& tap);
+        void on(const TappedBlock<ECG_TAP_FILTERED>& tap);
+        void on(const QrsEvent& beat);
+    };
+    // The interactive ECG views: moving average per lead-on frame, and beats
+    struct ECGDisplayEvents {
+        float averaged[ECGAcquisition::MAX_BLOCK_SIZE];
+        size_t averagedCount;
+        int peakCount;
+        bool peakDetected;
+        uint64_t firstBeatUs;
+        uint64_t lastBeatUs;
+        void on(const TappedBlock<ECG_TAP_RAW>&) {}
+        void on(const TappedBlock<ECG_TAP_AVERAGED>& tap);
+        void on(const TappedBlock<ECG_TAP_FILTERED>&) {}
+        void on(const QrsEvent& beat);
+    };
+    int64_t ecgWindowFilteredSum = 0;   // Frames accumulated since the last readECG()
+    int64_t ecgWindowBPMSum = 0;
+    uint32_t ecgWindowCount = 0;
+    int ecgWindowPeaks = 0;
+    bool ecgWindowLeadOff = false;
+    
+    // Signal quality over SQI_WINDOW_SECONDS windows: the ECG from the chain
+    // above, the PPG (IR, systole up) from its own band-pass and pulse
+    // fiducials so it is assessed whether or not the BP monitor runs.
+    // Estimators skip what a low window would give them.
+    SignalQualityEngine ecgQuality = SignalQualityEngine(ECG_STREAM_QUALITY_CONFIG);
+    SignalQualityEngine ppgQuality = SignalQualityEngine(PPG_STREAM_QUALITY_CONFIG);
+    enum PPGQualityTap { PPG_TAP_FILTERED };
+    Pipeline<BandpassStage<PPGBandpass<PPG_STREAM_SAMPLE_RATE>, -4>,    // 18-bit counts into Q15
+             TapStage<PPG_TAP_FILTERED>,
+             PulseFiducialStage> ppgQualityPipeline;
+    struct PPGQualityEvents {
+        SensorManager& self;
+        void on(const TappedBlock<PPG_TAP_FILTERED>& tap);
+        void on(const PulseFiducials& beat);
+    };
+    void shareSignalQuality();
+    
+    static SensorManager* streamInstance;  // Target for the PPG/ECG interrupt handlers
+    
+    // DS18B20 async conversions (ROM addresses cached at init)
+    DallasTemperatureBus temperatureBus;
+    DS18B20Pipeline temperaturePipeline;
+    
+    // Cooperative scheduler - latest completed result of every sensor job
+    SensorScheduler scheduler;
+    SemaphoreHandle_t schedulerMutex = NULL;
+    bool schedulerStarted = false;
+    SensorReadings latestReadings;
+    uint32_t temperatureConversionsAtRelease = 0;
+    static const int BIA_SWEEP_POINTS = 5;
+    BIAResult biaSweepResults[BIA_SWEEP_POINTS];
+    unsigned int biaSweepCount = 0;
+    bool biaSweepStarted = false;       // Sequenced on the AD5940, waiting for INT
+    unsigned long biaSweepStartMs = 0;
+    
+    // Glucose monitoring windows: mean of the newest GLUCOSE_WINDOW_SIZE readings
+    SlidingWindowStats<float, GLUCOSE_WINDOW_SIZE> glucoseIrReadings;
+    SlidingWindowStats<float, GLUCOSE_WINDOW_SIZE> glucoseRedReadings;
     uint32_t glucoseLastReading = 0;
+    uint64_t glucoseWindowIrSum = 0;     // Stream samples since the last glucose read
+    uint64_t glucoseWindowRedSum = 0;
+    uint32_t glucoseWindowCount = 0;
       // Calibration values
     float weightOffset = WEIGHT_OFFSET;
     float weightCalibrationFactor = LOAD_CELL_CALIBRATION_FACTOR;
@@ -115,18 +169,7 @@ private:    // Sensor objects
     bool glucoseInitialized = false;
     bool bpMonitorInitialized = false;  // Add BP monitor state
     
-    // MAX30102 Mode Management (Single Sensor)
-    MAX30102_Mode currentMAX30102Mode = MODE_HEART_RATE_SPO2;
-    unsigned long modeStartTime = 0;
-    unsigned long lastModeCycle = 0;
-    bool autoModeCycling = ENABLE_AUTO_MODE_CYCLING;
-    
     // ECG specific variables
-    static const int ECG_FILTER_SIZE = 10;
-    int ecgBuffer[ECG_FILTER_SIZE];
-    int ecgBufferIndex = 0;
-    unsigned long lastPeakTime = 0;
-    int ecgThreshold = 1500;
     int currentBPM = 0;
     
     // Helper methods
@@ -137,6 +180,29 @@ private:    // Sensor objects
     bool initializeECGSensor();
     bool initializeGlucoseSensor();
     bool initializeBloodPressureMonitor();  // Add BP monitor initialization
+    bool startPPGStreaming();
+    static void ppgAcquisitionTask(void* parameter);
+    static void onPPGInterrupt();
+    void registerPPGConsumers();
+    static void heartRatePPGConsumer(void* context, const PPGSample* samples, size_t count);
+    void updateMaximSpO2();
+    void resetPPGHeartRate();
+    static void glucosePPGConsumer(void* context, const PPGSample* samples, size_t count);
+    static void bloodPressurePPGConsumer(void* context, const PPGSample* samples, size_t count);
+    static void qualityPPGConsumer(void* context, const PPGSample* samples, size_t count);
+    bool startECGStreaming();
+    static void ecgSamplingTask(void* parameter);
+    static void onECGTimer();
+    
+    // Scheduler jobs (one non-blocking step per call)
+    static SensorStepResult heartRateJob(void* context, uint32_t nowMs, uint32_t step);
+    static SensorStepResult temperatureJob(void* context, uint32_t nowMs, uint32_t step);
+    static SensorStepResult weightJob(void* context, uint32_t nowMs, uint32_t step);
+    static SensorStepResult ecgJob(void* context, uint32_t nowMs, uint32_t step);
+    static SensorStepResult glucoseJob(void* context, uint32_t nowMs, uint32_t step);
+    static SensorStepResult bloodPressureJob(void* context, uint32_t nowMs, uint32_t step);
+    static SensorStepResult bioimpedanceJob(void* context, uint32_t nowMs, uint32_t step);
+    BodyComposition analyzeBIASweep(BIAResult* results, unsigned int resultCount, float currentWeight);
     
     HeartRateData readHeartRateAndSpO2();
     TemperatureData readTemperature();
@@ -152,8 +218,13 @@ private:    // Sensor objects
     bool validateECGReading(float avgBPM, float avgFiltered);
     bool validateGlucoseReading(float glucose, float signalQuality);
     bool validateBloodPressureReading(float systolic, float diastolic);  // Add blood pressure validation
+    
+    // Runs the lead-on stretches of a block of frames through ecgPipeline;
+    // returns true if any frame had a lead off
+    template <typename Events>
+    bool processECGFrames(const ECGFrame* frames, size_t count, Events& events);
+    
       // Glucose helper methods
-    float calculateGlucoseMovingAverage(float* readings, float newValue);
     float calculateGlucoseLevel(float ir, float red);
 
 public:
@@ -173,8 +244,24 @@ public:
     void setTemperatureOffset(float offset);  // Add temperature calibration method
     float getTemperatureOffset();  // Get current temperature offset
     
+    // Streaming - drains acquired samples into HR/SpO2, glucose and BP consumers
+    void processPPGStream();
+    PPGAcquisitionStats getPPGStats();
+    void printPPGStreamStats();
+    void processECGStream();
+    ECGAcquisitionStats getECGStats();
+    void updateTemperature();   // Advances the DS18B20 conversion state machine
+    uint8_t getTemperatureSensorCount();
+    TemperatureData getTemperatureByIndex(uint8_t index);
+    
+    // Scheduler - call runScheduler() every SENSOR_SCHEDULER_TICK_MS
+    bool startScheduler();
+    void runScheduler();
+    SensorReadings getLatestReadings();
+    void printSchedulerStats();
+    
     // Reading methods
-    SensorReadings readAllSensors();
+    SensorReadings readAllSensors();  // Latest snapshot assembled by the scheduler
     HeartRateData readHeartRate();
     TemperatureData getTemperature();
     WeightData getWeight();
@@ -201,16 +288,6 @@ public:
     String getSensorStatus();
     void printSensorReadings(const SensorReadings& readings);
     
-    // MAX30102 Staged Testing Methods (Single Sensor)
-    bool setMAX30102Mode(MAX30102_Mode mode);
-    MAX30102_Mode getCurrentMAX30102Mode();
-    bool switchToHeartRateMode();
-    bool switchToGlucoseMode();
-    bool switchToBloodPressureMode();
-    bool switchToCalibrationMode();
-    void cycleMAX30102Modes();  // Auto-cycle through modes
-    String getMAX30102ModeString();
-    
     // DS18B20 specific test and debug methods
     void testDS18B20();  // Standalone DS18B20 test function
     
@@ -221,6 +298,5 @@ public:
 
 // Global utility function
 void displaySensorReadings(const SensorReadings& readings);
-String getModeString(MAX30102_Mode mode);  // Helper function for mode strings
 
 #endif // SENSORS_H
@@ -0,0 +1,37 @@
+#ifndef SENSORS_AD8232_FRONT_END_H
+#define SENSORS_AD8232_FRONT_END_H
+
+#include <Arduino.h>
+#include <driver/adc.h>
+#include "sensors/ecg_acquisition.h"
+#include "config.h"
+
+// ECGFrontEnd backed by ADC1 and the AD8232 lead-off comparator outputs
+class AD8232FrontEnd : public ECGFrontEnd {
+public:
+    void begin() {
+        pinMode(LO_PLUS_PIN, INPUT);
+        pinMode(LO_MINUS_PIN, INPUT);
+        pinMode(ECG_PIN, INPUT);
+        // Raw ADC1 reads, same 12-bit / 11 dB setup analogRead uses
+        adc1_config_width(ADC_WIDTH_BIT_12);
+        adc1_config_channel_atten(channel, ADC_ATTEN_DB_11);
+    }
+
+    uint16_t readSample() override {
+        int value = adc1_get_raw(channel);
+        return value < 0 ? 0 : (uint16_t)value;
+    }
+
+    uint8_t readLeadOff() override {
+        uint8_t flags = ECGLeadOff::NONE;
+        if (digitalRead(LO_PLUS_PIN) == HIGH) flags |= ECGLeadOff::PLUS;
+        if (digitalRead(LO_MINUS_PIN) == HIGH) flags |= ECGLeadOff::MINUS;
+        return flags;
+    }
+
+private:
+    static const adc1_channel_t channel = ADC1_CHANNEL_0;  // GPIO36 (ECG_PIN)
+};
+
+#endif // SENSORS_AD8232_FRONT_END_H
@@ -0,0 +1,36 @@
+#ifndef SENSORS_DALLAS_TEMPERATURE_BUS_H
+#define SENSORS_DALLAS_TEMPERATURE_BUS_H
+
+#include <DallasTemperature.h>
+#include "sensors/ds18b20_pipeline.h"
+
+// TemperatureBus backed by the DallasTemperature library
+class DallasTemperatureBus : public TemperatureBus {
+public:
+    explicit DallasTemperatureBus(DallasTemperature& sensors) : sensors(sensors) {}
+
+    uint8_t deviceCount() override { return sensors.getDeviceCount(); }
+
+    bool getAddress(uint8_t index, uint8_t* address) override {
+        return sensors.getAddress(address, index);
+    }
+
+    bool setResolution(const uint8_t* address, uint8_t bits) override {
+        return sensors.setResolution(address, bits);
+    }
+
+    void requestConversion() override {
+        sensors.setWaitForConversion(false);
+        sensors.requestTemperatures();
+    }
+
+    float readCelsius(const uint8_t* address) override {
+        // Reads the scratchpad of one known ROM; no bus search
+        return sensors.getTempC(address);
+    }
+
+private:
+    DallasTemperature& sensors;
+};
+
+#endif // SENSORS_DALLAS_TEMPERATURE_BUS_H
@@ -0,0 +1,74 @@
+#ifndef SENSORS_DS18B20_PIPELINE_H
+#define SENSORS_DS18B20_PIPELINE_H
+
+#include <stdint.h>
+
+// Non-blocking DS18B20 conversion pipeline
+// update() starts a bus-wide conversion and returns immediately; on a later
+// call, once the conversion time for the configured resolution has passed,
+// every sensor is read by its cached ROM address and the results published.
+// Nothing here waits on the bus, so it can run from a 1 s sensor tick.
+
+// OneWire temperature bus (DallasTemperature on target, mock on host)
+class TemperatureBus {
+public:
+    static constexpr float DISCONNECTED_C = -127.0f;
+
+    virtual ~TemperatureBus() {}
+    virtual uint8_t deviceCount() = 0;
+    virtual bool getAddress(uint8_t index, uint8_t* address) = 0;
+    virtual bool setResolution(const uint8_t* address, uint8_t bits) = 0;
+    virtual void requestConversion() = 0;    // Must not wait for completion
+    virtual float readCelsius(const uint8_t* address) = 0;
+};
+
+struct TemperatureChannel {
+    uint8_t address[8];
+    float celsius;
+    bool valid;
+    uint32_t timestampMs;   // When the conversion that produced celsius started
+};
+
+struct DS18B20PipelineStats {
+    uint32_t conversions;
+    uint32_t readErrors;
+};
+
+class DS18B20Pipeline {
+public:
+    static const uint8_t MAX_SENSORS = 4;
+
+    explicit DS18B20Pipeline(TemperatureBus& bus);
+
+    // Enumerates the bus once and caches ROM addresses. Returns the sensor count.
+    uint8_t begin(uint8_t resolutionBits, uint32_t intervalMs);
+
+    // Advances the state machine. Returns true when new values were published.
+    bool update(uint32_t nowMs);
+
+    bool isConverting() const { return state == CONVERTING; }
+    bool hasReading() const { return published; }
+    uint8_t sensorCount() const { return count; }
+    const TemperatureChannel& channel(uint8_t index) const { return channels[index < count ? index : 0]; }
+
+    uint8_t resolutionBits() const { return resolution; }
+    // Datasheet max conversion time: 93.75 ms at 9 bits, doubling per extra bit
+    uint32_t conversionTimeMs() const { return 750UL >> (12 - resolution); }
+    DS18B20PipelineStats getStats() const { return stats; }
+
+private:
+    enum State { IDLE, CONVERTING };
+
+    TemperatureBus& bus;
+    TemperatureChannel channels[MAX_SENSORS];
+    uint8_t count;
+    uint8_t resolution;
+    uint32_t intervalMs;
+    State state;
+    uint32_t conversionStartMs;
+    bool started;
+    bool published;
+    DS18B20PipelineStats stats;
+};
+
+#endif // SENSORS_DS18B20_PIPELINE_H
@@ -0,0 +1,94 @@
+#ifndef SENSORS_ECG_ACQUISITION_H
+#define SENSORS_ECG_ACQUISITION_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+#include "sensors/spsc_ring.h"
+
+// AD8232 streaming acquisition engine
+// A hardware timer ticks at the sample rate; every tick one ECG sample and
+// the LO+/LO- lead-off state are captured together into a frame. Frames are
+// stamped from the tick index (not from when the task happened to run) and
+// handed to consumers in fixed-size blocks.
+
+namespace ECGLeadOff {
+    const uint8_t NONE  = 0x00;
+    const uint8_t PLUS  = 0x01;   // LO+ high
+    const uint8_t MINUS = 0x02;   // LO- high
+}
+
+struct ECGFrame {
+    uint16_t raw;           // 12-bit ADC value (0 while leads are off)
+    uint8_t leadOff;        // ECGLeadOff flags sampled in the same tick
+    uint64_t timestampUs;   // Tick time on the sample grid (esp_timer clock)
+};
+
+// Analog front end (ADC + lead-off comparators on target, mock on host)
+class ECGFrontEnd {
+public:
+    virtual ~ECGFrontEnd() {}
+    virtual uint16_t readSample() = 0;
+    virtual uint8_t readLeadOff() = 0;
+};
+
+// Lock-free ring between the sampling task and the sensor task
+typedef SpscRing<ECGFrame, 1024> ECGFrameRing;
+
+struct ECGAcquisitionConfig {
+    uint16_t sampleRateHz = 250;    // 250..500 Hz
+    uint16_t blockSize = 25;        // Frames per delivered block (100 ms at 250 Hz)
+};
+
+struct ECGAcquisitionStats {
+    uint32_t framesAcquired;
+    uint32_t missedTicks;           // Timer ticks the sampling task could not serve
+    uint32_t ringDrops;             // Frames lost because consumers fell behind
+    uint32_t leadOffFrames;
+    uint32_t blocksDelivered;
+};
+
+class ECGAcquisition {
+public:
+    static const uint16_t MIN_RATE_HZ = 250;
+    static const uint16_t MAX_RATE_HZ = 500;
+    static const uint16_t MAX_BLOCK_SIZE = 128;
+
+    explicit ECGAcquisition(ECGFrontEnd& frontEnd);
+
+    // Clamps the configuration and anchors the sample grid at startUs
+    // (64-bit esp_timer microseconds)
+    bool begin(const ECGAcquisitionConfig& config, uint64_t startUs);
+
+    // ISR-safe: records that the sample timer fired
+    void onTimerTick() { pendingTicks.fetch_add(1, std::memory_order_acq_rel); }
+    uint32_t pendingTickCount() const { return pendingTicks.load(std::memory_order_acquire); }
+
+    // Captures one frame for the newest pending tick. Ticks that piled up in
+    // between are counted as missed; the grid is kept so timestamps stay exact.
+    uint16_t service();
+
+    // Non-blocking consumer side: a block is only returned once it is complete
+    size_t readBlock(ECGFrame* out);
+    size_t read(ECGFrame* out, size_t maxCount) { return ring.pop(out, maxCount); }
+    size_t available() const { return ring.available(); }
+
+    uint32_t samplePeriodUs() const { return periodUs; }
+    uint16_t sampleRateHz() const { return config.sampleRateHz; }
+    uint16_t blockSize() const { return config.blockSize; }
+    ECGAcquisitionStats getStats() const;
+    void resetStats();
+
+private:
+    ECGFrontEnd& frontEnd;
+    ECGAcquisitionConfig config;
+    ECGFrameRing ring;
+    std::atomic<uint32_t> pendingTicks;
+
+    uint32_t periodUs;
+    uint64_t startUs;
+    uint32_t tickIndex;
+    ECGAcquisitionStats stats;
+};
+
+#endif // SENSORS_ECG_ACQUISITION_H
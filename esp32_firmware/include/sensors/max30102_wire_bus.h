@@ -0,0 +1,24 @@
+#ifndef SENSORS_MAX30102_WIRE_BUS_H
+#define SENSORS_MAX30102_WIRE_BUS_H
+
+#include <Arduino.h>
+#include <Wire.h>
+#include "sensors/ppg_acquisition.h"
+
+// PPGBus backed by the Arduino TwoWire driver
+class MAX30102WireBus : public PPGBus {
+public:
+    static const uint8_t I2C_ADDRESS = 0x57;
+
+    explicit MAX30102WireBus(TwoWire& wire = Wire) : wire(wire) {}
+
+    bool readRegister(uint8_t reg, uint8_t& value) override;
+    bool writeRegister(uint8_t reg, uint8_t value) override;
+    bool readBurst(uint8_t reg, uint8_t* buffer, size_t length) override;
+    size_t maxBurstLength() const override { return 120; } // ESP32 Wire buffer is 128 bytes
+
+private:
+    TwoWire& wire;
+};
+
+#endif // SENSORS_MAX30102_WIRE_BUS_H
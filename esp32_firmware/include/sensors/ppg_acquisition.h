@@ -0,0 +1,127 @@
+#ifndef SENSORS_PPG_ACQUISITION_H
+#define SENSORS_PPG_ACQUISITION_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+#include "sensors/spsc_ring.h"
+
+// MAX30102 streaming acquisition engine
+// Drains the on-chip FIFO in bursts (driven by the INT line) and pushes
+// timestamped Red/IR samples into a ring buffer that consumers read
+// without blocking. Bus access is abstracted so the engine can run
+// against a mock FIFO on a Linux host.
+
+// MAX30102 register map (subset used by the FIFO engine)
+namespace MAX30102Reg {
+    const uint8_t INT_STATUS_1 = 0x00;
+    const uint8_t INT_STATUS_2 = 0x01;
+    const uint8_t INT_ENABLE_1 = 0x02;
+    const uint8_t INT_ENABLE_2 = 0x03;
+    const uint8_t FIFO_WR_PTR  = 0x04;
+    const uint8_t OVF_COUNTER  = 0x05;
+    const uint8_t FIFO_RD_PTR  = 0x06;
+    const uint8_t FIFO_DATA    = 0x07;
+    const uint8_t FIFO_CONFIG  = 0x08;
+    const uint8_t MODE_CONFIG  = 0x09;
+    const uint8_t SPO2_CONFIG  = 0x0A;
+    const uint8_t LED1_PA      = 0x0C;  // Red
+    const uint8_t LED2_PA      = 0x0D;  // IR
+
+    const uint8_t INT_A_FULL    = 0x80;
+    const uint8_t INT_PPG_RDY   = 0x40;
+    const uint8_t MODE_SPO2     = 0x03;
+    const uint8_t MODE_RESET    = 0x40;
+
+    const uint8_t FIFO_DEPTH      = 32;
+    const uint8_t BYTES_PER_SAMPLE = 6;   // 3 bytes Red + 3 bytes IR
+    const uint32_t SAMPLE_MASK    = 0x3FFFF; // 18-bit ADC
+}
+
+struct PPGSample {
+    uint32_t red;
+    uint32_t ir;
+    uint64_t timestampUs;   // Sample time on the esp_timer clock, reconstructed from the FIFO position
+    uint32_t generation;    // Configuration the sample was taken under (see PPGAcquisition::read())
+};
+
+// Register-level bus used by the engine (Wire on target, mock on host)
+class PPGBus {
+public:
+    virtual ~PPGBus() {}
+    virtual bool readRegister(uint8_t reg, uint8_t& value) = 0;
+    virtual bool writeRegister(uint8_t reg, uint8_t value) = 0;
+    virtual bool readBurst(uint8_t reg, uint8_t* buffer, size_t length) = 0;
+    virtual size_t maxBurstLength() const { return 120; }
+};
+
+// Lock-free ring between the acquisition task and the sensor task
+typedef SpscRing<PPGSample, 1024> PPGSampleRing;
+
+struct PPGAcquisitionConfig {
+    uint16_t sampleRateHz = 200;    // 50..400 Hz in SpO2 mode with 411us pulses
+    uint8_t redAmplitude = 0x1F;
+    uint8_t irAmplitude = 0x1F;
+    uint8_t almostFullFree = 15;    // INT fires when this many FIFO slots remain free
+};
+
+struct PPGAcquisitionStats {
+    uint32_t samplesAcquired;
+    uint32_t bursts;
+    uint32_t fifoOverflowSamples;   // Samples lost inside the MAX30102 (OVF_COUNTER)
+    uint32_t ringDrops;             // Samples lost because consumers fell behind
+    uint32_t busErrors;
+    uint8_t maxBurstSamples;
+};
+
+class PPGAcquisition {
+public:
+    explicit PPGAcquisition(PPGBus& bus);
+
+    // Programs SpO2 mode, sample rate, FIFO almost-full interrupt and clears pointers
+    bool begin(const PPGAcquisitionConfig& config);
+    // Re-applies mode, rate, FIFO and interrupt settings after another driver
+    // (e.g. MAX30105::setup) reset the part. LED currents are left untouched.
+    bool restart();
+
+    // ISR-safe: only latches that the INT line fired
+    void onInterrupt() { interruptPending.store(true, std::memory_order_release); }
+    bool isInterruptPending() const { return interruptPending.load(std::memory_order_acquire); }
+
+    // Drains everything currently in the FIFO. nowUs is the 64-bit esp_timer
+    // time of the read. Returns the number of samples pushed.
+    uint16_t service(uint64_t nowUs);
+
+    // Non-blocking consumer side. Samples taken before the latest begin() or
+    // restart() are dropped here: the producer never touches the ring's tail,
+    // so a reconfigure from the acquisition task can't race a pop().
+    size_t read(PPGSample* out, size_t maxCount);
+    size_t available() const { return ring.available(); }   // Stale samples included
+
+    // Fallback wake-up when no INT edge arrives: just before the FIFO would fill
+    uint32_t pollIntervalUs() const { return periodUs * (MAX30102Reg::FIFO_DEPTH - 4); }
+
+    uint32_t samplePeriodUs() const { return periodUs; }
+    uint16_t sampleRateHz() const { return config.sampleRateHz; }
+    PPGAcquisitionStats getStats() const;
+    void resetStats();
+
+private:
+    PPGBus& bus;
+    PPGAcquisitionConfig config;
+    PPGSampleRing ring;
+    std::atomic<bool> interruptPending;
+    std::atomic<uint32_t> generation;   // Bumped by every (re)configuration
+
+    uint32_t periodUs;
+    uint64_t lastTimestampUs;
+    bool timelineValid;
+    PPGAcquisitionStats stats;
+
+    bool configureDevice(bool applyLedAmplitudes);
+    uint8_t sampleRateCode(uint16_t rateHz) const;
+    bool readFifoCount(uint8_t& count, uint8_t& overflow);
+    uint64_t firstTimestamp(uint8_t count, uint64_t nowUs);
+};
+
+#endif // SENSORS_PPG_ACQUISITION_H
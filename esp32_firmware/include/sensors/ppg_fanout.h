@@ -0,0 +1,94 @@
+#ifndef SENSORS_PPG_FANOUT_H
+#define SENSORS_PPG_FANOUT_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "sensors/ppg_acquisition.h"
+
+// Shared MAX30102 stream
+// One FIFO stream is handed to every PPG consumer (HR/SpO2, glucose
+// features, BP/PTT) at the same time instead of time-slicing the part
+// between measurement modes. The fan-out also decides when the part really
+// has to be reprogrammed: a consumer needs a faster sample rate, or the
+// shared LED currents put the DC level outside the range all consumers can
+// use. Otherwise the stream keeps running untouched.
+
+// Called with each batch in acquisition order; must not block
+typedef void (*PPGConsumerFn)(void* context, const PPGSample* samples, size_t count);
+
+struct PPGStreamProfile {
+    uint16_t sampleRateHz;
+    uint8_t redAmplitude;   // LED1_PA register value
+    uint8_t irAmplitude;    // LED2_PA register value
+};
+
+struct PPGLedRange {
+    uint32_t dcLow;             // Raise the LED current when the DC level is below this...
+    uint32_t dcHigh;            // ...and lower it above this
+    uint32_t noContactDc;       // Below this nothing is on the sensor: leave the current alone
+    uint32_t windowSamples;     // DC level is judged over this many samples
+};
+
+struct PPGConsumerStats {
+    const char* name;
+    uint16_t minSampleRateHz;
+    bool enabled;
+    uint32_t samples;
+    uint32_t batches;
+};
+
+class PPGFanout {
+public:
+    static const int MAX_CONSUMERS = 6;
+
+    PPGFanout();
+
+    // Returns the consumer id, or -1 when the table is full
+    int addConsumer(const char* name, PPGConsumerFn fn, void* context, uint16_t minSampleRateHz = 0);
+    void setEnabled(int id, bool enabled);
+
+    // Profile the stream was started with and LED auto-ranging limits
+    void begin(const PPGStreamProfile& profile, const PPGLedRange& range);
+
+    // Hands the same batch to every enabled consumer, in registration order
+    void dispatch(const PPGSample* samples, size_t count);
+
+    // True when the part has to be reprogrammed; profile then holds the new settings
+    bool reconcile(PPGStreamProfile& profile);
+
+    const PPGStreamProfile& getProfile() const { return profile; }
+    uint16_t requiredSampleRateHz() const;
+    uint32_t reconfigurationCount() const { return reconfigurations; }
+    int consumerCount() const { return count; }
+    PPGConsumerStats getStats(int id) const;
+
+private:
+    struct Consumer {
+        const char* name;
+        PPGConsumerFn fn;
+        void* context;
+        uint16_t minSampleRateHz;
+        bool enabled;
+        uint32_t samples;
+        uint32_t batches;
+    };
+
+    Consumer consumers[MAX_CONSUMERS];
+    int count;
+    PPGStreamProfile profile;
+    PPGLedRange range;
+    uint32_t reconfigurations;
+
+    // DC level of the current judging window
+    uint64_t dcIrSum;
+    uint64_t dcRedSum;
+    uint32_t dcSamples;
+    bool dcReady;
+    uint32_t dcIr;
+    uint32_t dcRed;
+
+    uint8_t rangeAmplitude(uint8_t amplitude, uint32_t dc) const;
+    void restartDcWindow();
+};
+
+#endif // SENSORS_PPG_FANOUT_H
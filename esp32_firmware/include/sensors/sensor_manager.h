@@ -4,9 +4,8 @@
 #include <Wire.h>
 #include <OneWire.h>
 #include <DallasTemperature.h>
-#include <HX711.h>
+#include <HX711_ADC.h>
 #include "MAX30105.h"
-#include "heartRate.h"
 #include "spo2_algorithm.h"
 #include "AD5940.h"
 #include "BIA_Application.h"
@@ -15,55 +14,29 @@
 #include "freertos/queue.h"
 #include "freertos/semphr.h"
 #include "config.h"
+#include "sensors.h"                     // Shared SensorReadings / *Data structures
+#include "sensors/ppg_acquisition.h"
+#include "sensors/max30102_wire_bus.h"
+#include "sensors/ds18b20_pipeline.h"
+#include "sensors/dallas_temperature_bus.h"
+#include "dsp/rolling_ppg_window.h"
+#include "dsp/sliding_window_stats.h"
 
-// Sensor data structures
-struct HeartRateData {
-    float heartRate;
-    float spO2;
-    bool validReading;
-    bool fingerDetected;
-    uint32_t timestamp;
-    uint32_t irValue;
-    uint32_t redValue;
+// Per-task counters, used to compare against the cooperative SensorManager
+struct SensorTaskMetrics {
+    uint32_t published;         // Readings pushed to the sensor's queue
+    uint32_t errors;
+    uint32_t lastLoopUs;        // Bus access + processing time of one loop
+    uint32_t maxLoopUs;
+    uint32_t maxBusWaitUs;      // Longest wait for the I2C/SPI mutex
 };
 
-struct TemperatureData {
-    float temperature;
-    bool validReading;
-    uint32_t timestamp;
-    float previousReading;
-    bool sensorConnected;
-};
-
-struct WeightData {
-    float weight;
-    bool validReading;
-    bool stable;
-    uint32_t timestamp;
-    float rawValue;
-    uint8_t stabilityCount;
-};
-
-struct BioimpedanceData {
-    float resistance;
-    float reactance;
-    float impedance;
-    float phase;
-    float frequency;
-    bool validReading;
-    uint32_t timestamp;
-    uint16_t measurementCount;
-};
-
-struct SensorReadings {
-    HeartRateData heartRate;
-    TemperatureData temperature;
-    WeightData weight;
-    BioimpedanceData bioimpedance;
-    uint32_t systemTimestamp;
-    String deviceID;
-    float batteryVoltage;
-    int wifiRSSI;
+struct AggregatorMetrics {
+    uint32_t cycles;
+    uint32_t lastPeriodUs;      // Measured time between two aggregates
+    uint32_t maxJitterUs;       // Worst |period - TASK_SAFE_AGGREGATOR_PERIOD_MS|
+    uint64_t totalJitterUs;
+    uint32_t droppedSnapshots;  // Oldest aggregate discarded because nobody consumed it
 };
 
 // Task-safe sensor manager with FreeRTOS integration
@@ -73,9 +46,15 @@ private:
     MAX30105 heartRateSensor;
     OneWire oneWire;
     DallasTemperature temperatureSensor;
-    HX711 loadCell;
+    HX711_ADC loadCell;
     BIAApplication biaApp;
     
+    // Streaming engines (same ones SensorManager uses)
+    MAX30102WireBus ppgBus;
+    PPGAcquisition ppgAcquisition;
+    DallasTemperatureBus temperatureBus;
+    DS18B20Pipeline temperaturePipeline;
+    
     // Task handles
     TaskHandle_t heartRateTaskHandle;
     TaskHandle_t temperatureTaskHandle;
@@ -93,6 +72,7 @@ private:
     // Mutexes for thread safety
     SemaphoreHandle_t i2cMutex;
     SemaphoreHandle_t spiMutex;
+    SemaphoreHandle_t loadCellMutex;    // The HX711's bit-banged DOUT/SCK pair
     SemaphoreHandle_t dataAccessMutex;
     
     // Initialization flags
@@ -107,16 +87,22 @@ private:
     float temperatureOffset;
     bool bioimpedanceCalibrated;
     
-    // Sensor buffers for SpO2 calculation
-    uint32_t irBuffer[100];
-    uint32_t redBuffer[100];
+    // Red/IR for spo2_algorithm: 25 Hz, 4 s window, a new one every second
+    RollingPPGWindow spo2Window;
+    
+    // Latest value of each sensor as merged by the aggregator
+    SensorReadings latestReadings;
+    float lastTemperature;
+    typedef SlidingWindowStats<float, 5> WeightHistory;   // Newest load-cell readings
+    WeightHistory weightHistory;
     
-    // Configuration
+    SensorTaskMetrics taskMetrics[4];
+    AggregatorMetrics aggregatorMetrics;
+    
+    // Configuration (intervals come from config.h)
     static const size_t QUEUE_SIZE = 10;
-    static const uint32_t HEART_RATE_SAMPLE_RATE = 100; // Hz
-    static const uint32_t TEMPERATURE_INTERVAL = 5000;  // ms
-    static const uint32_t WEIGHT_INTERVAL = 2000;       // ms
-    static const uint32_t BIA_INTERVAL = 15000;         // ms
+    static const size_t AGGREGATED_QUEUE_SIZE = 4;
+    static const uint32_t HEART_RATE_SAMPLE_RATE = 100; // Hz at the FIFO
     
 public:
     TaskSafeSensorManager();
@@ -139,6 +125,7 @@ public:
     
     // Calibration
     bool calibrateWeight(float knownWeight);
+    bool tareWeight();
     bool calibrateTemperature(float knownTemperature);
     bool calibrateBioimpedance(float knownResistance);
     bool performBIASweep(BIAResult* results, uint32_t maxResults, uint32_t* actualCount);
@@ -147,6 +134,10 @@ public:
     String getSensorStatus();
     String getBIAStatus();
     bool allSensorsReady();
+    bool isHeartRateReady() const { return heartRateInitialized; }
+    bool isTemperatureReady() const { return temperatureInitialized; }
+    bool isWeightReady() const { return weightInitialized; }
+    bool isBioimpedanceReady() const { return bioimpedanceInitialized; }
     void printSensorReadings(const SensorReadings& readings);
     
     // Error handling and recovery
@@ -157,6 +148,11 @@ public:
     bool enterLowPowerMode();
     bool exitLowPowerMode();
     
+    // Throughput / jitter
+    SensorTaskMetrics getTaskMetrics(uint8_t sensorType);
+    AggregatorMetrics getAggregatorMetrics();
+    void printTaskStats();
+    
 private:
     // Static task functions
     static void heartRateTask(void* parameter);
@@ -183,11 +179,13 @@ private:
                                    int8_t* validSPO2, int32_t* heartRate, 
                                    int8_t* validHeartRate);
     float filterTemperature(float newReading, float previousReading);
-    bool isWeightStable(float* readings, size_t count);
+    bool isWeightStable(const WeightHistory& history);
     
     // Mutex helpers
     bool takeMutex(SemaphoreHandle_t mutex, uint32_t timeoutMs = 100);
+    bool takeBus(SemaphoreHandle_t mutex, uint8_t sensorType, uint32_t timeoutMs = 100);
     void giveMutex(SemaphoreHandle_t mutex);
+    void recordLoop(uint8_t sensorType, uint32_t startUs);
 };
 
 // Sensor type definitions for error handling
@@ -0,0 +1,82 @@
+#ifndef SENSORS_SENSOR_SCHEDULER_H
+#define SENSORS_SENSOR_SCHEDULER_H
+
+#include <stdint.h>
+
+// Cooperative deadline scheduler for sensor state machines
+// Each sensor is a periodic job made of short non-blocking steps. A job is
+// released every periodMs and its deadline is the next release. run() steps
+// ready jobs in earliest-deadline-first order, at most once each per call,
+// and stops when the CPU budget for the call is spent. Per-sensor latency
+// (release to completion), step cost and overrun counters are kept so a
+// sensor that starves the others shows up in the stats.
+
+enum SensorStepResult {
+    SENSOR_STEP_PENDING,    // Call again on a later run()
+    SENSOR_STEP_DONE        // Job finished, result published
+};
+
+// step is 0 on the first call of a job and counts up for each later call
+typedef SensorStepResult (*SensorStepFn)(void* context, uint32_t nowMs, uint32_t step);
+typedef uint32_t (*SchedulerClockUs)();
+
+struct SensorTaskStats {
+    const char* name;
+    uint32_t periodMs;
+    uint32_t completed;         // Jobs finished
+    uint32_t overruns;          // Jobs that finished after their deadline
+    uint32_t skippedReleases;   // Whole periods lost while a job overran
+    uint32_t lastLatencyMs;     // Release to completion
+    uint32_t maxLatencyMs;
+    uint32_t steps;
+    uint32_t lastStepUs;
+    uint32_t maxStepUs;
+    uint64_t totalStepUs;
+};
+
+class SensorScheduler {
+public:
+    static const uint8_t MAX_TASKS = 10;
+
+    explicit SensorScheduler(SchedulerClockUs clockUs);
+
+    // Returns the task id, or -1 when the table is full
+    int addTask(const char* name, uint32_t periodMs, SensorStepFn fn, void* context, uint32_t offsetMs = 0);
+    void setEnabled(int id, bool enabled);
+
+    // First release of every task at nowMs + its offset
+    void start(uint32_t nowMs);
+
+    // Steps ready jobs in deadline order. Returns the number of steps executed.
+    uint8_t run(uint32_t nowMs, uint32_t budgetUs);
+
+    // Milliseconds until the next release (0 if a job is ready or active)
+    uint32_t msUntilNextRelease(uint32_t nowMs) const;
+
+    uint8_t taskCount() const { return count; }
+    const SensorTaskStats& getStats(uint8_t id) const { return tasks[id < count ? id : 0].stats; }
+    bool isActive(uint8_t id) const { return id < count && tasks[id].active; }
+    void resetStats();
+
+private:
+    struct Task {
+        SensorStepFn fn;
+        void* context;
+        uint32_t offsetMs;
+        uint32_t nextReleaseMs;
+        uint32_t jobReleaseMs;
+        uint32_t jobStep;
+        bool enabled;
+        bool active;
+        SensorTaskStats stats;
+    };
+
+    SchedulerClockUs clockUs;
+    Task tasks[MAX_TASKS];
+    uint8_t count;
+
+    bool releaseIfDue(Task& task, uint32_t nowMs);
+    void skipMissedReleases(Task& task, uint32_t nowMs);
+};
+
+#endif // SENSORS_SENSOR_SCHEDULER_H
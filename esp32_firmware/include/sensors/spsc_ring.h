@@ -0,0 +1,160 @@
+#ifndef SENSORS_SPSC_RING_H
+#define SENSORS_SPSC_RING_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+
+// Lock-free single-producer / single-consumer ring buffer
+// One context (ISR or acquisition task) pushes, one context (DSP or sensor
+// task) pops. Head and tail are free-running 32-bit counters published with
+// acquire/release ordering, so neither side ever takes a lock or disables
+// interrupts and push() is safe to call from an ISR. Capacity is fixed at
+// compile time and must be a power of two so indexing is a mask.
+//
+// Producer side: push(), pushBatch(), freeSpace()
+// Consumer side: pop(), peek(), peekLatest(), at(), discard(), clear(), slide()
+// Either side:   available(), droppedCount()
+
+// Smallest power of two >= n, for sizing a ring from an arbitrary window length
+constexpr uint32_t spscRingCapacityFor(uint32_t n, uint32_t capacity = 1) {
+    return capacity >= n ? capacity : spscRingCapacityFor(n, capacity << 1);
+}
+
+template <typename T, uint32_t Capacity>
+class SpscRing {
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "SpscRing capacity must be a power of two");
+
+public:
+    static constexpr uint32_t CAPACITY = Capacity;
+    static constexpr uint32_t MASK = Capacity - 1;
+
+    SpscRing() : head(0), tail(0), dropped(0) {}
+
+    // Producer: returns false (and counts a drop) when the ring is full
+    bool push(const T& item) {
+        uint32_t h = head.load(std::memory_order_relaxed);
+        uint32_t t = tail.load(std::memory_order_acquire);
+        if (h - t >= Capacity) {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        slots[h & MASK] = item;
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Producer: pushes as many items as fit, publishing them with one store
+    size_t pushBatch(const T* items, size_t count) {
+        uint32_t h = head.load(std::memory_order_relaxed);
+        uint32_t t = tail.load(std::memory_order_acquire);
+        size_t space = Capacity - (h - t);
+        size_t n = count < space ? count : space;
+        for (size_t i = 0; i < n; i++) {
+            slots[(h + i) & MASK] = items[i];
+        }
+        head.store(h + n, std::memory_order_release);
+        if (n < count) {
+            dropped.fetch_add(count - n, std::memory_order_relaxed);
+        }
+        return n;
+    }
+
+    // Consumer: copies out up to maxCount items, oldest first
+    size_t pop(T* out, size_t maxCount) {
+        uint32_t t = tail.load(std::memory_order_relaxed);
+        uint32_t h = head.load(std::memory_order_acquire);
+        size_t count = h - t;
+        if (count > maxCount) count = maxCount;
+        copyOut(t, out, count);
+        tail.store(t + count, std::memory_order_release);
+        return count;
+    }
+
+    bool pop(T& out) {
+        return pop(&out, 1) == 1;
+    }
+
+    // Consumer: copies `count` items starting `offset` items after the oldest,
+    // without consuming them. Returns the number copied.
+    size_t peek(T* out, size_t count, size_t offset = 0) const {
+        uint32_t t = tail.load(std::memory_order_relaxed);
+        uint32_t h = head.load(std::memory_order_acquire);
+        size_t queued = h - t;
+        if (offset >= queued) return 0;
+        if (count > queued - offset) count = queued - offset;
+        copyOut(t + offset, out, count);
+        return count;
+    }
+
+    // Consumer: copies the newest `count` items (oldest of them first)
+    size_t peekLatest(T* out, size_t count) const {
+        size_t queued = available();
+        if (count > queued) count = queued;
+        return peek(out, count, queued - count);
+    }
+
+    // Consumer: i-th oldest unconsumed item (i < available())
+    const T& at(size_t i) const {
+        return slots[(tail.load(std::memory_order_relaxed) + i) & MASK];
+    }
+
+    // Consumer: drops up to count of the oldest items
+    size_t discard(size_t count) {
+        uint32_t t = tail.load(std::memory_order_relaxed);
+        uint32_t h = head.load(std::memory_order_acquire);
+        if (count > h - t) count = h - t;
+        tail.store(t + count, std::memory_order_release);
+        return count;
+    }
+
+    // Sliding window for a context that is both producer and consumer:
+    // keeps only the newest `window` items, evicting the oldest first.
+    // Returns true and stores the evicted item when one was pushed out.
+    bool slide(const T& item, size_t window, T* evicted = nullptr) {
+        bool evictedOne = false;
+        if (window > Capacity) window = Capacity;
+        if (window > 0 && available() >= window) {
+            if (evicted) *evicted = at(0);
+            discard(1);
+            evictedOne = true;
+        }
+        push(item);
+        return evictedOne;
+    }
+
+    size_t available() const {
+        return head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire);
+    }
+
+    size_t freeSpace() const {
+        return Capacity - available();
+    }
+
+    bool empty() const { return available() == 0; }
+    bool full() const { return available() >= Capacity; }
+
+    uint32_t droppedCount() const { return dropped.load(std::memory_order_relaxed); }
+
+    // Consumer: drops everything queued
+    void clear() {
+        tail.store(head.load(std::memory_order_acquire), std::memory_order_release);
+    }
+
+private:
+    T slots[Capacity];
+    std::atomic<uint32_t> head;
+    std::atomic<uint32_t> tail;
+    std::atomic<uint32_t> dropped;
+
+    // Copies in at most two contiguous runs (before and after the wrap)
+    void copyOut(uint32_t from, T* out, size_t count) const {
+        size_t start = from & MASK;
+        size_t first = Capacity - start;
+        if (first > count) first = count;
+        for (size_t i = 0; i < first; i++) out[i] = slots[start + i];
+        for (size_t i = first; i < count; i++) out[i] = slots[i - first];
+    }
+};
+
+#endif // SENSORS_SPSC_RING_H
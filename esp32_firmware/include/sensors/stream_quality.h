@@ -0,0 +1,17 @@
+#ifndef SENSORS_STREAM_QUALITY_H
+#define SENSORS_STREAM_QUALITY_H
+
+#include "dsp/signal_quality.h"
+#include "config.h"
+
+// SQI of the live ECG and PPG streams, shared by SensorManager and the host
+// replay. Beat templates of 64 samples: around the QRS (80 ms before the
+// R-peak), and across the pulse upstroke (120 ms before its steepest point)
+const SignalQualityConfig ECG_STREAM_QUALITY_CONFIG = {
+    SignalKind::ECG, ECG_STREAM_SAMPLE_RATE, SQI_WINDOW_SECONDS * ECG_STREAM_SAMPLE_RATE, 0, 4095, 64, 20
+};
+const SignalQualityConfig PPG_STREAM_QUALITY_CONFIG = {
+    SignalKind::PPG, PPG_STREAM_SAMPLE_RATE, SQI_WINDOW_SECONDS * PPG_STREAM_SAMPLE_RATE, 0, 262143, 64, 24
+};
+
+#endif // SENSORS_STREAM_QUALITY_H
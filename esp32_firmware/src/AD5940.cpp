@@ -2,11 +2,27 @@
 
 AD5940Class AD5940;
 
+// Writes the datasheet requires after every reset, before anything else
+static const struct {
+    uint16_t addr;
+    uint32_t data;
+} AD5940_INIT_TABLE[] = {
+    {0x0908, 0x02C9}, {0x0C08, 0x206C}, {0x21F0, 0x0010}, {0x0410, 0x02C9},
+    {0x0A28, 0x0009}, {0x238C, 0x0104}, {0x0A04, 0x4859}, {0x0A04, 0xF27B},
+    {0x0A00, 0x8009}, {0x22F0, 0x0000}, {0x2230, 0xDE87A5AF}, {0x2250, 0x103F},
+    {0x22B0, 0x203C}, {0x2230, 0xDE87A5A0},
+};
+
 AD5940Class::AD5940Class() {
     _csPin = -1;
     _resetPin = -1;
     _intPin = -1;
     _initialized = false;
+    _sweepPoints = 0;
+    _sweepDone = false;
+#ifdef ARDUINO
+    _sweepWaiter = NULL;
+#endif
 }
 
 bool AD5940Class::begin(int csPin, int resetPin, int intPin) {
@@ -25,21 +41,23 @@ bool AD5940Class::begin(int csPin, int resetPin, int intPin) {
     
     if (_intPin >= 0) {
         pinMode(_intPin, INPUT);
+#ifdef ARDUINO
+        // GP0 is set up as INT0 by configureSequencer(), active low
+        attachInterrupt(digitalPinToInterrupt(_intPin), onInterrupt, FALLING);
+#endif
     }
     
     // Initialize SPI (should be done in main setup)
-    SPI.beginTransaction(SPISettings(1000000, MSBFIRST, SPI_MODE0));
+    hal::spi().beginTransaction(1000000, 0);    // Mode 0
     
     // Reset and check ID
     if (!reset()) {
         return false;
     }
     
-    delay(100);
-    
     uint32_t id = readID();
-    if (id != 0x5502) { // Expected AD5940 ID
-        Serial.printf("AD5940 ID mismatch: 0x%04X (expected 0x5502)\n", id);
+    if (id != AD5940_CHIPID) {
+        Serial.printf("AD5940 ID mismatch: 0x%04X (expected 0x%04X)\n", id, AD5940_CHIPID);
         return false;
     }
     
@@ -57,20 +75,18 @@ bool AD5940Class::reset() {
     }
     
     // Software reset via SPI
-    selectChip();
-    spiTransfer(AD5940_SPICMD_RESET);
-    deselectChip();
+    writeWord(AD5940_REG_SWRSTCON, AD5940_SWRST_KEY);
     delay(100);
     
+    for (size_t i = 0; i < sizeof(AD5940_INIT_TABLE) / sizeof(AD5940_INIT_TABLE[0]); i++) {
+        writeWord(AD5940_INIT_TABLE[i].addr, AD5940_INIT_TABLE[i].data);
+    }
+    _sweepPoints = 0;
     return true;
 }
 
 uint32_t AD5940Class::readID() {
-    selectChip();
-    spiTransfer(AD5940_SPICMD_GETID);
-    uint32_t id = spiRead32();
-    deselectChip();
-    return id & 0xFFFF;
+    return readRegister(AD5940_REG_CHIPID) & 0xFFFF;
 }
 
 bool AD5940Class::initializeBIA() {
@@ -107,144 +123,307 @@ bool AD5940Class::initializeBIA() {
 }
 
 bool AD5940Class::configureClock() {
-    // Configure system clock to 16MHz
-    if (!writeRegister(0x0C, 0x00000001)) return false; // Enable 16MHz oscillator
-    delay(10);
-    
-    // Select 16MHz as system clock
-    if (!writeRegister(0x0D, 0x00000000)) return false;
-    
-    return true;
+    // System and ADC clocks from the 16 MHz internal oscillator
+    return writeRegister(AD5940_REG_CLKSEL, 0);
 }
 
 bool AD5940Class::configureAFE() {
-    // Configure excitation amplifier
-    if (!writeRegister(0x1068, 0x00000027)) return false; // EXCITAMPGAIN
-    
-    // Configure current source
-    if (!writeRegister(0x1074, 0x00000003)) return false; // EXCITDACGAIN
-    
-    // Configure ADC
-    if (!writeRegister(0x1020, 0x00008009)) return false; // ADCCON
-    if (!writeRegister(0x1024, 0x00000003)) return false; // DFTCON
-    
-    // Configure PGA
-    if (!writeRegister(0x1078, 0x00000000)) return false; // PGACON
-    if (!writeRegister(0x107C, 0x00000005)) return false; // PGAGAIN
+    // Low-power mode covers the sweep up to 200 kHz
+    if (!writeRegister(AD5940_REG_PMBW, AD5940_PMBW_LP_250KHZ)) return false;
+    
+    // Sine excitation through the high-speed DAC
+    if (!writeRegister(AD5940_REG_HSDACCON, AD5940_HSDACCON_RATE_16MHZ)) return false;
+    if (!writeRegister(AD5940_REG_WGCON, AD5940_WGCON_SINE)) return false;
+    if (!writeRegister(AD5940_REG_WGAMPLITUDE, AD5940_WG_AMPLITUDE)) return false;
+    if (!writeRegister(AD5940_REG_WGOFFSET, 0)) return false;
+    if (!writeRegister(AD5940_REG_WGPHASE, 0)) return false;
+    
+    // Electrodes and the current return path
+    if (!writeRegister(AD5940_REG_DSWFULLCON, AD5940_SWD_CE0)) return false;
+    if (!writeRegister(AD5940_REG_PSWFULLCON, AD5940_SWP_CE0)) return false;
+    if (!writeRegister(AD5940_REG_NSWFULLCON, AD5940_SWN_AIN1)) return false;
+    if (!writeRegister(AD5940_REG_TSWFULLCON, AD5940_SWT_AIN1 | AD5940_SWT_TRTIA)) return false;
+    if (!writeRegister(AD5940_REG_SWCON, AD5940_SWCON_FULLCON)) return false;
+    if (!writeRegister(AD5940_REG_HSRTIACON, AD5940_HSRTIA_1K)) return false;
+    if (!writeRegister(AD5940_REG_HSTIACON, 0)) return false;     // 1.11 V bias
+    
+    // ADC across the sense electrodes
+    if (!writeRegister(AD5940_REG_ADCCON, AD5940_ADCCON_AIN2_AIN3)) return false;
     
     return true;
 }
 
 bool AD5940Class::configureDSP() {
-    // Configure DFT settings
-    if (!writeRegister(0x1024, 0x00000003)) return false; // DFTCON
-    if (!writeRegister(0x1028, 0x00000080)) return false; // DFTNUM
-    
-    // Configure statistics block
-    if (!writeRegister(0x1038, 0x00000001)) return false; // STATSCON
+    // 400 kSPS into the DFT; each sweep point sets its own DFT length
+    if (!writeRegister(AD5940_REG_ADCFILTERCON, AD5940_ADCFILTER_800KSPS | AD5940_ADCFILTER_SINC3_OSR2 |
+                                                AD5940_ADCFILTER_LPF_BYPASS)) return false;
+    if (!writeRegister(AD5940_REG_DFTCON, AD5940_DFTCON_HANNING | AD5940_DFTCON_SINC3)) return false;
     
     return true;
 }
 
 bool AD5940Class::configureSequencer() {
-    // Basic sequencer configuration for continuous measurement
-    if (!writeRegister(0x3000, 0x00000001)) return false; // SEQ0INFO
-    if (!writeRegister(0x3004, 0x00000000)) return false; // SEQ1INFO
+    // Command SRAM for the sweep table, the rest as the data FIFO
+    if (!writeRegister(AD5940_REG_CMDDATACON, AD5940_CMDDATACON_SEQ_FIFO)) return false;
+    if (!writeRegister(AD5940_REG_SEQCON, 0)) return false;
+    if (!writeRegister(AD5940_REG_FIFOCON, AD5940_FIFOCON_DFT)) return false;
+    
+    // End of sequence on INT0, out on GP0, active low
+    if (!writeRegister(AD5940_REG_INTCPOL, 0)) return false;
+    if (!writeRegister(AD5940_REG_INTCSEL0, AD5940_INT_ENDSEQ)) return false;
+    if (!writeRegister(AD5940_REG_GP0CON, AD5940_GP0_INT0)) return false;
+    if (!writeRegister(AD5940_REG_GP0OEN, 1)) return false;
     
     return true;
 }
 
-bool AD5940Class::startBIA() {
-    if (!_initialized) return false;
+fImpPolar AD5940Class::calculateImpedance(uint32_t realData, uint32_t imagData) {
+    fImpPolar result;
     
-    // Start the measurement sequence
-    if (!writeRegister(0x0000, 0x00000001)) return false; // Start sequencer
+    // Convert raw DFT data to voltage
+    float realVolt = (float)((int32_t)realData) / 32768.0f; // Assuming 16-bit signed
+    float imagVolt = (float)((int32_t)imagData) / 32768.0f;
     
-    Serial.println("BIA measurement started");
-    return true;
+    // Calculate magnitude and phase
+    result.Magnitude = sqrt(realVolt * realVolt + imagVolt * imagVolt);
+    result.Phase = atan2(imagVolt, realVolt) * 180.0f / PI;
+    
+    // Apply calibration factors (simplified)
+    result.Magnitude *= 1000.0f; // Convert to ohms (calibration dependent)
+    
+    return result;
 }
 
-bool AD5940Class::stopBIA() {
-    if (!_initialized) return false;
+// The sine generator's frequency word, 0 outside what its 24 bits can hold
+static uint32_t sineFrequencyWord(float frequencyHz) {
+    double word = (double)frequencyHz * (1UL << 30) / AD5940_SYSCLK_HZ + 0.5;
+    if (word < 1 || word > 0xFFFFFF) {
+        return 0;
+    }
+    return (uint32_t)word;
+}
+
+// The shortest DFT that spans AD5940_SWEEP_DFT_US and 4 periods of the sine
+static uint32_t dftNumberCode(float frequencyHz) {
+    float windowUs = max((float)AD5940_SWEEP_DFT_US, 4e6f / frequencyHz);
+    uint32_t samples = (uint32_t)(windowUs * AD5940_DFT_SAMPLE_HZ / 1e6f);
+    uint32_t code = 0;
+    while (code < AD5940_DFTNUM_MAX_CODE && (4UL << code) < samples) {
+        code++;
+    }
+    return code;
+}
+
+bool AD5940Class::loadSweep(const float* frequencies, uint32_t count) {
+    if (!_initialized || count == 0 || count > AD5940_SWEEP_MAX_POINTS) return false;
+    
+    const uint32_t clocksPerUs = AD5940_SYSCLK_HZ / 1000000;
+    const uint32_t clocksPerSample = AD5940_SYSCLK_HZ / AD5940_DFT_SAMPLE_HZ;
+    const uint32_t excite = AD5940_AFECON_DACREFEN | AD5940_AFECON_DACEN | AD5940_AFECON_EXBUFEN |
+                            AD5940_AFECON_INAMPEN | AD5940_AFECON_TIAEN | AD5940_AFECON_WAVEGENEN |
+                            AD5940_AFECON_ADCEN;
+    uint32_t sequence[AD5940_SWEEP_MAX_POINTS * 7 + 2];
+    uint32_t length = 0;
+    
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t word = sineFrequencyWord(frequencies[i]);
+        if (word == 0) {
+            Serial.printf("AD5940 sweep: %.1f Hz out of range\n", frequencies[i]);
+            return false;
+        }
+        uint32_t code = dftNumberCode(frequencies[i]);
+        uint32_t dftClocks = (4UL << code) * clocksPerSample + AD5940_SWEEP_DFT_MARGIN_US * clocksPerUs;
+        sequence[length++] = AD5940_SEQ_WR(AD5940_REG_WGFCW, word);
+        sequence[length++] = AD5940_SEQ_WR(AD5940_REG_DFTCON, AD5940_DFTCON_HANNING | AD5940_DFTCON_SINC3 |
+                                                              AD5940_DFTCON_NUM(code));
+        sequence[length++] = AD5940_SEQ_WR(AD5940_REG_AFECON, excite);
+        sequence[length++] = AD5940_SEQ_WAIT(AD5940_SWEEP_SETTLE_US * clocksPerUs);
+        sequence[length++] = AD5940_SEQ_WR(AD5940_REG_AFECON, excite | AD5940_AFECON_ADCCONVEN | AD5940_AFECON_DFTEN);
+        sequence[length++] = AD5940_SEQ_WAIT(dftClocks);
+        sequence[length++] = AD5940_SEQ_WR(AD5940_REG_AFECON, excite);  // DFT result into the FIFO
+    }
+    sequence[length++] = AD5940_SEQ_WR(AD5940_REG_AFECON, 0);           // Excitation off
+    sequence[length++] = AD5940_SEQ_WR(AD5940_REG_SEQCON, 0);           // End of sequence
     
-    // Stop the measurement sequence
-    if (!writeRegister(0x0000, 0x00000000)) return false; // Stop sequencer
+    // Commands into SRAM from address 0, then point sequence 0 at them
+    if (!writeRegister(AD5940_REG_CMDFIFOWADDR, 0)) return false;
+    for (uint32_t i = 0; i < length; i++) {
+        writeWord(AD5940_REG_CMDFIFOWRITE, sequence[i]);
+    }
+    if (!writeRegister(AD5940_REG_SEQ0INFO, length << 16)) return false;
     
-    Serial.println("BIA measurement stopped");
+    _sweepPoints = count;
+    Serial.printf("AD5940 sweep loaded: %u points, %u sequencer commands\n", (unsigned)count, (unsigned)length);
     return true;
 }
 
-bool AD5940Class::getBIAData(fFreqPoint* data, uint32_t* count) {
-    if (!_initialized || !isReady()) return false;
-    
-    // Read DFT results
-    uint32_t realData = readRegister(0x1030); // DFTREAL
-    uint32_t imagData = readRegister(0x1034); // DFTIMAG
+bool AD5940Class::startSweep() {
+    if (!_initialized || _sweepPoints == 0) return false;
     
-    if (realData == 0 && imagData == 0) {
-        *count = 0;
-        return false;
-    }
+    _sweepDone = false;
+    writeWord(AD5940_REG_INTCCLR, AD5940_INT_ENDSEQ);
     
-    // Calculate impedance from DFT results
-    data[0].FreqHz = 10000; // Current frequency (would need to track this)
-    data[0].Impedance = calculateImpedance(realData, imagData);
+    // Toggling the FIFO off flushes whatever an earlier sweep left in it
+    if (!writeRegister(AD5940_REG_FIFOCON, 0)) return false;
+    if (!writeRegister(AD5940_REG_FIFOCON, AD5940_FIFOCON_DFT)) return false;
+    if (!writeRegister(AD5940_REG_SEQCON, 1)) return false;
     
-    *count = 1;
+    writeWord(AD5940_REG_TRIGSEQ, 1);   // Run sequence 0
     return true;
 }
 
-fImpPolar AD5940Class::calculateImpedance(uint32_t realData, uint32_t imagData) {
-    fImpPolar result;
-    
-    // Convert raw DFT data to voltage
-    float realVolt = (float)((int32_t)realData) / 32768.0f; // Assuming 16-bit signed
-    float imagVolt = (float)((int32_t)imagData) / 32768.0f;
+bool AD5940Class::isSweepDone() {
+    if (_intPin >= 0) {
+        return _sweepDone;
+    }
+    return (readRegister(AD5940_REG_INTCFLG0) & AD5940_INT_ENDSEQ) != 0;
+}
+
+bool AD5940Class::waitForSweep(uint32_t timeoutMs) {
+    uint32_t startTime = millis();
     
-    // Calculate magnitude and phase
-    result.Magnitude = sqrt(realVolt * realVolt + imagVolt * imagVolt);
-    result.Phase = atan2(imagVolt, realVolt) * 180.0f / PI;
+#ifdef ARDUINO
+    if (_intPin >= 0) {
+        // Registered before the flag is checked, so an edge in between still
+        // leaves a notification to take
+        _sweepWaiter = xTaskGetCurrentTaskHandle();
+        uint32_t elapsed;
+        while (!_sweepDone && (elapsed = millis() - startTime) < timeoutMs) {
+            ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(timeoutMs - elapsed) + 1);
+        }
+        _sweepWaiter = NULL;
+        return _sweepDone;
+    }
+#endif
+
+    while ((millis() - startTime) < timeoutMs) {
+        if (isSweepDone()) {
+            return true;
+        }
+        delay(1);
+    }
+    return isSweepDone();
+}
+
+bool AD5940Class::stopSweep() {
+    if (!_initialized) return false;
     
-    // Apply calibration factors (simplified)
-    result.Magnitude *= 1000.0f; // Convert to ohms (calibration dependent)
+    // Sequencer and excitation off, then whatever part of the sweep reached
+    // the FIFO flushed so the next sweep starts clean
+    bool stopped = writeRegister(AD5940_REG_SEQCON, 0);
+    writeWord(AD5940_REG_AFECON, 0);
+    writeWord(AD5940_REG_FIFOCON, 0);
+    writeWord(AD5940_REG_FIFOCON, AD5940_FIFOCON_DFT);
+    writeWord(AD5940_REG_INTCCLR, AD5940_INT_ENDSEQ);
+    _sweepDone = false;
+    return stopped;
+}
+
+// FIFO words carry the DFT result in their low 18 bits, two's complement
+static uint32_t dftResult(uint32_t word) {
+    word &= 0x3FFFF;
+    if (word & 0x20000) {
+        word |= 0xFFFC0000;
+    }
+    return word;
+}
+
+uint32_t AD5940Class::readSweepResults(uint32_t* words, uint32_t maxWords) {
+    if (!_initialized) return 0;
+    
+    uint32_t count = (readRegister(AD5940_REG_FIFOCNTSTA) >> 16) & 0x7FF;
+    count = min(count, min(maxWords, _sweepPoints * 2));
+    
+    if (count < 3) {
+        // Too short for the burst framing, which needs two trailing words
+        for (uint32_t i = 0; i < count; i++) {
+            words[i] = dftResult(readRegister(AD5940_REG_DATAFIFORD));
+        }
+    } else {
+        // Command, dummy bytes and every word under one chip select; the FIFO
+        // comes back in place of what went out
+        uint8_t burst[AD5940_FIFO_DUMMY_BYTES + AD5940_SWEEP_MAX_POINTS * 2 * 4] = {0};
+        size_t length = AD5940_FIFO_DUMMY_BYTES + count * 4;
+        memset(burst + length - 8, AD5940_FIFO_TAIL_BYTE, 8);
+        selectChip();
+        spiTransfer(AD5940_SPICMD_READFIFO);
+        hal::spi().transfer(burst, burst, length);
+        deselectChip();
+    
+        const uint8_t* data = burst + AD5940_FIFO_DUMMY_BYTES;
+        for (uint32_t i = 0; i < count; i++) {
+            words[i] = dftResult(((uint32_t)data[4 * i] << 24) | ((uint32_t)data[4 * i + 1] << 16) |
+                                 ((uint32_t)data[4 * i + 2] << 8) | data[4 * i + 3]);
+        }
+    }
     
-    return result;
+    writeWord(AD5940_REG_INTCCLR, AD5940_INT_ENDSEQ);
+    _sweepDone = false;
+    return count;
+}
+
+void IRAM_ATTR AD5940Class::onInterrupt() {
+    AD5940._sweepDone = true;
+#ifdef ARDUINO
+    TaskHandle_t waiter = AD5940._sweepWaiter;
+    if (waiter != NULL) {
+        BaseType_t higherPriorityTaskWoken = pdFALSE;
+        vTaskNotifyGiveFromISR(waiter, &higherPriorityTaskWoken);
+        if (higherPriorityTaskWoken) {
+            portYIELD_FROM_ISR();
+        }
+    }
+#endif
 }
 
 bool AD5940Class::writeRegister(uint16_t addr, uint32_t data) {
-    selectChip();
+    writeWord(addr, data);
     
-    spiTransfer(AD5940_SPICMD_SETREG);
-    spiWrite16(addr);
+    // Verify write
+    uint32_t readBack = readRegister(addr);
+    return (readBack == data);
+}
+
+static bool isWideRegister(uint16_t addr) {
+    return addr >= 0x1000 && addr <= 0x3014;
+}
+
+void AD5940Class::writeWord(uint16_t addr, uint32_t data) {
+    setAddress(addr);
+    selectChip();
     
-    // Write 32-bit data
-    spiTransfer((data >> 24) & 0xFF);
-    spiTransfer((data >> 16) & 0xFF);
+    spiTransfer(AD5940_SPICMD_WRITEREG);
+    if (isWideRegister(addr)) {
+        spiTransfer((data >> 24) & 0xFF);
+        spiTransfer((data >> 16) & 0xFF);
+    }
     spiTransfer((data >> 8) & 0xFF);
     spiTransfer(data & 0xFF);
     
     deselectChip();
-    
-    // Verify write
-    uint32_t readBack = readRegister(addr);
-    return (readBack == data);
 }
 
 uint32_t AD5940Class::readRegister(uint16_t addr) {
+    setAddress(addr);
     selectChip();
     
-    spiTransfer(AD5940_SPICMD_GETREG);
-    spiWrite16(addr);
-    
-    uint32_t data = spiRead32();
+    spiTransfer(AD5940_SPICMD_READREG);
+    spiTransfer(0x00);      // Dummy
+    uint32_t data = 0;
+    for (int i = isWideRegister(addr) ? 4 : 2; i > 0; i--) {
+        data = (data << 8) | spiTransfer(0x00);
+    }
     
     deselectChip();
     return data;
 }
 
-bool AD5940Class::isReady() {
-    uint32_t status = readRegister(0x0008); // SPIREG
-    return !(status & AD5940_SPIREG_M_READY);
+void AD5940Class::setAddress(uint16_t addr) {
+    selectChip();
+    spiTransfer(AD5940_SPICMD_SETADDR);
+    spiTransfer((addr >> 8) & 0xFF);
+    spiTransfer(addr & 0xFF);
+    deselectChip();
 }
 
 void AD5940Class::selectChip() {
@@ -258,19 +437,5 @@ void AD5940Class::deselectChip() {
 }
 
 uint8_t AD5940Class::spiTransfer(uint8_t data) {
-    return SPI.transfer(data);
-}
-
-void AD5940Class::spiWrite16(uint16_t data) {
-    spiTransfer((data >> 8) & 0xFF);
-    spiTransfer(data & 0xFF);
-}
-
-uint32_t AD5940Class::spiRead32() {
-    uint32_t data = 0;
-    data |= ((uint32_t)spiTransfer(0x00)) << 24;
-    data |= ((uint32_t)spiTransfer(0x00)) << 16;
-    data |= ((uint32_t)spiTransfer(0x00)) << 8;
-    data |= ((uint32_t)spiTransfer(0x00));
-    return data;
+    return hal::spi().transfer(data);
 }
@@ -2,10 +2,11 @@
 
 BIAApplication::BIAApplication() {
     _initialized = false;
-    _measuring = false;
     _calibrationGain = 1.0f;
     _calibrationPhase = 0.0f;
     _currentFreqIndex = 0;
+    _sweepPoints = 0;
+    _sweeping = false;
     
     // Default configuration
     _config.StartFreq = 1000.0f;
@@ -28,13 +29,14 @@ bool BIAApplication::initialize(int csPin, int resetPin, int intPin) {
         return false;
     }
     
-    // Perform self-test
+    // Perform self-test (it measures, so the application counts as up)
+    _initialized = true;
     if (!selfTest()) {
         Serial.println("BIA self-test failed");
+        _initialized = false;
         return false;
     }
     
-    _initialized = true;
     Serial.println("BIA Application initialized successfully");
     return true;
 }
@@ -61,82 +63,60 @@ bool BIAApplication::configure(const BIAConfig& config) {
 }
 
 bool BIAApplication::startMeasurement() {
-    if (!_initialized || _measuring) return false;
-    
-    if (!AD5940.startBIA()) {
-        return false;
-    }
+    // Runs the table already in the sequencer again
+    if (!_initialized || _sweeping || _sweepPoints == 0) return false;
     
-    _measuring = true;
+    _sweeping = AD5940.startSweep();
     _currentFreqIndex = 0;
-    return true;
+    return _sweeping;
 }
 
 bool BIAApplication::stopMeasurement() {
-    if (!_initialized || !_measuring) return false;
+    if (!_initialized || !_sweeping) return false;
     
-    if (!AD5940.stopBIA()) {
-        return false;
-    }
-    
-    _measuring = false;
+    cancelSweep();
     return true;
 }
 
 bool BIAApplication::isMeasuring() {
-    return _measuring;
+    return _sweeping;
 }
 
 bool BIAApplication::getResult(BIAResult& result) {
-    if (!_initialized) return false;
-    
-    fFreqPoint data;
-    uint32_t count;
-    
-    if (!AD5940.getBIAData(&data, &count) || count == 0) {
-        result.Valid = false;
-        return false;
-    }
-    
-    // Fill result structure
-    result.Frequency = data.FreqHz;
-    result.Magnitude = data.Impedance.Magnitude * _calibrationGain;
-    result.Phase = data.Impedance.Phase + _calibrationPhase;
+    // The first point of a finished sweep
+    result.Valid = false;
+    return finishSweep(&result, 1) == 1 && result.Valid;
+}
+
+void BIAApplication::processRawData(uint32_t realData, uint32_t imagData, BIAResult& result) {
+    applyCalibration(AD5940.calculateImpedance(realData, imagData), result);
+}
+
+void BIAApplication::applyCalibration(const fImpPolar& impedance, BIAResult& result) {
+    result.Magnitude = impedance.Magnitude * _calibrationGain;
+    result.Phase = impedance.Phase + _calibrationPhase;
     result.Resistance = result.Magnitude * cos(result.Phase * PI / 180.0f);
     result.Reactance = result.Magnitude * sin(result.Phase * PI / 180.0f);
     result.Timestamp = millis();
     result.Valid = true;
-    
-    return true;
 }
 
 bool BIAApplication::performSingleMeasurement(float frequency, BIAResult& result) {
-    if (!_initialized) return false;
-    
-    // Set frequency
-    if (!setFrequency(frequency)) {
-        result.Valid = false;
-        return false;
-    }
-    
-    // Start measurement
-    if (!startMeasurement()) {
-        result.Valid = false;
-        return false;
-    }
-    
-    // Wait for result
-    if (!waitForResult()) {
-        stopMeasurement();
-        result.Valid = false;
-        return false;
-    }
-    
-    // Get result
-    bool success = getResult(result);
-    stopMeasurement();
-    
-    return success;
+    uint32_t count = 0;
+    result.Valid = false;
+    return performSweep(&frequency, 1, &result, &count) && result.Valid;
+}
+
+bool BIAApplication::beginMeasurement(float frequency) {
+    return beginSweep(&frequency, 1);
+}
+
+bool BIAApplication::isResultReady() {
+    return isSweepReady();
+}
+
+bool BIAApplication::finishMeasurement(BIAResult& result) {
+    return getResult(result);
 }
 
 bool BIAApplication::performFrequencySweep(BIAResult* results, uint32_t maxResults, uint32_t* actualCount) {
@@ -147,35 +127,98 @@ bool BIAApplication::performFrequencySweep(BIAResult* results, uint32_t maxResul
     
     Serial.printf("Starting frequency sweep: %d points\n", numPoints);
     
-    for (uint32_t i = 0; i < numPoints; i++) {
-        // Calculate frequency for this point
-        float frequency;
-        if (numPoints == 1) {
-            frequency = _config.StartFreq;
-        } else {
-            float logStart = log10(_config.StartFreq);
-            float logEnd = log10(_config.EndFreq);
-            float logStep = (logEnd - logStart) / (numPoints - 1);
-            frequency = pow(10, logStart + i * logStep);
+    // One sequenced sweep per AD5940_SWEEP_MAX_POINTS points
+    float frequencies[AD5940_SWEEP_MAX_POINTS];
+    for (uint32_t first = 0; first < numPoints; first += AD5940_SWEEP_MAX_POINTS) {
+        uint32_t count = min(numPoints - first, (uint32_t)AD5940_SWEEP_MAX_POINTS);
+        for (uint32_t j = 0; j < count; j++) {
+            // Calculate frequency for this point
+            uint32_t i = first + j;
+            if (numPoints == 1) {
+                frequencies[j] = _config.StartFreq;
+            } else {
+                float logStart = log10(_config.StartFreq);
+                float logEnd = log10(_config.EndFreq);
+                float logStep = (logEnd - logStart) / (numPoints - 1);
+                frequencies[j] = pow(10, logStart + i * logStep);
+            }
         }
         
-        // Perform measurement at this frequency
-        BIAResult result;
-        if (performSingleMeasurement(frequency, result)) {
-            results[*actualCount] = result;
-            (*actualCount)++;
-            
+        uint32_t base = *actualCount;
+        uint32_t measured = 0;
+        performSweep(frequencies, count, results + base, &measured);
+        
+        // Keep the valid points, packed
+        for (uint32_t j = 0; j < measured; j++) {
+            const BIAResult& result = results[base + j];
+            if (!result.Valid) continue;
             Serial.printf("%.1f Hz: %.1f Ω, %.1f°\n", 
                          result.Frequency, result.Magnitude, result.Phase);
+            results[(*actualCount)++] = result;
         }
-        
-        delay(50); // Small delay between measurements
     }
     
     Serial.printf("Frequency sweep complete: %d valid measurements\n", *actualCount);
     return (*actualCount > 0);
 }
 
+bool BIAApplication::beginSweep(const float* frequencies, uint32_t count) {
+    if (!_initialized || _sweeping || count == 0 || count > AD5940_SWEEP_MAX_POINTS) return false;
+    
+    bool loaded = count == _sweepPoints && memcmp(frequencies, _sweepFrequencies, count * sizeof(float)) == 0;
+    if (!loaded) {
+        _sweepPoints = 0;
+        if (!AD5940.loadSweep(frequencies, count)) {
+            return false;
+        }
+        memcpy(_sweepFrequencies, frequencies, count * sizeof(float));
+        _sweepPoints = count;
+    }
+    
+    _sweeping = AD5940.startSweep();
+    return _sweeping;
+}
+
+bool BIAApplication::isSweepReady() {
+    return _sweeping && AD5940.isSweepDone();
+}
+
+uint32_t BIAApplication::finishSweep(BIAResult* results, uint32_t maxResults) {
+    if (!_sweeping) return 0;
+    _sweeping = false;
+    
+    uint32_t words[AD5940_SWEEP_MAX_POINTS * 2];
+    uint32_t count = min(AD5940.readSweepResults(words, AD5940_SWEEP_MAX_POINTS * 2) / 2, maxResults);
+    for (uint32_t i = 0; i < count; i++) {
+        processRawData(words[2 * i], words[2 * i + 1], results[i]);
+        results[i].Frequency = _sweepFrequencies[i];
+        results[i].Valid = words[2 * i] != 0 || words[2 * i + 1] != 0;
+    }
+    return count;
+}
+
+bool BIAApplication::performSweep(const float* frequencies, uint32_t count, BIAResult* results,
+                                  uint32_t* actualCount, uint32_t timeoutMs) {
+    *actualCount = 0;
+    if (!beginSweep(frequencies, count)) {
+        return false;
+    }
+    
+    if (!AD5940.waitForSweep(timeoutMs)) {
+        Serial.println("BIA sweep timed out");
+        cancelSweep();
+        return false;
+    }
+    
+    *actualCount = finishSweep(results, count);
+    return (*actualCount > 0);
+}
+
+void BIAApplication::cancelSweep() {
+    _sweeping = false;
+    AD5940.stopSweep();
+}
+
 bool BIAApplication::calibrate(float knownResistance) {
     if (!_initialized) return false;
     
@@ -217,7 +260,7 @@ String BIAApplication::getStatus() {
     
     if (!_initialized) {
         status += "Not initialized";
-    } else if (_measuring) {
+    } else if (_sweeping) {
         status += "Measuring";
     } else {
         status += "Ready";
@@ -236,7 +279,7 @@ bool BIAApplication::selfTest() {
     
     // Check AD5940 communication
     uint32_t id = AD5940.readID();
-    if (id != 0x5502) {
+    if (id != AD5940_CHIPID) {
         Serial.printf("Self-test failed: Invalid ID 0x%04X\n", id);
         return false;
     }
@@ -258,21 +301,3 @@ bool BIAApplication::selfTest() {
     return false;
 }
 
-bool BIAApplication::setFrequency(float frequency) {
-    // This would need to be implemented based on AD5940 register map
-    // For now, assume frequency is set correctly
-    return true;
-}
-
-bool BIAApplication::waitForResult(uint32_t timeoutMs) {
-    uint32_t startTime = millis();
-    
-    while ((millis() - startTime) < timeoutMs) {
-        if (AD5940.isReady()) {
-            return true;
-        }
-        delay(10);
-    }
-    
-    return false;
-}
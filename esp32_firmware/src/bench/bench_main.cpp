@@ -0,0 +1,143 @@
+#ifdef KERNEL_BENCH
+
+// Kernel microbenchmarks (see include/bench/kernel_bench.h)
+// Host:   pio run -e bench && .pio/build/bench/program [options]
+//   -o <path>          write the JSON there as well as to stdout
+//   -t <seconds>       time budget per kernel (0.25)
+//   -f <prefix>        only the kernels whose name starts with it
+//   -c <baseline.json> compare against an earlier run, exit 1 on a regression
+//   -p <percent>       slowdown allowed before it counts (10)
+//   -r <results.json>  compare that run instead of running the kernels
+// Target: pio run -e esp32dev_bench -t upload -t monitor
+//   the JSON is printed between BENCH_JSON_BEGIN and BENCH_JSON_END lines;
+//   captured copies compare on the host: program -c before.json -r after.json
+
+#include <Arduino.h>
+#include "bench/kernel_bench.h"
+#include "config.h"
+
+#ifdef ARDUINO
+
+void setup() {
+    Serial.begin(SERIAL_BAUD_RATE);
+    delay(1000);
+    Serial.println("⏱️ Kernel benchmarks starting");
+
+    KernelBench bench;
+    runDspKernels(bench);
+    for (const KernelBenchResult& result : bench.getResults()) {
+        Serial.printf("⏱️ %-20s %10.1f ns/op %10.1f cycles/sample\n", result.name.c_str(), result.nsPerOp,
+                      result.cyclesPerSample());
+    }
+    Serial.println("BENCH_JSON_BEGIN");
+    Serial.print(kernelBenchJSON(bench.getResults()).c_str());
+    Serial.println("BENCH_JSON_END");
+}
+
+void loop() {
+    delay(1000);
+}
+
+#else
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+
+static void usage() {
+    fprintf(stderr, "usage: program [-o out.json] [-t seconds] [-f prefix] [-c baseline.json [-p percent]]\n"
+                    "       program -c baseline.json -r results.json [-p percent]\n");
+}
+
+static bool readFile(const char* path, std::string& text) {
+    FILE* file = fopen(path, "rb");
+    if (!file) return false;
+    char chunk[4096];
+    size_t n;
+    while ((n = fread(chunk, 1, sizeof(chunk), file)) > 0) {
+        text.append(chunk, n);
+    }
+    fclose(file);
+    return true;
+}
+
+static bool loadResults(const char* path, std::vector<KernelBenchResult>& results) {
+    std::string json;
+    if (!readFile(path, json) || !parseKernelBenchJSON(json, results)) {
+        fprintf(stderr, "not a kernel benchmark result: %s\n", path);
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    const char* outPath = nullptr;
+    const char* baselinePath = nullptr;
+    const char* resultsPath = nullptr;
+    const char* filter = "";
+    double seconds = 0.25;
+    float tolerance = 10;
+    for (int i = 1; i < argc; i++) {
+        if (i + 1 >= argc) {
+            usage();
+            return 2;
+        }
+        if (strcmp(argv[i], "-o") == 0) {
+            outPath = argv[++i];
+        } else if (strcmp(argv[i], "-t") == 0) {
+            seconds = atof(argv[++i]);
+        } else if (strcmp(argv[i], "-f") == 0) {
+            filter = argv[++i];
+        } else if (strcmp(argv[i], "-c") == 0) {
+            baselinePath = argv[++i];
+        } else if (strcmp(argv[i], "-r") == 0) {
+            resultsPath = argv[++i];
+        } else if (strcmp(argv[i], "-p") == 0) {
+            tolerance = (float)atof(argv[++i]);
+        } else {
+            usage();
+            return 2;
+        }
+    }
+    if (seconds <= 0 || (resultsPath && !baselinePath)) {
+        usage();
+        return 2;
+    }
+
+    std::vector<KernelBenchResult> results;
+    if (resultsPath) {
+        if (!loadResults(resultsPath, results)) return 2;
+    } else {
+        // The modules' Serial logging would be timed into the kernels
+        Serial.setOutput(nullptr);
+        KernelBench bench(seconds);
+        bench.setFilter(filter);
+        runDspKernels(bench);
+        results = bench.getResults();
+
+        std::string json = kernelBenchJSON(results);
+        fputs(json.c_str(), stdout);
+        if (outPath) {
+            FILE* file = fopen(outPath, "w");
+            if (!file || fputs(json.c_str(), file) < 0 || fclose(file) != 0) {
+                fprintf(stderr, "could not write %s\n", outPath);
+                return 1;
+            }
+        }
+    }
+
+    if (!baselinePath) {
+        return 0;
+    }
+    std::vector<KernelBenchResult> baseline;
+    if (!loadResults(baselinePath, baseline)) return 2;
+    std::string report;
+    int regressions = compareKernelBench(baseline, results, tolerance, report);
+    fputs(report.c_str(), stderr);
+    fprintf(stderr, "%d regression%s over %.0f%%\n", regressions, regressions == 1 ? "" : "s", tolerance);
+    return regressions == 0 ? 0 : 1;
+}
+
+#endif // ARDUINO
+
+#endif // KERNEL_BENCH
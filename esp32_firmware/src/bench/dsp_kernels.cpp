@@ -0,0 +1,316 @@
+#include "bench/kernel_bench.h"
+#include "replay/synthetic_signals.h"
+#include "dsp/pipeline.h"
+#include "dsp/bandpass_designs.h"
+#include "dsp/qrs_detector.h"
+#include "dsp/peak_timing.h"
+#include "dsp/ppg_fiducials.h"
+#include "dsp/hrv_engine.h"
+#include "dsp/sliding_window_stats.h"
+#include "sensors/ppg_acquisition.h"
+#include "blood_pressure.h"
+#include "body_composition.h"
+#include "AD5940.h"
+#include "BIA_Application.h"
+#include "data_manager.h"
+#include "config.h"
+#include <math.h>
+#include <string.h>
+
+// The kernels, fed from SyntheticSignals (seed 1, 8 s of 72 BPM with a 200 ms
+// PTT and one five-point sweep). Streams are processed in the blocks the
+// firmware hands them on in: ECG_STREAM_BLOCK_SIZE frames, PPG FIFO bursts.
+//   ecg_bandpass, ppg_bandpass     the streams' band-pass stages (the old
+//                                  applyBandpassFilter) on the float back end
+//   ecg_bandpass_q15, ppg_bandpass_q15   the same on the fixed-point back end,
+//                                  float/Q15 conversions included (DSP_FIXED_POINT=1)
+//   qrs_detector, ppg_peak_detector, ppg_fiducials   the peak detectors
+//   bp_estimate                    calculateBloodPressure(): PTT median, HRV, PWV, quality
+//   hrv_beat                       HrvEngine::addBeat(), where calculateHRV()'s RMSSD comes from
+//   glucose_window                 the glucose IR and Red moving averages
+//   ad5940_impedance, bia_process_raw   DFT words to impedance, then to a calibrated result
+//   body_composition               analyzeBodyComposition() on the sweep, its Serial logging included
+//   sensor_json                    DataManager::formatSensorDataJSON() on a full reading
+
+static const double WORKLOAD_SECONDS = 8;
+static const size_t PPG_BURST = MAX30102Reg::FIFO_DEPTH - 15;      // PPGAcquisitionConfig::almostFullFree
+
+// Keeps the optimiser from discarding the kernels' results
+static volatile float sink;
+
+struct Workload {
+    std::vector<float> ecg;             // Raw AD8232 counts
+    std::vector<uint64_t> ecgTimes;
+    std::vector<float> ecgFiltered;
+    std::vector<PPGSample> ppg;
+    std::vector<float> ppgFiltered;     // IR, band-passed and inverted so pulses point up
+    std::vector<uint64_t> ppgTimes;
+    std::vector<QrsEvent> rPeaks;       // From the truth, as the detector reports them
+    BIAResult sweep[8];
+    int sweepPoints = 0;
+};
+
+static void buildWorkload(Workload& work) {
+    SyntheticConfig config;
+    config.seconds = WORKLOAD_SECONDS;
+    config.heartRateBPM = 72;
+    config.sweepTimes.push_back(1);
+    SyntheticSignals signals(config);
+
+    TraceRecord record;
+    while (signals.next(record)) {
+        if (record.channel == TraceChannel::ECG) {
+            work.ecg.push_back(record.values[0]);
+            work.ecgTimes.push_back(record.timeUs);
+        } else if (record.channel == TraceChannel::PPG) {
+            PPGSample sample = {(uint32_t)record.values[1], (uint32_t)record.values[0], record.timeUs};
+            work.ppg.push_back(sample);
+            work.ppgTimes.push_back(record.timeUs);
+        } else if (work.sweepPoints < 8) {
+            BIAResult& point = work.sweep[work.sweepPoints++];
+            point.Frequency = record.values[0];
+            point.Resistance = record.values[1];
+            point.Reactance = record.values[2];
+            point.Magnitude = sqrtf(point.Resistance * point.Resistance + point.Reactance * point.Reactance);
+            point.Phase = atan2f(point.Reactance, point.Resistance) * 180.0f / PI;
+            point.Timestamp = (uint32_t)(record.timeUs / 1000);
+            point.Valid = true;
+        }
+    }
+
+    // Band-passed copies for the detectors, through the same stages
+    work.ecgFiltered = work.ecg;
+    Pipeline<BandpassStage<ECGBandpass<ECG_STREAM_SAMPLE_RATE>, 3> > ecgFilter;
+    SampleBlock ecgBlock = {work.ecgFiltered.data(), work.ecgTimes.data(), work.ecgFiltered.size()};
+    ecgFilter.process(ecgBlock);
+    for (const PPGSample& sample : work.ppg) {
+        work.ppgFiltered.push_back((float)sample.ir);
+    }
+    Pipeline<BandpassStage<PPGBandpass<PPG_STREAM_SAMPLE_RATE>, -4> > ppgFilter;
+    SampleBlock ppgBlock = {work.ppgFiltered.data(), work.ppgTimes.data(), work.ppgFiltered.size()};
+    ppgFilter.process(ppgBlock);
+    for (float& value : work.ppgFiltered) {
+        value = -value;
+    }
+
+    uint64_t startUs = config.startUs;
+    uint64_t previousUs = 0;
+    for (const SyntheticBeat& beat : signals.getTruth().beats) {
+        if (beat.rPeak >= WORKLOAD_SECONDS) break;
+        uint64_t timeUs = startUs + (uint64_t)(beat.rPeak * 1e6);
+        QrsEvent event = {timeUs, 1000.0f, (uint32_t)(beat.rPeak * ECG_STREAM_SAMPLE_RATE),
+                          previousUs ? (float)(timeUs - previousUs) / 1000.0f : 0.0f, false};
+        work.rPeaks.push_back(event);
+        previousUs = timeUs;
+    }
+}
+
+// Successive blocks of a stream, wrapping at the end
+struct BlockCursor {
+    size_t next = 0;
+
+    size_t take(size_t total, size_t blockSize) {
+        if (next + blockSize > total) next = 0;
+        size_t first = next;
+        next += blockSize;
+        return first;
+    }
+};
+
+template <typename Precision>
+static void runBandpassKernels(KernelBench& bench, const Workload& work, const char* ecgName, const char* ppgName) {
+    const size_t ecgBlock = ECG_STREAM_BLOCK_SIZE;
+    float values[PPG_BURST > ECG_STREAM_BLOCK_SIZE ? PPG_BURST : ECG_STREAM_BLOCK_SIZE];
+    uint64_t times[sizeof(values) / sizeof(values[0])];
+
+    {
+        Pipeline<BandpassStage<ECGBandpass<ECG_STREAM_SAMPLE_RATE>, 3, Precision> > filter;
+        BlockCursor cursor;
+        bench.run(ecgName, ecgBlock, [&]() {
+            size_t first = cursor.take(work.ecg.size(), ecgBlock);
+            memcpy(values, &work.ecg[first], ecgBlock * sizeof(float));
+            SampleBlock block = {values, times, ecgBlock};
+            filter.process(block);
+            sink = values[ecgBlock - 1];
+        });
+    }
+    {
+        Pipeline<BandpassStage<PPGBandpass<PPG_STREAM_SAMPLE_RATE>, -4, Precision> > filter;
+        BlockCursor cursor;
+        bench.run(ppgName, PPG_BURST, [&]() {
+            size_t first = cursor.take(work.ppg.size(), PPG_BURST);
+            for (size_t i = 0; i < PPG_BURST; i++) values[i] = (float)work.ppg[first + i].ir;
+            SampleBlock block = {values, times, PPG_BURST};
+            filter.process(block);
+            sink = values[PPG_BURST - 1];
+        });
+    }
+}
+
+static void runStreamKernels(KernelBench& bench, const Workload& work) {
+    const size_t ecgBlock = ECG_STREAM_BLOCK_SIZE;
+
+    // Both back ends, whichever DSP_FIXED_POINT the build picked
+    runBandpassKernels<FloatPrecision>(bench, work, "ecg_bandpass", "ppg_bandpass");
+    runBandpassKernels<FixedPrecision>(bench, work, "ecg_bandpass_q15", "ppg_bandpass_q15");
+    {
+        static QrsDetector detector(ECG_STREAM_SAMPLE_RATE);
+        BlockCursor cursor;
+        bench.run("qrs_detector", ecgBlock, [&]() {
+            size_t first = cursor.take(work.ecgFiltered.size(), ecgBlock);
+            if (first == 0) detector.reset();      // Time must not run backwards
+            QrsEvent event;
+            for (size_t i = first; i < first + ecgBlock; i++) {
+                if (detector.addSample(work.ecgFiltered[i], work.ecgTimes[i], event)) sink = event.amplitude;
+            }
+        });
+    }
+    {
+        PeakDetector detector(0, 300000);
+        BlockCursor cursor;
+        bench.run("ppg_peak_detector", PPG_BURST, [&]() {
+            size_t first = cursor.take(work.ppgFiltered.size(), PPG_BURST);
+            if (first == 0) detector.reset();
+            TimedPeak peak;
+            for (size_t i = first; i < first + PPG_BURST; i++) {
+                if (detector.addSample(work.ppgFiltered[i], work.ppgTimes[i], peak)) sink = peak.value;
+            }
+        });
+    }
+    {
+        static PulseFiducialDetector detector;
+        BlockCursor cursor;
+        bench.run("ppg_fiducials", PPG_BURST, [&]() {
+            size_t first = cursor.take(work.ppgFiltered.size(), PPG_BURST);
+            if (first == 0) detector.reset();
+            PulseFiducials beats[4];
+            sink = (float)detector.processBlock(&work.ppgFiltered[first], &work.ppgTimes[first], PPG_BURST, beats, 4);
+        });
+    }
+}
+
+static void runEstimatorKernels(KernelBench& bench, const Workload& work, BloodPressureData& bpOut) {
+    {
+        // A monitor that has seen the whole workload, as between two estimates
+        static BloodPressureMonitor monitor;
+        monitor.reset();
+        size_t beat = 0;
+        size_t ecgNext = 0;
+        for (size_t first = 0; first + PPG_BURST <= work.ppg.size(); first += PPG_BURST) {
+            uint64_t burstEndUs = work.ppg[first + PPG_BURST - 1].timestampUs;
+            while (ecgNext + ECG_STREAM_BLOCK_SIZE <= work.ecg.size() && work.ecgTimes[ecgNext] <= burstEndUs) {
+                monitor.addFilteredECG(&work.ecgFiltered[ecgNext], &work.ecgTimes[ecgNext], ECG_STREAM_BLOCK_SIZE);
+                ecgNext += ECG_STREAM_BLOCK_SIZE;
+            }
+            // R-peaks arrive a couple of hundred ms late, as from the QRS detector
+            while (beat < work.rPeaks.size() && work.rPeaks[beat].timeUs + 200000 <= burstEndUs) {
+                monitor.addRPeak(work.rPeaks[beat++]);
+            }
+            monitor.addPPGBlock(&work.ppg[first], PPG_BURST);
+        }
+        // Clean synthetic channels, as the SQI engines would score them
+        SignalQualityIndex good = {};
+        good.score = 100;
+        good.valid = true;
+        monitor.setSignalQuality(good, good);
+        bench.run("bp_estimate", 1, [&]() {
+            bpOut = monitor.calculateBloodPressure();
+            sink = bpOut.pulseTransitTime;
+        });
+    }
+    {
+        static HrvEngine engine(HRV_SPECTRUM_INTERVAL_MS);
+        engine.reset();
+        uint64_t timeUs = 0;
+        size_t beat = 1;
+        bench.run("hrv_beat", 1, [&]() {
+            // The workload's RR intervals, looped
+            if (beat == work.rPeaks.size()) beat = 1;
+            timeUs += work.rPeaks[beat].timeUs - work.rPeaks[beat - 1].timeUs;
+            beat++;
+            engine.addBeat(timeUs);
+            sink = engine.getMetrics().rmssdMs;
+        });
+    }
+    {
+        static SlidingWindowStats<float, GLUCOSE_WINDOW_SIZE> irWindow;
+        static SlidingWindowStats<float, GLUCOSE_WINDOW_SIZE> redWindow;
+        BlockCursor cursor;
+        bench.run("glucose_window", 1, [&]() {
+            const PPGSample& sample = work.ppg[cursor.take(work.ppg.size(), 1)];
+            irWindow.push((float)sample.ir);
+            redWindow.push((float)sample.red);
+            sink = irWindow.mean() + redWindow.mean();
+        });
+    }
+}
+
+static void runBIAKernels(KernelBench& bench, const Workload& work, BodyComposition& compositionOut) {
+    // The sweep's points as the DFT words calculateImpedance() takes (1000 ohm full scale)
+    uint32_t realWords[8];
+    uint32_t imagWords[8];
+    for (int i = 0; i < work.sweepPoints; i++) {
+        realWords[i] = (uint32_t)(int32_t)(work.sweep[i].Resistance / 1000.0f * 32768.0f);
+        imagWords[i] = (uint32_t)(int32_t)(work.sweep[i].Reactance / 1000.0f * 32768.0f);
+    }
+    int point = 0;
+    bench.run("ad5940_impedance", 1, [&]() {
+        point = point + 1 == work.sweepPoints ? 0 : point + 1;
+        sink = AD5940.calculateImpedance(realWords[point], imagWords[point]).Magnitude;
+    });
+
+    static BIAApplication bia;
+    bench.run("bia_process_raw", 1, [&]() {
+        point = point + 1 == work.sweepPoints ? 0 : point + 1;
+        BIAResult result;
+        bia.processRawData(realWords[point], imagWords[point], result);
+        sink = result.Resistance;
+    });
+
+    static BodyCompositionAnalyzer analyzer;
+    UserProfile profile = {35, 175.0f, 70.0f, true, 3, false};
+    analyzer.setUserProfile(profile);
+    bench.run("body_composition", work.sweepPoints, [&]() {
+        compositionOut = analyzer.analyzeBodyComposition(work.sweep, work.sweepPoints, profile.weight);
+        sink = compositionOut.phaseAngle;
+    });
+}
+
+static void fillReadings(SensorReadings& readings, const Workload& work, const BloodPressureData& bp,
+                         const BodyComposition& composition) {
+    readings = SensorReadings();
+    uint32_t nowMs = (uint32_t)(work.ecgTimes.back() / 1000);
+    readings.systemTimestamp = nowMs;
+    readings.heartRate = {72.0f, 97.0f, true, nowMs, (1 << HR_SOURCE_ECG) | (1 << HR_SOURCE_PPG_SPECTRAL)};
+    readings.temperature = {36.6f, true, nowMs};
+    readings.weight = {70.0f, true, true, nowMs};
+    const BIAResult& point = work.sweep[work.sweepPoints / 2];
+    readings.bioimpedance = {point.Resistance, point.Reactance, point.Magnitude, point.Phase, point.Frequency, true, nowMs};
+    readings.ecg = {0.0f, 72, (int)work.rPeaks.size(), true, false, nowMs};
+    readings.glucose = {95.0f, (float)work.ppg.back().ir, (float)work.ppg.back().red, 0.8f, 90.0f, true, true, nowMs};
+    readings.bloodPressure = bp;
+    readings.bloodPressure.validReading = true;
+    readings.bodyComposition = composition;
+    readings.bodyComposition.validReading = true;
+}
+
+void runDspKernels(KernelBench& bench) {
+    static Workload work;
+    if (work.ecg.empty()) {
+        buildWorkload(work);
+    }
+    runStreamKernels(bench, work);
+
+    BloodPressureData bp = {};
+    runEstimatorKernels(bench, work, bp);
+    BodyComposition composition = {};
+    runBIAKernels(bench, work, composition);
+
+    static DataManager dataManager;
+    static SensorReadings readings;
+    fillReadings(readings, work, bp, composition);
+    bench.run("sensor_json", 1, [&]() {
+        String json = dataManager.formatSensorDataJSON(readings);
+        sink = (float)json.length();
+    });
+}
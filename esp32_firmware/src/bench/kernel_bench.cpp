@@ -0,0 +1,141 @@
+#include "bench/kernel_bench.h"
+#include "config.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef ARDUINO
+#include <Arduino.h>
+#include <esp_timer.h>
+
+KernelBenchStamp kernelBenchNow() {
+    KernelBenchStamp stamp;
+    stamp.cycles = ESP.getCycleCount();
+    stamp.ns = (uint64_t)esp_timer_get_time() * 1000;
+    return stamp;
+}
+
+bool kernelBenchHasCycles() { return true; }
+uint32_t kernelBenchCpuMhz() { return getCpuFrequencyMhz(); }
+
+#else
+#include <chrono>
+
+KernelBenchStamp kernelBenchNow() {
+    KernelBenchStamp stamp;
+    stamp.cycles = 0;
+    stamp.ns = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::steady_clock::now().time_since_epoch()).count();
+    return stamp;
+}
+
+bool kernelBenchHasCycles() { return false; }
+uint32_t kernelBenchCpuMhz() { return 0; }
+#endif
+
+static const char* SUITE_NAME = "biotrack-kernels";
+
+static void appendNumber(std::string& json, const char* key, double value) {
+    char field[64];
+    if (value < 0) {
+        snprintf(field, sizeof(field), ",\"%s\":null", key);
+    } else {
+        snprintf(field, sizeof(field), ",\"%s\":%.3f", key, value);
+    }
+    json += field;
+}
+
+// Written by hand: fixed fields, and no JSON document on the heap next to the
+// kernels being timed
+std::string kernelBenchJSON(const std::vector<KernelBenchResult>& results) {
+    char header[160];
+#ifdef ARDUINO
+    const char* platform = "esp32";
+#else
+    const char* platform = "host";
+#endif
+    snprintf(header, sizeof(header), "{\"suite\":\"%s\",\"firmware\":\"%s\",\"platform\":\"%s\",\"cpu_mhz\":%u,\"kernels\":[",
+             SUITE_NAME, FIRMWARE_VERSION, platform, (unsigned)kernelBenchCpuMhz());
+    std::string json = header;
+    for (size_t i = 0; i < results.size(); i++) {
+        const KernelBenchResult& result = results[i];
+        char fields[160];
+        snprintf(fields, sizeof(fields), "%s\n{\"name\":\"%s\",\"samples_per_op\":%u,\"ops\":%llu", i ? "," : "",
+                 result.name.c_str(), (unsigned)result.samplesPerOp, (unsigned long long)result.ops);
+        json += fields;
+        appendNumber(json, "ns_per_op", result.nsPerOp);
+        appendNumber(json, "ns_per_sample", result.nsPerSample());
+        appendNumber(json, "cycles_per_op", result.cyclesPerOp);
+        appendNumber(json, "cycles_per_sample", result.cyclesPerSample());
+        json += "}";
+    }
+    json += "\n]}\n";
+    return json;
+}
+
+#ifndef ARDUINO
+
+// The value after "key": in [from, to), -1 for null or a missing key
+static double numberField(const std::string& json, size_t from, size_t to, const char* key) {
+    std::string quoted = std::string("\"") + key + "\":";
+    size_t at = json.find(quoted, from);
+    if (at == std::string::npos || at >= to) return -1;
+    const char* value = json.c_str() + at + quoted.size();
+    if (strncmp(value, "null", 4) == 0) return -1;
+    return strtod(value, nullptr);
+}
+
+bool parseKernelBenchJSON(const std::string& json, std::vector<KernelBenchResult>& results) {
+    results.clear();
+    if (json.find(std::string("\"suite\":\"") + SUITE_NAME + "\"") == std::string::npos) {
+        return false;
+    }
+    size_t at = json.find("\"kernels\":[");
+    if (at == std::string::npos) {
+        return false;
+    }
+    // One flat object per kernel
+    while ((at = json.find("{\"name\":\"", at)) != std::string::npos) {
+        size_t nameStart = at + 9;
+        size_t nameEnd = json.find('"', nameStart);
+        size_t end = json.find('}', at);
+        if (nameEnd == std::string::npos || end == std::string::npos) {
+            return false;
+        }
+        KernelBenchResult result;
+        result.name = json.substr(nameStart, nameEnd - nameStart);
+        result.samplesPerOp = (uint32_t)numberField(json, at, end, "samples_per_op");
+        result.ops = (uint64_t)numberField(json, at, end, "ops");
+        result.nsPerOp = numberField(json, at, end, "ns_per_op");
+        result.cyclesPerOp = numberField(json, at, end, "cycles_per_op");
+        if (result.samplesPerOp == 0 || result.nsPerOp < 0) {
+            return false;
+        }
+        results.push_back(result);
+        at = end;
+    }
+    return true;
+}
+
+int compareKernelBench(const std::vector<KernelBenchResult>& baseline, const std::vector<KernelBenchResult>& current,
+                       float tolerancePercent, std::string& report) {
+    int regressions = 0;
+    for (const KernelBenchResult& now : current) {
+        for (const KernelBenchResult& before : baseline) {
+            if (before.name != now.name) continue;
+            bool cycles = before.cyclesPerOp >= 0 && now.cyclesPerOp >= 0;
+            double old = cycles ? before.cyclesPerSample() : before.nsPerSample();
+            double value = cycles ? now.cyclesPerSample() : now.nsPerSample();
+            double change = old > 0 ? (value / old - 1) * 100 : 0;
+            bool slower = change > tolerancePercent;
+            regressions += slower;
+            char line[160];
+            snprintf(line, sizeof(line), "%-28s %10.2f -> %10.2f %s/sample  %+6.1f%%%s\n", now.name.c_str(), old, value,
+                     cycles ? "cycles" : "ns", change, slower ? "  REGRESSION" : "");
+            report += line;
+        }
+    }
+    return regressions;
+}
+
+#endif // ARDUINO
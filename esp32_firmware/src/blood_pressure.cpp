@@ -2,31 +2,6 @@
 #include <math.h>
 
 BloodPressureMonitor::BloodPressureMonitor() {
-    // Initialize buffers
-    for (int i = 0; i < BP_BUFFER_SIZE; i++) {
-        ecgBuffer[i] = 0;
-        ppgBuffer[i] = 0;
-        ecgTimestamps[i] = 0;
-        ppgTimestamps[i] = 0;
-    }
-    
-    // Initialize filter buffers
-    for (int i = 0; i < 10; i++) {
-        ecgFilterBuffer[i] = 0;
-        ppgFilterBuffer[i] = 0;
-    }
-    
-    // Initialize peak arrays
-    for (int i = 0; i < 20; i++) {
-        ecgPeaks[i] = {0, 0, 0};
-        ppgPeaks[i] = {0, 0, 0};
-    }
-    
-    // Initialize RR intervals
-    for (int i = 0; i < 50; i++) {
-        rrIntervals[i] = 0;
-    }
-    
     // Initialize calibration points
     for (int i = 0; i < 5; i++) {
         calibrationPoints[i] = {0, 0, 0, 0};
@@ -51,61 +26,105 @@ bool BloodPressureMonitor::begin() {
 }
 
 void BloodPressureMonitor::reset() {
-    ecgBufferIndex = 0;
-    ppgBufferIndex = 0;
+    ecgBuffer.clear();
+    ppgBuffer.clear();
+    ecgSampleCount = 0;
+    ppgSampleCount = 0;
     ecgPeakCount = 0;
     ppgPeakCount = 0;
-    rrCount = 0;
-    filterIndex = 0;
+    hrvEngine.reset();
     lastValidReading = 0;
+    ecgPipeline.reset();
+    ppgPipeline.reset();
+    ecgPpgCorrelator.reset();
+    beatPairer.reset();
+    pttHistory.clear();
+    pttOutliers = 0;
+    pttOutlierRun = 0;
+    ecgQuality = {};
+    ppgQuality = {};
+}
+
+void BloodPressureMonitor::addECGSample(float ecgValue, uint64_t timestampUs) {
+    // Apply bandpass filter (0.5-40 Hz for ECG), starting from the first
+    // sample's level so the AD8232 mid-rail offset doesn't ring through
+    SampleBlock block = {&ecgValue, &timestampUs, 1};
+    ECGEvents events = {*this};
+    ecgPipeline.process(block, events);
 }
 
-void BloodPressureMonitor::addECGSample(float ecgValue, unsigned long timestamp) {
-    // Apply bandpass filter (0.5-40 Hz for ECG)
-    float filteredECG = applyBandpassFilter(ecgFilterBuffer, ecgValue);
+void BloodPressureMonitor::addFilteredECG(const float* values, const uint64_t* timestampsUs, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        updateECGBuffer(values[i], timestampsUs[i]);
+        ecgPpgCorrelator.addECG(values[i], timestampsUs[i]);
+    }
+}
+
+void BloodPressureMonitor::ECGEvents::on(const TappedBlock<TAP_FILTERED>& tap) {
+    monitor.addFilteredECG(tap.block.values, tap.block.timestampsUs, tap.block.count);
+}
+
+void BloodPressureMonitor::addRPeak(const QrsEvent& beat) {
+    ecgPeakCount++;
     
-    updateECGBuffer(filteredECG, timestamp);
+    // Opens a PTT window, or claims a pulse that was reported first
+    PairedBeat pair;
+    if (beatPairer.addRPeak(beat.timeUs, pair)) {
+        addPairedBeat(pair);
+    }
     
-    // Detect R-peaks in ECG
-    if (detectECGPeak(filteredECG, ecgBufferIndex)) {
-        // Store peak information
-        int peakIndex = ecgPeakCount % 20;
-        ecgPeaks[peakIndex] = {ecgBufferIndex, filteredECG, timestamp};
-        ecgPeakCount++;
+    // R-R interval for HRV, from the interpolated peak times
+    hrvEngine.addBeat(beat.timeUs);
+}
+
+void BloodPressureMonitor::setSignalQuality(const SignalQualityIndex& ecg, const SignalQualityIndex& ppg) {
+    ecgQuality = ecg;
+    ppgQuality = ppg;
+}
+
+void BloodPressureMonitor::addPPGSample(float irValue, float redValue, uint64_t timestampUs) {
+    PPGSample sample = {(uint32_t)redValue, (uint32_t)irValue, timestampUs};
+    addPPGBlock(&sample, 1);
+}
+
+void BloodPressureMonitor::addPPGBlock(const PPGSample* samples, size_t count) {
+    float values[PPG_BLOCK_SIZE];
+    uint64_t times[PPG_BLOCK_SIZE];
+    PPGEvents events = {*this};
+    
+    while (count > 0) {
+        size_t n = count < (size_t)PPG_BLOCK_SIZE ? count : PPG_BLOCK_SIZE;
         
-        // Calculate R-R interval for HRV
-        if (ecgPeakCount > 1) {
-            int prevIndex = (ecgPeakCount - 2) % 20;
-            float rrInterval = timestamp - ecgPeaks[prevIndex].timestamp;
-            
-            if (rrInterval > 300 && rrInterval < 2000) { // Valid RR interval (30-200 BPM)
-                rrIntervals[rrCount % 50] = rrInterval;
-                rrCount++;
-            }
+        // Use IR channel for pulse detection (more reliable for PTT). The
+        // counts dip as blood volume rises, so negate to make systole rise.
+        for (size_t i = 0; i < n; i++) {
+            values[i] = -(float)samples[i].ir;
+            times[i] = samples[i].timestampUs;
         }
+        
+        // Band-pass (0.5-8 Hz for PPG, primed with the DC level), then the
+        // pulse foot, max upslope and peak of every beat completed in the block
+        SampleBlock block = {values, times, n};
+        ppgPipeline.process(block, events);
+        
+        samples += n;
+        count -= n;
     }
-    
-    // Adaptive threshold adjustment
-    if (adaptiveThresholding) {
-        adaptThresholds();
+}
+
+void BloodPressureMonitor::PPGEvents::on(const TappedBlock<TAP_FILTERED>& tap) {
+    const SampleBlock& block = tap.block;
+    for (size_t i = 0; i < block.count; i++) {
+        monitor.updatePPGBuffer(block.values[i], block.timestampsUs[i]);
     }
+    monitor.ecgPpgCorrelator.addPPGBlock(block.values, block.timestampsUs, block.count);
 }
 
-void BloodPressureMonitor::addPPGSample(float irValue, float redValue, unsigned long timestamp) {
-    // Use IR channel for pulse detection (more reliable for PTT)
-    float ppgValue = irValue;
-    
-    // Apply bandpass filter (0.5-8 Hz for PPG)
-    float filteredPPG = applyBandpassFilter(ppgFilterBuffer, ppgValue);
-    
-    updatePPGBuffer(filteredPPG, timestamp);
-    
-    // Detect pulse peaks in PPG
-    if (detectPPGPeak(filteredPPG, ppgBufferIndex)) {
-        // Store peak information
-        int peakIndex = ppgPeakCount % 20;
-        ppgPeaks[peakIndex] = {ppgBufferIndex, filteredPPG, timestamp};
-        ppgPeakCount++;
+void BloodPressureMonitor::PPGEvents::on(const PulseFiducials& beat) {
+    monitor.ppgPeakCount++;
+    PairedBeat pair;
+    if (monitor.beatPairer.addPulse(beat.timeOf(monitor.pttFiducial), pair)) {
+        monitor.addPairedBeat(pair);
     }
 }
 
@@ -118,12 +137,20 @@ BloodPressureData BloodPressureMonitor::calculateBloodPressure() {
         return data;
     }
     
-    // Calculate Pulse Transit Time
-    float ptt = calculatePTT();
-    if (ptt <= 0) {
+    // A noisy channel only gives a noisy PTT: don't spend the rest on it
+    if (isLowQuality(ecgQuality, SQI_MIN_SCORE) || isLowQuality(ppgQuality, SQI_MIN_SCORE)) {
+        Serial.println("⚠️ ECG/PPG signal quality too low for BP calculation");
+        data.signalQuality = assessSignalQuality();
+        return data;
+    }
+    
+    // Pulse Transit Time: median of the paired-beat history (µs, reported in ms)
+    float pttUs = calculatePTT();
+    if (pttUs <= 0) {
         Serial.println("⚠️ Invalid PTT calculation");
         return data;
     }
+    float ptt = pttUs / 1000.0f;
     
     data.pulseTransitTime = ptt;
     data.pulseWaveVelocity = calculatePWV(ptt);
@@ -152,10 +179,13 @@ BloodPressureData BloodPressureMonitor::calculateBloodPressure() {
     
     // Calculate Heart Rate Variability
     data.heartRateVariability = calculateHRV();
+    data.hrv = hrvEngine.getMetrics();
     
     // Assess signal quality
     data.signalQuality = assessSignalQuality();
     data.correlationCoeff = calculateCorrelation();
+    float lagUs = calculateCorrelationPTT();
+    data.correlationPTT = lagUs > 0 ? lagUs / 1000.0f : 0;
     data.rhythmRegular = checkRhythmRegularity();
     
     // Validate reading
@@ -171,38 +201,39 @@ BloodPressureData BloodPressureMonitor::calculateBloodPressure() {
     return data;
 }
 
+void BloodPressureMonitor::addPairedBeat(const PairedBeat& pair) {
+    // Beats from a window either stream scored low are as likely missed or
+    // extra as real
+    if (isLowQuality(ecgQuality, SQI_MIN_SCORE) || isLowQuality(ppgQuality, SQI_MIN_SCORE)) {
+        return;
+    }
+    // A missed or extra beat on either side makes a wild PTT: keep it out of
+    // the history unless it persists (a real change in pressure)
+    if (pttHistory.count() >= 8 && pttHistory.isOutlier(pair.transitUs, 4.0f) && pttOutlierRun < 8) {
+        pttOutliers++;
+        pttOutlierRun++;
+        return;
+    }
+    pttOutlierRun = 0;
+    pttHistory.push(pair.transitUs);
+}
+
 float BloodPressureMonitor::calculatePTT() {
-    if (ecgPeakCount < 2 || ppgPeakCount < 2) {
+    if (pttHistory.count() < PTT_MIN_PAIRS) {
         return -1;
     }
-    
-    float totalPTT = 0;
-    int validPairs = 0;
-    
-    // Find matching ECG and PPG peaks within reasonable time window
-    for (int i = max(0, ecgPeakCount - 10); i < ecgPeakCount; i++) {
-        int ecgIndex = i % 20;
-        unsigned long ecgTime = ecgPeaks[ecgIndex].timestamp;
-        
-        // Look for corresponding PPG peak within 50-400ms after ECG peak
-        for (int j = max(0, ppgPeakCount - 10); j < ppgPeakCount; j++) {
-            int ppgIndex = j % 20;
-            unsigned long ppgTime = ppgPeaks[ppgIndex].timestamp;
-            
-            if (ppgTime > ecgTime && (ppgTime - ecgTime) >= 50 && (ppgTime - ecgTime) <= 400) {
-                float ptt = ppgTime - ecgTime;
-                totalPTT += ptt;
-                validPairs++;
-                break; // Take first valid match
-            }
-        }
-    }
-    
-    if (validPairs > 0) {
-        return totalPTT / validPairs;
+    return pttHistory.median();
+}
+
+void BloodPressureMonitor::setPTTFiducial(PulseFiducial fiducial) {
+    if (fiducial == pttFiducial) {
+        return;
     }
-    
-    return -1;
+    // PTTs to different fiducials don't mix
+    pttFiducial = fiducial;
+    beatPairer.reset();
+    pttHistory.clear();
+    pttOutlierRun = 0;
 }
 
 float BloodPressureMonitor::calculatePWV(float ptt) {
@@ -218,160 +249,65 @@ float BloodPressureMonitor::calculatePWV(float ptt) {
 }
 
 float BloodPressureMonitor::calculateHRV() {
-    if (rrCount < 10) {
+    // RMSSD (Root Mean Square of Successive Differences), kept by the engine
+    const HrvMetrics& metrics = hrvEngine.getMetrics();
+    if (metrics.intervals < 10) {
         return 0;
     }
-    
-    // Calculate RMSSD (Root Mean Square of Successive Differences)
-    float sumSquaredDiff = 0;
-    int validDiffs = 0;
-    
-    for (int i = 1; i < min(rrCount, 50); i++) {
-        float diff = rrIntervals[i] - rrIntervals[i-1];
-        sumSquaredDiff += diff * diff;
-        validDiffs++;
-    }
-    
-    if (validDiffs > 0) {
-        return sqrt(sumSquaredDiff / validDiffs);
-    }
-    return 0;
-}
-
-bool BloodPressureMonitor::detectECGPeak(float value, int index) {
-    static float lastValue = 0;
-    static float lastDerivative = 0;
-    static bool risingEdge = false;
-    static unsigned long lastPeakTime = 0;
-    
-    float derivative = value - lastValue;
-    
-    // Detect R-peak: positive peak above threshold with minimum interval
-    if (value > ecgThreshold && derivative > 0 && lastDerivative <= 0) {
-        risingEdge = true;
-    }
-    
-    if (risingEdge && derivative < 0 && lastDerivative >= 0) {
-        // Peak detected
-        unsigned long currentTime = millis();
-        if (currentTime - lastPeakTime > 300) { // Minimum 300ms between peaks
-            lastPeakTime = currentTime;
-            risingEdge = false;
-            lastValue = value;
-            lastDerivative = derivative;
-            return true;
-        }
-        risingEdge = false;
-    }
-    
-    lastValue = value;
-    lastDerivative = derivative;
-    return false;
-}
-
-bool BloodPressureMonitor::detectPPGPeak(float value, int index) {
-    static float lastValue = 0;
-    static float lastDerivative = 0;
-    static bool risingEdge = false;
-    static unsigned long lastPeakTime = 0;
-    
-    float derivative = value - lastValue;
-    
-    // Detect PPG peak: positive peak above threshold
-    if (value > ppgThreshold && derivative > 0 && lastDerivative <= 0) {
-        risingEdge = true;
-    }
-    
-    if (risingEdge && derivative < 0 && lastDerivative >= 0) {
-        // Peak detected
-        unsigned long currentTime = millis();
-        if (currentTime - lastPeakTime > 400) { // Minimum 400ms between peaks
-            lastPeakTime = currentTime;
-            risingEdge = false;
-            lastValue = value;
-            lastDerivative = derivative;
-            return true;
-        }
-        risingEdge = false;
-    }
-    
-    lastValue = value;
-    lastDerivative = derivative;
-    return false;
-}
-
-float BloodPressureMonitor::applyBandpassFilter(float* buffer, float newValue) {
-    // Simple moving average filter for now
-    // In production, use proper Butterworth or Chebyshev filter
-    buffer[filterIndex] = newValue;
-    filterIndex = (filterIndex + 1) % 10;
-    
-    float sum = 0;
-    for (int i = 0; i < 10; i++) {
-        sum += buffer[i];
-    }
-    return sum / 10.0;
+    return metrics.rmssdMs;
 }
 
 float BloodPressureMonitor::assessSignalQuality() {
-    float quality = 100.0;
-    
-    // Check signal stability
-    if (ecgPeakCount < 5 || ppgPeakCount < 5) {
-        quality -= 30;
+    // The weaker channel's SQI (a channel not yet assessed doesn't count)
+    float quality = 100.0f;
+    if (ecgQuality.valid) {
+        quality = fminf(quality, ecgQuality.score);
     }
-    
-    // Check peak regularity
-    if (!checkRhythmRegularity()) {
-        quality -= 20;
+    if (ppgQuality.valid) {
+        quality = fminf(quality, ppgQuality.score);
     }
     
-    // Check correlation between ECG and PPG
+    // Then how well the two line up: full marks from a correlation of 0.5
     int correlation = calculateCorrelation();
-    if (abs(correlation) < 50) {
-        quality -= 25;
-    }
+    quality = fminf(quality, max(0, correlation) * 2.0f);
     
-    // Check recent peak detection
-    if (millis() - lastValidReading > 10000) {
-        quality -= 25;
+    // The two PTT estimates should agree. The lag runs to the steepest part
+    // of the upstroke, so only max-slope pairs are comparable.
+    float lagUs = calculateCorrelationPTT();
+    float pttUs = calculatePTT();
+    if (pttFiducial == PulseFiducial::MAX_SLOPE && lagUs > 0 && pttUs > 0 &&
+        fabsf(lagUs - pttUs) > PTT_AGREEMENT_US) {
+        quality = fminf(quality, 50.0f);
     }
     
-    return max(0.0f, quality);
+    return quality;
 }
 
 int BloodPressureMonitor::calculateCorrelation() {
-    // Simplified correlation calculation
-    // In production, use proper Pearson correlation coefficient
-    if (ecgPeakCount < 3 || ppgPeakCount < 3) {
+    // Best normalised ECG-PPG cross-correlation over the PTT lag range
+    CorrelationPeak peak = ecgPpgCorrelator.getPeak();
+    if (!peak.valid) {
         return 0;
     }
-    
-    // For now, return high correlation if we have matching peaks
-    return 85; // Placeholder - implement proper correlation
+    return (int)lroundf(peak.coefficient * 100.0f);
+}
+
+float BloodPressureMonitor::calculateCorrelationPTT() {
+    CorrelationPeak peak = ecgPpgCorrelator.getPeak();
+    if (!peak.valid || peak.lagUs < 50000 || peak.lagUs > 500000) {
+        return -1;
+    }
+    return peak.lagUs;
 }
 
 bool BloodPressureMonitor::checkRhythmRegularity() {
-    if (rrCount < 5) {
+    const HrvMetrics& metrics = hrvEngine.getMetrics();
+    if (metrics.intervals < 5) {
         return false;
     }
     
-    // Check if RR intervals are relatively consistent
-    float mean = 0;
-    for (int i = 0; i < min(rrCount, 10); i++) {
-        mean += rrIntervals[i];
-    }
-    mean /= min(rrCount, 10);
-    
-    float variance = 0;
-    for (int i = 0; i < min(rrCount, 10); i++) {
-        float diff = rrIntervals[i] - mean;
-        variance += diff * diff;
-    }
-    variance /= min(rrCount, 10);
-    
     // Regular if standard deviation is less than 20% of mean
-    return sqrt(variance) < (mean * 0.2);
+    return metrics.sdnnMs < (metrics.meanRRMs * 0.2f);
 }
 
 bool BloodPressureMonitor::addCalibrationPoint(float systolic, float diastolic) {
@@ -380,8 +316,8 @@ bool BloodPressureMonitor::addCalibrationPoint(float systolic, float diastolic)
         return false;
     }
     
-    // Calculate current PTT
-    float currentPTT = calculatePTT();
+    // Calculate current PTT (ms)
+    float currentPTT = calculatePTT() / 1000.0f;
     if (currentPTT <= 0) {
         Serial.println("❌ Cannot calibrate: Invalid PTT");
         return false;
@@ -434,45 +370,14 @@ void BloodPressureMonitor::updateCalibration() {
                   systolicSlope, systolicIntercept, diastolicSlope, diastolicIntercept);
 }
 
-void BloodPressureMonitor::adaptThresholds() {
-    // Adaptive threshold adjustment based on signal statistics
-    static unsigned long lastUpdate = 0;
-    
-    if (millis() - lastUpdate < 5000) { // Update every 5 seconds
-        return;
-    }
-    
-    // Calculate signal statistics
-    float ecgMean = 0, ppgMean = 0;
-    int samples = min(ecgBufferIndex, 50);
-    
-    for (int i = 0; i < samples; i++) {
-        ecgMean += ecgBuffer[i];
-        ppgMean += ppgBuffer[i];
-    }
-    
-    if (samples > 0) {
-        ecgMean /= samples;
-        ppgMean /= samples;
-        
-        // Adjust thresholds to be 1.5x above mean
-        ecgThreshold = ecgMean * 1.5;
-        ppgThreshold = ppgMean * 1.5;
-    }
-    
-    lastUpdate = millis();
-}
-
-void BloodPressureMonitor::updateECGBuffer(float value, unsigned long timestamp) {
-    ecgBuffer[ecgBufferIndex] = value;
-    ecgTimestamps[ecgBufferIndex] = timestamp;
-    ecgBufferIndex = (ecgBufferIndex + 1) % BP_BUFFER_SIZE;
+void BloodPressureMonitor::updateECGBuffer(float value, uint64_t timestampUs) {
+    ecgBuffer.slide({value, timestampUs}, BP_BUFFER_SIZE);
+    ecgSampleCount++;
 }
 
-void BloodPressureMonitor::updatePPGBuffer(float value, unsigned long timestamp) {
-    ppgBuffer[ppgBufferIndex] = value;
-    ppgTimestamps[ppgBufferIndex] = timestamp;
-    ppgBufferIndex = (ppgBufferIndex + 1) % BP_BUFFER_SIZE;
+void BloodPressureMonitor::updatePPGBuffer(float value, uint64_t timestampUs) {
+    ppgBuffer.slide({value, timestampUs}, BP_BUFFER_SIZE);
+    ppgSampleCount++;
 }
 
 bool BloodPressureMonitor::isReadyForMeasurement() {
@@ -507,7 +412,23 @@ void BloodPressureMonitor::printDiagnostics() {
     Serial.printf("ECG Peaks: %d, PPG Peaks: %d\n", ecgPeakCount, ppgPeakCount);
     Serial.printf("Signal Quality: %.1f%%\n", assessSignalQuality());
     Serial.printf("Calibration Points: %d/5\n", calibrationCount);
-    Serial.printf("Current Thresholds: ECG=%.1f, PPG=%.1f\n", ecgThreshold, ppgThreshold);
+    Serial.printf("PTT Fiducial: %s\n", pulseFiducialName(pttFiducial));
+    Serial.printf("PTT: median %.1f ms, MAD %.1f ms over %d pairs (%lu paired, %lu outliers)\n",
+                  pttHistory.median() / 1000.0f, pttHistory.mad() / 1000.0f, (int)pttHistory.count(),
+                  (unsigned long)beatPairer.getPairedCount(), (unsigned long)pttOutliers);
+    const HrvMetrics& hrv = hrvEngine.getMetrics();
+    Serial.printf("HRV: %lu RR, mean %.0f ms, SDNN %.1f ms, RMSSD %.1f ms, pNN50 %.1f%%, %lu rejected\n",
+                  (unsigned long)hrv.intervals, hrv.meanRRMs, hrv.sdnnMs, hrv.rmssdMs, hrv.pnn50,
+                  (unsigned long)hrvEngine.getRejectedCount());
+    if (hrv.spectrumValid) {
+        Serial.printf("HRV spectrum: LF %.0f ms^2, HF %.0f ms^2, LF/HF %.2f\n", hrv.lfPower, hrv.hfPower, hrv.lfHfRatio);
+    }
+    CorrelationPeak peak = ecgPpgCorrelator.getPeak();
+    if (peak.valid) {
+        Serial.printf("ECG-PPG correlation: r=%.2f, lag %.1f ms\n", peak.coefficient, peak.lagUs / 1000.0f);
+    } else {
+        Serial.println("ECG-PPG correlation: filling window");
+    }
     
     if (calibrationCount > 0) {
         Serial.printf("Calibration: Sys=%.3f*PTT+%.1f, Dia=%.3f*PTT+%.1f\n",
@@ -1,7 +1,8 @@
 #include "body_composition.h"
 #include <math.h>
 
-BodyCompositionAnalyzer::BodyCompositionAnalyzer() {
+BodyCompositionAnalyzer::BodyCompositionAnalyzer()
+    : sweepQuality(SignalQualityConfig{SignalKind::BIA, 0, 0, 0, 0, QUALITY_SWEEP_POINTS, 0}) {
     profileSet = false;
     athleteModeEnabled = false;
     
@@ -63,6 +64,14 @@ BodyComposition BodyCompositionAnalyzer::analyzeBodyComposition(const BIAResult*
     composition.impedance50kHz = result50kHz->Magnitude;
     composition.phaseAngle = calculatePhaseAngle(result50kHz->Resistance, result50kHz->Reactance);
     
+    // Quality first: a sweep unlike the previous ones, or with points out of
+    // range, is a contact problem and not worth the equations
+    composition.measurementQuality = assessMeasurementQuality(biaResults, resultCount);
+    if (composition.measurementQuality <= 60.0f) {
+        Serial.printf("⚠️ BIA sweep quality %.0f%%, body composition skipped\n", composition.measurementQuality);
+        return composition;
+    }
+    
     // Calculate body composition using multiple approaches
     
     // 1. Total Body Water (TBW) calculation
@@ -93,12 +102,8 @@ BodyComposition BodyCompositionAnalyzer::analyzeBodyComposition(const BIAResult*
                                   userProfile.isMale, composition.muscleMassKg);
     composition.metabolicAge = calculateMetabolicAge(composition.BMR, userProfile.isMale);
     
-    // 7. Quality assessment
-    composition.measurementQuality = assessMeasurementQuality(biaResults, resultCount);
-    
-    // 8. Validation
-    composition.validReading = (composition.measurementQuality > 60.0f &&
-                               isReasonableBodyFat(composition.bodyFatPercentage, userProfile.age, userProfile.isMale) &&
+    // 7. Validation
+    composition.validReading = (isReasonableBodyFat(composition.bodyFatPercentage, userProfile.age, userProfile.isMale) &&
                                isReasonableMuscleMass(composition.muscleMassPercentage, userProfile.age, userProfile.isMale));
     
     if (composition.validReading) {
@@ -268,35 +273,16 @@ bool BodyCompositionAnalyzer::validateBIAData(const BIAResult& result) {
 float BodyCompositionAnalyzer::assessMeasurementQuality(const BIAResult* results, int count) {
     if (count == 0) return 0;
     
-    float qualityScore = 100.0f;
-    
-    // Check data consistency
-    if (count > 1) {
-        float resistanceVariation = 0;
-        float reactanceVariation = 0;
-        
-        for (int i = 1; i < count; i++) {
-            resistanceVariation += abs(results[i].Resistance - results[i-1].Resistance);
-            reactanceVariation += abs(results[i].Reactance - results[i-1].Reactance);
-        }
-        
-        resistanceVariation /= count;
-        reactanceVariation /= count;
-        
-        // Penalize high variation
-        if (resistanceVariation > 20) qualityScore -= 30;
-        if (reactanceVariation > 10) qualityScore -= 20;
-    }
-    
-    // Check phase angle quality
+    // The phase spectrum as one window; only a full sweep completes the
+    // template and is matched against the earlier ones
+    sweepQuality.addBeatAt(sweepQuality.sampleCount());
     for (int i = 0; i < count; i++) {
         float phaseAngle = calculatePhaseAngle(results[i].Resistance, results[i].Reactance);
-        if (phaseAngle < 3.0f || phaseAngle > 15.0f) {
-            qualityScore -= 15;
-        }
+        sweepQuality.addRaw(phaseAngle, !validateBIAData(results[i]));
+        sweepQuality.addSample(phaseAngle, 0);
     }
-    
-    return max(0.0f, qualityScore);
+    sweepQuality.endWindow();
+    return sweepQuality.getIndex().score;
 }
 
 bool BodyCompositionAnalyzer::isReasonableBodyFat(float bodyFatPercentage, int age, bool isMale) {
@@ -41,13 +41,14 @@ bool DataManager::begin() {
 }
 
 bool DataManager::initializeFileSystem() {
-    if (!SPIFFS.begin(true)) {
+    hal::FileSystem& fs = hal::fileSystem();
+    if (!fs.mount()) {
         Serial.println("❌ SPIFFS Mount Failed");
         return false;
     }
     
-    Serial.printf("📁 SPIFFS initialized. Total: %d bytes, Used: %d bytes\n",
-                 SPIFFS.totalBytes(), SPIFFS.usedBytes());
+    Serial.printf("📁 SPIFFS initialized. Total: %u bytes, Used: %u bytes\n",
+                 (unsigned)fs.totalBytes(), (unsigned)fs.usedBytes());
     
     return true;
 }
@@ -87,6 +88,12 @@ String DataManager::formatSensorDataJSON(const SensorReadings& data) {
         hr["spo2"] = data.heartRate.spO2;
         hr["timestamp"] = data.heartRate.timestamp;
         hr["valid"] = true;
+        JsonArray sources = hr.createNestedArray("sources");
+        for (uint8_t s = 0; s < HR_SOURCE_COUNT; s++) {
+            if (data.heartRate.sources & (1 << s)) {
+                sources.add(heartRateSourceName((HeartRateSource)s));
+            }
+        }
     }
     
     // Temperature data
@@ -154,6 +161,19 @@ String DataManager::formatSensorDataJSON(const SensorReadings& data) {
         bp["HRV"] = data.bloodPressure.heartRateVariability;
         bp["signalQuality"] = data.bloodPressure.signalQuality;
         bp["correlationCoeff"] = data.bloodPressure.correlationCoeff;
+        bp["correlationPTT"] = data.bloodPressure.correlationPTT;
+        const HrvMetrics& hrvMetrics = data.bloodPressure.hrv;
+        JsonObject hrv = bp.createNestedObject("hrv");
+        hrv["meanRR"] = hrvMetrics.meanRRMs;
+        hrv["SDNN"] = hrvMetrics.sdnnMs;
+        hrv["RMSSD"] = hrvMetrics.rmssdMs;
+        hrv["pNN50"] = hrvMetrics.pnn50;
+        hrv["intervals"] = hrvMetrics.intervals;
+        if (hrvMetrics.spectrumValid) {
+            hrv["LF"] = hrvMetrics.lfPower;
+            hrv["HF"] = hrvMetrics.hfPower;
+            hrv["LFHF"] = hrvMetrics.lfHfRatio;
+        }
         bp["unit"] = "mmHg";
         bp["timestamp"] = data.bloodPressure.timestamp;
         bp["valid"] = true;
@@ -181,6 +201,28 @@ String DataManager::formatSensorDataJSON(const SensorReadings& data) {
         bc["valid"] = true;
     }
     
+    // Signal quality of each channel's latest assessed window
+    const SignalQualityIndex* channels[] = {&data.quality.ecg, &data.quality.ppg, &data.quality.bia};
+    const char* channelNames[] = {"ecg", "ppg", "bia"};
+    JsonObject sqi;
+    for (int c = 0; c < 3; c++) {
+        const SignalQualityIndex& q = *channels[c];
+        if (!q.valid) {
+            continue;
+        }
+        if (sqi.isNull()) {
+            sqi = doc.createNestedObject("sqi");
+        }
+        JsonObject channel = sqi.createNestedObject(channelNames[c]);
+        channel["score"] = q.score;
+        channel["kurtosis"] = q.kurtosis;
+        channel["skewness"] = q.skewness;
+        channel["perfusionIndex"] = q.perfusionIndex;
+        channel["templateMatch"] = q.templateMatch;
+        channel["clipping"] = q.clippingRatio;
+        channel["beats"] = q.beats;
+    }
+    
     String output;
     serializeJson(doc, output);
     return output;
@@ -246,39 +288,37 @@ void DataManager::addAlert(const String& type, const String& message, const Stri
 }
 
 bool DataManager::saveDataToFile(const SensorReadings& data) {
-    File file = SPIFFS.open(DATA_FILE, FILE_APPEND);
-    if (!file) {
+    String line = formatSensorDataJSON(data) + "\n";
+    if (!hal::fileSystem().write(DATA_FILE, line.c_str(), line.length(), true)) {
         Serial.println("❌ Failed to open data file for writing");
         return false;
     }
     
-    String jsonData = formatSensorDataJSON(data);
-    file.println(jsonData);
-    file.close();
-    
     return true;
 }
 
 bool DataManager::loadDataFromFile() {
-    if (!SPIFFS.exists(DATA_FILE)) {
+    hal::FileSystem& fs = hal::fileSystem();
+    if (!fs.exists(DATA_FILE)) {
         Serial.println("📁 No existing data file found");
         return true; // Not an error
     }
     
-    File file = SPIFFS.open(DATA_FILE, FILE_READ);
-    if (!file) {
+    // Count the stored lines a chunk at a time
+    // Could parse and load recent data into buffer here
+    int lineCount = 0;
+    bool opened = fs.read(DATA_FILE, [](void* context, const char* data, size_t length) {
+        int& lines = *(int*)context;
+        for (size_t i = 0; i < length && lines < MAX_BUFFER_SIZE; i++) {
+            if (data[i] == '\n') lines++;
+        }
+        return lines < MAX_BUFFER_SIZE;
+    }, &lineCount);
+    if (!opened) {
         Serial.println("❌ Failed to open data file for reading");
         return false;
     }
     
-    int lineCount = 0;
-    while (file.available() && lineCount < MAX_BUFFER_SIZE) {
-        String line = file.readStringUntil('\n');
-        // Could parse and load recent data into buffer here
-        lineCount++;
-    }
-    
-    file.close();
     Serial.printf("📁 Loaded %d data entries from file\n", lineCount);
     return true;
 }
@@ -338,10 +378,10 @@ String DataManager::getSystemStats() {
     doc["successfulUploads"] = successfulUploads;
     doc["failedUploads"] = failedUploads;
     doc["successRate"] = getUploadSuccessRate();
-    doc["freeHeap"] = ESP.getFreeHeap();
+    doc["freeHeap"] = hal::freeHeapBytes();
     doc["uptime"] = millis() / 1000;
-    doc["storageUsed"] = SPIFFS.usedBytes();
-    doc["storageTotal"] = SPIFFS.totalBytes();
+    doc["storageUsed"] = hal::fileSystem().usedBytes();
+    doc["storageTotal"] = hal::fileSystem().totalBytes();
     doc["version"] = FIRMWARE_VERSION;
     
     String output;
@@ -364,11 +404,6 @@ void DataManager::updateStatistics(bool uploadSuccess) {
 }
 
 bool DataManager::saveAlertsToFile() {
-    File file = SPIFFS.open(ALERTS_FILE, FILE_WRITE);
-    if (!file) {
-        return false;
-    }
-    
     StaticJsonDocument<JSON_BUFFER_SIZE> doc;
     JsonArray alertsArray = doc.createNestedArray("alerts");
     
@@ -385,24 +420,26 @@ bool DataManager::saveAlertsToFile() {
     
     String output;
     serializeJson(doc, output);
-    file.print(output);
-    file.close();
-    
-    return true;
+    return hal::fileSystem().write(ALERTS_FILE, output.c_str(), output.length(), false);
 }
 
 bool DataManager::loadAlertsFromFile() {
-    if (!SPIFFS.exists(ALERTS_FILE)) {
+    hal::FileSystem& fs = hal::fileSystem();
+    if (!fs.exists(ALERTS_FILE)) {
         return true; // Not an error
     }
     
-    File file = SPIFFS.open(ALERTS_FILE, FILE_READ);
-    if (!file) {
+    long fileSize = fs.size(ALERTS_FILE);
+    if (fileSize < 0) {
         return false;
     }
     
-    String content = file.readString();
-    file.close();
+    String content;
+    content.reserve(fileSize);
+    fs.read(ALERTS_FILE, [](void* context, const char* data, size_t) {
+        *(String*)context += data;
+        return true;
+    }, &content);
     
     StaticJsonDocument<JSON_BUFFER_SIZE> doc;
     DeserializationError error = deserializeJson(doc, content);
@@ -451,7 +488,8 @@ int DataManager::getUnacknowledgedAlertsCount() {
 }
 
 size_t DataManager::getAvailableStorage() {
-    return SPIFFS.totalBytes() - SPIFFS.usedBytes();
+    hal::FileSystem& fs = hal::fileSystem();
+    return fs.totalBytes() - fs.usedBytes();
 }
 
 SensorReadings DataManager::getLatestReading() {
@@ -0,0 +1,78 @@
+#include "dsp/beat_pairer.h"
+
+BeatPairer::BeatPairer(uint32_t minUs, uint32_t maxUs) : minUs(minUs), maxUs(maxUs) {
+    reset();
+}
+
+void BeatPairer::reset() {
+    for (size_t i = 0; i < QUEUE; i++) {
+        openRPeaks[i] = 0;
+        earlyPulses[i] = 0;
+    }
+    rHead = 0;
+    rTail = 0;
+    pHead = 0;
+    pTail = 0;
+    paired = 0;
+    unpairedRPeaks = 0;
+    unpairedPulses = 0;
+}
+
+bool BeatPairer::addRPeak(uint64_t timeUs, PairedBeat& pair) {
+    // Pulses that arrived first: any before this window can't belong to
+    // this R-peak or a later one
+    while (pHead != pTail && earlyPulses[pHead % QUEUE] < timeUs + minUs) {
+        pHead++;
+        unpairedPulses++;
+    }
+    if (pHead != pTail && earlyPulses[pHead % QUEUE] <= timeUs + maxUs) {
+        return makePair(timeUs, earlyPulses[pHead++ % QUEUE], pair);
+    }
+
+    // Open a window; with no pulses arriving the oldest one gives way
+    if (rTail - rHead == QUEUE) {
+        rHead++;
+        unpairedRPeaks++;
+    }
+    openRPeaks[rTail++ % QUEUE] = timeUs;
+    return false;
+}
+
+bool BeatPairer::addPulse(uint64_t timeUs, PairedBeat& pair) {
+    expireRPeaks(timeUs);
+
+    if (rHead != rTail) {
+        uint64_t rPeakUs = openRPeaks[rHead % QUEUE];
+        if (timeUs >= rPeakUs + minUs) {
+            rHead++;
+            return makePair(rPeakUs, timeUs, pair);
+        }
+        // Too soon after every open R-peak, and later ones are later still
+        unpairedPulses++;
+        return false;
+    }
+
+    // No window open yet: the R-peak may still be on its way
+    if (pTail - pHead == QUEUE) {
+        pHead++;
+        unpairedPulses++;
+    }
+    earlyPulses[pTail++ % QUEUE] = timeUs;
+    return false;
+}
+
+void BeatPairer::expireRPeaks(uint64_t nowUs) {
+    // Pulses arrive in time order, so a window this pulse is past stays empty
+    while (rHead != rTail && openRPeaks[rHead % QUEUE] + maxUs < nowUs) {
+        rHead++;
+        unpairedRPeaks++;
+    }
+}
+
+bool BeatPairer::makePair(uint64_t rPeakUs, uint64_t pulseUs, PairedBeat& pair) {
+    pair.rPeakUs = rPeakUs;
+    pair.pulseUs = pulseUs;
+    pair.transitUs = (uint32_t)(pulseUs - rPeakUs);
+    paired++;
+    return true;
+}
@@ -0,0 +1,248 @@
+#include "dsp/ecg_ppg_correlator.h"
+#include "dsp/peak_timing.h"
+#include <math.h>
+
+template <typename Precision>
+BasicEcgPpgCorrelator<Precision>::BasicEcgPpgCorrelator() {
+    ecg.squared = true;
+    ppg.squared = false;
+    reset();
+}
+
+template <typename Precision>
+void BasicEcgPpgCorrelator<Precision>::reset() {
+    resetChannel(ecg);
+    resetChannel(ppg);
+    restartCorrelation();
+}
+
+template <typename Precision>
+void BasicEcgPpgCorrelator<Precision>::resetChannel(Channel& channel) {
+    channel.havePrevious = false;
+    channel.previous = 0;
+    channel.previousUs = 0;
+    channel.binOpen = false;
+    channel.bin = 0;
+    channel.binSum = 0;
+    channel.binCount = 0;
+    channel.binMean = 0;
+    channel.recentCount = 0;
+    channel.started = false;
+    channel.firstBin = 0;
+    channel.nextBin = 0;
+}
+
+template <typename Precision>
+void BasicEcgPpgCorrelator<Precision>::restartCorrelation() {
+    // Whatever each channel already holds is left out of the next window
+    ecg.firstBin = ecg.nextBin;
+    ppg.firstBin = ppg.nextBin;
+    active = false;
+    correlatedBin = 0;
+    windowBins = 0;
+    sumY = 0;
+    sumYY = 0;
+    for (uint32_t i = 0; i < LAGS; i++) {
+        sumX[i] = 0;
+        sumXX[i] = 0;
+        sumXY[i] = 0;
+    }
+}
+
+template <typename Precision>
+void BasicEcgPpgCorrelator<Precision>::addECG(float value, uint64_t timestampUs) {
+    addSample(ecg, value, timestampUs);
+    advance();
+}
+
+template <typename Precision>
+void BasicEcgPpgCorrelator<Precision>::addPPG(float value, uint64_t timestampUs) {
+    addSample(ppg, value, timestampUs);
+    advance();
+}
+
+template <typename Precision>
+void BasicEcgPpgCorrelator<Precision>::addPPGBlock(const float* values, const uint64_t* timestampsUs, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        addSample(ppg, values[i], timestampsUs[i]);
+        advance();
+    }
+}
+
+template <typename Precision>
+void BasicEcgPpgCorrelator<Precision>::addSample(Channel& channel, float value, uint64_t timestampUs) {
+    if (!channel.havePrevious || timestampUs < channel.previousUs) {
+        if (channel.havePrevious) {
+            // Clock went back (the source restarted)
+            resetChannel(channel);
+            restartCorrelation();
+        }
+        channel.havePrevious = true;
+        channel.previous = value;
+        channel.previousUs = timestampUs;
+        return;
+    }
+
+    // Slope between two samples, stamped midway between them
+    float slope = value - channel.previous;
+    float feature = channel.squared ? slope * slope : (slope > 0 ? slope : 0);
+    uint32_t bin = (uint32_t)((channel.previousUs + (timestampUs - channel.previousUs) / 2) / BIN_US);
+    channel.previous = value;
+    channel.previousUs = timestampUs;
+
+    if (channel.binOpen && bin != channel.bin) {
+        channel.binMean = channel.binSum / channel.binCount;
+        uint32_t skipped = bin - channel.bin - 1;
+        if (skipped > MAX_GAP_BINS) {
+            // Samples went missing: start over from this one
+            resetChannel(channel);
+            restartCorrelation();
+            channel.havePrevious = true;
+            channel.previous = value;
+            channel.previousUs = timestampUs;
+            return;
+        }
+        // A short gap (a late FIFO read) holds the last bin across it
+        for (uint32_t b = channel.bin; b != bin; b++) {
+            emitBin(channel, b, channel.binMean);
+        }
+        channel.binOpen = false;
+    }
+
+    if (!channel.binOpen) {
+        channel.bin = bin;
+        channel.binSum = 0;
+        channel.binCount = 0;
+        channel.binOpen = true;
+    }
+    channel.binSum += feature;
+    channel.binCount++;
+}
+
+template <typename Precision>
+void BasicEcgPpgCorrelator<Precision>::emitBin(Channel& channel, uint32_t bin, float mean) {
+    // Bins arrive consecutively, so the bin number places them in the smoother
+    channel.recent[bin % SMOOTH] = mean;
+    if (channel.recentCount < SMOOTH) {
+        channel.recentCount++;
+        if (channel.recentCount < SMOOTH) {
+            return;
+        }
+    }
+    float sum = 0;
+    for (uint32_t i = 0; i < SMOOTH; i++) {
+        sum += channel.recent[i];
+    }
+
+    if (!channel.started) {
+        channel.started = true;
+        channel.firstBin = bin;
+    }
+    if (active && (int32_t)(bin - correlatedBin) >= (int32_t)(RING - WINDOW - MAX_LAG)) {
+        // This would overwrite bins the window still needs: the other stream has stalled
+        restartCorrelation();
+    }
+    if (bin - channel.firstBin >= RING) {
+        channel.firstBin = bin - RING + 1;
+    }
+    channel.feature[bin % RING] = Arithmetic::quantise(sum / SMOOTH, channel.squared);
+    channel.nextBin = bin + 1;
+}
+
+template <typename Precision>
+void BasicEcgPpgCorrelator<Precision>::advance() {
+    if (!active) {
+        if (ecg.nextBin == ecg.firstBin || ppg.nextBin == ppg.firstBin) {
+            return;
+        }
+        // ECG from the later of the two starts, PPG from MAX_LAG bins after
+        uint32_t start = (int32_t)(ecg.firstBin - ppg.firstBin) > 0 ? ecg.firstBin : ppg.firstBin;
+        correlatedBin = start + MAX_LAG;
+        active = true;
+    }
+
+    uint32_t end = (int32_t)(ecg.nextBin - ppg.nextBin) < 0 ? ecg.nextBin : ppg.nextBin;
+    while ((int32_t)(end - correlatedBin) > 0) {
+        correlateBin(correlatedBin++);
+    }
+}
+
+template <typename Precision>
+void BasicEcgPpgCorrelator<Precision>::correlateBin(uint32_t bin) {
+    // PPG at this bin against the ECG MIN_LAG..MAX_LAG bins before it
+    if (windowBins == WINDOW) {
+        uint32_t old = bin - WINDOW;
+        Feature yOld = ppg.feature[old % RING];
+        sumY -= yOld;
+        sumYY -= (Sum)yOld * yOld;
+        updateLagSums<true>(old, yOld);
+    } else {
+        windowBins++;
+    }
+
+    Feature y = ppg.feature[bin % RING];
+    sumY += y;
+    sumYY += (Sum)y * y;
+    updateLagSums<false>(bin, y);
+}
+
+template <typename Precision>
+template <bool Subtract>
+void BasicEcgPpgCorrelator<Precision>::updateLagSums(uint32_t bin, Feature y) {
+    // The ECG bins MAX_LAG..MIN_LAG before this one, in at most two runs of the ring
+    uint32_t first = (bin - MAX_LAG) % RING;
+    uint32_t run = RING - first < LAGS ? RING - first : LAGS;
+    lagSums<Subtract>(&ecg.feature[first], y, sumX, sumXX, sumXY, run);
+    if (run < LAGS) {
+        lagSums<Subtract>(&ecg.feature[0], y, sumX + run, sumXX + run, sumXY + run, LAGS - run);
+    }
+}
+
+template <typename Precision>
+float BasicEcgPpgCorrelator<Precision>::coefficientAt(uint32_t lagBins) const {
+    if (windowBins < 2 || lagBins < MIN_LAG || lagBins > MAX_LAG) {
+        return 0;
+    }
+    uint32_t i = MAX_LAG - lagBins;
+    return Arithmetic::coefficient(windowBins, sumX[i], sumXX[i], sumY, sumYY, sumXY[i]);
+}
+
+float CorrelatorArithmetic<FloatPrecision>::coefficient(uint32_t count, Sum sumX, Sum sumXX, Sum sumY, Sum sumYY,
+                                                       Sum sumXY) {
+    double n = count;
+    double covariance = n * sumXY - sumX * sumY;
+    double varianceX = n * sumXX - sumX * sumX;
+    double varianceY = n * sumYY - sumY * sumY;
+    // A flat channel leaves only rounding in the variance
+    if (varianceX <= 1e-9 * n * sumXX || varianceY <= 1e-9 * n * sumYY) {
+        return 0;
+    }
+    double r = covariance / sqrt(varianceX * varianceY);
+    return (float)(r > 1.0 ? 1.0 : (r < -1.0 ? -1.0 : r));
+}
+
+template <typename Precision>
+CorrelationPeak BasicEcgPpgCorrelator<Precision>::getPeak() const {
+    CorrelationPeak peak = {0, -1, isReady()};
+    if (windowBins < 2) {
+        return peak;
+    }
+
+    float r[LAGS];
+    uint32_t best = 0;
+    for (uint32_t i = 0; i < LAGS; i++) {
+        r[i] = coefficientAt(MIN_LAG + i);
+        if (r[i] > r[best]) best = i;
+    }
+    peak.coefficient = r[best];
+
+    // On the edge the true peak may lie outside the range
+    if (best > 0 && best < LAGS - 1) {
+        float offset = parabolicPeakOffset(r[best - 1], r[best], r[best + 1]);
+        peak.lagUs = (MIN_LAG + best + offset) * BIN_US;
+    }
+    return peak;
+}
+
+template class BasicEcgPpgCorrelator<FloatPrecision>;
+template class BasicEcgPpgCorrelator<FixedPrecision>;
@@ -0,0 +1,56 @@
+#include "dsp/fixed_point.h"
+
+uint32_t isqrt64(uint64_t value) {
+    // Digit by digit, two bits of the input per bit of the root
+    uint64_t remainder = value;
+    uint64_t root = 0;
+    uint64_t bit = 1ULL << 62;
+    while (bit > value) {
+        bit >>= 2;
+    }
+    while (bit != 0) {
+        if (remainder >= root + bit) {
+            remainder -= root + bit;
+            root = (root >> 1) + bit;
+        } else {
+            root >>= 1;
+        }
+        bit >>= 2;
+    }
+    return (uint32_t)root;
+}
+
+// Shifts a positive variance up by an even amount into [2^60, 2^62) and
+// returns its root, now 31 significant bits; halfShift gets the amount / 2
+static uint32_t normalisedRoot(uint64_t variance, int& halfShift) {
+    halfShift = 0;
+    while (variance < (1ULL << 60)) {
+        variance <<= 2;
+        halfShift++;
+    }
+    return isqrt64(variance);
+}
+
+int16_t correlationQ15(uint32_t n, int64_t sumX, int64_t sumXX, int64_t sumY, int64_t sumYY, int64_t sumXY) {
+    if (n < 2) {
+        return 0;
+    }
+    // Exact sums leave exact variances: zero means flat
+    int64_t varianceX = (int64_t)n * sumXX - sumX * sumX;
+    int64_t varianceY = (int64_t)n * sumYY - sumY * sumY;
+    if (varianceX <= 0 || varianceY <= 0) {
+        return 0;
+    }
+    int64_t covariance = (int64_t)n * sumXY - sumX * sumY;
+
+    // r = cov / sqrt(varX * varY). With both roots normalised the
+    // denominator fills 61..62 bits, and Cauchy-Schwarz keeps the covariance,
+    // shifted by as much, below it
+    int shiftX, shiftY;
+    uint64_t denominator = (uint64_t)normalisedRoot((uint64_t)varianceX, shiftX) *
+                           normalisedRoot((uint64_t)varianceY, shiftY);
+    uint64_t magnitude = (uint64_t)(covariance < 0 ? -covariance : covariance) << (shiftX + shiftY);
+    uint64_t r = magnitude / (denominator >> 15);
+    if (r > 32767) r = 32767;
+    return covariance < 0 ? -(int16_t)r : (int16_t)r;
+}
@@ -0,0 +1,72 @@
+#include "dsp/heart_rate_fusion.h"
+#include <math.h>
+
+const char* heartRateSourceName(HeartRateSource source) {
+    switch (source) {
+        case HR_SOURCE_ECG: return "ecg";
+        case HR_SOURCE_PPG_SPECTRAL: return "ppg_spectral";
+        case HR_SOURCE_PPG_MAXIM: return "ppg_maxim";
+        default: return "unknown";
+    }
+}
+
+HeartRateFusion::HeartRateFusion(uint32_t maxAgeMs) : maxAgeUs((uint64_t)maxAgeMs * 1000) {
+    reset();
+}
+
+void HeartRateFusion::reset() {
+    for (uint8_t i = 0; i < HR_SOURCE_COUNT; i++) {
+        estimates[i] = {0, 0, 0, false};
+    }
+}
+
+void HeartRateFusion::update(HeartRateSource source, float bpm, float confidence, uint64_t timeUs) {
+    if (source >= HR_SOURCE_COUNT) {
+        return;
+    }
+    HeartRateEstimate& estimate = estimates[source];
+    estimate.bpm = bpm;
+    estimate.confidence = confidence < 0 ? 0 : (confidence > 1 ? 1 : confidence);
+    estimate.timeUs = timeUs;
+    estimate.valid = bpm >= MIN_BPM && bpm <= MAX_BPM && estimate.confidence > 0;
+}
+
+void HeartRateFusion::invalidate(HeartRateSource source) {
+    if (source < HR_SOURCE_COUNT) {
+        estimates[source].valid = false;
+    }
+}
+
+FusedHeartRate HeartRateFusion::fuse(uint64_t nowUs) const {
+    FusedHeartRate fused = {0, 0, 0, false};
+
+    // Stale sources (leads off, finger lifted, estimator starved) drop out
+    bool fresh[HR_SOURCE_COUNT];
+    int anchor = -1;
+    for (uint8_t i = 0; i < HR_SOURCE_COUNT; i++) {
+        const HeartRateEstimate& e = estimates[i];
+        fresh[i] = e.valid && (nowUs < e.timeUs || nowUs - e.timeUs <= maxAgeUs);
+        if (fresh[i] && (anchor < 0 || e.confidence > estimates[anchor].confidence)) {
+            anchor = i;
+        }
+    }
+    if (anchor < 0) {
+        return fused;
+    }
+
+    float weighted = 0;
+    float weights = 0;
+    for (uint8_t i = 0; i < HR_SOURCE_COUNT; i++) {
+        const HeartRateEstimate& e = estimates[i];
+        if (!fresh[i] || fabsf(e.bpm - estimates[anchor].bpm) > AGREEMENT_BPM) {
+            continue;
+        }
+        weighted += e.confidence * e.bpm;
+        weights += e.confidence;
+        fused.sources |= 1 << i;
+    }
+    fused.bpm = weighted / weights;
+    fused.confidence = estimates[anchor].confidence;
+    fused.valid = true;
+    return fused;
+}
@@ -0,0 +1,241 @@
+#include "dsp/hrv_engine.h"
+#include <math.h>
+
+static const uint32_t MIN_RR_US = 300000;           // 200 BPM
+static const uint32_t MAX_RR_US = 2000000;          // 30 BPM
+static const uint32_t NN50_US = 50000;
+static const int MAX_REJECT_RUN = 3;
+static const uint32_t MIN_SPECTRUM_INTERVALS = 32;
+static const uint64_t MIN_SPECTRUM_SPAN_US = 60000000;  // 2.4 cycles of the lowest LF frequency
+
+static const double TWO_PI = 6.283185307179586;
+
+HrvEngine::HrvEngine(uint32_t spectrumIntervalMs) : spectrumIntervalUs((uint64_t)spectrumIntervalMs * 1000) {
+    reset();
+}
+
+void HrvEngine::reset() {
+    for (uint32_t i = 0; i < WINDOW; i++) {
+        window[i] = {0, 0, 0, false};
+    }
+    head = 0;
+    count = 0;
+
+    sumRR = 0;
+    sumRR2 = 0;
+    sumDiff2 = 0;
+    diffCount = 0;
+    nn50Count = 0;
+
+    for (uint32_t k = 0; k < BINS; k++) {
+        bins[k] = {0, 0, 0, 0, 0, 0};
+    }
+    sumY = 0;
+
+    haveLastBeat = false;
+    lastBeatUs = 0;
+    lastAcceptedUs = 0;
+    previousAccepted = false;
+    rejectRun = 0;
+    rejected = 0;
+
+    lastSpectrumUs = 0;
+    metrics = {0, 0, 0, 0, 0, false, 0, 0, 0};
+}
+
+bool HrvEngine::addBeat(uint64_t timeUs) {
+    if (!haveLastBeat || timeUs <= lastBeatUs) {
+        haveLastBeat = true;
+        lastBeatUs = timeUs;
+        previousAccepted = false;
+        return false;
+    }
+    uint64_t rr = timeUs - lastBeatUs;
+    lastBeatUs = timeUs;
+
+    // Missed beats or a noise trigger: nothing to compare the next one with
+    if (rr < MIN_RR_US || rr > MAX_RR_US) {
+        lastAcceptedUs = 0;
+        previousAccepted = false;
+        rejectRun = 0;
+        rejected++;
+        return false;
+    }
+
+    // Ectopic beat (or its compensatory pause) unless it keeps up
+    uint32_t rrUs = (uint32_t)rr;
+    if (lastAcceptedUs > 0 && rejectRun < MAX_REJECT_RUN) {
+        uint32_t change = rrUs > lastAcceptedUs ? rrUs - lastAcceptedUs : lastAcceptedUs - rrUs;
+        if (change > lastAcceptedUs / 5) {
+            previousAccepted = false;
+            rejectRun++;
+            rejected++;
+            return false;
+        }
+    }
+
+    addInterval(timeUs, rrUs);
+    lastAcceptedUs = rrUs;
+    previousAccepted = true;
+    rejectRun = 0;
+    return true;
+}
+
+void HrvEngine::addInterval(uint64_t timeUs, uint32_t rrUs) {
+    if (count == WINDOW) {
+        evictOldest();
+    }
+
+    Interval& interval = window[(head + count) % WINDOW];
+    interval.timeUs = timeUs;
+    interval.rrUs = rrUs;
+    interval.hasDiff = previousAccepted;
+    interval.diffUs = (int32_t)rrUs - (int32_t)lastAcceptedUs;
+    count++;
+
+    sumRR += rrUs;
+    sumRR2 += (uint64_t)rrUs * rrUs;
+    if (interval.hasDiff) {
+        uint32_t magnitude = interval.diffUs < 0 ? -interval.diffUs : interval.diffUs;
+        sumDiff2 += (uint64_t)magnitude * magnitude;
+        diffCount++;
+        if (magnitude > NN50_US) nn50Count++;
+    }
+    updateSpectrumSums(interval, 1.0);
+
+    updateTimeDomain();
+    if (timeUs - lastSpectrumUs >= spectrumIntervalUs) {
+        updateSpectrum();
+        lastSpectrumUs = timeUs;
+    }
+}
+
+void HrvEngine::evictOldest() {
+    Interval& oldest = window[head];
+    sumRR -= oldest.rrUs;
+    sumRR2 -= (uint64_t)oldest.rrUs * oldest.rrUs;
+    updateSpectrumSums(oldest, -1.0);
+    head = (head + 1) % WINDOW;
+    count--;
+
+    // The next one's difference was taken from the interval just evicted
+    Interval& next = window[head];
+    if (count > 0 && next.hasDiff) {
+        uint32_t magnitude = next.diffUs < 0 ? -next.diffUs : next.diffUs;
+        sumDiff2 -= (uint64_t)magnitude * magnitude;
+        diffCount--;
+        if (magnitude > NN50_US) nn50Count--;
+        next.hasDiff = false;
+    }
+}
+
+void HrvEngine::updateSpectrumSums(const Interval& interval, double sign) {
+    // Phase of the 1/256 Hz grid step at this beat, reduced in integers so
+    // it stays exact however long the device has been up
+    const uint64_t periodUs = (uint64_t)SPECTRUM_PERIOD_S * 1000000;
+    uint64_t phaseUs = interval.timeUs % periodUs;
+    double step = TWO_PI * (double)phaseUs / (double)periodUs;
+    double first = TWO_PI * (double)((phaseUs * FIRST_BIN) % periodUs) / (double)periodUs;
+
+    double y = interval.rrUs / 1000.0;
+    double stepCos = cos(step);
+    double stepSin = sin(step);
+    double c = cos(first);
+    double s = sin(first);
+    sumY += sign * y;
+    for (uint32_t k = 0; k < BINS; k++) {
+        Bin& bin = bins[k];
+        bin.yCos += sign * y * c;
+        bin.ySin += sign * y * s;
+        bin.cos1 += sign * c;
+        bin.sin1 += sign * s;
+        bin.cos2 += sign * (c * c - s * s);
+        bin.sin2 += sign * 2.0 * c * s;
+
+        // Next frequency: rotate by one grid step
+        double nextCos = c * stepCos - s * stepSin;
+        s = s * stepCos + c * stepSin;
+        c = nextCos;
+    }
+}
+
+void HrvEngine::updateTimeDomain() {
+    metrics.intervals = count;
+    if (count == 0) {
+        metrics.meanRRMs = 0;
+        metrics.sdnnMs = 0;
+        metrics.rmssdMs = 0;
+        metrics.pnn50 = 0;
+        return;
+    }
+    metrics.meanRRMs = (float)((double)sumRR / count / 1000.0);
+    if (count > 1) {
+        // Exact in integers: n * sum(x^2) - sum(x)^2
+        uint64_t spread = (uint64_t)count * sumRR2 - sumRR * sumRR;
+        metrics.sdnnMs = (float)(sqrt((double)spread / ((double)count * (count - 1))) / 1000.0);
+    } else {
+        metrics.sdnnMs = 0;
+    }
+    if (diffCount > 0) {
+        metrics.rmssdMs = (float)(sqrt((double)sumDiff2 / diffCount) / 1000.0);
+        metrics.pnn50 = 100.0f * nn50Count / diffCount;
+    } else {
+        metrics.rmssdMs = 0;
+        metrics.pnn50 = 0;
+    }
+}
+
+float HrvEngine::spectrumAt(uint32_t binIndex) const {
+    if (binIndex < FIRST_BIN || binIndex > LAST_BIN || count < 2) {
+        return 0;
+    }
+    const Bin& bin = bins[binIndex - FIRST_BIN];
+    double n = count;
+    double mean = sumY / n;
+    double yc = bin.yCos - mean * bin.cos1;
+    double ys = bin.ySin - mean * bin.sin1;
+
+    // tau puts the beats' phases in quadrature: derive cos/sin(w tau) from
+    // the 2w sums without an arctangent (the sign of tau doesn't matter)
+    double spread = sqrt(bin.cos2 * bin.cos2 + bin.sin2 * bin.sin2);
+    double cos2Tau = spread > 1e-9 * n ? bin.cos2 / spread : 1.0;
+    double cosTau = sqrt((1.0 + cos2Tau) * 0.5);
+    double sinTau = sqrt((1.0 - cos2Tau) * 0.5);
+    if (bin.sin2 < 0) sinTau = -sinTau;
+
+    double cosSquares = 0.5 * (n + spread);
+    double sinSquares = 0.5 * (n - spread);
+    double inPhase = yc * cosTau + ys * sinTau;
+    double quadrature = ys * cosTau - yc * sinTau;
+    double power = inPhase * inPhase / cosSquares;
+    if (sinSquares > 1e-9 * n) {
+        power += quadrature * quadrature / sinSquares;
+    }
+    power *= 0.5;
+
+    // Scaled to a density: a sinusoid's bins then sum to its variance
+    double spanS = (window[(head + count - 1) % WINDOW].timeUs - window[head].timeUs) / 1e6;
+    return (float)(power * 2.0 * spanS / n);
+}
+
+void HrvEngine::updateSpectrum() {
+    uint64_t spanUs = count > 1 ? window[(head + count - 1) % WINDOW].timeUs - window[head].timeUs : 0;
+    metrics.spectrumValid = count >= MIN_SPECTRUM_INTERVALS && spanUs >= MIN_SPECTRUM_SPAN_US;
+    if (!metrics.spectrumValid) {
+        metrics.lfPower = 0;
+        metrics.hfPower = 0;
+        metrics.lfHfRatio = 0;
+        return;
+    }
+
+    const float binWidthHz = 1.0f / SPECTRUM_PERIOD_S;
+    float lf = 0;
+    float hf = 0;
+    for (uint32_t k = FIRST_BIN; k <= LAST_BIN; k++) {
+        if (k < LF_HF_BIN) lf += spectrumAt(k);
+        else hf += spectrumAt(k);
+    }
+    metrics.lfPower = lf * binWidthHz;
+    metrics.hfPower = hf * binWidthHz;
+    metrics.lfHfRatio = metrics.hfPower > 0 ? metrics.lfPower / metrics.hfPower : 0;
+}
@@ -0,0 +1,104 @@
+#include "dsp/peak_timing.h"
+
+float parabolicPeakOffset(float previous, float peak, float next, float* vertexValue) {
+    float curvature = previous - 2.0f * peak + next;
+    float offset = 0.0f;
+    if (curvature < 0.0f) {
+        offset = 0.5f * (previous - next) / curvature;
+        if (offset > 0.5f) offset = 0.5f;
+        if (offset < -0.5f) offset = -0.5f;
+    }
+    if (vertexValue) {
+        *vertexValue = peak - 0.25f * (previous - next) * offset;
+    }
+    return offset;
+}
+
+PeakDetector::PeakDetector(float threshold, uint32_t refractoryUs)
+    : threshold(threshold), refractoryUs(refractoryUs), interpolate(true) {
+    reset();
+}
+
+void PeakDetector::reset() {
+    for (int i = 0; i < 3; i++) {
+        values[i] = 0;
+        times[i] = 0;
+    }
+    sampleCount = 0;
+    havePeak = false;
+    lastPeakUs = 0;
+}
+
+bool PeakDetector::addSample(float value, uint64_t timestampUs, TimedPeak& peak) {
+    values[0] = values[1];
+    values[1] = values[2];
+    values[2] = value;
+    times[0] = times[1];
+    times[1] = times[2];
+    times[2] = timestampUs;
+    sampleCount++;
+
+    if (sampleCount < 3) {
+        return false;
+    }
+
+    // Middle sample is a maximum: strictly above the left, not below the right
+    // (the first sample of a flat top counts)
+    if (!(values[1] > threshold && values[1] > values[0] && values[1] >= values[2])) {
+        return false;
+    }
+
+    float vertex = values[1];
+    uint64_t peakUs = times[1];
+    if (interpolate) {
+        float offset = parabolicPeakOffset(values[0], values[1], values[2], &vertex);
+        // Scale by the spacing on the side the vertex falls, so uneven sample
+        // times (e.g. after a FIFO gap) don't skew the estimate
+        if (offset > 0.0f) {
+            peakUs += (uint64_t)(offset * (float)(times[2] - times[1]) + 0.5f);
+        } else if (offset < 0.0f) {
+            peakUs -= (uint64_t)(-offset * (float)(times[1] - times[0]) + 0.5f);
+        }
+    }
+
+    if (havePeak && peakUs - lastPeakUs < refractoryUs) {
+        return false;
+    }
+
+    havePeak = true;
+    lastPeakUs = peakUs;
+    peak.timeUs = peakUs;
+    peak.value = vertex;
+    peak.index = sampleCount - 2;
+    return true;
+}
+
+float meanPulseTransitUs(const uint64_t* rPeaksUs, size_t rCount,
+                         const uint64_t* pulsePeaksUs, size_t pulseCount,
+                         uint32_t minUs, uint32_t maxUs) {
+    double total = 0;
+    int pairs = 0;
+
+    size_t first = 0;
+    for (size_t i = 0; i < rCount; i++) {
+        uint64_t rTime = rPeaksUs[i];
+        // Pulse peaks before this R-peak can't pair with it or any later one
+        while (first < pulseCount && pulsePeaksUs[first] <= rTime) {
+            first++;
+        }
+        for (size_t j = first; j < pulseCount; j++) {
+            uint64_t delay = pulsePeaksUs[j] - rTime;
+            if (delay > maxUs) break;
+            if (delay >= minUs) {
+                total += (double)delay;
+                pairs++;
+                break; // First valid match
+            }
+        }
+    }
+
+    if (pairs == 0) {
+        return -1;
+    }
+    return (float)(total / pairs);
+}
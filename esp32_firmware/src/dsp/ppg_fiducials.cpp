@@ -0,0 +1,208 @@
+#include "dsp/ppg_fiducials.h"
+#include "dsp/peak_timing.h"
+#include <math.h>
+
+static const float UPSTROKE_SLOPE_FRACTION = 0.5f;     // Of the running max-slope level
+static const float MIN_AMPLITUDE_FRACTION = 0.33f;     // Of the running amplitude level
+static const float LEVEL_WEIGHT = 0.125f;
+
+const char* pulseFiducialName(PulseFiducial fiducial) {
+    switch (fiducial) {
+        case PulseFiducial::FOOT: return "foot";
+        case PulseFiducial::MAX_SLOPE: return "max slope";
+        case PulseFiducial::PEAK: return "peak";
+    }
+    return "unknown";
+}
+
+// All on sample time, so the stream rate can change under the detector
+static const uint32_t LEARNING_US = 1500000;           // To find the slope level
+static const uint32_t MAX_RISE_US = 300000;            // A systolic upstroke is well under this
+static const uint32_t REFRACTORY_US = 200000;          // Upstroke start after the last peak (dicrotic wave)
+static const uint32_t MISSED_BEAT_US = 2000000;        // No beat for this long: lower the levels
+
+PulseFiducialDetector::PulseFiducialDetector() : adaptive(true) {
+    reset();
+}
+
+void PulseFiducialDetector::reset() {
+    for (uint32_t i = 0; i < HISTORY; i++) {
+        history[i] = {0, 0};
+    }
+    sampleCount = 0;
+    latestTimeUs = 0;
+    firstTimeUs = 0;
+
+    learning = true;
+    slopeLevel = 0;
+    amplitudeLevel = 0;
+
+    rising = false;
+    riseStartUs = 0;
+    maxSlope = 0;
+    maxSlopeIndex = 0;
+
+    beats = 0;
+    lastPeakUs = 0;
+    lastPeakIndex = 0;
+    levelCheckUs = 0;
+}
+
+size_t PulseFiducialDetector::processBlock(const float* values, const uint64_t* timestampsUs, size_t count,
+                                           PulseFiducials* beatsOut, size_t maxBeats) {
+    size_t found = 0;
+    PulseFiducials beat;
+    for (size_t i = 0; i < count; i++) {
+        if (addSample(values[i], timestampsUs[i], beat) && found < maxBeats) {
+            beatsOut[found++] = beat;
+        }
+    }
+    return found;
+}
+
+bool PulseFiducialDetector::addSample(float value, uint64_t timestampUs, PulseFiducials& beat) {
+    uint32_t n = sampleCount;
+    history[n & (HISTORY - 1)] = {value, (uint32_t)timestampUs};
+    latestTimeUs = timestampUs;
+    sampleCount++;
+    if (n == 0) {
+        firstTimeUs = timestampUs;
+    }
+    if (n < 2) {
+        return false;
+    }
+
+    // Centred-difference slope of the previous sample
+    uint32_t k = n - 1;
+    float previous = entry(k).value;
+    float slope = (value - entry(n - 2).value) * 0.5f;
+
+    if (learning) {
+        if (slope > slopeLevel) slopeLevel = slope;
+        if (timestampUs - firstTimeUs >= LEARNING_US) {
+            learning = false;
+            levelCheckUs = timestampUs;
+        }
+        return false;
+    }
+
+    if (!rising) {
+        // Pulses got smaller (sensor pressure, vasoconstriction): meet them halfway
+        if (adaptive && timestampUs - levelCheckUs > MISSED_BEAT_US) {
+            slopeLevel *= 0.5f;
+            amplitudeLevel *= 0.5f;
+            levelCheckUs = timestampUs;
+        }
+
+        uint64_t sampleUs = fullTime(entry(k).timeLowUs);
+        bool refractory = beats > 0 && sampleUs < lastPeakUs + REFRACTORY_US;
+        if (slope > UPSTROKE_SLOPE_FRACTION * slopeLevel && !refractory) {
+            rising = true;
+            riseStartUs = sampleUs;
+            maxSlope = slope;
+            maxSlopeIndex = k;
+        }
+        return false;
+    }
+
+    if (slope > maxSlope) {
+        maxSlope = slope;
+        maxSlopeIndex = k;
+    }
+
+    // Slope turned: the systolic maximum is this sample or the one before
+    bool found = false;
+    if (slope <= 0.0f) {
+        found = finishBeat(previous >= entry(k - 1).value ? k : k - 1, beat);
+    } else if (timestampUs - riseStartUs <= MAX_RISE_US) {
+        return false;   // Still rising
+    }
+
+    // Beat done, or rising for too long to be an upstroke
+    rising = false;
+    return found;
+}
+
+bool PulseFiducialDetector::finishBeat(uint32_t peakIndex, PulseFiducials& beat) {
+    // Max slope: parabola through the slopes either side (maxSlopeIndex + 1 < sampleCount - 1 here)
+    uint32_t m = maxSlopeIndex;
+    float slopeOffset = 0.0f;
+    float steepest = maxSlope;
+    if (m >= 2) {
+        slopeOffset = parabolicPeakOffset(slopeAt(m - 1), maxSlope, slopeAt(m + 1), &steepest);
+    }
+    float slopeLevelValue = entry(m).value;
+    if (slopeOffset > 0.0f) {
+        slopeLevelValue += slopeOffset * (entry(m + 1).value - entry(m).value);
+    } else if (slopeOffset < 0.0f) {
+        slopeLevelValue += slopeOffset * (entry(m).value - entry(m - 1).value);
+    }
+
+    // Peak: parabola through the maximum
+    float peakValue = entry(peakIndex).value;
+    float peakOffset = parabolicPeakOffset(entry(peakIndex - 1).value, peakValue, entry(peakIndex + 1).value, &peakValue);
+
+    // The minimum the upstroke starts from: walk back down from the steepest
+    // point, no further than the last peak or the oldest sample still held.
+    // Bounded, and once per beat.
+    uint32_t earliest = beats > 0 ? lastPeakIndex + 1 : 0;
+    if (sampleCount > HISTORY && earliest < sampleCount - HISTORY + 1) earliest = sampleCount - HISTORY + 1;
+    uint32_t valleyIndex = m;
+    while (valleyIndex > earliest && entry(valleyIndex - 1).value < entry(valleyIndex).value) {
+        valleyIndex--;
+    }
+    float valleyValue = entry(valleyIndex).value;
+
+    float amplitude = peakValue - valleyValue;
+    if (steepest <= 0.0f || amplitude <= 0.0f ||
+        (amplitudeLevel > 0.0f && amplitude < MIN_AMPLITUDE_FRACTION * amplitudeLevel)) {
+        return false;
+    }
+
+    // Foot: the tangent at the steepest point meets the minimum's level, no
+    // earlier than the minimum itself
+    float footOffset = slopeOffset - (slopeLevelValue - valleyValue) / steepest;
+    if (footOffset < -(float)(m - valleyIndex)) footOffset = -(float)(m - valleyIndex);
+    if (footOffset > slopeOffset) footOffset = slopeOffset;
+
+    beat.footUs = timeAt(m, footOffset);
+    beat.maxSlopeUs = timeAt(m, slopeOffset);
+    beat.peakUs = timeAt(peakIndex, peakOffset);
+    beat.footValue = valleyValue;
+    beat.peakValue = peakValue;
+    uint32_t spacingUs = (uint32_t)(entry(m + 1).timeLowUs - entry(m - 1).timeLowUs) / 2;
+    beat.maxSlope = spacingUs > 0 ? steepest * 1e6f / spacingUs : 0.0f;
+    beat.peakIndex = peakIndex;
+
+    if (adaptive || beats == 0) {
+        if (amplitudeLevel <= 0.0f) amplitudeLevel = amplitude;
+        amplitudeLevel += LEVEL_WEIGHT * (amplitude - amplitudeLevel);
+        slopeLevel += LEVEL_WEIGHT * (steepest - slopeLevel);
+    }
+    beats++;
+    lastPeakUs = beat.peakUs;
+    lastPeakIndex = peakIndex;
+    levelCheckUs = latestTimeUs;
+    return true;
+}
+
+float PulseFiducialDetector::slopeAt(uint32_t index) const {
+    return (entry(index + 1).value - entry(index - 1).value) * 0.5f;
+}
+
+uint64_t PulseFiducialDetector::timeAt(uint32_t index, float offset) const {
+    // Whole samples first so the fraction stays small, then scale by that
+    // sample's actual spacing (FIFO bursts can leave uneven gaps)
+    int whole = (int)floorf(offset);
+    index += whole;
+    float fraction = offset - whole;
+    uint64_t timeUs = fullTime(entry(index).timeLowUs);
+    if (fraction > 0.0f && index + 1 < sampleCount) {
+        timeUs += (uint64_t)(fraction * (float)(uint32_t)(entry(index + 1).timeLowUs - entry(index).timeLowUs) + 0.5f);
+    }
+    return timeUs;
+}
+
+uint64_t PulseFiducialDetector::fullTime(uint32_t timeLowUs) const {
+    return latestTimeUs - (uint32_t)((uint32_t)latestTimeUs - timeLowUs);
+}
@@ -0,0 +1,313 @@
+#include "dsp/qrs_detector.h"
+#include "dsp/peak_timing.h"
+#include <math.h>
+
+// Pan-Tompkins constants
+static const float RR_LOW_LIMIT = 0.92f;        // Regular RR: 92-116% of the regular average
+static const float RR_HIGH_LIMIT = 1.16f;
+static const float RR_MISSED_LIMIT = 1.66f;     // Search back after this many average RRs
+
+QrsDetector::QrsDetector(uint32_t sampleRateHz)
+    : sampleRate(sampleRateHz < 50 ? 50 : (sampleRateHz > MAX_SAMPLE_RATE_HZ ? MAX_SAMPLE_RATE_HZ : sampleRateHz)),
+      bandpass(bandpassCoeffs) {
+    // 5-15 Hz: keeps the QRS energy, drops P/T waves, baseline and EMG
+    bandpassCoeffs[0] = BiquadDesign::highpass(5.0, sampleRate, BiquadDesign::butterworthQ(2, 0));
+    bandpassCoeffs[1] = BiquadDesign::lowpass(15.0, sampleRate, BiquadDesign::butterworthQ(2, 0));
+
+    mwiLength = (sampleRate * 150 + 500) / 1000;    // 150 ms integration window
+    searchSamples = sampleRate / 4;                 // R-peak lies within 250 ms before the integral peak
+    learningSamples = sampleRate * 2;
+    refractoryUs = 200000;
+    tWaveUs = 360000;
+    peakHoldSamples = sampleRate / 5;
+    reset();
+}
+
+void QrsDetector::reset() {
+    bandpass.reset();
+    for (uint32_t i = 0; i < HISTORY; i++) {
+        history[i] = {0, 0, 0};
+    }
+    sampleCount = 0;
+    latestTimeUs = 0;
+    for (int i = 0; i < 4; i++) {
+        derivativeInput[i] = 0;
+    }
+
+    for (uint32_t i = 0; i < MWI_MAX; i++) {
+        mwiRing[i] = 0;
+    }
+    mwiIndex = 0;
+    mwiSum = 0;
+    mwiLapSum = 0;
+    previousIntegral = 0;
+
+    peakArmed = false;
+    peakIntegral = 0;
+    peakIndex = 0;
+    deferredPending = false;
+    deferredIntegral = 0;
+    deferredIndex = 0;
+
+    learning = true;
+    learningIntegralMax = 0;
+    learningIntegralSum = 0;
+    learningBandpassedMax = 0;
+    learningBandpassedSum = 0;
+
+    signalLevelI = 0;
+    noiseLevelI = 0;
+    signalLevelF = 0;
+    noiseLevelF = 0;
+
+    beats = 0;
+    lastBeatUs = 0;
+    lastBeatSlope = 0;
+    irregular = false;
+    irregularRun = 0;
+    searchBackCandidate.valid = false;
+
+    for (int i = 0; i < RR_COUNT; i++) {
+        rrAll[i] = 0;
+        rrRegular[i] = 0;
+    }
+    rrAllCount = 0;
+    rrRegularCount = 0;
+    rrAllNext = 0;
+    rrRegularNext = 0;
+    rrAllSum = 0;
+    rrRegularSum = 0;
+    rrAverage1Us = 0;
+    rrAverage2Us = 0;
+}
+
+bool QrsDetector::addSample(float value, uint64_t timestampUs, QrsEvent& event) {
+    uint32_t n = sampleCount;
+
+    // Band-pass, five-point derivative, squaring, moving-window integration
+    float filtered = bandpass.process(value);
+    float derivative = (2.0f * filtered + derivativeInput[0] - derivativeInput[2] - 2.0f * derivativeInput[3]) * 0.125f;
+    derivativeInput[3] = derivativeInput[2];
+    derivativeInput[2] = derivativeInput[1];
+    derivativeInput[1] = derivativeInput[0];
+    derivativeInput[0] = filtered;
+    float integral = integrate(derivative * derivative);
+
+    history[n & (HISTORY - 1)] = {value, filtered, (uint32_t)timestampUs};
+    latestTimeUs = timestampUs;
+    sampleCount++;
+
+    if (learning) {
+        if (integral > learningIntegralMax) learningIntegralMax = integral;
+        learningIntegralSum += integral;
+        float magnitude = fabsf(filtered);
+        if (magnitude > learningBandpassedMax) learningBandpassedMax = magnitude;
+        learningBandpassedSum += magnitude;
+        if (sampleCount >= learningSamples) {
+            finishLearning();
+        }
+        previousIntegral = integral;
+        return false;
+    }
+
+    bool found = false;
+
+    // A peak declared while another beat was being reported
+    if (deferredPending) {
+        deferredPending = false;
+        found = classify(deferredIntegral, deferredIndex, event);
+    }
+
+    // No beat for 1.66 average RR: take the best peak above the lower thresholds
+    if (!found && searchBackCandidate.valid && beats >= 2 && rrAverage2Us > 0 &&
+        timestampUs - lastBeatUs > (uint64_t)(RR_MISSED_LIMIT * rrAverage2Us)) {
+        acceptBeat(searchBackCandidate, true, event);
+        found = true;
+    }
+
+    // Peak of the integral: the largest value before it falls to half, or
+    // before it has stopped rising for 200 ms
+    bool declare = false;
+    if (!peakArmed) {
+        if (integral > previousIntegral) {
+            peakArmed = true;
+            peakIntegral = integral;
+            peakIndex = n;
+        }
+    } else if (integral > peakIntegral) {
+        peakIntegral = integral;
+        peakIndex = n;
+    } else if (integral < 0.5f * peakIntegral || n - peakIndex >= peakHoldSamples) {
+        declare = true;
+        peakArmed = false;
+    }
+    previousIntegral = integral;
+
+    if (declare) {
+        if (found) {
+            deferredPending = true;
+            deferredIntegral = peakIntegral;
+            deferredIndex = peakIndex;
+        } else {
+            found = classify(peakIntegral, peakIndex, event);
+        }
+    }
+    return found;
+}
+
+float QrsDetector::integrate(float squared) {
+    mwiSum += squared - mwiRing[mwiIndex];
+    mwiRing[mwiIndex] = squared;
+    mwiLapSum += squared;
+    if (++mwiIndex >= mwiLength) {
+        // The ring now holds exactly this lap: drop the running sum's rounding drift
+        mwiIndex = 0;
+        mwiSum = mwiLapSum;
+        mwiLapSum = 0;
+    }
+    return mwiSum / mwiLength;
+}
+
+void QrsDetector::finishLearning() {
+    learning = false;
+    signalLevelI = 0.5f * learningIntegralMax;
+    noiseLevelI = learningIntegralSum / sampleCount;
+    signalLevelF = 0.5f * learningBandpassedMax;
+    noiseLevelF = learningBandpassedSum / sampleCount;
+}
+
+bool QrsDetector::classify(float integral, uint32_t index, QrsEvent& event) {
+    Candidate candidate = locate(integral, index);
+
+    // Still the beat that was just reported (or a wide QRS's second hump)
+    if (beats > 0 && candidate.timeUs < lastBeatUs + refractoryUs) {
+        return false;
+    }
+
+    float thresholdI1 = noiseLevelI + 0.25f * (signalLevelI - noiseLevelI);
+    float thresholdF1 = noiseLevelF + 0.25f * (signalLevelF - noiseLevelF);
+    if (irregular) {
+        thresholdI1 *= 0.5f;
+        thresholdF1 *= 0.5f;
+    }
+    float thresholdI2 = 0.5f * thresholdI1;
+    float thresholdF2 = 0.5f * thresholdF1;
+
+    bool tWave = beats > 0 && candidate.timeUs - lastBeatUs < tWaveUs && candidate.slope < 0.5f * lastBeatSlope;
+    if (!tWave && candidate.integral > thresholdI1 && candidate.bandpassedPeak > thresholdF1) {
+        acceptBeat(candidate, false, event);
+        return true;
+    }
+
+    noiseLevelI = 0.125f * candidate.integral + 0.875f * noiseLevelI;
+    noiseLevelF = 0.125f * candidate.bandpassedPeak + 0.875f * noiseLevelF;
+
+    if (!tWave && candidate.integral > thresholdI2 && candidate.bandpassedPeak > thresholdF2 &&
+        (!searchBackCandidate.valid || candidate.integral > searchBackCandidate.integral)) {
+        searchBackCandidate = candidate;
+    }
+    return false;
+}
+
+QrsDetector::Candidate QrsDetector::locate(float integral, uint32_t index) const {
+    // Bounded search: at most searchSamples entries, once per integral peak
+    uint32_t oldest = sampleCount > HISTORY ? sampleCount - HISTORY + 1 : 1;
+    uint32_t first = index > searchSamples ? index - searchSamples : 0;
+    if (first < oldest) first = oldest;
+    if (index + 1 >= sampleCount) index = sampleCount - 2;
+
+    Candidate candidate = {true, integral, 0, 0, first, 0, 0};
+    float best = -1;
+    for (uint32_t i = first; i <= index; i++) {
+        const HistoryEntry& current = entry(i);
+        float magnitude = fabsf(current.input);
+        if (magnitude > best) {
+            best = magnitude;
+            candidate.index = i;
+        }
+        float bandpassed = fabsf(current.bandpassed);
+        if (bandpassed > candidate.bandpassedPeak) candidate.bandpassedPeak = bandpassed;
+        float slope = fabsf(current.bandpassed - entry(i - 1).bandpassed);
+        if (slope > candidate.slope) candidate.slope = slope;
+    }
+
+    // Parabolic vertex on the R-wave, whichever way the lead points
+    const HistoryEntry& previous = entry(candidate.index - 1);
+    const HistoryEntry& peak = entry(candidate.index);
+    const HistoryEntry& next = entry(candidate.index + 1);
+    float sign = peak.input < 0 ? -1.0f : 1.0f;
+    float vertex = 0;
+    float offset = parabolicPeakOffset(sign * previous.input, sign * peak.input, sign * next.input, &vertex);
+    candidate.amplitude = sign * vertex;
+
+    uint64_t peakUs = fullTime(peak.timeLowUs);
+    if (offset > 0.0f) {
+        peakUs += (uint64_t)(offset * (float)(uint32_t)(next.timeLowUs - peak.timeLowUs) + 0.5f);
+    } else if (offset < 0.0f) {
+        peakUs -= (uint64_t)(-offset * (float)(uint32_t)(peak.timeLowUs - previous.timeLowUs) + 0.5f);
+    }
+    candidate.timeUs = peakUs;
+    return candidate;
+}
+
+void QrsDetector::acceptBeat(const Candidate& beat, bool searchBack, QrsEvent& event) {
+    // Beats found by search-back pull the signal levels down faster
+    float weight = searchBack ? 0.25f : 0.125f;
+    signalLevelI = weight * beat.integral + (1.0f - weight) * signalLevelI;
+    signalLevelF = weight * beat.bandpassedPeak + (1.0f - weight) * signalLevelF;
+
+    float rrMs = 0;
+    if (beats > 0) {
+        uint32_t rrUs = (uint32_t)(beat.timeUs - lastBeatUs);
+        rrMs = rrUs / 1000.0f;
+        updateRR(rrUs);
+    }
+
+    beats++;
+    lastBeatUs = beat.timeUs;
+    lastBeatSlope = beat.slope;
+    searchBackCandidate.valid = false;
+
+    event.timeUs = beat.timeUs;
+    event.amplitude = beat.amplitude;
+    event.index = beat.index;
+    event.rrMs = rrMs;
+    event.searchBack = searchBack;
+}
+
+void QrsDetector::updateRR(uint32_t rrUs) {
+    rrAllSum = rrAllSum + rrUs - rrAll[rrAllNext];
+    rrAll[rrAllNext] = rrUs;
+    rrAllNext = (rrAllNext + 1) % RR_COUNT;
+    if (rrAllCount < RR_COUNT) rrAllCount++;
+    rrAverage1Us = (float)rrAllSum / rrAllCount;
+
+    bool regular = rrRegularCount == 0 ||
+                   (rrUs >= RR_LOW_LIMIT * rrAverage2Us && rrUs <= RR_HIGH_LIMIT * rrAverage2Us);
+    if (regular) {
+        irregular = false;
+        irregularRun = 0;
+        rrRegularSum = rrRegularSum + rrUs - rrRegular[rrRegularNext];
+        rrRegular[rrRegularNext] = rrUs;
+        rrRegularNext = (rrRegularNext + 1) % RR_COUNT;
+        if (rrRegularCount < RR_COUNT) rrRegularCount++;
+        rrAverage2Us = (float)rrRegularSum / rrRegularCount;
+    } else {
+        irregular = true;
+        // Eight irregular intervals in a row: the rate has moved, start over from them
+        if (++irregularRun >= RR_COUNT) {
+            for (int i = 0; i < RR_COUNT; i++) {
+                rrRegular[i] = rrAll[i];
+            }
+            rrRegularSum = rrAllSum;
+            rrRegularCount = rrAllCount;
+            rrRegularNext = rrAllNext;
+            rrAverage2Us = rrAverage1Us;
+            irregularRun = 0;
+        }
+    }
+}
+
+uint64_t QrsDetector::fullTime(uint32_t timeLowUs) const {
+    return latestTimeUs - (uint32_t)((uint32_t)latestTimeUs - timeLowUs);
+}
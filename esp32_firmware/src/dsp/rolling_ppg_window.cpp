@@ -0,0 +1,80 @@
+#include "dsp/rolling_ppg_window.h"
+#include <string.h>
+
+RollingPPGWindow::RollingPPGWindow() {
+    reset();
+}
+
+void RollingPPGWindow::reset() {
+    memset(irBuffer, 0, sizeof(irBuffer));
+    memset(redBuffer, 0, sizeof(redBuffer));
+    count = 0;
+    fresh = 0;
+    binOpen = false;
+    bin = 0;
+    redSum = 0;
+    irSum = 0;
+    binCount = 0;
+    windows = 0;
+}
+
+bool RollingPPGWindow::addSample(uint32_t red, uint32_t ir, uint64_t timestampUs) {
+    uint32_t sampleBin = (uint32_t)(timestampUs / BIN_US);
+    if (!binOpen) {
+        binOpen = true;
+        bin = sampleBin;
+    }
+
+    bool ready = false;
+    int32_t ahead = (int32_t)(sampleBin - bin);
+    if (ahead > 0) {
+        uint32_t redMean = (uint32_t)(redSum / binCount);
+        uint32_t irMean = (uint32_t)(irSum / binCount);
+        ready = pushBin(redMean, irMean);
+        if ((uint32_t)ahead > MAX_GAP_BINS + 1) {
+            count = 0;
+            fresh = 0;
+            ready = false;
+        } else {
+            for (int32_t missing = 1; missing < ahead; missing++) {
+                ready |= pushBin(redMean, irMean);
+            }
+        }
+        bin = sampleBin;
+        redSum = 0;
+        irSum = 0;
+        binCount = 0;
+    } else if (ahead < 0) {
+        // Source clock went backwards
+        count = 0;
+        fresh = 0;
+        bin = sampleBin;
+        redSum = 0;
+        irSum = 0;
+        binCount = 0;
+    }
+
+    redSum += red;
+    irSum += ir;
+    binCount++;
+    return ready;
+}
+
+bool RollingPPGWindow::pushBin(uint32_t red, uint32_t ir) {
+    if (count == CAPACITY) {
+        memmove(irBuffer, irBuffer + STEP, LENGTH * sizeof(uint32_t));
+        memmove(redBuffer, redBuffer + STEP, LENGTH * sizeof(uint32_t));
+        count = LENGTH;
+    }
+    irBuffer[count] = ir;
+    redBuffer[count] = red;
+    count++;
+    fresh++;
+
+    if (count < LENGTH || fresh < STEP) {
+        return false;
+    }
+    fresh = 0;
+    windows++;
+    return true;
+}
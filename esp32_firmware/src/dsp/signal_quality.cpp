@@ -0,0 +1,222 @@
+#include "dsp/signal_quality.h"
+#include <math.h>
+
+SignalQualityEngine::SignalQualityEngine(const SignalQualityConfig& config) : config(config) {
+    if (this->config.templateSamples > MAX_TEMPLATE) {
+        this->config.templateSamples = MAX_TEMPLATE;
+    }
+    if (this->config.templateLead >= this->config.templateSamples) {
+        this->config.templateLead = 0;
+    }
+    reset();
+}
+
+void SignalQualityEngine::reset() {
+    index = {0, 0, 0, 0, 0, 0, 0, false};
+    samples = 0;
+    lastUs = 0;
+    pendingCount = 0;
+    templateBeats = 0;
+    for (uint32_t i = 0; i < MAX_TEMPLATE; i++) {
+        beatTemplate[i] = 0;
+    }
+    clearWindow();
+}
+
+void SignalQualityEngine::clearWindow() {
+    count = 0;
+    mean = 0;
+    m2 = 0;
+    m3 = 0;
+    m4 = 0;
+    minimum = 0;
+    maximum = 0;
+    rawSum = 0;
+    rawCount = 0;
+    clippedCount = 0;
+    matchSum = 0;
+    matchedBeats = 0;
+}
+
+void SignalQualityEngine::addRaw(float raw, bool clipped) {
+    rawSum += raw;
+    rawCount++;
+    if (clipped) {
+        clippedCount++;
+    }
+}
+
+void SignalQualityEngine::addRawBlock(const float* raw, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        addRaw(raw[i], raw[i] <= config.railLow || raw[i] >= config.railHigh);
+    }
+}
+
+bool SignalQualityEngine::addSample(float value, uint64_t timestampUs) {
+    // Central moments, updated in one pass without keeping the window
+    uint32_t previous = count++;
+    float delta = value - mean;
+    float deltaN = delta / count;
+    float deltaN2 = deltaN * deltaN;
+    float term = delta * deltaN * previous;
+    mean += deltaN;
+    m4 += term * deltaN2 * ((float)count * count - 3.0f * count + 3.0f) + 6.0f * deltaN2 * m2 - 4.0f * deltaN * m3;
+    m3 += term * deltaN * (count - 2.0f) - 3.0f * deltaN * m2;
+    m2 += term;
+    if (previous == 0 || value < minimum) minimum = value;
+    if (previous == 0 || value > maximum) maximum = value;
+
+    history[samples % HISTORY] = value;
+    samples++;
+    lastUs = timestampUs;
+    if (pendingCount > 0) {
+        matchReadyBeats();
+    }
+
+    if (config.windowSamples > 0 && count >= config.windowSamples) {
+        return publish();
+    }
+    return false;
+}
+
+bool SignalQualityEngine::addBlock(const float* values, const uint64_t* timestampsUs, size_t n) {
+    bool published = false;
+    for (size_t i = 0; i < n; i++) {
+        published |= addSample(values[i], timestampsUs[i]);
+    }
+    return published;
+}
+
+void SignalQualityEngine::addBeat(uint64_t timeUs) {
+    if (samples == 0 || config.sampleRateHz <= 0) {
+        return;
+    }
+    // Back from the newest sample by the time between them
+    int64_t behindUs = (int64_t)(lastUs - timeUs);
+    int32_t behind = (int32_t)lroundf(behindUs * config.sampleRateHz * 1e-6f);
+    addBeatAt(samples - 1 - behind);
+}
+
+void SignalQualityEngine::addBeatAt(uint32_t sample) {
+    if (config.templateSamples == 0) {
+        return;
+    }
+    uint32_t start = sample - config.templateLead;
+    // Gone from the history, or before the first sample
+    int32_t behind = (int32_t)(samples - start);
+    uint32_t kept = samples < HISTORY ? samples : HISTORY;
+    if (behind > (int32_t)kept) {
+        return;
+    }
+    if (pendingCount == MAX_PENDING) {
+        // Beats faster than templates complete: keep the newest
+        for (uint32_t i = 1; i < MAX_PENDING; i++) pending[i - 1] = pending[i];
+        pendingCount--;
+    }
+    pending[pendingCount++] = start;
+    matchReadyBeats();
+}
+
+void SignalQualityEngine::matchReadyBeats() {
+    uint32_t kept = 0;
+    for (uint32_t i = 0; i < pendingCount; i++) {
+        uint32_t start = pending[i];
+        if ((int32_t)(samples - start) >= (int32_t)config.templateSamples) {
+            matchBeat(start);
+        } else {
+            pending[kept++] = start;
+        }
+    }
+    pendingCount = kept;
+}
+
+void SignalQualityEngine::matchBeat(uint32_t start) {
+    uint32_t length = config.templateSamples;
+    float beat[MAX_TEMPLATE];
+    for (uint32_t i = 0; i < length; i++) {
+        beat[i] = history[(start + i) % HISTORY];
+    }
+
+    if (templateBeats > 0) {
+        // Pearson correlation with the template: shape, not size or offset
+        float sumA = 0, sumB = 0;
+        for (uint32_t i = 0; i < length; i++) {
+            sumA += beat[i];
+            sumB += beatTemplate[i];
+        }
+        float meanA = sumA / length;
+        float meanB = sumB / length;
+        float ab = 0, aa = 0, bb = 0;
+        for (uint32_t i = 0; i < length; i++) {
+            float a = beat[i] - meanA;
+            float b = beatTemplate[i] - meanB;
+            ab += a * b;
+            aa += a * a;
+            bb += b * b;
+        }
+        matchSum += (aa > 0 && bb > 0) ? ab / sqrtf(aa * bb) : 0;
+        matchedBeats++;
+    }
+
+    // Running average of the recent beats
+    if (templateBeats < TEMPLATE_BEATS) {
+        templateBeats++;
+    }
+    float weight = 1.0f / templateBeats;
+    for (uint32_t i = 0; i < length; i++) {
+        beatTemplate[i] += (beat[i] - beatTemplate[i]) * weight;
+    }
+}
+
+bool SignalQualityEngine::endWindow() {
+    pendingCount = 0;
+    if (count == 0) {
+        return false;
+    }
+    return publish();
+}
+
+bool SignalQualityEngine::publish() {
+    index.kurtosis = m2 > 0 ? count * m4 / (m2 * m2) : 0;
+    index.skewness = m2 > 0 ? sqrtf((float)count) * m3 / (m2 * sqrtf(m2)) : 0;
+    float dc = rawCount > 0 ? (float)(rawSum / rawCount) : 0;
+    index.perfusionIndex = (config.kind == SignalKind::PPG && dc > 0) ? (maximum - minimum) / dc * 100.0f : 0;
+    index.templateMatch = matchedBeats > 0 ? matchSum / matchedBeats : 0;
+    index.clippingRatio = rawCount > 0 ? (float)clippedCount / rawCount : 0;
+    index.beats = matchedBeats;
+    index.valid = true;
+    index.score = score();
+    clearWindow();
+    return true;
+}
+
+// 0 at bad, 1 at good, linear between (either way round)
+static float ramp(float value, float bad, float good) {
+    float t = (value - bad) / (good - bad);
+    return t < 0 ? 0 : (t > 1 ? 1 : t);
+}
+
+float SignalQualityEngine::score() const {
+    float worst = ramp(index.clippingRatio, 0.05f, 0.0f);
+    switch (config.kind) {
+        case SignalKind::ECG:
+            // QRS complexes make a peaky distribution; beats must repeat
+            worst = fminf(worst, ramp(index.kurtosis, 3.0f, 5.0f));
+            worst = fminf(worst, index.beats >= 2 ? ramp(index.templateMatch, 0.5f, 0.9f) : 0.0f);
+            break;
+        case SignalKind::PPG:
+            // Fast upstroke, slow runoff; a pulse the photodiode can resolve
+            worst = fminf(worst, ramp(index.skewness, 0.0f, 0.3f));
+            worst = fminf(worst, ramp(index.perfusionIndex, 0.05f, 0.2f));
+            worst = fminf(worst, index.beats >= 2 ? ramp(index.templateMatch, 0.5f, 0.9f) : 0.0f);
+            break;
+        case SignalKind::BIA:
+            // A sweep may lose a point; its shape should match the last ones
+            worst = ramp(index.clippingRatio, 0.6f, 0.0f);
+            if (index.beats > 0) {
+                worst = fminf(worst, ramp(index.templateMatch, 0.8f, 0.95f));
+            }
+            break;
+    }
+    return worst * 100.0f;
+}
@@ -0,0 +1,215 @@
+#include "dsp/spectral_hr.h"
+#include "dsp/peak_timing.h"
+#include <math.h>
+
+static const float BIN_SECONDS = SpectralHeartRate::BIN_US / 1e6f;
+static const float BPM_PER_BIN = 60.0f / (BIN_SECONDS * SpectralHeartRate::FFT_SIZE);
+static const float DC_ALPHA = BIN_SECONDS / 1.5f;         // 1.5 s time constant
+static const float AC_ALPHA = BIN_SECONDS / 4.0f;         // 4 s time constant
+static const float CANDIDATE_FRACTION = 0.3f;             // Of the strongest peak
+static const float SUBHARMONIC_FRACTION = 0.5f;           // Fundamental under a stronger second harmonic
+static const float TRACK_BPM = 12.0f;
+static const float MIN_CONFIDENCE = 0.25f;
+static const float MIN_RATIO = 0.3f;                      // SpO2 100% on the curve
+static const float MAX_RATIO = 1.2f;                      // SpO2 66% on the curve
+
+SpectralHeartRate::SpectralHeartRate() {
+    // Periodic Hann, tabulated once
+    for (uint32_t i = 0; i < WINDOW; i++) {
+        window[i] = (float)(0.5 - 0.5 * cos(2.0 * 3.14159265358979323846 * i / WINDOW));
+    }
+    reset();
+}
+
+void SpectralHeartRate::reset() {
+    restart();
+    for (uint32_t k = 0; k < FFT_SIZE / 2; k++) {
+        power[k] = 0;
+    }
+    estimate = {0, 0, 0, 0, false, false, 0};
+}
+
+void SpectralHeartRate::restart() {
+    for (uint32_t i = 0; i < WINDOW; i++) {
+        ring[i] = 0;
+    }
+    head = 0;
+    filled = 0;
+    sinceAnalysis = 0;
+
+    binOpen = false;
+    bin = 0;
+    redSum = 0;
+    irSum = 0;
+    binCount = 0;
+    lastRed = 0;
+    lastIr = 0;
+
+    levelsPrimed = false;
+    dcRed = 0;
+    dcIr = 0;
+    acPowerRed = 0;
+    acPowerIr = 0;
+}
+
+bool SpectralHeartRate::addSample(uint32_t red, uint32_t ir, uint64_t timestampUs) {
+    uint32_t sampleBin = (uint32_t)(timestampUs / BIN_US);
+    if (!binOpen) {
+        binOpen = true;
+        bin = sampleBin;
+    }
+
+    bool analysed = false;
+    int32_t ahead = (int32_t)(sampleBin - bin);
+    if (ahead > 0) {
+        // Close the bin, then hold its level across a short gap
+        lastRed = (float)redSum / binCount;
+        lastIr = (float)irSum / binCount;
+        analysed = pushBin(lastRed, lastIr);
+        if ((uint32_t)ahead > MAX_GAP_BINS + 1) {
+            restart();
+            binOpen = true;
+        } else {
+            for (int32_t missing = 1; missing < ahead; missing++) {
+                analysed |= pushBin(lastRed, lastIr);
+            }
+        }
+        bin = sampleBin;
+        redSum = 0;
+        irSum = 0;
+        binCount = 0;
+    } else if (ahead < 0) {
+        // Source clock went backwards
+        restart();
+        binOpen = true;
+        bin = sampleBin;
+    }
+
+    redSum += red;
+    irSum += ir;
+    binCount++;
+    return analysed;
+}
+
+size_t SpectralHeartRate::addBlock(const PPGSample* samples, size_t count) {
+    size_t analyses = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (addSample(samples[i].red, samples[i].ir, samples[i].timestampUs)) {
+            analyses++;
+        }
+    }
+    return analyses;
+}
+
+bool SpectralHeartRate::pushBin(float red, float ir) {
+    if (!levelsPrimed) {
+        levelsPrimed = true;
+        dcRed = red;
+        dcIr = ir;
+    }
+    dcRed += DC_ALPHA * (red - dcRed);
+    dcIr += DC_ALPHA * (ir - dcIr);
+    float acRed = red - dcRed;
+    float acIr = ir - dcIr;
+    acPowerRed += AC_ALPHA * (acRed * acRed - acPowerRed);
+    acPowerIr += AC_ALPHA * (acIr * acIr - acPowerIr);
+
+    ring[head] = ir;
+    head = (head + 1) % WINDOW;
+    if (filled < WINDOW) filled++;
+    sinceAnalysis++;
+
+    if (filled < WINDOW || sinceAnalysis < HOP) {
+        return false;
+    }
+    sinceAnalysis = 0;
+    analyse();
+    return true;
+}
+
+uint32_t SpectralHeartRate::strongestPeak(uint32_t low, uint32_t high) const {
+    if (low < LOW_BIN) low = LOW_BIN;
+    if (high > HIGH_BIN) high = HIGH_BIN;
+    uint32_t best = 0;
+    for (uint32_t k = low; k <= high; k++) {
+        bool localMax = power[k] >= power[k - 1] && power[k] > power[k + 1];
+        if (localMax && (best == 0 || power[k] > power[best])) {
+            best = k;
+        }
+    }
+    return best;
+}
+
+void SpectralHeartRate::analyse() {
+    // Mean removed before windowing, so DC leakage can't mask a slow pulse
+    float mean = 0;
+    for (uint32_t i = 0; i < WINDOW; i++) {
+        mean += ring[i];
+    }
+    mean /= WINDOW;
+    for (uint32_t i = 0; i < WINDOW; i++) {
+        re[i] = (ring[(head + i) % WINDOW] - mean) * window[i];
+        im[i] = 0;
+    }
+    for (uint32_t i = WINDOW; i < FFT_SIZE; i++) {
+        re[i] = 0;
+        im[i] = 0;
+    }
+    fft.forward(re, im);
+    for (uint32_t k = 0; k < FFT_SIZE / 2; k++) {
+        power[k] = re[k] * re[k] + im[k] * im[k];
+    }
+    estimate.updates++;
+    updateSpO2();
+
+    float bandPower = 0;
+    for (uint32_t k = LOW_BIN; k <= HIGH_BIN; k++) {
+        bandPower += power[k];
+    }
+    uint32_t peak = strongestPeak(LOW_BIN, HIGH_BIN);
+    if (peak == 0 || bandPower <= 0) {
+        estimate.heartRateValid = false;
+        estimate.confidence = 0;
+        return;
+    }
+    float strongest = power[peak];
+
+    // A sharp dicrotic notch can put more power in the second harmonic
+    uint32_t half = strongestPeak(peak / 2 - 1, peak / 2 + 1);
+    if (half != 0 && power[half] >= SUBHARMONIC_FRACTION * strongest) {
+        peak = half;
+    }
+
+    // Once locked, stay with the pulse unless it has all but gone
+    if (estimate.heartRateValid) {
+        uint32_t previous = (uint32_t)(estimate.heartRateBpm / BPM_PER_BIN + 0.5f);
+        uint32_t reach = (uint32_t)(TRACK_BPM / BPM_PER_BIN + 0.5f);
+        uint32_t tracked = strongestPeak(previous > reach ? previous - reach : 0, previous + reach);
+        if (tracked != 0 && power[tracked] >= CANDIDATE_FRACTION * strongest) {
+            peak = tracked;
+        }
+    }
+
+    // Between bins: a parabola through the log power is exact for a Gaussian lobe
+    const float epsilon = 1e-12f * strongest + 1e-20f;
+    float offset = parabolicPeakOffset(logf(power[peak - 1] + epsilon), logf(power[peak] + epsilon),
+                                       logf(power[peak + 1] + epsilon));
+    estimate.heartRateBpm = (peak + offset) * BPM_PER_BIN;
+    estimate.confidence = (power[peak - 1] + power[peak] + power[peak + 1]) / bandPower;
+    estimate.heartRateValid = estimate.confidence >= MIN_CONFIDENCE;
+}
+
+void SpectralHeartRate::updateSpO2() {
+    estimate.spo2Valid = false;
+    if (dcRed <= 0 || dcIr <= 0 || acPowerIr <= 0) {
+        estimate.ratio = 0;
+        estimate.spo2 = 0;
+        return;
+    }
+    float ratio = (sqrtf(acPowerRed) / dcRed) / (sqrtf(acPowerIr) / dcIr);
+    // Maxim's MAX30102 reference calibration
+    float spo2 = -45.060f * ratio * ratio + 30.354f * ratio + 94.845f;
+    estimate.ratio = ratio;
+    estimate.spo2 = spo2 > 100.0f ? 100.0f : spo2;
+    estimate.spo2Valid = ratio >= MIN_RATIO && ratio <= MAX_RATIO;
+}
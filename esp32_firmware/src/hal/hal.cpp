@@ -0,0 +1,22 @@
+#include "hal/hal.h"
+
+namespace hal {
+
+// Installed overrides; null means the platform's own
+static Clock* installedClock = nullptr;
+static Gpio* installedGpio = nullptr;
+static Spi* installedSpi = nullptr;
+static FileSystem* installedFileSystem = nullptr;
+
+Clock& clock() { return installedClock ? *installedClock : platformClock(); }
+Gpio& gpio() { return installedGpio ? *installedGpio : platformGpio(); }
+Spi& spi() { return installedSpi ? *installedSpi : platformSpi(); }
+FileSystem& fileSystem() { return installedFileSystem ? *installedFileSystem : platformFileSystem(); }
+uint32_t freeHeapBytes() { return platformFreeHeapBytes(); }
+
+void setClock(Clock* clock) { installedClock = clock; }
+void setGpio(Gpio* gpio) { installedGpio = gpio; }
+void setSpi(Spi* spi) { installedSpi = spi; }
+void setFileSystem(FileSystem* fileSystem) { installedFileSystem = fileSystem; }
+
+} // namespace hal
@@ -0,0 +1,112 @@
+#ifdef ARDUINO
+
+#include "hal/hal.h"
+#include <Arduino.h>
+#include <SPI.h>
+#include <SPIFFS.h>
+#include <esp_timer.h>
+
+namespace hal {
+
+class Esp32Clock : public Clock {
+public:
+    uint32_t millis() override { return ::millis(); }
+    uint64_t micros() override { return esp_timer_get_time(); }
+    void delayMs(uint32_t ms) override { ::delay(ms); }
+    void delayUs(uint32_t us) override { ::delayMicroseconds(us); }
+};
+
+class Esp32Gpio : public Gpio {
+public:
+    void setMode(uint8_t pin, Mode mode) override {
+        ::pinMode(pin, mode == MODE_OUTPUT ? OUTPUT : (mode == MODE_INPUT_PULLUP ? INPUT_PULLUP : INPUT));
+    }
+    bool read(uint8_t pin) override { return ::digitalRead(pin) == HIGH; }
+    void write(uint8_t pin, bool high) override { ::digitalWrite(pin, high ? HIGH : LOW); }
+    int readAnalog(uint8_t pin) override { return ::analogRead(pin); }
+};
+
+class Esp32Spi : public Spi {
+public:
+    void beginTransaction(uint32_t clockHz, uint8_t mode) override {
+        SPI.beginTransaction(SPISettings(clockHz, MSBFIRST, mode));
+    }
+    void endTransaction() override { SPI.endTransaction(); }
+    uint8_t transfer(uint8_t value) override { return SPI.transfer(value); }
+    void transfer(const uint8_t* tx, uint8_t* rx, size_t length) override {
+        if (!tx || !rx) {
+            Spi::transfer(tx, rx, length);
+            return;
+        }
+        SPI.transferBytes(tx, rx, length);
+    }
+};
+
+class SpiffsFileSystem : public FileSystem {
+public:
+    bool mount() override { return SPIFFS.begin(true); }
+    bool exists(const char* path) override { return SPIFFS.exists(path); }
+    long size(const char* path) override {
+        File file = SPIFFS.open(path, FILE_READ);
+        if (!file) {
+            return -1;
+        }
+        long bytes = file.size();
+        file.close();
+        return bytes;
+    }
+    bool read(const char* path, ChunkSink sink, void* context) override {
+        File file = SPIFFS.open(path, FILE_READ);
+        if (!file) {
+            return false;
+        }
+        char chunk[READ_CHUNK_BYTES + 1];
+        size_t count;
+        while ((count = file.read((uint8_t*)chunk, READ_CHUNK_BYTES)) > 0) {
+            chunk[count] = '\0';
+            if (!sink(context, chunk, count)) break;
+        }
+        file.close();
+        return true;
+    }
+    bool write(const char* path, const char* data, size_t length, bool append) override {
+        File file = SPIFFS.open(path, append ? FILE_APPEND : FILE_WRITE);
+        if (!file) {
+            return false;
+        }
+        size_t written = file.write((const uint8_t*)data, length);
+        file.close();
+        return written == length;
+    }
+    bool remove(const char* path) override { return SPIFFS.remove(path); }
+    size_t totalBytes() override { return SPIFFS.totalBytes(); }
+    size_t usedBytes() override { return SPIFFS.usedBytes(); }
+};
+
+Clock& platformClock() {
+    static Esp32Clock clock;
+    return clock;
+}
+
+Gpio& platformGpio() {
+    static Esp32Gpio gpio;
+    return gpio;
+}
+
+Spi& platformSpi() {
+    static Esp32Spi spi;
+    return spi;
+}
+
+FileSystem& platformFileSystem() {
+    static SpiffsFileSystem fileSystem;
+    return fileSystem;
+}
+
+uint32_t platformFreeHeapBytes() {
+    return ESP.getFreeHeap();
+}
+
+} // namespace hal
+
+#endif // ARDUINO
@@ -0,0 +1,123 @@
+#ifndef ARDUINO
+
+#include "hal/hal.h"
+#include <chrono>
+#include <thread>
+#include <string>
+#include <fstream>
+#include <cstdio>
+#include <cstdlib>
+#include <sys/stat.h>
+
+// Linux stand-ins: the steady clock, a pin table, an SPI bus with nothing
+// on it, and a directory for the filesystem ($HAL_NATIVE_FS_ROOT, or
+// ./native_fs). Tests wanting devices install their own through hal::set*().
+
+namespace hal {
+
+class NativeClock : public Clock {
+public:
+    NativeClock() : start(std::chrono::steady_clock::now()) {}
+    uint32_t millis() override { return (uint32_t)(micros() / 1000); }
+    uint64_t micros() override {
+        return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+    }
+    void delayMs(uint32_t ms) override { std::this_thread::sleep_for(std::chrono::milliseconds(ms)); }
+    void delayUs(uint32_t us) override { std::this_thread::sleep_for(std::chrono::microseconds(us)); }
+
+private:
+    std::chrono::steady_clock::time_point start;
+};
+
+// Pins read back what was written, pulled-up inputs high; the ADC reads 0
+class NativeGpio : public Gpio {
+public:
+    void setMode(uint8_t pin, Mode mode) override {
+        if (mode == MODE_INPUT_PULLUP) levels[pin] = true;
+    }
+    bool read(uint8_t pin) override { return levels[pin]; }
+    void write(uint8_t pin, bool high) override { levels[pin] = high; }
+    int readAnalog(uint8_t) override { return 0; }
+
+private:
+    bool levels[256] = {};
+};
+
+// MISO floats high
+class NativeSpi : public Spi {
+public:
+    void beginTransaction(uint32_t, uint8_t) override {}
+    void endTransaction() override {}
+    uint8_t transfer(uint8_t) override { return 0xFF; }
+};
+
+class DirectoryFileSystem : public FileSystem {
+public:
+    bool mount() override {
+        const char* env = getenv("HAL_NATIVE_FS_ROOT");
+        root = env && env[0] ? env : "native_fs";
+        mkdir(root.c_str(), 0755);
+        struct stat info;
+        return stat(root.c_str(), &info) == 0 && S_ISDIR(info.st_mode);
+    }
+    bool exists(const char* path) override {
+        struct stat info;
+        return stat(hostPath(path).c_str(), &info) == 0;
+    }
+    long size(const char* path) override {
+        struct stat info;
+        return stat(hostPath(path).c_str(), &info) == 0 ? (long)info.st_size : -1;
+    }
+    bool read(const char* path, ChunkSink sink, void* context) override {
+        std::ifstream file(hostPath(path), std::ios::binary);
+        if (!file) {
+            return false;
+        }
+        char chunk[READ_CHUNK_BYTES + 1];
+        size_t count;
+        while ((count = (size_t)file.read(chunk, READ_CHUNK_BYTES).gcount()) > 0) {
+            chunk[count] = '\0';
+            if (!sink(context, chunk, count)) break;
+        }
+        return true;
+    }
+    bool write(const char* path, const char* data, size_t length, bool append) override {
+        std::ofstream file(hostPath(path), std::ios::binary | (append ? std::ios::app : std::ios::trunc));
+        return file.write(data, length).good();
+    }
+    bool remove(const char* path) override { return std::remove(hostPath(path).c_str()) == 0; }
+    size_t totalBytes() override { return 0x170000; }       // The spiffs partition in default.csv
+    size_t usedBytes() override { return 0; }
+
+private:
+    std::string root = "native_fs";
+    std::string hostPath(const char* path) const { return root + (path[0] == '/' ? "" : "/") + path; }
+};
+
+Clock& platformClock() {
+    static NativeClock clock;
+    return clock;
+}
+
+Gpio& platformGpio() {
+    static NativeGpio gpio;
+    return gpio;
+}
+
+Spi& platformSpi() {
+    static NativeSpi spi;
+    return spi;
+}
+
+FileSystem& platformFileSystem() {
+    static DirectoryFileSystem fileSystem;
+    return fileSystem;
+}
+
+uint32_t platformFreeHeapBytes() {
+    return 320 * 1024;      // What an ESP32 application has after the core, roughly
+}
+
+} // namespace hal
+
+#endif // ARDUINO
@@ -0,0 +1,80 @@
+#ifndef ARDUINO
+
+#include "hal/native/Arduino.h"
+#include <stdio.h>
+#include <stdarg.h>
+
+HardwareSerial Serial;
+
+static std::string integerText(unsigned long magnitude, bool negative, unsigned char base) {
+    if (base < 2 || base > 36) base = 10;
+    char digits[72];
+    int n = 0;
+    do {
+        int digit = magnitude % base;
+        digits[n++] = (char)(digit < 10 ? '0' + digit : 'A' + digit - 10);
+        magnitude /= base;
+    } while (magnitude > 0);
+    std::string text = negative ? "-" : "";
+    while (n > 0) text += digits[--n];
+    return text;
+}
+
+String::String(int value, unsigned char base)
+    : text(base == 10 ? integerText(value < 0 ? -(long)value : value, value < 0, 10) : integerText((unsigned int)value, false, base)) {}
+
+String::String(unsigned int value, unsigned char base) : text(integerText(value, false, base)) {}
+
+String::String(long value, unsigned char base)
+    : text(base == 10 ? integerText(value < 0 ? 0UL - (unsigned long)value : value, value < 0, 10)
+                      : integerText((unsigned long)value, false, base)) {}
+
+String::String(unsigned long value, unsigned char base) : text(integerText(value, false, base)) {}
+
+String::String(float value, unsigned int decimals) : String((double)value, decimals) {}
+
+String::String(double value, unsigned int decimals) {
+    char buffer[48];
+    snprintf(buffer, sizeof(buffer), "%.*f", (int)decimals, value);
+    text = buffer;
+}
+
+int String::indexOf(char c, unsigned int from) const {
+    size_t at = text.find(c, from);
+    return at == std::string::npos ? -1 : (int)at;
+}
+
+int String::indexOf(const String& other, unsigned int from) const {
+    size_t at = text.find(other.text, from);
+    return at == std::string::npos ? -1 : (int)at;
+}
+
+String String::substring(unsigned int from, unsigned int to) const {
+    if (from > to) std::swap(from, to);
+    if (from >= text.length()) return String();
+    return String(text.substr(from, std::min<size_t>(to, text.length()) - from));
+}
+
+void HardwareSerial::flush() {
+    if (output) fflush(output);
+}
+
+size_t HardwareSerial::print(const char* text) {
+    if (!output) return strlen(text);
+    return fputs(text, output) < 0 ? 0 : strlen(text);
+}
+
+size_t HardwareSerial::print(char c) {
+    if (!output) return 1;
+    return fputc(c, output) == EOF ? 0 : 1;
+}
+
+size_t HardwareSerial::printf(const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    int n = output ? vfprintf(output, format, args) : vsnprintf(nullptr, 0, format, args);
+    va_end(args);
+    return n < 0 ? 0 : (size_t)n;
+}
+
+#endif // ARDUINO
@@ -17,6 +17,9 @@
 #include "data_manager.h"
 #include "ota_manager.h"
 #include "blood_pressure.h"
+#if USE_TASK_SAFE_SENSOR_MANAGER
+#include "sensors/sensor_manager.h"
+#endif
 
 // Global variables
 SecureNetworkManager secureNetwork;
@@ -35,6 +38,9 @@ TestMode currentMode = NORMAL_MODE;
 
 // Sensor objects
 SensorManager sensors;
+#if USE_TASK_SAFE_SENSOR_MANAGER
+TaskSafeSensorManager taskSensors;  // Owns the sensor hardware in this build; SensorManager stays uninitialized
+#endif
 DataManager dataManager;
 OTAManager otaManager;
 BloodPressureMonitor bpMonitor;
@@ -51,6 +57,7 @@ void createTasks();
 void sendHeartbeat();
 void handleIncomingCommand(String topic, String message);
 void sendDeviceStatus();
+String sensorStatus();
 void sensorTask(void* pvParameters);
 void networkTask(void* pvParameters);
 void dataTask(void* pvParameters);
@@ -349,9 +356,12 @@ void calculateAndDisplayBPResults(SensorReadings& readings) {
         
         // Advanced metrics
         Serial.println("\n📊 PULSE TRANSIT TIME ANALYSIS:");
-        Serial.printf("   PTT: %.1f ms\n", bp.pulseTransitTime);
+        Serial.printf("   PTT: %.1f ms (correlation lag %.1f ms)\n", bp.pulseTransitTime, bp.correlationPTT);
         Serial.printf("   PWV: %.2f m/s\n", bp.pulseWaveVelocity);
-        Serial.printf("   HRV: %.1f ms\n", bp.heartRateVariability);
+        Serial.printf("   HRV: %.1f ms (SDNN %.1f ms, pNN50 %.1f%%)\n", bp.heartRateVariability, bp.hrv.sdnnMs, bp.hrv.pnn50);
+        if (bp.hrv.spectrumValid) {
+            Serial.printf("   LF/HF: %.2f (LF %.0f ms^2, HF %.0f ms^2)\n", bp.hrv.lfHfRatio, bp.hrv.lfPower, bp.hrv.hfPower);
+        }
         
         // Signal quality
         Serial.println("\n📈 SIGNAL QUALITY:");
@@ -441,7 +451,7 @@ void setBPUserProfile() {
 void showBPSystemStatus() {
     Serial.println("\n📊 SYSTEM STATUS");
     Serial.println("━━━━━━━━━━━━━━━━━━━━");
-    Serial.println(sensors.getSensorStatus());
+    Serial.println(sensorStatus());
 }
 
 void showBPDetailedDiagnostics() {
@@ -452,7 +462,7 @@ void showBPDetailedDiagnostics() {
 }
 
 void showBPTestStatus() {    // Brief status update
-    Serial.printf("📡 %s\n", sensors.getSensorStatus().c_str());
+    Serial.printf("📡 %s\n", sensorStatus().c_str());
 }
 
 void runIndividualTestLoop() {
@@ -1243,7 +1253,11 @@ bool initializeSystem() {
     digitalWrite(LED_BUILTIN, LOW);
     
     // Initialize sensors first (required for all modes)
+#if USE_TASK_SAFE_SENSOR_MANAGER
+    if (!taskSensors.begin()) {
+#else
     if (!sensors.begin()) {
+#endif
         Serial.println("❌ Sensor initialization failed");
         return false;
     }
@@ -1306,7 +1320,11 @@ void handleIncomingCommand(String topic, String message) {
     String command = doc["command"];
     
     if (command == "calibrate_sensors") {
+#if USE_TASK_SAFE_SENSOR_MANAGER
+        taskSensors.calibrateWeight(1.0); // Default 1kg calibration
+#else
         sensors.calibrateWeight(1.0); // Default 1kg calibration
+#endif
         Serial.println("🔧 Sensor calibration initiated");
     }
     else if (command == "restart_device") {
@@ -1399,17 +1417,52 @@ void createTasks() {
     }
 }
 
+#if USE_TASK_SAFE_SENSOR_MANAGER
+void sensorTask(void *parameter) {
+    unsigned long lastAlertCheck = 0;
+    
+    taskSensors.startSensorTasks();
+    
+    while (true) {
+        // Per-sensor tasks do the bus work; this only consumes the fixed-cadence aggregate
+        SensorReadings readings;
+        if (systemInitialized && taskSensors.getAggregatedData(readings, TASK_SAFE_AGGREGATOR_PERIOD_MS * 2)) {
+            unsigned long currentTime = millis();
+            
+            if (currentTime - lastSensorReadTime > SENSOR_SAMPLE_RATE) { // Store every 5 seconds
+                if (dataManager.isValidReading(readings)) {
+                    dataManager.addSensorData(readings);
+                    Serial.println("📊 Sensors read and data stored");
+                }
+                lastSensorReadTime = currentTime;
+            }
+            
+            if (currentTime - lastAlertCheck >= 1000) {
+                checkSensorAlerts();
+                lastAlertCheck = currentTime;
+            }
+        } else if (!systemInitialized) {
+            vTaskDelay(pdMS_TO_TICKS(100));
+        }
+    }
+}
+#else
 void sensorTask(void *parameter) {
     TickType_t xLastWakeTime = xTaskGetTickCount();
-    const TickType_t xFrequency = pdMS_TO_TICKS(1000); // 1 second
+    const TickType_t xFrequency = pdMS_TO_TICKS(SENSOR_SCHEDULER_TICK_MS);
+    unsigned long lastAlertCheck = 0;
+    
+    sensors.startScheduler();
     
     while (true) {
         if (systemInitialized) {
-            // Check if it's time to read sensors based on intervals
             unsigned long currentTime = millis();
             
-            if (currentTime - lastSensorReadTime > 5000) { // Read every 5 seconds
-                SensorReadings readings = sensors.readAllSensors();
+            // Step whichever sensor jobs are due; each step returns quickly
+            sensors.runScheduler();
+            
+            if (currentTime - lastSensorReadTime > SENSOR_SAMPLE_RATE) { // Store every 5 seconds
+                SensorReadings readings = sensors.getLatestReadings();
                 if (dataManager.isValidReading(readings)) {
                     dataManager.addSensorData(readings);
                     Serial.println("📊 Sensors read and data stored");
@@ -1418,12 +1471,16 @@ void sensorTask(void *parameter) {
             }
             
             // Check for any sensor alerts
-            checkSensorAlerts();
+            if (currentTime - lastAlertCheck >= 1000) {
+                checkSensorAlerts();
+                lastAlertCheck = currentTime;
+            }
         }
         
         vTaskDelayUntil(&xLastWakeTime, xFrequency);
     }
 }
+#endif
 
 void networkTask(void *parameter) {
     TickType_t xLastWakeTime = xTaskGetTickCount();
@@ -1504,7 +1561,14 @@ void dataTask(void *parameter) {
 
 void processAndSendData() {
     // Get latest sensor readings
+#if USE_TASK_SAFE_SENSOR_MANAGER
+    SensorReadings data;
+    if (!taskSensors.getLatestReadings(data)) {
+        return;
+    }
+#else
     SensorReadings data = sensors.readAllSensors();
+#endif
     
     if (dataManager.isValidReading(data)) {
         // Store data locally first for reliability
@@ -1592,6 +1656,15 @@ void sendAlert(String type, float value) {
     Serial.printf("🚨 Alert sent: %s = %.2f\n", type.c_str(), value);
 }
 
+// Readiness as the manager that owns the sensors in this build sees it
+String sensorStatus() {
+#if USE_TASK_SAFE_SENSOR_MANAGER
+    return taskSensors.getSensorStatus();
+#else
+    return sensors.getSensorStatus();
+#endif
+}
+
 void sendHeartbeat() {
     DynamicJsonDocument heartbeatDoc(512);
     heartbeatDoc["deviceId"] = DEVICE_ID;
@@ -1603,10 +1676,17 @@ void sendHeartbeat() {
     heartbeatDoc["securityLevel"] = secureNetwork.getCurrentSecurityLevel();
     heartbeatDoc["queuedData"] = secureNetwork.getQueueSize();
       // Add sensor status
+#if USE_TASK_SAFE_SENSOR_MANAGER
+    heartbeatDoc["sensors"]["heartRate"] = taskSensors.isHeartRateReady();
+    heartbeatDoc["sensors"]["temperature"] = taskSensors.isTemperatureReady();
+    heartbeatDoc["sensors"]["bioimpedance"] = taskSensors.isBioimpedanceReady();
+    heartbeatDoc["sensors"]["ecg"] = false;    // No ECG task in this build
+#else
     heartbeatDoc["sensors"]["heartRate"] = sensors.isHeartRateReady();
     heartbeatDoc["sensors"]["temperature"] = sensors.isTemperatureReady();
     heartbeatDoc["sensors"]["bioimpedance"] = sensors.isBioimpedanceReady();
     heartbeatDoc["sensors"]["ecg"] = sensors.isECGReady();
+#endif
     
     String heartbeatJson;
     serializeJson(heartbeatDoc, heartbeatJson);
@@ -1648,7 +1728,11 @@ void monitorSystemHealth() {
         }
         
         // Sensor health check
+#if USE_TASK_SAFE_SENSOR_MANAGER
+        if (!taskSensors.isHeartRateReady()) {
+#else
         if (!sensors.isHeartRateReady() || !sensors.isECGReady()) {
+#endif
             Serial.println("⚠️ Critical sensors not responding");
         }
         
@@ -1690,11 +1774,19 @@ void sendDeviceStatus() {
     statusDoc["network"]["stats"]["successful"] = netStats.successfulRequests;
     statusDoc["network"]["stats"]["failed"] = netStats.failedRequests;
       // Sensor status
+#if USE_TASK_SAFE_SENSOR_MANAGER
+    statusDoc["sensors"]["heartRate"]["ready"] = taskSensors.isHeartRateReady();
+    statusDoc["sensors"]["temperature"]["ready"] = taskSensors.isTemperatureReady();
+    statusDoc["sensors"]["bioimpedance"]["ready"] = taskSensors.isBioimpedanceReady();
+    statusDoc["sensors"]["ecg"]["ready"] = false;
+    statusDoc["sensors"]["weight"]["ready"] = taskSensors.isWeightReady();
+#else
     statusDoc["sensors"]["heartRate"]["ready"] = sensors.isHeartRateReady();
     statusDoc["sensors"]["temperature"]["ready"] = sensors.isTemperatureReady();
     statusDoc["sensors"]["bioimpedance"]["ready"] = sensors.isBioimpedanceReady();
     statusDoc["sensors"]["ecg"]["ready"] = sensors.isECGReady();
     statusDoc["sensors"]["weight"]["ready"] = sensors.isWeightReady();
+#endif
     
     // Configuration
     statusDoc["config"]["mode"] = (currentMode == NORMAL_MODE) ? "normal" : 
@@ -1747,7 +1839,7 @@ void handleSerialCommands() {
             Serial.println();
             
             Serial.println("Sensor Status:");
-            Serial.println(sensors.getSensorStatus());
+            Serial.println(sensorStatus());
             
         } else if (command == "security") {
             Serial.println("\n=== SECURITY STATUS ===");
@@ -1767,8 +1859,23 @@ void handleSerialCommands() {
             
         } else if (command == "sensors") {
             Serial.println("\n=== SENSOR READINGS ===");
+#if USE_TASK_SAFE_SENSOR_MANAGER
+            SensorReadings readings;
+            if (taskSensors.getLatestReadings(readings)) {
+                taskSensors.printSensorReadings(readings);
+            }
+#else
             SensorReadings readings = sensors.readAllSensors();
             sensors.printSensorReadings(readings);
+#endif
+            
+        } else if (command == "scheduler") {
+#if USE_TASK_SAFE_SENSOR_MANAGER
+            taskSensors.printTaskStats();
+#else
+            sensors.printSchedulerStats();
+            sensors.printPPGStreamStats();
+#endif
             
         } else if (command == "test_alert") {
             Serial.println("Sending test alert...");
@@ -1783,6 +1890,24 @@ void handleSerialCommands() {
             delay(3000);
             ESP.restart();
             
+#if USE_TASK_SAFE_SENSOR_MANAGER
+        } else if (command.startsWith("temp_cal ")) {
+            // The task-safe manager derives the offset from a reference reading
+            float knownTemperature = command.substring(9).toFloat();
+            if (!taskSensors.calibrateTemperature(knownTemperature)) {
+                Serial.println("❌ Temperature calibration failed - no valid DS18B20 reading yet");
+            }
+            
+        } else if (command == "temp_cal") {
+            Serial.println("Usage: temp_cal <reference_temperature_C>");
+            Serial.println("Example: temp_cal 36.6");
+            
+        } else if (command == "tare") {
+            Serial.println("⚖️ Taring weight sensor (removing platform + device weight)...");
+            if (taskSensors.tareWeight()) {
+                Serial.println("✅ Weight sensor tared - place subject on platform for measurement");
+            }
+#else
         } else if (command == "temp_test") {
             Serial.println("🌡️ Starting DS18B20 temperature test...");
             sensors.testDS18B20();
@@ -1801,6 +1926,7 @@ void handleSerialCommands() {
             Serial.println("⚖️ Taring weight sensor (removing platform + device weight)...");
             sensors.tareWeight();
             Serial.println("✅ Weight sensor tared - place subject on platform for measurement");
+#endif
             
         } else if (command.startsWith("cal ")) {
             // Parse calibration weight
@@ -1809,7 +1935,13 @@ void handleSerialCommands() {
             if (knownWeight > 0) {
                 Serial.printf("🔧 Calibrating with known weight: %.2f kg\n", knownWeight);
                 Serial.println("📋 Make sure the known weight is on the scale, then calibrating...");
+#if USE_TASK_SAFE_SENSOR_MANAGER
+                if (!taskSensors.calibrateWeight(knownWeight)) {
+                    Serial.println("❌ Weight calibration failed");
+                }
+#else
                 sensors.calibrateWeight(knownWeight);
+#endif
             } else {
                 Serial.println("❌ Invalid weight. Usage: cal <weight_in_kg>");
                 Serial.println("Example: cal 77.5");
@@ -1818,7 +1950,11 @@ void handleSerialCommands() {
         } else if (command == "t") {
             // Quick tare command like in your example
             Serial.println("⚖️ Quick tare...");
+#if USE_TASK_SAFE_SENSOR_MANAGER
+            taskSensors.tareWeight();
+#else
             sensors.tareWeight();
+#endif
             
         } else if (command == "help") {
             Serial.println("\n=== AVAILABLE COMMANDS ===");
@@ -1826,9 +1962,15 @@ void handleSerialCommands() {
             Serial.println("security        - Show security status");
             Serial.println("network         - Show network diagnostics");
             Serial.println("sensors         - Read all sensors");
+            Serial.println("scheduler       - Show per-sensor latency, overruns and PPG stream consumers");
             Serial.println("test_alert      - Send test alert");
-            Serial.println("test_heartbeat  - Send test heartbeat");            Serial.println("temp_test       - Test DS18B20 temperature sensor");
+            Serial.println("test_heartbeat  - Send test heartbeat");
+#if USE_TASK_SAFE_SENSOR_MANAGER
+            Serial.println("temp_cal <C>    - Calibrate temperature against a reference reading");
+#else
+            Serial.println("temp_test       - Test DS18B20 temperature sensor");
             Serial.println("temp_cal [val]  - Set/show temperature calibration offset");
+#endif
             Serial.println("tare            - Tare/zero the weight sensor");
             Serial.println("t               - Quick tare command");
             Serial.println("cal <weight>    - Calibrate weight sensor with known weight (kg)");
@@ -0,0 +1,114 @@
+#ifndef ARDUINO
+
+// Replays recorded traces through the estimators on the host
+// Build and run with: pio run -e replay && .pio/build/replay/program [options] trace...
+//   -v                 let the modules' Serial logging through
+//   -i <ms>            blood pressure estimate interval (BLOOD_PRESSURE_INTERVAL)
+//   -p <age>,<height cm>,<weight kg>,<m|f>   BIA user profile
+//   -g <seconds>       replay a synthetic trace (SyntheticSignals) instead
+//   -s <seed>          its seed
+//   -o <path>          and write it out too, binary if the path ends in .bin
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "replay/signal_replay.h"
+#include "replay/synthetic_signals.h"
+
+static void usage() {
+    fprintf(stderr, "usage: program [-v] [-i bp_interval_ms] [-p age,height,weight,m|f] trace...\n"
+                    "       program [-v] [-i bp_interval_ms] [-p ...] -g seconds [-s seed] [-o out.csv|out.bin]\n");
+}
+
+static bool endsWith(const char* text, const char* suffix) {
+    size_t length = strlen(text);
+    size_t suffixLength = strlen(suffix);
+    return length >= suffixLength && strcmp(text + length - suffixLength, suffix) == 0;
+}
+
+static int runSynthetic(const ReplayConfig& config, const SyntheticConfig& synthetic, const char* outPath) {
+    SyntheticSignals signals(synthetic);
+    if (outPath) {
+        uint64_t written = signals.writeTo(outPath, endsWith(outPath, ".bin"));
+        if (written == 0) {
+            fprintf(stderr, "could not write %s\n", outPath);
+            return 1;
+        }
+        printf("Wrote %llu records to %s\n", (unsigned long long)written, outPath);
+    }
+
+    const SyntheticTruth& truth = signals.getTruth();
+    printf("== synthetic, seed %u, %.0f s\n", (unsigned)synthetic.seed, synthetic.seconds);
+    printf("Truth: %u beats (%u ectopic), %.1f BPM, PTT %.1f ms, %u sweeps\n",
+           (unsigned)truth.beatsBetween(0, synthetic.seconds), (unsigned)truth.ectopicBeats(),
+           truth.meanHeartRateBPM(0, synthetic.seconds), truth.meanPttMs(0, synthetic.seconds),
+           (unsigned)truth.sweepEnds.size());
+
+    SignalReplay replay(config);
+    replay.begin();
+    signals.feed(replay);
+    replay.finish();
+    replay.printReport();
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    ReplayConfig config;
+    SyntheticConfig synthetic;
+    bool generate = false;
+    const char* outPath = nullptr;
+    int first = 1;
+    for (; first < argc && argv[first][0] == '-'; first++) {
+        const char* option = argv[first];
+        if (strcmp(option, "-v") == 0) {
+            config.moduleOutput = true;
+        } else if (strcmp(option, "-i") == 0 && first + 1 < argc) {
+            config.bpIntervalMs = (uint32_t)atol(argv[++first]);
+        } else if (strcmp(option, "-p") == 0 && first + 1 < argc) {
+            char sex = 'm';
+            if (sscanf(argv[++first], "%d,%f,%f,%c", &config.profile.age, &config.profile.height,
+                       &config.profile.weight, &sex) < 3) {
+                usage();
+                return 2;
+            }
+            config.profile.isMale = sex != 'f' && sex != 'F';
+        } else if (strcmp(option, "-g") == 0 && first + 1 < argc) {
+            synthetic.seconds = atof(argv[++first]);
+            generate = synthetic.seconds > 0;
+        } else if (strcmp(option, "-s") == 0 && first + 1 < argc) {
+            synthetic.seed = (uint32_t)strtoul(argv[++first], nullptr, 0);
+        } else if (strcmp(option, "-o") == 0 && first + 1 < argc) {
+            outPath = argv[++first];
+        } else {
+            usage();
+            return 2;
+        }
+    }
+    if ((!generate && first >= argc) || config.bpIntervalMs == 0) {
+        usage();
+        return 2;
+    }
+
+    if (generate) {
+        // A BIA sweep every BIOIMPEDANCE_INTERVAL, as the scheduler takes them
+        for (double t = 1; t < synthetic.seconds; t += BIOIMPEDANCE_INTERVAL / 1000.0) {
+            synthetic.sweepTimes.push_back(t);
+        }
+        return runSynthetic(config, synthetic, outPath);
+    }
+
+    int failures = 0;
+    for (int i = first; i < argc; i++) {
+        SignalReplay replay(config);
+        printf("== %s\n", argv[i]);
+        if (!replay.run(argv[i])) {
+            failures++;
+            continue;
+        }
+        replay.printReport();
+        printf("\n");
+    }
+    return failures == 0 ? 0 : 1;
+}
+
+#endif // ARDUINO
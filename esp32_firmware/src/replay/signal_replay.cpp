@@ -0,0 +1,326 @@
+#ifndef ARDUINO
+
+#include "replay/signal_replay.h"
+#include "sensors/stream_quality.h"
+#include <stdio.h>
+#include <math.h>
+#include <chrono>
+
+typedef std::chrono::steady_clock WallClock;
+
+static double secondsSince(WallClock::time_point start) {
+    return std::chrono::duration<double>(WallClock::now() - start).count();
+}
+
+const char* replayStageName(ReplayStage stage) {
+    switch (stage) {
+        case REPLAY_STAGE_ECG_CHAIN: return "ecg_chain";
+        case REPLAY_STAGE_PPG_MONITOR: return "ppg_monitor";
+        case REPLAY_STAGE_PPG_QUALITY: return "ppg_quality";
+        case REPLAY_STAGE_BP_ESTIMATE: return "bp_estimate";
+        case REPLAY_STAGE_BIA_ANALYSIS: return "bia_analysis";
+        default: return "?";
+    }
+}
+
+SignalReplay::SignalReplay(const ReplayConfig& config)
+    : config(config), report(), ecgQuality(ECG_STREAM_QUALITY_CONFIG), ppgQuality(PPG_STREAM_QUALITY_CONFIG) {}
+
+bool SignalReplay::run(const char* path) {
+    TraceReader reader;
+    if (!reader.open(path)) {
+        Serial.printf("❌ Can't open trace %s\n", path);
+        return false;
+    }
+
+    begin();
+    TraceRecord record;
+    while (reader.next(record)) {
+        addRecord(record);
+    }
+    finish();
+    skippedRecords += reader.getSkippedLines();
+    return true;
+}
+
+void SignalReplay::begin() {
+    report = ReplayReport();
+    skippedRecords = 0;
+    ecgCount = ppgCount = 0;
+    sweepCount = 0;
+    nextEstimateUs = 0;
+    for (int i = 0; i < 3; i++) {
+        channelFirstUs[i] = channelLastUs[i] = 0;
+    }
+    ecgFed = false;
+    wallStart = WallClock::now();
+
+    clock.nowUs = 0;
+    hal::setClock(&clock);
+    if (!config.moduleOutput) {
+        Serial.setOutput(nullptr);
+    }
+
+    bpMonitor.begin();
+    bodyComposition.setUserProfile(config.profile);
+    ecgPipeline.reset();
+    ecgQuality.reset();
+    ppgQuality.reset();
+    ppgQualityPipeline.reset();
+    running = true;
+}
+
+void SignalReplay::addRecord(const TraceRecord& record) {
+    if (!running) {
+        return;
+    }
+    if (record.timeUs < clock.nowUs) {
+        skippedRecords++;       // Time never runs backwards on the target either
+        return;
+    }
+
+    uint64_t count = report.totalRecords();
+    if (count == 0) {
+        report.firstUs = record.timeUs;
+        nextEstimateUs = record.timeUs + (uint64_t)config.bpIntervalMs * 1000;
+    }
+    report.lastUs = record.timeUs;
+    int channel = (int)record.channel;
+    if (report.records[channel]++ == 0) {
+        channelFirstUs[channel] = record.timeUs;
+    }
+    channelLastUs[channel] = record.timeUs;
+    clock.nowUs = record.timeUs;
+
+    if (sweepCount > 0 && record.timeUs - sweepLastUs > (uint64_t)SWEEP_GAP_MS * 1000) {
+        flushSweep();
+    }
+
+    // The BP job runs on its schedule, with whatever the streams delivered
+    if (record.timeUs >= nextEstimateUs) {
+        flushECG();
+        flushPPG();
+        estimateBloodPressure();
+        nextEstimateUs += (uint64_t)config.bpIntervalMs * 1000;
+    }
+
+    switch (record.channel) {
+        case TraceChannel::ECG:
+            if (record.values[1] != 0) {
+                // After lead-off the chain primes from the new level and relearns
+                flushECG();
+                if (ecgFed) {
+                    ecgPipeline.reset();
+                    ecgQuality.reset();
+                    ecgFed = false;
+                    report.leadOffResets++;
+                }
+                break;
+            }
+            ecgValues[ecgCount] = record.values[0];
+            ecgTimes[ecgCount++] = record.timeUs;
+            if (ecgCount == ECG_STREAM_BLOCK_SIZE) {
+                flushECG();
+            }
+            break;
+
+        case TraceChannel::PPG:
+            ppgBurst[ppgCount++] = {(uint32_t)record.values[1], (uint32_t)record.values[0], record.timeUs};
+            if (ppgCount == PPG_BURST_SIZE) {
+                flushPPG();
+            }
+            break;
+
+        case TraceChannel::BIA: {
+            // A sweep ends where the frequency stops rising
+            if (sweepCount == MAX_SWEEP_POINTS || (sweepCount > 0 && record.values[0] <= sweep[sweepCount - 1].Frequency)) {
+                flushSweep();
+            }
+            BIAResult& point = sweep[sweepCount++];
+            point.Frequency = record.values[0];
+            point.Resistance = record.values[1];
+            point.Reactance = record.values[2];
+            point.Magnitude = sqrtf(point.Resistance * point.Resistance + point.Reactance * point.Reactance);
+            point.Phase = atan2f(point.Reactance, point.Resistance) * 180.0f / PI;
+            point.Timestamp = clock.millis();
+            point.Valid = true;
+            sweepLastUs = record.timeUs;
+            break;
+        }
+    }
+}
+
+void SignalReplay::finish() {
+    if (!running) {
+        return;
+    }
+    flushECG();
+    flushPPG();
+    flushSweep();
+
+    for (int i = 0; i < 2; i++) {
+        uint64_t spanUs = channelLastUs[i] - channelFirstUs[i];
+        float rateHz = report.records[i] > 1 && spanUs > 0 ? (report.records[i] - 1) * 1e6f / spanUs : 0;
+        (i == 0 ? report.ecgRateHz : report.ppgRateHz) = rateHz;
+    }
+    report.hrv = bpMonitor.getHRV();
+    report.heartRateBPM = ecgQrs().getHeartRate();
+    report.ecgQuality = ecgQuality.getIndex();
+    report.ppgQuality = ppgQuality.getIndex();
+
+    report.wallSeconds = secondsSince(wallStart);
+
+    Serial.setOutput(stdout);
+    hal::setClock(nullptr);
+    running = false;
+}
+
+void SignalReplay::flushECG() {
+    if (ecgCount == 0) {
+        return;
+    }
+    WallClock::time_point start = WallClock::now();
+    SampleBlock block = {ecgValues, ecgTimes, ecgCount};
+    ECGEvents events = {*this};
+    ecgPipeline.process(block, events);
+    countStage(REPLAY_STAGE_ECG_CHAIN, ecgCount, secondsSince(start));
+    ecgFed = true;
+    ecgCount = 0;
+}
+
+void SignalReplay::flushPPG() {
+    if (ppgCount == 0) {
+        return;
+    }
+    WallClock::time_point start = WallClock::now();
+    bpMonitor.addPPGBlock(ppgBurst, ppgCount);
+    countStage(REPLAY_STAGE_PPG_MONITOR, ppgCount, secondsSince(start));
+
+    // The quality consumer: raw IR for the rails, then negated so systole rises
+    start = WallClock::now();
+    float values[PPG_BURST_SIZE];
+    uint64_t times[PPG_BURST_SIZE];
+    for (size_t i = 0; i < ppgCount; i++) {
+        values[i] = (float)ppgBurst[i].ir;
+        times[i] = ppgBurst[i].timestampUs;
+    }
+    ppgQuality.addRawBlock(values, ppgCount);
+    for (size_t i = 0; i < ppgCount; i++) {
+        values[i] = -values[i];
+    }
+    SampleBlock block = {values, times, ppgCount};
+    PPGQualityEvents events = {*this};
+    ppgQualityPipeline.process(block, events);
+    countStage(REPLAY_STAGE_PPG_QUALITY, ppgCount, secondsSince(start));
+    ppgCount = 0;
+}
+
+void SignalReplay::flushSweep() {
+    if (sweepCount == 0) {
+        return;
+    }
+    // On the target the analysis follows the last point straight away
+    uint64_t nowUs = clock.nowUs;
+    clock.nowUs = sweepLastUs;
+    WallClock::time_point start = WallClock::now();
+    BodyComposition composition = bodyComposition.analyzeBodyComposition(sweep, sweepCount, config.profile.weight);
+    countStage(REPLAY_STAGE_BIA_ANALYSIS, sweepCount, secondsSince(start));
+    clock.nowUs = nowUs;
+    report.bodyComposition.push_back(composition);
+    sweepCount = 0;
+}
+
+void SignalReplay::estimateBloodPressure() {
+    // As SensorManager::readBloodPressure(): nothing until the monitor is ready
+    if (!bpMonitor.isReadyForMeasurement()) {
+        return;
+    }
+    WallClock::time_point start = WallClock::now();
+    BloodPressureData reading = bpMonitor.calculateBloodPressure();
+    countStage(REPLAY_STAGE_BP_ESTIMATE, 1, secondsSince(start));
+    report.bloodPressure.push_back(reading);
+}
+
+void SignalReplay::shareSignalQuality() {
+    bpMonitor.setSignalQuality(ecgQuality.getIndex(), ppgQuality.getIndex());
+}
+
+void SignalReplay::countStage(ReplayStage stage, uint64_t samples, double seconds) {
+    ReplayStageStats& stats = report.stages[stage];
+    stats.calls++;
+    stats.samples += samples;
+    stats.totalSeconds += seconds;
+    if (seconds > stats.maxSeconds) stats.maxSeconds = seconds;
+}
+
+void SignalReplay::ECGEvents::on(const TappedBlock<ECG_TAP_RAW>& tap) {
+    self.ecgQuality.addRawBlock(tap.block.values, tap.block.count);
+}
+
+void SignalReplay::ECGEvents::on(const TappedBlock<ECG_TAP_FILTERED>& tap) {
+    if (self.ecgQuality.addBlock(tap.block.values, tap.block.timestampsUs, tap.block.count)) {
+        self.shareSignalQuality();
+    }
+    self.bpMonitor.addFilteredECG(tap.block.values, tap.block.timestampsUs, tap.block.count);
+}
+
+void SignalReplay::ECGEvents::on(const QrsEvent& beat) {
+    self.report.rPeaks++;
+    self.ecgQuality.addBeat(beat.timeUs);
+    self.bpMonitor.addRPeak(beat);
+}
+
+void SignalReplay::PPGQualityEvents::on(const TappedBlock<PPG_TAP_FILTERED>& tap) {
+    if (self.ppgQuality.addBlock(tap.block.values, tap.block.timestampsUs, tap.block.count)) {
+        self.shareSignalQuality();
+    }
+}
+
+void SignalReplay::PPGQualityEvents::on(const PulseFiducials& beat) {
+    self.report.pulses++;
+    self.ppgQuality.addBeat(beat.maxSlopeUs);
+}
+
+void SignalReplay::printReport() const {
+    const ReplayReport& r = report;
+    printf("Trace: %.1f s, %llu ECG / %llu PPG / %llu BIA records", r.traceSeconds(),
+           (unsigned long long)r.records[0], (unsigned long long)r.records[1], (unsigned long long)r.records[2]);
+    if (skippedRecords > 0) printf(", %u skipped", (unsigned)skippedRecords);
+    printf("\n");
+    printf("Rates: ECG %.1f Hz, PPG %.1f Hz (the chains are designed for %d and %d)\n", r.ecgRateHz, r.ppgRateHz,
+           ECG_STREAM_SAMPLE_RATE, PPG_STREAM_SAMPLE_RATE);
+    printf("Replayed in %.3f s: %.0f samples/s, %.0fx real time\n", r.wallSeconds, r.samplesPerSecond(), r.speedup());
+
+    printf("\nStage           calls    samples   total ms   mean us    max us\n");
+    for (int i = 0; i < REPLAY_STAGE_COUNT; i++) {
+        const ReplayStageStats& s = r.stages[i];
+        printf("%-14s %6u %10llu %10.1f %9.2f %9.2f\n", replayStageName((ReplayStage)i), (unsigned)s.calls,
+               (unsigned long long)s.samples, s.totalSeconds * 1e3, s.calls ? s.totalSeconds * 1e6 / s.calls : 0.0,
+               s.maxSeconds * 1e6);
+    }
+
+    printf("\nECG: %u R-peaks (%.0f BPM at the end), %u lead-off resets, SQI %.0f\n", (unsigned)r.rPeaks,
+           r.heartRateBPM, (unsigned)r.leadOffResets, r.ecgQuality.valid ? r.ecgQuality.score : 0.0f);
+    printf("PPG: %u pulses, SQI %.0f\n", (unsigned)r.pulses, r.ppgQuality.valid ? r.ppgQuality.score : 0.0f);
+    printf("HRV: %lu RR, SDNN %.1f ms, RMSSD %.1f ms, pNN50 %.1f%%\n", (unsigned long)r.hrv.intervals, r.hrv.sdnnMs,
+           r.hrv.rmssdMs, r.hrv.pnn50);
+
+    int valid = 0;
+    for (const BloodPressureData& bp : r.bloodPressure) valid += bp.validReading;
+    printf("\nBlood pressure: %d estimates, %d valid\n", (int)r.bloodPressure.size(), valid);
+    for (const BloodPressureData& bp : r.bloodPressure) {
+        printf("  %8.1f s  %5.1f/%5.1f mmHg  PTT %6.1f ms  quality %3.0f%s\n", bp.timestamp / 1000.0, bp.systolic,
+               bp.diastolic, bp.pulseTransitTime, bp.signalQuality, bp.validReading ? "" : "  (invalid)");
+    }
+
+    if (!r.bodyComposition.empty()) {
+        printf("\nBody composition: %d sweeps\n", (int)r.bodyComposition.size());
+        for (const BodyComposition& bc : r.bodyComposition) {
+            printf("  %8.1f s  fat %4.1f%%  water %4.1f%%  phase %4.1f deg  quality %3.0f%s\n", bc.timestamp / 1000.0,
+                   bc.bodyFatPercentage, bc.bodyWaterPercentage, bc.phaseAngle, bc.measurementQuality,
+                   bc.validReading ? "" : "  (invalid)");
+        }
+    }
+}
+
+#endif // ARDUINO
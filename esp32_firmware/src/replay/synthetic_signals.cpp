@@ -0,0 +1,332 @@
+#include "replay/synthetic_signals.h"
+#include <math.h>
+#include <algorithm>
+#ifndef ARDUINO
+#include "replay/signal_replay.h"
+#endif
+
+static const double RADIANS_PER_CYCLE = 6.283185307179586;
+static const double ECG_BEAT_BEFORE = 0.4;      // A beat's waves span R - 0.4 s to R + 0.6 s
+static const double ECG_BEAT_AFTER = 0.6;
+static const double PULSE_LENGTH = 1.5;         // Seconds after the onset
+static const double MOTION_EDGE = 0.2;          // Seconds to ramp a motion interval in and out
+static const float ECG_RAIL = 4095.0f;
+
+static double wave(double tau, double centre, double width, double amplitude) {
+    double d = tau - centre;
+    return amplitude * exp(-d * d / (2 * width * width));
+}
+
+void ColeModel::impedanceAt(float frequencyHz, float& resistance, float& reactance) const {
+    // (jx)^alpha = x^alpha * (cos(alpha pi/2) + j sin(alpha pi/2))
+    double x = pow(frequencyHz / fcHz, alpha);
+    double re = 1 + x * cos(alpha * M_PI / 2);
+    double im = x * sin(alpha * M_PI / 2);
+    double scale = (r0 - rInf) / (re * re + im * im);
+    resistance = (float)(rInf + scale * re);
+    reactance = (float)(scale * im);
+}
+
+float SyntheticTruth::meanHeartRateBPM(double from, double to) const {
+    double first = -1;
+    double last = -1;
+    uint32_t count = 0;
+    for (const SyntheticBeat& beat : beats) {
+        if (beat.rPeak < from || beat.rPeak >= to) continue;
+        if (count++ == 0) first = beat.rPeak;
+        last = beat.rPeak;
+    }
+    return count > 1 ? (float)(60.0 * (count - 1) / (last - first)) : 0;
+}
+
+float SyntheticTruth::meanPttMs(double from, double to) const {
+    double sum = 0;
+    uint32_t count = 0;
+    for (const SyntheticBeat& beat : beats) {
+        if (beat.rPeak < from || beat.rPeak >= to) continue;
+        sum += beat.pttMs();
+        count++;
+    }
+    return count ? (float)(sum / count) : 0;
+}
+
+uint32_t SyntheticTruth::beatsBetween(double from, double to) const {
+    uint32_t count = 0;
+    for (const SyntheticBeat& beat : beats) {
+        if (beat.rPeak >= from && beat.rPeak < to) count++;
+    }
+    return count;
+}
+
+uint32_t SyntheticTruth::ectopicBeats() const {
+    uint32_t count = 0;
+    for (const SyntheticBeat& beat : beats) {
+        if (beat.ectopic) count++;
+    }
+    return count;
+}
+
+uint32_t SyntheticSignals::Random::nextU32() {
+    // splitmix64
+    uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return (uint32_t)((z ^ (z >> 31)) >> 32);
+}
+
+double SyntheticSignals::Random::uniform() {
+    return (nextU32() >> 8) / 16777216.0;
+}
+
+double SyntheticSignals::Random::gaussian() {
+    // Box-Muller, one of the pair
+    double u1 = 1.0 - uniform();
+    double u2 = uniform();
+    return sqrt(-2.0 * log(u1)) * cos(RADIANS_PER_CYCLE * u2);
+}
+
+SyntheticSignals::SyntheticSignals(const SyntheticConfig& config) : config(config) {
+    std::sort(this->config.sweepTimes.begin(), this->config.sweepTimes.end());
+    buildBeats();
+
+    Random phases;
+    phases.seed(config.seed ^ 0x4D4F5449u);
+    for (size_t i = 0; i < 3 * config.motion.size(); i++) {
+        motionPhases.push_back(RADIANS_PER_CYCLE * phases.uniform());
+    }
+
+    // Each sweep ends at its last point inside the trace
+    double spacing = config.sweepPointMs / 1000.0;
+    size_t points = config.sweepFrequencies.size();
+    for (double start : this->config.sweepTimes) {
+        if (points == 0 || start >= config.seconds) continue;
+        size_t inside = std::min(points, (size_t)ceil((config.seconds - start) / (spacing > 0 ? spacing : 1e-9)));
+        truth.sweepEnds.push_back(start + (inside - 1) * spacing);
+    }
+    restart();
+}
+
+void SyntheticSignals::buildBeats() {
+    Random rhythm;
+    rhythm.seed(config.seed);
+    double normalRR = 60.0 / config.heartRateBPM;
+    double t = 0.3 + 0.5 * normalRR * rhythm.uniform();
+    bool ectopic = false;
+    double prematureRR = 0;
+
+    // Up to the last beat whose P wave starts inside the trace
+    while (t < config.seconds + ECG_BEAT_BEFORE) {
+        truth.beats.push_back({t, t + pttSecondsAt(t), ectopic});
+
+        double rr = normalRR * (1 + config.rsaFraction * sin(RADIANS_PER_CYCLE * config.respirationHz * t)) +
+                    config.rrJitterMs / 1000.0 * rhythm.gaussian();
+        double draw = rhythm.uniform();
+        if (ectopic) {
+            // Compensatory pause: the sinus rhythm carries on underneath
+            rr = 2 * rr - prematureRR;
+            ectopic = false;
+        } else if (draw < config.ectopicFraction) {
+            rr *= config.ectopicCoupling;
+            prematureRR = rr;
+            ectopic = true;
+        }
+        t += std::max(rr, 0.25);
+    }
+}
+
+void SyntheticSignals::restart() {
+    ecgNoise.seed(config.seed ^ 0x45434721u);
+    ppgNoise.seed(config.seed ^ 0x50504721u);
+    biaNoise.seed(config.seed ^ 0x42494121u);
+    ecgIndex = ppgIndex = 0;
+    sweepIndex = sweepPoint = 0;
+    ecgBeat = ppgBeat = 0;
+}
+
+double SyntheticSignals::pttSecondsAt(double t) const {
+    return (config.pttMs + config.pttSwingMs * sin(RADIANS_PER_CYCLE * config.respirationHz * t)) / 1000.0;
+}
+
+double SyntheticSignals::respirationAt(double t) const {
+    return sin(RADIANS_PER_CYCLE * config.respirationHz * t);
+}
+
+double SyntheticSignals::ecgMvAt(double t, size_t& firstBeat) const {
+    const std::vector<SyntheticBeat>& beats = truth.beats;
+    while (firstBeat < beats.size() && beats[firstBeat].rPeak + ECG_BEAT_AFTER < t) {
+        firstBeat++;
+    }
+    double a = config.rAmplitudeMv;
+    double mv = 0;
+    for (size_t b = firstBeat; b < beats.size(); b++) {
+        double tau = t - beats[b].rPeak;
+        if (tau < -ECG_BEAT_BEFORE) break;
+        if (beats[b].ectopic) {
+            // Wide ventricular complex, no P wave, discordant T
+            mv += wave(tau, 0.000, 0.030, 1.3 * a) + wave(tau, 0.060, 0.025, -0.45 * a) +
+                  wave(tau, 0.320, 0.060, -0.45 * a);
+        } else {
+            mv += wave(tau, -0.160, 0.025, 0.12 * a) + wave(tau, -0.020, 0.008, -0.10 * a) +
+                  wave(tau, 0.000, 0.009, a) + wave(tau, 0.022, 0.008, -0.20 * a) +
+                  wave(tau, 0.250, 0.045, 0.25 * a);
+        }
+    }
+    return mv;
+}
+
+double SyntheticSignals::pulseVolumeAt(double t, size_t& firstBeat) const {
+    const std::vector<SyntheticBeat>& beats = truth.beats;
+    double rise = config.ppgRiseMs / 1000.0;
+    // Steepest upstroke of a half-cosine rise is half way up
+    while (firstBeat < beats.size() && beats[firstBeat].ppgMaxSlope - rise / 2 + PULSE_LENGTH < t) {
+        firstBeat++;
+    }
+    double volume = 0;
+    for (size_t b = firstBeat; b < beats.size(); b++) {
+        double tau = t - (beats[b].ppgMaxSlope - rise / 2);
+        if (tau < 0) break;
+        double scale = beats[b].ectopic ? config.ectopicPulseScale : 1.0;
+        if (tau < rise) {
+            volume += scale * 0.5 * (1.0 - cos(M_PI * tau / rise));
+        } else {
+            double after = tau - rise;
+            double notch = after - 0.2;
+            volume += scale * (exp(-after / 0.12) + 0.15 * exp(-notch * notch / (2 * 0.03 * 0.03)));
+        }
+    }
+    return volume;
+}
+
+double SyntheticSignals::motionAt(double t, double& envelope) const {
+    envelope = 0;
+    for (size_t i = 0; i < config.motion.size(); i++) {
+        const SyntheticInterval& interval = config.motion[i];
+        if (!interval.contains(t)) continue;
+        envelope = std::min(1.0, std::min(t - interval.start, interval.end - t) / MOTION_EDGE);
+        const double* phase = &motionPhases[3 * i];
+        return envelope * (sin(RADIANS_PER_CYCLE * 0.7 * t + phase[0]) + 0.6 * sin(RADIANS_PER_CYCLE * 1.6 * t + phase[1]) +
+                           0.3 * sin(RADIANS_PER_CYCLE * 2.9 * t + phase[2]));
+    }
+    return 0;
+}
+
+uint64_t SyntheticSignals::timeUs(double t) const {
+    return config.startUs + (uint64_t)(t * 1e6 + 0.5);
+}
+
+float SyntheticSignals::ecgCountsAt(double t) const {
+    size_t firstBeat = std::lower_bound(truth.beats.begin(), truth.beats.end(), t - ECG_BEAT_AFTER,
+                                        [](const SyntheticBeat& beat, double time) { return beat.rPeak < time; }) -
+                       truth.beats.begin();
+    return (float)(SYNTHETIC_ECG_MIDRAIL + SYNTHETIC_ECG_COUNTS_PER_MV * ecgMvAt(t, firstBeat));
+}
+
+void SyntheticSignals::ppgCountsAt(double t, float& ir, float& red) const {
+    size_t firstBeat = std::lower_bound(truth.beats.begin(), truth.beats.end(), t - PULSE_LENGTH - 1.0,
+                                        [](const SyntheticBeat& beat, double time) { return beat.ppgMaxSlope < time; }) -
+                       truth.beats.begin();
+    double volume = pulseVolumeAt(t, firstBeat);
+    double redRatio = (110.0 - config.spo2) / 25.0;
+    ir = (float)(config.ppgDcCounts - config.ppgAmplitudeCounts * volume);
+    red = (float)(config.redDcFraction * (config.ppgDcCounts - redRatio * config.ppgAmplitudeCounts * volume));
+}
+
+bool SyntheticSignals::next(TraceRecord& record) {
+    double ecgT = ecgIndex / config.ecgRateHz;
+    double ppgT = ppgIndex / config.ppgRateHz;
+    double biaT = 1e18;
+    if (sweepIndex < config.sweepTimes.size() && !config.sweepFrequencies.empty()) {
+        biaT = config.sweepTimes[sweepIndex] + sweepPoint * config.sweepPointMs / 1000.0;
+    }
+    double t = std::min(ecgT, std::min(ppgT, biaT));
+    if (t >= config.seconds) {
+        return false;
+    }
+    record.timeUs = timeUs(t);
+    record.values[0] = record.values[1] = record.values[2] = 0;
+
+    if (t == biaT) {
+        record.channel = TraceChannel::BIA;
+        float resistance, reactance;
+        config.cole.impedanceAt(config.sweepFrequencies[sweepPoint], resistance, reactance);
+        record.values[0] = config.sweepFrequencies[sweepPoint];
+        record.values[1] = resistance + (float)(config.biaNoiseOhms * biaNoise.gaussian());
+        record.values[2] = reactance + (float)(config.biaNoiseOhms * biaNoise.gaussian());
+        if (++sweepPoint == config.sweepFrequencies.size()) {
+            sweepPoint = 0;
+            sweepIndex++;
+        }
+        return true;
+    }
+
+    double envelope;
+    double motion = motionAt(t, envelope);
+
+    if (t == ecgT) {
+        record.channel = TraceChannel::ECG;
+        ecgIndex++;
+        double mv = ecgMvAt(t, ecgBeat);
+        // Noise is drawn on every sample, so lead-off leaves the rest of the trace as it was
+        double noise = config.ecgNoiseMv * ecgNoise.gaussian();
+        double emg = 0.3 * config.motionMv * envelope * ecgNoise.gaussian();
+        for (const SyntheticInterval& interval : config.leadOff) {
+            if (interval.contains(t)) {
+                record.values[0] = ECG_RAIL;
+                record.values[1] = 1;
+                return true;
+            }
+        }
+        double respiration = respirationAt(t);
+        mv += config.baselineWanderMv * (0.7 * respiration + 0.3 * sin(RADIANS_PER_CYCLE * 0.05 * t + 1.0));
+        mv += config.mainsMv * sin(RADIANS_PER_CYCLE * 50.0 * t);
+        mv += noise + config.motionMv * motion + emg;
+        float counts = (float)(SYNTHETIC_ECG_MIDRAIL + SYNTHETIC_ECG_COUNTS_PER_MV * mv);
+        record.values[0] = std::max(0.0f, std::min(ECG_RAIL, counts));
+        return true;
+    }
+
+    record.channel = TraceChannel::PPG;
+    ppgIndex++;
+    double volume = pulseVolumeAt(t, ppgBeat);
+    double dc = config.ppgDcCounts * (1 + config.ppgWanderFraction * respirationAt(t)) + config.motionCounts * motion;
+    double redRatio = (110.0 - config.spo2) / 25.0;
+    double ir = dc - config.ppgAmplitudeCounts * volume + config.ppgNoiseCounts * ppgNoise.gaussian();
+    double red = config.redDcFraction * (dc - redRatio * config.ppgAmplitudeCounts * volume) +
+                 config.ppgNoiseCounts * ppgNoise.gaussian();
+    record.values[0] = (float)ir;
+    record.values[1] = (float)red;
+    return true;
+}
+
+#ifndef ARDUINO
+
+// Trace files and the replay are host-only
+uint64_t SyntheticSignals::writeTo(const char* path, bool binary) {
+    TraceWriter writer;
+    if (!writer.open(path, binary)) {
+        return 0;
+    }
+    restart();
+    uint64_t count = 0;
+    TraceRecord record;
+    while (next(record)) {
+        if (!writer.write(record)) {
+            return 0;
+        }
+        count++;
+    }
+    return writer.close() ? count : 0;
+}
+
+uint64_t SyntheticSignals::feed(SignalReplay& replay) {
+    restart();
+    uint64_t count = 0;
+    TraceRecord record;
+    while (next(record)) {
+        replay.addRecord(record);
+        count++;
+    }
+    return count;
+}
+
+#endif // ARDUINO
@@ -0,0 +1,173 @@
+#ifndef ARDUINO
+
+#include "replay/trace.h"
+#include <string.h>
+#include <stdlib.h>
+
+static const char BINARY_MAGIC[8] = {'B', 'T', 'T', 'R', 'A', 'C', 'E', '1'};
+static const size_t BINARY_RECORD_SIZE = 24;
+
+const char* traceChannelName(TraceChannel channel) {
+    switch (channel) {
+        case TraceChannel::ECG: return "ecg";
+        case TraceChannel::PPG: return "ppg";
+        case TraceChannel::BIA: return "bia";
+    }
+    return "?";
+}
+
+static bool parseChannel(const char* name, size_t length, TraceChannel& channel) {
+    static const TraceChannel channels[3] = {TraceChannel::ECG, TraceChannel::PPG, TraceChannel::BIA};
+    for (TraceChannel candidate : channels) {
+        if (length == 3 && strncmp(name, traceChannelName(candidate), 3) == 0) {
+            channel = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+static void putLE32(uint8_t* out, uint32_t value) {
+    for (int i = 0; i < 4; i++) out[i] = (uint8_t)(value >> (8 * i));
+}
+
+static uint32_t getLE32(const uint8_t* in) {
+    return (uint32_t)in[0] | ((uint32_t)in[1] << 8) | ((uint32_t)in[2] << 16) | ((uint32_t)in[3] << 24);
+}
+
+static uint32_t floatBits(float value) {
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+static float bitsFloat(uint32_t bits) {
+    float value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+bool TraceReader::open(const char* path) {
+    close();
+    skippedLines = 0;
+    file = fopen(path, "rb");
+    if (!file) {
+        return false;
+    }
+    char magic[sizeof(BINARY_MAGIC)];
+    binary = fread(magic, 1, sizeof(magic), file) == sizeof(magic) &&
+             memcmp(magic, BINARY_MAGIC, sizeof(magic)) == 0;
+    if (!binary) {
+        rewind(file);
+    }
+    return true;
+}
+
+void TraceReader::close() {
+    if (file) {
+        fclose(file);
+        file = nullptr;
+    }
+}
+
+bool TraceReader::next(TraceRecord& record) {
+    if (!file) {
+        return false;
+    }
+
+    if (binary) {
+        uint8_t raw[BINARY_RECORD_SIZE];
+        while (fread(raw, 1, sizeof(raw), file) == sizeof(raw)) {
+            if (raw[8] > (uint8_t)TraceChannel::BIA) {
+                skippedLines++;
+                continue;
+            }
+            record.timeUs = (uint64_t)getLE32(raw) | ((uint64_t)getLE32(raw + 4) << 32);
+            record.channel = (TraceChannel)raw[8];
+            for (int i = 0; i < 3; i++) {
+                record.values[i] = bitsFloat(getLE32(raw + 12 + 4 * i));
+            }
+            return true;
+        }
+        return false;
+    }
+
+    char line[160];
+    while (fgets(line, sizeof(line), file)) {
+        if (line[0] == '#' || line[0] == '\n' || line[0] == '\r') {
+            continue;
+        }
+        // time_us,channel,v0[,v1[,v2]]
+        char* cursor;
+        unsigned long long timeUs = strtoull(line, &cursor, 10);
+        if (cursor == line || *cursor != ',') {
+            skippedLines++;
+            continue;
+        }
+        const char* name = cursor + 1;
+        const char* nameEnd = strchr(name, ',');
+        if (!nameEnd || !parseChannel(name, nameEnd - name, record.channel)) {
+            skippedLines++;
+            continue;
+        }
+        record.timeUs = timeUs;
+        record.values[0] = record.values[1] = record.values[2] = 0;
+        cursor = (char*)nameEnd;
+        for (int i = 0; i < 3 && *cursor == ','; i++) {
+            char* end;
+            record.values[i] = strtof(cursor + 1, &end);
+            cursor = end;
+        }
+        return true;
+    }
+    return false;
+}
+
+bool TraceWriter::open(const char* path, bool binaryFormat) {
+    close();
+    binary = binaryFormat;
+    file = fopen(path, binary ? "wb" : "w");
+    if (!file) {
+        return false;
+    }
+    if (binary) {
+        return fwrite(BINARY_MAGIC, 1, sizeof(BINARY_MAGIC), file) == sizeof(BINARY_MAGIC);
+    }
+    return fputs("# BioTrack trace\n# columns=time_us,channel,values\n", file) >= 0;
+}
+
+bool TraceWriter::close() {
+    if (!file) {
+        return true;
+    }
+    bool ok = fclose(file) == 0;
+    file = nullptr;
+    return ok;
+}
+
+bool TraceWriter::write(const TraceRecord& record) {
+    if (!file) {
+        return false;
+    }
+
+    if (binary) {
+        uint8_t raw[BINARY_RECORD_SIZE] = {};
+        putLE32(raw, (uint32_t)record.timeUs);
+        putLE32(raw + 4, (uint32_t)(record.timeUs >> 32));
+        raw[8] = (uint8_t)record.channel;
+        for (int i = 0; i < 3; i++) {
+            putLE32(raw + 12 + 4 * i, floatBits(record.values[i]));
+        }
+        return fwrite(raw, 1, sizeof(raw), file) == sizeof(raw);
+    }
+
+    // Only as many values as the channel has
+    int count = record.channel == TraceChannel::BIA ? 3 : (record.channel == TraceChannel::PPG || record.values[1] != 0 ? 2 : 1);
+    int n = fprintf(file, "%llu,%s", (unsigned long long)record.timeUs, traceChannelName(record.channel));
+    for (int i = 0; i < count && n >= 0; i++) {
+        n = fprintf(file, ",%.9g", record.values[i]);
+    }
+    return n >= 0 && fputc('\n', file) != EOF;
+}
+
+#endif // ARDUINO
@@ -0,0 +1,739 @@
+#include "sensors/sensor_manager.h"
+#include <EEPROM.h>
+#include <esp_timer.h>
+
+static const char* const SENSOR_NAMES[] = {"heart_rate", "temperature", "weight", "bioimpedance"};
+
+// Queues only ever need the newest reading: when one is full the oldest
+// entry is dropped so a slow consumer never blocks a sensor task
+template <typename T>
+static bool publishLatest(QueueHandle_t queue, const T& item) {
+    if (xQueueSend(queue, &item, 0) == pdPASS) {
+        return true;
+    }
+    T discarded;
+    xQueueReceive(queue, &discarded, 0);
+    xQueueSend(queue, &item, 0);
+    return false;
+}
+
+// Keeps only the newest item waiting in a queue
+template <typename T>
+static bool drainLatest(QueueHandle_t queue, T& latest) {
+    bool received = false;
+    while (xQueueReceive(queue, &latest, 0) == pdPASS) {
+        received = true;
+    }
+    return received;
+}
+
+TaskSafeSensorManager::TaskSafeSensorManager()
+    : oneWire(DS18B20_PIN), temperatureSensor(&oneWire), loadCell(WEIGHT_SENSOR_DOUT, WEIGHT_SENSOR_SCK),
+      ppgBus(Wire), ppgAcquisition(ppgBus), temperatureBus(temperatureSensor), temperaturePipeline(temperatureBus),
+      heartRateTaskHandle(NULL), temperatureTaskHandle(NULL), weightTaskHandle(NULL),
+      bioimpedanceTaskHandle(NULL), aggregatorTaskHandle(NULL),
+      heartRateQueue(NULL), temperatureQueue(NULL), weightQueue(NULL), bioimpedanceQueue(NULL),
+      aggregatedDataQueue(NULL), i2cMutex(NULL), spiMutex(NULL), loadCellMutex(NULL), dataAccessMutex(NULL),
+      heartRateInitialized(false), temperatureInitialized(false), weightInitialized(false),
+      bioimpedanceInitialized(false), tasksStarted(false),
+      weightCalibrationFactor(LOAD_CELL_CALIBRATION_FACTOR), temperatureOffset(5.0f), bioimpedanceCalibrated(false),
+      lastTemperature(0) {
+    latestReadings = {};
+    memset(taskMetrics, 0, sizeof(taskMetrics));
+    memset(&aggregatorMetrics, 0, sizeof(aggregatorMetrics));
+}
+
+TaskSafeSensorManager::~TaskSafeSensorManager() {
+    stopSensorTasks();
+
+    QueueHandle_t queues[] = {heartRateQueue, temperatureQueue, weightQueue, bioimpedanceQueue, aggregatedDataQueue};
+    for (QueueHandle_t queue : queues) {
+        if (queue != NULL) vQueueDelete(queue);
+    }
+    SemaphoreHandle_t mutexes[] = {i2cMutex, spiMutex, loadCellMutex, dataAccessMutex};
+    for (SemaphoreHandle_t mutex : mutexes) {
+        if (mutex != NULL) vSemaphoreDelete(mutex);
+    }
+}
+
+bool TaskSafeSensorManager::begin() {
+    Serial.println("🔄 Initializing task-safe sensor manager...");
+
+    i2cMutex = xSemaphoreCreateMutex();
+    spiMutex = xSemaphoreCreateMutex();
+    loadCellMutex = xSemaphoreCreateMutex();
+    dataAccessMutex = xSemaphoreCreateMutex();
+    heartRateQueue = xQueueCreate(QUEUE_SIZE, sizeof(HeartRateData));
+    temperatureQueue = xQueueCreate(QUEUE_SIZE, sizeof(TemperatureData));
+    weightQueue = xQueueCreate(QUEUE_SIZE, sizeof(WeightData));
+    bioimpedanceQueue = xQueueCreate(QUEUE_SIZE, sizeof(BioimpedanceData));
+    aggregatedDataQueue = xQueueCreate(AGGREGATED_QUEUE_SIZE, sizeof(SensorReadings));
+
+    if (!i2cMutex || !spiMutex || !loadCellMutex || !dataAccessMutex || !heartRateQueue || !temperatureQueue ||
+        !weightQueue || !bioimpedanceQueue || !aggregatedDataQueue) {
+        Serial.println("❌ Failed to create sensor queues/mutexes");
+        return false;
+    }
+
+    Wire.begin(MAX30102_SDA_PIN, MAX30102_SCL_PIN);
+
+    heartRateInitialized = initializeHeartRateSensor();
+    Serial.println(heartRateInitialized ? "✅ Heart rate sensor initialized" : "⚠️ Heart rate sensor failed");
+    temperatureInitialized = initializeTemperatureSensor();
+    Serial.println(temperatureInitialized ? "✅ Temperature sensor initialized" : "⚠️ Temperature sensor failed");
+    weightInitialized = initializeWeightSensor();
+    Serial.println(weightInitialized ? "✅ Weight sensor initialized" : "❌ Weight sensor failed");
+    bioimpedanceInitialized = initializeBioimpedanceSensor();
+    Serial.println(bioimpedanceInitialized ? "✅ Bioimpedance sensor initialized" : "⚠️ Bioimpedance sensor failed");
+
+    // Same policy as SensorManager: only the weight sensor is mandatory
+    return weightInitialized;
+}
+
+bool TaskSafeSensorManager::initializeHeartRateSensor() {
+    if (!takeMutex(i2cMutex, 1000)) {
+        return false;
+    }
+
+    bool ok = heartRateSensor.begin(Wire, I2C_SPEED_FAST);
+    if (ok) {
+        PPGAcquisitionConfig config;
+        config.sampleRateHz = HEART_RATE_SAMPLE_RATE;
+        config.redAmplitude = 0x1F;
+        config.irAmplitude = 0x1F;
+        ok = ppgAcquisition.begin(config);
+    }
+
+    giveMutex(i2cMutex);
+    return ok;
+}
+
+bool TaskSafeSensorManager::initializeTemperatureSensor() {
+    temperatureSensor.begin();
+    if (temperaturePipeline.begin(DS18B20_RESOLUTION, DS18B20_CONVERSION_INTERVAL) == 0) {
+        Serial.println("❌ No DS18B20 sensors found");
+        return false;
+    }
+    return true;
+}
+
+bool TaskSafeSensorManager::initializeWeightSensor() {
+    EEPROM.begin(512);
+
+    float calValue;
+    EEPROM.get(WEIGHT_EEPROM_ADDRESS, calValue);
+    if (calValue == 0xFFFFFFFF || calValue == 0.0 || isnan(calValue)) {
+        calValue = LOAD_CELL_CALIBRATION_FACTOR;
+    }
+
+    loadCell.begin();
+    loadCell.start(2000, true);
+    if (loadCell.getTareTimeoutFlag() || loadCell.getSignalTimeoutFlag()) {
+        Serial.printf("❌ HX711 timeout - check wiring (DOUT=%d, SCK=%d)\n", WEIGHT_SENSOR_DOUT, WEIGHT_SENSOR_SCK);
+        return false;
+    }
+
+    weightCalibrationFactor = calValue;
+    loadCell.setCalFactor(calValue);
+    return true;
+}
+
+bool TaskSafeSensorManager::initializeBioimpedanceSensor() {
+    if (!takeMutex(spiMutex, 1000)) {
+        return false;
+    }
+
+    bool ok = biaApp.initialize(AD5941_CS_PIN, AD5941_RESET_PIN, AD5941_INT_PIN);
+    if (ok) {
+        BIAConfig config;
+        config.StartFreq = 1000.0f;
+        config.EndFreq = 100000.0f;
+        config.NumOfPoints = 10;
+        config.ExcitVolt = 200.0f;
+        config.SweepEnable = false;
+        ok = biaApp.configure(config) && biaApp.selfTest();
+    }
+
+    giveMutex(spiMutex);
+    return ok;
+}
+
+bool TaskSafeSensorManager::startSensorTasks() {
+    if (tasksStarted) {
+        return true;
+    }
+    if (!dataAccessMutex) {
+        Serial.println("❌ begin() must succeed before starting sensor tasks");
+        return false;
+    }
+
+    // The I2C PPG and the SPI AD5940 sit on different buses and different
+    // cores, so a 60 ms BIA point never delays a FIFO drain
+    bool ok = true;
+    if (heartRateInitialized) {
+        ok &= xTaskCreatePinnedToCore(heartRateTask, "HRTask", TASK_STACK_SIZE_MEDIUM, this,
+                                      TASK_SAFE_SENSOR_TASK_PRIORITY, &heartRateTaskHandle, TASK_SAFE_I2C_CORE) == pdPASS;
+    }
+    if (temperatureInitialized) {
+        ok &= xTaskCreatePinnedToCore(temperatureTask, "TempTask", TASK_STACK_SIZE_SMALL, this,
+                                      TASK_SAFE_SENSOR_TASK_PRIORITY - 1, &temperatureTaskHandle, TASK_SAFE_I2C_CORE) == pdPASS;
+    }
+    if (weightInitialized) {
+        ok &= xTaskCreatePinnedToCore(weightTask, "WeightTask", TASK_STACK_SIZE_SMALL, this,
+                                      TASK_SAFE_SENSOR_TASK_PRIORITY - 1, &weightTaskHandle, TASK_SAFE_SPI_CORE) == pdPASS;
+    }
+    if (bioimpedanceInitialized) {
+        ok &= xTaskCreatePinnedToCore(bioimpedanceTask, "BIATask", TASK_STACK_SIZE_MEDIUM, this,
+                                      TASK_SAFE_SENSOR_TASK_PRIORITY, &bioimpedanceTaskHandle, TASK_SAFE_SPI_CORE) == pdPASS;
+    }
+    ok &= xTaskCreatePinnedToCore(dataAggregatorTask, "AggregatorTask", TASK_STACK_SIZE_MEDIUM, this,
+                                  TASK_SAFE_AGGREGATOR_PRIORITY, &aggregatorTaskHandle, TASK_SAFE_SPI_CORE) == pdPASS;
+
+    if (!ok) {
+        Serial.println("❌ Failed to create sensor tasks");
+        stopSensorTasks();
+        return false;
+    }
+
+    tasksStarted = true;
+    Serial.printf("✅ Sensor tasks started (aggregate every %d ms)\n", TASK_SAFE_AGGREGATOR_PERIOD_MS);
+    return true;
+}
+
+bool TaskSafeSensorManager::stopSensorTasks() {
+    TaskHandle_t* handles[] = {&aggregatorTaskHandle, &heartRateTaskHandle, &temperatureTaskHandle,
+                               &weightTaskHandle, &bioimpedanceTaskHandle};
+
+    // Hold every bus so no task is deleted in the middle of a transaction
+    bool haveI2C = takeMutex(i2cMutex, 1000);
+    bool haveSPI = takeMutex(spiMutex, 2000);
+    bool haveLoadCell = takeMutex(loadCellMutex, 1000);
+    for (TaskHandle_t* handle : handles) {
+        if (*handle != NULL) {
+            vTaskDelete(*handle);
+            *handle = NULL;
+        }
+    }
+    if (haveLoadCell) giveMutex(loadCellMutex);
+    if (haveSPI) giveMutex(spiMutex);
+    if (haveI2C) giveMutex(i2cMutex);
+
+    tasksStarted = false;
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// Sensor tasks
+// ---------------------------------------------------------------------------
+
+void TaskSafeSensorManager::heartRateTask(void* parameter) {
+    TaskSafeSensorManager* self = static_cast<TaskSafeSensorManager*>(parameter);
+    // Wake just before the 32-sample FIFO would fill
+    TickType_t period = pdMS_TO_TICKS(self->ppgAcquisition.pollIntervalUs() / 1000);
+    if (period == 0) period = 1;
+    TickType_t lastWake = xTaskGetTickCount();
+
+    while (true) {
+        HeartRateData data = self->readHeartRateAndSpO2();
+        if (data.timestamp != 0) {
+            publishLatest(self->heartRateQueue, data);
+            self->taskMetrics[SENSOR_HEART_RATE].published++;
+        }
+        vTaskDelayUntil(&lastWake, period);
+    }
+}
+
+void TaskSafeSensorManager::temperatureTask(void* parameter) {
+    TaskSafeSensorManager* self = static_cast<TaskSafeSensorManager*>(parameter);
+    // Conversions run in the background; polling only reads finished scratchpads
+    const TickType_t period = pdMS_TO_TICKS(100);
+    TickType_t lastWake = xTaskGetTickCount();
+
+    while (true) {
+        TemperatureData data = self->readTemperature();
+        if (data.timestamp != 0) {
+            publishLatest(self->temperatureQueue, data);
+            self->taskMetrics[SENSOR_TEMPERATURE].published++;
+        }
+        vTaskDelayUntil(&lastWake, period);
+    }
+}
+
+void TaskSafeSensorManager::weightTask(void* parameter) {
+    TaskSafeSensorManager* self = static_cast<TaskSafeSensorManager*>(parameter);
+    // HX711 converts at 10 Hz; update() must be called often enough not to miss one
+    const TickType_t period = pdMS_TO_TICKS(20);
+    TickType_t lastWake = xTaskGetTickCount();
+    uint32_t lastPublishMs = 0;
+
+    while (true) {
+        WeightData data = self->readWeight();
+        if (data.timestamp != 0 && millis() - lastPublishMs >= WEIGHT_INTERVAL) {
+            publishLatest(self->weightQueue, data);
+            self->taskMetrics[SENSOR_WEIGHT].published++;
+            lastPublishMs = millis();
+        }
+        vTaskDelayUntil(&lastWake, period);
+    }
+}
+
+void TaskSafeSensorManager::bioimpedanceTask(void* parameter) {
+    TaskSafeSensorManager* self = static_cast<TaskSafeSensorManager*>(parameter);
+    const TickType_t period = pdMS_TO_TICKS(BIOIMPEDANCE_INTERVAL);
+    TickType_t lastWake = xTaskGetTickCount();
+
+    while (true) {
+        BioimpedanceData data = self->readBioimpedance();
+        if (data.timestamp != 0) {
+            publishLatest(self->bioimpedanceQueue, data);
+            self->taskMetrics[SENSOR_BIOIMPEDANCE].published++;
+        }
+        vTaskDelayUntil(&lastWake, period);
+    }
+}
+
+void TaskSafeSensorManager::dataAggregatorTask(void* parameter) {
+    TaskSafeSensorManager* self = static_cast<TaskSafeSensorManager*>(parameter);
+    const TickType_t period = pdMS_TO_TICKS(TASK_SAFE_AGGREGATOR_PERIOD_MS);
+    const uint32_t periodUs = TASK_SAFE_AGGREGATOR_PERIOD_MS * 1000UL;
+    TickType_t lastWake = xTaskGetTickCount();
+    uint32_t lastCycleUs = 0;
+
+    while (true) {
+        vTaskDelayUntil(&lastWake, period);
+
+        uint32_t nowUs = micros();
+        AggregatorMetrics& metrics = self->aggregatorMetrics;
+        if (metrics.cycles > 0) {
+            uint32_t actual = nowUs - lastCycleUs;
+            uint32_t jitter = actual > periodUs ? actual - periodUs : periodUs - actual;
+            metrics.lastPeriodUs = actual;
+            metrics.totalJitterUs += jitter;
+            if (jitter > metrics.maxJitterUs) metrics.maxJitterUs = jitter;
+        }
+        lastCycleUs = nowUs;
+        metrics.cycles++;
+
+        HeartRateData heartRate;
+        TemperatureData temperature;
+        WeightData weight;
+        BioimpedanceData bioimpedance;
+        SensorReadings snapshot;
+
+        if (self->takeMutex(self->dataAccessMutex)) {
+            if (drainLatest(self->heartRateQueue, heartRate)) self->latestReadings.heartRate = heartRate;
+            if (drainLatest(self->temperatureQueue, temperature)) self->latestReadings.temperature = temperature;
+            if (drainLatest(self->weightQueue, weight)) self->latestReadings.weight = weight;
+            if (drainLatest(self->bioimpedanceQueue, bioimpedance)) self->latestReadings.bioimpedance = bioimpedance;
+            self->latestReadings.systemTimestamp = millis();
+            snapshot = self->latestReadings;
+            self->giveMutex(self->dataAccessMutex);
+
+            if (!publishLatest(self->aggregatedDataQueue, snapshot)) {
+                metrics.droppedSnapshots++;
+            }
+        }
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Sensor reads (one task loop each; timestamp 0 means nothing new)
+// ---------------------------------------------------------------------------
+
+HeartRateData TaskSafeSensorManager::readHeartRateAndSpO2() {
+    HeartRateData data = {0, 0, false, 0};
+    uint32_t startUs = micros();
+
+    if (!takeBus(i2cMutex, SENSOR_HEART_RATE)) {
+        return data;
+    }
+    ppgAcquisition.service(esp_timer_get_time());
+    giveMutex(i2cMutex);
+
+    PPGSample batch[32];
+    size_t count;
+    while ((count = ppgAcquisition.read(batch, 32)) > 0) {
+        for (size_t i = 0; i < count; i++) {
+            // Re-estimate once a second over the newest 4 s, read in place
+            if (!spo2Window.addSample(batch[i].red, batch[i].ir, batch[i].timestampUs)) {
+                continue;
+            }
+            uint32_t* irWindow = spo2Window.irWindow();
+            uint32_t* redWindow = spo2Window.redWindow();
+
+            int32_t spo2 = 0;
+            int32_t heartRate = 0;
+            int8_t spo2Valid = 0;
+            int8_t heartRateValid = 0;
+            calculateSpO2AndHeartRate(irWindow, redWindow, RollingPPGWindow::LENGTH, &spo2, &spo2Valid, &heartRate, &heartRateValid);
+
+            data.heartRate = heartRate;
+            data.spO2 = spo2;
+            data.timestamp = millis();
+            data.sources = 1 << HR_SOURCE_PPG_MAXIM;
+            data.validReading = heartRateValid && spo2Valid && irWindow[RollingPPGWindow::LENGTH - 1] > 50000 &&
+                                validateHeartRateReading(data);
+        }
+    }
+
+    recordLoop(SENSOR_HEART_RATE, startUs);
+    return data;
+}
+
+TemperatureData TaskSafeSensorManager::readTemperature() {
+    TemperatureData data = {0, false, 0};
+    uint32_t startUs = micros();
+
+    if (temperaturePipeline.update(millis())) {
+        const TemperatureChannel& channel = temperaturePipeline.channel(0);
+        data.timestamp = channel.timestampMs;
+        if (channel.valid) {
+            float calibrated = channel.celsius + temperatureOffset;
+            data.temperature = filterTemperature(calibrated, lastTemperature);
+            data.validReading = validateTemperatureReading(data);
+            lastTemperature = data.temperature;
+        } else {
+            taskMetrics[SENSOR_TEMPERATURE].errors++;
+        }
+    }
+
+    recordLoop(SENSOR_TEMPERATURE, startUs);
+    return data;
+}
+
+WeightData TaskSafeSensorManager::readWeight() {
+    WeightData data = {0, false, false, 0};
+    uint32_t startUs = micros();
+
+    // A tare or calibration holds the load cell for a couple of seconds
+    if (!takeBus(loadCellMutex, SENSOR_WEIGHT, 5000)) {
+        return data;
+    }
+    if (loadCell.update()) {
+        data.weight = loadCell.getData();
+        data.timestamp = millis();
+
+        weightHistory.push(data.weight);
+        data.stable = isWeightStable(weightHistory);
+        data.validReading = validateWeightReading(data);
+    }
+    giveMutex(loadCellMutex);
+
+    recordLoop(SENSOR_WEIGHT, startUs);
+    return data;
+}
+
+BioimpedanceData TaskSafeSensorManager::readBioimpedance() {
+    BioimpedanceData data = {0, 0, 0, 0, 0, false, 0};
+    uint32_t startUs = micros();
+
+    if (!takeBus(spiMutex, SENSOR_BIOIMPEDANCE, 2000)) {
+        return data;
+    }
+    BIAResult result;
+    bool ok = biaApp.performSingleMeasurement(10000.0f, result);
+    giveMutex(spiMutex);
+
+    data.timestamp = millis();
+    if (ok) {
+        data.resistance = result.Resistance;
+        data.reactance = result.Reactance;
+        data.impedance = result.Magnitude;
+        data.phase = result.Phase;
+        data.frequency = result.Frequency;
+        data.validReading = result.Valid && validateBioimpedanceReading(data);
+    } else {
+        taskMetrics[SENSOR_BIOIMPEDANCE].errors++;
+    }
+
+    recordLoop(SENSOR_BIOIMPEDANCE, startUs);
+    return data;
+}
+
+// ---------------------------------------------------------------------------
+// Data access
+// ---------------------------------------------------------------------------
+
+bool TaskSafeSensorManager::getLatestReadings(SensorReadings& readings, uint32_t timeoutMs) {
+    if (!takeMutex(dataAccessMutex, timeoutMs)) {
+        return false;
+    }
+    readings = latestReadings;
+    giveMutex(dataAccessMutex);
+    return true;
+}
+
+bool TaskSafeSensorManager::getAggregatedData(SensorReadings& readings, uint32_t timeoutMs) {
+    if (!aggregatedDataQueue) {
+        return false;
+    }
+    return xQueueReceive(aggregatedDataQueue, &readings, pdMS_TO_TICKS(timeoutMs)) == pdPASS;
+}
+
+// ---------------------------------------------------------------------------
+// Calibration
+// ---------------------------------------------------------------------------
+
+bool TaskSafeSensorManager::calibrateWeight(float knownWeight) {
+    if (!weightInitialized || knownWeight <= 0 || !takeMutex(loadCellMutex, 5000)) {
+        return false;
+    }
+    loadCell.refreshDataSet();
+    float newCalFactor = loadCell.getNewCalibration(knownWeight);
+    loadCell.setCalFactor(newCalFactor);
+    weightCalibrationFactor = newCalFactor;
+    weightHistory.clear();
+    giveMutex(loadCellMutex);
+
+    EEPROM.put(WEIGHT_EEPROM_ADDRESS, newCalFactor);
+    EEPROM.commit();
+    Serial.printf("✅ Calibration factor %.2f saved to EEPROM\n", newCalFactor);
+    return true;
+}
+
+bool TaskSafeSensorManager::tareWeight() {
+    if (!weightInitialized || !takeMutex(loadCellMutex, 5000)) {
+        return false;
+    }
+    // getTareStatus() reports completion once, so poll it into a flag
+    loadCell.tareNoDelay();
+    uint32_t startMs = millis();
+    bool done = false;
+    while (!done && millis() - startMs < 3000) {
+        loadCell.update();
+        done = loadCell.getTareStatus();
+        if (!done) delay(10);
+    }
+    weightHistory.clear();
+    giveMutex(loadCellMutex);
+    Serial.println(done ? "✅ Weight sensor tare complete" : "❌ Weight sensor tare timed out");
+    return done;
+}
+
+bool TaskSafeSensorManager::calibrateTemperature(float knownTemperature) {
+    if (!temperatureInitialized || !temperaturePipeline.hasReading() || !temperaturePipeline.channel(0).valid) {
+        return false;
+    }
+    temperatureOffset = knownTemperature - temperaturePipeline.channel(0).celsius;
+    lastTemperature = 0;
+    Serial.printf("🔧 Temperature offset set to %.2f°C\n", temperatureOffset);
+    return true;
+}
+
+bool TaskSafeSensorManager::calibrateBioimpedance(float knownResistance) {
+    if (!bioimpedanceInitialized || !takeMutex(spiMutex, 5000)) {
+        return false;
+    }
+    bioimpedanceCalibrated = biaApp.calibrate(knownResistance);
+    giveMutex(spiMutex);
+    return bioimpedanceCalibrated;
+}
+
+bool TaskSafeSensorManager::performBIASweep(BIAResult* results, uint32_t maxResults, uint32_t* actualCount) {
+    if (!bioimpedanceInitialized || !results || !actualCount || !takeMutex(spiMutex, 5000)) {
+        return false;
+    }
+    bool ok = biaApp.performFrequencySweep(results, maxResults, actualCount);
+    giveMutex(spiMutex);
+    return ok;
+}
+
+// ---------------------------------------------------------------------------
+// Diagnostics
+// ---------------------------------------------------------------------------
+
+String TaskSafeSensorManager::getSensorStatus() {
+    String status = "Sensors (tasks): ";
+    status += heartRateInitialized ? "HR✅ " : "HR❌ ";
+    status += temperatureInitialized ? "TEMP✅ " : "TEMP❌ ";
+    status += weightInitialized ? "WEIGHT✅ " : "WEIGHT❌ ";
+    status += bioimpedanceInitialized ? "BIO✅" : "BIO❌";
+    return status;
+}
+
+String TaskSafeSensorManager::getBIAStatus() {
+    if (!bioimpedanceInitialized) {
+        return "BIA: Not initialized";
+    }
+    return bioimpedanceCalibrated ? "BIA: Calibrated" : "BIA: Ready for measurements";
+}
+
+bool TaskSafeSensorManager::allSensorsReady() {
+    return heartRateInitialized && temperatureInitialized && weightInitialized && bioimpedanceInitialized;
+}
+
+void TaskSafeSensorManager::printSensorReadings(const SensorReadings& readings) {
+    displaySensorReadings(readings);
+}
+
+SensorTaskMetrics TaskSafeSensorManager::getTaskMetrics(uint8_t sensorType) {
+    SensorTaskMetrics metrics = {};
+    if (sensorType <= SENSOR_BIOIMPEDANCE) {
+        metrics = taskMetrics[sensorType];
+    }
+    return metrics;
+}
+
+AggregatorMetrics TaskSafeSensorManager::getAggregatorMetrics() {
+    return aggregatorMetrics;
+}
+
+void TaskSafeSensorManager::printTaskStats() {
+    Serial.println("\n=== SENSOR TASK STATS ===");
+    Serial.println("sensor        published  errors  loop(us) max(us)  busWait(us)");
+    for (uint8_t i = 0; i <= SENSOR_BIOIMPEDANCE; i++) {
+        const SensorTaskMetrics& m = taskMetrics[i];
+        Serial.printf("%-13s %9lu %7lu %9lu %7lu %11lu\n", SENSOR_NAMES[i], (unsigned long)m.published,
+                      (unsigned long)m.errors, (unsigned long)m.lastLoopUs, (unsigned long)m.maxLoopUs,
+                      (unsigned long)m.maxBusWaitUs);
+    }
+
+    const AggregatorMetrics& a = aggregatorMetrics;
+    uint32_t meanJitter = a.cycles > 1 ? (uint32_t)(a.totalJitterUs / (a.cycles - 1)) : 0;
+    Serial.printf("Aggregator: %lu cycles @ %d ms, period %lu us, jitter mean %lu us / max %lu us, dropped %lu\n",
+                  (unsigned long)a.cycles, TASK_SAFE_AGGREGATOR_PERIOD_MS, (unsigned long)a.lastPeriodUs,
+                  (unsigned long)meanJitter, (unsigned long)a.maxJitterUs, (unsigned long)a.droppedSnapshots);
+}
+
+// ---------------------------------------------------------------------------
+// Error handling and power
+// ---------------------------------------------------------------------------
+
+bool TaskSafeSensorManager::resetSensor(uint8_t sensorType) {
+    switch (sensorType) {
+        case SENSOR_HEART_RATE:
+            spo2Window.reset();
+            heartRateInitialized = initializeHeartRateSensor();
+            return heartRateInitialized;
+        case SENSOR_TEMPERATURE:
+            temperatureInitialized = initializeTemperatureSensor();
+            return temperatureInitialized;
+        case SENSOR_WEIGHT: {
+            if (!takeMutex(loadCellMutex, 5000)) {
+                return false;
+            }
+            weightInitialized = initializeWeightSensor();
+            weightHistory.clear();
+            giveMutex(loadCellMutex);
+            return weightInitialized;
+        }
+        case SENSOR_BIOIMPEDANCE:
+            bioimpedanceInitialized = initializeBioimpedanceSensor();
+            return bioimpedanceInitialized;
+        default:
+            return false;
+    }
+}
+
+void TaskSafeSensorManager::handleSensorError(uint8_t sensorType, const String& error) {
+    const char* name = sensorType <= SENSOR_BIOIMPEDANCE ? SENSOR_NAMES[sensorType] : "unknown";
+    Serial.printf("⚠️ Sensor error (%s): %s\n", name, error.c_str());
+    if (sensorType <= SENSOR_BIOIMPEDANCE) {
+        taskMetrics[sensorType].errors++;
+    }
+    if (!resetSensor(sensorType)) {
+        Serial.printf("❌ Reset of %s failed\n", name);
+    }
+}
+
+bool TaskSafeSensorManager::enterLowPowerMode() {
+    if (heartRateInitialized && takeMutex(i2cMutex)) {
+        heartRateSensor.shutDown();
+        giveMutex(i2cMutex);
+    }
+    if (weightInitialized && takeMutex(loadCellMutex, 1000)) {
+        if (weightTaskHandle) vTaskSuspend(weightTaskHandle);
+        loadCell.powerDown();
+        giveMutex(loadCellMutex);
+    }
+    if (heartRateTaskHandle) vTaskSuspend(heartRateTaskHandle);
+    if (bioimpedanceTaskHandle) vTaskSuspend(bioimpedanceTaskHandle);
+    return true;
+}
+
+bool TaskSafeSensorManager::exitLowPowerMode() {
+    if (heartRateInitialized && takeMutex(i2cMutex)) {
+        heartRateSensor.wakeUp();
+        giveMutex(i2cMutex);
+    }
+    if (weightInitialized) {
+        loadCell.powerUp();
+        if (weightTaskHandle) vTaskResume(weightTaskHandle);
+    }
+    if (heartRateTaskHandle) vTaskResume(heartRateTaskHandle);
+    if (bioimpedanceTaskHandle) vTaskResume(bioimpedanceTaskHandle);
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// Validation and helpers
+// ---------------------------------------------------------------------------
+
+bool TaskSafeSensorManager::validateHeartRateReading(const HeartRateData& data) {
+    return (data.heartRate >= 30 && data.heartRate <= 220) && (data.spO2 >= 70 && data.spO2 <= 100);
+}
+
+bool TaskSafeSensorManager::validateTemperatureReading(const TemperatureData& data) {
+    return data.temperature >= 20.0 && data.temperature <= 45.0;
+}
+
+bool TaskSafeSensorManager::validateWeightReading(const WeightData& data) {
+    return data.weight >= 0.1 && data.weight <= 500.0;
+}
+
+bool TaskSafeSensorManager::validateBioimpedanceReading(const BioimpedanceData& data) {
+    return data.impedance >= 10.0 && data.impedance <= 10000.0;
+}
+
+void TaskSafeSensorManager::calculateSpO2AndHeartRate(uint32_t* irBuffer, uint32_t* redBuffer,
+                                                      int32_t bufferLength, int32_t* spo2,
+                                                      int8_t* validSPO2, int32_t* heartRate,
+                                                      int8_t* validHeartRate) {
+    maxim_heart_rate_and_oxygen_saturation(irBuffer, bufferLength, redBuffer, spo2, validSPO2, heartRate, validHeartRate);
+}
+
+float TaskSafeSensorManager::filterTemperature(float newReading, float previousReading) {
+    // Light exponential smoothing; the first reading passes straight through
+    if (previousReading == 0) {
+        return newReading;
+    }
+    return previousReading + 0.5f * (newReading - previousReading);
+}
+
+bool TaskSafeSensorManager::isWeightStable(const WeightHistory& history) {
+    if (!history.full()) {
+        return false;
+    }
+    return history.range() < 0.1f;  // kg
+}
+
+bool TaskSafeSensorManager::takeMutex(SemaphoreHandle_t mutex, uint32_t timeoutMs) {
+    return mutex != NULL && xSemaphoreTake(mutex, pdMS_TO_TICKS(timeoutMs)) == pdTRUE;
+}
+
+bool TaskSafeSensorManager::takeBus(SemaphoreHandle_t mutex, uint8_t sensorType, uint32_t timeoutMs) {
+    uint32_t startUs = micros();
+    if (!takeMutex(mutex, timeoutMs)) {
+        taskMetrics[sensorType].errors++;
+        return false;
+    }
+    uint32_t waitUs = micros() - startUs;
+    if (waitUs > taskMetrics[sensorType].maxBusWaitUs) {
+        taskMetrics[sensorType].maxBusWaitUs = waitUs;
+    }
+    return true;
+}
+
+void TaskSafeSensorManager::giveMutex(SemaphoreHandle_t mutex) {
+    if (mutex != NULL) {
+        xSemaphoreGive(mutex);
+    }
+}
+
+void TaskSafeSensorManager::recordLoop(uint8_t sensorType, uint32_t startUs) {
+    SensorTaskMetrics& metrics = taskMetrics[sensorType];
+    metrics.lastLoopUs = micros() - startUs;
+    if (metrics.lastLoopUs > metrics.maxLoopUs) {
+        metrics.maxLoopUs = metrics.lastLoopUs;
+    }
+}
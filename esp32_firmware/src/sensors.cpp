@@ -1,24 +1,25 @@
 #include "sensors.h"
+#include <esp_timer.h>
 
-SensorManager::SensorManager() : oneWire(DS18B20_PIN), temperatureSensor(&oneWire), loadCell(WEIGHT_SENSOR_DOUT, WEIGHT_SENSOR_SCK) {
-    // Constructor - Initialize ECG buffer
-    for (int i = 0; i < ECG_FILTER_SIZE; i++) {
-        ecgBuffer[i] = 0;
-    }
-    ecgBufferIndex = 0;
-    lastPeakTime = 0;
+SensorManager* SensorManager::streamInstance = nullptr;
+
+static_assert(RollingPPGWindow::LENGTH == BUFFER_SIZE, "spo2_algorithm expects 4 s at 25 Hz");
+
+static uint32_t schedulerClockUs() {
+    return micros();
+}
+
+SensorManager::SensorManager() : oneWire(DS18B20_PIN), temperatureSensor(&oneWire), loadCell(WEIGHT_SENSOR_DOUT, WEIGHT_SENSOR_SCK),
+                                 ppgBus(Wire), ppgAcquisition(ppgBus), ecgAcquisition(ecgFrontEnd),
+                                 temperatureBus(temperatureSensor), temperaturePipeline(temperatureBus),
+                                 scheduler(schedulerClockUs) {
     currentBPM = 0;
     
     // Initialize calibration values
     temperatureOffset = 5.0;  // Default +5°C offset as specified in user code
     
-    // Initialize glucose monitoring buffers
-    for (int i = 0; i < GLUCOSE_WINDOW_SIZE; i++) {
-        glucoseIrReadings[i] = 0;
-        glucoseRedReadings[i] = 0;
-    }
-    glucoseReadIndex = 0;
     glucoseLastReading = 0;
+    registerPPGConsumers();
 }
 
 bool SensorManager::begin() {
@@ -118,9 +119,252 @@ bool SensorManager::initializeHeartRateSensor() {
     heartRateSensor.setPulseAmplitudeRed(0x0A);  // Turn Red LED to low to indicate sensor is running
     heartRateSensor.setPulseAmplitudeGreen(0);   // Turn off Green LED
     
+    if (!startPPGStreaming()) {
+        return false;
+    }
+    resetPPGHeartRate();
+    ppgFanout.setEnabled(ppgQualityConsumer, true);
+    ppgFanout.setEnabled(ppgHeartRateConsumer, true);
     return true;
 }
 
+bool SensorManager::startPPGStreaming() {
+    if (ppgStreaming) {
+        return ppgAcquisition.restart();
+    }
+
+    PPGAcquisitionConfig config;
+    config.sampleRateHz = PPG_STREAM_SAMPLE_RATE;
+    config.redAmplitude = PPG_STREAM_RED_AMPLITUDE;
+    config.irAmplitude = PPG_STREAM_IR_AMPLITUDE;
+    if (!ppgAcquisition.begin(config)) {
+        Serial.println("❌ Failed to configure MAX30102 FIFO streaming");
+        return false;
+    }
+    
+    // The stream is configured once for every consumer; the fan-out only asks
+    // for a restart when LED currents or the sample rate have to change
+    PPGLedRange range = {PPG_DC_LOW, PPG_DC_HIGH, PPG_NO_CONTACT_DC,
+                         (uint32_t)PPG_LED_RANGING_WINDOW_MS * ppgAcquisition.sampleRateHz() / 1000};
+    ppgFanout.begin({ppgAcquisition.sampleRateHz(), config.redAmplitude, config.irAmplitude}, range);
+
+    streamInstance = this;
+    pinMode(MAX30102_INT_PIN, INPUT_PULLUP);  // INT is open-drain, active low
+
+    if (xTaskCreatePinnedToCore(ppgAcquisitionTask, "PPGAcqTask", PPG_STREAM_TASK_STACK,
+                                this, PPG_STREAM_TASK_PRIORITY, &ppgTaskHandle, 0) != pdPASS) {
+        Serial.println("❌ Failed to create PPG acquisition task");
+        return false;
+    }
+
+    attachInterrupt(digitalPinToInterrupt(MAX30102_INT_PIN), onPPGInterrupt, FALLING);
+    ppgStreaming = true;
+
+    Serial.printf("✅ MAX30102 streaming at %d Hz (FIFO almost-full interrupt on GPIO %d)\n",
+                  ppgAcquisition.sampleRateHz(), MAX30102_INT_PIN);
+    return true;
+}
+
+void IRAM_ATTR SensorManager::onPPGInterrupt() {
+    if (streamInstance == nullptr || streamInstance->ppgTaskHandle == NULL) {
+        return;
+    }
+    streamInstance->ppgAcquisition.onInterrupt();
+
+    BaseType_t higherPriorityTaskWoken = pdFALSE;
+    vTaskNotifyGiveFromISR(streamInstance->ppgTaskHandle, &higherPriorityTaskWoken);
+    if (higherPriorityTaskWoken) {
+        portYIELD_FROM_ISR();
+    }
+}
+
+void SensorManager::ppgAcquisitionTask(void* parameter) {
+    SensorManager* self = static_cast<SensorManager*>(parameter);
+    // Fall back to polling just before the FIFO would fill if an INT edge is missed
+    TickType_t fallback = pdMS_TO_TICKS(self->ppgAcquisition.pollIntervalUs() / 1000);
+    if (fallback == 0) fallback = 1;
+
+    while (true) {
+        ulTaskNotifyTake(pdTRUE, fallback);
+        // All bus traffic for the stream stays in this task, including restarts
+        if (self->ppgReconfigurePending.exchange(false, std::memory_order_acquire)) {
+            self->ppgAcquisition.begin(self->pendingPPGConfig);
+            fallback = pdMS_TO_TICKS(self->ppgAcquisition.pollIntervalUs() / 1000);
+            if (fallback == 0) fallback = 1;
+        }
+        self->ppgAcquisition.service(esp_timer_get_time());
+    }
+}
+
+void SensorManager::processPPGStream() {
+    if (!ppgStreaming) {
+        return;
+    }
+
+    PPGSample batch[32];
+    size_t count;
+    while ((count = ppgAcquisition.read(batch, 32)) > 0) {
+        // HR/SpO2, glucose and BP/PTT all see every sample
+        ppgFanout.dispatch(batch, count);
+        latestPPG = batch[count - 1];
+    }
+
+    // Wait for a previous restart to be applied before judging the new settings
+    PPGStreamProfile profile;
+    if (!ppgReconfigurePending.load(std::memory_order_acquire) && ppgFanout.reconcile(profile)) {
+        pendingPPGConfig.sampleRateHz = profile.sampleRateHz;
+        pendingPPGConfig.redAmplitude = profile.redAmplitude;
+        pendingPPGConfig.irAmplitude = profile.irAmplitude;
+        ppgReconfigurePending.store(true, std::memory_order_release);
+        xTaskNotifyGive(ppgTaskHandle);
+        Serial.printf("🔄 MAX30102 stream reconfigured: %d Hz, LED red 0x%02X, IR 0x%02X\n",
+                      profile.sampleRateHz, profile.redAmplitude, profile.irAmplitude);
+    }
+}
+
+void SensorManager::registerPPGConsumers() {
+    // Consumers start disabled and are switched on as each measurement initializes.
+    // Signal quality goes first, so the others gate on the window it just closed.
+    ppgQualityConsumer = ppgFanout.addConsumer("signal_quality", qualityPPGConsumer, this);
+    ppgHeartRateConsumer = ppgFanout.addConsumer("heart_rate", heartRatePPGConsumer, this, PPG_HR_MIN_SAMPLE_RATE);
+    ppgGlucoseConsumer = ppgFanout.addConsumer("glucose", glucosePPGConsumer, this, PPG_GLUCOSE_MIN_SAMPLE_RATE);
+    ppgBloodPressureConsumer = ppgFanout.addConsumer("blood_pressure", bloodPressurePPGConsumer, this, PPG_BP_MIN_SAMPLE_RATE);
+    ppgFanout.setEnabled(ppgQualityConsumer, false);
+    ppgFanout.setEnabled(ppgHeartRateConsumer, false);
+    ppgFanout.setEnabled(ppgGlucoseConsumer, false);
+    ppgFanout.setEnabled(ppgBloodPressureConsumer, false);
+}
+
+void SensorManager::heartRatePPGConsumer(void* context, const PPGSample* samples, size_t count) {
+    SensorManager* self = static_cast<SensorManager*>(context);
+    for (size_t i = 0; i < count; i++) {
+        self->ppgWindowIrSum += samples[i].ir;
+        // Maxim's estimate once a second over the newest 4 s
+        if (self->spo2Window.addSample(samples[i].red, samples[i].ir, samples[i].timestampUs)) {
+            self->updateMaximSpO2();
+        }
+    }
+    self->ppgWindowCount += count;
+
+    if (count > 0 && self->spectralHeartRate.addBlock(samples, count) > 0) {
+        const SpectralEstimate& estimate = self->spectralHeartRate.getEstimate();
+        if (estimate.heartRateValid && !self->ppgQuality.isLowQuality(SQI_MIN_SCORE)) {
+            self->heartRateFusion.update(HR_SOURCE_PPG_SPECTRAL, estimate.heartRateBpm, estimate.confidence,
+                                         samples[count - 1].timestampUs);
+        } else {
+            self->heartRateFusion.invalidate(HR_SOURCE_PPG_SPECTRAL);
+        }
+    }
+}
+
+void SensorManager::updateMaximSpO2() {
+    // Not worth the search on a window the PPG SQI scored low
+    if (ppgQuality.isLowQuality(SQI_MIN_SCORE)) {
+        maximSpO2Valid = false;
+        heartRateFusion.invalidate(HR_SOURCE_PPG_MAXIM);
+        return;
+    }
+    
+    int32_t spo2 = 0;
+    int32_t heartRate = 0;
+    int8_t spo2Valid = 0;
+    int8_t heartRateValid = 0;
+    maxim_heart_rate_and_oxygen_saturation(spo2Window.irWindow(), RollingPPGWindow::LENGTH, spo2Window.redWindow(),
+                                           &spo2, &spo2Valid, &heartRate, &heartRateValid);
+
+    maximSpO2 = spo2;
+    maximSpO2Valid = spo2Valid && spo2 > 0 && spo2 <= 100;
+    if (heartRateValid) {
+        heartRateFusion.update(HR_SOURCE_PPG_MAXIM, heartRate, HR_FUSION_MAXIM_CONFIDENCE, spo2Window.windowEndUs());
+    } else {
+        heartRateFusion.invalidate(HR_SOURCE_PPG_MAXIM);
+    }
+}
+
+void SensorManager::resetPPGHeartRate() {
+    spectralHeartRate.reset();
+    spo2Window.reset();
+    maximSpO2 = 0;
+    maximSpO2Valid = false;
+    heartRateFusion.invalidate(HR_SOURCE_PPG_SPECTRAL);
+    heartRateFusion.invalidate(HR_SOURCE_PPG_MAXIM);
+    ppgQuality.reset();
+    ppgQualityPipeline.reset();
+}
+
+void SensorManager::glucosePPGConsumer(void* context, const PPGSample* samples, size_t count) {
+    SensorManager* self = static_cast<SensorManager*>(context);
+    for (size_t i = 0; i < count; i++) {
+        self->glucoseWindowIrSum += samples[i].ir;
+        self->glucoseWindowRedSum += samples[i].red;
+    }
+    self->glucoseWindowCount += count;
+}
+
+void SensorManager::bloodPressurePPGConsumer(void* context, const PPGSample* samples, size_t count) {
+    SensorManager* self = static_cast<SensorManager*>(context);
+    self->bpMonitor.addPPGBlock(samples, count);
+}
+
+void SensorManager::qualityPPGConsumer(void* context, const PPGSample* samples, size_t count) {
+    SensorManager* self = static_cast<SensorManager*>(context);
+    static const size_t BLOCK_SIZE = 32;
+    float values[BLOCK_SIZE];
+    uint64_t times[BLOCK_SIZE];
+    PPGQualityEvents events = {*self};
+    
+    while (count > 0) {
+        size_t n = count < BLOCK_SIZE ? count : BLOCK_SIZE;
+        // Raw IR counts for clipping and the DC level, then negated so systole rises
+        for (size_t i = 0; i < n; i++) {
+            values[i] = (float)samples[i].ir;
+            times[i] = samples[i].timestampUs;
+        }
+        self->ppgQuality.addRawBlock(values, n);
+        for (size_t i = 0; i < n; i++) {
+            values[i] = -values[i];
+        }
+        SampleBlock block = {values, times, n};
+        self->ppgQualityPipeline.process(block, events);
+        
+        samples += n;
+        count -= n;
+    }
+}
+
+void SensorManager::PPGQualityEvents::on(const TappedBlock<PPG_TAP_FILTERED>& tap) {
+    if (self.ppgQuality.addBlock(tap.block.values, tap.block.timestampsUs, tap.block.count)) {
+        self.shareSignalQuality();
+    }
+}
+
+void SensorManager::PPGQualityEvents::on(const PulseFiducials& beat) {
+    self.ppgQuality.addBeat(beat.maxSlopeUs);
+}
+
+void SensorManager::shareSignalQuality() {
+    if (bpMonitorInitialized) {
+        bpMonitor.setSignalQuality(ecgQuality.getIndex(), ppgQuality.getIndex());
+    }
+}
+
+PPGAcquisitionStats SensorManager::getPPGStats() {
+    return ppgAcquisition.getStats();
+}
+
+void SensorManager::printPPGStreamStats() {
+    const PPGStreamProfile& profile = ppgFanout.getProfile();
+    Serial.printf("📊 PPG stream: %d Hz, LED red 0x%02X, IR 0x%02X, %lu reconfigurations\n",
+                  profile.sampleRateHz, profile.redAmplitude, profile.irAmplitude,
+                  (unsigned long)ppgFanout.reconfigurationCount());
+    for (int i = 0; i < ppgFanout.consumerCount(); i++) {
+        PPGConsumerStats stats = ppgFanout.getStats(i);
+        Serial.printf("   %-15s %s  %lu samples in %lu batches (needs >= %d Hz)\n",
+                      stats.name, stats.enabled ? "✅" : "⏸️",
+                      (unsigned long)stats.samples, (unsigned long)stats.batches, stats.minSampleRateHz);
+    }
+}
+
 bool SensorManager::initializeTemperatureSensor() {
     Serial.println("🌡️ Initializing DS18B20 temperature sensor...");
     
@@ -136,13 +380,20 @@ bool SensorManager::initializeTemperatureSensor() {
     
     Serial.printf("✅ Found %d DS18B20 sensor(s)\n", deviceCount);
     
-    // Set resolution to 12-bit for maximum precision (0.0625°C resolution)
-    temperatureSensor.setResolution(12);
-    
     // Set wait for conversion to false for non-blocking operation
     temperatureSensor.setWaitForConversion(false);
     
-    Serial.println("✅ DS18B20 temperature sensor initialized successfully");
+    // Cache ROM addresses and set resolution (12-bit = 0.0625°C) on each sensor
+    if (temperaturePipeline.begin(DS18B20_RESOLUTION, DS18B20_CONVERSION_INTERVAL) == 0) {
+        Serial.println("❌ Could not read DS18B20 ROM addresses");
+        return false;
+    }
+    
+    // Kick off the first conversion so a value is ready on a later tick
+    temperaturePipeline.update(millis());
+    
+    Serial.printf("✅ DS18B20 temperature sensor initialized successfully (%d-bit, %lu ms conversions)\n",
+                  temperaturePipeline.resolutionBits(), (unsigned long)temperaturePipeline.conversionTimeMs());
     return true;
 }
 
@@ -215,17 +466,13 @@ bool SensorManager::initializeBioimpedanceSensor() {
 bool SensorManager::initializeECGSensor() {
     Serial.println("🔄 Initializing AD8232 ECG sensor...");
     
-    // Configure ECG pins
-    pinMode(LO_PLUS_PIN, INPUT);
-    pinMode(LO_MINUS_PIN, INPUT);
-    pinMode(ECG_PIN, INPUT);
+    // Configure ECG pins and ADC1 channel
+    ecgFrontEnd.begin();
     
-    // Initialize the filter buffer
-    for (int i = 0; i < ECG_FILTER_SIZE; i++) {
-        ecgBuffer[i] = 0;
-    }
-    ecgBufferIndex = 0;
-    lastPeakTime = 0;
+    // Start the filters and QRS thresholds afresh
+    ecgPipeline.reset();
+    ecgQuality.reset();
+    ecgPipelineFed = false;
     currentBPM = 0;
     
     // Test ADC reading
@@ -235,42 +482,193 @@ bool SensorManager::initializeECGSensor() {
         return false;
     }
       Serial.println("✅ AD8232 ECG sensor initialized");
+    return startECGStreaming();
+}
+
+bool SensorManager::startECGStreaming() {
+    if (ecgStreaming) {
+        return true;
+    }
+
+    streamInstance = this;
+    if (xTaskCreatePinnedToCore(ecgSamplingTask, "ECGSampleTask", ECG_STREAM_TASK_STACK,
+                                this, ECG_STREAM_TASK_PRIORITY, &ecgTaskHandle, 0) != pdPASS) {
+        Serial.println("❌ Failed to create ECG sampling task");
+        return false;
+    }
+
+    ECGAcquisitionConfig config;
+    config.sampleRateHz = ECG_STREAM_SAMPLE_RATE;
+    config.blockSize = ECG_STREAM_BLOCK_SIZE;
+    ecgAcquisition.begin(config, 0);  // Clamps the rate and derives the sample period
+
+    // 80 MHz APB / 80 = 1 MHz timer, alarm every sample period
+    ecgTimer = timerBegin(ECG_STREAM_TIMER, 80, true);
+    if (ecgTimer == NULL) {
+        Serial.println("❌ Failed to allocate ECG sample timer");
+        return false;
+    }
+    timerAttachInterrupt(ecgTimer, onECGTimer, true);
+    timerAlarmWrite(ecgTimer, ecgAcquisition.samplePeriodUs(), true);
+    // The first alarm fires one period after the timer starts: anchor the grid there
+    ecgAcquisition.begin(config, esp_timer_get_time() + ecgAcquisition.samplePeriodUs());
+    timerAlarmEnable(ecgTimer);
+    ecgStreaming = true;
+
+    Serial.printf("✅ AD8232 streaming at %d Hz in %d-frame blocks (lead-off sampled per frame)\n",
+                  ecgAcquisition.sampleRateHz(), ecgAcquisition.blockSize());
     return true;
 }
 
+void IRAM_ATTR SensorManager::onECGTimer() {
+    if (streamInstance == nullptr || streamInstance->ecgTaskHandle == NULL) {
+        return;
+    }
+    streamInstance->ecgAcquisition.onTimerTick();
+
+    BaseType_t higherPriorityTaskWoken = pdFALSE;
+    vTaskNotifyGiveFromISR(streamInstance->ecgTaskHandle, &higherPriorityTaskWoken);
+    if (higherPriorityTaskWoken) {
+        portYIELD_FROM_ISR();
+    }
+}
+
+void SensorManager::ecgSamplingTask(void* parameter) {
+    SensorManager* self = static_cast<SensorManager*>(parameter);
+
+    while (true) {
+        // ADC reads are not ISR-safe, so the timer only wakes this task
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        self->ecgAcquisition.service();
+    }
+}
+
+template <typename Events>
+bool SensorManager::processECGFrames(const ECGFrame* frames, size_t count, Events& events) {
+    float values[ECGAcquisition::MAX_BLOCK_SIZE];
+    uint64_t times[ECGAcquisition::MAX_BLOCK_SIZE];
+    size_t n = 0;
+    bool leadOff = false;
+
+    for (size_t i = 0; i <= count; i++) {
+        bool off = i < count && frames[i].leadOff != ECGLeadOff::NONE;
+        if (i < count && !off) {
+            values[n] = frames[i].raw;
+            times[n] = frames[i].timestampUs;
+            n++;
+            continue;
+        }
+        if (n > 0) {
+            SampleBlock block = {values, times, n};
+            ecgPipeline.process(block, events);
+            ecgPipelineFed = true;
+            n = 0;
+        }
+        // After lead-off the electrodes settle from a new level: prime the
+        // band-pass there and relearn the QRS thresholds
+        if (off) {
+            leadOff = true;
+            if (ecgPipelineFed) {
+                ecgPipeline.reset();
+                ecgQuality.reset();
+                ecgPipelineFed = false;
+            }
+        }
+    }
+    return leadOff;
+}
+
+void SensorManager::ECGStreamEvents::on(const TappedBlock<ECG_TAP_RAW>& tap) {
+    // ADC counts, clipped at the rails
+    self.ecgQuality.addRawBlock(tap.block.values, tap.block.count);
+}
+
+void SensorManager::ECGStreamEvents::on(const TappedBlock<ECG_TAP_AVERAGED>& tap) {
+    // Average of the last ECG_FILTER_SIZE readings, summed for readECG()
+    for (size_t i = 0; i < tap.block.count; i++) {
+        self.ecgWindowFilteredSum += (int)tap.block.values[i];
+    }
+}
+
+void SensorManager::ECGStreamEvents::on(const TappedBlock<ECG_TAP_FILTERED>& tap) {
+    if (self.ecgQuality.addBlock(tap.block.values, tap.block.timestampsUs, tap.block.count)) {
+        self.shareSignalQuality();
+    }
+    // The BP monitor keeps the band-passed ECG for PTT and correlation
+    if (self.bpMonitorInitialized) {
+        self.bpMonitor.addFilteredECG(tap.block.values, tap.block.timestampsUs, tap.block.count);
+    }
+}
+
+void SensorManager::ECGStreamEvents::on(const QrsEvent& beat) {
+    // R-peaks drive the BPM, and HRV/PTT in the BP monitor
+    QrsDetector& qrs = self.ecgQrs();
+    self.currentBPM = (int)(qrs.getHeartRate() + 0.5f);
+    self.ecgWindowPeaks++;
+    self.ecgQuality.addBeat(beat.timeUs);
+    if (!qrs.isLearning() && !self.ecgQuality.isLowQuality(SQI_MIN_SCORE)) {
+        self.heartRateFusion.update(HR_SOURCE_ECG, qrs.getHeartRate(), HR_FUSION_ECG_CONFIDENCE, beat.timeUs);
+    }
+    if (self.bpMonitorInitialized) {
+        self.bpMonitor.addRPeak(beat);
+    }
+}
+
+void SensorManager::ECGDisplayEvents::on(const TappedBlock<ECG_TAP_AVERAGED>& tap) {
+    for (size_t i = 0; i < tap.block.count && averagedCount < ECGAcquisition::MAX_BLOCK_SIZE; i++) {
+        averaged[averagedCount++] = tap.block.values[i];
+    }
+}
+
+void SensorManager::ECGDisplayEvents::on(const QrsEvent& beat) {
+    peakDetected = true;
+    peakCount++;
+    if (firstBeatUs == 0) firstBeatUs = beat.timeUs;
+    lastBeatUs = beat.timeUs;
+}
+
+void SensorManager::processECGStream() {
+    if (!ecgStreaming) {
+        return;
+    }
+
+    ECGFrame block[ECGAcquisition::MAX_BLOCK_SIZE];
+    ECGStreamEvents events = {*this};
+    size_t count;
+    while ((count = ecgAcquisition.readBlock(block)) > 0) {
+        if (processECGFrames(block, count, events)) {
+            ecgWindowLeadOff = true;
+            heartRateFusion.invalidate(HR_SOURCE_ECG);
+        }
+        ecgWindowBPMSum += (int64_t)currentBPM * count;
+        ecgWindowCount += count;
+    }
+}
+
+ECGAcquisitionStats SensorManager::getECGStats() {
+    return ecgAcquisition.getStats();
+}
+
 bool SensorManager::initializeGlucoseSensor() {
-    Serial.println("🔄 Initializing MAX30102 for glucose estimation mode...");
-    
-    // Enable internal pull-up resistors for I2C pins (backup if external pull-ups missing)
-    pinMode(MAX30102_SDA_PIN, INPUT_PULLUP);
-    pinMode(MAX30102_SCL_PIN, INPUT_PULLUP);
-    delay(100); // Allow pins to stabilize
+    Serial.println("🔄 Initializing glucose estimation on the MAX30102 stream...");
     
-    // Use the same I2C bus as heart rate sensor - single MAX30102 approach
-    // No need for Wire1.begin() - already initialized in heart rate sensor init
-    
-    if (!glucoseSensor.begin(Wire, I2C_SPEED_FAST)) {
-        Serial.println("❌ Cannot initialize MAX30102 in glucose mode");
+    // Glucose features come from the same PPG stream as HR/SpO2, so the part
+    // is not reprogrammed here; it just has to be streaming already
+    if (!ppgStreaming) {
+        Serial.println("❌ Glucose estimation needs the MAX30102 stream");
         Serial.println("   Ensure heart rate sensor is properly initialized first");
         return false;
     }
     
-    // Configure for glucose estimation mode - different settings than HR/SpO2
-    glucoseSensor.setup();
-    glucoseSensor.setPulseAmplitudeRed(0x0A);  // Low power for glucose monitoring
-    glucoseSensor.setPulseAmplitudeIR(0x0A);   // Low power for glucose monitoring
-    
-    // Initialize glucose monitoring arrays
-    for (int i = 0; i < GLUCOSE_WINDOW_SIZE; i++) {
-        glucoseIrReadings[i] = 0;
-        glucoseRedReadings[i] = 0;
-    }
-    glucoseReadIndex = 0;
-    glucoseMaxIR = 0;
-    glucoseMinIR = UINT32_MAX;
-    glucoseMaxRed = 0;
-    glucoseMinRed = UINT32_MAX;
+    // Initialize glucose monitoring windows
+    glucoseIrReadings.clear();
+    glucoseRedReadings.clear();
     glucoseLastReading = 0;
+    glucoseWindowIrSum = 0;
+    glucoseWindowRedSum = 0;
+    glucoseWindowCount = 0;
+    ppgFanout.setEnabled(ppgQualityConsumer, true);
+    ppgFanout.setEnabled(ppgGlucoseConsumer, true);
     
     Serial.println("✅ MAX30102 Glucose sensor initialized");
     return true;
@@ -286,6 +684,8 @@ bool SensorManager::initializeBloodPressureMonitor() {
     
     // Set default user profile (can be updated later)
     bpMonitor.setPersonalParameters(30, 170.0, true);
+    ppgFanout.setEnabled(ppgQualityConsumer, true);
+    ppgFanout.setEnabled(ppgBloodPressureConsumer, true);
     
     Serial.println("✅ Blood Pressure Monitor initialized");
     Serial.println("📋 Requires calibration with reference BP measurements");
@@ -293,30 +693,220 @@ bool SensorManager::initializeBloodPressureMonitor() {
 }
 
 SensorReadings SensorManager::readAllSensors() {
-    SensorReadings readings;
-    readings.systemTimestamp = millis();
-    
-    // Read all sensors
-    readings.heartRate = readHeartRateAndSpO2();
-    readings.temperature = readTemperature();
-    readings.weight = readWeight();
-    readings.bioimpedance = readBioimpedance();
-    readings.ecg = readECG();
-    readings.glucose = readGlucose();
-    readings.bloodPressure = readBloodPressure();  // Add BP reading
-    
-    // Perform body composition analysis if bioimpedance and weight are available
-    if (readings.bioimpedance.validReading) {
-        float weight = readings.weight.validReading ? readings.weight.weight : 0;
-        readings.bodyComposition = getBodyComposition(weight);
+    // Sensors are scheduled jobs now; pump the scheduler once (test modes have
+    // no sensorTask) and return the latest completed result of each sensor
+    if (!schedulerStarted) {
+        startScheduler();
+    }
+    runScheduler();
+    return getLatestReadings();
+}
+
+// ===================================================
+// Sensor Scheduler
+// ===================================================
+
+bool SensorManager::startScheduler() {
+    if (schedulerStarted) {
+        return true;
+    }
+    
+    schedulerMutex = xSemaphoreCreateMutex();
+    if (schedulerMutex == NULL) {
+        Serial.println("❌ Failed to create sensor scheduler mutex");
+        return false;
+    }
+    
+    // Nothing is valid until each job has completed once
+    latestReadings = {};
+    unsigned long now = millis();
+    latestReadings.heartRate.timestamp = now;
+    latestReadings.temperature.timestamp = now;
+    latestReadings.weight.timestamp = now;
+    latestReadings.bioimpedance.timestamp = now;
+    latestReadings.ecg.timestamp = now;
+    latestReadings.glucose.timestamp = now;
+    latestReadings.bloodPressure.timestamp = now;
+    latestReadings.bloodPressure.needsCalibration = true;
+    latestReadings.bodyComposition.timestamp = now;
+    
+    // Stagger first releases so the jobs don't all become ready in the same tick
+    const uint32_t stagger = SENSOR_SCHEDULER_STAGGER_MS;
+    int id;
+    id = scheduler.addTask("weight", WEIGHT_INTERVAL, weightJob, this, 0);
+    scheduler.setEnabled(id, weightInitialized);
+    id = scheduler.addTask("heart_rate", HEART_RATE_INTERVAL, heartRateJob, this, stagger);
+    scheduler.setEnabled(id, heartRateInitialized);
+    id = scheduler.addTask("temperature", TEMPERATURE_INTERVAL, temperatureJob, this, 2 * stagger);
+    scheduler.setEnabled(id, temperatureInitialized);
+    id = scheduler.addTask("ecg", ECG_INTERVAL, ecgJob, this, 3 * stagger);
+    scheduler.setEnabled(id, ecgInitialized);
+    id = scheduler.addTask("glucose", GLUCOSE_INTERVAL, glucoseJob, this, 4 * stagger);
+    scheduler.setEnabled(id, glucoseInitialized);
+    id = scheduler.addTask("blood_pressure", BLOOD_PRESSURE_INTERVAL, bloodPressureJob, this, 5 * stagger);
+    scheduler.setEnabled(id, bpMonitorInitialized);
+    id = scheduler.addTask("bioimpedance", BIOIMPEDANCE_INTERVAL, bioimpedanceJob, this, 6 * stagger);
+    scheduler.setEnabled(id, bioimpedanceInitialized);
+    
+    scheduler.start(now);
+    schedulerStarted = true;
+    Serial.printf("✅ Sensor scheduler started with %d jobs (%d ms tick)\n",
+                  scheduler.taskCount(), SENSOR_SCHEDULER_TICK_MS);
+    return true;
+}
+
+void SensorManager::runScheduler() {
+    if (!schedulerStarted) {
+        return;
+    }
+    // Another task is already stepping the jobs this tick
+    if (xSemaphoreTake(schedulerMutex, 0) != pdTRUE) {
+        return;
+    }
+    
+    // Keep the streams drained even while no job needs them
+    processPPGStream();
+    processECGStream();
+    updateTemperature();
+    
+    // Latest SQI windows, for the telemetry
+    latestReadings.quality.ecg = ecgQuality.getIndex();
+    latestReadings.quality.ppg = ppgQuality.getIndex();
+    
+    scheduler.run(millis(), SENSOR_SCHEDULER_BUDGET_US);
+    xSemaphoreGive(schedulerMutex);
+}
+
+SensorReadings SensorManager::getLatestReadings() {
+    SensorReadings snapshot;
+    if (schedulerStarted && xSemaphoreTake(schedulerMutex, pdMS_TO_TICKS(100)) == pdTRUE) {
+        snapshot = latestReadings;
+        xSemaphoreGive(schedulerMutex);
     } else {
-        // Initialize empty body composition data
-        readings.bodyComposition = {};
-        readings.bodyComposition.timestamp = millis();
-        readings.bodyComposition.validReading = false;
+        snapshot = latestReadings;
+    }
+    snapshot.systemTimestamp = millis();
+    return snapshot;
+}
+
+void SensorManager::printSchedulerStats() {
+    Serial.println("\n⏱️ SENSOR SCHEDULER");
+    Serial.println("Job             Period  Done  Overrun  Skipped  Lat(ms) last/max  Step(us) last/max");
+    for (uint8_t i = 0; i < scheduler.taskCount(); i++) {
+        const SensorTaskStats& s = scheduler.getStats(i);
+        Serial.printf("%-15s %6lu %5lu %8lu %8lu %8lu/%-8lu %8lu/%-8lu\n",
+                      s.name, (unsigned long)s.periodMs, (unsigned long)s.completed,
+                      (unsigned long)s.overruns, (unsigned long)s.skippedReleases,
+                      (unsigned long)s.lastLatencyMs, (unsigned long)s.maxLatencyMs,
+                      (unsigned long)s.lastStepUs, (unsigned long)s.maxStepUs);
     }
+}
+
+SensorStepResult SensorManager::heartRateJob(void* context, uint32_t nowMs, uint32_t step) {
+    SensorManager* self = static_cast<SensorManager*>(context);
+    self->latestReadings.heartRate = self->readHeartRateAndSpO2();
+    return SENSOR_STEP_DONE;
+}
+
+SensorStepResult SensorManager::temperatureJob(void* context, uint32_t nowMs, uint32_t step) {
+    SensorManager* self = static_cast<SensorManager*>(context);
+    uint32_t conversions = self->temperaturePipeline.getStats().conversions;
     
-    return readings;
+    // Wait for a conversion that finished after this job was released
+    if (step == 0) {
+        self->temperatureConversionsAtRelease = conversions;
+    }
+    if (conversions == self->temperatureConversionsAtRelease) {
+        return SENSOR_STEP_PENDING;
+    }
+    
+    self->latestReadings.temperature = self->readTemperature();
+    return SENSOR_STEP_DONE;
+}
+
+SensorStepResult SensorManager::weightJob(void* context, uint32_t nowMs, uint32_t step) {
+    SensorManager* self = static_cast<SensorManager*>(context);
+    self->latestReadings.weight = self->readWeight();
+    return SENSOR_STEP_DONE;
+}
+
+SensorStepResult SensorManager::ecgJob(void* context, uint32_t nowMs, uint32_t step) {
+    SensorManager* self = static_cast<SensorManager*>(context);
+    self->latestReadings.ecg = self->readECG();
+    return SENSOR_STEP_DONE;
+}
+
+SensorStepResult SensorManager::glucoseJob(void* context, uint32_t nowMs, uint32_t step) {
+    SensorManager* self = static_cast<SensorManager*>(context);
+    self->latestReadings.glucose = self->readGlucose();
+    return SENSOR_STEP_DONE;
+}
+
+SensorStepResult SensorManager::bloodPressureJob(void* context, uint32_t nowMs, uint32_t step) {
+    SensorManager* self = static_cast<SensorManager*>(context);
+    self->latestReadings.bloodPressure = self->readBloodPressure();
+    return SENSOR_STEP_DONE;
+}
+
+SensorStepResult SensorManager::bioimpedanceJob(void* context, uint32_t nowMs, uint32_t step) {
+    SensorManager* self = static_cast<SensorManager*>(context);
+    // Same 1/5/10/50/100 kHz sweep as getBodyComposition(), sequenced by the AD5940
+    static const float frequencies[BIA_SWEEP_POINTS] = {1000.0f, 5000.0f, 10000.0f, 50000.0f, 100000.0f};
+    static const unsigned int BIA_REFERENCE_POINT = 2;  // 10 kHz feeds the bioimpedance reading
+    
+    if (step == 0) {
+        self->biaSweepCount = 0;
+        self->biaSweepStarted = self->biaApp.beginSweep(frequencies, BIA_SWEEP_POINTS);
+        self->biaSweepStartMs = nowMs;
+        if (self->biaSweepStarted) {
+            return SENSOR_STEP_PENDING;
+        }
+    }
+    
+    // The INT edge sets a flag, so waiting costs no SPI traffic
+    BIAResult results[BIA_SWEEP_POINTS];
+    unsigned int resultCount = 0;
+    if (self->biaSweepStarted) {
+        if (self->biaApp.isSweepReady()) {
+            resultCount = self->biaApp.finishSweep(results, BIA_SWEEP_POINTS);
+        } else if (nowMs - self->biaSweepStartMs < BIA_SWEEP_TIMEOUT_MS) {
+            return SENSOR_STEP_PENDING;
+        } else {
+            Serial.println("⚠️ BIA sweep timed out");
+            self->biaApp.cancelSweep();
+        }
+        self->biaSweepStarted = false;
+    }
+    
+    for (unsigned int i = 0; i < resultCount; i++) {
+        const BIAResult& result = results[i];
+        if (i == BIA_REFERENCE_POINT) {
+            BioimpedanceData& bia = self->latestReadings.bioimpedance;
+            bia.resistance = result.Resistance;
+            bia.reactance = result.Reactance;
+            bia.impedance = result.Magnitude;
+            bia.phase = result.Phase;
+            bia.frequency = result.Frequency;
+            bia.validReading = result.Valid && self->validateBioimpedanceReading(result.Magnitude);
+            bia.timestamp = millis();
+        }
+        if (result.Valid && result.Resistance > 10 && result.Resistance < 2000) {
+            self->biaSweepResults[self->biaSweepCount++] = result;
+        }
+    }
+    
+    // All points collected: body composition from the sweep and the latest weight
+    const WeightData& weight = self->latestReadings.weight;
+    float currentWeight = (weight.validReading && weight.stable) ? weight.weight : 0;
+    if (self->biaSweepCount > 0) {
+        self->latestReadings.bodyComposition =
+            self->analyzeBIASweep(self->biaSweepResults, self->biaSweepCount, currentWeight);
+        self->latestReadings.quality.bia = self->bodyCompositionAnalyzer.getSweepQuality();
+    } else {
+        self->latestReadings.bodyComposition.validReading = false;
+        self->latestReadings.bodyComposition.timestamp = millis();
+    }
+    return SENSOR_STEP_DONE;
 }
 
 HeartRateData SensorManager::readHeartRateAndSpO2() {
@@ -326,40 +916,32 @@ HeartRateData SensorManager::readHeartRateAndSpO2() {
         return data;
     }
 
-    // Collect fresh samples
+    // Drain whatever the acquisition task has buffered since the last call
+    processPPGStream();
+
     long irValue = 0;
-    long redValue = 0;
-    int samples = 0;
-    
-    for (int i = 0; i < 50; i++) {
-        while (!heartRateSensor.available()) {
-            heartRateSensor.check();
-        }
-        
-        uint32_t ir = heartRateSensor.getIR();
-        uint32_t red = heartRateSensor.getRed();
-        
-        // Feed data to blood pressure monitor for PPG analysis
-        if (bpMonitorInitialized) {
-            bpMonitor.addPPGSample(ir, red, millis());
-        }
-        
-        redValue += red;
-        irValue += ir;
-        samples++;
-        heartRateSensor.nextSample();
-        delay(10);
-    }
+    uint32_t samples = ppgWindowCount;
     
     if (samples > 0) {
-        irValue /= samples;
-        redValue /= samples;
+        irValue = ppgWindowIrSum / samples;
+        ppgWindowIrSum = 0;
+        ppgWindowCount = 0;
         
-        // Simple peak detection for heart rate (placeholder algorithm)        // In production, use proper heart rate calculation algorithms
         if (irValue > 50000) { // Finger detected
-            data.heartRate = 75 + random(-15, 15); // Simulated reading
-            data.spO2 = 98 + random(-3, 2);        // Simulated SpO2
-            data.validReading = validateHeartRateReading(data.heartRate, data.spO2);
+            // Heart rate fused from ECG and both PPG estimators; SpO2 from
+            // spo2_algorithm, or the spectral ratio of ratios until it has one
+            FusedHeartRate fused = heartRateFusion.fuse(esp_timer_get_time());
+            const SpectralEstimate& spectral = spectralHeartRate.getEstimate();
+            bool haveSpO2 = (maximSpO2Valid || spectral.spo2Valid) && !ppgQuality.isLowQuality(SQI_MIN_SCORE);
+            if (fused.valid && haveSpO2) {
+                data.heartRate = fused.bpm;
+                data.spO2 = maximSpO2Valid ? (float)maximSpO2 : spectral.spo2;
+                data.sources = fused.sources;
+                data.validReading = validateHeartRateReading(data.heartRate, data.spO2);
+            }
+        } else {
+            // Finger lifted: don't carry the old windows over to the next placement
+            resetPPGHeartRate();
         }
     }
     
@@ -374,14 +956,17 @@ TemperatureData SensorManager::readTemperature() {
         return data;
     }
     
-    // Request temperature reading from the DS18B20 sensor
-    temperatureSensor.requestTemperatures();
+    // Publish a finished conversion (and start the next one) without waiting
+    updateTemperature();
     
-    // Small delay to allow conversion to complete (can be removed if using async mode)
-    delay(100);
+    if (!temperaturePipeline.hasReading()) {
+        return data; // First conversion still in progress
+    }
     
-    // Get the temperature in Celsius (index 0 for first sensor)
-    float temperatureC = temperatureSensor.getTempCByIndex(0);
+    // Primary sensor is the first one found on the bus
+    const TemperatureChannel& primary = temperaturePipeline.channel(0);
+    float temperatureC = primary.valid ? primary.celsius : DEVICE_DISCONNECTED_C;
+    data.timestamp = primary.timestampMs;
       // Check if reading is valid
     if (temperatureC != DEVICE_DISCONNECTED_C) {
         // Apply calibration offset (configurable, default +5°C as specified)
@@ -400,6 +985,32 @@ TemperatureData SensorManager::readTemperature() {
     return data;
 }
 
+void SensorManager::updateTemperature() {
+    if (temperatureInitialized) {
+        temperaturePipeline.update(millis());
+    }
+}
+
+uint8_t SensorManager::getTemperatureSensorCount() {
+    return temperaturePipeline.sensorCount();
+}
+
+TemperatureData SensorManager::getTemperatureByIndex(uint8_t index) {
+    TemperatureData data = {0, false, millis()};
+    
+    if (!temperatureInitialized || index >= temperaturePipeline.sensorCount()) {
+        return data;
+    }
+    
+    const TemperatureChannel& channel = temperaturePipeline.channel(index);
+    if (channel.valid) {
+        data.temperature = channel.celsius + temperatureOffset;
+        data.validReading = validateTemperatureReading(data.temperature);
+        data.timestamp = channel.timestampMs;
+    }
+    return data;
+}
+
 WeightData SensorManager::readWeight() {
     WeightData data = {0, false, false, millis()};
     
@@ -458,74 +1069,24 @@ ECGData SensorManager::readECG() {
         return data;
     }
     
-    long sumFiltered = 0;
-    long sumBPM = 0;
-    int readingCount = 0;
-    int peakCount = 0;
-    bool leadOffDetected = false;
-    
-    unsigned long startTime = millis();
+    // Consume the blocks the sampling task produced since the last call
+    processECGStream();
     
-    // Collect readings for 5 seconds (as per original code)
-    while (millis() - startTime < 5000) {
-        int filteredValue = 0;
-        
-        // Check for noise from LO_PLUS or LO_MINUS (lead-off detection)
-        if (digitalRead(LO_PLUS_PIN) == 1 || digitalRead(LO_MINUS_PIN) == 1) {
-            filteredValue = 0;
-            leadOffDetected = true;
-        } else {
-            int rawValue = analogRead(ECG_PIN);
-            
-            // Feed ECG data to blood pressure monitor
-            if (bpMonitorInitialized) {
-                bpMonitor.addECGSample(rawValue, millis());
-            }
-            
-            // Update the circular buffer
-            ecgBuffer[ecgBufferIndex] = rawValue;
-            ecgBufferIndex = (ecgBufferIndex + 1) % ECG_FILTER_SIZE;
-            
-            // Compute the average of the last ECG_FILTER_SIZE readings
-            int sum = 0;
-            for (int i = 0; i < ECG_FILTER_SIZE; i++) {
-                sum += ecgBuffer[i];
-            }
-            filteredValue = sum / ECG_FILTER_SIZE;
-            
-            // BPM detection: detect a rising edge crossing the threshold
-            static bool peakDetected = false;
-            if (filteredValue > ecgThreshold && !peakDetected) {
-                peakDetected = true;
-                unsigned long currentTime = millis();
-                unsigned long interval = currentTime - lastPeakTime;
-                
-                if (interval > 300) { // Ensure a minimum interval between peaks (200 BPM max)
-                    currentBPM = 60000 / interval;
-                    lastPeakTime = currentTime;
-                    peakCount++;
-                }
-            } else if (filteredValue < ecgThreshold) {
-                peakDetected = false;
-            }
-        }
-        
-        // Accumulate values for averaging
-        sumFiltered += filteredValue;
-        sumBPM += currentBPM;
-        readingCount++;
-        
-        delay(50); // Wait 50ms between readings (20 Hz sampling rate)
+    // Compute averages over the window since the previous reading
+    if (ecgWindowCount > 0) {
+        data.avgFilteredValue = (float)ecgWindowFilteredSum / ecgWindowCount;
+        data.avgBPM = ecgWindowBPMSum / ecgWindowCount;
+        data.peakCount = ecgWindowPeaks;
+        data.leadOff = ecgWindowLeadOff;
+        data.validReading = validateECGReading(data.avgBPM, data.avgFilteredValue) && !ecgWindowLeadOff &&
+                            !ecgQuality.isLowQuality(SQI_MIN_SCORE);
     }
     
-    // Compute averages from the 5-second window
-    if (readingCount > 0) {
-        data.avgFilteredValue = (float)sumFiltered / readingCount;
-        data.avgBPM = sumBPM / readingCount;
-        data.peakCount = peakCount;
-        data.leadOff = leadOffDetected;
-        data.validReading = validateECGReading(data.avgBPM, data.avgFilteredValue) && !leadOffDetected;
-    }
+    ecgWindowFilteredSum = 0;
+    ecgWindowBPMSum = 0;
+    ecgWindowCount = 0;
+    ecgWindowPeaks = 0;
+    ecgWindowLeadOff = false;
       
     return data;
 }
@@ -537,9 +1098,16 @@ GlucoseData SensorManager::readGlucose() {
         return data;
     }
     
-    // Read raw IR and Red values
-    uint32_t ir = glucoseSensor.getIR();
-    uint32_t red = glucoseSensor.getRed();
+    // Mean IR and Red over the stream samples since the last read
+    processPPGStream();
+    if (glucoseWindowCount == 0) {
+        return data;
+    }
+    uint32_t ir = glucoseWindowIrSum / glucoseWindowCount;
+    uint32_t red = glucoseWindowRedSum / glucoseWindowCount;
+    glucoseWindowIrSum = 0;
+    glucoseWindowRedSum = 0;
+    glucoseWindowCount = 0;
     
     // Signal quality checks
     if (ir < GLUCOSE_MIN_SIGNAL || red < GLUCOSE_MIN_SIGNAL) {
@@ -553,8 +1121,10 @@ GlucoseData SensorManager::readGlucose() {
     }
     
     // Calculate moving averages
-    float avgIR = calculateGlucoseMovingAverage(glucoseIrReadings, (float)ir);
-    float avgRed = calculateGlucoseMovingAverage(glucoseRedReadings, (float)red);
+    glucoseIrReadings.push((float)ir);
+    glucoseRedReadings.push((float)red);
+    float avgIR = glucoseIrReadings.mean();
+    float avgRed = glucoseRedReadings.mean();
     
     // Calculate signal stability
     float irVariation = 0;
@@ -562,27 +1132,15 @@ GlucoseData SensorManager::readGlucose() {
         irVariation = abs(((float)ir - glucoseLastReading) / glucoseLastReading * 100);
     }
     
-    // Update min/max for signal quality assessment
-    glucoseMaxIR = max(glucoseMaxIR, ir);
-    glucoseMinIR = min(glucoseMinIR, ir);
-    glucoseMaxRed = max(glucoseMaxRed, red);
-    glucoseMinRed = min(glucoseMinRed, red);
-    
-    // Calculate signal quality (variation percentage)
-    float signalRange = 0;
-    if (glucoseMaxIR > 0) {
-        signalRange = ((float)(glucoseMaxIR - glucoseMinIR) / glucoseMaxIR) * 100;
-    }
-    
     // Store data
     data.irValue = avgIR;
     data.redValue = avgRed;
     data.ratio = (avgIR > 0) ? (avgRed / avgIR) : 0;
-    data.signalQuality = signalRange;
+    data.signalQuality = ppgQuality.getIndex().valid ? ppgQuality.getIndex().score : 0;
     data.stable = (irVariation < GLUCOSE_STABILITY_THRESHOLD);
     
-    // Calculate glucose only if signal is stable
-    if (data.stable && irVariation < GLUCOSE_STABILITY_THRESHOLD) {
+    // Calculate glucose only if signal is stable and the PPG SQI window passed
+    if (data.stable && data.signalQuality >= SQI_MIN_SCORE) {
         data.glucoseLevel = calculateGlucoseLevel(avgIR, avgRed);
         data.validReading = validateGlucoseReading(data.glucoseLevel, data.signalQuality);
     }
@@ -723,21 +1281,7 @@ bool SensorManager::validateECGReading(float bpm, float filteredValue) {
 }
 
 bool SensorManager::validateGlucoseReading(float glucose, float signalQuality) {
-    return (glucose >= 50 && glucose <= 500) && (signalQuality > 30); // mg/dL range and signal quality
-}
-
-// Glucose helper functions
-float SensorManager::calculateGlucoseMovingAverage(float* readings, float newValue) {
-    // Add new value to circular buffer
-    readings[glucoseReadIndex] = newValue;
-    glucoseReadIndex = (glucoseReadIndex + 1) % GLUCOSE_WINDOW_SIZE;
-    
-    // Calculate average
-    float sum = 0;
-    for (int i = 0; i < GLUCOSE_WINDOW_SIZE; i++) {
-        sum += readings[i];
-    }
-    return sum / GLUCOSE_WINDOW_SIZE;
+    return (glucose >= 50 && glucose <= 500) && (signalQuality >= SQI_MIN_SCORE); // mg/dL range and PPG SQI
 }
 
 float SensorManager::calculateGlucoseLevel(float irValue, float redValue) {
@@ -775,19 +1319,14 @@ bool SensorManager::performBIASweep(BIAResult* results, unsigned int maxResults,
     }
     
     *resultCount = 0;
-    // Perform frequency sweep measurements
+    // Perform frequency sweep measurements, one sequence on the AD5940
     float frequencies[] = {1000, 5000, 10000, 50000, 100000}; // Hz
-    int numFreq = sizeof(frequencies) / sizeof(frequencies[0]);
+    uint32_t numFreq = min((uint32_t)(sizeof(frequencies) / sizeof(frequencies[0])), (uint32_t)maxResults);
     
-    for (int i = 0; i < numFreq && i < maxResults; i++) {
-        BIAResult result;
-        if (biaApp.performSingleMeasurement(frequencies[i], result)) {
-            results[i] = result;
-            (*resultCount)++;
-        }
-    }
-    
-    return (*resultCount > 0);
+    uint32_t count = 0;
+    bool ok = biaApp.performSweep(frequencies, numFreq, results, &count);
+    *resultCount = count;
+    return ok;
 }
 
 void SensorManager::printSensorReadings(const SensorReadings& readings) {
@@ -801,8 +1340,12 @@ void displaySensorReadings(const SensorReadings& readings) {
     
     // Heart Rate and SpO2
     if (readings.heartRate.validReading) {
-        Serial.printf("Heart Rate: %d bpm, SpO2: %.1f%%\n", 
-                     readings.heartRate.heartRate, readings.heartRate.spO2);
+        Serial.printf("Heart Rate: %.0f bpm (from%s%s%s), SpO2: %.1f%%\n",
+                     readings.heartRate.heartRate,
+                     (readings.heartRate.sources & (1 << HR_SOURCE_ECG)) ? " ECG" : "",
+                     (readings.heartRate.sources & (1 << HR_SOURCE_PPG_SPECTRAL)) ? " PPG-spectrum" : "",
+                     (readings.heartRate.sources & (1 << HR_SOURCE_PPG_MAXIM)) ? " Maxim" : "",
+                     readings.heartRate.spO2);
     } else {
         Serial.println("Heart Rate: Invalid reading");
     }
@@ -1021,35 +1564,28 @@ void SensorManager::testAD8232ECG() {
     Serial.println("🫀 AD8232 ECG Individual Test - Heart Rate Diagram");
     Serial.println("=================================================");
     
-    if (!ecgInitialized) {
+    if (!ecgInitialized || !ecgStreaming) {
         Serial.println("❌ ECG sensor not initialized");
         return;
     }
     
     Serial.println("📊 Real-time ECG readings for heart rate analysis");
     Serial.println("💡 Press any key to stop the test");
-    Serial.println("📈 Format: Timestamp(ms), RawValue, FilteredValue, BPM, LeadOff");
+    Serial.println("📈 Format: Timestamp(ms), RawValue, FilteredValue, BPM, LeadOff, PeakDetected");
     Serial.println("-------------------------------------------------");
     
-    // Reset ECG analysis variables
-    for (int i = 0; i < ECG_FILTER_SIZE; i++) {
-        ecgBuffer[i] = 0;
-    }
-    ecgBufferIndex = 0;
-    lastPeakTime = 0;
+    // Same stream and ECG pipeline as processECGStream(), started afresh;
+    // the loop is blocked here, so this is the only reader
+    ecgPipeline.reset();
+    ecgPipelineFed = false;
     currentBPM = 0;
     
-    // Peak detection variables
-    bool peakDetected = false;
-    int lastFilteredValue = 0;
-    int peakCount = 0;
-    unsigned long testStartTime = millis();
-    unsigned long lastDisplayTime = 0;
-    
-    // Running averages for heart rate calculation
-    float bpmReadings[10] = {0};
-    int bpmIndex = 0;
+    ECGDisplayEvents events = ECGDisplayEvents();
+    uint64_t testStartUs = 0;
+    uint64_t lastDisplayUs = 0;
+    uint64_t lastStatusUs = 0;
     
+    ECGFrame block[ECGAcquisition::MAX_BLOCK_SIZE];
     while (true) {
         // Check if user wants to stop
         if (Serial.available()) {
@@ -1057,105 +1593,62 @@ void SensorManager::testAD8232ECG() {
             break;
         }
         
-        unsigned long currentTime = millis();
-        int rawValue = 0;
-        int filteredValue = 0;
-        bool leadOff = false;
+        size_t count = ecgAcquisition.readBlock(block);
+        if (count == 0) {
+            vTaskDelay(pdMS_TO_TICKS(10));
+            continue;
+        }
         
-        // Check for lead-off detection
-        if (digitalRead(LO_PLUS_PIN) == 1 || digitalRead(LO_MINUS_PIN) == 1) {
-            leadOff = true;
-            filteredValue = 0;
-            rawValue = 0;
-        } else {
-            // Read raw ECG value
-            rawValue = analogRead(ECG_PIN);
-            
-            // Update circular buffer for filtering
-            ecgBuffer[ecgBufferIndex] = rawValue;
-            ecgBufferIndex = (ecgBufferIndex + 1) % ECG_FILTER_SIZE;
-            
-            // Calculate filtered value (moving average)
-            int sum = 0;
-            for (int i = 0; i < ECG_FILTER_SIZE; i++) {
-                sum += ecgBuffer[i];
+        int peaksBefore = events.peakCount;
+        events.averagedCount = 0;
+        processECGFrames(block, count, events);
+        if (events.peakCount != peaksBefore) {
+            currentBPM = (int)(ecgQrs().getHeartRate() + 0.5f);
+        }
+        
+        size_t averaged = 0;
+        for (size_t i = 0; i < count; i++) {
+            const ECGFrame& frame = block[i];
+            bool leadOff = frame.leadOff != ECGLeadOff::NONE;
+            int filteredValue = leadOff ? 0 : (int)events.averaged[averaged++];
+            if (testStartUs == 0) {
+                testStartUs = frame.timestampUs;
+                lastDisplayUs = testStartUs;
+                lastStatusUs = testStartUs;
             }
-            filteredValue = sum / ECG_FILTER_SIZE;
             
-            // Peak detection for heart rate calculation
-            // Look for rising edge crossing threshold
-            if (filteredValue > ecgThreshold && !peakDetected && filteredValue > lastFilteredValue) {
-                peakDetected = true;
-                unsigned long interval = currentTime - lastPeakTime;
-                
-                // Ensure minimum interval between peaks (300ms = 200 BPM max)
-                if (interval > 300 && lastPeakTime > 0) {
-                    float instantBPM = 60000.0 / interval;
-                    
-                    // Validate BPM range
-                    if (instantBPM >= 30 && instantBPM <= 200) {
-                        // Add to running average
-                        bpmReadings[bpmIndex] = instantBPM;
-                        bpmIndex = (bpmIndex + 1) % 10;
-                        
-                        // Calculate average BPM
-                        float sumBPM = 0;
-                        int validReadings = 0;
-                        for (int i = 0; i < 10; i++) {
-                            if (bpmReadings[i] > 0) {
-                                sumBPM += bpmReadings[i];
-                                validReadings++;
-                            }
-                        }
-                        
-                        if (validReadings > 0) {
-                            currentBPM = sumBPM / validReadings;
-                        }
-                        
-                        peakCount++;
-                    }
-                }
-                lastPeakTime = currentTime;
-            } else if (filteredValue < ecgThreshold - 50) { // Hysteresis
-                peakDetected = false;
+            // Display data every 50ms of sample time
+            if (frame.timestampUs - lastDisplayUs >= 50000) {
+                Serial.printf("%lu,%d,%d,%d,%d,%d\n",
+                             (unsigned long)((frame.timestampUs - testStartUs) / 1000),
+                             frame.raw,
+                             filteredValue,
+                             currentBPM,
+                             leadOff ? 1 : 0,
+                             events.peakDetected ? 1 : 0);
+                events.peakDetected = false;
+                lastDisplayUs = frame.timestampUs;
             }
             
-            lastFilteredValue = filteredValue;
-        }
-        
-        // Display data every 50ms for real-time monitoring
-        if (currentTime - lastDisplayTime >= 50) {
-            // Output format: Timestamp, Raw, Filtered, BPM, LeadOff, PeakDetected
-            Serial.printf("%lu,%d,%d,%.1f,%d,%d\n", 
-                         currentTime - testStartTime,
-                         rawValue,
-                         filteredValue,
-                         currentBPM,
-                         leadOff ? 1 : 0,
-                         peakDetected ? 1 : 0);
-            
-            lastDisplayTime = currentTime;
-        }
-        
-        // Show status every 5 seconds
-        if ((currentTime - testStartTime) % 5000 < 50) {
-            Serial.printf("# Status: BPM=%.1f, Peaks=%d, Time=%lus, LeadOff=%s\n",
-                         currentBPM, peakCount, (currentTime - testStartTime) / 1000,
-                         leadOff ? "YES" : "NO");
+            // Show status every 5 seconds
+            if (frame.timestampUs - lastStatusUs >= 5000000) {
+                Serial.printf("# Status: BPM=%d, Peaks=%d, Time=%lus, LeadOff=%s\n",
+                             currentBPM, events.peakCount, (unsigned long)((frame.timestampUs - testStartUs) / 1000000),
+                             leadOff ? "YES" : "NO");
+                lastStatusUs = frame.timestampUs;
+            }
         }
-        
-        delay(20); // 50Hz sampling rate
     }
     
-    unsigned long totalTime = millis() - testStartTime;
+    unsigned long totalTime = (unsigned long)((lastDisplayUs - testStartUs) / 1000);
     
     Serial.println("-------------------------------------------------");
     Serial.println("📊 ECG Test Summary:");
     Serial.printf("⏱️  Test Duration: %.2f seconds\n", totalTime / 1000.0);
-    Serial.printf("💓 Final Heart Rate: %.1f BPM\n", currentBPM);
-    Serial.printf("📈 Total Peaks Detected: %d\n", peakCount);
+    Serial.printf("💓 Final Heart Rate: %d BPM\n", currentBPM);
+    Serial.printf("📈 Total Peaks Detected: %d\n", events.peakCount);
     Serial.printf("📊 Average Peak Interval: %.1f ms\n", 
-                 peakCount > 1 ? (float)totalTime / (peakCount - 1) : 0);
+                 events.peakCount > 1 ? (events.lastBeatUs - events.firstBeatUs) / 1000.0 / (events.peakCount - 1) : 0);
     
     // Heart rate analysis
     if (currentBPM > 0) {
@@ -1167,6 +1660,10 @@ void SensorManager::testAD8232ECG() {
         Serial.printf("🫀 Heart Rate Category: %s\n", hrCategory.c_str());
     }
     
+    // processECGStream() starts over from the next frame
+    ecgPipeline.reset();
+    ecgPipelineFed = false;
+    
     Serial.println("=================================================");
     Serial.println("✅ AD8232 ECG test completed");
 }
@@ -1176,7 +1673,7 @@ void SensorManager::runECGMonitor() {
     Serial.println("🫀 AD8232 Real-Time ECG Monitor");
     Serial.println("==============================");
     
-    if (!ecgInitialized) {
+    if (!ecgInitialized || !ecgStreaming) {
         Serial.println("❌ ECG sensor not initialized");
         return;
     }
@@ -1190,30 +1687,39 @@ void SensorManager::runECGMonitor() {
     const int displayWidth = 60;
     const int baselinePos = displayWidth / 2;
     
+    // The stream through the same ECG pipeline, moving average shown at 10 Hz
+    // of sample time; the loop is blocked here, so this is the only reader
+    ecgPipeline.reset();
+    ecgPipelineFed = false;
+    ECGDisplayEvents events = ECGDisplayEvents();
+    ECGFrame block[ECGAcquisition::MAX_BLOCK_SIZE];
+    uint64_t lastDisplayUs = 0;
+    
     while (true) {
         if (Serial.available()) {
             Serial.read();
             break;
         }
         
-        // Read ECG value
-        bool leadOff = (digitalRead(LO_PLUS_PIN) == 1 || digitalRead(LO_MINUS_PIN) == 1);
+        size_t count = ecgAcquisition.readBlock(block);
+        if (count == 0) {
+            vTaskDelay(pdMS_TO_TICKS(10));
+            continue;
+        }
+        events.averagedCount = 0;
+        processECGFrames(block, count, events);
+        
+        // Newest frame of the block, if a display line is due
+        const ECGFrame& frame = block[count - 1];
+        if (frame.timestampUs - lastDisplayUs < 100000) {
+            continue;
+        }
+        lastDisplayUs = frame.timestampUs;
         
-        if (leadOff) {
+        if (frame.leadOff != ECGLeadOff::NONE) {
             Serial.println("❌ LEAD OFF - Check electrode connections");
         } else {
-            int rawValue = analogRead(ECG_PIN);
-            
-            // Update filter buffer
-            ecgBuffer[ecgBufferIndex] = rawValue;
-            ecgBufferIndex = (ecgBufferIndex + 1) % ECG_FILTER_SIZE;
-            
-            // Calculate filtered value
-            int sum = 0;
-            for (int i = 0; i < ECG_FILTER_SIZE; i++) {
-                sum += ecgBuffer[i];
-            }
-            int filteredValue = sum / ECG_FILTER_SIZE;
+            int filteredValue = (int)events.averaged[events.averagedCount - 1];
             
             // Scale value for display (assuming 12-bit ADC, 0-4095 range)
             int scaledValue = map(filteredValue, 1500, 2500, 0, displayWidth);
@@ -1233,10 +1739,12 @@ void SensorManager::runECGMonitor() {
             
             Serial.printf("%s %d\n", waveform.c_str(), filteredValue);
         }
-        
-        delay(100); // 10Hz display update
     }
     
+    // processECGStream() starts over from the next frame
+    ecgPipeline.reset();
+    ecgPipelineFed = false;
+    
     Serial.println("==============================");
     Serial.println("✅ ECG monitoring stopped");
 }
@@ -1256,23 +1764,24 @@ BodyComposition SensorManager::getBodyComposition(float currentWeight) {
     BIAResult results[maxResults];
     unsigned int resultCount = 0;
     
-    // Perform frequency sweep: 1kHz, 5kHz, 10kHz, 50kHz, 100kHz
+    // Frequency sweep 1kHz, 5kHz, 10kHz, 50kHz, 100kHz: the AD5940 sequences
+    // it and interrupts once, with every DFT result waiting in its FIFO
     float frequencies[] = {1000.0f, 5000.0f, 10000.0f, 50000.0f, 100000.0f};
-    int numFreq = sizeof(frequencies) / sizeof(frequencies[0]);
+    uint32_t numFreq = sizeof(frequencies) / sizeof(frequencies[0]);
     
     Serial.println("🔄 Performing BIA frequency sweep for body composition...");
     
-    for (int i = 0; i < numFreq && resultCount < maxResults; i++) {
-        BIAResult result;
-        if (biaApp.performSingleMeasurement(frequencies[i], result)) {
-            if (result.Valid && result.Resistance > 10 && result.Resistance < 2000) {
-                results[resultCount] = result;
-                resultCount++;
-                Serial.printf("   %.0fHz: R=%.1fΩ, X=%.1fΩ, Z=%.1fΩ\n", 
-                             frequencies[i], result.Resistance, result.Reactance, result.Magnitude);
-            }
+    BIAResult sweep[maxResults];
+    uint32_t measured = 0;
+    biaApp.performSweep(frequencies, numFreq, sweep, &measured, BIA_SWEEP_TIMEOUT_MS);
+    for (uint32_t i = 0; i < measured; i++) {
+        const BIAResult& result = sweep[i];
+        if (result.Valid && result.Resistance > 10 && result.Resistance < 2000) {
+            results[resultCount] = result;
+            resultCount++;
+            Serial.printf("   %.0fHz: R=%.1fΩ, X=%.1fΩ, Z=%.1fΩ\n", 
+                         result.Frequency, result.Resistance, result.Reactance, result.Magnitude);
         }
-        delay(100); // Brief delay between measurements
     }
     
     if (resultCount == 0) {
@@ -1288,8 +1797,12 @@ BodyComposition SensorManager::getBodyComposition(float currentWeight) {
         }
     }
     
+    return analyzeBIASweep(results, resultCount, currentWeight);
+}
+
+BodyComposition SensorManager::analyzeBIASweep(BIAResult* results, unsigned int resultCount, float currentWeight) {
     // Perform body composition analysis
-    composition = bodyCompositionAnalyzer.analyzeBodyComposition(results, resultCount, currentWeight);
+    BodyComposition composition = bodyCompositionAnalyzer.analyzeBodyComposition(results, resultCount, currentWeight);
     
     if (composition.validReading) {
         Serial.println("✅ Body composition analysis completed");
@@ -1305,186 +1818,3 @@ BodyComposition SensorManager::getBodyComposition(float currentWeight) {
     
     return composition;
 }
-
-// ===================================================
-// MAX30102 Staged Testing Implementation (Single Sensor)
-// ===================================================
-
-bool SensorManager::setMAX30102Mode(MAX30102_Mode mode) {
-    if (mode == currentMAX30102Mode) {
-        return true; // Already in requested mode
-    }
-    
-    Serial.printf("🔄 Switching MAX30102 from %s to %s mode\n", 
-                  getMAX30102ModeString().c_str(), 
-                  getModeString(mode).c_str());
-    
-    currentMAX30102Mode = mode;
-    modeStartTime = millis();
-    
-    // Configure sensor settings based on mode
-    switch (mode) {
-        case MODE_HEART_RATE_SPO2:
-            return switchToHeartRateMode();
-        case MODE_GLUCOSE_ESTIMATION:
-            return switchToGlucoseMode();
-        case MODE_BLOOD_PRESSURE:
-            return switchToBloodPressureMode();
-        case MODE_CALIBRATION:
-            return switchToCalibrationMode();
-        default:
-            Serial.println("❌ Unknown MAX30102 mode requested");
-            return false;
-    }
-}
-
-MAX30102_Mode SensorManager::getCurrentMAX30102Mode() {
-    return currentMAX30102Mode;
-}
-
-bool SensorManager::switchToHeartRateMode() {
-    Serial.println("💓 Configuring MAX30102 for Heart Rate & SpO2 measurement");
-    
-    if (!heartRateInitialized) {
-        Serial.println("❌ Heart rate sensor not initialized");
-        return false;
-    }
-    
-    // Configure for optimal heart rate and SpO2 measurement
-    heartRateSensor.setup();
-    heartRateSensor.setPulseAmplitudeRed(0x0A);    // Medium power for good signal
-    heartRateSensor.setPulseAmplitudeIR(0x1F);     // Higher power for SpO2 accuracy
-    heartRateSensor.setSampleRate(2);              // Sample rate 2 (200 Hz)
-    heartRateSensor.setPulseWidth(215);            // 215 microseconds pulse width
-    
-    Serial.println("✅ MAX30102 configured for Heart Rate & SpO2 mode");
-    return true;
-}
-
-bool SensorManager::switchToGlucoseMode() {
-    Serial.println("🩸 Configuring MAX30102 for Glucose Estimation");
-    
-    if (!glucoseInitialized) {
-        Serial.println("❌ Glucose sensor mode not initialized");
-        return false;
-    }
-    
-    // Configure for glucose estimation using PPG morphology
-    glucoseSensor.setup();
-    glucoseSensor.setPulseAmplitudeRed(0x08);      // Lower power for glucose
-    glucoseSensor.setPulseAmplitudeIR(0x08);       // Lower power, focused on morphology
-    glucoseSensor.setSampleRate(2);               // Sample rate 2 (200 Hz)
-    glucoseSensor.setPulseWidth(118);              // Shorter pulse width
-    
-    Serial.println("✅ MAX30102 configured for Glucose Estimation mode");
-    return true;
-}
-
-bool SensorManager::switchToBloodPressureMode() {
-    Serial.println("🩺 Configuring MAX30102 for Blood Pressure PTT");
-    
-    // Use heart rate sensor for PPG in blood pressure mode
-    if (!heartRateInitialized) {
-        Serial.println("❌ Heart rate sensor not initialized for BP mode");
-        return false;
-    }
-    
-    // Configure for pulse transit time measurement
-    heartRateSensor.setup();
-    heartRateSensor.setPulseAmplitudeRed(0x0C);    // Medium-high power for clear pulse
-    heartRateSensor.setPulseAmplitudeIR(0x0C);     // Balanced for PTT detection
-    heartRateSensor.setSampleRate(3);              // Sample rate 3 (400 Hz) for timing precision
-    heartRateSensor.setPulseWidth(215);            // Standard pulse width
-    
-    Serial.println("✅ MAX30102 configured for Blood Pressure PTT mode");
-    return true;
-}
-
-bool SensorManager::switchToCalibrationMode() {
-    Serial.println("⚙️ Configuring MAX30102 for Calibration");
-    
-    // Use standard settings for calibration
-    if (!heartRateInitialized) {
-        Serial.println("❌ Sensor not initialized for calibration mode");
-        return false;
-    }
-    
-    // Calibration mode uses moderate settings
-    heartRateSensor.setup();
-    heartRateSensor.setPulseAmplitudeRed(0x0F);    // Moderate power
-    heartRateSensor.setPulseAmplitudeIR(0x0F);     // Moderate power
-    heartRateSensor.setSampleRate(2);              // Sample rate 2 (200 Hz)
-    heartRateSensor.setPulseWidth(215);            // Standard pulse width
-    
-    Serial.println("✅ MAX30102 configured for Calibration mode");
-    return true;
-}
-
-void SensorManager::cycleMAX30102Modes() {
-    if (!autoModeCycling) {
-        return; // Auto-cycling disabled
-    }
-    
-    unsigned long currentTime = millis();
-    unsigned long timeInCurrentMode = currentTime - modeStartTime;
-    
-    // Check if it's time to switch modes
-    bool shouldSwitch = false;
-    
-    switch (currentMAX30102Mode) {
-        case MODE_HEART_RATE_SPO2:
-            shouldSwitch = (timeInCurrentMode >= MODE_DURATION_HR_SPO2);
-            break;
-        case MODE_GLUCOSE_ESTIMATION:
-            shouldSwitch = (timeInCurrentMode >= MODE_DURATION_GLUCOSE);
-            break;
-        case MODE_BLOOD_PRESSURE:
-            shouldSwitch = (timeInCurrentMode >= MODE_DURATION_BP);
-            break;
-        case MODE_CALIBRATION:
-            shouldSwitch = (timeInCurrentMode >= MODE_DURATION_CALIBRATION);
-            break;
-    }
-    
-    if (shouldSwitch) {
-        // Cycle to next mode
-        MAX30102_Mode nextMode;
-        switch (currentMAX30102Mode) {
-            case MODE_HEART_RATE_SPO2:
-                nextMode = MODE_GLUCOSE_ESTIMATION;
-                break;
-            case MODE_GLUCOSE_ESTIMATION:
-                nextMode = MODE_BLOOD_PRESSURE;
-                break;
-            case MODE_BLOOD_PRESSURE:
-                nextMode = MODE_CALIBRATION;
-                break;
-            case MODE_CALIBRATION:
-            default:
-                nextMode = MODE_HEART_RATE_SPO2;
-                break;
-        }
-        
-        setMAX30102Mode(nextMode);
-        lastModeCycle = currentTime;
-    }
-}
-
-String SensorManager::getMAX30102ModeString() {
-    return getModeString(currentMAX30102Mode);
-}
-
-String getModeString(MAX30102_Mode mode) {
-    switch (mode) {
-        case MODE_HEART_RATE_SPO2:
-            return "Heart Rate & SpO2";
-        case MODE_GLUCOSE_ESTIMATION:
-            return "Glucose Estimation";
-        case MODE_BLOOD_PRESSURE:
-            return "Blood Pressure PTT";
-        case MODE_CALIBRATION:
-            return "Calibration";
-        default:
-            return "Unknown";
-    }
-}
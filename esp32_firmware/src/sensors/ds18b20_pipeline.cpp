@@ -0,0 +1,74 @@
+#include "sensors/ds18b20_pipeline.h"
+#include <string.h>
+
+DS18B20Pipeline::DS18B20Pipeline(TemperatureBus& bus)
+    : bus(bus), count(0), resolution(12), intervalMs(0), state(IDLE),
+      conversionStartMs(0), started(false), published(false) {
+    memset(channels, 0, sizeof(channels));
+    stats.conversions = 0;
+    stats.readErrors = 0;
+}
+
+uint8_t DS18B20Pipeline::begin(uint8_t resolutionBits, uint32_t interval) {
+    if (resolutionBits < 9) resolutionBits = 9;
+    if (resolutionBits > 12) resolutionBits = 12;
+    resolution = resolutionBits;
+    intervalMs = interval;
+    state = IDLE;
+    started = false;
+    published = false;
+
+    count = 0;
+    uint8_t found = bus.deviceCount();
+    for (uint8_t i = 0; i < found && count < MAX_SENSORS; i++) {
+        TemperatureChannel& ch = channels[count];
+        if (!bus.getAddress(i, ch.address)) {
+            continue;
+        }
+        bus.setResolution(ch.address, resolution);
+        ch.celsius = TemperatureBus::DISCONNECTED_C;
+        ch.valid = false;
+        ch.timestampMs = 0;
+        count++;
+    }
+    return count;
+}
+
+bool DS18B20Pipeline::update(uint32_t nowMs) {
+    if (count == 0) {
+        return false;
+    }
+
+    bool publishedNow = false;
+    if (state == CONVERTING) {
+        if (nowMs - conversionStartMs < conversionTimeMs()) {
+            return false;
+        }
+
+        for (uint8_t i = 0; i < count; i++) {
+            TemperatureChannel& ch = channels[i];
+            float celsius = bus.readCelsius(ch.address);
+            if (celsius == TemperatureBus::DISCONNECTED_C) {
+                ch.valid = false;
+                stats.readErrors++;
+            } else {
+                ch.celsius = celsius;
+                ch.valid = true;
+                ch.timestampMs = conversionStartMs;
+            }
+        }
+        stats.conversions++;
+        published = true;
+        publishedNow = true;
+        state = IDLE;
+    }
+
+    // Conversions are spaced start-to-start; a short interval means back-to-back
+    if (!started || nowMs - conversionStartMs >= intervalMs) {
+        bus.requestConversion();
+        conversionStartMs = nowMs;
+        started = true;
+        state = CONVERTING;
+    }
+    return publishedNow;
+}
@@ -0,0 +1,73 @@
+#include "sensors/ecg_acquisition.h"
+
+ECGAcquisition::ECGAcquisition(ECGFrontEnd& frontEnd)
+    : frontEnd(frontEnd), pendingTicks(0), periodUs(4000), startUs(0), tickIndex(0) {
+    resetStats();
+}
+
+bool ECGAcquisition::begin(const ECGAcquisitionConfig& newConfig, uint64_t start) {
+    config = newConfig;
+    if (config.sampleRateHz < MIN_RATE_HZ) config.sampleRateHz = MIN_RATE_HZ;
+    if (config.sampleRateHz > MAX_RATE_HZ) config.sampleRateHz = MAX_RATE_HZ;
+    if (config.blockSize == 0) config.blockSize = 1;
+    if (config.blockSize > MAX_BLOCK_SIZE) config.blockSize = MAX_BLOCK_SIZE;
+
+    // Whole microseconds so the hardware timer alarm matches the grid exactly
+    periodUs = 1000000UL / config.sampleRateHz;
+    startUs = start;
+    tickIndex = 0;
+    pendingTicks.store(0, std::memory_order_release);
+    ring.clear();
+    return true;
+}
+
+uint16_t ECGAcquisition::service() {
+    uint32_t ticks = pendingTicks.exchange(0, std::memory_order_acq_rel);
+    if (ticks == 0) {
+        return 0;
+    }
+
+    if (ticks > 1) {
+        stats.missedTicks += ticks - 1;
+        tickIndex += ticks - 1;
+    }
+
+    ECGFrame frame;
+    frame.leadOff = frontEnd.readLeadOff();
+    // Electrodes are floating while a lead is off; don't pass rail noise on
+    frame.raw = frame.leadOff == ECGLeadOff::NONE ? frontEnd.readSample() : 0;
+    frame.timestampUs = startUs + (uint64_t)tickIndex * periodUs;
+    tickIndex++;
+
+    if (frame.leadOff != ECGLeadOff::NONE) {
+        stats.leadOffFrames++;
+    }
+    if (!ring.push(frame)) {
+        return 0;
+    }
+    stats.framesAcquired++;
+    return 1;
+}
+
+size_t ECGAcquisition::readBlock(ECGFrame* out) {
+    if (ring.available() < config.blockSize) {
+        return 0;
+    }
+    size_t count = ring.pop(out, config.blockSize);
+    stats.blocksDelivered++;
+    return count;
+}
+
+ECGAcquisitionStats ECGAcquisition::getStats() const {
+    ECGAcquisitionStats snapshot = stats;
+    snapshot.ringDrops = ring.droppedCount();
+    return snapshot;
+}
+
+void ECGAcquisition::resetStats() {
+    stats.framesAcquired = 0;
+    stats.missedTicks = 0;
+    stats.ringDrops = 0;
+    stats.leadOffFrames = 0;
+    stats.blocksDelivered = 0;
+}
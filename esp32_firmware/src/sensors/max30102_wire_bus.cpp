@@ -0,0 +1,30 @@
+#include "sensors/max30102_wire_bus.h"
+
+bool MAX30102WireBus::readRegister(uint8_t reg, uint8_t& value) {
+    return readBurst(reg, &value, 1);
+}
+
+bool MAX30102WireBus::writeRegister(uint8_t reg, uint8_t value) {
+    wire.beginTransmission(I2C_ADDRESS);
+    wire.write(reg);
+    wire.write(value);
+    return wire.endTransmission() == 0;
+}
+
+bool MAX30102WireBus::readBurst(uint8_t reg, uint8_t* buffer, size_t length) {
+    wire.beginTransmission(I2C_ADDRESS);
+    wire.write(reg);
+    if (wire.endTransmission(false) != 0) {
+        return false;
+    }
+
+    size_t received = wire.requestFrom(I2C_ADDRESS, (uint8_t)length);
+    if (received != length) {
+        return false;
+    }
+
+    for (size_t i = 0; i < length; i++) {
+        buffer[i] = wire.read();
+    }
+    return true;
+}
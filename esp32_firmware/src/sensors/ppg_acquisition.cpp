@@ -0,0 +1,193 @@
+#include "sensors/ppg_acquisition.h"
+
+PPGAcquisition::PPGAcquisition(PPGBus& bus)
+    : bus(bus), interruptPending(false), generation(0), periodUs(5000), lastTimestampUs(0), timelineValid(false) {
+    resetStats();
+}
+
+bool PPGAcquisition::begin(const PPGAcquisitionConfig& newConfig) {
+    config = newConfig;
+    if (config.sampleRateHz < 50) config.sampleRateHz = 50;
+    if (config.sampleRateHz > 400) config.sampleRateHz = 400;
+    if (config.almostFullFree > 15) config.almostFullFree = 15;
+
+    periodUs = 1000000UL / config.sampleRateHz;
+    return configureDevice(true);
+}
+
+bool PPGAcquisition::restart() {
+    // Keep whatever LED currents the caller just programmed
+    return configureDevice(false);
+}
+
+bool PPGAcquisition::configureDevice(bool applyLedAmplitudes) {
+    using namespace MAX30102Reg;
+
+    // No sample averaging, rollover disabled so OVF_COUNTER reports lost samples
+    uint8_t fifoConfig = config.almostFullFree & 0x0F;
+    // ADC range 4096nA, sample rate, 411us pulse width (18-bit)
+    uint8_t spo2Config = (0x01 << 5) | (sampleRateCode(config.sampleRateHz) << 2) | 0x03;
+
+    bool ok = bus.writeRegister(MODE_CONFIG, MODE_SPO2) &&
+              bus.writeRegister(FIFO_CONFIG, fifoConfig) &&
+              bus.writeRegister(SPO2_CONFIG, spo2Config) &&
+              bus.writeRegister(INT_ENABLE_1, INT_A_FULL) &&
+              bus.writeRegister(INT_ENABLE_2, 0x00) &&
+              bus.writeRegister(FIFO_WR_PTR, 0x00) &&
+              bus.writeRegister(OVF_COUNTER, 0x00) &&
+              bus.writeRegister(FIFO_RD_PTR, 0x00);
+    if (ok && applyLedAmplitudes) {
+        ok = bus.writeRegister(LED1_PA, config.redAmplitude) &&
+             bus.writeRegister(LED2_PA, config.irAmplitude);
+    }
+
+    // Reading the status register releases the INT line
+    uint8_t status;
+    bus.readRegister(INT_STATUS_1, status);
+
+    // Whatever is still queued belongs to the old settings; the consumer
+    // drops it in read() once it sees the new generation
+    timelineValid = false;
+    generation.fetch_add(1, std::memory_order_release);
+    if (!ok) stats.busErrors++;
+    return ok;
+}
+
+uint8_t PPGAcquisition::sampleRateCode(uint16_t rateHz) const {
+    if (rateHz >= 400) return 3;
+    if (rateHz >= 200) return 2;
+    if (rateHz >= 100) return 1;
+    return 0; // 50 Hz
+}
+
+bool PPGAcquisition::readFifoCount(uint8_t& count, uint8_t& overflow) {
+    using namespace MAX30102Reg;
+
+    uint8_t writePtr, readPtr;
+    if (!bus.readRegister(FIFO_WR_PTR, writePtr) ||
+        !bus.readRegister(OVF_COUNTER, overflow) ||
+        !bus.readRegister(FIFO_RD_PTR, readPtr)) {
+        return false;
+    }
+
+    count = (writePtr - readPtr) & (FIFO_DEPTH - 1);
+    if (overflow > 0 && count == 0) {
+        count = FIFO_DEPTH; // Pointers wrapped onto each other: FIFO is full
+    }
+    return true;
+}
+
+uint64_t PPGAcquisition::firstTimestamp(uint8_t count, uint64_t nowUs) {
+    // The newest sample was taken at most one period before the burst read
+    uint64_t anchor = nowUs - (uint64_t)(count - 1) * periodUs;
+    if (!timelineValid) {
+        timelineValid = true;
+        return anchor;
+    }
+
+    // Otherwise continue the sample clock and slowly pull it towards the anchor,
+    // so read-time jitter does not leak into the timestamps
+    uint64_t predicted = lastTimestampUs + periodUs;
+    int64_t error = (int64_t)(anchor - predicted);
+    if (error > (int64_t)(2 * periodUs) || error < -(int64_t)(2 * periodUs)) {
+        return anchor;
+    }
+    return predicted + error / 8;
+}
+
+uint16_t PPGAcquisition::service(uint64_t nowUs) {
+    using namespace MAX30102Reg;
+
+    interruptPending.store(false, std::memory_order_release);
+
+    uint8_t status;
+    if (!bus.readRegister(INT_STATUS_1, status)) {
+        stats.busErrors++;
+        return 0;
+    }
+
+    uint8_t count = 0;
+    uint8_t overflow = 0;
+    if (!readFifoCount(count, overflow)) {
+        stats.busErrors++;
+        return 0;
+    }
+
+    if (overflow > 0) {
+        stats.fifoOverflowSamples += overflow;
+        timelineValid = false; // Gap in the stream
+    }
+    if (count == 0) {
+        return 0;
+    }
+
+    uint64_t timestamp = firstTimestamp(count, nowUs);
+    uint32_t currentGeneration = generation.load(std::memory_order_relaxed);
+    size_t chunkSamples = bus.maxBurstLength() / BYTES_PER_SAMPLE;
+    if (chunkSamples == 0) chunkSamples = 1;
+
+    uint8_t raw[FIFO_DEPTH * BYTES_PER_SAMPLE];
+    uint16_t pushed = 0;
+    uint8_t remaining = count;
+
+    while (remaining > 0) {
+        uint8_t chunk = remaining < chunkSamples ? remaining : (uint8_t)chunkSamples;
+        if (!bus.readBurst(FIFO_DATA, raw, (size_t)chunk * BYTES_PER_SAMPLE)) {
+            stats.busErrors++;
+            timelineValid = false;
+            break;
+        }
+
+        for (uint8_t i = 0; i < chunk; i++) {
+            const uint8_t* p = &raw[i * BYTES_PER_SAMPLE];
+            PPGSample sample;
+            sample.red = (((uint32_t)p[0] << 16) | ((uint32_t)p[1] << 8) | p[2]) & SAMPLE_MASK;
+            sample.ir = (((uint32_t)p[3] << 16) | ((uint32_t)p[4] << 8) | p[5]) & SAMPLE_MASK;
+            sample.timestampUs = timestamp;
+            sample.generation = currentGeneration;
+
+            if (ring.push(sample)) {
+                pushed++;
+            }
+            lastTimestampUs = timestamp;
+            timestamp += periodUs;
+        }
+        remaining -= chunk;
+    }
+
+    stats.samplesAcquired += pushed;
+    stats.bursts++;
+    if (count > stats.maxBurstSamples) stats.maxBurstSamples = count;
+    return pushed;
+}
+
+size_t PPGAcquisition::read(PPGSample* out, size_t maxCount) {
+    size_t kept = 0;
+    size_t popped;
+    while (kept == 0 && (popped = ring.pop(out, maxCount)) > 0) {
+        // Loaded after the pop, so it is at least the generation of every
+        // sample just popped: older tags are from before a reconfigure
+        uint32_t current = generation.load(std::memory_order_acquire);
+        for (size_t i = 0; i < popped; i++) {
+            if (out[i].generation == current) {
+                out[kept++] = out[i];
+            }
+        }
+    }
+    return kept;
+}
+
+PPGAcquisitionStats PPGAcquisition::getStats() const {
+    PPGAcquisitionStats snapshot = stats;
+    snapshot.ringDrops = ring.droppedCount();
+    return snapshot;
+}
+
+void PPGAcquisition::resetStats() {
+    stats.samplesAcquired = 0;
+    stats.bursts = 0;
+    stats.fifoOverflowSamples = 0;
+    stats.ringDrops = 0;
+    stats.busErrors = 0;
+    stats.maxBurstSamples = 0;
+}
@@ -0,0 +1,124 @@
+#include "sensors/ppg_fanout.h"
+
+PPGFanout::PPGFanout() : count(0), reconfigurations(0) {
+    profile = {200, 0x1F, 0x1F};
+    range = {0, 0xFFFFFFFF, 0, 0};
+    restartDcWindow();
+}
+
+int PPGFanout::addConsumer(const char* name, PPGConsumerFn fn, void* context, uint16_t minSampleRateHz) {
+    if (count >= MAX_CONSUMERS || fn == nullptr) {
+        return -1;
+    }
+    consumers[count] = {name, fn, context, minSampleRateHz, true, 0, 0};
+    return count++;
+}
+
+void PPGFanout::setEnabled(int id, bool enabled) {
+    if (id >= 0 && id < count) {
+        consumers[id].enabled = enabled;
+    }
+}
+
+void PPGFanout::begin(const PPGStreamProfile& newProfile, const PPGLedRange& newRange) {
+    profile = newProfile;
+    range = newRange;
+    restartDcWindow();
+}
+
+void PPGFanout::dispatch(const PPGSample* samples, size_t sampleCount) {
+    if (sampleCount == 0) {
+        return;
+    }
+
+    for (int i = 0; i < count; i++) {
+        Consumer& consumer = consumers[i];
+        if (!consumer.enabled) continue;
+        consumer.fn(consumer.context, samples, sampleCount);
+        consumer.samples += sampleCount;
+        consumer.batches++;
+    }
+
+    if (range.windowSamples == 0 || dcReady) {
+        return; // Auto-ranging off, or a verdict is waiting for reconcile()
+    }
+    for (size_t i = 0; i < sampleCount; i++) {
+        dcIrSum += samples[i].ir;
+        dcRedSum += samples[i].red;
+        if (++dcSamples >= range.windowSamples) {
+            dcIr = dcIrSum / dcSamples;
+            dcRed = dcRedSum / dcSamples;
+            dcReady = true;
+            break;
+        }
+    }
+}
+
+bool PPGFanout::reconcile(PPGStreamProfile& out) {
+    PPGStreamProfile next = profile;
+
+    // Only ever speed up: a consumer going away is not worth a restart
+    uint16_t required = requiredSampleRateHz();
+    if (required > next.sampleRateHz) {
+        next.sampleRateHz = required;
+    }
+
+    if (dcReady) {
+        next.irAmplitude = rangeAmplitude(profile.irAmplitude, dcIr);
+        next.redAmplitude = rangeAmplitude(profile.redAmplitude, dcRed);
+        restartDcWindow();
+    }
+
+    if (next.sampleRateHz == profile.sampleRateHz &&
+        next.irAmplitude == profile.irAmplitude &&
+        next.redAmplitude == profile.redAmplitude) {
+        return false;
+    }
+
+    profile = next;
+    reconfigurations++;
+    restartDcWindow(); // Samples taken with the old currents no longer apply
+    out = profile;
+    return true;
+}
+
+uint16_t PPGFanout::requiredSampleRateHz() const {
+    uint16_t required = 0;
+    for (int i = 0; i < count; i++) {
+        if (consumers[i].enabled && consumers[i].minSampleRateHz > required) {
+            required = consumers[i].minSampleRateHz;
+        }
+    }
+    return required;
+}
+
+PPGConsumerStats PPGFanout::getStats(int id) const {
+    PPGConsumerStats stats = {"", 0, false, 0, 0};
+    if (id >= 0 && id < count) {
+        const Consumer& c = consumers[id];
+        stats = {c.name, c.minSampleRateHz, c.enabled, c.samples, c.batches};
+    }
+    return stats;
+}
+
+uint8_t PPGFanout::rangeAmplitude(uint8_t amplitude, uint32_t dc) const {
+    if (dc < range.noContactDc || (dc >= range.dcLow && dc <= range.dcHigh)) {
+        return amplitude;
+    }
+
+    // DC level scales roughly linearly with LED current: aim for mid-range
+    uint32_t target = range.dcLow / 2 + range.dcHigh / 2;
+    uint32_t scaled = (uint32_t)((uint64_t)amplitude * target / (dc > 0 ? dc : 1));
+    if (scaled < 1) scaled = 1;
+    if (scaled > 0xFF) scaled = 0xFF;
+    return (uint8_t)scaled;
+}
+
+void PPGFanout::restartDcWindow() {
+    dcIrSum = 0;
+    dcRedSum = 0;
+    dcSamples = 0;
+    dcReady = false;
+    dcIr = 0;
+    dcRed = 0;
+}
@@ -0,0 +1,139 @@
+#include "sensors/sensor_scheduler.h"
+#include <string.h>
+
+SensorScheduler::SensorScheduler(SchedulerClockUs clockUs) : clockUs(clockUs), count(0) {
+    memset(tasks, 0, sizeof(tasks));
+}
+
+int SensorScheduler::addTask(const char* name, uint32_t periodMs, SensorStepFn fn, void* context, uint32_t offsetMs) {
+    if (count >= MAX_TASKS || fn == nullptr || periodMs == 0) {
+        return -1;
+    }
+
+    Task& task = tasks[count];
+    memset(&task, 0, sizeof(task));
+    task.fn = fn;
+    task.context = context;
+    task.offsetMs = offsetMs;
+    task.enabled = true;
+    task.stats.name = name;
+    task.stats.periodMs = periodMs;
+    return count++;
+}
+
+void SensorScheduler::setEnabled(int id, bool enabled) {
+    if (id >= 0 && id < count) {
+        tasks[id].enabled = enabled;
+    }
+}
+
+void SensorScheduler::start(uint32_t nowMs) {
+    for (uint8_t i = 0; i < count; i++) {
+        tasks[i].nextReleaseMs = nowMs + tasks[i].offsetMs;
+        tasks[i].active = false;
+    }
+}
+
+void SensorScheduler::skipMissedReleases(Task& task, uint32_t nowMs) {
+    // Never queue a backlog of jobs: drop releases that are already a full period old
+    while ((int32_t)(nowMs - task.nextReleaseMs) >= (int32_t)task.stats.periodMs) {
+        task.nextReleaseMs += task.stats.periodMs;
+        task.stats.skippedReleases++;
+    }
+}
+
+bool SensorScheduler::releaseIfDue(Task& task, uint32_t nowMs) {
+    if (task.active) {
+        return true;
+    }
+    if (!task.enabled || (int32_t)(nowMs - task.nextReleaseMs) < 0) {
+        return false;
+    }
+
+    skipMissedReleases(task, nowMs);
+    task.jobReleaseMs = task.nextReleaseMs;
+    task.nextReleaseMs += task.stats.periodMs;
+    task.jobStep = 0;
+    task.active = true;
+    return true;
+}
+
+uint8_t SensorScheduler::run(uint32_t nowMs, uint32_t budgetUs) {
+    bool stepped[MAX_TASKS] = {false};
+    uint8_t executed = 0;
+    uint32_t startUs = clockUs();
+
+    while (true) {
+        // Earliest deadline among ready jobs that have not run in this pass
+        int next = -1;
+        uint32_t nextDeadline = 0;
+        for (uint8_t i = 0; i < count; i++) {
+            if (stepped[i] || !releaseIfDue(tasks[i], nowMs)) {
+                continue;
+            }
+            uint32_t deadline = tasks[i].jobReleaseMs + tasks[i].stats.periodMs;
+            if (next < 0 || (int32_t)(deadline - nextDeadline) < 0) {
+                next = i;
+                nextDeadline = deadline;
+            }
+        }
+        if (next < 0) {
+            break;
+        }
+
+        Task& task = tasks[next];
+        stepped[next] = true;
+
+        uint32_t stepStartUs = clockUs();
+        SensorStepResult result = task.fn(task.context, nowMs, task.jobStep);
+        uint32_t stepUs = clockUs() - stepStartUs;
+
+        task.jobStep++;
+        task.stats.steps++;
+        task.stats.lastStepUs = stepUs;
+        task.stats.totalStepUs += stepUs;
+        if (stepUs > task.stats.maxStepUs) task.stats.maxStepUs = stepUs;
+        executed++;
+
+        if (result == SENSOR_STEP_DONE) {
+            // Steps may take real time; latency is measured at completion
+            uint32_t doneMs = nowMs + (clockUs() - startUs) / 1000;
+            uint32_t latency = doneMs - task.jobReleaseMs;
+            task.stats.lastLatencyMs = latency;
+            if (latency > task.stats.maxLatencyMs) task.stats.maxLatencyMs = latency;
+            if (latency > task.stats.periodMs) task.stats.overruns++;
+            task.stats.completed++;
+            task.active = false;
+            skipMissedReleases(task, doneMs);
+        }
+
+        if (clockUs() - startUs >= budgetUs) {
+            break;
+        }
+    }
+    return executed;
+}
+
+uint32_t SensorScheduler::msUntilNextRelease(uint32_t nowMs) const {
+    uint32_t earliest = UINT32_MAX;
+    for (uint8_t i = 0; i < count; i++) {
+        const Task& task = tasks[i];
+        if (!task.enabled) continue;
+        if (task.active) return 0;
+        int32_t wait = (int32_t)(task.nextReleaseMs - nowMs);
+        if (wait <= 0) return 0;
+        if ((uint32_t)wait < earliest) earliest = wait;
+    }
+    return earliest;
+}
+
+void SensorScheduler::resetStats() {
+    for (uint8_t i = 0; i < count; i++) {
+        SensorTaskStats& stats = tasks[i].stats;
+        const char* name = stats.name;
+        uint32_t period = stats.periodMs;
+        memset(&stats, 0, sizeof(stats));
+        stats.name = name;
+        stats.periodMs = period;
+    }
+}
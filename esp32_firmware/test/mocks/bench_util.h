@@ -0,0 +1,38 @@
+#ifndef BENCH_UTIL_H
+#define BENCH_UTIL_H
+
+#include <unity.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "bench/kernel_bench.h"
+
+// Timing and reporting for the test_*_bench suites: the clock KernelBench
+// reads and one result line, so every suite measures and prints the same
+// way. Kernels that fit KernelBench::run() (repeatable, no threads, no
+// accuracy checked alongside) belong in runDspKernels() instead.
+
+// Keeps the optimiser from discarding the benchmark loops
+static volatile float benchSink;
+static volatile uint64_t benchSinkBits;
+
+// Seconds since construction or the last restart()
+class BenchTimer {
+public:
+    BenchTimer() { restart(); }
+    void restart() { start = kernelBenchNow().ns; }
+    double seconds() const { return (double)(kernelBenchNow().ns - start) / 1e9; }
+
+private:
+    uint64_t start;
+};
+
+// One line per measurement; returns the ns per unit for comparisons
+inline double benchReport(const char* name, double count, double seconds, const char* unit = "sample") {
+    double ns = seconds * 1e9 / count;
+    char line[160];
+    snprintf(line, sizeof(line), "%-48s %10.1f ns/%-9s %8.2f M%ss/s", name, ns, unit, count / seconds / 1e6, unit);
+    TEST_MESSAGE(line);
+    return ns;
+}
+
+#endif // BENCH_UTIL_H
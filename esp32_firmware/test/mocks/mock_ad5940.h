@@ -0,0 +1,228 @@
+#ifndef MOCK_AD5940_H
+#define MOCK_AD5940_H
+
+#include "AD5940.h"
+#include "hal/hal.h"
+#include "mock_hal.h"
+#include "replay/synthetic_signals.h"
+#include <deque>
+#include <map>
+#include <math.h>
+#include <vector>
+
+// An AD5940 behind hal::spi() and the chip-select pin: registers, the
+// sequencer running from SRAM and the data FIFO. Sequencer waits take time
+// on the ManualClock; the DFT of each point sees the Cole model as the load.
+// Install it as both the Spi and the Gpio.
+class MockAD5940 : public hal::Spi, public hal::Gpio {
+public:
+    MockAD5940(ManualClock& clock, uint8_t csPin) : clock(clock), csPin(csPin) {}
+
+    ColeModel load;
+    std::vector<uint32_t> sram;
+    std::deque<uint32_t> fifo;
+    std::vector<double> measuredHz;     // Every DFT the sequencer ran
+    uint32_t frames = 0;                // Chip-select frames
+    uint32_t bursts = 0;                // Block transfers
+    uint32_t sramWrites = 0;
+    uint32_t triggers = 0;
+    uint32_t shortDfts = 0;             // DFTs stopped before their DFTNUM samples were in
+    bool stalled = false;               // Sequences start but never end
+
+    uint32_t reg(uint16_t addr) { return registers[addr]; }
+    double frequencyHz() { return (double)registers[AD5940_REG_WGFCW] * AD5940_SYSCLK_HZ / (1UL << 30); }
+    bool running() { update(); return sequencing; }
+
+    // INT0 low: the sequence ended and the end-of-sequence interrupt is selected
+    bool intAsserted() {
+        update();
+        return (registers[AD5940_REG_INTCFLG0] & registers[AD5940_REG_INTCSEL0] & AD5940_INT_ENDSEQ) != 0;
+    }
+
+    // Gpio: only the chip select matters
+    void setMode(uint8_t, Mode) override {}
+    bool read(uint8_t) override { return true; }
+    void write(uint8_t pin, bool high) override {
+        if (pin != csPin) return;
+        if (!high) {
+            position = 0;
+        } else {
+            frames++;
+        }
+    }
+    int readAnalog(uint8_t) override { return 0; }
+
+    // Spi
+    void beginTransaction(uint32_t, uint8_t) override {}
+    void endTransaction() override {}
+    void transfer(const uint8_t* tx, uint8_t* rx, size_t length) override {
+        bursts++;
+        hal::Spi::transfer(tx, rx, length);
+    }
+    uint8_t transfer(uint8_t value) override {
+        uint32_t at = position++;
+        if (at == 0) {
+            command = value;
+            if (command == AD5940_SPICMD_READREG) outgoing = readRegister(address);
+            incoming = 0;
+            return 0;
+        }
+        uint32_t width = wide(address) ? 4 : 2;
+        switch (command) {
+        case AD5940_SPICMD_SETADDR:
+            if (at <= 2) address = (uint16_t)((address << 8) | value);
+            return 0;
+        case AD5940_SPICMD_WRITEREG:
+            incoming = (incoming << 8) | value;
+            if (at == width) writeRegister(address, incoming);
+            return 0;
+        case AD5940_SPICMD_READREG:
+            if (at == 1) return 0;      // Dummy
+            return byteOf(outgoing, width, at - 2);
+        case AD5940_SPICMD_READFIFO:
+            if (at <= AD5940_FIFO_DUMMY_BYTES) return 0;
+            if ((at - AD5940_FIFO_DUMMY_BYTES - 1) % 4 == 0) outgoing = popFifo();
+            return byteOf(outgoing, 4, (at - AD5940_FIFO_DUMMY_BYTES - 1) % 4);
+        default:
+            return 0;
+        }
+    }
+
+private:
+    ManualClock& clock;
+    uint8_t csPin;
+    std::map<uint16_t, uint32_t> registers;
+    uint32_t position = 0;
+    uint8_t command = 0;
+    uint16_t address = 0;
+    uint32_t outgoing = 0;              // Being read out
+    uint32_t incoming = 0;              // Being written in
+    bool sequencing = false;
+    uint64_t endUs = 0;
+    std::vector<uint32_t> pending;      // DFT words the running sequence will have queued
+
+    static bool wide(uint16_t addr) { return addr >= 0x1000 && addr <= 0x3014; }
+    static uint8_t byteOf(uint32_t value, uint32_t width, uint32_t index) {
+        return index < width ? (uint8_t)(value >> (8 * (width - 1 - index))) : 0;
+    }
+
+    uint32_t popFifo() {
+        update();
+        if (fifo.empty()) return 0;
+        uint32_t value = fifo.front();
+        fifo.pop_front();
+        return value;
+    }
+
+    // The DFT words calculateImpedance() turns back into the load, as 18-bit
+    // results under the channel and ECC bits of a FIFO word
+    void dft(uint32_t& real, uint32_t& imag) {
+        float r, x;
+        load.impedanceAt((float)frequencyHz(), r, x);
+        real = 0xA5000000 | ((uint32_t)(int32_t)lround(r / 1000.0 * 32768) & 0x3FFFF);
+        imag = 0xA5000000 | ((uint32_t)(int32_t)lround(-x / 1000.0 * 32768) & 0x3FFFF);
+    }
+
+    void writeRegister(uint16_t addr, uint32_t value) {
+        switch (addr) {
+        case AD5940_REG_SWRSTCON:
+            if (value == AD5940_SWRST_KEY) {
+                registers.clear();
+                fifo.clear();
+                sequencing = false;
+            }
+            return;
+        case AD5940_REG_CMDFIFOWADDR:
+            registers[addr] = value;
+            return;
+        case AD5940_REG_CMDFIFOWRITE: {
+            uint32_t at = registers[AD5940_REG_CMDFIFOWADDR]++;
+            if (sram.size() <= at) sram.resize(at + 1);
+            sram[at] = value;
+            sramWrites++;
+            return;
+        }
+        case AD5940_REG_TRIGSEQ:
+            if (value & 1) runSequence();
+            return;
+        case AD5940_REG_INTCCLR:
+            registers[AD5940_REG_INTCFLG0] &= ~value;
+            return;
+        case AD5940_REG_SEQCON:
+            if (!(value & 1)) {
+                update();
+                sequencing = false;     // Stopped part way: nothing more reaches the FIFO
+                pending.clear();
+            }
+            break;
+        case AD5940_REG_FIFOCON:
+            if (!(value & AD5940_FIFOCON_DFT)) fifo.clear();
+            break;
+        }
+        registers[addr] = value;
+    }
+
+    uint32_t readRegister(uint16_t addr) {
+        update();
+        switch (addr) {
+        case AD5940_REG_CHIPID:
+            return AD5940_CHIPID;
+        case AD5940_REG_FIFOCNTSTA:
+            return (uint32_t)fifo.size() << 16;
+        case AD5940_REG_DATAFIFORD:
+            return popFifo();
+        }
+        return registers[addr];
+    }
+
+    // Runs sequence 0 from SRAM; its results land when the clock passes its waits
+    void runSequence() {
+        if (!(registers[AD5940_REG_SEQCON] & 1)) return;
+        triggers++;
+        uint32_t info = registers[AD5940_REG_SEQ0INFO];
+        uint32_t start = info & 0x7FF;
+        uint32_t length = (info >> 16) & 0x7FF;
+        uint64_t elapsedUs = 0;
+        uint64_t convertingSinceUs = 0;
+        bool converting = false;
+        pending.clear();
+        for (uint32_t i = start; i < start + length && i < sram.size(); i++) {
+            uint32_t cmd = sram[i];
+            if (!(cmd & 0x80000000UL)) {
+                elapsedUs += (cmd & 0x3FFFFFFF) / (AD5940_SYSCLK_HZ / 1000000);
+                continue;
+            }
+            uint16_t addr = (uint16_t)(0x2000 + (((cmd >> 24) & 0x7F) << 2));
+            uint32_t data = cmd & 0xFFFFFF;
+            if (addr == AD5940_REG_AFECON) {
+                bool on = (data & (AD5940_AFECON_ADCCONVEN | AD5940_AFECON_DFTEN)) != 0;
+                if (on && !converting) convertingSinceUs = elapsedUs;
+                if (converting && !on && (registers[AD5940_REG_FIFOCON] & AD5940_FIFOCON_DFT)) {
+                    uint32_t samples = 4UL << ((registers[AD5940_REG_DFTCON] >> 4) & 0xF);
+                    if ((elapsedUs - convertingSinceUs) * AD5940_DFT_SAMPLE_HZ < samples * 1000000ULL) shortDfts++;
+                    uint32_t real, imag;
+                    dft(real, imag);
+                    pending.push_back(real);
+                    pending.push_back(imag);
+                    measuredHz.push_back(frequencyHz());
+                }
+                converting = on;
+            }
+            registers[addr] = data;
+            if (addr == AD5940_REG_SEQCON && data == 0) break;
+        }
+        registers[AD5940_REG_SEQCON] = 1;       // Still running until the clock gets there
+        sequencing = true;
+        endUs = clock.nowUs + elapsedUs;
+    }
+
+    void update() {
+        if (!sequencing || stalled || clock.nowUs < endUs) return;
+        sequencing = false;
+        registers[AD5940_REG_SEQCON] = 0;
+        fifo.insert(fifo.end(), pending.begin(), pending.end());
+        registers[AD5940_REG_INTCFLG0] |= AD5940_INT_ENDSEQ;
+    }
+};
+
+#endif // MOCK_AD5940_H
@@ -0,0 +1,34 @@
+#ifndef MOCK_ECG_FRONT_END_H
+#define MOCK_ECG_FRONT_END_H
+
+#include "sensors/ecg_acquisition.h"
+
+// Host-side AD8232 model. Each sample returns an incrementing counter
+// (masked to 12 bits) so tests can prove frames stay in order; lead-off
+// can be forced for a range of reads.
+class MockECGFrontEnd : public ECGFrontEnd {
+public:
+    uint32_t sampleReads = 0;
+    uint32_t leadOffReads = 0;
+    uint32_t leadOffFrom = 0;       // Read index where leads come off
+    uint32_t leadOffCount = 0;      // Number of reads the leads stay off
+    uint8_t leadOffFlags = ECGLeadOff::PLUS;
+
+    static uint16_t valueFor(uint32_t read) { return (uint16_t)(read & 0x0FFF); }
+
+    uint16_t readSample() override {
+        return valueFor(sampleReads++);
+    }
+
+    uint8_t readLeadOff() override {
+        uint32_t read = leadOffReads++;
+        if (leadOffCount > 0 && read >= leadOffFrom && read < leadOffFrom + leadOffCount) {
+            // The sample counter still advances so ordering checks stay simple
+            sampleReads++;
+            return leadOffFlags;
+        }
+        return ECGLeadOff::NONE;
+    }
+};
+
+#endif // MOCK_ECG_FRONT_END_H
@@ -0,0 +1,68 @@
+#ifndef MOCK_HAL_H
+#define MOCK_HAL_H
+
+#include "hal/hal.h"
+#include <map>
+#include <string>
+
+// Host-side HAL pieces for tests that install them with hal::set*().
+
+// Time moves only when the test (or a delay) moves it
+class ManualClock : public hal::Clock {
+public:
+    uint64_t nowUs = 0;
+
+    void advanceMs(uint32_t ms) { nowUs += (uint64_t)ms * 1000; }
+
+    uint32_t millis() override { return (uint32_t)(nowUs / 1000); }
+    uint64_t micros() override { return nowUs; }
+    void delayMs(uint32_t ms) override { advanceMs(ms); }
+    void delayUs(uint32_t us) override { nowUs += us; }
+};
+
+// Files in a map; capacity is the partition size it reports
+class MemoryFileSystem : public hal::FileSystem {
+public:
+    std::map<std::string, std::string> files;
+    size_t capacity = 0x170000;
+    bool mounted = false;
+
+    bool mount() override {
+        mounted = true;
+        return true;
+    }
+    bool exists(const char* path) override { return files.count(path) > 0; }
+    long size(const char* path) override {
+        auto file = files.find(path);
+        return file == files.end() ? -1 : (long)file->second.size();
+    }
+    uint32_t opens = 0;                 // Calls to read()
+
+    bool read(const char* path, ChunkSink sink, void* context) override {
+        auto file = files.find(path);
+        if (file == files.end()) {
+            return false;
+        }
+        opens++;
+        for (size_t offset = 0; offset < file->second.size(); offset += READ_CHUNK_BYTES) {
+            std::string chunk = file->second.substr(offset, READ_CHUNK_BYTES);
+            if (!sink(context, chunk.c_str(), chunk.size())) break;
+        }
+        return true;
+    }
+    bool write(const char* path, const char* data, size_t length, bool append) override {
+        std::string& file = files[path];
+        if (!append) file.clear();
+        file.append(data, length);
+        return true;
+    }
+    bool remove(const char* path) override { return files.erase(path) > 0; }
+    size_t totalBytes() override { return capacity; }
+    size_t usedBytes() override {
+        size_t used = 0;
+        for (const auto& file : files) used += file.second.size();
+        return used;
+    }
+};
+
+#endif // MOCK_HAL_H
@@ -0,0 +1,142 @@
+#ifndef MOCK_MAX30102_BUS_H
+#define MOCK_MAX30102_BUS_H
+
+#include <string.h>
+#include "sensors/ppg_acquisition.h"
+
+// Host-side model of the MAX30102 FIFO as seen over I2C.
+// Samples are generated on a virtual clock at the programmed rate; each
+// sample carries its sequence number in the IR channel so tests can prove
+// nothing was dropped or reordered.
+class MockMAX30102Bus : public PPGBus {
+public:
+    uint32_t generatedSamples = 0;
+    uint32_t lostSamples = 0;       // Samples discarded because the FIFO was full
+    uint32_t transactions = 0;
+    uint32_t bytesTransferred = 0;
+    size_t burstLimit = 120;
+
+    MockMAX30102Bus() { memset(regs, 0, sizeof(regs)); }
+
+    void attachInterrupt(PPGAcquisition* engine) { listener = engine; }
+
+    uint16_t rateHz() const {
+        static const uint16_t rates[] = {50, 100, 200, 400, 800, 1000, 1600, 3200};
+        return rates[(regs[MAX30102Reg::SPO2_CONFIG] >> 2) & 0x07];
+    }
+
+    uint32_t periodUs() const { return 1000000UL / rateHz(); }
+
+    // True acquisition time of a given sequence number
+    uint32_t sampleTimeUs(uint32_t sequence) const { return startUs + sequence * periodUs(); }
+
+    bool interruptAsserted() const { return intLatched; }
+
+    void start(uint32_t nowUs) {
+        startUs = nowUs;
+        running = true;
+        generatedSamples = 0;
+    }
+
+    // Generates every sample due up to nowUs
+    void advanceTo(uint32_t nowUs) {
+        if (!running) return;
+        while ((int32_t)(nowUs - sampleTimeUs(generatedSamples)) >= 0) {
+            produce(generatedSamples);
+            generatedSamples++;
+        }
+    }
+
+    bool readRegister(uint8_t reg, uint8_t& value) override {
+        transactions++;
+        bytesTransferred += 1;
+        switch (reg) {
+            case MAX30102Reg::INT_STATUS_1:
+                value = intLatched ? MAX30102Reg::INT_A_FULL : 0;
+                intLatched = false;
+                return true;
+            case MAX30102Reg::FIFO_WR_PTR: value = writePtr & 0x1F; return true;
+            case MAX30102Reg::FIFO_RD_PTR: value = readPtr & 0x1F; return true;
+            case MAX30102Reg::OVF_COUNTER: value = overflowCounter; return true;
+            default: value = regs[reg]; return true;
+        }
+    }
+
+    bool writeRegister(uint8_t reg, uint8_t value) override {
+        transactions++;
+        bytesTransferred += 2;
+        regs[reg] = value;
+        if (reg == MAX30102Reg::FIFO_WR_PTR) { writePtr = value & 0x1F; count = 0; }
+        if (reg == MAX30102Reg::FIFO_RD_PTR) { readPtr = value & 0x1F; count = 0; }
+        if (reg == MAX30102Reg::OVF_COUNTER) { overflowCounter = 0; }
+        return true;
+    }
+
+    bool readBurst(uint8_t reg, uint8_t* buffer, size_t length) override {
+        if (reg != MAX30102Reg::FIFO_DATA) {
+            if (length != 1) return false;
+            return readRegister(reg, buffer[0]);
+        }
+        if (length > burstLimit) return false;
+        transactions++;
+        bytesTransferred += length;
+
+        size_t samples = length / MAX30102Reg::BYTES_PER_SAMPLE;
+        for (size_t i = 0; i < samples; i++) {
+            uint8_t* p = &buffer[i * MAX30102Reg::BYTES_PER_SAMPLE];
+            if (count == 0) {
+                memset(p, 0, MAX30102Reg::BYTES_PER_SAMPLE);
+                continue;
+            }
+            memcpy(p, fifo[readPtr], MAX30102Reg::BYTES_PER_SAMPLE);
+            readPtr = (readPtr + 1) & 0x1F;
+            count--;
+            overflowCounter = 0;
+        }
+        intLatched = false;
+        return true;
+    }
+
+    size_t maxBurstLength() const override { return burstLimit; }
+
+    static uint32_t redFor(uint32_t sequence) { return (sequence * 7 + 1000) & MAX30102Reg::SAMPLE_MASK; }
+    static uint32_t irFor(uint32_t sequence) { return sequence & MAX30102Reg::SAMPLE_MASK; }
+
+private:
+    uint8_t regs[256];
+    uint8_t fifo[MAX30102Reg::FIFO_DEPTH][MAX30102Reg::BYTES_PER_SAMPLE];
+    uint8_t writePtr = 0;
+    uint8_t readPtr = 0;
+    uint8_t count = 0;
+    uint8_t overflowCounter = 0;
+    bool intLatched = false;
+    bool running = false;
+    uint32_t startUs = 0;
+    PPGAcquisition* listener = nullptr;
+
+    void produce(uint32_t sequence) {
+        if (count == MAX30102Reg::FIFO_DEPTH) {
+            // Rollover disabled: the new sample is lost and OVF_COUNTER saturates at 0x1F
+            lostSamples++;
+            if (overflowCounter < 0x1F) overflowCounter++;
+            return;
+        }
+
+        uint32_t red = redFor(sequence);
+        uint32_t ir = irFor(sequence);
+        uint8_t* p = fifo[writePtr];
+        p[0] = (red >> 16) & 0x03; p[1] = (red >> 8) & 0xFF; p[2] = red & 0xFF;
+        p[3] = (ir >> 16) & 0x03;  p[4] = (ir >> 8) & 0xFF;  p[5] = ir & 0xFF;
+        writePtr = (writePtr + 1) & 0x1F;
+        count++;
+
+        uint8_t almostFullFree = regs[MAX30102Reg::FIFO_CONFIG] & 0x0F;
+        bool enabled = regs[MAX30102Reg::INT_ENABLE_1] & MAX30102Reg::INT_A_FULL;
+        if (enabled && !intLatched && (MAX30102Reg::FIFO_DEPTH - count) == almostFullFree) {
+            intLatched = true;
+            if (listener) listener->onInterrupt();
+        }
+    }
+};
+
+#endif // MOCK_MAX30102_BUS_H
@@ -0,0 +1,72 @@
+#ifndef MOCK_TEMPERATURE_BUS_H
+#define MOCK_TEMPERATURE_BUS_H
+
+#include <string.h>
+#include "sensors/ds18b20_pipeline.h"
+
+// Host-side OneWire bus with up to four DS18B20s. A conversion only yields
+// the new temperature once the datasheet conversion time has elapsed on
+// the virtual clock; reading earlier returns the previous scratchpad,
+// exactly like the real part.
+class MockTemperatureBus : public TemperatureBus {
+public:
+    uint8_t devices = 1;
+    uint32_t nowMs = 0;
+    float trueCelsius[4] = {36.5f, 25.0f, 30.0f, 20.0f};
+    bool disconnected[4] = {false, false, false, false};
+
+    uint32_t enumerations = 0;      // getAddress() calls (bus searches)
+    uint32_t conversionRequests = 0;
+    uint32_t earlyReads = 0;        // Reads before the conversion finished
+    uint8_t resolution[4] = {12, 12, 12, 12};
+
+    uint8_t deviceCount() override { return devices; }
+
+    bool getAddress(uint8_t index, uint8_t* address) override {
+        enumerations++;
+        if (index >= devices) return false;
+        for (uint8_t i = 0; i < 8; i++) address[i] = (uint8_t)(0x28 + index * 16 + i);
+        return true;
+    }
+
+    bool setResolution(const uint8_t* address, uint8_t bits) override {
+        int index = indexOf(address);
+        if (index < 0) return false;
+        resolution[index] = bits;
+        return true;
+    }
+
+    void requestConversion() override {
+        conversionRequests++;
+        conversionStartMs = nowMs;
+        for (uint8_t i = 0; i < devices; i++) pending[i] = trueCelsius[i];
+        converting = true;
+    }
+
+    float readCelsius(const uint8_t* address) override {
+        int index = indexOf(address);
+        if (index < 0 || disconnected[index]) return DISCONNECTED_C;
+        uint32_t needed = 750UL >> (12 - resolution[index]);
+        if (converting && nowMs - conversionStartMs >= needed) {
+            scratchpad[index] = pending[index];
+        } else if (converting) {
+            earlyReads++;
+        }
+        return scratchpad[index];
+    }
+
+private:
+    float scratchpad[4] = {85.0f, 85.0f, 85.0f, 85.0f};  // Power-on value
+    float pending[4] = {0, 0, 0, 0};
+    uint32_t conversionStartMs = 0;
+    bool converting = false;
+
+    int indexOf(const uint8_t* address) const {
+        for (uint8_t i = 0; i < devices; i++) {
+            if (address[0] == (uint8_t)(0x28 + i * 16)) return i;
+        }
+        return -1;
+    }
+};
+
+#endif // MOCK_TEMPERATURE_BUS_H
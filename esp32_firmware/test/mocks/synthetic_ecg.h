@@ -0,0 +1,55 @@
+#ifndef SYNTHETIC_ECG_H
+#define SYNTHETIC_ECG_H
+
+#include <stdint.h>
+#include <math.h>
+#include <vector>
+
+// Lead-II-like ECG with known R-peak times, in band-passed ADC counts
+// (zero baseline). Each beat is a sum of Gaussians: P wave 160 ms before the
+// R-peak, a narrow QRS (Q, R, S) and a broad T wave 250 ms after it.
+struct SyntheticECG {
+    double sampleRateHz;
+    double rAmplitude = 1000;
+    double noiseCounts = 0;             // Uniform white noise, peak value
+    uint32_t noiseSeed = 777;
+
+    std::vector<double> rPeaks;         // Seconds
+
+    explicit SyntheticECG(double rateHz) : sampleRateHz(rateHz) {}
+
+    static double wave(double tau, double centre, double width, double amplitude) {
+        double d = tau - centre;
+        return amplitude * exp(-d * d / (2 * width * width));
+    }
+
+    double beat(double tau) const {
+        return wave(tau, -0.160, 0.025, 0.12 * rAmplitude) +
+               wave(tau, -0.020, 0.008, -0.10 * rAmplitude) +
+               wave(tau, 0.000, 0.009, rAmplitude) +
+               wave(tau, 0.022, 0.008, -0.20 * rAmplitude) +
+               wave(tau, 0.250, 0.045, 0.25 * rAmplitude);
+    }
+
+    // Noise-free value at t seconds
+    double valueAt(double t) const {
+        double value = 0;
+        for (double r : rPeaks) {
+            double tau = t - r;
+            if (tau < -0.4) break;
+            if (tau < 0.6) value += beat(tau);
+        }
+        return value;
+    }
+
+    double sample(uint32_t n) {
+        double noise = 0;
+        if (noiseCounts > 0) {
+            noiseSeed = noiseSeed * 1664525u + 1013904223u;
+            noise = noiseCounts * ((noiseSeed >> 8) / 8388608.0 - 1.0);
+        }
+        return valueAt(n / sampleRateHz) + noise;
+    }
+};
+
+#endif // SYNTHETIC_ECG_H
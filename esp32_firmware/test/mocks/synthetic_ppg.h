@@ -0,0 +1,83 @@
+#ifndef SYNTHETIC_PPG_H
+#define SYNTHETIC_PPG_H
+
+#include <stdint.h>
+#include <math.h>
+#include <vector>
+
+// Finger PPG pulse train with known onsets, in raw MAX30102 IR polarity
+// (counts dip as blood volume rises). Each pulse rises as a half cosine from
+// its onset over riseSeconds, then runs off exponentially with a small
+// dicrotic wave. An optional late-systolic reflected wave moves the peak
+// (as vascular tone does) without touching the upstroke.
+// Without it, for a half-cosine rise the fiducials are exact:
+//   foot (intersecting tangent)  onset + (1/2 - 1/pi) * rise
+//   max slope                    onset + rise / 2
+//   peak                         onset + rise
+struct SyntheticPPG {
+    double sampleRateHz;
+    double dcCounts = 100000;
+    double amplitudeCounts = 1500;
+    double riseSeconds = 0.12;
+    double runoffSeconds = 0.12;
+    double dicroticFraction = 0.15;     // Of the amplitude, 0.2 s after the peak
+    double noiseCounts = 0;             // Uniform white noise, peak value
+    uint32_t noiseSeed = 12345;
+
+    std::vector<double> onsets;         // Seconds
+    std::vector<double> amplitudeScale; // Per beat, 1 if empty
+    std::vector<double> reflection;     // Per beat, reflected wave as a fraction of the amplitude, 0 if empty
+
+    explicit SyntheticPPG(double rateHz) : sampleRateHz(rateHz) {}
+
+    static double footOffset(double rise) { return (0.5 - 1.0 / M_PI) * rise; }
+
+    // Onsets every rrSeconds, with a repeating +-jitterSeconds pattern, from firstOnset until endSeconds
+    void regularOnsets(double firstOnset, double rrSeconds, double jitterSeconds, double endSeconds) {
+        static const double pattern[7] = {0.0, 0.8, -0.5, 0.3, -1.0, 0.6, -0.2};
+        int beat = 0;
+        for (double t = firstOnset; t < endSeconds; t += rrSeconds + jitterSeconds * pattern[beat++ % 7]) {
+            onsets.push_back(t);
+        }
+    }
+
+    double pulse(double tau, double amplitude, double reflected = 0) const {
+        if (tau < 0) return 0;
+        double wave = tau - riseSeconds - 0.05;
+        double late = reflected * exp(-wave * wave / (2 * 0.04 * 0.04));
+        if (tau < riseSeconds) return amplitude * (0.5 * (1.0 - cos(M_PI * tau / riseSeconds)) + late);
+        double after = tau - riseSeconds;
+        double notch = after - 0.2;
+        return amplitude * (exp(-after / runoffSeconds) + dicroticFraction * exp(-notch * notch / (2 * 0.03 * 0.03)) + late);
+    }
+
+    // Noise-free raw IR counts at t seconds
+    double valueAt(double t) const {
+        double volume = 0;
+        for (size_t b = 0; b < onsets.size(); b++) {
+            double tau = t - onsets[b];
+            if (tau < 0) break;
+            if (tau < 1.5) {
+                volume += pulse(tau, amplitudeCounts * (b < amplitudeScale.size() ? amplitudeScale[b] : 1.0),
+                                b < reflection.size() ? reflection[b] : 0.0);
+            }
+        }
+        return dcCounts - volume;
+    }
+
+    // Raw IR counts at sample n
+    double sample(uint32_t n) {
+        double noise = 0;
+        if (noiseCounts > 0) {
+            noiseSeed = noiseSeed * 1664525u + 1013904223u;
+            noise = noiseCounts * ((noiseSeed >> 8) / 8388608.0 - 1.0);
+        }
+        return valueAt(n / sampleRateHz) + noise;
+    }
+
+    static uint64_t timeUs(uint32_t n, double rateHz) {
+        return 1000000ULL + (uint64_t)(n * 1e6 / rateHz + 0.5);
+    }
+};
+
+#endif // SYNTHETIC_PPG_H
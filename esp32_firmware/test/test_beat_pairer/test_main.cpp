@@ -0,0 +1,114 @@
+// Host tests for the event-driven R-peak / pulse pairer
+// Run with: pio test -e native -f test_beat_pairer
+
+#include <unity.h>
+#include <vector>
+#include "dsp/beat_pairer.h"
+
+static const uint32_t MIN_US = 50000;
+static const uint32_t MAX_US = 500000;
+
+void setUp() {}
+void tearDown() {}
+
+void test_r_peak_then_pulse_pairs() {
+    BeatPairer pairer(MIN_US, MAX_US);
+    PairedBeat pair;
+    TEST_ASSERT_FALSE(pairer.addRPeak(1000000, pair));
+    TEST_ASSERT_TRUE(pairer.addPulse(1230000, pair));
+    TEST_ASSERT_EQUAL_UINT64(1000000, pair.rPeakUs);
+    TEST_ASSERT_EQUAL_UINT64(1230000, pair.pulseUs);
+    TEST_ASSERT_EQUAL_UINT32(230000, pair.transitUs);
+    TEST_ASSERT_EQUAL_UINT32(1, pairer.getPairedCount());
+}
+
+void test_pulse_reported_before_its_r_peak() {
+    // The pulse detector can finish before the QRS detector has confirmed the beat
+    BeatPairer pairer(MIN_US, MAX_US);
+    PairedBeat pair;
+    TEST_ASSERT_FALSE(pairer.addPulse(1230000, pair));
+    TEST_ASSERT_TRUE(pairer.addRPeak(1000000, pair));
+    TEST_ASSERT_EQUAL_UINT32(230000, pair.transitUs);
+    TEST_ASSERT_EQUAL_UINT32(0, pairer.getUnpairedPulses());
+}
+
+void test_one_to_one_at_high_heart_rate() {
+    // 150 BPM with a 450 ms transit: two windows are open when each pulse lands
+    BeatPairer pairer(MIN_US, MAX_US);
+    PairedBeat pair;
+    std::vector<uint32_t> transits;
+    uint64_t rr = 400000;
+    for (int beat = 0; beat < 20; beat++) {
+        uint64_t r = 1000000 + beat * rr;
+        if (pairer.addRPeak(r, pair)) transits.push_back(pair.transitUs);
+        // This beat's pulse lands after the next R-peak; feed the previous beat's now
+        if (beat > 0 && pairer.addPulse(r - rr + 450000, pair)) transits.push_back(pair.transitUs);
+    }
+    TEST_ASSERT_EQUAL(19, (int)transits.size());
+    for (uint32_t transit : transits) {
+        TEST_ASSERT_EQUAL_UINT32(450000, transit);
+    }
+}
+
+void test_missed_pulse_expires_its_window() {
+    BeatPairer pairer(MIN_US, MAX_US);
+    PairedBeat pair;
+    pairer.addRPeak(1000000, pair);
+    pairer.addRPeak(1800000, pair);     // The first beat's pulse was never detected
+    TEST_ASSERT_TRUE(pairer.addPulse(2050000, pair));
+    TEST_ASSERT_EQUAL_UINT64(1800000, pair.rPeakUs);
+    TEST_ASSERT_EQUAL_UINT32(1, pairer.getUnpairedRPeaks());
+}
+
+void test_missed_r_peak_does_not_borrow_a_pulse() {
+    BeatPairer pairer(MIN_US, MAX_US);
+    PairedBeat pair;
+    pairer.addRPeak(1000000, pair);
+    TEST_ASSERT_TRUE(pairer.addPulse(1250000, pair));
+    // Next R-peak missed by the QRS detector: its pulse finds no open window
+    TEST_ASSERT_FALSE(pairer.addPulse(2050000, pair));
+    // The beat after pairs normally; the stray pulse is discarded when it arrives
+    TEST_ASSERT_FALSE(pairer.addRPeak(2600000, pair));
+    TEST_ASSERT_EQUAL_UINT32(1, pairer.getUnpairedPulses());
+    TEST_ASSERT_TRUE(pairer.addPulse(2850000, pair));
+    TEST_ASSERT_EQUAL_UINT32(250000, pair.transitUs);
+}
+
+void test_pulse_too_soon_after_r_peak_is_rejected() {
+    BeatPairer pairer(MIN_US, MAX_US);
+    PairedBeat pair;
+    pairer.addRPeak(1000000, pair);
+    TEST_ASSERT_FALSE(pairer.addPulse(1020000, pair));     // Previous beat's late dicrotic detection
+    TEST_ASSERT_TRUE(pairer.addPulse(1240000, pair));
+    TEST_ASSERT_EQUAL_UINT32(240000, pair.transitUs);
+}
+
+void test_queues_stay_bounded_without_the_other_stream() {
+    BeatPairer pairer(MIN_US, MAX_US);
+    PairedBeat pair;
+    // ECG only (finger off the sensor) for a minute, then PPG returns
+    for (int beat = 0; beat < 80; beat++) {
+        TEST_ASSERT_FALSE(pairer.addRPeak(1000000 + beat * 750000ULL, pair));
+    }
+    TEST_ASSERT_GREATER_OR_EQUAL(76, (int)pairer.getUnpairedRPeaks());
+    uint64_t r = 1000000 + 80 * 750000ULL;
+    pairer.addRPeak(r, pair);
+    TEST_ASSERT_TRUE(pairer.addPulse(r + 260000, pair));
+    TEST_ASSERT_EQUAL_UINT64(r, pair.rPeakUs);
+
+    pairer.reset();
+    TEST_ASSERT_EQUAL_UINT32(0, pairer.getPairedCount());
+    TEST_ASSERT_EQUAL_UINT32(0, pairer.getUnpairedRPeaks());
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_r_peak_then_pulse_pairs);
+    RUN_TEST(test_pulse_reported_before_its_r_peak);
+    RUN_TEST(test_one_to_one_at_high_heart_rate);
+    RUN_TEST(test_missed_pulse_expires_its_window);
+    RUN_TEST(test_missed_r_peak_does_not_borrow_a_pulse);
+    RUN_TEST(test_pulse_too_soon_after_r_peak_is_rejected);
+    RUN_TEST(test_queues_stay_bounded_without_the_other_stream);
+    return UNITY_END();
+}
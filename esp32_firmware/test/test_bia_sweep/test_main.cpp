@@ -0,0 +1,254 @@
+// Host tests for the AD5940 hardware-sequenced sweep, against an emulated chip
+// Run with: pio test -e native -f test_bia_sweep
+
+#include <unity.h>
+#include <math.h>
+#include "hal/hal.h"
+#include "BIA_Application.h"
+#include "../mocks/mock_hal.h"
+#include "../mocks/mock_ad5940.h"
+
+static const uint8_t CS_PIN = 5;
+static const uint8_t RESET_PIN = 25;
+static const uint8_t INT_PIN = 26;
+static const float BODY_SWEEP[] = {1000.0f, 5000.0f, 10000.0f, 50000.0f, 100000.0f};
+static const uint32_t BODY_POINTS = sizeof(BODY_SWEEP) / sizeof(BODY_SWEEP[0]);
+
+static MockAD5940* chip;
+
+// Samples the INT line whenever the firmware sleeps, as the pin interrupt would
+class InterruptClock : public ManualClock {
+public:
+    void delayMs(uint32_t ms) override {
+        ManualClock::delayMs(ms);
+        bool low = chip != nullptr && chip->intAsserted();
+        if (low && !wasLow) AD5940Class::onInterrupt();
+        wasLow = low;
+    }
+
+private:
+    bool wasLow = false;
+};
+
+static InterruptClock manualClock;
+
+// Initialized, with the self-test's measurement left out of the counters
+static void initialize(BIAApplication& bia, int intPin = -1) {
+    TEST_ASSERT_TRUE(bia.initialize(CS_PIN, RESET_PIN, intPin));
+    chip->triggers = 0;
+    chip->measuredHz.clear();
+}
+
+void setUp() {
+    manualClock = InterruptClock();
+    chip = new MockAD5940(manualClock, CS_PIN);
+    hal::setClock(&manualClock);
+    hal::setSpi(chip);
+    hal::setGpio(chip);
+}
+
+void tearDown() {
+    hal::setClock(nullptr);
+    hal::setSpi(nullptr);
+    hal::setGpio(nullptr);
+    delete chip;
+    chip = nullptr;
+}
+
+static void assertMatchesLoad(const BIAResult& result, float frequencyHz) {
+    float r, x;
+    chip->load.impedanceAt(frequencyHz, r, x);
+    TEST_ASSERT_TRUE(result.Valid);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, frequencyHz, result.Frequency);
+    TEST_ASSERT_FLOAT_WITHIN(0.5f, r, result.Resistance);
+    TEST_ASSERT_FLOAT_WITHIN(0.5f, -x, result.Reactance);
+}
+
+void test_initialize_runs_the_self_test() {
+    BIAApplication bia;
+    TEST_ASSERT_TRUE(bia.initialize(CS_PIN, RESET_PIN));
+    TEST_ASSERT_EQUAL_STRING("BIA Status: Ready, Freq: 1000.0-100000.0Hz", bia.getStatus().c_str());
+}
+
+void test_initialize_programs_the_front_end() {
+    BIAApplication bia;
+    initialize(bia);
+    TEST_ASSERT_EQUAL_UINT32(AD5940_WGCON_SINE, chip->reg(AD5940_REG_WGCON));
+    TEST_ASSERT_EQUAL_UINT32(AD5940_HSDACCON_RATE_16MHZ, chip->reg(AD5940_REG_HSDACCON));
+    TEST_ASSERT_EQUAL_UINT32(AD5940_ADCCON_AIN2_AIN3, chip->reg(AD5940_REG_ADCCON));
+    TEST_ASSERT_EQUAL_UINT32(AD5940_INT_ENDSEQ, chip->reg(AD5940_REG_INTCSEL0));
+    TEST_ASSERT_EQUAL_UINT32(AD5940_FIFOCON_DFT, chip->reg(AD5940_REG_FIFOCON));
+    // The datasheet's start-up table went in after the reset
+    TEST_ASSERT_EQUAL_UINT32(0xDE87A5A0, chip->reg(0x2230));
+    TEST_ASSERT_EQUAL_UINT32(0xF27B, chip->reg(0x0A04));
+}
+
+void test_single_measurement_programs_the_generator() {
+    BIAApplication bia;
+    initialize(bia);
+    BIAResult result;
+    TEST_ASSERT_TRUE(bia.performSingleMeasurement(50000.0f, result));
+    // 50 kHz * 2^30 / 16 MHz
+    TEST_ASSERT_EQUAL_UINT32(3355443, chip->reg(AD5940_REG_WGFCW));
+    assertMatchesLoad(result, 50000.0f);
+    TEST_ASSERT_FALSE(bia.isMeasuring());
+}
+
+void test_sweep_runs_on_the_sequencer() {
+    BIAApplication bia;
+    initialize(bia);
+    BIAResult results[BODY_POINTS];
+    uint32_t count = 0;
+    uint64_t startUs = manualClock.nowUs;
+    TEST_ASSERT_TRUE(bia.performSweep(BODY_SWEEP, BODY_POINTS, results, &count));
+
+    TEST_ASSERT_EQUAL_UINT32(1, chip->triggers);
+    TEST_ASSERT_EQUAL_UINT32(BODY_POINTS * 7 + 2, chip->sram.size());
+    TEST_ASSERT_EQUAL_UINT32(BODY_POINTS, chip->measuredHz.size());
+    TEST_ASSERT_EQUAL_UINT32(0, chip->shortDfts);
+    TEST_ASSERT_EQUAL_UINT32(BODY_POINTS, count);
+    for (uint32_t i = 0; i < BODY_POINTS; i++) {
+        TEST_ASSERT_FLOAT_WITHIN(0.02, BODY_SWEEP[i], chip->measuredHz[i]);
+        assertMatchesLoad(results[i], BODY_SWEEP[i]);
+    }
+    // 1 ms settling per point, then 2048 DFT samples at 1 kHz and 1024 above
+    uint64_t elapsedMs = (manualClock.nowUs - startUs) / 1000;
+    TEST_ASSERT_TRUE(elapsedMs >= 20);
+    TEST_ASSERT_TRUE(elapsedMs <= 23);
+}
+
+void test_fifo_drains_in_one_burst() {
+    BIAApplication bia;
+    initialize(bia);
+    TEST_ASSERT_TRUE(bia.beginSweep(BODY_SWEEP, BODY_POINTS));
+    manualClock.advanceMs(50);
+    TEST_ASSERT_TRUE(bia.isSweepReady());
+    TEST_ASSERT_EQUAL_UINT32(BODY_POINTS * 2, chip->fifo.size());
+
+    chip->frames = 0;
+    chip->bursts = 0;
+    BIAResult results[BODY_POINTS];
+    TEST_ASSERT_EQUAL_UINT32(BODY_POINTS, bia.finishSweep(results, BODY_POINTS));
+    // FIFO count (address, read), the burst, clearing the interrupt (address, write)
+    TEST_ASSERT_EQUAL_UINT32(5, chip->frames);
+    TEST_ASSERT_EQUAL_UINT32(1, chip->bursts);
+    TEST_ASSERT_EQUAL_UINT32(0, chip->fifo.size());
+    TEST_ASSERT_EQUAL_UINT32(0, chip->reg(AD5940_REG_INTCFLG0));
+    assertMatchesLoad(results[0], BODY_SWEEP[0]);
+    assertMatchesLoad(results[BODY_POINTS - 1], BODY_SWEEP[BODY_POINTS - 1]);
+}
+
+void test_waiting_on_the_interrupt_stays_off_the_bus() {
+    BIAApplication bia;
+    initialize(bia, INT_PIN);
+    TEST_ASSERT_TRUE(bia.beginSweep(BODY_SWEEP, BODY_POINTS));
+
+    chip->frames = 0;
+    uint32_t waitedMs = 0;
+    while (!bia.isSweepReady() && waitedMs < 100) {
+        manualClock.advanceMs(1);
+        waitedMs++;
+        // The INT edge
+        if (chip->intAsserted()) AD5940Class::onInterrupt();
+    }
+    TEST_ASSERT_EQUAL_UINT32(0, chip->frames);
+    TEST_ASSERT_TRUE(waitedMs >= 20 && waitedMs <= 23);
+
+    BIAResult results[BODY_POINTS];
+    TEST_ASSERT_EQUAL_UINT32(BODY_POINTS, bia.finishSweep(results, BODY_POINTS));
+    TEST_ASSERT_FALSE(bia.isSweepReady());
+}
+
+void test_table_reloads_only_when_it_changes() {
+    BIAApplication bia;
+    initialize(bia);
+    BIAResult results[BODY_POINTS];
+    uint32_t count = 0;
+    TEST_ASSERT_TRUE(bia.performSweep(BODY_SWEEP, BODY_POINTS, results, &count));
+    uint32_t loaded = chip->sramWrites;
+
+    TEST_ASSERT_TRUE(bia.performSweep(BODY_SWEEP, BODY_POINTS, results, &count));
+    TEST_ASSERT_EQUAL_UINT32(loaded, chip->sramWrites);
+    TEST_ASSERT_EQUAL_UINT32(2, chip->triggers);
+    TEST_ASSERT_EQUAL_UINT32(BODY_POINTS, count);
+
+    float twoPoints[] = {5000.0f, 200000.0f};
+    TEST_ASSERT_TRUE(bia.performSweep(twoPoints, 2, results, &count));
+    TEST_ASSERT_EQUAL_UINT32(loaded + 2 * 7 + 2, chip->sramWrites);
+    TEST_ASSERT_EQUAL_UINT32(2, count);
+    assertMatchesLoad(results[1], 200000.0f);
+}
+
+void test_sweep_rejects_what_the_chip_cannot_hold() {
+    BIAApplication bia;
+    initialize(bia);
+    float tooHigh[] = {10000.0f, 300000.0f};    // Past the 24-bit frequency word
+    TEST_ASSERT_FALSE(bia.beginSweep(tooHigh, 2));
+    float tooMany[AD5940_SWEEP_MAX_POINTS + 1];
+    for (uint32_t i = 0; i < AD5940_SWEEP_MAX_POINTS + 1; i++) tooMany[i] = 1000.0f * (i + 1);
+    TEST_ASSERT_FALSE(bia.beginSweep(tooMany, AD5940_SWEEP_MAX_POINTS + 1));
+    TEST_ASSERT_EQUAL_UINT32(0, chip->triggers);
+
+}
+
+void test_timeout_stops_the_sequencer() {
+    BIAApplication bia;
+    initialize(bia);
+
+    // A sweep the chip never finishes times out
+    chip->stalled = true;
+    BIAResult results[BODY_POINTS];
+    uint32_t count = 0;
+    TEST_ASSERT_FALSE(bia.performSweep(BODY_SWEEP, BODY_POINTS, results, &count, 100));
+    TEST_ASSERT_EQUAL_UINT32(0, count);
+    TEST_ASSERT_FALSE(chip->running());
+    TEST_ASSERT_EQUAL_UINT32(0, chip->reg(AD5940_REG_SEQCON));
+    TEST_ASSERT_EQUAL_UINT32(0, chip->fifo.size());
+    TEST_ASSERT_FALSE(bia.isMeasuring());
+
+    // Abandoned from the scheduler's side, then the next sweep runs clean
+    TEST_ASSERT_TRUE(bia.beginSweep(BODY_SWEEP, BODY_POINTS));
+    manualClock.advanceMs(50);
+    bia.cancelSweep();
+    TEST_ASSERT_FALSE(chip->running());
+    TEST_ASSERT_FALSE(bia.isSweepReady());
+
+    chip->stalled = false;
+    TEST_ASSERT_TRUE(bia.performSweep(BODY_SWEEP, BODY_POINTS, results, &count));
+    TEST_ASSERT_EQUAL_UINT32(BODY_POINTS, count);
+    assertMatchesLoad(results[0], BODY_SWEEP[0]);
+}
+
+void test_frequency_sweep_splits_long_tables() {
+    BIAApplication bia;
+    initialize(bia);
+    BIAConfig config = {1000.0f, 100000.0f, 20, 200.0f, true};
+    TEST_ASSERT_TRUE(bia.configure(config));
+
+    BIAResult results[20];
+    uint32_t count = 0;
+    TEST_ASSERT_TRUE(bia.performFrequencySweep(results, 20, &count));
+    TEST_ASSERT_EQUAL_UINT32(20, count);
+    TEST_ASSERT_EQUAL_UINT32(2, chip->triggers);
+    assertMatchesLoad(results[0], 1000.0f);
+    assertMatchesLoad(results[19], 100000.0f);
+    for (uint32_t i = 1; i < count; i++) {
+        // Log spaced over two decades
+        TEST_ASSERT_FLOAT_WITHIN(0.01f, 2.0f / 19, log10(results[i].Frequency / results[i - 1].Frequency));
+    }
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_initialize_runs_the_self_test);
+    RUN_TEST(test_initialize_programs_the_front_end);
+    RUN_TEST(test_single_measurement_programs_the_generator);
+    RUN_TEST(test_sweep_runs_on_the_sequencer);
+    RUN_TEST(test_fifo_drains_in_one_burst);
+    RUN_TEST(test_waiting_on_the_interrupt_stays_off_the_bus);
+    RUN_TEST(test_table_reloads_only_when_it_changes);
+    RUN_TEST(test_sweep_rejects_what_the_chip_cannot_hold);
+    RUN_TEST(test_timeout_stops_the_sequencer);
+    RUN_TEST(test_frequency_sweep_splits_long_tables);
+    return UNITY_END();
+}
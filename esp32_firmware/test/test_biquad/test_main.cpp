@@ -0,0 +1,302 @@
+// Host tests for the cascaded biquad engine and the ECG/PPG band-pass designs
+// Run with: pio test -e native -f test_biquad
+
+#include <unity.h>
+#include <math.h>
+#include <complex>
+#include "dsp/bandpass_designs.h"
+
+// The tables really are compile-time constants
+static_assert(ECGBandpass<250>::coeffs[0].b0 > 0.99f && ECGBandpass<250>::coeffs[0].b0 < 1.0f,
+              "ECG high-pass section not evaluated at compile time");
+static_assert(PPGBandpass<200>::coeffsQ14[0].b0 > 16000, "PPG Q14 table not evaluated at compile time");
+
+// Reference transfer functions (b, a of the whole 6th-order cascade), built
+// independently of biquad.h: analogue Butterworth prototype poles, pre-warped
+// and mapped through the bilinear transform as scipy.signal.butter() does,
+// then the 2nd-order high-pass and 4th-order low-pass polynomials multiplied.
+struct ReferenceDesign {
+    double sampleRateHz;
+    double b[7];
+    double a[7];
+};
+
+static const ReferenceDesign ECG_250 = {250, {
+    0.022667888598723585, 0.04533577719744717, -0.022667888598723606, -0.090671554394894313,
+    -0.022667888598723596, 0.04533577719744717, 0.022667888598723585}, {
+    1, -3.3942124309891062, 4.9040260758969438, -4.0207624067565471,
+    1.9750908041830488, -0.52618301789540489, 0.062098250180294808}};
+
+static const ReferenceDesign PPG_200 = {200, {
+    0.00018119226462534355, 0.0003623845292506871, -0.00018119226462534344, -0.00072476905850137443,
+    -0.0001811922646253435, 0.0003623845292506871, 0.00018119226462534355}, {
+    1, -5.3218543214886376, 11.830746629634993, -14.063511052961799,
+    9.4283822016392449, -3.379872208348111, 0.50610946687211622}};
+
+static const ReferenceDesign ECG_500 = {500, {
+    0.0022249843606471989, 0.0044499687212943978, -0.0022249843606471989, -0.0088999374425887956,
+    -0.0022249843606471989, 0.0044499687212943978, 0.0022249843606471989}, {
+    1, -4.6837252792190887, 9.2198489245699395, -9.7815950810246477,
+    5.9009861422776844, -1.9176286434356897, 0.26211534226283839}};
+
+static const ReferenceDesign PPG_400 = {400, {
+    1.3220105422579055e-05, 2.644021084515811e-05, -1.3220105422579048e-05, -5.2880421690316233e-05,
+    -1.3220105422579045e-05, 2.644021084515811e-05, 1.3220105422579055e-05}, {
+    1, -5.6606219950615886, 13.359628574486884, -16.826845051018044,
+    11.929253383058581, -4.513373276164022, 0.71195837774604398}};
+
+typedef std::complex<double> Complex;
+
+static Complex referenceResponse(const ReferenceDesign& ref, double hz) {
+    Complex zInv = std::polar(1.0, -2.0 * M_PI * hz / ref.sampleRateHz);
+    Complex num = 0, den = 0, power = 1;
+    for (int i = 0; i < 7; i++) {
+        num += ref.b[i] * power;
+        den += ref.a[i] * power;
+        power *= zInv;
+    }
+    return num / den;
+}
+
+template <size_t N>
+static Complex cascadeResponse(const BiquadCoeffs (&coeffs)[N], double sampleRateHz, double hz) {
+    Complex zInv = std::polar(1.0, -2.0 * M_PI * hz / sampleRateHz);
+    Complex h = 1;
+    for (size_t s = 0; s < N; s++) {
+        const BiquadCoeffs& c = coeffs[s];
+        h *= ((double)c.b0 + (double)c.b1 * zInv + (double)c.b2 * zInv * zInv) /
+             (1.0 + (double)c.a1 * zInv + (double)c.a2 * zInv * zInv);
+    }
+    return h;
+}
+
+static double dB(Complex h) {
+    return 20.0 * log10(std::abs(h));
+}
+
+template <size_t N>
+static void checkAgainstReference(const BiquadCoeffs (&coeffs)[N], const ReferenceDesign& ref) {
+    // Log-spaced from 0.05 Hz to just under Nyquist
+    double nyquist = ref.sampleRateHz / 2;
+    for (double hz = 0.05; hz < nyquist * 0.98; hz *= 1.07) {
+        Complex expected = referenceResponse(ref, hz);
+        Complex actual = cascadeResponse(coeffs, ref.sampleRateHz, hz);
+        if (dB(expected) > -60.0) {
+            // Float coefficient rounding only: well under a hundredth of a dB
+            TEST_ASSERT_FLOAT_WITHIN(0.01, dB(expected), dB(actual));
+            TEST_ASSERT_FLOAT_WITHIN(0.001, 0.0, std::abs(std::arg(actual / expected)));
+        } else {
+            TEST_ASSERT_FLOAT_WITHIN(1e-4, std::abs(expected), std::abs(actual));
+        }
+    }
+}
+
+// Steady-state gain of a filter instance for a sine at hz
+template <typename Filter>
+static double measuredGain(Filter& filter, double sampleRateHz, double hz) {
+    const int settle = (int)(10 * sampleRateHz);
+    const int periods = (int)ceil(4 * hz);
+    const int measure = (int)lround(periods * sampleRateHz / hz);
+    double sumSq = 0;
+    for (int n = 0; n < settle + measure; n++) {
+        float y = filter.process((float)sin(2 * M_PI * hz * n / sampleRateHz));
+        if (n >= settle) sumSq += (double)y * y;
+    }
+    return sqrt(2.0 * sumSq / measure);
+}
+
+// Small deterministic noise source
+static uint32_t noiseState = 1;
+static double noise(double amplitude) {
+    noiseState = noiseState * 1664525u + 1013904223u;
+    return amplitude * ((noiseState >> 8) / 16777216.0 - 0.5);
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_constexpr_trig_matches_libm() {
+    for (double x = 0.0; x < M_PI / 2 - 0.05; x += 0.01) {
+        TEST_ASSERT_DOUBLE_WITHIN(1e-12, tan(x), BiquadDesign::tan(x));
+    }
+    TEST_ASSERT_DOUBLE_WITHIN(1e-12, sqrt(0.5), BiquadDesign::butterworthQ(2, 0));
+    TEST_ASSERT_DOUBLE_WITHIN(1e-12, 0.541196100146197, BiquadDesign::butterworthQ(4, 0));
+    TEST_ASSERT_DOUBLE_WITHIN(1e-12, 1.306562964876377, BiquadDesign::butterworthQ(4, 1));
+}
+
+void test_designs_match_reference_transfer_functions() {
+    checkAgainstReference(ECGBandpass<250>::coeffs, ECG_250);
+    checkAgainstReference(PPGBandpass<200>::coeffs, PPG_200);
+    checkAgainstReference(ECGBandpass<500>::coeffs, ECG_500);
+    checkAgainstReference(PPGBandpass<400>::coeffs, PPG_400);
+}
+
+void test_band_edges_and_stopbands() {
+    const BiquadCoeffs (&ecg)[3] = ECGBandpass<250>::coeffs;
+    TEST_ASSERT_FLOAT_WITHIN(0.05, -3.01, dB(cascadeResponse(ecg, 250, 0.5)));
+    TEST_ASSERT_FLOAT_WITHIN(0.05, -3.01, dB(cascadeResponse(ecg, 250, 40)));
+    TEST_ASSERT_FLOAT_WITHIN(0.05, 0.0, dB(cascadeResponse(ecg, 250, 10)));
+    TEST_ASSERT_LESS_THAN(-39.0, dB(cascadeResponse(ecg, 250, 0.05)));    // Baseline wander
+    TEST_ASSERT_LESS_THAN(-38.0, dB(cascadeResponse(ecg, 250, 100)));     // EMG
+
+    const BiquadCoeffs (&ppg)[3] = PPGBandpass<200>::coeffs;
+    TEST_ASSERT_FLOAT_WITHIN(0.05, -3.01, dB(cascadeResponse(ppg, 200, 0.5)));
+    TEST_ASSERT_FLOAT_WITHIN(0.05, -3.01, dB(cascadeResponse(ppg, 200, 8)));
+    TEST_ASSERT_FLOAT_WITHIN(0.05, 0.0, dB(cascadeResponse(ppg, 200, 2)));
+    TEST_ASSERT_LESS_THAN(-45.0, dB(cascadeResponse(ppg, 200, 50)));      // Mains
+}
+
+void test_float_cascade_follows_designed_response() {
+    const double frequencies[] = {0.5, 1.0, 5.0, 17.0, 40.0, 60.0};
+    for (double hz : frequencies) {
+        BiquadCascade<3> filter(ECGBandpass<250>::coeffs);
+        double expected = std::abs(cascadeResponse(ECGBandpass<250>::coeffs, 250, hz));
+        TEST_ASSERT_FLOAT_WITHIN(0.005 * expected + 1e-4, expected, measuredGain(filter, 250, hz));
+    }
+
+    // processBlock() is the same filter
+    BiquadCascade<3> single(PPGBandpass<200>::coeffs);
+    BiquadCascade<3> block(PPGBandpass<200>::coeffs);
+    float buffer[37];
+    for (int chunk = 0; chunk < 50; chunk++) {
+        for (int i = 0; i < 37; i++) {
+            buffer[i] = (float)(90000 + 800 * sin((chunk * 37 + i) * 0.07) + noise(50));
+        }
+        float expected[37];
+        for (int i = 0; i < 37; i++) expected[i] = single.process(buffer[i]);
+        block.processBlock(buffer, buffer, 37);
+        for (int i = 0; i < 37; i++) TEST_ASSERT_EQUAL_FLOAT(expected[i], buffer[i]);
+    }
+}
+
+void test_channels_keep_separate_state() {
+    // ECG and PPG samples interleaved the way the sensor tasks deliver them
+    // must filter exactly as if each channel ran alone
+    BiquadCascade<3> ecgAlone(ECGBandpass<250>::coeffs);
+    BiquadCascade<3> ppgAlone(PPGBandpass<200>::coeffs);
+    BiquadCascade<3> ecgShared(ECGBandpass<250>::coeffs);
+    BiquadCascade<3> ppgShared(PPGBandpass<200>::coeffs);
+
+    for (int n = 0; n < 5000; n++) {
+        float ecg = (float)(2048 + 400 * sin(n * 0.21));
+        float ppg = (float)(90000 + 900 * sin(n * 0.05));
+        float a = ecgAlone.process(ecg);
+        float b = ppgAlone.process(ppg);
+        float c;
+        float d;
+        if (n % 3 == 0) {
+            d = ppgShared.process(ppg);
+            c = ecgShared.process(ecg);
+        } else {
+            c = ecgShared.process(ecg);
+            d = ppgShared.process(ppg);
+        }
+        TEST_ASSERT_TRUE(a == c && b == d);
+    }
+}
+
+void test_prime_removes_start_up_transient() {
+    // Raw IR counts: ~90000 DC with a 600-count pulse
+    BiquadCascade<3> cold(PPGBandpass<200>::coeffs);
+    BiquadCascade<3> primed(PPGBandpass<200>::coeffs);
+    primed.prime(90000.0f);
+
+    float coldPeak = 0, primedPeak = 0;
+    for (int n = 0; n < 400; n++) {
+        float x = (float)(90000 + 600 * sin(2 * M_PI * 1.2 * n / 200.0));
+        coldPeak = fmaxf(coldPeak, fabsf(cold.process(x)));
+        primedPeak = fmaxf(primedPeak, fabsf(primed.process(x)));
+    }
+    TEST_ASSERT_GREATER_THAN(20000.0f, coldPeak);    // The DC step rings through the high-pass
+    TEST_ASSERT_LESS_THAN(700.0f, primedPeak);
+
+    BiquadCascadeQ15<3> q15(PPGBandpass<200>::coeffsQ14);
+    q15.prime(12000);
+    for (int n = 0; n < 100; n++) {
+        TEST_ASSERT_INT_WITHIN(2, 0, q15.process(12000));
+    }
+}
+
+static BiquadCoeffs dequantise(const BiquadCoeffsQ14& q) {
+    return {q.b0 / 16384.0f, q.b1 / 16384.0f, q.b2 / 16384.0f, q.a1 / 16384.0f, q.a2 / 16384.0f};
+}
+
+struct Q15Error {
+    double arithmeticDb;    // Signal to error against a float filter with the same Q14 coefficients
+    double designDb;        // Signal to error against the float design
+};
+
+template <size_t N>
+static Q15Error q15SignalToError(const BiquadCoeffs (&coeffs)[N], const BiquadCoeffsQ14 (&coeffsQ14)[N],
+                                 double sampleRateHz, double offset, double amplitude) {
+    BiquadCoeffs sameCoeffs[N];
+    for (size_t s = 0; s < N; s++) sameCoeffs[s] = dequantise(coeffsQ14[s]);
+    BiquadCascade<N> design(coeffs);
+    BiquadCascade<N> same(sameCoeffs);
+    BiquadCascadeQ15<N> fixed(coeffsQ14);
+    design.prime((float)offset);
+    same.prime((float)offset);
+    fixed.prime((int16_t)offset);
+    noiseState = 7;
+
+    double signalSq = 0, arithmeticSq = 0, designSq = 0;
+    int total = (int)(60 * sampleRateHz);
+    for (int n = 0; n < total; n++) {
+        double t = n / sampleRateHz;
+        // Narrow 72 bpm pulse train with harmonics across the pass band, plus drift and noise
+        double phase = fmod(t * 1.2, 1.0);
+        double x = offset + amplitude * exp(-pow((phase - 0.3) / 0.03, 2)) +
+                   0.2 * amplitude * sin(2 * M_PI * 0.15 * t) + noise(0.02 * amplitude);
+        int16_t q = (int16_t)lround(x);
+        double expected = design.process((float)q);
+        double reference = same.process((float)q);
+        double actual = fixed.process(q);
+        if (n > sampleRateHz * 5) {
+            signalSq += expected * expected;
+            arithmeticSq += (actual - reference) * (actual - reference);
+            designSq += (actual - expected) * (actual - expected);
+        }
+    }
+    return {10 * log10(signalSq / arithmeticSq), 10 * log10(signalSq / designSq)};
+}
+
+void test_q15_back_end_tracks_float() {
+    // ECG: 12-bit AD8232 reading (raw - 2048) << 3, R-waves ~ a fifth of full scale
+    Q15Error ecg = q15SignalToError(ECGBandpass<250>::coeffs, ECGBandpass<250>::coeffsQ14, 250, 1500, 6000);
+    // PPG: 18-bit counts >> 4 with the DC left in; the high-pass runs first
+    Q15Error ppg = q15SignalToError(PPGBandpass<200>::coeffs, PPGBandpass<200>::coeffsQ14, 200, 5600, 400);
+    char line[128];
+    snprintf(line, sizeof(line), "Q15 arithmetic: ECG %.1f dB, PPG %.1f dB; vs float design: ECG %.1f dB, PPG %.1f dB",
+             ecg.arithmeticDb, ppg.arithmeticDb, ecg.designDb, ppg.designDb);
+    TEST_MESSAGE(line);
+
+    // Rounding noise stays far below the signal...
+    TEST_ASSERT_GREATER_THAN(60.0, ecg.arithmeticDb);
+    TEST_ASSERT_GREATER_THAN(40.0, ppg.arithmeticDb);
+    // ...the rest is the 14-bit coefficients nudging the 0.5 Hz corner
+    TEST_ASSERT_GREATER_THAN(30.0, ecg.designDb);
+    TEST_ASSERT_GREATER_THAN(40.0, ppg.designDb);
+}
+
+void test_q14_quantisation_keeps_the_response() {
+    BiquadCoeffs dequantised[3];
+    for (int s = 0; s < 3; s++) dequantised[s] = dequantise(PPGBandpass<200>::coeffsQ14[s]);
+    // The band itself survives 14-bit coefficients
+    const double frequencies[] = {0.5, 1.0, 2.0, 5.0, 8.0};
+    for (double hz : frequencies) {
+        TEST_ASSERT_FLOAT_WITHIN(0.5, dB(referenceResponse(PPG_200, hz)), dB(cascadeResponse(dequantised, 200, hz)));
+    }
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_constexpr_trig_matches_libm);
+    RUN_TEST(test_designs_match_reference_transfer_functions);
+    RUN_TEST(test_band_edges_and_stopbands);
+    RUN_TEST(test_float_cascade_follows_designed_response);
+    RUN_TEST(test_channels_keep_separate_state);
+    RUN_TEST(test_prime_removes_start_up_transient);
+    RUN_TEST(test_q15_back_end_tracks_float);
+    RUN_TEST(test_q14_quantisation_keeps_the_response);
+    return UNITY_END();
+}
@@ -0,0 +1,109 @@
+// Per-sample cost of the biquad back ends against the old boxcar filter
+// Run with: pio test -e native -f test_biquad_bench -v   (-v shows the numbers)
+
+#include <unity.h>
+#include <stdio.h>
+#include <math.h>
+#include "dsp/bandpass_designs.h"
+#include "../mocks/bench_util.h"
+
+static const uint32_t SAMPLES = 4000000;
+static const int BLOCK = 32;
+
+// AD8232-like input: mid-rail offset, a beat every 200 samples, a little noise
+static float inputs[4096];
+static int16_t inputsQ15[4096];
+
+void setUp() {
+    for (int i = 0; i < 4096; i++) {
+        int phase = i % 200;
+        float beat = phase < 8 ? 600.0f * (1.0f - fabsf(phase - 4) / 4.0f) : 0.0f;
+        inputs[i] = 2048.0f + beat + 30.0f * sinf(i * 0.013f) + (float)((i * 7919) % 17) - 8.0f;
+        inputsQ15[i] = (int16_t)((inputs[i] - 2048.0f) * 8.0f);
+    }
+}
+void tearDown() {}
+
+void test_bench_boxcar_vs_biquad() {
+    // Previous applyBandpassFilter(): 10-tap window re-summed on every sample
+    float window[10] = {0};
+    int filterIndex = 0;
+    float checksum = 0;
+    BenchTimer timer;
+    for (uint32_t n = 0; n < SAMPLES; n++) {
+        window[filterIndex] = inputs[n & 4095];
+        filterIndex = (filterIndex + 1) % 10;
+        float sum = 0;
+        for (int i = 0; i < 10; i++) sum += window[i];
+        checksum += sum / 10.0f;
+    }
+    benchReport("boxcar, 10 taps (old)", SAMPLES, timer.seconds());
+    benchSink = checksum;
+
+    BiquadCascade<ECGBandpass<250>::SECTIONS> filter(ECGBandpass<250>::coeffs);
+    checksum = 0;
+    timer.restart();
+    for (uint32_t n = 0; n < SAMPLES; n++) {
+        checksum += filter.process(inputs[n & 4095]);
+    }
+    benchReport("biquad float, 3 sections, per sample", SAMPLES, timer.seconds());
+    benchSink = checksum;
+    TEST_ASSERT_TRUE(isfinite(checksum));
+
+    filter.reset();
+    float block[BLOCK];
+    checksum = 0;
+    timer.restart();
+    for (uint32_t n = 0; n < SAMPLES; n += BLOCK) {
+        filter.processBlock(&inputs[n & 4095], block, BLOCK);
+        checksum += block[BLOCK - 1];
+    }
+    benchReport("biquad float, 3 sections, block of 32", SAMPLES, timer.seconds());
+    benchSink = checksum;
+    TEST_ASSERT_TRUE(isfinite(checksum));
+}
+
+void test_bench_q15() {
+    BiquadCascadeQ15<ECGBandpass<250>::SECTIONS> filter(ECGBandpass<250>::coeffsQ14);
+    int32_t checksum = 0;
+    BenchTimer timer;
+    for (uint32_t n = 0; n < SAMPLES; n++) {
+        checksum += filter.process(inputsQ15[n & 4095]);
+    }
+    benchReport("biquad Q15, 3 sections, per sample", SAMPLES, timer.seconds());
+    benchSinkBits = checksum;
+
+    int16_t block[BLOCK];
+    timer.restart();
+    for (uint32_t n = 0; n < SAMPLES; n += BLOCK) {
+        filter.processBlock(&inputsQ15[n & 4095], block, BLOCK);
+        checksum += block[BLOCK - 1];
+    }
+    benchReport("biquad Q15, 3 sections, block of 32", SAMPLES, timer.seconds());
+    benchSinkBits = checksum;
+}
+
+void test_bench_two_channels_interleaved() {
+    // ECG and PPG through their own instances, the way BloodPressureMonitor runs them
+    BiquadCascade<3> ecg(ECGBandpass<250>::coeffs);
+    BiquadCascade<3> ppg(PPGBandpass<200>::coeffs);
+    ppg.prime(90000.0f);
+    float checksum = 0;
+    BenchTimer timer;
+    for (uint32_t n = 0; n < SAMPLES; n++) {
+        float x = inputs[n & 4095];
+        checksum += ecg.process(x);
+        checksum += ppg.process(x * 40.0f + 8000.0f);
+    }
+    benchReport("ECG + PPG float, interleaved (per pair)", SAMPLES, timer.seconds());
+    benchSink = checksum;
+    TEST_ASSERT_TRUE(isfinite(checksum));
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_bench_boxcar_vs_biquad);
+    RUN_TEST(test_bench_q15);
+    RUN_TEST(test_bench_two_channels_interleaved);
+    return UNITY_END();
+}
@@ -0,0 +1,139 @@
+// Host tests for the non-blocking DS18B20 conversion pipeline
+// Run with: pio test -e native -f test_ds18b20_pipeline
+
+#include <unity.h>
+#include "sensors/ds18b20_pipeline.h"
+#include "../mocks/mock_temperature_bus.h"
+
+void setUp() {}
+void tearDown() {}
+
+void test_conversion_time_follows_resolution() {
+    MockTemperatureBus bus;
+    DS18B20Pipeline pipeline(bus);
+
+    pipeline.begin(9, 0);
+    TEST_ASSERT_EQUAL_UINT32(93, pipeline.conversionTimeMs());
+    pipeline.begin(10, 0);
+    TEST_ASSERT_EQUAL_UINT32(187, pipeline.conversionTimeMs());
+    pipeline.begin(11, 0);
+    TEST_ASSERT_EQUAL_UINT32(375, pipeline.conversionTimeMs());
+    pipeline.begin(12, 0);
+    TEST_ASSERT_EQUAL_UINT32(750, pipeline.conversionTimeMs());
+    TEST_ASSERT_EQUAL(12, bus.resolution[0]);
+}
+
+void test_value_published_only_after_conversion_time() {
+    MockTemperatureBus bus;
+    DS18B20Pipeline pipeline(bus);
+    TEST_ASSERT_EQUAL(1, pipeline.begin(12, 1000));
+
+    bus.nowMs = 0;
+    TEST_ASSERT_FALSE(pipeline.update(bus.nowMs));  // Starts the conversion
+    TEST_ASSERT_TRUE(pipeline.isConverting());
+    TEST_ASSERT_FALSE(pipeline.hasReading());
+
+    // The old delay(100) would have read here and got the stale 85 C scratchpad
+    bus.nowMs = 100;
+    TEST_ASSERT_FALSE(pipeline.update(bus.nowMs));
+    bus.nowMs = 749;
+    TEST_ASSERT_FALSE(pipeline.update(bus.nowMs));
+
+    bus.nowMs = 750;
+    TEST_ASSERT_TRUE(pipeline.update(bus.nowMs));
+    TEST_ASSERT_TRUE(pipeline.hasReading());
+    TEST_ASSERT_TRUE(pipeline.channel(0).valid);
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 36.5f, pipeline.channel(0).celsius);
+    TEST_ASSERT_EQUAL_UINT32(0, bus.earlyReads);
+}
+
+void test_interval_spaces_conversions() {
+    MockTemperatureBus bus;
+    DS18B20Pipeline pipeline(bus);
+    pipeline.begin(12, 5000);
+
+    // 1 s sensor tick for 30 s
+    uint32_t published = 0;
+    for (bus.nowMs = 0; bus.nowMs < 30000; bus.nowMs += 1000) {
+        if (pipeline.update(bus.nowMs)) published++;
+    }
+    TEST_ASSERT_EQUAL_UINT32(6, bus.conversionRequests);
+    TEST_ASSERT_EQUAL_UINT32(6, published);
+    TEST_ASSERT_EQUAL_UINT32(0, bus.earlyReads);
+}
+
+void test_back_to_back_conversions_track_changes() {
+    MockTemperatureBus bus;
+    DS18B20Pipeline pipeline(bus);
+    pipeline.begin(12, 0);
+
+    for (bus.nowMs = 0; bus.nowMs <= 10000; bus.nowMs += 250) {
+        bus.trueCelsius[0] = 36.0f + bus.nowMs / 10000.0f;
+        pipeline.update(bus.nowMs);
+    }
+    // Latest value is at most one conversion (plus one tick) behind the truth
+    TEST_ASSERT_TRUE(pipeline.channel(0).valid);
+    TEST_ASSERT_GREATER_OR_EQUAL(10000 - 1000, pipeline.channel(0).timestampMs);
+    TEST_ASSERT_FLOAT_WITHIN(0.11f, 37.0f, pipeline.channel(0).celsius);
+}
+
+void test_multiple_sensors_use_cached_addresses() {
+    MockTemperatureBus bus;
+    bus.devices = 3;
+    DS18B20Pipeline pipeline(bus);
+    TEST_ASSERT_EQUAL(3, pipeline.begin(11, 0));
+    uint32_t enumerationsAfterInit = bus.enumerations;
+
+    for (bus.nowMs = 0; bus.nowMs < 20000; bus.nowMs += 100) {
+        pipeline.update(bus.nowMs);
+    }
+
+    // Reads never searched the bus again
+    TEST_ASSERT_EQUAL_UINT32(enumerationsAfterInit, bus.enumerations);
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 36.5f, pipeline.channel(0).celsius);
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 25.0f, pipeline.channel(1).celsius);
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 30.0f, pipeline.channel(2).celsius);
+    TEST_ASSERT_GREATER_THAN(40, pipeline.getStats().conversions);
+}
+
+void test_disconnected_sensor_is_flagged() {
+    MockTemperatureBus bus;
+    bus.devices = 2;
+    DS18B20Pipeline pipeline(bus);
+    pipeline.begin(9, 0);
+
+    bus.nowMs = 0;
+    pipeline.update(bus.nowMs);
+    bus.nowMs = 100;
+    TEST_ASSERT_TRUE(pipeline.update(bus.nowMs));
+    TEST_ASSERT_TRUE(pipeline.channel(1).valid);
+
+    bus.disconnected[1] = true;
+    bus.nowMs = 200;
+    TEST_ASSERT_TRUE(pipeline.update(bus.nowMs));
+    TEST_ASSERT_TRUE(pipeline.channel(0).valid);
+    TEST_ASSERT_FALSE(pipeline.channel(1).valid);
+    TEST_ASSERT_EQUAL_UINT32(1, pipeline.getStats().readErrors);
+}
+
+void test_empty_bus_never_converts() {
+    MockTemperatureBus bus;
+    bus.devices = 0;
+    DS18B20Pipeline pipeline(bus);
+    TEST_ASSERT_EQUAL(0, pipeline.begin(12, 0));
+    TEST_ASSERT_FALSE(pipeline.update(0));
+    TEST_ASSERT_FALSE(pipeline.update(1000));
+    TEST_ASSERT_EQUAL_UINT32(0, bus.conversionRequests);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_conversion_time_follows_resolution);
+    RUN_TEST(test_value_published_only_after_conversion_time);
+    RUN_TEST(test_interval_spaces_conversions);
+    RUN_TEST(test_back_to_back_conversions_track_changes);
+    RUN_TEST(test_multiple_sensors_use_cached_addresses);
+    RUN_TEST(test_disconnected_sensor_is_flagged);
+    RUN_TEST(test_empty_bus_never_converts);
+    return UNITY_END();
+}
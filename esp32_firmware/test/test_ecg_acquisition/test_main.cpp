@@ -0,0 +1,193 @@
+// Host tests for the timer-driven AD8232 acquisition engine
+// Run with: pio test -e native -f test_ecg_acquisition
+
+#include <unity.h>
+#include <stdio.h>
+#include "sensors/ecg_acquisition.h"
+#include "../mocks/mock_ecg_front_end.h"
+
+static const uint32_t START_US = 5000;
+
+struct StreamResult {
+    uint32_t ticks;
+    uint32_t received;
+    uint32_t orderErrors;
+    uint32_t gridErrors;
+    uint32_t partialBlocks;
+    ECGAcquisitionStats stats;
+};
+
+static void drainBlocks(ECGAcquisition& engine, StreamResult& result) {
+    ECGFrame block[ECGAcquisition::MAX_BLOCK_SIZE];
+    uint32_t period = engine.samplePeriodUs();
+    size_t n;
+    while ((n = engine.readBlock(block)) > 0) {
+        if (n != engine.blockSize()) result.partialBlocks++;
+        for (size_t i = 0; i < n; i++) {
+            uint32_t index = result.received + i;
+            if (block[i].raw != MockECGFrontEnd::valueFor(index)) result.orderErrors++;
+            if (block[i].timestampUs != START_US + index * period) result.gridErrors++;
+        }
+        result.received += n;
+    }
+}
+
+// Hardware timer ticks on the exact grid and the sampling task serves each
+// tick before the next one; the consumer pulls whole blocks every
+// consumerPeriodUs.
+static StreamResult stream(uint16_t rateHz, uint32_t durationUs, uint32_t consumerPeriodUs) {
+    MockECGFrontEnd frontEnd;
+    ECGAcquisition engine(frontEnd);
+    ECGAcquisitionConfig config;
+    config.sampleRateHz = rateHz;
+    engine.begin(config, START_US);
+
+    StreamResult result = {};
+    uint32_t period = engine.samplePeriodUs();
+    uint32_t nextConsume = START_US + consumerPeriodUs;
+
+    for (uint32_t tick = 0; START_US + tick * period < START_US + durationUs; tick++) {
+        uint32_t tickTime = START_US + tick * period;
+        engine.onTimerTick();
+        result.ticks++;
+        engine.service();
+
+        if (tickTime >= nextConsume) {
+            drainBlocks(engine, result);
+            nextConsume += consumerPeriodUs;
+        }
+    }
+
+    result.stats = engine.getStats();
+    drainBlocks(engine, result);
+    return result;
+}
+
+static void assertStream(uint16_t rateHz) {
+    const uint32_t duration = 60000000UL;
+    StreamResult r = stream(rateHz, duration, 1000000UL);
+
+    TEST_ASSERT_EQUAL_UINT32(0, r.stats.missedTicks);
+    TEST_ASSERT_EQUAL_UINT32(0, r.stats.ringDrops);
+    TEST_ASSERT_EQUAL_UINT32(0, r.orderErrors);
+    TEST_ASSERT_EQUAL_UINT32(0, r.gridErrors);
+    TEST_ASSERT_EQUAL_UINT32(0, r.partialBlocks);
+    TEST_ASSERT_EQUAL_UINT32(r.ticks, r.stats.framesAcquired);
+    // Everything but the final incomplete block reached the consumer
+    TEST_ASSERT_LESS_THAN(25, r.ticks - r.received);
+
+    char msg[128];
+    snprintf(msg, sizeof(msg), "%u Hz: %u frames in %u blocks, period %u us",
+             rateHz, r.received, r.stats.blocksDelivered, 1000000U / rateHz);
+    TEST_MESSAGE(msg);
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_stream_250hz() { assertStream(250); }
+void test_stream_360hz() { assertStream(360); }
+void test_stream_500hz() { assertStream(500); }
+
+void test_rate_is_clamped() {
+    MockECGFrontEnd frontEnd;
+    ECGAcquisition engine(frontEnd);
+    ECGAcquisitionConfig config;
+
+    config.sampleRateHz = 20;   // Old readECG() rate
+    engine.begin(config, 0);
+    TEST_ASSERT_EQUAL(250, engine.sampleRateHz());
+    TEST_ASSERT_EQUAL_UINT32(4000, engine.samplePeriodUs());
+
+    config.sampleRateHz = 1000;
+    engine.begin(config, 0);
+    TEST_ASSERT_EQUAL(500, engine.sampleRateHz());
+    TEST_ASSERT_EQUAL_UINT32(2000, engine.samplePeriodUs());
+}
+
+void test_lead_off_sampled_in_same_tick() {
+    MockECGFrontEnd frontEnd;
+    frontEnd.leadOffFrom = 100;
+    frontEnd.leadOffCount = 50;
+    frontEnd.leadOffFlags = ECGLeadOff::PLUS | ECGLeadOff::MINUS;
+    ECGAcquisition engine(frontEnd);
+    ECGAcquisitionConfig config;
+    engine.begin(config, START_US);
+
+    ECGFrame frames[300];
+    for (int i = 0; i < 300; i++) {
+        engine.onTimerTick();
+        engine.service();
+    }
+    TEST_ASSERT_EQUAL(300, engine.read(frames, 300));
+
+    for (int i = 0; i < 300; i++) {
+        bool off = i >= 100 && i < 150;
+        TEST_ASSERT_EQUAL(off ? (ECGLeadOff::PLUS | ECGLeadOff::MINUS) : ECGLeadOff::NONE, frames[i].leadOff);
+        TEST_ASSERT_EQUAL(off ? 0 : MockECGFrontEnd::valueFor(i), frames[i].raw);
+        TEST_ASSERT_EQUAL_UINT32(START_US + i * 4000UL, frames[i].timestampUs);
+    }
+    TEST_ASSERT_EQUAL_UINT32(50, engine.getStats().leadOffFrames);
+}
+
+void test_missed_ticks_keep_the_grid() {
+    MockECGFrontEnd frontEnd;
+    ECGAcquisition engine(frontEnd);
+    ECGAcquisitionConfig config;
+    config.sampleRateHz = 500;
+    engine.begin(config, START_US);
+
+    engine.onTimerTick();
+    engine.service();
+    // Task starved for three ticks
+    engine.onTimerTick();
+    engine.onTimerTick();
+    engine.onTimerTick();
+    TEST_ASSERT_EQUAL_UINT32(3, engine.pendingTickCount());
+    TEST_ASSERT_EQUAL(1, engine.service());
+    TEST_ASSERT_EQUAL(0, engine.service());
+
+    ECGFrame frames[2];
+    TEST_ASSERT_EQUAL(2, engine.read(frames, 2));
+    TEST_ASSERT_EQUAL_UINT32(START_US, frames[0].timestampUs);
+    TEST_ASSERT_EQUAL_UINT32(START_US + 3 * 2000UL, frames[1].timestampUs);
+    TEST_ASSERT_EQUAL_UINT32(2, engine.getStats().missedTicks);
+}
+
+void test_partial_block_is_held_back() {
+    MockECGFrontEnd frontEnd;
+    ECGAcquisition engine(frontEnd);
+    ECGAcquisitionConfig config;
+    config.blockSize = 50;
+    engine.begin(config, 0);
+
+    ECGFrame block[ECGAcquisition::MAX_BLOCK_SIZE];
+    for (int i = 0; i < 49; i++) {
+        engine.onTimerTick();
+        engine.service();
+    }
+    TEST_ASSERT_EQUAL(0, engine.readBlock(block));
+    engine.onTimerTick();
+    engine.service();
+    TEST_ASSERT_EQUAL(50, engine.readBlock(block));
+    TEST_ASSERT_EQUAL(0, engine.available());
+}
+
+void test_ring_drops_when_consumer_starves() {
+    // 500 Hz for 3 s with the consumer asleep: 1500 frames > ring capacity
+    StreamResult r = stream(500, 3000000UL, 5000000UL);
+    TEST_ASSERT_EQUAL_UINT32(r.ticks - ECGFrameRing::CAPACITY, r.stats.ringDrops);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_stream_250hz);
+    RUN_TEST(test_stream_360hz);
+    RUN_TEST(test_stream_500hz);
+    RUN_TEST(test_rate_is_clamped);
+    RUN_TEST(test_lead_off_sampled_in_same_tick);
+    RUN_TEST(test_missed_ticks_keep_the_grid);
+    RUN_TEST(test_partial_block_is_held_back);
+    RUN_TEST(test_ring_drops_when_consumer_starves);
+    return UNITY_END();
+}
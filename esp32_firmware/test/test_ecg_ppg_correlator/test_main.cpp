@@ -0,0 +1,192 @@
+// Host tests for the streaming ECG-PPG cross-correlation
+// Run with: pio test -e native -f test_ecg_ppg_correlator
+
+#include <unity.h>
+#include <stdio.h>
+#include <math.h>
+#include <vector>
+#include "dsp/ecg_ppg_correlator.h"
+#include "../mocks/synthetic_ecg.h"
+#include "../mocks/synthetic_ppg.h"
+
+static const double ECG_RATE = 250;
+static const double PPG_RATE = 200;
+static const size_t PPG_BURST = 16;     // FIFO read every 80 ms
+
+// ECG beats and the pulses they cause, with the steepest part of each
+// upstroke transitSeconds after its R-peak
+struct Recording {
+    SyntheticECG ecg = SyntheticECG(ECG_RATE);
+    SyntheticPPG ppg = SyntheticPPG(PPG_RATE);
+
+    void addBeat(double rPeak, double transitSeconds) {
+        ecg.rPeaks.push_back(rPeak);
+        ppg.onsets.push_back(rPeak + transitSeconds - ppg.riseSeconds / 2);
+    }
+
+    void addBeats(double from, double to, double rrSeconds, double transitSeconds) {
+        static const double pattern[7] = {0.0, 0.8, -0.5, 0.3, -1.0, 0.6, -0.2};
+        int beat = 0;
+        for (double t = from; t < to; t += rrSeconds * (1 + 0.05 * pattern[beat++ % 7])) {
+            addBeat(t, transitSeconds);
+        }
+    }
+};
+
+static uint64_t ecgTimeUs(uint32_t n) { return 1000000ULL + (uint64_t)(n * 1e6 / ECG_RATE + 0.5); }
+static uint64_t ppgTimeUs(uint32_t n) { return 1001300ULL + (uint64_t)(n * 1e6 / PPG_RATE + 0.5); }
+
+// Feeds [from, to) seconds the way the firmware sees it: ECG sample by sample,
+// PPG in FIFO bursts that land after the ECG of the same stretch. PPG is
+// negated so systole rises.
+static void feed(EcgPpgCorrelator& correlator, Recording& recording, double from, double to,
+                 bool withECG = true, bool withPPG = true) {
+    uint32_t ecgNext = (uint32_t)ceil(from * ECG_RATE);
+    uint32_t ppgNext = (uint32_t)ceil(from * PPG_RATE);
+    uint32_t ecgEnd = (uint32_t)ceil(to * ECG_RATE);
+    uint32_t ppgEnd = (uint32_t)ceil(to * PPG_RATE);
+    float values[PPG_BURST];
+    uint64_t times[PPG_BURST];
+    while (ppgNext < ppgEnd || ecgNext < ecgEnd) {
+        size_t count = 0;
+        while (count < PPG_BURST && ppgNext < ppgEnd) {
+            values[count] = (float)-recording.ppg.sample(ppgNext);
+            times[count++] = ppgTimeUs(ppgNext++);
+        }
+        uint64_t burstEndUs = count ? times[count - 1] : ~0ULL;
+        while (ecgNext < ecgEnd && ecgTimeUs(ecgNext) <= burstEndUs) {
+            float value = (float)recording.ecg.sample(ecgNext);
+            if (withECG) correlator.addECG(value, ecgTimeUs(ecgNext));
+            ecgNext++;
+        }
+        if (withPPG) correlator.addPPGBlock(values, times, count);
+    }
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_lag_is_the_transit_to_the_steepest_upstroke() {
+    const double transits[3] = {0.120, 0.230, 0.380};
+    for (double transit : transits) {
+        Recording recording;
+        recording.addBeats(0.3, 20, 0.85, transit);
+        EcgPpgCorrelator correlator;
+        feed(correlator, recording, 0, 12);
+
+        TEST_ASSERT_TRUE(correlator.isReady());
+        CorrelationPeak peak = correlator.getPeak();
+        char line[80];
+        snprintf(line, sizeof(line), "transit %.0f ms: lag %.1f ms, r %.2f", transit * 1e3, peak.lagUs / 1e3,
+                 peak.coefficient);
+        TEST_MESSAGE(line);
+        TEST_ASSERT_TRUE(peak.valid);
+        TEST_ASSERT_FLOAT_WITHIN(5000, transit * 1e6, peak.lagUs);
+        TEST_ASSERT_GREATER_THAN(0.6f, peak.coefficient);
+    }
+}
+
+void test_lag_follows_a_change_in_transit() {
+    Recording recording;
+    recording.addBeats(0.3, 20, 0.9, 0.260);
+    recording.addBeats(20.1, 40, 0.9, 0.190);
+    EcgPpgCorrelator correlator;
+
+    feed(correlator, recording, 0, 19);
+    TEST_ASSERT_FLOAT_WITHIN(5000, 260000, correlator.getPeak().lagUs);
+
+    // A full window after the step, only the new transit is left
+    feed(correlator, recording, 19, 30);
+    TEST_ASSERT_FLOAT_WITHIN(5000, 190000, correlator.getPeak().lagUs);
+}
+
+void test_unrelated_signals_correlate_weakly() {
+    Recording recording;
+    recording.addBeats(0.3, 20, 0.8, 0.2);
+    recording.ppg.onsets.clear();
+    recording.ppg.noiseCounts = 200;
+    EcgPpgCorrelator correlator;
+    feed(correlator, recording, 0, 12);
+
+    TEST_ASSERT_TRUE(correlator.isReady());
+    TEST_ASSERT_LESS_THAN(0.3f, correlator.getPeak().coefficient);
+}
+
+void test_needs_a_full_window() {
+    Recording recording;
+    recording.addBeats(0.3, 20, 0.85, 0.25);
+    EcgPpgCorrelator correlator;
+
+    feed(correlator, recording, 0, 7);
+    TEST_ASSERT_FALSE(correlator.isReady());
+    TEST_ASSERT_FALSE(correlator.getPeak().valid);
+
+    feed(correlator, recording, 7, 10);
+    TEST_ASSERT_TRUE(correlator.isReady());
+}
+
+void test_running_sums_match_a_fresh_window() {
+    // Ten minutes of adding and removing against a correlator that only
+    // ever saw the last stretch: same bins in the window, same answer
+    Recording recording;
+    recording.ecg.noiseCounts = 30;
+    recording.ppg.noiseCounts = 20;
+    recording.addBeats(0.3, 610, 0.8, 0.22);
+    EcgPpgCorrelator longRun;
+    feed(longRun, recording, 0, 600);
+
+    // The noise generators are stateful, so replay the whole run but only
+    // hand the last 12 s to the fresh correlator
+    EcgPpgCorrelator fresh;
+    Recording again;
+    again.ecg.noiseCounts = 30;
+    again.ppg.noiseCounts = 20;
+    again.addBeats(0.3, 610, 0.8, 0.22);
+    feed(fresh, again, 0, 588, false, false);
+    feed(fresh, again, 588, 600);
+
+    TEST_ASSERT_TRUE(fresh.isReady());
+    for (uint32_t lag = EcgPpgCorrelator::MIN_LAG; lag <= EcgPpgCorrelator::MAX_LAG; lag++) {
+        TEST_ASSERT_FLOAT_WITHIN(1e-5f, fresh.coefficientAt(lag), longRun.coefficientAt(lag));
+    }
+}
+
+void test_a_stalled_stream_restarts_the_window() {
+    Recording recording;
+    recording.addBeats(0.3, 40, 0.85, 0.24);
+    EcgPpgCorrelator correlator;
+    feed(correlator, recording, 0, 12);
+    TEST_ASSERT_TRUE(correlator.isReady());
+
+    // Leads off: the PPG runs on alone
+    feed(correlator, recording, 12, 16, false, true);
+    TEST_ASSERT_FALSE(correlator.isReady());
+
+    // Back on: a fresh window, lined up again
+    feed(correlator, recording, 16, 30);
+    TEST_ASSERT_TRUE(correlator.isReady());
+    TEST_ASSERT_FLOAT_WITHIN(5000, 240000, correlator.getPeak().lagUs);
+}
+
+void test_reset_clears_the_window() {
+    Recording recording;
+    recording.addBeats(0.3, 20, 0.85, 0.25);
+    EcgPpgCorrelator correlator;
+    feed(correlator, recording, 0, 12);
+    correlator.reset();
+    TEST_ASSERT_FALSE(correlator.isReady());
+    TEST_ASSERT_EQUAL_FLOAT(0.0f, correlator.getPeak().coefficient);
+    TEST_ASSERT_EQUAL_FLOAT(0.0f, correlator.coefficientAt(10));
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_lag_is_the_transit_to_the_steepest_upstroke);
+    RUN_TEST(test_lag_follows_a_change_in_transit);
+    RUN_TEST(test_unrelated_signals_correlate_weakly);
+    RUN_TEST(test_needs_a_full_window);
+    RUN_TEST(test_running_sums_match_a_fresh_window);
+    RUN_TEST(test_a_stalled_stream_restarts_the_window);
+    RUN_TEST(test_reset_clears_the_window);
+    return UNITY_END();
+}
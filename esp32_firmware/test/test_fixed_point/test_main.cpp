@@ -0,0 +1,240 @@
+// Host tests for the fixed-point DSP back end
+// Run with: pio test -e native -f test_fixed_point
+
+#include <unity.h>
+#include <stdio.h>
+#include <math.h>
+#include <random>
+#include <vector>
+#include "dsp/fixed_point.h"
+#include "dsp/pipeline.h"
+#include "dsp/bandpass_designs.h"
+#include "dsp/ecg_ppg_correlator.h"
+#include "../mocks/synthetic_ecg.h"
+#include "../mocks/synthetic_ppg.h"
+
+static const uint32_t ECG_RATE = 250;
+static const uint32_t PPG_RATE = 200;
+
+typedef BasicEcgPpgCorrelator<FloatPrecision> FloatCorrelator;
+typedef BasicEcgPpgCorrelator<FixedPrecision> FixedCorrelator;
+
+void setUp() {}
+void tearDown() {}
+
+void test_isqrt_is_the_floor_of_the_root() {
+    const uint64_t edges[] = {0, 1, 2, 3, 4, 15, 16, 17, 0xFFFFFFFFULL, 1ULL << 62, ~0ULL};
+    for (uint64_t value : edges) {
+        uint64_t root = isqrt64(value);
+        TEST_ASSERT_TRUE(root * root <= value);
+        TEST_ASSERT_TRUE((root + 1) * (root + 1) > value || root == 0xFFFFFFFFULL);
+    }
+    std::mt19937_64 random(7);
+    for (int i = 0; i < 100000; i++) {
+        uint64_t value = random() >> (random() % 64);
+        uint64_t root = isqrt64(value);
+        TEST_ASSERT_TRUE(root * root <= value);
+        TEST_ASSERT_TRUE(root == 0xFFFFFFFFULL || (root + 1) * (root + 1) > value);
+    }
+}
+
+void test_correlation_matches_double() {
+    // Random windows of 400 features below 2^20, including near-flat and
+    // near-perfectly correlated pairs
+    std::mt19937 random(11);
+    for (int trial = 0; trial < 500; trial++) {
+        int32_t range = 1 + (int32_t)(random() % (1 << 20));
+        double mix = (trial % 5) / 4.0;
+        int64_t sumX = 0, sumXX = 0, sumY = 0, sumYY = 0, sumXY = 0;
+        double dx = 0, dxx = 0, dy = 0, dyy = 0, dxy = 0;
+        for (int n = 0; n < 400; n++) {
+            int32_t x = (int32_t)(random() % range);
+            int32_t y = (int32_t)(mix * x + (1 - mix) * (random() % range));
+            sumX += x;
+            sumXX += (int64_t)x * x;
+            sumY += y;
+            sumYY += (int64_t)y * y;
+            sumXY += (int64_t)x * y;
+            dx += x;
+            dxx += (double)x * x;
+            dy += y;
+            dyy += (double)y * y;
+            dxy += (double)x * y;
+        }
+        double vx = 400 * dxx - dx * dx;
+        double vy = 400 * dyy - dy * dy;
+        double r = vx > 0 && vy > 0 ? (400 * dxy - dx * dy) / sqrt(vx * vy) : 0;
+        int16_t q = correlationQ15(400, sumX, sumXX, sumY, sumYY, sumXY);
+        TEST_ASSERT_FLOAT_WITHIN(2.0f / 32768, (float)r, q / 32768.0f);
+    }
+    // Flat on either side
+    TEST_ASSERT_EQUAL_INT16(0, correlationQ15(4, 8, 16, 10, 30, 20));
+    TEST_ASSERT_EQUAL_INT16(0, correlationQ15(1, 3, 9, 2, 4, 6));
+    // Perfectly anti-correlated: x = 0,1,2,3 and y = 3,2,1,0
+    TEST_ASSERT_EQUAL_INT16(-32767, correlationQ15(4, 6, 14, 6, 14, 4));
+}
+
+void test_unrolled_lag_sums_match_the_reference() {
+    std::mt19937 random(3);
+    for (size_t count = 0; count <= 27; count++) {
+        std::vector<int32_t> x(count);
+        std::vector<int64_t> a(3 * count, 0), b(3 * count, 0);
+        for (int pass = 0; pass < 200; pass++) {
+            for (size_t j = 0; j < count; j++) x[j] = (int32_t)(random() % (1 << 20));
+            int32_t y = pass == 0 ? (1 << 20) - 1 : (int32_t)(random() % (1 << 20));
+            if (pass % 3 == 2) {
+                lagSumsReference<true>(x.data(), y, &a[0], &a[count], &a[2 * count], count);
+                lagSumsUnrolled<true>(x.data(), y, &b[0], &b[count], &b[2 * count], count);
+            } else {
+                lagSumsReference<false>(x.data(), y, &a[0], &a[count], &a[2 * count], count);
+                lagSumsUnrolled<false>(x.data(), y, &b[0], &b[count], &b[2 * count], count);
+            }
+        }
+        for (size_t k = 0; k < 3 * count; k++) {
+            TEST_ASSERT_TRUE(a[k] == b[k]);
+        }
+    }
+}
+
+void test_q15_block_filter_matches_per_sample() {
+    typedef ECGBandpass<ECG_RATE> Design;
+    SyntheticECG heart(ECG_RATE);
+    heart.noiseCounts = 30;
+    for (double t = 0.5; t < 20; t += 0.8) heart.rPeaks.push_back(t);
+    std::vector<int16_t> input;
+    for (uint32_t n = 0; n < 20 * ECG_RATE; n++) input.push_back(toQ15(2048.0f + (float)heart.sample(n), 3));
+
+    BiquadCascadeQ15<Design::SECTIONS> single(Design::coeffsQ14);
+    BiquadCascadeQ15<Design::SECTIONS> blocks(Design::coeffsQ14);
+    single.prime(input[0]);
+    blocks.prime(input[0]);
+    std::vector<int16_t> output(input.size());
+    const size_t sizes[] = {1, 7, 32, 25, 128};
+    size_t start = 0;
+    for (size_t k = 0; start < input.size(); k++) {
+        size_t n = sizes[k % 5] < input.size() - start ? sizes[k % 5] : input.size() - start;
+        blocks.processBlock(&input[start], &output[start], n);
+        start += n;
+    }
+    for (size_t n = 0; n < input.size(); n++) {
+        TEST_ASSERT_EQUAL_INT16(single.process(input[n]), output[n]);
+    }
+}
+
+// Both back ends give the same ECG up to the 14-bit coefficients, which
+// nudge the 0.5 Hz corner (see test_biquad)
+void test_fixed_bandpass_stage_tracks_float() {
+    typedef ECGBandpass<ECG_RATE> Design;
+    Pipeline<BandpassStage<Design, 3, FloatPrecision> > floating;
+    Pipeline<BandpassStage<Design, 3, FixedPrecision> > fixed;
+    SyntheticECG heart(ECG_RATE);
+    heart.noiseCounts = 20;
+    for (double t = 0.5; t < 30; t += 0.8) heart.rPeaks.push_back(t);
+
+    double signal = 0, error = 0;
+    float a[25], b[25];
+    uint64_t times[25];
+    for (uint32_t first = 0; first < 30 * ECG_RATE; first += 25) {
+        for (uint32_t i = 0; i < 25; i++) {
+            a[i] = b[i] = 2048.0f + (float)heart.sample(first + i);
+            times[i] = (uint64_t)(first + i) * 1000000 / ECG_RATE;
+        }
+        SampleBlock blockA = {a, times, 25};
+        SampleBlock blockB = {b, times, 25};
+        floating.process(blockA);
+        fixed.process(blockB);
+        if (first < 2 * ECG_RATE) continue;     // Past the settling
+        for (uint32_t i = 0; i < 25; i++) {
+            signal += (double)a[i] * a[i];
+            error += (double)(a[i] - b[i]) * (a[i] - b[i]);
+        }
+    }
+    double snr = 10 * log10(signal / error);
+    char line[80];
+    snprintf(line, sizeof(line), "ECG band-pass, Q15 against float: %.1f dB", snr);
+    TEST_MESSAGE(line);
+    TEST_ASSERT_TRUE(snr > 35);
+}
+
+// ECG sample by sample and PPG in 16-sample bursts, the PPG 220 ms behind
+template <typename Correlator>
+static void feed(Correlator& correlator, double seconds, uint32_t seed) {
+    SyntheticECG heart(ECG_RATE);
+    SyntheticPPG finger(PPG_RATE);
+    heart.noiseCounts = 30;
+    finger.noiseCounts = 20;
+    finger.noiseSeed = seed;
+    for (double t = 0.3; t < seconds + 1; t += 0.82) {
+        heart.rPeaks.push_back(t);
+        finger.onsets.push_back(t + 0.22 - finger.riseSeconds / 2);
+    }
+    uint32_t ecgNext = 0;
+    float values[16];
+    uint64_t times[16];
+    for (uint32_t first = 0; first < seconds * PPG_RATE; first += 16) {
+        for (uint32_t i = 0; i < 16; i++) {
+            values[i] = (float)-finger.sample(first + i);
+            times[i] = SyntheticPPG::timeUs(first + i, PPG_RATE);
+        }
+        while ((uint64_t)ecgNext * 1000000 / ECG_RATE <= times[15] - 1000000) {
+            correlator.addECG((float)heart.sample(ecgNext), 1000000 + (uint64_t)ecgNext * 1000000 / ECG_RATE);
+            ecgNext++;
+        }
+        correlator.addPPGBlock(values, times, 16);
+    }
+}
+
+void test_fixed_correlator_agrees_with_float() {
+    static FloatCorrelator floating;
+    static FixedCorrelator fixed;
+    feed(floating, 30, 5);
+    feed(fixed, 30, 5);
+    TEST_ASSERT_TRUE(fixed.isReady());
+
+    CorrelationPeak a = floating.getPeak();
+    CorrelationPeak b = fixed.getPeak();
+    char line[96];
+    snprintf(line, sizeof(line), "float lag %.2f ms r %.4f, fixed lag %.2f ms r %.4f", a.lagUs / 1e3, a.coefficient,
+             b.lagUs / 1e3, b.coefficient);
+    TEST_MESSAGE(line);
+    TEST_ASSERT_FLOAT_WITHIN(5000, 220000, b.lagUs);
+    TEST_ASSERT_FLOAT_WITHIN(500, a.lagUs, b.lagUs);
+    for (uint32_t lag = FixedCorrelator::MIN_LAG; lag <= FixedCorrelator::MAX_LAG; lag++) {
+        TEST_ASSERT_FLOAT_WITHIN(0.005f, floating.coefficientAt(lag), fixed.coefficientAt(lag));
+    }
+}
+
+void test_fixed_sums_are_exact_after_a_long_run() {
+    // Integer sums add and remove without rounding, so ten minutes of
+    // sliding leave exactly what a correlator fed only the last window holds
+    static FixedCorrelator longRun;
+    static FixedCorrelator fresh;
+    feed(longRun, 600, 9);
+    // Same stream, but the fresh one only sees the last 12 s
+    struct Tail {
+        FixedCorrelator& target;
+        void addECG(float value, uint64_t us) {
+            if (us >= 589000000ULL) target.addECG(value, us);
+        }
+        void addPPGBlock(const float* values, const uint64_t* us, size_t count) {
+            if (us[0] >= 589000000ULL) target.addPPGBlock(values, us, count);
+        }
+    } tail = {fresh};
+    feed(tail, 600, 9);
+    TEST_ASSERT_TRUE(fresh.isReady());
+    for (uint32_t lag = FixedCorrelator::MIN_LAG; lag <= FixedCorrelator::MAX_LAG; lag++) {
+        TEST_ASSERT_EQUAL_FLOAT(fresh.coefficientAt(lag), longRun.coefficientAt(lag));
+    }
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_isqrt_is_the_floor_of_the_root);
+    RUN_TEST(test_correlation_matches_double);
+    RUN_TEST(test_unrolled_lag_sums_match_the_reference);
+    RUN_TEST(test_q15_block_filter_matches_per_sample);
+    RUN_TEST(test_fixed_bandpass_stage_tracks_float);
+    RUN_TEST(test_fixed_correlator_agrees_with_float);
+    RUN_TEST(test_fixed_sums_are_exact_after_a_long_run);
+    return UNITY_END();
+}
@@ -0,0 +1,177 @@
+// Accuracy and throughput of the fixed-point back end against float
+// Run with: pio test -e native -f test_fixed_point_bench -v   (-v shows the numbers)
+//
+// The host has a double-precision FPU, so the speed ratios here understate
+// the target's, where double runs in software; the accuracy figures carry over.
+
+#include <unity.h>
+#include <stdio.h>
+#include <math.h>
+#include <random>
+#include <vector>
+#include "dsp/fixed_point.h"
+#include "dsp/pipeline.h"
+#include "dsp/bandpass_designs.h"
+#include "dsp/ecg_ppg_correlator.h"
+#include "../mocks/synthetic_ecg.h"
+#include "../mocks/synthetic_ppg.h"
+#include "../mocks/bench_util.h"
+
+static const uint32_t ECG_RATE = 250;
+static const uint32_t PPG_RATE = 200;
+static const double SECONDS = 600;
+
+static std::vector<float> ecg;
+static std::vector<float> ppg;
+static std::vector<uint64_t> ecgTimes;
+static std::vector<uint64_t> ppgTimes;
+
+// Ten minutes of each, the PPG systole-up and 230 ms behind the R-peaks
+void setUp() {
+    if (!ecg.empty()) return;
+    SyntheticECG heart(ECG_RATE);
+    SyntheticPPG finger(PPG_RATE);
+    heart.noiseCounts = 20;
+    finger.noiseCounts = 40;
+    for (double t = 0.5; t < SECONDS + 1; t += 0.8) {
+        heart.rPeaks.push_back(t);
+        finger.onsets.push_back(t + 0.23 - finger.riseSeconds / 2);
+    }
+    for (uint32_t n = 0; n < SECONDS * ECG_RATE; n++) {
+        ecg.push_back(2048.0f + (float)heart.sample(n));
+        ecgTimes.push_back(1000000 + (uint64_t)n * 1000000 / ECG_RATE);
+    }
+    for (uint32_t n = 0; n < SECONDS * PPG_RATE; n++) {
+        ppg.push_back(-(float)finger.sample(n));
+        ppgTimes.push_back(SyntheticPPG::timeUs(n, PPG_RATE));
+    }
+}
+void tearDown() {}
+
+// Runs a record through a band-pass stage in blocks; returns the seconds taken
+template <typename Stage>
+static double filter(Stage& stage, const std::vector<float>& input, std::vector<uint64_t>& times, size_t blockSize,
+                     std::vector<float>& output) {
+    output = input;
+    BenchTimer timer;
+    for (size_t first = 0; first < output.size(); first += blockSize) {
+        size_t n = output.size() - first < blockSize ? output.size() - first : blockSize;
+        SampleBlock block = {&output[first], &times[first], n};
+        stage.process(block);
+    }
+    return timer.seconds();
+}
+
+static double signalToErrorDb(const std::vector<float>& reference, const std::vector<float>& other, size_t skip) {
+    double signal = 0, error = 0;
+    for (size_t n = skip; n < reference.size(); n++) {
+        signal += (double)reference[n] * reference[n];
+        error += (double)(reference[n] - other[n]) * (reference[n] - other[n]);
+    }
+    return 10 * log10(signal / error);
+}
+
+void test_bandpass() {
+    typedef ECGBandpass<ECG_RATE> ECGDesign;
+    typedef PPGBandpass<PPG_RATE> PPGDesign;
+    static Pipeline<BandpassStage<ECGDesign, 3, FloatPrecision> > ecgFloat;
+    static Pipeline<BandpassStage<ECGDesign, 3, FixedPrecision> > ecgFixed;
+    static Pipeline<BandpassStage<PPGDesign, -4, FloatPrecision> > ppgFloat;
+    static Pipeline<BandpassStage<PPGDesign, -4, FixedPrecision> > ppgFixed;
+    std::vector<float> a, b;
+
+    double floatSeconds = filter(ecgFloat, ecg, ecgTimes, 25, a);
+    double fixedSeconds = filter(ecgFixed, ecg, ecgTimes, 25, b);
+    double ecgDb = signalToErrorDb(a, b, 2 * ECG_RATE);
+    benchReport("ECG band-pass, float", ecg.size(), floatSeconds);
+    benchReport("ECG band-pass, Q15", ecg.size(), fixedSeconds);
+
+    floatSeconds = filter(ppgFloat, ppg, ppgTimes, 32, a);
+    fixedSeconds = filter(ppgFixed, ppg, ppgTimes, 32, b);
+    double ppgDb = signalToErrorDb(a, b, 2 * PPG_RATE);
+    benchReport("PPG band-pass, float", ppg.size(), floatSeconds);
+    benchReport("PPG band-pass, Q15", ppg.size(), fixedSeconds);
+    benchSink = b.back();
+
+    char line[96];
+    snprintf(line, sizeof(line), "Q15 against float: ECG %.1f dB, PPG %.1f dB", ecgDb, ppgDb);
+    TEST_MESSAGE(line);
+    TEST_ASSERT_GREATER_THAN(30.0, ecgDb);
+    TEST_ASSERT_GREATER_THAN(30.0, ppgDb);
+}
+
+// ECG sample by sample, PPG in 16-sample FIFO bursts; returns the seconds taken
+template <typename Correlator>
+static double correlate(Correlator& correlator) {
+    size_t ecgNext = 0;
+    BenchTimer timer;
+    for (size_t first = 0; first < ppg.size(); first += 16) {
+        size_t n = ppg.size() - first < 16 ? ppg.size() - first : 16;
+        while (ecgNext < ecg.size() && ecgTimes[ecgNext] <= ppgTimes[first + n - 1]) {
+            correlator.addECG(ecg[ecgNext], ecgTimes[ecgNext]);
+            ecgNext++;
+        }
+        correlator.addPPGBlock(&ppg[first], &ppgTimes[first], n);
+    }
+    return timer.seconds();
+}
+
+void test_correlator() {
+    static BasicEcgPpgCorrelator<FloatPrecision> floating;
+    static BasicEcgPpgCorrelator<FixedPrecision> fixed;
+    double floatSeconds = correlate(floating);
+    double fixedSeconds = correlate(fixed);
+    size_t samples = ecg.size() + ppg.size();
+    benchReport("ECG/PPG correlator, double sums", samples, floatSeconds);
+    benchReport("ECG/PPG correlator, int64 sums", samples, fixedSeconds);
+
+    float worst = 0;
+    for (uint32_t lag = EcgPpgCorrelator::MIN_LAG; lag <= EcgPpgCorrelator::MAX_LAG; lag++) {
+        float difference = fabsf(floating.coefficientAt(lag) - fixed.coefficientAt(lag));
+        if (difference > worst) worst = difference;
+    }
+    CorrelationPeak a = floating.getPeak();
+    CorrelationPeak b = fixed.getPeak();
+    char line[128];
+    snprintf(line, sizeof(line), "lag float %.2f ms, fixed %.2f ms; worst r difference %.5f", a.lagUs / 1e3,
+             b.lagUs / 1e3, worst);
+    TEST_MESSAGE(line);
+    TEST_ASSERT_FLOAT_WITHIN(500, a.lagUs, b.lagUs);
+    TEST_ASSERT_TRUE(worst < 0.005f);
+}
+
+void test_lag_sum_kernels() {
+    static const size_t LAGS = EcgPpgCorrelator::LAGS;
+    static const size_t PASSES = 400000;
+    std::mt19937 random(1);
+    std::vector<int32_t> x(LAGS + 64);
+    for (size_t j = 0; j < x.size(); j++) x[j] = (int32_t)(random() % (1 << 20));
+    int64_t sums[3][LAGS] = {};
+
+    BenchTimer timer;
+    for (size_t pass = 0; pass < PASSES; pass++) {
+        lagSumsReference<false>(&x[pass & 63], x[pass & 31], sums[0], sums[1], sums[2], LAGS);
+    }
+    double reference = timer.seconds();
+    int64_t check = sums[2][LAGS - 1];
+
+    int64_t unrolledSums[3][LAGS] = {};
+    timer.restart();
+    for (size_t pass = 0; pass < PASSES; pass++) {
+        lagSumsUnrolled<false>(&x[pass & 63], x[pass & 31], unrolledSums[0], unrolledSums[1], unrolledSums[2], LAGS);
+    }
+    double unrolled = timer.seconds();
+    benchSink = (float)unrolledSums[2][0];
+
+    benchReport("25-lag sums, reference (per bin)", PASSES, reference);
+    benchReport("25-lag sums, unrolled (per bin)", PASSES, unrolled);
+    TEST_ASSERT_TRUE(check == unrolledSums[2][LAGS - 1]);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_bandpass);
+    RUN_TEST(test_correlator);
+    RUN_TEST(test_lag_sum_kernels);
+    return UNITY_END();
+}
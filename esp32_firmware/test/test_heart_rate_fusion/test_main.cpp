@@ -0,0 +1,80 @@
+// Host tests for fusing ECG and PPG heart-rate estimates
+// Run with: pio test -e native -f test_heart_rate_fusion
+
+#include <unity.h>
+#include "dsp/heart_rate_fusion.h"
+
+static const uint64_t NOW_US = 100000000;
+
+void setUp() {}
+void tearDown() {}
+
+void test_nothing_reported_is_invalid() {
+    HeartRateFusion fusion;
+    FusedHeartRate fused = fusion.fuse(NOW_US);
+    TEST_ASSERT_FALSE(fused.valid);
+    TEST_ASSERT_EQUAL_UINT8(0, fused.sources);
+}
+
+void test_agreeing_sources_are_weighted_by_confidence() {
+    HeartRateFusion fusion;
+    fusion.update(HR_SOURCE_ECG, 72, 0.9f, NOW_US);
+    fusion.update(HR_SOURCE_PPG_SPECTRAL, 75, 0.6f, NOW_US - 500000);
+    fusion.update(HR_SOURCE_PPG_MAXIM, 78, 0.3f, NOW_US - 1000000);
+
+    FusedHeartRate fused = fusion.fuse(NOW_US);
+    TEST_ASSERT_TRUE(fused.valid);
+    TEST_ASSERT_FLOAT_WITHIN(1e-3, (0.9f * 72 + 0.6f * 75 + 0.3f * 78) / 1.8f, fused.bpm);
+    TEST_ASSERT_FLOAT_WITHIN(1e-6, 0.9f, fused.confidence);
+    TEST_ASSERT_EQUAL_UINT8(0x07, fused.sources);
+}
+
+void test_a_doubled_rate_is_left_out() {
+    // Maxim's peak counting can lock onto the dicrotic wave
+    HeartRateFusion fusion;
+    fusion.update(HR_SOURCE_ECG, 64, 0.9f, NOW_US);
+    fusion.update(HR_SOURCE_PPG_SPECTRAL, 65, 0.5f, NOW_US);
+    fusion.update(HR_SOURCE_PPG_MAXIM, 128, 0.5f, NOW_US);
+
+    FusedHeartRate fused = fusion.fuse(NOW_US);
+    TEST_ASSERT_FLOAT_WITHIN(1.0, 64.4, fused.bpm);
+    TEST_ASSERT_EQUAL_UINT8((1 << HR_SOURCE_ECG) | (1 << HR_SOURCE_PPG_SPECTRAL), fused.sources);
+}
+
+void test_stale_and_invalidated_sources_drop_out() {
+    HeartRateFusion fusion(5000);
+    fusion.update(HR_SOURCE_ECG, 90, 0.9f, NOW_US - 6000000);        // Leads came off 6 s ago
+    fusion.update(HR_SOURCE_PPG_SPECTRAL, 70, 0.5f, NOW_US - 1000000);
+    FusedHeartRate fused = fusion.fuse(NOW_US);
+    TEST_ASSERT_FLOAT_WITHIN(1e-4, 70, fused.bpm);
+    TEST_ASSERT_EQUAL_UINT8(1 << HR_SOURCE_PPG_SPECTRAL, fused.sources);
+
+    fusion.invalidate(HR_SOURCE_PPG_SPECTRAL);
+    TEST_ASSERT_FALSE(fusion.fuse(NOW_US).valid);
+}
+
+void test_implausible_rates_are_not_accepted() {
+    HeartRateFusion fusion;
+    fusion.update(HR_SOURCE_PPG_MAXIM, 250, 0.5f, NOW_US);
+    fusion.update(HR_SOURCE_PPG_SPECTRAL, 20, 0.5f, NOW_US);
+    fusion.update(HR_SOURCE_ECG, 80, 0, NOW_US);
+    TEST_ASSERT_FALSE(fusion.fuse(NOW_US).valid);
+    TEST_ASSERT_FALSE(fusion.getSource(HR_SOURCE_PPG_MAXIM).valid);
+}
+
+void test_source_names() {
+    TEST_ASSERT_EQUAL_STRING("ecg", heartRateSourceName(HR_SOURCE_ECG));
+    TEST_ASSERT_EQUAL_STRING("ppg_spectral", heartRateSourceName(HR_SOURCE_PPG_SPECTRAL));
+    TEST_ASSERT_EQUAL_STRING("ppg_maxim", heartRateSourceName(HR_SOURCE_PPG_MAXIM));
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_nothing_reported_is_invalid);
+    RUN_TEST(test_agreeing_sources_are_weighted_by_confidence);
+    RUN_TEST(test_a_doubled_rate_is_left_out);
+    RUN_TEST(test_stale_and_invalidated_sources_drop_out);
+    RUN_TEST(test_implausible_rates_are_not_accepted);
+    RUN_TEST(test_source_names);
+    return UNITY_END();
+}
@@ -0,0 +1,229 @@
+// Host tests for the incremental HRV engine
+// Run with: pio test -e native -f test_hrv_engine
+
+#include <unity.h>
+#include <stdio.h>
+#include <math.h>
+#include <vector>
+#include "dsp/hrv_engine.h"
+
+static const uint64_t START_US = 5000000;
+
+// Feeds R-peaks so that consecutive beats are rrUs[i] apart
+static uint64_t feedIntervals(HrvEngine& engine, const std::vector<uint32_t>& rrUs, uint64_t startUs = START_US) {
+    uint64_t t = startUs;
+    engine.addBeat(t);
+    for (uint32_t rr : rrUs) {
+        t += rr;
+        engine.addBeat(t);
+    }
+    return t;
+}
+
+// RR of a 850 ms rhythm modulated at 0.1 Hz (LF) and 0.25 Hz (HF)
+static std::vector<uint32_t> modulatedRhythm(double seconds, double lfMs, double hfMs, std::vector<double>* beatTimes = nullptr) {
+    std::vector<uint32_t> rr;
+    double t = 0;
+    while (t < seconds) {
+        double interval = 850 + lfMs * sin(2 * M_PI * 0.1 * t) + hfMs * sin(2 * M_PI * 0.25 * t);
+        t += interval / 1000.0;
+        rr.push_back((uint32_t)lround(interval * 1000));
+        if (beatTimes) beatTimes->push_back(t);
+    }
+    return rr;
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_time_domain_matches_direct_computation() {
+    // Stays within 20% of each neighbour, so every interval is accepted
+    std::vector<uint32_t> rr;
+    uint32_t seed = 99;
+    for (int i = 0; i < 300; i++) {
+        seed = seed * 1664525u + 1013904223u;
+        rr.push_back(800000 + (seed >> 8) % 120000);
+    }
+    HrvEngine engine;
+    feedIntervals(engine, rr);
+
+    // The newest WINDOW intervals and the differences between them
+    size_t first = rr.size() - HrvEngine::WINDOW;
+    double sum = 0, sum2 = 0, diff2 = 0;
+    int nn50 = 0;
+    for (size_t i = first; i < rr.size(); i++) {
+        sum += rr[i] / 1000.0;
+        if (i > first) {
+            double d = ((double)rr[i] - rr[i - 1]) / 1000.0;
+            diff2 += d * d;
+            if (fabs(d) > 50) nn50++;
+        }
+    }
+    double n = HrvEngine::WINDOW;
+    double mean = sum / n;
+    for (size_t i = first; i < rr.size(); i++) {
+        double d = rr[i] / 1000.0 - mean;
+        sum2 += d * d;
+    }
+
+    const HrvMetrics& m = engine.getMetrics();
+    TEST_ASSERT_EQUAL_UINT32(HrvEngine::WINDOW, m.intervals);
+    TEST_ASSERT_EQUAL_UINT32(0, engine.getRejectedCount());
+    TEST_ASSERT_FLOAT_WITHIN(1e-3, mean, m.meanRRMs);
+    TEST_ASSERT_FLOAT_WITHIN(1e-3, sqrt(sum2 / (n - 1)), m.sdnnMs);
+    TEST_ASSERT_FLOAT_WITHIN(1e-3, sqrt(diff2 / (n - 1)), m.rmssdMs);
+    TEST_ASSERT_FLOAT_WITHIN(1e-3, 100.0 * nn50 / (n - 1), m.pnn50);
+}
+
+void test_no_difference_across_the_ring_wrap() {
+    // A slow ramp: every successive difference is 1 ms, including where the
+    // window's storage wraps (the old buffer saw a ~127 ms jump there)
+    std::vector<uint32_t> rr;
+    for (int i = 0; i < 200; i++) rr.push_back(700000 + i * 1000);
+    HrvEngine engine;
+    feedIntervals(engine, rr);
+
+    TEST_ASSERT_FLOAT_WITHIN(1e-4, 1.0, engine.getMetrics().rmssdMs);
+    TEST_ASSERT_FLOAT_WITHIN(1e-4, 0.0, engine.getMetrics().pnn50);
+}
+
+void test_ectopic_beat_is_left_out() {
+    // A premature beat and its compensatory pause in a steady 800 ms rhythm
+    std::vector<uint32_t> rr(40, 800000);
+    rr[20] = 500000;
+    rr[21] = 1100000;
+    HrvEngine engine;
+    feedIntervals(engine, rr);
+
+    const HrvMetrics& m = engine.getMetrics();
+    TEST_ASSERT_EQUAL_UINT32(2, engine.getRejectedCount());
+    TEST_ASSERT_EQUAL_UINT32(38, m.intervals);
+    TEST_ASSERT_FLOAT_WITHIN(1e-4, 0.0, m.rmssdMs);
+    TEST_ASSERT_FLOAT_WITHIN(1e-4, 800.0, m.meanRRMs);
+}
+
+void test_a_real_rate_change_is_followed() {
+    std::vector<uint32_t> rr(20, 1000000);
+    for (int i = 0; i < 20; i++) rr.push_back(700000);
+    HrvEngine engine;
+    feedIntervals(engine, rr);
+
+    // Three rejected, then the new rate is taken up with no difference across the step
+    TEST_ASSERT_EQUAL_UINT32(3, engine.getRejectedCount());
+    TEST_ASSERT_EQUAL_UINT32(37, engine.getMetrics().intervals);
+    TEST_ASSERT_FLOAT_WITHIN(1e-4, 0.0, engine.getMetrics().rmssdMs);
+}
+
+void test_lost_beats_break_the_chain() {
+    HrvEngine engine;
+    std::vector<uint32_t> rr(10, 800000);
+    uint64_t t = feedIntervals(engine, rr);
+    // Leads off for five seconds, then back at a different rate
+    std::vector<uint32_t> after(10, 900000);
+    feedIntervals(engine, after, t + 5000000);
+
+    TEST_ASSERT_EQUAL_UINT32(20, engine.getMetrics().intervals);
+    TEST_ASSERT_FLOAT_WITHIN(1e-4, 0.0, engine.getMetrics().rmssdMs);
+    TEST_ASSERT_FLOAT_WITHIN(1e-3, 850.0, engine.getMetrics().meanRRMs);
+}
+
+void test_lf_and_hf_power_of_known_modulation() {
+    // Sinusoids of 30 and 15 ms carry 450 and 112.5 ms^2
+    HrvEngine engine(0);
+    feedIntervals(engine, modulatedRhythm(200, 30, 15));
+
+    const HrvMetrics& m = engine.getMetrics();
+    char line[96];
+    snprintf(line, sizeof(line), "LF %.1f ms^2, HF %.1f ms^2, LF/HF %.2f", m.lfPower, m.hfPower, m.lfHfRatio);
+    TEST_MESSAGE(line);
+    TEST_ASSERT_TRUE(m.spectrumValid);
+    TEST_ASSERT_FLOAT_WITHIN(0.15 * 450, 450, m.lfPower);
+    TEST_ASSERT_FLOAT_WITHIN(0.15 * 112.5, 112.5, m.hfPower);
+    TEST_ASSERT_FLOAT_WITHIN(0.6, 4.0, m.lfHfRatio);
+
+    // The periodogram peaks at the two modulation frequencies (bins 25.6 and 64)
+    uint32_t lfPeak = HrvEngine::FIRST_BIN, hfPeak = HrvEngine::LF_HF_BIN;
+    for (uint32_t k = HrvEngine::FIRST_BIN; k <= HrvEngine::LAST_BIN; k++) {
+        if (k < HrvEngine::LF_HF_BIN && engine.spectrumAt(k) > engine.spectrumAt(lfPeak)) lfPeak = k;
+        if (k >= HrvEngine::LF_HF_BIN && engine.spectrumAt(k) > engine.spectrumAt(hfPeak)) hfPeak = k;
+    }
+    TEST_ASSERT_INT_WITHIN(1, 26, lfPeak);
+    TEST_ASSERT_INT_WITHIN(1, 64, hfPeak);
+}
+
+void test_incremental_periodogram_matches_direct_lomb_scargle() {
+    std::vector<double> beatTimes;
+    std::vector<uint32_t> rr = modulatedRhythm(400, 25, 20, &beatTimes);
+    HrvEngine engine(0);
+    feedIntervals(engine, rr, 0);
+
+    // Textbook Lomb-Scargle over the window, with tau from the arctangent
+    size_t first = rr.size() - HrvEngine::WINDOW;
+    std::vector<double> t, y;
+    double mean = 0;
+    for (size_t i = first; i < rr.size(); i++) {
+        t.push_back((double)(uint64_t)llround(beatTimes[i] * 1e6) / 1e6);
+        y.push_back(rr[i] / 1000.0);
+        mean += rr[i] / 1000.0;
+    }
+    mean /= t.size();
+    double span = t.back() - t.front();
+    for (uint32_t k = HrvEngine::FIRST_BIN; k <= HrvEngine::LAST_BIN; k++) {
+        double w = 2 * M_PI * k / (double)HrvEngine::SPECTRUM_PERIOD_S;
+        double s2 = 0, c2 = 0;
+        for (double ti : t) {
+            s2 += sin(2 * w * ti);
+            c2 += cos(2 * w * ti);
+        }
+        double tau = atan2(s2, c2) / (2 * w);
+        double yc = 0, ys = 0, cc = 0, ss = 0;
+        for (size_t i = 0; i < t.size(); i++) {
+            double c = cos(w * (t[i] - tau)), s = sin(w * (t[i] - tau));
+            yc += (y[i] - mean) * c;
+            ys += (y[i] - mean) * s;
+            cc += c * c;
+            ss += s * s;
+        }
+        double expected = 0.5 * (yc * yc / cc + ys * ys / ss) * 2.0 * span / t.size();
+        TEST_ASSERT_FLOAT_WITHIN(1e-4 * expected + 1e-3, expected, engine.spectrumAt(k));
+    }
+}
+
+void test_spectrum_waits_for_enough_data_and_its_interval() {
+    HrvEngine engine(10000);
+    std::vector<uint32_t> rr = modulatedRhythm(50, 30, 15);
+    uint64_t t = feedIntervals(engine, rr);
+    TEST_ASSERT_FALSE(engine.getMetrics().spectrumValid);
+
+    // Valid once a minute is covered, then only refreshed every 10 s
+    t = feedIntervals(engine, modulatedRhythm(30, 30, 15), t);
+    TEST_ASSERT_TRUE(engine.getMetrics().spectrumValid);
+    float lf = engine.getMetrics().lfPower;
+    engine.addBeat(t + 850000);
+    TEST_ASSERT_EQUAL_FLOAT(lf, engine.getMetrics().lfPower);
+}
+
+void test_reset_clears_everything() {
+    HrvEngine engine;
+    feedIntervals(engine, modulatedRhythm(100, 30, 15));
+    engine.reset();
+    TEST_ASSERT_EQUAL_UINT32(0, engine.getMetrics().intervals);
+    TEST_ASSERT_FLOAT_WITHIN(1e-6, 0.0, engine.getMetrics().rmssdMs);
+    TEST_ASSERT_FALSE(engine.getMetrics().spectrumValid);
+    TEST_ASSERT_FALSE(engine.addBeat(1000000));
+    TEST_ASSERT_TRUE(engine.addBeat(1800000));
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_time_domain_matches_direct_computation);
+    RUN_TEST(test_no_difference_across_the_ring_wrap);
+    RUN_TEST(test_ectopic_beat_is_left_out);
+    RUN_TEST(test_a_real_rate_change_is_followed);
+    RUN_TEST(test_lost_beats_break_the_chain);
+    RUN_TEST(test_lf_and_hf_power_of_known_modulation);
+    RUN_TEST(test_incremental_periodogram_matches_direct_lomb_scargle);
+    RUN_TEST(test_spectrum_waits_for_enough_data_and_its_interval);
+    RUN_TEST(test_reset_clears_everything);
+    return UNITY_END();
+}
@@ -0,0 +1,124 @@
+// Per-beat cost of the incremental HRV engine against recomputing from the window
+// Run with: pio test -e native -f test_hrv_engine_bench -v   (-v shows the numbers)
+
+#include <unity.h>
+#include <stdio.h>
+#include <math.h>
+#include "dsp/hrv_engine.h"
+#include "../mocks/bench_util.h"
+
+static const uint32_t BEATS = 200000;
+
+// Modulated rhythm, 700-1000 ms
+static uint32_t intervals[4096];
+
+void setUp() {
+    double t = 0;
+    for (int i = 0; i < 4096; i++) {
+        double rr = 850 + 60 * sin(2 * M_PI * 0.1 * t) + 30 * sin(2 * M_PI * 0.25 * t) + (i * 7919) % 23 - 11;
+        intervals[i] = (uint32_t)(rr * 1000);
+        t += rr / 1000.0;
+    }
+}
+void tearDown() {}
+
+void test_bench_per_beat_update() {
+    // Previous calculateHRV(): RMSSD re-summed over the 50-entry array
+    float rrIntervals[50] = {0};
+    int rrCount = 0;
+    float checksum = 0;
+    BenchTimer timer;
+    for (uint32_t n = 0; n < BEATS; n++) {
+        rrIntervals[rrCount % 50] = intervals[n & 4095] / 1000.0f;
+        rrCount++;
+        float sumSquaredDiff = 0;
+        int validDiffs = 0;
+        for (int i = 1; i < (rrCount < 50 ? rrCount : 50); i++) {
+            float diff = rrIntervals[i] - rrIntervals[i - 1];
+            sumSquaredDiff += diff * diff;
+            validDiffs++;
+        }
+        checksum += validDiffs ? sqrtf(sumSquaredDiff / validDiffs) : 0;
+    }
+    benchReport("RMSSD re-summed over 50 (old)", BEATS, timer.seconds(), "beat");
+    benchSink = checksum;
+
+    // Time domain and periodogram sums every beat, LF/HF every 5 s
+    HrvEngine engine(5000);
+    uint64_t t = 1000000;
+    checksum = 0;
+    timer.restart();
+    for (uint32_t n = 0; n < BEATS; n++) {
+        t += intervals[n & 4095];
+        engine.addBeat(t);
+        checksum += engine.getMetrics().rmssdMs;
+    }
+    benchReport("HrvEngine, LF/HF every 5 s", BEATS, timer.seconds(), "beat");
+    benchSink = checksum + engine.getMetrics().lfPower;
+    TEST_ASSERT_TRUE(engine.getMetrics().spectrumValid);
+    TEST_ASSERT_TRUE(isfinite(checksum));
+
+    // LF/HF assembled on every beat, the most it can cost
+    HrvEngine everyBeat(0);
+    t = 1000000;
+    checksum = 0;
+    timer.restart();
+    for (uint32_t n = 0; n < BEATS; n++) {
+        t += intervals[n & 4095];
+        everyBeat.addBeat(t);
+        checksum += everyBeat.getMetrics().lfHfRatio;
+    }
+    benchReport("HrvEngine, LF/HF every beat", BEATS, timer.seconds(), "beat");
+    benchSink = checksum;
+    TEST_ASSERT_TRUE(isfinite(checksum));
+}
+
+void test_bench_direct_lomb_scargle() {
+    // What each LF/HF update would cost without the running sums: the
+    // textbook periodogram over the whole window at every grid frequency
+    const uint32_t EVALUATIONS = 200;
+    const uint32_t N = HrvEngine::WINDOW;
+    double t[N], y[N];
+    double clock = 0;
+    for (uint32_t i = 0; i < N; i++) {
+        clock += intervals[i] / 1e6;
+        t[i] = clock;
+        y[i] = intervals[i] / 1000.0;
+    }
+    double checksum = 0;
+    BenchTimer timer;
+    for (uint32_t e = 0; e < EVALUATIONS; e++) {
+        double mean = 0;
+        for (uint32_t i = 0; i < N; i++) mean += y[i];
+        mean /= N;
+        for (uint32_t k = HrvEngine::FIRST_BIN; k <= HrvEngine::LAST_BIN; k++) {
+            double w = 2 * M_PI * k / (double)HrvEngine::SPECTRUM_PERIOD_S;
+            double s2 = 0, c2 = 0;
+            for (uint32_t i = 0; i < N; i++) {
+                s2 += sin(2 * w * t[i]);
+                c2 += cos(2 * w * t[i]);
+            }
+            double tau = atan2(s2, c2) / (2 * w);
+            double yc = 0, ys = 0, cc = 0, ss = 0;
+            for (uint32_t i = 0; i < N; i++) {
+                double c = cos(w * (t[i] - tau)), s = sin(w * (t[i] - tau));
+                yc += (y[i] - mean) * c;
+                ys += (y[i] - mean) * s;
+                cc += c * c;
+                ss += s * s;
+            }
+            checksum += 0.5 * (yc * yc / cc + ys * ys / ss);
+        }
+        t[e % N] += 1e-6;   // Defeat hoisting across evaluations
+    }
+    benchReport("direct Lomb-Scargle over the window", EVALUATIONS, timer.seconds(), "evaluation");
+    benchSink = (float)checksum;
+    TEST_ASSERT_TRUE(isfinite(checksum));
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_bench_per_beat_update);
+    RUN_TEST(test_bench_direct_lomb_scargle);
+    return UNITY_END();
+}
@@ -0,0 +1,137 @@
+// Host tests for the kernel benchmark runner, its JSON and the regression check
+// Run with: pio test -e native -f test_kernel_bench -v   (-v shows the host numbers)
+
+#include <unity.h>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include <Arduino.h>
+#include "bench/kernel_bench.h"
+#include "config.h"
+
+static volatile float sink;
+
+void setUp() {}
+void tearDown() {}
+
+void test_runner_times_each_kernel() {
+    KernelBench bench(0.01);
+    float value = 0;
+    bench.run("short", 4, [&]() {
+        for (int i = 0; i < 4; i++) value += 1.0f;
+        sink = value;
+    });
+    bench.run("long", 1, [&]() {
+        for (int i = 0; i < 4000; i++) value += 1.0f;
+        sink = value;
+    });
+    const std::vector<KernelBenchResult>& results = bench.getResults();
+    TEST_ASSERT_EQUAL(2, results.size());
+    TEST_ASSERT_EQUAL_STRING("short", results[0].name.c_str());
+    TEST_ASSERT_EQUAL_UINT32(4, results[0].samplesPerOp);
+    TEST_ASSERT_TRUE(results[0].ops > 1000);
+    TEST_ASSERT_TRUE(results[0].nsPerOp > 0);
+    TEST_ASSERT_FLOAT_WITHIN(1e-6, results[0].nsPerOp / 4, results[0].nsPerSample());
+    // No cycle counter on the host
+    TEST_ASSERT_TRUE(results[0].cyclesPerOp < 0);
+    TEST_ASSERT_TRUE(results[0].cyclesPerSample() < 0);
+    TEST_ASSERT_TRUE(results[1].nsPerOp > 10 * results[0].nsPerOp);
+}
+
+void test_filter_skips_other_kernels() {
+    KernelBench bench(0.001);
+    bench.setFilter("ppg_");
+    uint64_t calls[2] = {};     // An empty op is folded into whole batches, so these get large
+    bench.run("ecg_bandpass", 1, [&]() { calls[0]++; });
+    bench.run("ppg_bandpass", 1, [&]() { calls[1]++; });
+    TEST_ASSERT_EQUAL(1, bench.getResults().size());
+    TEST_ASSERT_EQUAL(0, calls[0]);
+    TEST_ASSERT_TRUE(calls[1] > 0);
+}
+
+void test_json_reads_back() {
+    std::vector<KernelBenchResult> results;
+    KernelBenchResult a = {"ecg_bandpass", 25, 4096, 180.5, -1};
+    KernelBenchResult b = {"bp_estimate", 1, 100, 2000.25, 48000};
+    results.push_back(a);
+    results.push_back(b);
+    std::string json = kernelBenchJSON(results);
+    TEST_ASSERT_TRUE(json.find("\"firmware\":\"" FIRMWARE_VERSION "\"") != std::string::npos);
+    TEST_ASSERT_TRUE(json.find("\"platform\":\"host\"") != std::string::npos);
+    TEST_ASSERT_TRUE(json.find("\"cycles_per_sample\":null") != std::string::npos);
+    TEST_ASSERT_TRUE(json.find("\"ns_per_sample\":7.220") != std::string::npos);
+
+    std::vector<KernelBenchResult> parsed;
+    TEST_ASSERT_TRUE(parseKernelBenchJSON(json, parsed));
+    TEST_ASSERT_EQUAL(2, parsed.size());
+    TEST_ASSERT_EQUAL_STRING("bp_estimate", parsed[1].name.c_str());
+    TEST_ASSERT_EQUAL_UINT32(25, parsed[0].samplesPerOp);
+    TEST_ASSERT_EQUAL_UINT64(4096, parsed[0].ops);
+    TEST_ASSERT_FLOAT_WITHIN(0.001, 180.5, parsed[0].nsPerOp);
+    TEST_ASSERT_TRUE(parsed[0].cyclesPerOp < 0);
+    TEST_ASSERT_FLOAT_WITHIN(0.001, 48000, parsed[1].cyclesPerOp);
+
+    TEST_ASSERT_FALSE(parseKernelBenchJSON("{\"suite\":\"other\"}", parsed));
+}
+
+void test_compare_flags_slower_kernels() {
+    std::vector<KernelBenchResult> baseline;
+    KernelBenchResult a = {"ecg_bandpass", 25, 1, 100, -1};
+    KernelBenchResult b = {"bp_estimate", 1, 1, 1000, 4000};
+    KernelBenchResult gone = {"removed", 1, 1, 10, -1};
+    baseline.push_back(a);
+    baseline.push_back(b);
+    baseline.push_back(gone);
+
+    std::vector<KernelBenchResult> current = baseline;
+    current[0].nsPerOp = 105;           // Within 10%
+    current[1].nsPerOp = 900;           // Faster in ns, but 20% more cycles
+    current[1].cyclesPerOp = 4800;
+    current.pop_back();
+    std::string report;
+    TEST_ASSERT_EQUAL(1, compareKernelBench(baseline, current, 10, report));
+    TEST_MESSAGE(report.c_str());
+    TEST_ASSERT_TRUE(report.find("bp_estimate") != std::string::npos);
+    TEST_ASSERT_TRUE(report.find("REGRESSION") != std::string::npos);
+    TEST_ASSERT_TRUE(report.find("removed") == std::string::npos);
+
+    report.clear();
+    TEST_ASSERT_EQUAL(0, compareKernelBench(baseline, current, 25, report));
+}
+
+void test_every_firmware_kernel_runs() {
+    Serial.setOutput(nullptr);
+    KernelBench bench(0.005);
+    runDspKernels(bench);
+    Serial.setOutput(stdout);
+
+    static const char* expected[] = {"ecg_bandpass", "ppg_bandpass", "ecg_bandpass_q15", "ppg_bandpass_q15",
+                                     "qrs_detector", "ppg_peak_detector",
+                                     "ppg_fiducials", "bp_estimate", "hrv_beat", "glucose_window",
+                                     "ad5940_impedance", "bia_process_raw", "body_composition", "sensor_json"};
+    const std::vector<KernelBenchResult>& results = bench.getResults();
+    TEST_ASSERT_EQUAL(sizeof(expected) / sizeof(expected[0]), results.size());
+    for (size_t i = 0; i < results.size(); i++) {
+        TEST_ASSERT_EQUAL_STRING(expected[i], results[i].name.c_str());
+        TEST_ASSERT_TRUE(results[i].ops > 0);
+        TEST_ASSERT_TRUE(results[i].nsPerOp > 0);
+        char line[96];
+        snprintf(line, sizeof(line), "%-20s %10.1f ns/op %8.2f ns/sample", results[i].name.c_str(), results[i].nsPerOp,
+                 results[i].nsPerSample());
+        TEST_MESSAGE(line);
+    }
+    std::vector<KernelBenchResult> parsed;
+    TEST_ASSERT_TRUE(parseKernelBenchJSON(kernelBenchJSON(results), parsed));
+    TEST_ASSERT_EQUAL(results.size(), parsed.size());
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_runner_times_each_kernel);
+    RUN_TEST(test_filter_skips_other_kernels);
+    RUN_TEST(test_json_reads_back);
+    RUN_TEST(test_compare_flags_slower_kernels);
+    RUN_TEST(test_every_firmware_kernel_runs);
+    return UNITY_END();
+}
@@ -0,0 +1,138 @@
+// Host tests for the modules the native env builds through the HAL
+// Run with: pio test -e native -f test_native_modules
+
+#include <unity.h>
+#include <string.h>
+#include <math.h>
+#include "hal/hal.h"
+#include "blood_pressure.h"
+#include "body_composition.h"
+#include "data_manager.h"
+#include "../mocks/mock_hal.h"
+#include "../mocks/synthetic_ecg.h"
+#include "../mocks/synthetic_ppg.h"
+
+static const double ECG_RATE = 250;
+static const double PPG_RATE = 200;
+
+static ManualClock manualClock;
+static MemoryFileSystem memoryFs;
+
+void setUp() {
+    manualClock = ManualClock();
+    memoryFs = MemoryFileSystem();
+    hal::setClock(&manualClock);
+    hal::setFileSystem(&memoryFs);
+}
+
+void tearDown() {
+    hal::setClock(nullptr);
+    hal::setFileSystem(nullptr);
+}
+
+void test_installed_clock_drives_the_arduino_calls() {
+    manualClock.nowUs = 1234567;
+    TEST_ASSERT_EQUAL_UINT32(1234, millis());
+    TEST_ASSERT_EQUAL_UINT32(1234567, micros());
+    delay(50);
+    TEST_ASSERT_EQUAL_UINT32(1284, millis());
+
+    hal::setClock(nullptr);
+    TEST_ASSERT_TRUE(&hal::clock() == &hal::platformClock());
+}
+
+void test_blood_pressure_pairs_beats_on_the_host() {
+    const double transit = 0.200;
+    SyntheticECG ecg(ECG_RATE);
+    SyntheticPPG ppg(PPG_RATE);
+    for (double t = 0.5; t < 15; t += 0.8) {
+        ecg.rPeaks.push_back(t);
+        ppg.onsets.push_back(t + transit - ppg.riseSeconds / 2);
+    }
+
+    // R-peaks arrive from the stream's QRS detector, a little after the fact
+    BloodPressureMonitor monitor;
+    TEST_ASSERT_TRUE(monitor.begin());
+    uint32_t ppgNext = 0;
+    size_t beatNext = 0;
+    for (uint32_t n = 0; n < 15 * ECG_RATE; n++) {
+        uint64_t timeUs = (uint64_t)(n * 1e6 / ECG_RATE);
+        monitor.addECGSample((float)(2048 + ecg.sample(n)), timeUs);
+        if (beatNext < ecg.rPeaks.size() && ecg.rPeaks[beatNext] + 0.1 <= n / ECG_RATE) {
+            QrsEvent beat = {(uint64_t)(ecg.rPeaks[beatNext++] * 1e6), 1000, 0, 0, false};
+            monitor.addRPeak(beat);
+        }
+        while ((uint64_t)(ppgNext * 1e6 / PPG_RATE) <= timeUs) {
+            float ir = (float)ppg.sample(ppgNext);
+            monitor.addPPGSample(ir, ir, (uint64_t)(ppgNext * 1e6 / PPG_RATE));
+            ppgNext++;
+        }
+    }
+
+    manualClock.nowUs = 15000000;
+    BloodPressureData reading = monitor.calculateBloodPressure();
+    TEST_ASSERT_EQUAL_UINT32(15000, reading.timestamp);
+    // Exact R-peaks here, so the PTT carries the PPG band-pass delay on top
+    TEST_ASSERT_TRUE(reading.pulseTransitTime > transit * 1e3);
+    TEST_ASSERT_TRUE(reading.pulseTransitTime < transit * 1e3 + 80);
+    TEST_ASSERT_TRUE(reading.needsCalibration);
+}
+
+void test_body_composition_stamps_with_the_hal_clock() {
+    manualClock.nowUs = 42000000;
+    BodyCompositionAnalyzer analyzer;
+    analyzer.setUserProfile({35, 175, 70, true, 3, false});
+    BodyComposition composition = analyzer.analyzeFromSingleFrequency(500, 55, 50000, 70);
+    TEST_ASSERT_EQUAL_UINT32(42000, composition.timestamp);
+    TEST_ASSERT_TRUE(composition.phaseAngle > 5 && composition.phaseAngle < 7);
+}
+
+static size_t countLines(const std::string& text) {
+    size_t lines = 0;
+    for (char c : text) lines += c == '\n';
+    return lines;
+}
+
+void test_data_manager_persists_through_the_file_system() {
+    static DataManager manager;
+    TEST_ASSERT_TRUE(manager.begin());
+    TEST_ASSERT_TRUE(memoryFs.mounted);
+
+    static SensorReadings reading;
+    reading = SensorReadings();
+    reading.temperature = {36.8f, true, 0};
+    for (int i = 0; i < 3; i++) {
+        manualClock.advanceMs(1000);
+        TEST_ASSERT_TRUE(manager.addSensorData(reading));
+    }
+    TEST_ASSERT_EQUAL(3, countLines(memoryFs.files["/sensor_data.json"]));
+    TEST_ASSERT_FALSE(manager.hasUnacknowledgedAlerts());
+
+    // Alerts are stamped with millis(), so a stopped clock would drop them
+    reading.heartRate = {200, 98, true, 0, 0};
+    TEST_ASSERT_TRUE(manager.addSensorData(reading));
+    TEST_ASSERT_EQUAL(1, manager.getUnacknowledgedAlertsCount());
+    TEST_ASSERT_TRUE(memoryFs.exists("/alerts.json"));
+    TEST_ASSERT_TRUE(memoryFs.size("/alerts.json") > 0);
+
+    TEST_ASSERT_EQUAL(memoryFs.capacity - memoryFs.usedBytes(), manager.getAvailableStorage());
+
+    // A restart reads both files back without touching them, each in one
+    // open however many chunks they span
+    memoryFs.files["/sensor_data.json"].append(3 * hal::FileSystem::READ_CHUNK_BYTES, ' ').append("\n");
+    std::string before = memoryFs.files["/sensor_data.json"];
+    memoryFs.opens = 0;
+    static DataManager restarted;
+    TEST_ASSERT_TRUE(restarted.begin());
+    TEST_ASSERT_EQUAL(2, memoryFs.opens);
+    TEST_ASSERT_TRUE(before == memoryFs.files["/sensor_data.json"]);
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_installed_clock_drives_the_arduino_calls);
+    RUN_TEST(test_blood_pressure_pairs_beats_on_the_host);
+    RUN_TEST(test_body_composition_stamps_with_the_hal_clock);
+    RUN_TEST(test_data_manager_persists_through_the_file_system);
+    return UNITY_END();
+}
@@ -0,0 +1,225 @@
+// Host tests for sub-sample peak timing and the microsecond PTT path
+// Run with: pio test -e native -f test_peak_timing -v   (-v shows the PTT spread)
+
+#include <unity.h>
+#include <stdio.h>
+#include <math.h>
+#include <vector>
+#include "dsp/peak_timing.h"
+
+// Synthetic recording: Gaussian R-waves and pulse waves with a known delay
+static const double TRUE_PTT_US = 213437.0;
+static const double ECG_RATE_HZ = 250.0;
+static const double PPG_RATE_HZ = 100.0;
+static const double ECG_SIGMA_US = 12000.0;
+static const double PPG_SIGMA_US = 70000.0;
+static const double DURATION_US = 120e6;
+
+static std::vector<double> beatTimesUs() {
+    std::vector<double> beats;
+    double t = 500000.0;
+    for (int k = 0; t < DURATION_US - 1e6; k++) {
+        beats.push_back(t);
+        t += 830000.0 + 45000.0 * sin(k * 0.7) + 137.0 * k;   // Irregular RR, never on the sample grid
+    }
+    return beats;
+}
+
+static double gaussianTrain(const std::vector<double>& centres, double offsetUs, double sigmaUs, double tUs) {
+    double value = 0;
+    for (double centre : centres) {
+        double d = tUs - (centre + offsetUs);
+        if (fabs(d) < 5 * sigmaUs) value += exp(-d * d / (2 * sigmaUs * sigmaUs));
+    }
+    return value;
+}
+
+// Small deterministic noise so the peaks are not perfectly clean
+static uint32_t noiseState = 12345;
+static double noise(double amplitude) {
+    noiseState = noiseState * 1664525u + 1013904223u;
+    return amplitude * ((noiseState >> 8) / 16777216.0 - 0.5);
+}
+
+enum TimingMode {
+    // Previous behaviour: each peak stamped in whole ms when its block was processed
+    TIMING_PROCESSING_MS,
+    // Source timestamps, peak on the maximum sample
+    TIMING_SOURCE_SAMPLE,
+    // Source timestamps plus parabolic interpolation
+    TIMING_SOURCE_INTERPOLATED
+};
+
+struct Channel {
+    double rateHz;
+    double startUs;
+    double blockUs;     // How often the consumer drained this channel
+    double sigmaUs;
+    double offsetUs;    // Delay of this channel's wave after the R-peak
+    double amplitude;
+    float threshold;
+    uint32_t refractoryUs;
+};
+
+static std::vector<uint64_t> detect(const Channel& ch, const std::vector<double>& beats, TimingMode mode) {
+    PeakDetector detector(ch.threshold, ch.refractoryUs);
+    detector.setInterpolation(mode == TIMING_SOURCE_INTERPOLATED);
+    std::vector<uint64_t> peaks;
+    double periodUs = 1e6 / ch.rateHz;
+
+    for (double t = ch.startUs; t < DURATION_US; t += periodUs) {
+        float value = (float)(ch.amplitude * gaussianTrain(beats, ch.offsetUs, ch.sigmaUs, t) + noise(ch.amplitude * 0.002));
+        uint64_t stamp;
+        if (mode == TIMING_PROCESSING_MS) {
+            // Block delivered at the next consumer pass, then a little scheduling delay
+            double processedUs = ceil(t / ch.blockUs) * ch.blockUs + 300.0 + fabs(noise(2000.0));
+            stamp = (uint64_t)(processedUs / 1000.0) * 1000;
+        } else {
+            // Source clock: quantised to 1 us, like esp_timer
+            stamp = (uint64_t)(t + 0.5);
+        }
+        TimedPeak peak;
+        if (detector.addSample(value, stamp, peak)) peaks.push_back(peak.timeUs);
+    }
+    return peaks;
+}
+
+struct PttStats {
+    int beats;
+    double meanErrorUs;
+    double stdUs;
+};
+
+static PttStats measurePtt(TimingMode mode) {
+    noiseState = 12345;
+    std::vector<double> beats = beatTimesUs();
+    Channel ecg = {ECG_RATE_HZ, 1000.0, 100000.0, ECG_SIGMA_US, 0.0, 1000.0, 500.0f, 300000};
+    Channel ppg = {PPG_RATE_HZ, 3700.0, 170000.0, PPG_SIGMA_US, TRUE_PTT_US, 1.0, 0.5f, 400000};
+    std::vector<uint64_t> rPeaks = detect(ecg, beats, mode);
+    std::vector<uint64_t> pulsePeaks = detect(ppg, beats, mode);
+
+    double sum = 0, sumSq = 0;
+    int n = 0;
+    for (uint64_t r : rPeaks) {
+        // One beat at a time, so each PTT is a separate estimate
+        float ptt = meanPulseTransitUs(&r, 1, pulsePeaks.data(), pulsePeaks.size(), 50000, 400000);
+        if (ptt < 0) continue;
+        double error = ptt - TRUE_PTT_US;
+        sum += error;
+        sumSq += error * error;
+        n++;
+    }
+    PttStats stats = {n, 0, 0};
+    if (n > 1) {
+        stats.meanErrorUs = sum / n;
+        stats.stdUs = sqrt(sumSq / n - stats.meanErrorUs * stats.meanErrorUs);
+    }
+    return stats;
+}
+
+static void report(const char* name, const PttStats& s) {
+    char line[128];
+    snprintf(line, sizeof(line), "%-34s beats=%3d  bias=%8.1f us  std=%8.1f us",
+             name, s.beats, s.meanErrorUs, s.stdUs);
+    TEST_MESSAGE(line);
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_parabolic_offset_recovers_vertex() {
+    // y = 10 - (x - 0.3)^2 sampled at -1, 0, 1
+    float vertex = 0;
+    float offset = parabolicPeakOffset(10 - 1.69f, 10 - 0.09f, 10 - 0.49f, &vertex);
+    TEST_ASSERT_FLOAT_WITHIN(1e-5f, 0.3f, offset);
+    TEST_ASSERT_FLOAT_WITHIN(1e-4f, 10.0f, vertex);
+
+    TEST_ASSERT_EQUAL_FLOAT(0.0f, parabolicPeakOffset(1, 1, 1));   // Flat: no vertex
+    TEST_ASSERT_EQUAL_FLOAT(0.0f, parabolicPeakOffset(2, 1, 2));   // Minimum, not a peak
+}
+
+void test_detector_reports_interpolated_time_after_confirming_sample() {
+    PeakDetector detector(0.5f, 100000);
+    TimedPeak peak;
+    // Samples 4 ms apart on 1 - 0.5 * ((t - 9 ms) / 4 ms)^2: the maximum is
+    // 1 ms after the largest sample
+    uint64_t t0 = 1000000;
+    float a = 1.0f - (5.0f / 4.0f) * (5.0f / 4.0f) * 0.5f;   // t = 4 ms
+    float b = 1.0f - (1.0f / 4.0f) * (1.0f / 4.0f) * 0.5f;   // t = 8 ms
+    float c = 1.0f - (3.0f / 4.0f) * (3.0f / 4.0f) * 0.5f;   // t = 12 ms
+
+    TEST_ASSERT_FALSE(detector.addSample(0.1f, t0, peak));
+    TEST_ASSERT_FALSE(detector.addSample(a, t0 + 4000, peak));
+    TEST_ASSERT_FALSE(detector.addSample(b, t0 + 8000, peak));
+    TEST_ASSERT_TRUE(detector.addSample(c, t0 + 12000, peak));
+    TEST_ASSERT_EQUAL_UINT32(2, peak.index);
+    TEST_ASSERT_EQUAL_UINT64(t0 + 9000, peak.timeUs);
+    TEST_ASSERT_FLOAT_WITHIN(1e-4f, 1.0f, peak.value);
+
+    detector.reset();
+    detector.setInterpolation(false);
+    detector.addSample(0.1f, t0, peak);
+    detector.addSample(a, t0 + 4000, peak);
+    detector.addSample(b, t0 + 8000, peak);
+    TEST_ASSERT_TRUE(detector.addSample(c, t0 + 12000, peak));
+    TEST_ASSERT_EQUAL_UINT64(t0 + 8000, peak.timeUs);
+}
+
+void test_refractory_period_uses_sample_time() {
+    PeakDetector detector(0.5f, 300000);
+    TimedPeak peak;
+    int peaks = 0;
+    // Two maxima 200 ms apart, then one 600 ms later; all fed back to back
+    const float wave[] = {0, 1, 0, 1, 0, 0, 0, 0, 0, 1, 0};
+    for (int i = 0; i < 11; i++) {
+        if (detector.addSample(wave[i], 1000000ULL + i * 100000ULL, peak)) peaks++;
+    }
+    TEST_ASSERT_EQUAL(2, peaks);
+    TEST_ASSERT_EQUAL_UINT64(1900000ULL, peak.timeUs);
+
+    // Below threshold: nothing
+    detector.reset();
+    peaks = 0;
+    for (int i = 0; i < 11; i++) {
+        if (detector.addSample(wave[i] * 0.4f, 1000000ULL + i * 100000ULL, peak)) peaks++;
+    }
+    TEST_ASSERT_EQUAL(0, peaks);
+}
+
+void test_pulse_transit_pairs_first_peak_in_window() {
+    const uint64_t r[] = {1000000, 2000000, 3000000};
+    const uint64_t p[] = {900000, 1020000, 1210000, 1400000, 2250000, 3500000};
+    // 1.0 s pairs with 1.21 s (1.02 s is under 50 ms), 2.0 s with 2.25 s, 3.0 s has no match
+    TEST_ASSERT_FLOAT_WITHIN(0.5f, 230000.0f, meanPulseTransitUs(r, 3, p, 6, 50000, 400000));
+    TEST_ASSERT_EQUAL_FLOAT(-1.0f, meanPulseTransitUs(r + 2, 1, p, 6, 50000, 400000));
+    TEST_ASSERT_EQUAL_FLOAT(-1.0f, meanPulseTransitUs(r, 3, p, 0, 50000, 400000));
+}
+
+void test_replay_ptt_variance_improves_with_source_timestamps() {
+    PttStats legacy = measurePtt(TIMING_PROCESSING_MS);
+    PttStats sample = measurePtt(TIMING_SOURCE_SAMPLE);
+    PttStats interpolated = measurePtt(TIMING_SOURCE_INTERPOLATED);
+
+    report("processing time, whole ms", legacy);
+    report("source us, sample resolution", sample);
+    report("source us, interpolated", interpolated);
+
+    TEST_ASSERT_GREATER_THAN(100, interpolated.beats);
+    TEST_ASSERT_EQUAL(legacy.beats, interpolated.beats);
+    // Interpolated timing recovers the true delay to well under a millisecond
+    TEST_ASSERT_TRUE(fabs(interpolated.meanErrorUs) < 500.0);
+    TEST_ASSERT_TRUE(interpolated.stdUs < 500.0);
+    // ...and each step removes a large share of the spread
+    TEST_ASSERT_TRUE(sample.stdUs < legacy.stdUs / 4);
+    TEST_ASSERT_TRUE(interpolated.stdUs < sample.stdUs / 4);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_parabolic_offset_recovers_vertex);
+    RUN_TEST(test_detector_reports_interpolated_time_after_confirming_sample);
+    RUN_TEST(test_refractory_period_uses_sample_time);
+    RUN_TEST(test_pulse_transit_pairs_first_peak_in_window);
+    RUN_TEST(test_replay_ptt_variance_improves_with_source_timestamps);
+    return UNITY_END();
+}
@@ -0,0 +1,169 @@
+// Host tests for the compile-time DSP pipeline and its stages
+// Run with: pio test -e native -f test_pipeline
+
+#include <unity.h>
+#include <vector>
+#include "dsp/pipeline.h"
+#include "dsp/bandpass_designs.h"
+#include "../mocks/synthetic_ecg.h"
+
+static const uint32_t RATE = 250;
+typedef ECGBandpass<RATE> Design;
+
+enum { TAP_RAW, TAP_FILTERED, TAP_AVERAGED };
+
+// 30 s at 75 BPM on the AD8232 mid-rail
+static std::vector<float> ecg;
+static std::vector<uint64_t> times;
+
+struct Recorder {
+    std::vector<float> raw;
+    std::vector<float> filtered;
+    std::vector<float> averaged;
+    std::vector<uint64_t> filteredTimes;
+    std::vector<QrsEvent> beats;
+
+    static void append(std::vector<float>& to, const SampleBlock& block) {
+        to.insert(to.end(), block.values, block.values + block.count);
+    }
+    void on(const TappedBlock<TAP_RAW>& tap) { append(raw, tap.block); }
+    void on(const TappedBlock<TAP_FILTERED>& tap) {
+        append(filtered, tap.block);
+        filteredTimes.insert(filteredTimes.end(), tap.block.timestampsUs, tap.block.timestampsUs + tap.block.count);
+    }
+    void on(const TappedBlock<TAP_AVERAGED>& tap) { append(averaged, tap.block); }
+    void on(const QrsEvent& beat) { beats.push_back(beat); }
+};
+
+// Feeds the whole record in blocks of blockSize
+template <typename P, typename Events>
+static void run(P& pipeline, Events& events, size_t blockSize, size_t first = 0, size_t last = 0) {
+    if (last == 0) last = ecg.size();
+    std::vector<float> values(blockSize);
+    std::vector<uint64_t> stamps(blockSize);
+    for (size_t start = first; start < last; start += blockSize) {
+        size_t n = last - start < blockSize ? last - start : blockSize;
+        for (size_t i = 0; i < n; i++) {
+            values[i] = ecg[start + i];
+            stamps[i] = times[start + i];
+        }
+        SampleBlock block = {values.data(), stamps.data(), n};
+        pipeline.process(block, events);
+    }
+}
+
+void setUp() {
+    if (!ecg.empty()) return;
+    SyntheticECG source(RATE);
+    source.noiseCounts = 20;
+    for (double t = 0.5; t < 30; t += 0.8) source.rPeaks.push_back(t);
+    for (uint32_t n = 0; n < 30 * RATE; n++) {
+        ecg.push_back(2048.0f + (float)source.sample(n));
+        times.push_back(1000000 + (uint64_t)n * 1000000 / RATE);
+    }
+}
+void tearDown() {}
+
+void test_chain_matches_the_hand_written_one() {
+    Pipeline<BandpassStage<Design>, TapStage<TAP_FILTERED>, QrsStage<RATE> > pipeline;
+    Recorder recorder;
+    run(pipeline, recorder, 25);
+
+    // What the stream used to do sample by sample
+    BiquadCascade<Design::SECTIONS> filter(Design::coeffs);
+    QrsDetector qrs(RATE);
+    filter.prime(ecg[0]);
+    std::vector<QrsEvent> beats;
+    for (size_t n = 0; n < ecg.size(); n++) {
+        float value = filter.process(ecg[n]);
+        TEST_ASSERT_EQUAL_FLOAT(value, recorder.filtered[n]);
+        QrsEvent beat;
+        if (qrs.addSample(value, times[n], beat)) beats.push_back(beat);
+    }
+    TEST_ASSERT_EQUAL(ecg.size(), recorder.filteredTimes.size());
+    TEST_ASSERT_EQUAL_UINT64(times.back(), recorder.filteredTimes.back());
+    TEST_ASSERT_EQUAL(beats.size(), recorder.beats.size());
+    TEST_ASSERT_TRUE(beats.size() >= 35);
+    for (size_t b = 0; b < beats.size(); b++) {
+        TEST_ASSERT_EQUAL_UINT64(beats[b].timeUs, recorder.beats[b].timeUs);
+    }
+}
+
+void test_block_size_does_not_change_the_output() {
+    Pipeline<BandpassStage<Design>, TapStage<TAP_FILTERED>, QrsStage<RATE> > one, many;
+    Recorder single, blocks;
+    run(one, single, 1);
+    run(many, blocks, 128);
+    TEST_ASSERT_EQUAL(single.filtered.size(), blocks.filtered.size());
+    for (size_t n = 0; n < single.filtered.size(); n++) {
+        TEST_ASSERT_EQUAL_FLOAT(single.filtered[n], blocks.filtered[n]);
+    }
+    TEST_ASSERT_EQUAL(single.beats.size(), blocks.beats.size());
+}
+
+void test_branch_works_on_a_copy() {
+    Pipeline<BranchStage<16, MovingAverageStage<10>, TapStage<TAP_AVERAGED> >,
+             TapStage<TAP_RAW>,
+             BandpassStage<Design>,
+             TapStage<TAP_FILTERED> > pipeline;
+    Recorder recorder;
+    run(pipeline, recorder, 25);     // Wider than the branch: split into pieces
+
+    TEST_ASSERT_EQUAL(ecg.size(), recorder.raw.size());
+    TEST_ASSERT_EQUAL(ecg.size(), recorder.averaged.size());
+    for (size_t n = 0; n < ecg.size(); n++) {
+        TEST_ASSERT_EQUAL_FLOAT(ecg[n], recorder.raw[n]);
+        double sum = 0;
+        size_t first = n >= 9 ? n - 9 : 0;
+        for (size_t k = first; k <= n; k++) sum += ecg[k];
+        TEST_ASSERT_FLOAT_WITHIN(1e-2, sum / (n - first + 1), recorder.averaged[n]);
+    }
+}
+
+void test_decimation_spans_blocks() {
+    Pipeline<DecimateStage<4>, TapStage<TAP_FILTERED> > pipeline;
+    Recorder recorder;
+    run(pipeline, recorder, 7);      // Runs of 4 straddle every block edge
+    TEST_ASSERT_EQUAL(ecg.size() / 4, recorder.filtered.size());
+    for (size_t k = 0; k < recorder.filtered.size(); k++) {
+        float mean = (ecg[4 * k] + ecg[4 * k + 1] + ecg[4 * k + 2] + ecg[4 * k + 3]) / 4;
+        TEST_ASSERT_FLOAT_WITHIN(1e-2, mean, recorder.filtered[k]);
+        TEST_ASSERT_EQUAL_UINT64(times[4 * k] + (times[4 * k + 3] - times[4 * k]) / 2, recorder.filteredTimes[k]);
+    }
+}
+
+void test_reset_primes_again() {
+    // After a reset the band-pass starts from the next block's level, not from
+    // the delay line it had: a 1 V step between the halves doesn't ring through
+    Pipeline<BandpassStage<Design>, TapStage<TAP_FILTERED> > pipeline;
+    Recorder recorder;
+    run(pipeline, recorder, 25, 0, 2500);
+    for (size_t n = 2500; n < ecg.size(); n++) ecg[n] += 1200;
+    pipeline.reset();
+    run(pipeline, recorder, 25, 2500, 2525);
+    for (size_t n = 2500; n < 2525; n++) {
+        TEST_ASSERT_TRUE(fabsf(recorder.filtered[n]) < 400);
+    }
+    for (size_t n = 2500; n < ecg.size(); n++) ecg[n] -= 1200;
+}
+
+void test_stages_are_reachable() {
+    Pipeline<BandpassStage<Design>, QrsStage<RATE> > pipeline;
+    NoPipelineEvents events;
+    run(pipeline, events, 32);
+    const QrsDetector& qrs = pipeline.stage<1>().detector();
+    TEST_ASSERT_FALSE(qrs.isLearning());
+    TEST_ASSERT_FLOAT_WITHIN(2, 75, qrs.getHeartRate());
+    TEST_ASSERT_EQUAL(2, (int)(Pipeline<BandpassStage<Design>, QrsStage<RATE> >::STAGES));
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_chain_matches_the_hand_written_one);
+    RUN_TEST(test_block_size_does_not_change_the_output);
+    RUN_TEST(test_branch_works_on_a_copy);
+    RUN_TEST(test_decimation_spans_blocks);
+    RUN_TEST(test_reset_primes_again);
+    RUN_TEST(test_stages_are_reachable);
+    return UNITY_END();
+}
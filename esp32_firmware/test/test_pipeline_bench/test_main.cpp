@@ -0,0 +1,175 @@
+// Throughput of the ECG and PPG chains, hand-chained per sample and as pipelines
+// Run with: pio test -e native -f test_pipeline_bench -v   (-v shows the numbers)
+
+#include <unity.h>
+#include <stdio.h>
+#include <vector>
+#include "dsp/pipeline.h"
+#include "dsp/bandpass_designs.h"
+#include "dsp/sliding_window_stats.h"
+#include "../mocks/synthetic_ecg.h"
+#include "../mocks/synthetic_ppg.h"
+#include "../mocks/bench_util.h"
+
+static const uint32_t ECG_RATE = 250;
+static const uint32_t PPG_RATE = 200;
+static const double SECONDS = 600;
+static const size_t ECG_BLOCK = 25;      // ECG_STREAM_BLOCK_SIZE
+static const size_t PPG_BLOCK = 32;      // BloodPressureMonitor::PPG_BLOCK_SIZE
+
+typedef ECGBandpass<ECG_RATE> ECGDesign;
+typedef PPGBandpass<PPG_RATE> PPGDesign;
+
+static std::vector<float> ecg;
+static std::vector<float> ppg;
+static std::vector<uint64_t> ecgTimes;
+static std::vector<uint64_t> ppgTimes;
+
+// Ten minutes of each: ECG on the AD8232 mid-rail, PPG in raw counts
+void setUp() {
+    if (!ecg.empty()) return;
+    SyntheticECG heart(ECG_RATE);
+    heart.noiseCounts = 20;
+    for (double t = 0.5; t < SECONDS; t += 0.8) heart.rPeaks.push_back(t);
+    for (uint32_t n = 0; n < SECONDS * ECG_RATE; n++) {
+        ecg.push_back(2048.0f + (float)heart.sample(n));
+        ecgTimes.push_back((uint64_t)n * 1000000 / ECG_RATE);
+    }
+    SyntheticPPG finger(PPG_RATE);
+    finger.noiseCounts = 40;
+    finger.regularOnsets(0.3, 0.8, 0.05, SECONDS);
+    for (uint32_t n = 0; n < SECONDS * PPG_RATE; n++) {
+        ppg.push_back(-(float)finger.sample(n));
+        ppgTimes.push_back(SyntheticPPG::timeUs(n, PPG_RATE));
+    }
+}
+void tearDown() {}
+
+// Stand-in for what the BP monitor keeps of the filtered signal
+struct History {
+    float values[256];
+    size_t next = 0;
+    void add(float value) {
+        values[next] = value;
+        next = (next + 1) & 255;
+    }
+};
+
+enum { TAP_AVERAGED, TAP_FILTERED };
+
+struct ECGEvents {
+    History& history;
+    float averaged;
+    uint32_t beats;
+    void on(const TappedBlock<TAP_AVERAGED>& tap) { averaged += tap.block.values[tap.block.count - 1]; }
+    void on(const TappedBlock<TAP_FILTERED>& tap) {
+        for (size_t i = 0; i < tap.block.count; i++) history.add(tap.block.values[i]);
+    }
+    void on(const QrsEvent&) { beats++; }
+};
+
+struct PPGEvents {
+    History& history;
+    uint32_t pulses;
+    void on(const TappedBlock<TAP_FILTERED>& tap) {
+        for (size_t i = 0; i < tap.block.count; i++) history.add(tap.block.values[i]);
+    }
+    void on(const PulseFiducials&) { pulses++; }
+};
+
+void test_ecg_chain() {
+    // Before: per frame, a moving average, the QRS band-pass and detector,
+    // and the BP monitor's own copy of the same band-pass
+    History history;
+    SlidingWindowStats<int, 10> average;
+    BiquadCascade<ECGDesign::SECTIONS> qrsFilter(ECGDesign::coeffs);
+    BiquadCascade<ECGDesign::SECTIONS> bpFilter(ECGDesign::coeffs);
+    static QrsDetector qrs(ECG_RATE);
+    qrsFilter.prime(ecg[0]);
+    bpFilter.prime(ecg[0]);
+    float averaged = 0;
+    uint32_t handBeats = 0;
+    BenchTimer timer;
+    for (size_t n = 0; n < ecg.size(); n++) {
+        average.push((int)ecg[n]);
+        averaged += (float)(average.sum() / 10);
+        history.add(bpFilter.process(ecg[n]));
+        QrsEvent beat;
+        if (qrs.addSample(qrsFilter.process(ecg[n]), ecgTimes[n], beat)) handBeats++;
+    }
+    double before = timer.seconds();
+    benchSink = averaged;
+
+    // After: SensorManager's ECG pipeline, one band-pass shared through a tap
+    static Pipeline<BranchStage<ECG_BLOCK, MovingAverageStage<10>, TapStage<TAP_AVERAGED> >,
+                    BandpassStage<ECGDesign>, TapStage<TAP_FILTERED>, QrsStage<ECG_RATE> > pipeline;
+    ECGEvents events = {history, 0, 0};
+    float values[ECG_BLOCK];
+    uint64_t times[ECG_BLOCK];
+    timer.restart();
+    for (size_t first = 0; first < ecg.size(); first += ECG_BLOCK) {
+        size_t n = ecg.size() - first < ECG_BLOCK ? ecg.size() - first : ECG_BLOCK;
+        for (size_t i = 0; i < n; i++) {
+            values[i] = ecg[first + i];
+            times[i] = ecgTimes[first + i];
+        }
+        SampleBlock block = {values, times, n};
+        pipeline.process(block, events);
+    }
+    double after = timer.seconds();
+    benchSink = events.averaged;
+
+    benchReport("ECG hand-chained, per sample", ecg.size(), before);
+    benchReport("ECG pipeline, 25-sample blocks", ecg.size(), after);
+    TEST_ASSERT_EQUAL_UINT32(handBeats, events.beats);
+}
+
+void test_ppg_chain() {
+    // Before: the BP monitor's block loop with the stages written out
+    History history;
+    BiquadCascade<PPGDesign::SECTIONS> filter(PPGDesign::coeffs);
+    static PulseFiducialDetector fiducials;
+    PulseFiducials beats[4];
+    float values[PPG_BLOCK];
+    uint64_t times[PPG_BLOCK];
+    uint32_t handPulses = 0;
+    filter.prime(ppg[0]);
+    BenchTimer timer;
+    for (size_t first = 0; first < ppg.size(); first += PPG_BLOCK) {
+        size_t n = ppg.size() - first < PPG_BLOCK ? ppg.size() - first : PPG_BLOCK;
+        for (size_t i = 0; i < n; i++) {
+            values[i] = ppg[first + i];
+            times[i] = ppgTimes[first + i];
+        }
+        filter.processBlock(values, values, n);
+        for (size_t i = 0; i < n; i++) history.add(values[i]);
+        handPulses += fiducials.processBlock(values, times, n, beats, 4);
+    }
+    double before = timer.seconds();
+
+    static Pipeline<BandpassStage<PPGDesign>, TapStage<TAP_FILTERED>, PulseFiducialStage> pipeline;
+    PPGEvents events = {history, 0};
+    timer.restart();
+    for (size_t first = 0; first < ppg.size(); first += PPG_BLOCK) {
+        size_t n = ppg.size() - first < PPG_BLOCK ? ppg.size() - first : PPG_BLOCK;
+        for (size_t i = 0; i < n; i++) {
+            values[i] = ppg[first + i];
+            times[i] = ppgTimes[first + i];
+        }
+        SampleBlock block = {values, times, n};
+        pipeline.process(block, events);
+    }
+    double after = timer.seconds();
+    benchSink = history.values[0];
+
+    benchReport("PPG hand-chained, 32-sample blocks", ppg.size(), before);
+    benchReport("PPG pipeline, 32-sample blocks", ppg.size(), after);
+    TEST_ASSERT_EQUAL_UINT32(handPulses, events.pulses);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_ecg_chain);
+    RUN_TEST(test_ppg_chain);
+    return UNITY_END();
+}
@@ -0,0 +1,200 @@
+// Host tests for the MAX30102 FIFO acquisition engine
+// Run with: pio test -e native -f test_ppg_acquisition
+
+#include <unity.h>
+#include <stdio.h>
+#include "sensors/ppg_acquisition.h"
+#include "../mocks/mock_max30102_bus.h"
+
+static const uint32_t SIM_STEP_US = 100;
+
+struct SimResult {
+    uint32_t received;
+    uint32_t sequenceErrors;
+    uint32_t maxTimestampErrorUs;
+    PPGAcquisitionStats stats;
+    uint32_t generated;
+    uint32_t lost;
+    uint32_t transactions;
+};
+
+// Simple deterministic jitter source for task wake-up latency
+static uint32_t lcg(uint32_t& state) {
+    state = state * 1664525UL + 1013904223UL;
+    return state >> 8;
+}
+
+// Simulates the acquisition task (woken by INT with jitter, fallback poll just
+// before the FIFO fills)
+// and a consumer that drains the ring every consumerPeriodUs.
+static SimResult simulate(uint16_t rateHz, uint32_t durationUs, uint32_t consumerPeriodUs,
+                          uint32_t maxLatencyUs, uint32_t stallFromUs = 0, uint32_t stallUs = 0,
+                          size_t burstLimit = 120) {
+    MockMAX30102Bus bus;
+    bus.burstLimit = burstLimit;
+    PPGAcquisition engine(bus);
+    bus.attachInterrupt(&engine);
+
+    SimResult result = {};
+    PPGAcquisitionConfig config;
+    config.sampleRateHz = rateHz;
+    if (!engine.begin(config)) {
+        result.stats.busErrors = 1;
+        return result;
+    }
+
+    uint32_t rngState = 12345;
+    uint32_t serviceAt = 0;
+    bool serviceScheduled = false;
+    uint32_t lastPoll = 0;
+    uint32_t nextConsume = consumerPeriodUs;
+    uint32_t expectedSequence = 0;
+    const uint32_t startUs = 1000;
+
+    bus.start(startUs);
+    PPGSample batch[64];
+
+    for (uint32_t now = startUs; now < startUs + durationUs; now += SIM_STEP_US) {
+        bus.advanceTo(now);
+
+        bool stalled = stallUs > 0 && now >= startUs + stallFromUs && now < startUs + stallFromUs + stallUs;
+
+        if (engine.isInterruptPending() && !serviceScheduled) {
+            serviceAt = now + (maxLatencyUs ? lcg(rngState) % maxLatencyUs : 0);
+            serviceScheduled = true;
+        }
+        bool pollDue = now - lastPoll >= engine.pollIntervalUs();
+        if (!stalled && ((serviceScheduled && (int32_t)(now - serviceAt) >= 0) || pollDue)) {
+            engine.service(now);
+            serviceScheduled = false;
+            lastPoll = now;
+        }
+
+        bool last = now + SIM_STEP_US >= startUs + durationUs;
+        if (last) {
+            engine.service(now);
+        }
+        if ((int32_t)(now - startUs - nextConsume) >= 0 || last) {
+            size_t n;
+            while ((n = engine.read(batch, 64)) > 0) {
+                for (size_t i = 0; i < n; i++) {
+                    uint32_t sequence = batch[i].ir;
+                    if (sequence != expectedSequence) result.sequenceErrors++;
+                    expectedSequence = sequence + 1;
+                    if (batch[i].red != MockMAX30102Bus::redFor(sequence)) result.sequenceErrors++;
+
+                    uint32_t truth = bus.sampleTimeUs(sequence);
+                    int32_t error = (int32_t)(batch[i].timestampUs - truth);
+                    uint32_t absError = error < 0 ? -error : error;
+                    if (absError > result.maxTimestampErrorUs) result.maxTimestampErrorUs = absError;
+                }
+                result.received += n;
+            }
+            nextConsume += consumerPeriodUs;
+        }
+    }
+
+    result.stats = engine.getStats();
+    result.generated = bus.generatedSamples;
+    result.lost = bus.lostSamples;
+    result.transactions = bus.transactions;
+    return result;
+}
+
+static void assertZeroDrop(uint16_t rateHz) {
+    const uint32_t duration = 60000000UL; // 60 s of streaming
+    SimResult r = simulate(rateHz, duration, 1000000UL, 3000);
+
+    TEST_ASSERT_EQUAL_UINT32(0, r.lost);
+    TEST_ASSERT_EQUAL_UINT32(0, r.stats.fifoOverflowSamples);
+    TEST_ASSERT_EQUAL_UINT32(0, r.stats.ringDrops);
+    TEST_ASSERT_EQUAL_UINT32(0, r.stats.busErrors);
+    TEST_ASSERT_EQUAL_UINT32(0, r.sequenceErrors);
+    TEST_ASSERT_EQUAL_UINT32(r.generated, r.received);
+    // Timestamps stay within one sample period of the true acquisition time
+    TEST_ASSERT_LESS_OR_EQUAL(1000000UL / rateHz, r.maxTimestampErrorUs);
+
+    char msg[160];
+    snprintf(msg, sizeof(msg), "%u Hz: %u samples, %u bursts (max %u), %.1f I2C transactions/s, max ts error %u us",
+             rateHz, r.received, r.stats.bursts, r.stats.maxBurstSamples,
+             r.transactions / (duration / 1e6), r.maxTimestampErrorUs);
+    TEST_MESSAGE(msg);
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_sustained_100hz_zero_drop() { assertZeroDrop(100); }
+void test_sustained_200hz_zero_drop() { assertZeroDrop(200); }
+void test_sustained_400hz_zero_drop() { assertZeroDrop(400); }
+
+void test_bursts_are_interrupt_sized() {
+    SimResult r = simulate(400, 10000000UL, 500000UL, 0);
+    // A_FULL fires with 15 free slots, so bursts drain ~17 samples, not 1
+    TEST_ASSERT_GREATER_OR_EQUAL(15, r.stats.samplesAcquired / r.stats.bursts);
+    TEST_ASSERT_LESS_OR_EQUAL(MAX30102Reg::FIFO_DEPTH, r.stats.maxBurstSamples);
+}
+
+void test_small_i2c_buffer_is_chunked() {
+    SimResult r = simulate(400, 5000000UL, 250000UL, 2000, 0, 0, 30);
+    TEST_ASSERT_EQUAL_UINT32(0, r.lost);
+    TEST_ASSERT_EQUAL_UINT32(0, r.sequenceErrors);
+    TEST_ASSERT_EQUAL_UINT32(0, r.stats.busErrors);
+}
+
+void test_overflow_is_reported_when_service_stalls() {
+    // 120 ms stall at 400 Hz overruns the 32-deep FIFO (80 ms)
+    SimResult r = simulate(400, 2000000UL, 100000UL, 0, 500000UL, 120000UL);
+    TEST_ASSERT_GREATER_THAN(0, r.lost);
+    TEST_ASSERT_EQUAL_UINT32(r.lost, r.stats.fifoOverflowSamples);
+}
+
+void test_ring_drops_when_consumer_starves() {
+    // Consumer only reads every 4 s at 400 Hz: 1600 samples > ring capacity
+    SimResult r = simulate(400, 4500000UL, 4000000UL, 0);
+    TEST_ASSERT_EQUAL_UINT32(0, r.lost);
+    TEST_ASSERT_GREATER_THAN(0, r.stats.ringDrops);
+}
+
+void test_reconfigure_drops_queued_samples_on_the_consumer_side() {
+    MockMAX30102Bus bus;
+    PPGAcquisition engine(bus);
+    PPGAcquisitionConfig config;
+    config.sampleRateHz = 200;
+    TEST_ASSERT_TRUE(engine.begin(config));
+    bus.start(1000);
+    bus.advanceTo(100000);
+    TEST_ASSERT_TRUE(engine.service(100000) > 0);
+
+    // The producer restarts the stream with those samples still unread
+    uint32_t firstNew = bus.generatedSamples;
+    TEST_ASSERT_TRUE(engine.begin(config));
+    bus.advanceTo(150000);
+    uint16_t fresh = engine.service(150000);
+    TEST_ASSERT_TRUE(fresh > 0);
+
+    PPGSample batch[64];
+    size_t total = 0;
+    size_t n;
+    while ((n = engine.read(batch, 64)) > 0) {
+        for (size_t i = 0; i < n; i++) {
+            TEST_ASSERT_TRUE(batch[i].ir >= firstNew);
+        }
+        total += n;
+    }
+    TEST_ASSERT_EQUAL_UINT32(fresh, total);
+    TEST_ASSERT_EQUAL_UINT32(0, engine.available());
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_sustained_100hz_zero_drop);
+    RUN_TEST(test_sustained_200hz_zero_drop);
+    RUN_TEST(test_sustained_400hz_zero_drop);
+    RUN_TEST(test_bursts_are_interrupt_sized);
+    RUN_TEST(test_small_i2c_buffer_is_chunked);
+    RUN_TEST(test_overflow_is_reported_when_service_stalls);
+    RUN_TEST(test_ring_drops_when_consumer_starves);
+    RUN_TEST(test_reconfigure_drops_queued_samples_on_the_consumer_side);
+    return UNITY_END();
+}
@@ -0,0 +1,171 @@
+// Host tests for the shared PPG stream fan-out
+// Run with: pio test -e native -f test_ppg_fanout
+
+#include <unity.h>
+#include "sensors/ppg_fanout.h"
+
+static const PPGLedRange RANGE = {50000, 140000, 10000, 200};
+
+struct RecordingConsumer {
+    uint32_t samples;
+    uint32_t nextSequence;
+    bool ordered;
+};
+
+static void record(void* context, const PPGSample* samples, size_t count) {
+    RecordingConsumer* consumer = static_cast<RecordingConsumer*>(context);
+    for (size_t i = 0; i < count; i++) {
+        if (samples[i].timestampUs != consumer->nextSequence * 5000ULL) consumer->ordered = false;
+        consumer->nextSequence++;
+    }
+    consumer->samples += count;
+}
+
+// Feeds `seconds` of 200 Hz samples in 32-sample batches, reconciling after
+// each batch like processPPGStream() does. The DC level follows the LED
+// current: ambient light plus a per-LSB gain times the programmed amplitude.
+static uint32_t stream(PPGFanout& fanout, uint32_t& sequence, float seconds,
+                       uint32_t irGain, uint32_t redGain, uint32_t ambient = 0) {
+    uint32_t restarts = 0;
+    uint32_t total = (uint32_t)(seconds * 200);
+    PPGSample batch[32];
+    for (uint32_t done = 0; done < total; done += 32) {
+        const PPGStreamProfile& current = fanout.getProfile();
+        for (int i = 0; i < 32; i++) {
+            batch[i].ir = ambient + irGain * current.irAmplitude + (sequence % 7);
+            batch[i].red = ambient + redGain * current.redAmplitude + (sequence % 5);
+            batch[i].timestampUs = sequence * 5000ULL;
+            sequence++;
+        }
+        fanout.dispatch(batch, 32);
+        PPGStreamProfile profile;
+        if (fanout.reconcile(profile)) restarts++;
+    }
+    return restarts;
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_every_consumer_sees_the_whole_stream() {
+    PPGFanout fanout;
+    RecordingConsumer heartRate = {0, 0, true};
+    RecordingConsumer glucose = {0, 0, true};
+    RecordingConsumer bloodPressure = {0, 0, true};
+    fanout.addConsumer("heart_rate", record, &heartRate, 100);
+    fanout.addConsumer("glucose", record, &glucose, 50);
+    fanout.addConsumer("blood_pressure", record, &bloodPressure, 200);
+    fanout.begin({200, 0x0A, 0x1F}, RANGE);
+
+    uint32_t sequence = 0;
+    uint32_t restarts = stream(fanout, sequence, 75, 3000, 8000);   // ~93000 / 80000 DC
+
+    // All three metrics got the full 75 s, where mode cycling gave each 15-30 s of it
+    TEST_ASSERT_EQUAL_UINT32(sequence, heartRate.samples);
+    TEST_ASSERT_EQUAL_UINT32(sequence, glucose.samples);
+    TEST_ASSERT_EQUAL_UINT32(sequence, bloodPressure.samples);
+    TEST_ASSERT_TRUE(heartRate.ordered && glucose.ordered && bloodPressure.ordered);
+    TEST_ASSERT_EQUAL_UINT32(0, restarts);
+    TEST_ASSERT_EQUAL_UINT32(0, fanout.reconfigurationCount());
+}
+
+void test_disabled_consumer_is_skipped() {
+    PPGFanout fanout;
+    RecordingConsumer a = {0, 0, true};
+    RecordingConsumer b = {0, 0, true};
+    int idA = fanout.addConsumer("a", record, &a);
+    int idB = fanout.addConsumer("b", record, &b);
+    fanout.setEnabled(idB, false);
+
+    uint32_t sequence = 0;
+    stream(fanout, sequence, 1, 3000, 3000);
+    TEST_ASSERT_EQUAL_UINT32(sequence, a.samples);
+    TEST_ASSERT_EQUAL_UINT32(0, b.samples);
+    TEST_ASSERT_EQUAL_UINT32(sequence, fanout.getStats(idA).samples);
+    TEST_ASSERT_FALSE(fanout.getStats(idB).enabled);
+}
+
+void test_saturating_dc_lowers_led_current_once() {
+    PPGFanout fanout;
+    RecordingConsumer c = {0, 0, true};
+    fanout.addConsumer("c", record, &c);
+    fanout.begin({200, 0x1F, 0x1F}, RANGE);
+
+    uint32_t sequence = 0;
+    // IR sits at ~186000 (above the glucose saturation limit), red at ~90000
+    uint32_t restarts = stream(fanout, sequence, 20, 6000, 2900);
+    TEST_ASSERT_EQUAL_UINT32(1, restarts);
+
+    // IR scaled towards mid-range (0x1F * 95000 / 186000), red left alone
+    const PPGStreamProfile& profile = fanout.getProfile();
+    TEST_ASSERT_EQUAL_UINT8(15, profile.irAmplitude);
+    TEST_ASSERT_EQUAL_UINT8(0x1F, profile.redAmplitude);
+    TEST_ASSERT_EQUAL_UINT16(200, profile.sampleRateHz);
+}
+
+void test_weak_signal_raises_current_but_no_contact_does_not() {
+    PPGFanout fanout;
+    RecordingConsumer c = {0, 0, true};
+    fanout.addConsumer("c", record, &c);
+    fanout.begin({200, 0x0A, 0x0A}, RANGE);
+
+    uint32_t sequence = 0;
+    // Nothing on the sensor: ambient light only
+    uint32_t restarts = stream(fanout, sequence, 5, 0, 0, 3000);
+    TEST_ASSERT_EQUAL_UINT32(0, restarts);
+
+    // Finger placed but dim (~25000 IR, ~30000 red). The window straddling the
+    // placement may take one extra step; after that the stream is left alone.
+    restarts = stream(fanout, sequence, 20, 2500, 3000);
+    TEST_ASSERT_GREATER_OR_EQUAL(1, restarts);
+    TEST_ASSERT_LESS_OR_EQUAL(2, restarts);
+    uint32_t irDc = 2500 * fanout.getProfile().irAmplitude;
+    uint32_t redDc = 3000 * fanout.getProfile().redAmplitude;
+    TEST_ASSERT_TRUE(irDc >= RANGE.dcLow && irDc <= RANGE.dcHigh);
+    TEST_ASSERT_TRUE(redDc >= RANGE.dcLow && redDc <= RANGE.dcHigh);
+    TEST_ASSERT_EQUAL_UINT32(0, stream(fanout, sequence, 20, 2500, 3000));
+}
+
+void test_sample_rate_only_rises_for_a_consumer_that_needs_it() {
+    PPGFanout fanout;
+    RecordingConsumer slow = {0, 0, true};
+    RecordingConsumer fast = {0, 0, true};
+    fanout.addConsumer("slow", record, &slow, 100);
+    int fastId = fanout.addConsumer("fast", record, &fast, 400);
+    fanout.setEnabled(fastId, false);
+    fanout.begin({200, 0x1F, 0x1F}, RANGE);
+
+    PPGStreamProfile profile;
+    TEST_ASSERT_FALSE(fanout.reconcile(profile));
+
+    fanout.setEnabled(fastId, true);
+    TEST_ASSERT_TRUE(fanout.reconcile(profile));
+    TEST_ASSERT_EQUAL_UINT16(400, profile.sampleRateHz);
+    TEST_ASSERT_FALSE(fanout.reconcile(profile));
+
+    // Dropping the fast consumer is not worth a restart
+    fanout.setEnabled(fastId, false);
+    TEST_ASSERT_FALSE(fanout.reconcile(profile));
+    TEST_ASSERT_EQUAL_UINT16(400, fanout.getProfile().sampleRateHz);
+}
+
+void test_consumer_table_limit() {
+    PPGFanout fanout;
+    RecordingConsumer c = {0, 0, true};
+    for (int i = 0; i < PPGFanout::MAX_CONSUMERS; i++) {
+        TEST_ASSERT_EQUAL(i, fanout.addConsumer("c", record, &c));
+    }
+    TEST_ASSERT_EQUAL(-1, fanout.addConsumer("overflow", record, &c));
+    TEST_ASSERT_EQUAL(-1, PPGFanout().addConsumer("null", nullptr, &c));
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_every_consumer_sees_the_whole_stream);
+    RUN_TEST(test_disabled_consumer_is_skipped);
+    RUN_TEST(test_saturating_dc_lowers_led_current_once);
+    RUN_TEST(test_weak_signal_raises_current_but_no_contact_does_not);
+    RUN_TEST(test_sample_rate_only_rises_for_a_consumer_that_needs_it);
+    RUN_TEST(test_consumer_table_limit);
+    return UNITY_END();
+}
@@ -0,0 +1,221 @@
+// Host tests for the PPG foot / max-slope / peak fiducial detector
+// Run with: pio test -e native -f test_ppg_fiducials
+
+#include <unity.h>
+#include <stdio.h>
+#include <math.h>
+#include <vector>
+#include "dsp/ppg_fiducials.h"
+#include "../mocks/synthetic_ppg.h"
+
+struct Matched {
+    int beats;                  // Detected beats matched to an onset
+    int extra;                  // Detected beats with no onset near them
+    double worstErrorUs[3];     // Per fiducial, against the exact position
+};
+
+// Runs the train with systole rising (negated IR counts) and matches each
+// beat to the onset 0-300 ms before its foot estimate
+static Matched runTrain(SyntheticPPG& train, double seconds, PulseFiducialDetector& detector,
+                        std::vector<PulseFiducials>* out = nullptr) {
+    Matched result = {0, 0, {0, 0, 0}};
+    uint32_t total = (uint32_t)(seconds * train.sampleRateHz);
+    for (uint32_t n = 0; n < total; n++) {
+        PulseFiducials beat;
+        if (!detector.addSample((float)-train.sample(n), SyntheticPPG::timeUs(n, train.sampleRateHz), beat)) {
+            continue;
+        }
+        if (out) out->push_back(beat);
+        bool matched = false;
+        for (double onset : train.onsets) {
+            double onsetUs = 1e6 + onset * 1e6;
+            double expected[3] = {onsetUs + SyntheticPPG::footOffset(train.riseSeconds) * 1e6,
+                                  onsetUs + train.riseSeconds * 0.5e6, onsetUs + train.riseSeconds * 1e6};
+            if (fabs((double)beat.footUs - expected[0]) < 30000) {
+                matched = true;
+                for (int f = 0; f < 3; f++) {
+                    double error = fabs((double)beat.timeOf((PulseFiducial)f) - expected[f]);
+                    if (error > result.worstErrorUs[f]) result.worstErrorUs[f] = error;
+                }
+            }
+        }
+        if (matched) result.beats++;
+        else result.extra++;
+    }
+    return result;
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_fiducials_land_on_the_known_positions() {
+    const uint32_t rates[3] = {100, 200, 400};
+    for (uint32_t rate : rates) {
+        SyntheticPPG train(rate);
+        train.regularOnsets(0.31, 0.82, 0.05, 30);
+        PulseFiducialDetector detector;
+        Matched result = runTrain(train, 30, detector);
+
+        // Every beat after the 1.5 s learning phase except the last one, which is still rising
+        TEST_ASSERT_EQUAL(0, result.extra);
+        TEST_ASSERT_GREATER_OR_EQUAL((int)train.onsets.size() - 3, result.beats);
+
+        char line[96];
+        snprintf(line, sizeof(line), "%3u Hz worst error: foot %.0f us, max slope %.0f us, peak %.0f us", rate,
+                 result.worstErrorUs[0], result.worstErrorUs[1], result.worstErrorUs[2]);
+        TEST_MESSAGE(line);
+
+        // Foot and max slope well inside one sample period (10 ms at 100 Hz);
+        // the peak, where the rise meets the runoff, can be off by up to a sample
+        double period = 1e6 / rate;
+        TEST_ASSERT_LESS_THAN(0.25 * period, result.worstErrorUs[(int)PulseFiducial::FOOT]);
+        TEST_ASSERT_LESS_THAN(0.1 * period, result.worstErrorUs[(int)PulseFiducial::MAX_SLOPE]);
+        TEST_ASSERT_LESS_THAN(period, result.worstErrorUs[(int)PulseFiducial::PEAK]);
+    }
+}
+
+void test_beat_fields_are_filled() {
+    SyntheticPPG train(200);
+    train.regularOnsets(0.2, 1.0, 0, 8);
+    PulseFiducialDetector detector;
+    std::vector<PulseFiducials> beats;
+    runTrain(train, 8, detector, &beats);
+
+    TEST_ASSERT_GREATER_OR_EQUAL(5, (int)beats.size());
+    for (const PulseFiducials& beat : beats) {
+        TEST_ASSERT_TRUE(beat.footUs < beat.maxSlopeUs && beat.maxSlopeUs < beat.peakUs);
+        TEST_ASSERT_FLOAT_WITHIN(20.0f, 1500.0f, beat.amplitude());
+        // Half-cosine: A * pi / (2 * rise) counts per second
+        TEST_ASSERT_FLOAT_WITHIN(500.0f, (float)(1500 * M_PI / 0.24), beat.maxSlope);
+        TEST_ASSERT_EQUAL_UINT64(beat.peakUs, beat.timeOf(PulseFiducial::PEAK));
+    }
+    TEST_ASSERT_EQUAL((int)beats.size(), (int)detector.getBeatCount());
+}
+
+void test_tall_dicrotic_wave_is_one_beat() {
+    SyntheticPPG train(200);
+    train.dicroticFraction = 0.4;
+    train.regularOnsets(0.2, 0.9, 0, 20);
+    PulseFiducialDetector detector;
+    Matched result = runTrain(train, 20, detector);
+    TEST_ASSERT_EQUAL(0, result.extra);
+    TEST_ASSERT_GREATER_OR_EQUAL((int)train.onsets.size() - 3, result.beats);
+}
+
+void test_block_matches_per_sample() {
+    SyntheticPPG train(400);
+    train.noiseCounts = 20;
+    train.regularOnsets(0.1, 0.7, 0.04, 12);
+    uint32_t total = 12 * 400;
+    std::vector<float> values(total);
+    std::vector<uint64_t> times(total);
+    for (uint32_t n = 0; n < total; n++) {
+        values[n] = (float)-train.sample(n);
+        times[n] = SyntheticPPG::timeUs(n, 400);
+    }
+
+    PulseFiducialDetector single;
+    std::vector<PulseFiducials> expected;
+    for (uint32_t n = 0; n < total; n++) {
+        PulseFiducials beat;
+        if (single.addSample(values[n], times[n], beat)) expected.push_back(beat);
+    }
+
+    // 32-sample bursts, as the MAX30102 FIFO delivers them
+    PulseFiducialDetector blocks;
+    std::vector<PulseFiducials> actual;
+    PulseFiducials found[4];
+    for (uint32_t n = 0; n < total; n += 32) {
+        size_t count = blocks.processBlock(&values[n], &times[n], 32, found, 4);
+        actual.insert(actual.end(), found, found + count);
+    }
+
+    TEST_ASSERT_GREATER_THAN(10, (int)expected.size());
+    TEST_ASSERT_EQUAL((int)expected.size(), (int)actual.size());
+    for (size_t i = 0; i < expected.size(); i++) {
+        TEST_ASSERT_EQUAL_UINT64(expected[i].footUs, actual[i].footUs);
+        TEST_ASSERT_EQUAL_UINT64(expected[i].maxSlopeUs, actual[i].maxSlopeUs);
+        TEST_ASSERT_EQUAL_UINT64(expected[i].peakUs, actual[i].peakUs);
+    }
+}
+
+void test_smaller_pulses_are_picked_up_again() {
+    SyntheticPPG train(200);
+    train.regularOnsets(0.2, 0.8, 0, 40);
+    // Finger pressure drops the pulse to 20% after 15 s
+    for (double onset : train.onsets) {
+        train.amplitudeScale.push_back(onset < 15 ? 1.0 : 0.2);
+    }
+    PulseFiducialDetector detector;
+    std::vector<PulseFiducials> beats;
+    runTrain(train, 40, detector, &beats);
+
+    int late = 0;
+    for (const PulseFiducials& beat : beats) {
+        if (beat.footUs > 1000000 + 25000000ULL) {
+            late++;
+            TEST_ASSERT_FLOAT_WITHIN(20.0f, 300.0f, beat.amplitude());
+        }
+    }
+    // 25-40 s holds 18 onsets
+    TEST_ASSERT_GREATER_OR_EQUAL(16, late);
+}
+
+void test_uneven_sample_spacing_uses_real_times() {
+    // Same pulses, but every 32nd sample arrives 1 ms late (FIFO read jitter
+    // already folded into the timestamps): fiducials still land on the pulse
+    SyntheticPPG train(200);
+    train.regularOnsets(0.2, 0.8, 0, 10);
+    PulseFiducialDetector detector;
+    int checked = 0;
+    for (uint32_t n = 0; n < 2000; n++) {
+        double t = n / 200.0 + ((n % 32) == 31 ? 0.001 : 0.0);
+        PulseFiducials beat;
+        if (detector.addSample((float)-train.valueAt(t), 1000000ULL + (uint64_t)(t * 1e6 + 0.5), beat)) {
+            double onsetUs = 0;
+            for (double onset : train.onsets) {
+                if (fabs(1e6 + onset * 1e6 - (double)beat.maxSlopeUs) < 100000) onsetUs = 1e6 + onset * 1e6;
+            }
+            TEST_ASSERT_TRUE(onsetUs > 0);
+            TEST_ASSERT_FLOAT_WITHIN(1000.0, onsetUs + 60000, (double)beat.maxSlopeUs);
+            checked++;
+        }
+    }
+    TEST_ASSERT_GREATER_OR_EQUAL(8, checked);
+}
+
+void test_stream_rate_change_keeps_timing() {
+    // The fan-out can move the stream from 200 to 400 Hz mid-recording
+    SyntheticPPG train(200);
+    train.regularOnsets(0.2, 0.8, 0, 20);
+    PulseFiducialDetector detector;
+    int checked = 0;
+    double t = 0;
+    while (t < 20) {
+        PulseFiducials beat;
+        if (detector.addSample((float)-train.valueAt(t), 1000000ULL + (uint64_t)(t * 1e6 + 0.5), beat)) {
+            double nearest = 1e9;
+            for (double onset : train.onsets) {
+                double expectedUs = 1e6 + (onset + train.riseSeconds / 2) * 1e6;
+                if (fabs(expectedUs - (double)beat.maxSlopeUs) < fabs(nearest)) nearest = expectedUs - (double)beat.maxSlopeUs;
+            }
+            TEST_ASSERT_FLOAT_WITHIN(200.0, 0.0, nearest);
+            TEST_ASSERT_FLOAT_WITHIN(500.0f, (float)(1500 * M_PI / 0.24), beat.maxSlope);
+            checked++;
+        }
+        t += t < 10 ? 1.0 / 200 : 1.0 / 400;
+    }
+    TEST_ASSERT_GREATER_OR_EQUAL(20, checked);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_fiducials_land_on_the_known_positions);
+    RUN_TEST(test_beat_fields_are_filled);
+    RUN_TEST(test_tall_dicrotic_wave_is_one_beat);
+    RUN_TEST(test_block_matches_per_sample);
+    RUN_TEST(test_smaller_pulses_are_picked_up_again);
+    RUN_TEST(test_uneven_sample_spacing_uses_real_times);
+    RUN_TEST(test_stream_rate_change_keeps_timing);
+    return UNITY_END();
+}
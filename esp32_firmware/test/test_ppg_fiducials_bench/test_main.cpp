@@ -0,0 +1,118 @@
+// Fiducial timing jitter and per-sample cost on synthetic pulses with known onsets
+// Run with: pio test -e native -f test_ppg_fiducials_bench -v   (-v shows the numbers)
+
+#include <unity.h>
+#include <stdio.h>
+#include <math.h>
+#include <vector>
+#include "dsp/ppg_fiducials.h"
+#include "dsp/bandpass_designs.h"
+#include "../mocks/synthetic_ppg.h"
+#include "../mocks/bench_util.h"
+
+static const uint32_t RATE = 400;           // MAX30102 FIFO burst rate
+static const double SECONDS = 600;
+static const int BLOCK = 32;
+
+static std::vector<float> values;           // Band-passed, systole rising
+static std::vector<uint64_t> times;
+static SyntheticPPG train(RATE);
+
+// Ten minutes at 72 BPM with RR variation, sensor noise and a reflected wave
+// that changes from beat to beat (vascular tone), through the same 0.5-8 Hz
+// band-pass as BloodPressureMonitor
+void setUp() {
+    if (!values.empty()) return;
+    train.noiseCounts = 40;
+    train.regularOnsets(0.4, 0.83, 0.06, SECONDS);
+    for (size_t b = 0; b < train.onsets.size(); b++) {
+        train.reflection.push_back(0.15 + 0.15 * sin(b * 0.7) * cos(b * 0.13));
+    }
+    BiquadCascade<PPGBandpass<RATE>::SECTIONS> filter(PPGBandpass<RATE>::coeffs);
+    uint32_t total = (uint32_t)(SECONDS * RATE);
+    values.resize(total);
+    times.resize(total);
+    for (uint32_t n = 0; n < total; n++) {
+        float raw = (float)-train.sample(n);
+        if (n == 0) filter.prime(raw);
+        values[n] = filter.process(raw);
+        times[n] = SyntheticPPG::timeUs(n, RATE);
+    }
+}
+void tearDown() {}
+
+void test_bench_fiducial_jitter() {
+    PulseFiducialDetector detector;
+    std::vector<PulseFiducials> beats;
+    PulseFiducials found[4];
+    for (size_t n = 0; n + BLOCK <= values.size(); n += BLOCK) {
+        size_t count = detector.processBlock(&values[n], &times[n], BLOCK, found, 4);
+        beats.insert(beats.end(), found, found + count);
+    }
+
+    // Error against the exact fiducial of the nearest onset; the mean is the
+    // band-pass group delay (a constant, taken up by calibration), the
+    // spread is what PTT sees beat to beat
+    const double offsets[3] = {SyntheticPPG::footOffset(train.riseSeconds), train.riseSeconds / 2, train.riseSeconds};
+    double sum[3] = {0, 0, 0};
+    double sumSquares[3] = {0, 0, 0};
+    int matched = 0;
+    size_t onset = 0;
+    for (const PulseFiducials& beat : beats) {
+        double maxSlopeS = (beat.maxSlopeUs - 1000000.0) / 1e6;
+        while (onset + 1 < train.onsets.size() && train.onsets[onset + 1] + offsets[1] < maxSlopeS + 0.3) onset++;
+        if (fabs(train.onsets[onset] + offsets[1] - maxSlopeS) > 0.1) continue;
+        matched++;
+        for (int f = 0; f < 3; f++) {
+            double error = (beat.timeOf((PulseFiducial)f) - 1000000.0) / 1e3 - (train.onsets[onset] + offsets[f]) * 1e3;
+            sum[f] += error;
+            sumSquares[f] += error * error;
+        }
+    }
+
+    char line[128];
+    snprintf(line, sizeof(line), "%d of %d beats matched (%u Hz, noise %.0f counts on %.0f)",
+             matched, (int)train.onsets.size(), RATE, train.noiseCounts, train.amplitudeCounts);
+    TEST_MESSAGE(line);
+    double deviation[3];
+    for (int f = 0; f < 3; f++) {
+        double mean = sum[f] / matched;
+        deviation[f] = sqrt(sumSquares[f] / matched - mean * mean);
+        snprintf(line, sizeof(line), "%-10s  delay %6.2f ms  jitter (SD) %5.3f ms",
+                 pulseFiducialName((PulseFiducial)f), mean, deviation[f]);
+        TEST_MESSAGE(line);
+    }
+    TEST_ASSERT_GREATER_OR_EQUAL((int)train.onsets.size() - 4, matched);
+    // The reflected wave moves the peak; the upstroke fiducials stay put. The
+    // foot also follows the band-passed diastolic level, which RR changes move.
+    TEST_ASSERT_LESS_THAN(0.6 * deviation[(int)PulseFiducial::PEAK], deviation[(int)PulseFiducial::MAX_SLOPE]);
+    TEST_ASSERT_LESS_THAN(3.0, deviation[(int)PulseFiducial::FOOT]);
+}
+
+void test_bench_throughput() {
+    PulseFiducialDetector single;
+    PulseFiducials beat;
+    uint32_t beats = 0;
+    BenchTimer timer;
+    for (size_t n = 0; n < values.size(); n++) {
+        beats += single.addSample(values[n], times[n], beat);
+    }
+    benchReport("per sample", values.size(), timer.seconds());
+
+    PulseFiducialDetector blocks;
+    PulseFiducials found[4];
+    uint32_t blockBeats = 0;
+    timer.restart();
+    for (size_t n = 0; n + BLOCK <= values.size(); n += BLOCK) {
+        blockBeats += blocks.processBlock(&values[n], &times[n], BLOCK, found, 4);
+    }
+    benchReport("blocks of 32 (FIFO burst)", values.size(), timer.seconds());
+    TEST_ASSERT_EQUAL(beats, blockBeats);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_bench_fiducial_jitter);
+    RUN_TEST(test_bench_throughput);
+    return UNITY_END();
+}
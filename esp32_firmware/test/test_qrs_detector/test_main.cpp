@@ -0,0 +1,342 @@
+// Host tests for the streaming Pan-Tompkins QRS detector
+// Run with: pio test -e native -f test_qrs_detector -v   (-v shows Se/PPV and throughput per record)
+//
+// Every <name>.csv in test/data/ecg (or $ECG_RECORD_DIR) with a matching
+// <name>.ann is replayed through the detector; see test/data/ecg/README.md.
+
+#include <unity.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <dirent.h>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include "dsp/qrs_detector.h"
+
+static const char* DEFAULT_RECORD_DIR = "test/data/ecg";
+
+struct Record {
+    std::string name;
+    uint32_t sampleRateHz;
+    std::vector<float> samples;
+    std::vector<uint32_t> beats;    // Annotated R-peak sample indices
+};
+
+static bool loadRecord(const std::string& dir, const std::string& name, Record& record) {
+    record.name = name;
+    record.sampleRateHz = 0;
+    record.samples.clear();
+    record.beats.clear();
+
+    FILE* csv = fopen((dir + "/" + name + ".csv").c_str(), "r");
+    if (!csv) return false;
+    char line[128];
+    while (fgets(line, sizeof(line), csv)) {
+        if (line[0] == '#') {
+            const char* rate = strstr(line, "sample_rate_hz=");
+            if (rate) record.sampleRateHz = (uint32_t)atoi(rate + 15);
+        } else if (line[0] != '\n' && line[0] != '\r') {
+            record.samples.push_back((float)atof(line));
+        }
+    }
+    fclose(csv);
+
+    FILE* ann = fopen((dir + "/" + name + ".ann").c_str(), "r");
+    if (!ann) return false;
+    while (fgets(line, sizeof(line), ann)) {
+        if (line[0] != '#' && line[0] != '\n') record.beats.push_back((uint32_t)atol(line));
+    }
+    fclose(ann);
+    return record.sampleRateHz > 0 && !record.samples.empty();
+}
+
+static std::vector<std::string> listRecords(const std::string& dir) {
+    std::vector<std::string> names;
+    DIR* d = opendir(dir.c_str());
+    if (!d) return names;
+    while (struct dirent* e = readdir(d)) {
+        std::string file = e->d_name;
+        if (file.size() > 4 && file.compare(file.size() - 4, 4, ".csv") == 0) {
+            names.push_back(file.substr(0, file.size() - 4));
+        }
+    }
+    closedir(d);
+    std::sort(names.begin(), names.end());
+    return names;
+}
+
+static uint64_t sampleTimeUs(uint32_t index, uint32_t rateHz) {
+    return 1000000ULL + (uint64_t)index * 1000000ULL / rateHz;
+}
+
+// The 0.5-40 Hz front end the firmware runs before the detector, designed at
+// the record's rate
+struct FrontEndDesign {
+    BiquadCoeffs coeffs[3];
+
+    explicit FrontEndDesign(uint32_t rateHz) {
+        coeffs[0] = BiquadDesign::highpass(0.5, rateHz, BiquadDesign::butterworthQ(2, 0));
+        coeffs[1] = BiquadDesign::lowpass(40.0, rateHz, BiquadDesign::butterworthQ(4, 0));
+        coeffs[2] = BiquadDesign::lowpass(40.0, rateHz, BiquadDesign::butterworthQ(4, 1));
+    }
+};
+
+struct FrontEnd : FrontEndDesign {
+    BiquadCascade<3> filter;
+    bool primed;
+
+    explicit FrontEnd(uint32_t rateHz) : FrontEndDesign(rateHz), filter(coeffs), primed(false) {}
+    float process(float x) {
+        if (!primed) {
+            filter.prime(x);
+            primed = true;
+        }
+        return filter.process(x);
+    }
+};
+
+struct Score {
+    int truePositives;
+    int falseNegatives;
+    int falsePositives;
+    double meanAbsErrorMs;
+    double samplesPerSecond;
+    int searchBacks;
+};
+
+// Beat-by-beat comparison with a 150 ms match window (ANSI/AAMI EC57);
+// annotations inside the two-second learning phase are not scored
+static Score scoreRecord(const Record& record) {
+    std::vector<float> filtered(record.samples.size());
+    FrontEnd frontEnd(record.sampleRateHz);
+    for (size_t i = 0; i < record.samples.size(); i++) {
+        filtered[i] = frontEnd.process(record.samples[i]);
+    }
+
+    QrsDetector detector(record.sampleRateHz);
+    std::vector<QrsEvent> events;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < filtered.size(); i++) {
+        QrsEvent event;
+        if (detector.addSample(filtered[i], sampleTimeUs(i, record.sampleRateHz), event)) {
+            events.push_back(event);
+        }
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    Score score = {0, 0, 0, 0, filtered.size() / seconds, 0};
+    const uint64_t windowUs = 150000;
+    const uint64_t scoredFromUs = sampleTimeUs(2 * record.sampleRateHz, record.sampleRateHz);
+    const uint64_t endUs = sampleTimeUs(record.samples.size(), record.sampleRateHz) - 300000;  // Not yet confirmable
+    std::vector<bool> used(events.size(), false);
+    double errorSum = 0;
+
+    for (uint32_t beat : record.beats) {
+        uint64_t beatUs = sampleTimeUs(beat, record.sampleRateHz);
+        if (beatUs < scoredFromUs || beatUs > endUs) continue;
+        int match = -1;
+        uint64_t bestDistance = windowUs + 1;
+        for (size_t e = 0; e < events.size(); e++) {
+            uint64_t distance = events[e].timeUs > beatUs ? events[e].timeUs - beatUs : beatUs - events[e].timeUs;
+            if (!used[e] && distance <= bestDistance) {
+                bestDistance = distance;
+                match = (int)e;
+            }
+        }
+        if (match >= 0) {
+            used[match] = true;
+            score.truePositives++;
+            errorSum += bestDistance / 1000.0;
+            if (events[match].searchBack) score.searchBacks++;
+        } else {
+            score.falseNegatives++;
+        }
+    }
+    for (size_t e = 0; e < events.size(); e++) {
+        if (!used[e] && events[e].timeUs >= scoredFromUs + windowUs && events[e].timeUs <= endUs) {
+            score.falsePositives++;
+        }
+    }
+    score.meanAbsErrorMs = score.truePositives ? errorSum / score.truePositives : 0;
+    return score;
+}
+
+// ---- Synthetic beats for the unit tests ----
+
+static float gaussian(float x, float amplitude, float sigma) {
+    return amplitude * expf(-x * x / (2 * sigma * sigma));
+}
+
+// R-wave plus a T-wave of tRatio * R, at 250 Hz, in front-end units
+static float beatShape(float secondsFromR, float rAmplitude, float tRatio) {
+    return gaussian(secondsFromR, rAmplitude, 0.011f) + gaussian(secondsFromR - 0.03f, -0.25f * rAmplitude, 0.01f) +
+           gaussian(secondsFromR - 0.28f, tRatio * rAmplitude, 0.045f);
+}
+
+struct BeatTrain {
+    std::vector<double> beatTimes;
+    std::vector<float> amplitudes;
+    float tRatio;
+};
+
+static std::vector<QrsEvent> run(QrsDetector& detector, const BeatTrain& train, double seconds) {
+    std::vector<QrsEvent> events;
+    uint32_t total = (uint32_t)(seconds * 250);
+    for (uint32_t n = 0; n < total; n++) {
+        double t = n / 250.0;
+        float value = 0;
+        for (size_t b = 0; b < train.beatTimes.size(); b++) {
+            double d = t - train.beatTimes[b];
+            if (d > -0.3 && d < 0.6) value += beatShape((float)d, train.amplitudes[b], train.tRatio);
+        }
+        QrsEvent event;
+        if (detector.addSample(value, sampleTimeUs(n, 250), event)) events.push_back(event);
+    }
+    return events;
+}
+
+static BeatTrain regularTrain(double rrSeconds, double seconds, float amplitude, float tRatio) {
+    BeatTrain train;
+    train.tRatio = tRatio;
+    for (double t = 0.5; t < seconds; t += rrSeconds) {
+        train.beatTimes.push_back(t);
+        train.amplitudes.push_back(amplitude);
+    }
+    return train;
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_regular_rhythm_gives_exact_rr_and_heart_rate() {
+    QrsDetector detector(250);
+    BeatTrain train = regularTrain(0.8137, 30, 400, 0.3f);
+    std::vector<QrsEvent> events = run(detector, train, 30);
+
+    // Everything after the 2 s learning phase, apart from the last unconfirmed beat
+    TEST_ASSERT_GREATER_OR_EQUAL(32, (int)events.size());
+    for (size_t i = 1; i < events.size(); i++) {
+        TEST_ASSERT_FLOAT_WITHIN(1.0f, 813.7f, events[i].rrMs);
+        TEST_ASSERT_FALSE(events[i].searchBack);
+        TEST_ASSERT_FLOAT_WITHIN(40.0f, 400.0f, events[i].amplitude);
+    }
+    TEST_ASSERT_FLOAT_WITHIN(0.2f, 60.0f / 0.8137f, detector.getHeartRate());
+    // Sub-sample timing on a 4 ms grid
+    double expectedUs = 1000000.0 + train.beatTimes[train.beatTimes.size() / 2] * 1e6;
+    bool found = false;
+    for (const QrsEvent& e : events) {
+        if (fabs((double)e.timeUs - expectedUs) < 1000.0) found = true;
+    }
+    TEST_ASSERT_TRUE(found);
+}
+
+void test_inverted_lead_is_detected() {
+    QrsDetector detector(250);
+    std::vector<QrsEvent> events = run(detector, regularTrain(0.9, 20, -350, 0.3f), 20);
+    TEST_ASSERT_GREATER_OR_EQUAL(18, (int)events.size());
+    TEST_ASSERT_LESS_THAN(-300.0f, events.back().amplitude);
+}
+
+void test_tall_t_waves_are_not_beats() {
+    QrsDetector detector(250);
+    // T-wave 60% of the R-wave, 280 ms after it
+    std::vector<QrsEvent> events = run(detector, regularTrain(1.0, 30, 400, 0.6f), 30);
+    TEST_ASSERT_GREATER_OR_EQUAL(26, (int)events.size());
+    TEST_ASSERT_LESS_OR_EQUAL(28, (int)events.size());
+    for (size_t i = 1; i < events.size(); i++) {
+        TEST_ASSERT_FLOAT_WITHIN(5.0f, 1000.0f, events[i].rrMs);
+    }
+}
+
+void test_search_back_recovers_a_small_beat() {
+    QrsDetector detector(250);
+    BeatTrain train = regularTrain(0.85, 30, 400, 0.25f);
+    train.amplitudes[20] = 160;     // One beat at 40% amplitude (16% of the integral), e.g. a lead lifting
+    std::vector<QrsEvent> events = run(detector, train, 30);
+
+    double smallUs = 1000000.0 + train.beatTimes[20] * 1e6;
+    int recovered = 0;
+    for (const QrsEvent& e : events) {
+        if (fabs((double)e.timeUs - smallUs) < 10000.0) {
+            recovered++;
+            TEST_ASSERT_TRUE(e.searchBack);
+        }
+    }
+    TEST_ASSERT_EQUAL(1, recovered);
+}
+
+void test_instances_do_not_share_state() {
+    QrsDetector alone(250);
+    QrsDetector a(250);
+    QrsDetector b(250);
+    BeatTrain train = regularTrain(0.75, 12, 300, 0.3f);
+    std::vector<QrsEvent> expected = run(alone, train, 12);
+
+    // b gets noise interleaved with a's samples
+    std::vector<QrsEvent> actual;
+    uint32_t total = 12 * 250;
+    for (uint32_t n = 0; n < total; n++) {
+        double t = n / 250.0;
+        float value = 0;
+        for (size_t k = 0; k < train.beatTimes.size(); k++) {
+            double d = t - train.beatTimes[k];
+            if (d > -0.3 && d < 0.6) value += beatShape((float)d, train.amplitudes[k], train.tRatio);
+        }
+        QrsEvent event;
+        if (a.addSample(value, sampleTimeUs(n, 250), event)) actual.push_back(event);
+        b.addSample((float)((n * 7919) % 200) - 100.0f, sampleTimeUs(n, 250), event);
+    }
+    TEST_ASSERT_EQUAL((int)expected.size(), (int)actual.size());
+    for (size_t i = 0; i < expected.size(); i++) {
+        TEST_ASSERT_EQUAL_UINT64(expected[i].timeUs, actual[i].timeUs);
+    }
+}
+
+void test_recorded_ecg_files() {
+    const char* env = getenv("ECG_RECORD_DIR");
+    std::string dir = env ? env : DEFAULT_RECORD_DIR;
+    std::vector<std::string> names = listRecords(dir);
+    TEST_ASSERT_TRUE_MESSAGE(!names.empty(), "No ECG records found");
+
+    Score total = {0, 0, 0, 0, 0, 0};
+    for (const std::string& name : names) {
+        Record record;
+        TEST_ASSERT_TRUE_MESSAGE(loadRecord(dir, name, record), name.c_str());
+        Score s = scoreRecord(record);
+
+        double se = 100.0 * s.truePositives / (s.truePositives + s.falseNegatives);
+        double ppv = 100.0 * s.truePositives / (s.truePositives + s.falsePositives);
+        char line[192];
+        snprintf(line, sizeof(line), "%-20s %3u Hz  beats=%4d FN=%3d FP=%3d  Se=%6.2f%% PPV=%6.2f%%  |err|=%5.2f ms  "
+                 "search-back=%d  %.2f Msamples/s",
+                 name.c_str(), record.sampleRateHz, s.truePositives + s.falseNegatives, s.falseNegatives,
+                 s.falsePositives, se, ppv, s.meanAbsErrorMs, s.searchBacks, s.samplesPerSecond / 1e6);
+        TEST_MESSAGE(line);
+
+        total.truePositives += s.truePositives;
+        total.falseNegatives += s.falseNegatives;
+        total.falsePositives += s.falsePositives;
+    }
+
+    double se = 100.0 * total.truePositives / (total.truePositives + total.falseNegatives);
+    double ppv = 100.0 * total.truePositives / (total.truePositives + total.falsePositives);
+    char line[96];
+    snprintf(line, sizeof(line), "All records: Se=%.2f%% PPV=%.2f%%", se, ppv);
+    TEST_MESSAGE(line);
+    TEST_ASSERT_GREATER_OR_EQUAL(99.0, se);
+    TEST_ASSERT_GREATER_OR_EQUAL(99.0, ppv);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_regular_rhythm_gives_exact_rr_and_heart_rate);
+    RUN_TEST(test_inverted_lead_is_detected);
+    RUN_TEST(test_tall_t_waves_are_not_beats);
+    RUN_TEST(test_search_back_recovers_a_small_beat);
+    RUN_TEST(test_instances_do_not_share_state);
+    RUN_TEST(test_recorded_ecg_files);
+    return UNITY_END();
+}
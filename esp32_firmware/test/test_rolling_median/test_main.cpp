@@ -0,0 +1,91 @@
+// Host tests for the sorted-window rolling median / MAD
+// Run with: pio test -e native -f test_rolling_median
+
+#include <unity.h>
+#include <math.h>
+#include <algorithm>
+#include <vector>
+#include "dsp/rolling_median.h"
+
+static float medianOf(std::vector<float> values) {
+    std::sort(values.begin(), values.end());
+    size_t n = values.size();
+    return (n & 1) ? values[n / 2] : 0.5f * (values[n / 2 - 1] + values[n / 2]);
+}
+
+static float madOf(const std::vector<float>& values) {
+    float median = medianOf(values);
+    std::vector<float> deviations;
+    for (float v : values) deviations.push_back(fabsf(v - median));
+    return medianOf(deviations);
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_matches_brute_force_while_filling_and_sliding() {
+    RollingMedian<15> odd;
+    RollingMedian<16> even;
+    std::vector<float> history;
+    uint32_t seed = 7;
+    for (int i = 0; i < 500; i++) {
+        seed = seed * 1664525u + 1013904223u;
+        // Integers with plenty of repeats, plus the odd wild value
+        float value = (float)((seed >> 24) % 40) + ((seed & 0xFF) == 3 ? 1000.0f : 0.0f);
+        odd.push(value);
+        even.push(value);
+        history.push_back(value);
+
+        for (size_t window : {(size_t)15, (size_t)16}) {
+            size_t n = std::min(history.size(), window);
+            std::vector<float> recent(history.end() - n, history.end());
+            const bool isOdd = window == 15;
+            TEST_ASSERT_EQUAL((int)n, (int)(isOdd ? odd.count() : even.count()));
+            TEST_ASSERT_EQUAL_FLOAT(medianOf(recent), isOdd ? odd.median() : even.median());
+            TEST_ASSERT_EQUAL_FLOAT(madOf(recent), isOdd ? odd.mad() : even.mad());
+            TEST_ASSERT_EQUAL_FLOAT(*std::min_element(recent.begin(), recent.end()), isOdd ? odd.minimum() : even.minimum());
+            TEST_ASSERT_EQUAL_FLOAT(*std::max_element(recent.begin(), recent.end()), isOdd ? odd.maximum() : even.maximum());
+        }
+        TEST_ASSERT_EQUAL_FLOAT(value, odd.newest());
+    }
+    TEST_ASSERT_TRUE(odd.full());
+}
+
+void test_single_value_and_clear() {
+    RollingMedian<8> window;
+    window.push(230000.0f);
+    TEST_ASSERT_EQUAL_FLOAT(230000.0f, window.median());
+    TEST_ASSERT_EQUAL_FLOAT(0.0f, window.mad());
+    TEST_ASSERT_FALSE(window.isOutlier(230000.0f, 3.0f));
+    TEST_ASSERT_TRUE(window.isOutlier(230001.0f, 3.0f));
+
+    window.clear();
+    TEST_ASSERT_EQUAL(0, (int)window.count());
+    window.push(5.0f);
+    window.push(7.0f);
+    TEST_ASSERT_EQUAL_FLOAT(6.0f, window.median());
+    TEST_ASSERT_EQUAL_FLOAT(1.0f, window.mad());
+}
+
+void test_outliers_do_not_move_the_median() {
+    RollingMedian<31> window;
+    for (int i = 0; i < 31; i++) {
+        window.push(250000.0f + (i % 5) * 1000.0f);
+    }
+    float before = window.median();
+    // A missed beat pairs an R-peak with the next pulse: one wild PTT
+    window.push(1050000.0f);
+    window.push(20000.0f);
+    TEST_ASSERT_FLOAT_WITHIN(1000.0f, before, window.median());
+    TEST_ASSERT_TRUE(window.isOutlier(1050000.0f, 4.0f));
+    TEST_ASSERT_FALSE(window.isOutlier(252000.0f, 4.0f));
+    TEST_ASSERT_FLOAT_WITHIN(1.0f, 1.4826f * window.mad(), window.robustSigma());
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_matches_brute_force_while_filling_and_sliding);
+    RUN_TEST(test_single_value_and_clear);
+    RUN_TEST(test_outliers_do_not_move_the_median);
+    return UNITY_END();
+}
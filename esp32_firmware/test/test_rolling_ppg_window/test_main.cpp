@@ -0,0 +1,116 @@
+// Host tests for the 25 Hz red/IR window fed to spo2_algorithm
+// Run with: pio test -e native -f test_rolling_ppg_window
+
+#include <unity.h>
+#include "dsp/rolling_ppg_window.h"
+
+static const uint64_t START_US = 1000000;      // On a bin boundary
+
+// Sample n at rateHz carries IR = 1000 + its 40 ms bin index, red = 2 * IR
+static uint64_t sampleTime(uint32_t n, uint32_t rateHz) {
+    return START_US + (uint64_t)n * 1000000 / rateHz;
+}
+
+static uint32_t binValue(uint64_t timeUs) {
+    return 1000 + (uint32_t)((timeUs - START_US) / RollingPPGWindow::BIN_US);
+}
+
+// Feeds samples [first, last) and returns how many completed a window
+static uint32_t feed(RollingPPGWindow& window, uint32_t first, uint32_t last, uint32_t rateHz = 100) {
+    uint32_t ready = 0;
+    for (uint32_t n = first; n < last; n++) {
+        uint64_t t = sampleTime(n, rateHz);
+        if (window.addSample(2 * binValue(t), binValue(t), t)) {
+            ready++;
+        }
+    }
+    return ready;
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_first_window_after_four_seconds() {
+    RollingPPGWindow window;
+    // 100 bins of 4 samples; the 100th closes when the next bin starts
+    TEST_ASSERT_EQUAL_UINT32(0, feed(window, 0, 400));
+    TEST_ASSERT_EQUAL_UINT32(1, feed(window, 400, 401));
+    for (uint32_t i = 0; i < RollingPPGWindow::LENGTH; i++) {
+        TEST_ASSERT_EQUAL_UINT32(1000 + i, window.irWindow()[i]);
+        TEST_ASSERT_EQUAL_UINT32(2 * (1000 + i), window.redWindow()[i]);
+    }
+    TEST_ASSERT_EQUAL_UINT64(START_US + 4000000, window.windowEndUs());
+}
+
+void test_window_slides_by_one_second() {
+    RollingPPGWindow window;
+    feed(window, 0, 401);
+    // Every 25 bins from here, always the newest 100 in order
+    for (uint32_t second = 1; second <= 10; second++) {
+        uint32_t end = 401 + second * 100;
+        TEST_ASSERT_EQUAL_UINT32(1, feed(window, end - 100, end));
+        uint32_t first = 1000 + second * RollingPPGWindow::STEP;
+        for (uint32_t i = 0; i < RollingPPGWindow::LENGTH; i++) {
+            TEST_ASSERT_EQUAL_UINT32(first + i, window.irWindow()[i]);
+        }
+    }
+    TEST_ASSERT_EQUAL_UINT32(11, window.getWindowCount());
+}
+
+void test_window_is_read_in_place() {
+    RollingPPGWindow window;
+    feed(window, 0, 401);
+    const uint32_t* first = window.irWindow();
+    // Whichever half of the storage the window sits in, it never moves elsewhere
+    for (uint32_t second = 1; second <= 4; second++) {
+        feed(window, 301 + second * 100, 401 + second * 100);
+        TEST_ASSERT_TRUE(window.irWindow() >= first);
+        TEST_ASSERT_TRUE(window.irWindow() <= first + RollingPPGWindow::STEP);
+    }
+}
+
+void test_bins_are_averaged_at_any_stream_rate() {
+    const uint32_t rates[3] = {50, 200, 400};
+    for (uint32_t rate : rates) {
+        RollingPPGWindow window;
+        TEST_ASSERT_EQUAL_UINT32(1, feed(window, 0, rate * 4 + 1, rate));
+        TEST_ASSERT_EQUAL_UINT32(1000, window.irWindow()[0]);
+        TEST_ASSERT_EQUAL_UINT32(1099, window.irWindow()[RollingPPGWindow::LENGTH - 1]);
+    }
+}
+
+void test_short_gap_repeats_and_long_gap_restarts() {
+    RollingPPGWindow window;
+    feed(window, 0, 200);
+    // 80 ms missing (bins 50 and 51) are filled with bin 49
+    TEST_ASSERT_EQUAL_UINT32(0, feed(window, 208, 400));
+    TEST_ASSERT_EQUAL_UINT32(1, feed(window, 400, 401));
+    TEST_ASSERT_EQUAL_UINT32(1049, window.irWindow()[50]);
+    TEST_ASSERT_EQUAL_UINT32(1049, window.irWindow()[51]);
+    TEST_ASSERT_EQUAL_UINT32(1052, window.irWindow()[52]);
+
+    // A second missing: a full four seconds again before the next window
+    TEST_ASSERT_EQUAL_UINT32(0, feed(window, 509, 908));
+    TEST_ASSERT_EQUAL_UINT32(1, feed(window, 908, 912));
+    TEST_ASSERT_EQUAL_UINT32(1127, window.irWindow()[0]);
+}
+
+void test_reset_starts_over() {
+    RollingPPGWindow window;
+    feed(window, 0, 600);
+    window.reset();
+    TEST_ASSERT_EQUAL_UINT32(0, window.getWindowCount());
+    TEST_ASSERT_EQUAL_UINT32(0, feed(window, 600, 1000));
+    TEST_ASSERT_EQUAL_UINT32(1, feed(window, 1000, 1001));
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_first_window_after_four_seconds);
+    RUN_TEST(test_window_slides_by_one_second);
+    RUN_TEST(test_window_is_read_in_place);
+    RUN_TEST(test_bins_are_averaged_at_any_stream_rate);
+    RUN_TEST(test_short_gap_repeats_and_long_gap_restarts);
+    RUN_TEST(test_reset_starts_over);
+    return UNITY_END();
+}
@@ -0,0 +1,168 @@
+// Host tests for the cooperative sensor deadline scheduler
+// Run with: pio test -e native -f test_sensor_scheduler
+
+#include <unity.h>
+#include "sensors/sensor_scheduler.h"
+
+// Virtual microsecond clock; steps "take time" by advancing it
+static uint32_t fakeUs = 0;
+static uint32_t fakeClock() { return fakeUs; }
+
+struct FakeSensor {
+    uint32_t stepsPerJob;   // Steps until the job reports DONE
+    uint32_t stepCostUs;    // CPU time each step burns
+    uint32_t jobs;
+    uint32_t calls;
+    uint32_t order;         // Global call order of the last step
+};
+
+static uint32_t callCounter = 0;
+
+static SensorStepResult fakeStep(void* context, uint32_t nowMs, uint32_t step) {
+    (void)nowMs;
+    FakeSensor* sensor = static_cast<FakeSensor*>(context);
+    sensor->calls++;
+    sensor->order = ++callCounter;
+    fakeUs += sensor->stepCostUs;
+    if (step + 1 >= sensor->stepsPerJob) {
+        sensor->jobs++;
+        return SENSOR_STEP_DONE;
+    }
+    return SENSOR_STEP_PENDING;
+}
+
+// Runs the scheduler from a periodic tick like sensorTask does
+static void runFor(SensorScheduler& scheduler, uint32_t durationMs, uint32_t tickMs, uint32_t budgetUs) {
+    uint32_t startMs = fakeUs / 1000;
+    for (uint32_t now = startMs; now < startMs + durationMs; now += tickMs) {
+        if (fakeUs < now * 1000) fakeUs = now * 1000;
+        scheduler.run(fakeUs / 1000, budgetUs);
+    }
+}
+
+void setUp() {
+    fakeUs = 0;
+    callCounter = 0;
+}
+void tearDown() {}
+
+void test_each_sensor_runs_at_its_own_period() {
+    SensorScheduler scheduler(fakeClock);
+    FakeSensor weight = {1, 200, 0, 0, 0};
+    FakeSensor heartRate = {1, 500, 0, 0, 0};
+    FakeSensor bia = {1, 2000, 0, 0, 0};
+    scheduler.addTask("weight", 2000, fakeStep, &weight);
+    scheduler.addTask("heart_rate", 5000, fakeStep, &heartRate);
+    scheduler.addTask("bia", 15000, fakeStep, &bia);
+    scheduler.start(0);
+
+    runFor(scheduler, 60000, 20, 10000);
+
+    TEST_ASSERT_EQUAL_UINT32(30, weight.jobs);
+    TEST_ASSERT_EQUAL_UINT32(12, heartRate.jobs);
+    TEST_ASSERT_EQUAL_UINT32(4, bia.jobs);
+    for (uint8_t i = 0; i < scheduler.taskCount(); i++) {
+        TEST_ASSERT_EQUAL_UINT32(0, scheduler.getStats(i).overruns);
+        TEST_ASSERT_EQUAL_UINT32(0, scheduler.getStats(i).skippedReleases);
+        TEST_ASSERT_LESS_OR_EQUAL(20, scheduler.getStats(i).maxLatencyMs);
+    }
+}
+
+void test_earliest_deadline_runs_first() {
+    SensorScheduler scheduler(fakeClock);
+    FakeSensor slow = {1, 10, 0, 0, 0};
+    FakeSensor fast = {1, 10, 0, 0, 0};
+    scheduler.addTask("slow", 10000, fakeStep, &slow);
+    scheduler.addTask("fast", 1000, fakeStep, &fast);
+    scheduler.start(0);
+
+    TEST_ASSERT_EQUAL(2, scheduler.run(0, 100000));
+    TEST_ASSERT_LESS_THAN(slow.order, fast.order);
+}
+
+void test_multi_step_job_latency() {
+    SensorScheduler scheduler(fakeClock);
+    FakeSensor bia = {5, 100, 0, 0, 0};   // e.g. a 5-point sweep, one point per step
+    int id = scheduler.addTask("bia", 15000, fakeStep, &bia);
+    scheduler.start(0);
+
+    runFor(scheduler, 1000, 20, 10000);
+
+    TEST_ASSERT_EQUAL_UINT32(1, bia.jobs);
+    TEST_ASSERT_EQUAL_UINT32(5, bia.calls);
+    // Released at 0, stepped at 0, 20, 40, 60, 80 ms
+    TEST_ASSERT_EQUAL_UINT32(80, scheduler.getStats(id).lastLatencyMs);
+    TEST_ASSERT_FALSE(scheduler.isActive(id));
+}
+
+void test_overrun_and_skipped_releases_are_counted() {
+    SensorScheduler scheduler(fakeClock);
+    // Needs 40 steps at a 20 ms tick = 780 ms, but the period is 300 ms
+    FakeSensor laggard = {40, 10, 0, 0, 0};
+    int id = scheduler.addTask("laggard", 300, fakeStep, &laggard);
+    scheduler.start(0);
+
+    runFor(scheduler, 3000, 20, 10000);
+
+    const SensorTaskStats& stats = scheduler.getStats(id);
+    TEST_ASSERT_GREATER_THAN(0, stats.completed);
+    TEST_ASSERT_EQUAL_UINT32(stats.completed, stats.overruns);
+    TEST_ASSERT_GREATER_THAN(0, stats.skippedReleases);
+    TEST_ASSERT_GREATER_THAN(300, stats.maxLatencyMs);
+}
+
+void test_slow_sensor_cannot_starve_the_others() {
+    SensorScheduler scheduler(fakeClock);
+    // A 40 ms blocking step (the old delay-based BIA point) next to a light sensor
+    FakeSensor hog = {5, 40000, 0, 0, 0};
+    FakeSensor weight = {1, 200, 0, 0, 0};
+    int hogId = scheduler.addTask("bia", 1000, fakeStep, &hog);
+    int weightId = scheduler.addTask("weight", 200, fakeStep, &weight);
+    scheduler.start(0);
+
+    runFor(scheduler, 20000, 20, 5000);
+
+    // The hog only gets one step per pass, so the light sensor still meets every deadline
+    TEST_ASSERT_EQUAL_UINT32(100, weight.jobs);
+    TEST_ASSERT_EQUAL_UINT32(0, scheduler.getStats(weightId).overruns);
+    TEST_ASSERT_GREATER_OR_EQUAL(40000, scheduler.getStats(hogId).maxStepUs);
+    TEST_ASSERT_GREATER_THAN(0, hog.jobs);
+}
+
+void test_disabled_task_and_next_release() {
+    SensorScheduler scheduler(fakeClock);
+    FakeSensor a = {1, 10, 0, 0, 0};
+    FakeSensor b = {1, 10, 0, 0, 0};
+    int idA = scheduler.addTask("a", 1000, fakeStep, &a);
+    scheduler.addTask("b", 500, fakeStep, &b, 100);
+    scheduler.setEnabled(idA, false);
+    scheduler.start(0);
+
+    TEST_ASSERT_EQUAL_UINT32(100, scheduler.msUntilNextRelease(0));
+    TEST_ASSERT_EQUAL(0, scheduler.run(0, 1000));
+    TEST_ASSERT_EQUAL(1, scheduler.run(100, 1000));
+    TEST_ASSERT_EQUAL_UINT32(500, scheduler.msUntilNextRelease(100));
+    TEST_ASSERT_EQUAL_UINT32(0, a.calls);
+}
+
+void test_task_table_limit() {
+    SensorScheduler scheduler(fakeClock);
+    FakeSensor s = {1, 0, 0, 0, 0};
+    for (int i = 0; i < SensorScheduler::MAX_TASKS; i++) {
+        TEST_ASSERT_EQUAL(i, scheduler.addTask("s", 100, fakeStep, &s));
+    }
+    TEST_ASSERT_EQUAL(-1, scheduler.addTask("overflow", 100, fakeStep, &s));
+    TEST_ASSERT_EQUAL(-1, SensorScheduler(fakeClock).addTask("zero", 0, fakeStep, &s));
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_each_sensor_runs_at_its_own_period);
+    RUN_TEST(test_earliest_deadline_runs_first);
+    RUN_TEST(test_multi_step_job_latency);
+    RUN_TEST(test_overrun_and_skipped_releases_are_counted);
+    RUN_TEST(test_slow_sensor_cannot_starve_the_others);
+    RUN_TEST(test_disabled_task_and_next_release);
+    RUN_TEST(test_task_table_limit);
+    return UNITY_END();
+}
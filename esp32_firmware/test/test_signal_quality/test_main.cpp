@@ -0,0 +1,247 @@
+// Host tests for the streaming signal quality engine
+// Run with: pio test -e native -f test_signal_quality
+
+#include <unity.h>
+#include <stdio.h>
+#include <math.h>
+#include <vector>
+#include "dsp/signal_quality.h"
+#include "dsp/pipeline.h"
+#include "dsp/bandpass_designs.h"
+#include "../mocks/synthetic_ecg.h"
+#include "../mocks/synthetic_ppg.h"
+
+static const uint32_t ECG_RATE = 250;
+static const uint32_t PPG_RATE = 200;
+
+// As SensorManager sets them up
+static const SignalQualityConfig ECG_CONFIG = {SignalKind::ECG, ECG_RATE, 4 * ECG_RATE, 0, 4095, 64, 20};
+static const SignalQualityConfig PPG_CONFIG = {SignalKind::PPG, PPG_RATE, 4 * PPG_RATE, 0, 262143, 64, 24};
+
+enum { TAP_RAW, TAP_FILTERED };
+
+// Raw, filtered and beats into the engine, as the streams do
+struct Feeder {
+    SignalQualityEngine& engine;
+    std::vector<SignalQualityIndex> windows;
+    void on(const TappedBlock<TAP_RAW>& tap) { engine.addRawBlock(tap.block.values, tap.block.count); }
+    void on(const TappedBlock<TAP_FILTERED>& tap) {
+        if (engine.addBlock(tap.block.values, tap.block.timestampsUs, tap.block.count)) {
+            windows.push_back(engine.getIndex());
+        }
+    }
+    void on(const QrsEvent& beat) { engine.addBeat(beat.timeUs); }
+    void on(const PulseFiducials& beat) { engine.addBeat(beat.maxSlopeUs); }
+};
+
+template <typename P, typename Source>
+static void run(P& pipeline, Feeder& feeder, Source& source, uint32_t rate, double seconds, float offset,
+                float sign = 1, float limit = 1e9f) {
+    float values[25];
+    uint64_t times[25];
+    for (uint32_t first = 0; first < seconds * rate; first += 25) {
+        for (uint32_t i = 0; i < 25; i++) {
+            float value = offset + sign * (float)source.sample(first + i);
+            values[i] = value < 0 ? 0 : (value > limit ? limit : value);
+            times[i] = 1000000 + (uint64_t)(first + i) * 1000000 / rate;
+        }
+        SampleBlock block = {values, times, 25};
+        pipeline.process(block, feeder);
+    }
+}
+
+typedef Pipeline<TapStage<TAP_RAW>, BandpassStage<ECGBandpass<ECG_RATE> >, TapStage<TAP_FILTERED>,
+                 QrsStage<ECG_RATE> > ECGChain;
+typedef Pipeline<TapStage<TAP_RAW>, BandpassStage<PPGBandpass<PPG_RATE> >, TapStage<TAP_FILTERED>,
+                 PulseFiducialStage> PPGChain;
+
+static void print(const char* name, const SignalQualityIndex& q) {
+    char line[160];
+    snprintf(line, sizeof(line), "%-16s score %5.1f  kurt %5.2f skew %5.2f PI %5.2f%% match %5.2f (%u) clip %.3f", name,
+             q.score, q.kurtosis, q.skewness, q.perfusionIndex, q.templateMatch, q.beats, q.clippingRatio);
+    TEST_MESSAGE(line);
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_moments_match_a_batch_computation() {
+    SignalQualityConfig config = {SignalKind::ECG, 100, 500, -1e9f, 1e9f, 0, 0};
+    SignalQualityEngine engine(config);
+    std::vector<double> x;
+    uint32_t seed = 3;
+    for (int n = 0; n < 500; n++) {
+        seed = seed * 1664525u + 1013904223u;
+        double u = (seed >> 8) / 16777216.0;
+        x.push_back(100 + 50 * u * u * u);     // Skewed right
+    }
+    bool published = false;
+    for (size_t n = 0; n < x.size(); n++) published = engine.addSample((float)x[n], n * 10000);
+    TEST_ASSERT_TRUE(published);
+
+    double mean = 0, m2 = 0, m3 = 0, m4 = 0;
+    for (double v : x) mean += v / x.size();
+    for (double v : x) {
+        double d = v - mean;
+        m2 += d * d;
+        m3 += d * d * d;
+        m4 += d * d * d * d;
+    }
+    double n = x.size();
+    const SignalQualityIndex& q = engine.getIndex();
+    TEST_ASSERT_FLOAT_WITHIN(0.01, n * m4 / (m2 * m2), q.kurtosis);
+    TEST_ASSERT_FLOAT_WITHIN(0.01, sqrt(n) * m3 / pow(m2, 1.5), q.skewness);
+    TEST_ASSERT_TRUE(q.skewness > 0.5f);
+}
+
+void test_clean_ecg_scores_high() {
+    SignalQualityEngine engine(ECG_CONFIG);
+    Feeder feeder = {engine};
+    static ECGChain chain;
+    SyntheticECG heart(ECG_RATE);
+    heart.noiseCounts = 20;
+    for (double t = 0.5; t < 30; t += 0.8) heart.rPeaks.push_back(t);
+    run(chain, feeder, heart, ECG_RATE, 30, 2048);
+
+    const SignalQualityIndex& q = feeder.windows.back();
+    print("clean ECG", q);
+    TEST_ASSERT_TRUE(q.valid);
+    TEST_ASSERT_TRUE(q.kurtosis > 5);
+    TEST_ASSERT_TRUE(q.templateMatch > 0.9f);
+    TEST_ASSERT_TRUE(q.beats >= 3);
+    TEST_ASSERT_EQUAL_FLOAT(0.0f, q.clippingRatio);
+    TEST_ASSERT_TRUE(q.score > 80);
+    TEST_ASSERT_FALSE(engine.isLowQuality(50));
+}
+
+void test_noise_without_beats_scores_low() {
+    SignalQualityEngine engine(ECG_CONFIG);
+    Feeder feeder = {engine};
+    static ECGChain chain;
+    SyntheticECG heart(ECG_RATE);
+    heart.noiseCounts = 300;                // Electrodes off the skin
+    run(chain, feeder, heart, ECG_RATE, 30, 2048);
+
+    const SignalQualityIndex& q = feeder.windows.back();
+    print("noise ECG", q);
+    TEST_ASSERT_TRUE(q.kurtosis < 4);
+    TEST_ASSERT_TRUE(q.score < 20);
+    TEST_ASSERT_TRUE(engine.isLowQuality(50));
+}
+
+void test_clipping_is_counted_at_the_rails() {
+    SignalQualityEngine engine(ECG_CONFIG);
+    Feeder feeder = {engine};
+    static ECGChain chain;
+    SyntheticECG heart(ECG_RATE);
+    heart.rAmplitude = 3000;                // R-waves run into the top rail
+    for (double t = 0.5; t < 30; t += 0.8) heart.rPeaks.push_back(t);
+    run(chain, feeder, heart, ECG_RATE, 30, 2048, 1, 4095);
+
+    const SignalQualityIndex& q = feeder.windows.back();
+    print("clipped ECG", q);
+    TEST_ASSERT_TRUE(q.clippingRatio > 0.01f);
+    TEST_ASSERT_TRUE(q.score < 80);
+}
+
+void test_clean_ppg_scores_high() {
+    SignalQualityEngine engine(PPG_CONFIG);
+    Feeder feeder = {engine};
+    static PPGChain chain;
+    SyntheticPPG finger(PPG_RATE);
+    finger.noiseCounts = 40;
+    finger.regularOnsets(0.3, 0.8, 0.05, 30);
+    // Systole-up into the stream, the raw DC level as the MAX30102 gives it
+    run(chain, feeder, finger, PPG_RATE, 30, 200000, -1);
+
+    const SignalQualityIndex& q = feeder.windows.back();
+    print("clean PPG", q);
+    TEST_ASSERT_TRUE(q.skewness > 0.3f);
+    TEST_ASSERT_TRUE(q.templateMatch > 0.9f);
+    TEST_ASSERT_TRUE(q.perfusionIndex > 0.5f && q.perfusionIndex < 3);
+    TEST_ASSERT_TRUE(q.score > 80);
+}
+
+void test_motion_lowers_the_ppg_score() {
+    SignalQualityEngine engine(PPG_CONFIG);
+    Feeder feeder = {engine};
+    static PPGChain chain;
+    SyntheticPPG finger(PPG_RATE);
+    finger.noiseCounts = 1500;              // As large as the pulses
+    finger.regularOnsets(0.3, 0.8, 0.05, 30);
+    run(chain, feeder, finger, PPG_RATE, 30, 200000, -1);
+
+    const SignalQualityIndex& q = feeder.windows.back();
+    print("noisy PPG", q);
+    TEST_ASSERT_TRUE(q.score < 50);
+}
+
+void test_late_beats_line_up_with_their_samples() {
+    // A beat reported well after it happened matches as well as a prompt one
+    SignalQualityConfig config = {SignalKind::ECG, 100, 0, -1e9f, 1e9f, 20, 5};
+    SignalQualityEngine engine(config);
+    for (uint32_t n = 0; n < 1000; n++) {
+        float value = (n % 80 == 40) ? 100.0f : (n % 80 == 41 ? 50.0f : 0.0f);
+        engine.addSample(value, (uint64_t)n * 10000);
+        // Reported 300 ms late, by time
+        if (n % 80 == 70) engine.addBeat((uint64_t)(n - 30) * 10000);
+    }
+    engine.endWindow();
+    TEST_ASSERT_EQUAL_UINT16(11, engine.getIndex().beats);
+    TEST_ASSERT_FLOAT_WITHIN(1e-4, 1.0f, engine.getIndex().templateMatch);
+}
+
+void test_bia_sweeps_match_the_previous_ones() {
+    SignalQualityConfig config = {SignalKind::BIA, 0, 0, 1.0f, 20.0f, 5, 0};
+    SignalQualityEngine engine(config);
+    const float phase[5] = {3.0f, 5.5f, 7.0f, 6.0f, 4.0f};
+    for (int sweep = 0; sweep < 3; sweep++) {
+        engine.addBeatAt(engine.sampleCount());
+        for (int k = 0; k < 5; k++) {
+            engine.addRaw(phase[k], false);
+            engine.addSample(phase[k] * (1 + 0.01f * sweep), 0);
+        }
+        TEST_ASSERT_TRUE(engine.endWindow());
+    }
+    TEST_ASSERT_TRUE(engine.getIndex().templateMatch > 0.99f);
+    TEST_ASSERT_TRUE(engine.getIndex().score > 90);
+
+    // A sweep with a bad contact: jumps and out-of-range points
+    const float bad[5] = {3.0f, 25.0f, 2.0f, 0.5f, 9.0f};
+    engine.addBeatAt(engine.sampleCount());
+    for (int k = 0; k < 5; k++) {
+        engine.addRaw(bad[k], bad[k] <= 1.0f || bad[k] >= 20.0f);
+        engine.addSample(bad[k], 0);
+    }
+    engine.endWindow();
+    TEST_ASSERT_EQUAL_FLOAT(0.4f, engine.getIndex().clippingRatio);
+    TEST_ASSERT_TRUE(engine.getIndex().score < 20);
+}
+
+void test_reset_forgets_the_template() {
+    SignalQualityEngine engine(ECG_CONFIG);
+    Feeder feeder = {engine};
+    static ECGChain chain;
+    SyntheticECG heart(ECG_RATE);
+    for (double t = 0.5; t < 10; t += 0.8) heart.rPeaks.push_back(t);
+    run(chain, feeder, heart, ECG_RATE, 10, 2048);
+    TEST_ASSERT_TRUE(engine.getIndex().valid);
+    engine.reset();
+    TEST_ASSERT_FALSE(engine.getIndex().valid);
+    TEST_ASSERT_EQUAL_UINT32(0, engine.sampleCount());
+    TEST_ASSERT_FALSE(engine.isLowQuality(50));
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_moments_match_a_batch_computation);
+    RUN_TEST(test_clean_ecg_scores_high);
+    RUN_TEST(test_noise_without_beats_scores_low);
+    RUN_TEST(test_clipping_is_counted_at_the_rails);
+    RUN_TEST(test_clean_ppg_scores_high);
+    RUN_TEST(test_motion_lowers_the_ppg_score);
+    RUN_TEST(test_late_beats_line_up_with_their_samples);
+    RUN_TEST(test_bia_sweeps_match_the_previous_ones);
+    RUN_TEST(test_reset_forgets_the_template);
+    return UNITY_END();
+}
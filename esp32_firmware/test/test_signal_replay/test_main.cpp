@@ -0,0 +1,226 @@
+// Host tests for the trace format and the faster-than-real-time replay
+// Run with: pio test -e native -f test_signal_replay -v   (-v shows the replay rate)
+
+#include <unity.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string>
+#include <vector>
+#include "replay/trace.h"
+#include "replay/signal_replay.h"
+#include "../mocks/synthetic_ecg.h"
+#include "../mocks/synthetic_ppg.h"
+
+static const double ECG_RATE = ECG_STREAM_SAMPLE_RATE;
+static const double PPG_RATE = PPG_STREAM_SAMPLE_RATE;
+static const uint64_t START_US = 5000000;          // Boot time of the first record
+static const double TRANSIT = 0.200;
+
+// ECG and PPG with the steepest upstroke TRANSIT after each R-peak, and a
+// five-point BIA sweep at each of sweepTimes, merged in time order
+static std::vector<TraceRecord> makeTrace(double seconds, const std::vector<double>& sweepTimes) {
+    SyntheticECG ecg(ECG_RATE);
+    SyntheticPPG ppg(PPG_RATE);
+    static const double pattern[7] = {0.0, 0.8, -0.5, 0.3, -1.0, 0.6, -0.2};
+    int beat = 0;
+    for (double t = 0.4; t < seconds + 1; t += 0.85 * (1 + 0.04 * pattern[beat++ % 7])) {
+        ecg.rPeaks.push_back(t);
+        ppg.onsets.push_back(t + TRANSIT - ppg.riseSeconds / 2);
+    }
+
+    std::vector<TraceRecord> records;
+    uint32_t ecgNext = 0;
+    uint32_t ppgNext = 0;
+    size_t sweepNext = 0;
+    while (true) {
+        double ecgT = ecgNext / ECG_RATE;
+        double ppgT = ppgNext / PPG_RATE;
+        double sweepT = sweepNext < sweepTimes.size() ? sweepTimes[sweepNext] : 1e9;
+        double t = std::min(ecgT, std::min(ppgT, sweepT));
+        if (t >= seconds) break;
+        uint64_t timeUs = START_US + (uint64_t)(t * 1e6 + 0.5);
+        if (t == sweepT) {
+            static const float frequencies[5] = {5000, 10000, 50000, 100000, 200000};
+            for (float frequency : frequencies) {
+                // Tissue-like: resistance falls and the phase peaks near 50 kHz
+                float resistance = 560 - 0.0006f * frequency;
+                float reactance = 62 - fabsf(logf(frequency / 50000)) * 12;
+                records.push_back({timeUs, TraceChannel::BIA, {frequency, resistance, reactance}});
+            }
+            sweepNext++;
+        } else if (t == ecgT) {
+            records.push_back({timeUs, TraceChannel::ECG, {(float)(2048 + ecg.sample(ecgNext)), 0, 0}});
+            ecgNext++;
+        } else {
+            float ir = (float)ppg.sample(ppgNext);
+            records.push_back({timeUs, TraceChannel::PPG, {ir, ir * 0.8f, 0}});
+            ppgNext++;
+        }
+    }
+    return records;
+}
+
+static std::string tempPath() {
+    char path[] = "/tmp/biotrack_traceXXXXXX";
+    int fd = mkstemp(path);
+    if (fd >= 0) close(fd);
+    return path;
+}
+
+static void writeTrace(const std::string& path, const std::vector<TraceRecord>& records, bool binary) {
+    TraceWriter writer;
+    TEST_ASSERT_TRUE(writer.open(path.c_str(), binary));
+    for (const TraceRecord& record : records) {
+        TEST_ASSERT_TRUE(writer.write(record));
+    }
+    TEST_ASSERT_TRUE(writer.close());
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_csv_and_binary_read_back_exactly() {
+    std::vector<TraceRecord> records = makeTrace(3, {1.0});
+    for (int binary = 0; binary < 2; binary++) {
+        std::string path = tempPath();
+        writeTrace(path, records, binary);
+
+        TraceReader reader;
+        TEST_ASSERT_TRUE(reader.open(path.c_str()));
+        TEST_ASSERT_EQUAL(binary != 0, reader.isBinary());
+        TraceRecord record;
+        size_t count = 0;
+        while (reader.next(record)) {
+            TEST_ASSERT_TRUE(count < records.size());
+            const TraceRecord& expected = records[count++];
+            TEST_ASSERT_EQUAL_UINT64(expected.timeUs, record.timeUs);
+            TEST_ASSERT_EQUAL((int)expected.channel, (int)record.channel);
+            for (int i = 0; i < 3; i++) {
+                TEST_ASSERT_EQUAL_FLOAT(expected.values[i], record.values[i]);
+            }
+        }
+        TEST_ASSERT_EQUAL(records.size(), count);
+        TEST_ASSERT_EQUAL_UINT32(0, reader.getSkippedLines());
+        remove(path.c_str());
+    }
+}
+
+void test_malformed_csv_lines_are_skipped() {
+    std::string path = tempPath();
+    FILE* file = fopen(path.c_str(), "w");
+    fputs("# BioTrack trace\n1000,ecg,2048\nnot a record\n2000,emg,1\n3000,ppg,100000,90000\n\n4000,bia,50000,500,60\n", file);
+    fclose(file);
+
+    TraceReader reader;
+    TEST_ASSERT_TRUE(reader.open(path.c_str()));
+    TraceRecord record;
+    const TraceChannel expected[3] = {TraceChannel::ECG, TraceChannel::PPG, TraceChannel::BIA};
+    for (TraceChannel channel : expected) {
+        TEST_ASSERT_TRUE(reader.next(record));
+        TEST_ASSERT_EQUAL((int)channel, (int)record.channel);
+    }
+    TEST_ASSERT_EQUAL_FLOAT(60, record.values[2]);
+    TEST_ASSERT_FALSE(reader.next(record));
+    TEST_ASSERT_EQUAL_UINT32(2, reader.getSkippedLines());
+    remove(path.c_str());
+}
+
+void test_replay_runs_the_estimators_on_trace_time() {
+    const double seconds = 60;
+    std::string path = tempPath();
+    writeTrace(path, makeTrace(seconds, {20.0, 50.0}), true);
+
+    SignalReplay replay;
+    TEST_ASSERT_TRUE(replay.run(path.c_str()));
+    remove(path.c_str());
+    const ReplayReport& report = replay.getReport();
+
+    TEST_ASSERT_EQUAL_UINT64((uint64_t)(seconds * ECG_RATE), report.records[0]);
+    TEST_ASSERT_EQUAL_UINT64((uint64_t)(seconds * PPG_RATE), report.records[1]);
+    TEST_ASSERT_EQUAL_UINT64(10, report.records[2]);
+    TEST_ASSERT_FLOAT_WITHIN(0.5f, ECG_RATE, report.ecgRateHz);
+    TEST_ASSERT_FLOAT_WITHIN(0.5f, PPG_RATE, report.ppgRateHz);
+    TEST_ASSERT_INT_WITHIN(3, 70, (int)report.rPeaks);
+    TEST_ASSERT_INT_WITHIN(3, 70, (int)report.pulses);
+    TEST_ASSERT_TRUE(report.hrv.intervals > 50);
+
+    // Estimates every BLOOD_PRESSURE_INTERVAL of trace time, stamped by the virtual clock
+    TEST_ASSERT_TRUE(report.bloodPressure.size() >= 8);
+    for (const BloodPressureData& bp : report.bloodPressure) {
+        uint32_t sinceStartMs = bp.timestamp - START_US / 1000;
+        TEST_ASSERT_UINT32_WITHIN(5, 0, sinceStartMs % BLOOD_PRESSURE_INTERVAL);
+        // Exact beats, so the PTT is the transit plus the PPG band-pass delay
+        TEST_ASSERT_TRUE(bp.pulseTransitTime > TRANSIT * 1e3);
+        TEST_ASSERT_TRUE(bp.pulseTransitTime < TRANSIT * 1e3 + 80);
+    }
+
+    TEST_ASSERT_EQUAL(2, report.bodyComposition.size());
+    TEST_ASSERT_EQUAL_UINT32(START_US / 1000 + 20000, report.bodyComposition[0].timestamp);
+    TEST_ASSERT_EQUAL_UINT32(START_US / 1000 + 50000, report.bodyComposition[1].timestamp);
+
+    // The platform clock is back
+    TEST_ASSERT_TRUE(&hal::clock() == &hal::platformClock());
+}
+
+void test_replay_beats_real_time() {
+    const double seconds = 600;
+    std::vector<TraceRecord> records = makeTrace(seconds, {});
+    SignalReplay replay;
+    replay.begin();
+    for (const TraceRecord& record : records) {
+        replay.addRecord(record);
+    }
+    replay.finish();
+    const ReplayReport& report = replay.getReport();
+
+    char line[160];
+    snprintf(line, sizeof(line), "%.0f s of ECG+PPG in %.3f s: %.2f Msamples/s, %.0fx real time", report.traceSeconds(),
+             report.wallSeconds, report.samplesPerSecond() / 1e6, report.speedup());
+    TEST_MESSAGE(line);
+    for (int i = 0; i < REPLAY_STAGE_COUNT; i++) {
+        const ReplayStageStats& stage = report.stages[i];
+        snprintf(line, sizeof(line), "  %-12s %7u calls  %8.2f us mean  %8.2f us max", replayStageName((ReplayStage)i),
+                 (unsigned)stage.calls, stage.calls ? stage.totalSeconds * 1e6 / stage.calls : 0.0, stage.maxSeconds * 1e6);
+        TEST_MESSAGE(line);
+    }
+    // A day of trace in well under an hour even on a slow runner
+    TEST_ASSERT_GREATER_THAN(50, (int)report.speedup());
+}
+
+void test_lead_off_restarts_the_ecg_chain() {
+    std::vector<TraceRecord> records = makeTrace(20, {});
+    std::vector<TraceRecord> withLeadOff;
+    for (const TraceRecord& record : records) {
+        TraceRecord copy = record;
+        double t = (record.timeUs - START_US) / 1e6;
+        if (record.channel == TraceChannel::ECG && t >= 8 && t < 9) {
+            copy.values[1] = 1;
+        }
+        withLeadOff.push_back(copy);
+    }
+    // And a record from the past, which is dropped
+    withLeadOff.push_back({START_US, TraceChannel::ECG, {2048, 0, 0}});
+
+    SignalReplay replay;
+    replay.begin();
+    for (const TraceRecord& record : withLeadOff) {
+        replay.addRecord(record);
+    }
+    replay.finish();
+    const ReplayReport& report = replay.getReport();
+    TEST_ASSERT_EQUAL_UINT32(1, report.leadOffResets);
+    TEST_ASSERT_EQUAL_UINT32(1, replay.getSkippedRecords());
+    // The detector relearns after the gap and carries on
+    TEST_ASSERT_TRUE(report.rPeaks > 15);
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_csv_and_binary_read_back_exactly);
+    RUN_TEST(test_malformed_csv_lines_are_skipped);
+    RUN_TEST(test_replay_runs_the_estimators_on_trace_time);
+    RUN_TEST(test_replay_beats_real_time);
+    RUN_TEST(test_lead_off_restarts_the_ecg_chain);
+    return UNITY_END();
+}
@@ -0,0 +1,160 @@
+// Host tests for the O(1) sliding-window min/max/mean/variance template
+// Run with: pio test -e native -f test_sliding_window_stats
+
+#include <unity.h>
+#include <math.h>
+#include <vector>
+#include "dsp/sliding_window_stats.h"
+
+// Min, max, mean and sample variance of the newest n values, the slow way
+struct Reference {
+    double minimum;
+    double maximum;
+    double mean;
+    double variance;
+};
+
+template <typename T>
+static Reference reference(const std::vector<T>& all, size_t end, size_t n) {
+    size_t start = end > n ? end - n : 0;
+    Reference r = {(double)all[start], (double)all[start], 0, 0};
+    for (size_t i = start; i < end; i++) {
+        r.minimum = fmin(r.minimum, (double)all[i]);
+        r.maximum = fmax(r.maximum, (double)all[i]);
+        r.mean += all[i];
+    }
+    size_t count = end - start;
+    r.mean /= count;
+    for (size_t i = start; i < end; i++) {
+        r.variance += ((double)all[i] - r.mean) * ((double)all[i] - r.mean);
+    }
+    r.variance = count > 1 ? r.variance / (count - 1) : 0;
+    return r;
+}
+
+static uint32_t lcg(uint32_t& seed) {
+    seed = seed * 1664525u + 1013904223u;
+    return seed >> 8;
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_float_window_matches_a_rescan() {
+    SlidingWindowStats<float, 16> stats;
+    std::vector<float> all;
+    uint32_t seed = 7;
+    for (int i = 0; i < 2000; i++) {
+        float value = 1000.0f + (lcg(seed) % 20000) / 10.0f - 1000.0f * (i % 300 < 150);
+        all.push_back(value);
+        stats.push(value);
+
+        Reference r = reference(all, all.size(), 16);
+        TEST_ASSERT_EQUAL_FLOAT(r.minimum, stats.minimum());
+        TEST_ASSERT_EQUAL_FLOAT(r.maximum, stats.maximum());
+        TEST_ASSERT_FLOAT_WITHIN(1e-3, r.mean, stats.mean());
+        TEST_ASSERT_FLOAT_WITHIN(1e-4 * r.variance + 1e-2, r.variance, stats.variance());
+    }
+}
+
+void test_integer_window_is_exact() {
+    SlidingWindowStats<int32_t, 10> stats;
+    std::vector<int32_t> all;
+    uint32_t seed = 3;
+    for (int i = 0; i < 1000; i++) {
+        int32_t value = (int32_t)(lcg(seed) % 4096) - 2048;
+        all.push_back(value);
+        stats.push(value);
+
+        Reference r = reference(all, all.size(), 10);
+        int64_t sum = 0;
+        for (size_t k = all.size() > 10 ? all.size() - 10 : 0; k < all.size(); k++) sum += all[k];
+        TEST_ASSERT_EQUAL_INT(sum, stats.sum());
+        TEST_ASSERT_EQUAL_INT((int32_t)r.minimum, stats.minimum());
+        TEST_ASSERT_EQUAL_INT((int32_t)r.maximum, stats.maximum());
+        TEST_ASSERT_FLOAT_WITHIN(1e-4 * r.variance + 1e-3, r.variance, stats.variance());
+    }
+}
+
+void test_monotonic_runs_and_ties() {
+    // Rising, then falling, then flat: the queues' worst and best cases
+    SlidingWindowStats<int, 5> stats;
+    for (int i = 0; i < 20; i++) {
+        stats.push(i);
+        TEST_ASSERT_EQUAL_INT(i, stats.maximum());
+        TEST_ASSERT_EQUAL_INT(i >= 4 ? i - 4 : 0, stats.minimum());
+    }
+    for (int i = 10; i > 0; i--) {
+        stats.push(i);
+        TEST_ASSERT_EQUAL_INT(i, stats.minimum());
+    }
+    for (int i = 0; i < 10; i++) {
+        stats.push(7);
+    }
+    TEST_ASSERT_EQUAL_INT(7, stats.minimum());
+    TEST_ASSERT_EQUAL_INT(7, stats.maximum());
+    TEST_ASSERT_EQUAL_INT(0, stats.range());
+    TEST_ASSERT_FLOAT_WITHIN(1e-6, 0.0, stats.variance());
+}
+
+void test_partial_window_and_eviction() {
+    SlidingWindowStats<float, 4> stats;
+    TEST_ASSERT_EQUAL(0, stats.count());
+    TEST_ASSERT_FLOAT_WITHIN(1e-6, 0.0, stats.mean());
+    TEST_ASSERT_FLOAT_WITHIN(1e-6, 0.0, stats.variance());
+
+    stats.push(2);
+    stats.push(4);
+    TEST_ASSERT_EQUAL(2, stats.count());
+    TEST_ASSERT_FALSE(stats.full());
+    TEST_ASSERT_FLOAT_WITHIN(1e-6, 3.0, stats.mean());
+    TEST_ASSERT_FLOAT_WITHIN(1e-6, 2.0, stats.variance());
+    TEST_ASSERT_FLOAT_WITHIN(1e-6, 2.0, stats.at(0));
+
+    stats.push(6);
+    stats.push(8);
+    TEST_ASSERT_TRUE(stats.full());
+    TEST_ASSERT_FLOAT_WITHIN(1e-6, 2.0, stats.push(10));
+    TEST_ASSERT_FLOAT_WITHIN(1e-6, 4.0, stats.at(0));
+    TEST_ASSERT_FLOAT_WITHIN(1e-6, 10.0, stats.newest());
+    TEST_ASSERT_FLOAT_WITHIN(1e-6, 7.0, stats.mean());
+    TEST_ASSERT_FLOAT_WITHIN(1e-6, 4.0, stats.minimum());
+}
+
+void test_no_drift_over_a_long_run() {
+    // A large DC level with small ripple, as raw PPG counts are
+    SlidingWindowStats<float, 32> stats;
+    std::vector<float> all;
+    uint32_t seed = 11;
+    for (int i = 0; i < 1000000; i++) {
+        float value = 120000.0f + (float)(lcg(seed) % 200) - 100.0f;
+        stats.push(value);
+        if (i >= 1000000 - 32) all.push_back(value);
+    }
+    Reference r = reference(all, all.size(), 32);
+    TEST_ASSERT_FLOAT_WITHIN(1e-2, r.mean, stats.mean());
+    TEST_ASSERT_FLOAT_WITHIN(1e-3 * r.variance, r.variance, stats.variance());
+}
+
+void test_clear_starts_over() {
+    SlidingWindowStats<uint32_t, 3> stats;
+    stats.push(5);
+    stats.push(9);
+    stats.clear();
+    TEST_ASSERT_EQUAL(0, stats.count());
+    stats.push(1);
+    TEST_ASSERT_EQUAL_UINT32(1, stats.minimum());
+    TEST_ASSERT_EQUAL_UINT32(1, stats.maximum());
+    TEST_ASSERT_EQUAL_INT(1, stats.sum());
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_float_window_matches_a_rescan);
+    RUN_TEST(test_integer_window_is_exact);
+    RUN_TEST(test_monotonic_runs_and_ties);
+    RUN_TEST(test_partial_window_and_eviction);
+    RUN_TEST(test_no_drift_over_a_long_run);
+    RUN_TEST(test_clear_starts_over);
+    return UNITY_END();
+}
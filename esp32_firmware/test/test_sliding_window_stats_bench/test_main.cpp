@@ -0,0 +1,95 @@
+// Cost of sliding-window min/max/mean/variance against rescanning the window
+// Run with: pio test -e native -f test_sliding_window_stats_bench -v   (-v shows the numbers)
+
+#include <unity.h>
+#include <stdio.h>
+#include <math.h>
+#include <vector>
+#include "dsp/sliding_window_stats.h"
+#include "../mocks/bench_util.h"
+
+static const uint32_t COUNT = 200000;
+
+static std::vector<float> values;
+
+// A PPG-like level: DC, a 1.2 Hz pulse at 100 Hz and some noise
+void setUp() {
+    if (!values.empty()) return;
+    uint32_t seed = 1;
+    for (uint32_t n = 0; n < COUNT; n++) {
+        seed = seed * 1664525u + 1013904223u;
+        values.push_back(120000.0f + 600.0f * sinf(2 * 3.14159265f * 1.2f * n / 100) + (float)(seed >> 24));
+    }
+}
+void tearDown() {}
+
+// What the firmware did before: keep the window, sum and scan it on every sample
+template <size_t N>
+static double rescan() {
+    float window[N] = {0};
+    size_t filled = 0;
+    size_t next = 0;
+    float total = 0;
+    BenchTimer timer;
+    for (uint32_t n = 0; n < COUNT; n++) {
+        window[next] = values[n];
+        next = (next + 1) % N;
+        if (filled < N) filled++;
+        float sum = 0;
+        float lowest = window[0];
+        float highest = window[0];
+        for (size_t i = 0; i < filled; i++) {
+            sum += window[i];
+            if (window[i] < lowest) lowest = window[i];
+            if (window[i] > highest) highest = window[i];
+        }
+        float mean = sum / filled;
+        float squares = 0;
+        for (size_t i = 0; i < filled; i++) {
+            squares += (window[i] - mean) * (window[i] - mean);
+        }
+        total += mean + (highest - lowest) + squares;
+    }
+    double seconds = timer.seconds();
+    benchSink = total;
+    return seconds;
+}
+
+template <size_t N>
+static double sliding() {
+    static SlidingWindowStats<float, N> stats;
+    stats.clear();
+    float total = 0;
+    BenchTimer timer;
+    for (uint32_t n = 0; n < COUNT; n++) {
+        stats.push(values[n]);
+        total += stats.mean() + stats.range() + stats.variance();
+    }
+    double seconds = timer.seconds();
+    benchSink = total;
+    return seconds;
+}
+
+template <size_t N>
+static void compare(const char* rescanName, const char* slidingName) {
+    double before = rescan<N>();
+    double after = sliding<N>();
+    benchReport(rescanName, COUNT, before);
+    benchReport(slidingName, COUNT, after);
+    // The point of the template: its cost must not grow with the window
+    if (N >= 64) {
+        TEST_ASSERT_TRUE(after < before);
+    }
+}
+
+void test_window_of_10() { compare<10>("rescan, N = 10", "SlidingWindowStats, N = 10"); }
+void test_window_of_64() { compare<64>("rescan, N = 64", "SlidingWindowStats, N = 64"); }
+void test_window_of_256() { compare<256>("rescan, N = 256", "SlidingWindowStats, N = 256"); }
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_window_of_10);
+    RUN_TEST(test_window_of_64);
+    RUN_TEST(test_window_of_256);
+    return UNITY_END();
+}
@@ -0,0 +1,220 @@
+// Host tests for the spectral heart-rate and SpO2 estimator
+// Run with: pio test -e native -f test_spectral_hr
+
+#include <unity.h>
+#include <stdio.h>
+#include <math.h>
+#include <vector>
+#include "dsp/spectral_hr.h"
+#include "../mocks/synthetic_ppg.h"
+
+// Red and IR of one finger: the same pulses at their own DC level and depth
+struct Finger {
+    SyntheticPPG ir;
+    SyntheticPPG red;
+
+    Finger(double rateHz, double rrSeconds, double seconds) : ir(rateHz), red(rateHz) {
+        ir.regularOnsets(0.2, rrSeconds, 0.02, seconds + 2);
+        red.onsets = ir.onsets;
+        red.dcCounts = 80000;
+        red.amplitudeCounts = 600;      // R = (600 / 80000) / (1500 / 100000) = 0.5
+    }
+
+    void useOnsets(const std::vector<double>& onsets) {
+        ir.onsets = onsets;
+        red.onsets = onsets;
+    }
+};
+
+// Feeds samples [first, last) and returns the number of analyses
+static size_t feed(SpectralHeartRate& estimator, Finger& finger, uint32_t first, uint32_t last) {
+    size_t analyses = 0;
+    for (uint32_t n = first; n < last; n++) {
+        uint64_t t = SyntheticPPG::timeUs(n, finger.ir.sampleRateHz);
+        if (estimator.addSample((uint32_t)finger.red.sample(n), (uint32_t)finger.ir.sample(n), t)) {
+            analyses++;
+        }
+    }
+    return analyses;
+}
+
+static void reportEstimate(const char* label, const SpectralEstimate& e) {
+    char line[128];
+    snprintf(line, sizeof(line), "%s: %.2f BPM (confidence %.2f), R %.3f, SpO2 %.1f%%",
+             label, e.heartRateBpm, e.confidence, e.ratio, e.spo2);
+    TEST_MESSAGE(line);
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_heart_rate_across_the_range() {
+    const double rates[5] = {42, 60, 85, 120, 170};
+    for (double bpm : rates) {
+        Finger finger(100, 60.0 / bpm, 30);
+        SpectralHeartRate estimator;
+        feed(estimator, finger, 0, 3000);
+
+        const SpectralEstimate& e = estimator.getEstimate();
+        char label[32];
+        snprintf(label, sizeof(label), "%.0f BPM", bpm);
+        reportEstimate(label, e);
+        TEST_ASSERT_TRUE(e.heartRateValid);
+        TEST_ASSERT_FLOAT_WITHIN(2.0, bpm, e.heartRateBpm);
+    }
+}
+
+void test_strong_second_harmonic_does_not_double_the_rate() {
+    // A pronounced second wave every beat: at 60 BPM the 2 Hz harmonic
+    // carries 1.8x the power of the 1 Hz fundamental
+    SpectralHeartRate estimator;
+    for (uint32_t n = 0; n < 3000; n++) {
+        double t = n / 100.0;
+        double ir = 100000 - 600 * sin(2 * M_PI * t) - 800 * sin(4 * M_PI * t + 1.0);
+        estimator.addSample((uint32_t)(0.8 * ir), (uint32_t)ir, SyntheticPPG::timeUs(n, 100));
+    }
+
+    // 1 Hz and 2 Hz fall on bins 20.48 and 40.96
+    TEST_ASSERT_TRUE(estimator.powerAt(41) > estimator.powerAt(20));
+    TEST_ASSERT_TRUE(estimator.getEstimate().heartRateValid);
+    TEST_ASSERT_FLOAT_WITHIN(2.0, 60.0, estimator.getEstimate().heartRateBpm);
+}
+
+void test_follows_a_rate_ramp() {
+    // 60 to 120 BPM over a minute
+    std::vector<double> onsets;
+    for (double t = 0.2; t < 80;) {
+        onsets.push_back(t);
+        double bpm = t < 10 ? 60 : (t < 70 ? 60 + (t - 10) : 120);
+        t += 60.0 / bpm;
+    }
+    Finger finger(100, 1.0, 0);
+    finger.useOnsets(onsets);
+    SpectralHeartRate estimator;
+
+    // The window is 10.24 s long, so it reports the rate about 5 s ago
+    double worst = 0;
+    for (uint32_t n = 0; n < 8000; n++) {
+        uint64_t t = SyntheticPPG::timeUs(n, 100);
+        if (!estimator.addSample((uint32_t)finger.red.sample(n), (uint32_t)finger.ir.sample(n), t)) {
+            continue;
+        }
+        double centre = n / 100.0 - 5.12;
+        double expected = centre < 10 ? 60 : (centre < 70 ? 60 + (centre - 10) : 120);
+        TEST_ASSERT_TRUE(estimator.getEstimate().heartRateValid);
+        double error = fabs(estimator.getEstimate().heartRateBpm - expected);
+        if (error > worst) worst = error;
+    }
+    char line[64];
+    snprintf(line, sizeof(line), "worst error on the ramp %.2f BPM", worst);
+    TEST_MESSAGE(line);
+    TEST_ASSERT_TRUE(worst < 4.0);
+}
+
+void test_ratio_of_ratios_and_spo2() {
+    const double redAmplitudes[2] = {600, 960};         // R = 0.5 and 0.8
+    for (double amplitude : redAmplitudes) {
+        Finger finger(100, 0.8, 30);
+        finger.red.amplitudeCounts = amplitude;
+        SpectralHeartRate estimator;
+        feed(estimator, finger, 0, 3000);
+
+        const SpectralEstimate& e = estimator.getEstimate();
+        double ratio = (amplitude / 80000) / (1500.0 / 100000);
+        double spo2 = -45.060 * ratio * ratio + 30.354 * ratio + 94.845;
+        reportEstimate("ratio of ratios", e);
+        TEST_ASSERT_TRUE(e.spo2Valid);
+        TEST_ASSERT_FLOAT_WITHIN(0.02, ratio, e.ratio);
+        TEST_ASSERT_FLOAT_WITHIN(1.0, spo2, e.spo2);
+    }
+}
+
+void test_first_estimate_after_a_full_window_then_every_hop() {
+    Finger finger(100, 0.8, 30);
+    SpectralHeartRate estimator;
+    // 256 bins of 40 ms, closed by the first sample of the next bin
+    TEST_ASSERT_EQUAL(0, feed(estimator, finger, 0, 1024));
+    TEST_ASSERT_FALSE(estimator.getEstimate().heartRateValid);
+    TEST_ASSERT_EQUAL(1, feed(estimator, finger, 1024, 1028));
+    TEST_ASSERT_TRUE(estimator.getEstimate().heartRateValid);
+    // Then one analysis per 32 bins (1.28 s)
+    TEST_ASSERT_EQUAL(10, feed(estimator, finger, 1028, 1028 + 1280));
+    TEST_ASSERT_EQUAL_UINT32(11, estimator.getEstimate().updates);
+}
+
+void test_same_answer_at_any_stream_rate() {
+    const double rates[3] = {50, 100, 400};
+    float estimates[3];
+    for (int r = 0; r < 3; r++) {
+        Finger finger(rates[r], 0.75, 30);
+        SpectralHeartRate estimator;
+        // Delivered in bursts, as the FIFO drain does
+        std::vector<PPGSample> block;
+        uint32_t total = (uint32_t)(25 * rates[r]);
+        for (uint32_t n = 0; n < total; n++) {
+            block.push_back({(uint32_t)finger.red.sample(n), (uint32_t)finger.ir.sample(n),
+                             SyntheticPPG::timeUs(n, rates[r])});
+            if (block.size() == 16 || n + 1 == total) {
+                estimator.addBlock(block.data(), block.size());
+                block.clear();
+            }
+        }
+        TEST_ASSERT_TRUE(estimator.getEstimate().heartRateValid);
+        estimates[r] = estimator.getEstimate().heartRateBpm;
+        TEST_ASSERT_FLOAT_WITHIN(2.0, 80.0, estimates[r]);
+    }
+    TEST_ASSERT_FLOAT_WITHIN(0.5, estimates[0], estimates[1]);
+    TEST_ASSERT_FLOAT_WITHIN(0.5, estimates[1], estimates[2]);
+}
+
+void test_short_gap_is_held_and_long_gap_restarts() {
+    Finger finger(100, 0.8, 60);
+    SpectralHeartRate estimator;
+    feed(estimator, finger, 0, 1500);
+    uint32_t updates = estimator.getEstimate().updates;
+
+    // 100 ms missing: analyses carry on as if nothing happened
+    feed(estimator, finger, 1510, 1650);
+    TEST_ASSERT_EQUAL_UINT32(updates + 1, estimator.getEstimate().updates);
+
+    // About a second missing: the window starts over
+    TEST_ASSERT_EQUAL(0, feed(estimator, finger, 1748, 1748 + 1024));
+    TEST_ASSERT_EQUAL(1, feed(estimator, finger, 1748 + 1024, 1748 + 1030));
+}
+
+void test_noise_alone_is_not_a_heart_rate() {
+    SyntheticPPG noise(100);
+    noise.noiseCounts = 2000;
+    SpectralHeartRate estimator;
+    for (uint32_t n = 0; n < 3000; n++) {
+        uint32_t value = (uint32_t)noise.sample(n);
+        estimator.addSample(value, value, SyntheticPPG::timeUs(n, 100));
+    }
+    TEST_ASSERT_TRUE(estimator.getEstimate().updates > 0);
+    TEST_ASSERT_FALSE(estimator.getEstimate().heartRateValid);
+}
+
+void test_reset_clears_everything() {
+    Finger finger(100, 0.8, 30);
+    SpectralHeartRate estimator;
+    feed(estimator, finger, 0, 2000);
+    estimator.reset();
+    TEST_ASSERT_EQUAL_UINT32(0, estimator.getEstimate().updates);
+    TEST_ASSERT_FALSE(estimator.getEstimate().heartRateValid);
+    TEST_ASSERT_FALSE(estimator.getEstimate().spo2Valid);
+    TEST_ASSERT_EQUAL(0, feed(estimator, finger, 2000, 3024));
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_heart_rate_across_the_range);
+    RUN_TEST(test_strong_second_harmonic_does_not_double_the_rate);
+    RUN_TEST(test_follows_a_rate_ramp);
+    RUN_TEST(test_ratio_of_ratios_and_spo2);
+    RUN_TEST(test_first_estimate_after_a_full_window_then_every_hop);
+    RUN_TEST(test_same_answer_at_any_stream_rate);
+    RUN_TEST(test_short_gap_is_held_and_long_gap_restarts);
+    RUN_TEST(test_noise_alone_is_not_a_heart_rate);
+    RUN_TEST(test_reset_clears_everything);
+    return UNITY_END();
+}
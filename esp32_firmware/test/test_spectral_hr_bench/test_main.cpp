@@ -0,0 +1,149 @@
+// Cost of a spectral heart-rate update and of feeding it samples
+// Run with: pio test -e native -f test_spectral_hr_bench -v   (-v shows the numbers)
+
+#include <unity.h>
+#include <stdio.h>
+#include <math.h>
+#include <vector>
+#include "dsp/spectral_hr.h"
+#include "../mocks/synthetic_ppg.h"
+#include "../mocks/bench_util.h"
+
+static const uint32_t RATE = 100;
+static const double SECONDS = 300;
+
+static std::vector<PPGSample> samples;
+
+// Five minutes of a noisy 72 BPM finger
+void setUp() {
+    if (!samples.empty()) return;
+    SyntheticPPG ir(RATE);
+    ir.noiseCounts = 40;
+    ir.regularOnsets(0.3, 0.83, 0.05, SECONDS);
+    SyntheticPPG red = ir;
+    red.dcCounts = 80000;
+    red.amplitudeCounts = 700;
+    uint32_t total = (uint32_t)(SECONDS * RATE);
+    for (uint32_t n = 0; n < total; n++) {
+        samples.push_back({(uint32_t)red.sample(n), (uint32_t)ir.sample(n), SyntheticPPG::timeUs(n, RATE)});
+    }
+}
+void tearDown() {}
+
+void test_bench_stream() {
+    // Everything the consumer pays: binning, levels and the analyses
+    SpectralHeartRate estimator;
+    BenchTimer timer;
+    size_t analyses = estimator.addBlock(samples.data(), samples.size());
+    benchReport("stream incl. analyses", samples.size(), timer.seconds());
+    benchSink = estimator.getEstimate().heartRateBpm;
+    TEST_ASSERT_TRUE(analyses > 200);
+    TEST_ASSERT_FLOAT_WITHIN(3.0, 72.3, estimator.getEstimate().heartRateBpm);
+}
+
+void test_bench_per_update() {
+    // Fed a hop at a time once the window is full, so each block holds one analysis
+    SpectralHeartRate estimator;
+    size_t warm = 1100;
+    estimator.addBlock(samples.data(), warm);
+    const size_t hopSamples = SpectralHeartRate::HOP * SpectralHeartRate::BIN_US / (1000000 / RATE);
+    uint32_t updatesBefore = estimator.getEstimate().updates;
+
+    double total = 0;
+    size_t fed = 0;
+    for (size_t at = warm; at + hopSamples <= samples.size(); at += hopSamples) {
+        BenchTimer timer;
+        estimator.addBlock(samples.data() + at, hopSamples);
+        total += timer.seconds();
+        fed += hopSamples;
+    }
+    uint32_t updates = estimator.getEstimate().updates - updatesBefore;
+
+    // Binning and levels alone, 9 s at a time so the window never fills;
+    // the update is what the hops cost beyond that
+    double ingest = 0;
+    size_t ingested = 0;
+    float checksum = 0;
+    for (size_t at = warm; at + 900 <= samples.size(); at += 900) {
+        SpectralHeartRate fresh;
+        BenchTimer timer;
+        fresh.addBlock(samples.data() + at, 900);
+        ingest += timer.seconds();
+        ingested += 900;
+        checksum += fresh.getEstimate().updates;
+    }
+    benchSink = checksum;
+
+    double ingestPerSample = ingest / ingested;
+    double updateSeconds = (total - ingestPerSample * fed) / updates;
+    benchReport("ingest (bin, DC/AC levels)", 1, ingestPerSample);
+    benchReport("window + 512-point FFT + peak + SpO2", 1, updateSeconds, "update");
+    TEST_ASSERT_TRUE(updates > 100);
+    TEST_ASSERT_EQUAL(0, checksum);
+}
+
+void test_bench_fft_twiddles_per_call() {
+    // The same transform with the twiddles evaluated on every call in double,
+    // as arduinoFFT 1.6 does; the ESP32 emulates double in software
+    const uint32_t N = SpectralHeartRate::FFT_SIZE;
+    const uint32_t TRANSFORMS = 2000;
+    static double re[N], im[N];
+    double checksum = 0;
+    BenchTimer timer;
+    for (uint32_t t = 0; t < TRANSFORMS; t++) {
+        for (uint32_t i = 0; i < N; i++) {
+            re[i] = i < 256 ? samples[t + i].ir * 1e-5 : 0;
+            im[i] = 0;
+        }
+        for (uint32_t i = 1, j = 0; i < N; i++) {
+            uint32_t bit = N >> 1;
+            for (; j & bit; bit >>= 1) j ^= bit;
+            j ^= bit;
+            if (i < j) {
+                double tmp = re[i]; re[i] = re[j]; re[j] = tmp;
+            }
+        }
+        for (uint32_t size = 2; size <= N; size <<= 1) {
+            for (uint32_t j = 0; j < size / 2; j++) {
+                double wr = cos(-2 * M_PI * j / size);
+                double wi = sin(-2 * M_PI * j / size);
+                for (uint32_t a = j; a < N; a += size) {
+                    uint32_t b = a + size / 2;
+                    double tr = re[b] * wr - im[b] * wi;
+                    double ti = re[b] * wi + im[b] * wr;
+                    re[b] = re[a] - tr;
+                    im[b] = im[a] - ti;
+                    re[a] += tr;
+                    im[a] += ti;
+                }
+            }
+        }
+        checksum += re[20] * re[20] + im[20] * im[20];
+    }
+    benchReport("FFT, twiddles per call, double", TRANSFORMS, timer.seconds(), "transform");
+    benchSink = (float)checksum;
+
+    Radix2FFT<SpectralHeartRate::FFT_SIZE> fft;
+    static float fre[N], fim[N];
+    float fchecksum = 0;
+    timer.restart();
+    for (uint32_t t = 0; t < TRANSFORMS; t++) {
+        for (uint32_t i = 0; i < N; i++) {
+            fre[i] = i < 256 ? samples[t + i].ir * 1e-5f : 0;
+            fim[i] = 0;
+        }
+        fft.forward(fre, fim);
+        fchecksum += fre[20] * fre[20] + fim[20] * fim[20];
+    }
+    benchReport("Radix2FFT, tabulated twiddles, float", TRANSFORMS, timer.seconds(), "transform");
+    benchSink = fchecksum;
+    TEST_ASSERT_FLOAT_WITHIN(1e-3 * checksum, checksum, fchecksum);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_bench_stream);
+    RUN_TEST(test_bench_per_update);
+    RUN_TEST(test_bench_fft_twiddles_per_call);
+    return UNITY_END();
+}
@@ -0,0 +1,193 @@
+// Host tests for the lock-free SPSC ring buffer template
+// Run with: pio test -e native -f test_spsc_ring
+
+#include <unity.h>
+#include <thread>
+#include "sensors/spsc_ring.h"
+
+struct Sample {
+    uint32_t value;
+    uint32_t timestampUs;
+};
+
+void setUp() {}
+void tearDown() {}
+
+void test_capacity_helper_rounds_up_to_power_of_two() {
+    TEST_ASSERT_EQUAL_UINT32(1, spscRingCapacityFor(1));
+    TEST_ASSERT_EQUAL_UINT32(16, spscRingCapacityFor(10));
+    TEST_ASSERT_EQUAL_UINT32(128, spscRingCapacityFor(100));
+    TEST_ASSERT_EQUAL_UINT32(256, spscRingCapacityFor(200));
+    TEST_ASSERT_EQUAL_UINT32(1024, spscRingCapacityFor(1024));
+    TEST_ASSERT_EQUAL_UINT32(16, (SpscRing<int, spscRingCapacityFor(10)>::CAPACITY));
+}
+
+void test_push_pop_preserves_order() {
+    SpscRing<Sample, 8> ring;
+    TEST_ASSERT_TRUE(ring.empty());
+    for (uint32_t i = 0; i < 5; i++) {
+        TEST_ASSERT_TRUE(ring.push({i, i * 10}));
+    }
+    TEST_ASSERT_EQUAL(5, ring.available());
+    TEST_ASSERT_EQUAL(3, ring.freeSpace());
+
+    Sample out;
+    for (uint32_t i = 0; i < 5; i++) {
+        TEST_ASSERT_TRUE(ring.pop(out));
+        TEST_ASSERT_EQUAL_UINT32(i, out.value);
+        TEST_ASSERT_EQUAL_UINT32(i * 10, out.timestampUs);
+    }
+    TEST_ASSERT_FALSE(ring.pop(out));
+}
+
+void test_full_ring_counts_drops() {
+    SpscRing<int, 4> ring;
+    for (int i = 0; i < 4; i++) TEST_ASSERT_TRUE(ring.push(i));
+    TEST_ASSERT_TRUE(ring.full());
+    TEST_ASSERT_FALSE(ring.push(99));
+    TEST_ASSERT_FALSE(ring.push(100));
+    TEST_ASSERT_EQUAL_UINT32(2, ring.droppedCount());
+
+    // The oldest data survives; newer samples were the ones rejected
+    int out[4];
+    TEST_ASSERT_EQUAL(4, ring.pop(out, 4));
+    TEST_ASSERT_EQUAL(0, out[0]);
+    TEST_ASSERT_EQUAL(3, out[3]);
+}
+
+void test_batch_pop_across_the_wrap() {
+    SpscRing<int, 8> ring;
+    int out[8];
+    // Walk the indices around the buffer several times with uneven batches
+    int next = 0;
+    int expected = 0;
+    for (int round = 0; round < 50; round++) {
+        int batch[5];
+        for (int i = 0; i < 5; i++) batch[i] = next++;
+        TEST_ASSERT_EQUAL(5, ring.pushBatch(batch, 5));
+
+        size_t n = ring.pop(out, 3 + (round % 3));
+        for (size_t i = 0; i < n; i++) TEST_ASSERT_EQUAL(expected++, out[i]);
+        n = ring.pop(out, 8);
+        for (size_t i = 0; i < n; i++) TEST_ASSERT_EQUAL(expected++, out[i]);
+    }
+    TEST_ASSERT_EQUAL(next, expected);
+    TEST_ASSERT_EQUAL_UINT32(0, ring.droppedCount());
+}
+
+void test_push_batch_truncates_when_full() {
+    SpscRing<int, 8> ring;
+    int items[12];
+    for (int i = 0; i < 12; i++) items[i] = i;
+    TEST_ASSERT_EQUAL(8, ring.pushBatch(items, 12));
+    TEST_ASSERT_EQUAL_UINT32(4, ring.droppedCount());
+    TEST_ASSERT_EQUAL(0, ring.pushBatch(items, 1));
+}
+
+void test_peek_does_not_consume() {
+    SpscRing<int, 16> ring;
+    for (int i = 0; i < 10; i++) ring.push(i);
+
+    int window[4];
+    TEST_ASSERT_EQUAL(4, ring.peek(window, 4, 2));
+    TEST_ASSERT_EQUAL(2, window[0]);
+    TEST_ASSERT_EQUAL(5, window[3]);
+
+    TEST_ASSERT_EQUAL(4, ring.peekLatest(window, 4));
+    TEST_ASSERT_EQUAL(6, window[0]);
+    TEST_ASSERT_EQUAL(9, window[3]);
+
+    TEST_ASSERT_EQUAL(2, ring.peek(window, 4, 8));   // Clipped at the newest item
+    TEST_ASSERT_EQUAL(0, ring.peek(window, 4, 10));
+    TEST_ASSERT_EQUAL(7, ring.at(7));
+    TEST_ASSERT_EQUAL(10, ring.available());
+}
+
+void test_peek_window_spanning_the_wrap() {
+    SpscRing<int, 8> ring;
+    for (int i = 0; i < 6; i++) ring.push(i);
+    TEST_ASSERT_EQUAL(6, ring.discard(6));
+    for (int i = 100; i < 107; i++) ring.push(i);   // Occupies slots 6,7,0..4
+
+    int window[7];
+    TEST_ASSERT_EQUAL(7, ring.peek(window, 7));
+    for (int i = 0; i < 7; i++) TEST_ASSERT_EQUAL(100 + i, window[i]);
+}
+
+void test_slide_keeps_newest_window() {
+    SpscRing<int, 16> ring;
+    int evicted = -1;
+    int sum = 0;
+    for (int i = 1; i <= 25; i++) {
+        if (ring.slide(i, 10, &evicted)) sum -= evicted;
+        sum += i;
+    }
+    // Running sum maintained from the evicted items matches the window 16..25
+    TEST_ASSERT_EQUAL(10, ring.available());
+    TEST_ASSERT_EQUAL(16, ring.at(0));
+    TEST_ASSERT_EQUAL(15, evicted);
+    TEST_ASSERT_EQUAL(205, sum);
+    TEST_ASSERT_EQUAL_UINT32(0, ring.droppedCount());
+}
+
+void test_clear_and_discard() {
+    SpscRing<int, 8> ring;
+    for (int i = 0; i < 6; i++) ring.push(i);
+    TEST_ASSERT_EQUAL(2, ring.discard(2));
+    TEST_ASSERT_EQUAL(2, ring.at(0));
+    TEST_ASSERT_EQUAL(4, ring.discard(10));
+    TEST_ASSERT_TRUE(ring.empty());
+
+    ring.push(1);
+    ring.clear();
+    TEST_ASSERT_EQUAL(0, ring.available());
+    TEST_ASSERT_EQUAL(8, ring.freeSpace());
+}
+
+void test_concurrent_producer_consumer_sees_every_item_in_order() {
+    static SpscRing<Sample, 256> ring;
+    const uint32_t total = 2000000;
+
+    std::thread producer([&]() {
+        uint32_t i = 0;
+        while (i < total) {
+            if (ring.push({i, ~i})) {
+                i++;
+            } else {
+                std::this_thread::yield();
+            }
+        }
+    });
+
+    uint32_t expected = 0;
+    bool ordered = true;
+    Sample batch[64];
+    while (expected < total) {
+        size_t n = ring.pop(batch, 64);
+        if (n == 0) std::this_thread::yield();
+        for (size_t k = 0; k < n; k++) {
+            if (batch[k].value != expected || batch[k].timestampUs != ~expected) ordered = false;
+            expected++;
+        }
+    }
+    producer.join();
+
+    TEST_ASSERT_TRUE(ordered);
+    TEST_ASSERT_EQUAL_UINT32(total, expected);
+    TEST_ASSERT_TRUE(ring.empty());
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_capacity_helper_rounds_up_to_power_of_two);
+    RUN_TEST(test_push_pop_preserves_order);
+    RUN_TEST(test_full_ring_counts_drops);
+    RUN_TEST(test_batch_pop_across_the_wrap);
+    RUN_TEST(test_push_batch_truncates_when_full);
+    RUN_TEST(test_peek_does_not_consume);
+    RUN_TEST(test_peek_window_spanning_the_wrap);
+    RUN_TEST(test_slide_keeps_newest_window);
+    RUN_TEST(test_clear_and_discard);
+    RUN_TEST(test_concurrent_producer_consumer_sees_every_item_in_order);
+    return UNITY_END();
+}
@@ -0,0 +1,113 @@
+// Throughput microbenchmark for the SPSC ring buffer template
+// Run with: pio test -e native -f test_spsc_ring_bench -v   (-v shows the numbers)
+
+#include <unity.h>
+#include <stdio.h>
+#include <thread>
+#include "sensors/spsc_ring.h"
+#include "sensors/ppg_acquisition.h"
+#include "../mocks/bench_util.h"
+
+static const uint32_t SAMPLES = 5000000;
+
+void setUp() {}
+void tearDown() {}
+
+void test_bench_single_context_push_and_batch_pop() {
+    static SpscRing<PPGSample, 1024> ring;
+    PPGSample batch[32];
+    uint64_t checksum = 0;
+
+    BenchTimer timer;
+    for (uint32_t i = 0; i < SAMPLES; i += 32) {
+        for (uint32_t k = 0; k < 32; k++) ring.push({i + k, k, i});
+        size_t n = ring.pop(batch, 32);
+        for (size_t k = 0; k < n; k++) checksum += batch[k].red;
+    }
+    double seconds = timer.seconds();
+    benchSinkBits = checksum;
+
+    benchReport("push x32 + batch pop (PPGSample)", SAMPLES, seconds);
+    TEST_ASSERT_EQUAL_UINT32(0, ring.droppedCount());
+}
+
+void test_bench_cross_thread_stream() {
+    static SpscRing<PPGSample, 1024> ring;
+    BenchTimer timer;
+
+    std::thread producer([]() {
+        uint32_t i = 0;
+        while (i < SAMPLES) {
+            if (ring.push({i, i, i})) {
+                i++;
+            } else {
+                std::this_thread::yield();  // Full: let the consumer run (matters on one core)
+            }
+        }
+    });
+
+    PPGSample batch[64];
+    uint32_t received = 0;
+    uint64_t checksum = 0;
+    while (received < SAMPLES) {
+        size_t n = ring.pop(batch, 64);
+        if (n == 0) {
+            std::this_thread::yield();
+            continue;
+        }
+        for (size_t k = 0; k < n; k++) checksum += batch[k].ir;
+        received += n;
+    }
+    producer.join();
+    double seconds = timer.seconds();
+    benchSinkBits = checksum;
+
+    benchReport("producer thread -> consumer thread", SAMPLES, seconds);
+    TEST_ASSERT_EQUAL_UINT32(SAMPLES, received);
+}
+
+void test_bench_moving_average_ring_vs_modulo_array() {
+    const int WINDOW = 10;
+
+    // Previous pattern: modulo-indexed array, full re-sum per sample
+    int buffer[WINDOW] = {0};
+    int index = 0;
+    int64_t checksum = 0;
+    BenchTimer timer;
+    for (uint32_t i = 0; i < SAMPLES; i++) {
+        buffer[index] = (int)(i & 4095);
+        index = (index + 1) % WINDOW;
+        int sum = 0;
+        for (int j = 0; j < WINDOW; j++) sum += buffer[j];
+        checksum += sum / WINDOW;
+    }
+    double moduloSeconds = timer.seconds();
+    int64_t moduloChecksum = checksum;
+
+    // Ring window with a running sum
+    SpscRing<int, spscRingCapacityFor(WINDOW)> ring;
+    int32_t sum = 0;
+    checksum = 0;
+    timer.restart();
+    for (uint32_t i = 0; i < SAMPLES; i++) {
+        int value = (int)(i & 4095);
+        int evicted = 0;
+        ring.slide(value, WINDOW, &evicted);
+        sum += value - evicted;
+        checksum += sum / WINDOW;
+    }
+    double ringSeconds = timer.seconds();
+    benchSinkBits = (uint64_t)checksum;
+
+    benchReport("moving average, modulo array", SAMPLES, moduloSeconds);
+    benchReport("moving average, ring running sum", SAMPLES, ringSeconds);
+    TEST_ASSERT_EQUAL(moduloChecksum, checksum);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_bench_single_context_push_and_batch_pop);
+    RUN_TEST(test_bench_cross_thread_stream);
+    RUN_TEST(test_bench_moving_average_ring_vs_modulo_array);
+    return UNITY_END();
+}
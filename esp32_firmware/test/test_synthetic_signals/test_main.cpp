@@ -0,0 +1,257 @@
+// Host tests for the synthetic signal generator and the estimators' recovery of its ground truth
+// Run with: pio test -e native -f test_synthetic_signals -v   (-v shows measured against true values)
+
+#include <unity.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <math.h>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include "replay/synthetic_signals.h"
+#include "replay/signal_replay.h"
+
+static std::vector<TraceRecord> generate(const SyntheticConfig& config) {
+    SyntheticSignals signals(config);
+    std::vector<TraceRecord> records;
+    TraceRecord record;
+    while (signals.next(record)) {
+        records.push_back(record);
+    }
+    return records;
+}
+
+static bool sameRecords(const std::vector<TraceRecord>& a, const std::vector<TraceRecord>& b) {
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); i++) {
+        if (a[i].timeUs != b[i].timeUs || a[i].channel != b[i].channel ||
+            memcmp(a[i].values, b[i].values, sizeof(a[i].values)) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void replaySynthetic(SyntheticSignals& signals, SignalReplay& replay) {
+    replay.begin();
+    signals.feed(replay);
+    replay.finish();
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_same_seed_gives_the_same_trace() {
+    SyntheticConfig config;
+    config.seconds = 20;
+    config.ectopicFraction = 0.1f;
+    config.motion = {{5, 8}};
+    config.leadOff = {{12, 13}};
+    config.sweepTimes = {2};
+    config.biaNoiseOhms = 1;
+    std::vector<TraceRecord> first = generate(config);
+    TEST_ASSERT_TRUE(sameRecords(first, generate(config)));
+
+    // restart() replays it too
+    SyntheticSignals signals(config);
+    TraceRecord record;
+    while (signals.next(record)) {}
+    signals.restart();
+    std::vector<TraceRecord> again;
+    while (signals.next(record)) again.push_back(record);
+    TEST_ASSERT_TRUE(sameRecords(first, again));
+
+    config.seed = 2;
+    TEST_ASSERT_FALSE(sameRecords(first, generate(config)));
+
+    // In time order, at the stream rates
+    size_t counts[3] = {};
+    for (size_t i = 0; i < first.size(); i++) {
+        if (i > 0) TEST_ASSERT_TRUE(first[i].timeUs >= first[i - 1].timeUs);
+        counts[(int)first[i].channel]++;
+    }
+    TEST_ASSERT_EQUAL(20 * ECG_STREAM_SAMPLE_RATE, counts[0]);
+    TEST_ASSERT_EQUAL(20 * PPG_STREAM_SAMPLE_RATE, counts[1]);
+    TEST_ASSERT_EQUAL(5, counts[2]);
+}
+
+void test_cole_model_limits() {
+    ColeModel cole;
+    float resistance, reactance;
+    cole.impedanceAt(1, resistance, reactance);
+    TEST_ASSERT_FLOAT_WITHIN(0.5f, cole.r0, resistance);
+    TEST_ASSERT_FLOAT_WITHIN(0.5f, 0, reactance);
+    cole.impedanceAt(1e9f, resistance, reactance);
+    TEST_ASSERT_FLOAT_WITHIN(1.0f, cole.rInf, resistance);
+
+    // An ideal RC (alpha 1) at fc sits at the top of the semicircle
+    cole.alpha = 1;
+    cole.impedanceAt(cole.fcHz, resistance, reactance);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, (cole.r0 + cole.rInf) / 2, resistance);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, (cole.r0 - cole.rInf) / 2, reactance);
+
+    // And the defaults pass the analyzer's range checks over the sweep
+    SyntheticConfig config;
+    for (float frequency : config.sweepFrequencies) {
+        config.cole.impedanceAt(frequency, resistance, reactance);
+        float phase = atanf(reactance / resistance) * 180 / M_PI;
+        TEST_ASSERT_TRUE(reactance >= BodyCompositionUtils::MIN_VALID_REACTANCE);
+        TEST_ASSERT_TRUE(phase >= BodyCompositionUtils::MIN_PHASE_ANGLE);
+    }
+}
+
+void test_rhythm_truth_has_hrv_and_compensated_ectopics() {
+    SyntheticConfig config;
+    config.seconds = 600;
+    config.ectopicFraction = 0.05f;
+    SyntheticSignals signals(config);
+    const SyntheticTruth& truth = signals.getTruth();
+
+    TEST_ASSERT_FLOAT_WITHIN(1.0f, config.heartRateBPM, truth.meanHeartRateBPM(0, config.seconds));
+    uint32_t ectopics = truth.ectopicBeats();
+    TEST_ASSERT_TRUE(ectopics > 20 && ectopics < 60);
+
+    double normalRR = 60.0 / config.heartRateBPM;
+    double shortest = 10;
+    double longest = 0;
+    const std::vector<SyntheticBeat>& beats = truth.beats;
+    for (size_t i = 1; i + 1 < beats.size(); i++) {
+        double rr = beats[i].rPeak - beats[i - 1].rPeak;
+        if (beats[i].ectopic) {
+            // Early, then a pause that puts the sinus rhythm back on time
+            TEST_ASSERT_TRUE(rr < 0.8 * normalRR);
+            double pair = beats[i + 1].rPeak - beats[i - 1].rPeak;
+            TEST_ASSERT_FLOAT_WITHIN(0.12, 2 * normalRR, pair);
+        } else if (!beats[i - 1].ectopic) {
+            shortest = std::min(shortest, rr);
+            longest = std::max(longest, rr);
+        }
+    }
+    // Respiratory sinus arrhythmia and jitter spread the sinus intervals
+    TEST_ASSERT_TRUE(longest - shortest > 2 * config.rsaFraction * normalRR);
+}
+
+void test_replay_recovers_heart_rate_and_ptt() {
+    SyntheticConfig config;
+    config.seconds = 120;
+    config.heartRateBPM = 75;
+    float measured[2];
+    const float transits[2] = {150, 250};
+    for (int i = 0; i < 2; i++) {
+        config.pttMs = transits[i];
+        SyntheticSignals signals(config);
+        SignalReplay replay;
+        replaySynthetic(signals, replay);
+        const ReplayReport& report = replay.getReport();
+        const SyntheticTruth& truth = signals.getTruth();
+
+        TEST_ASSERT_INT_WITHIN(3, truth.beatsBetween(0, config.seconds), report.rPeaks);
+        TEST_ASSERT_FLOAT_WITHIN(4.0f, truth.meanHeartRateBPM(config.seconds - 30, config.seconds), report.heartRateBPM);
+
+        TEST_ASSERT_TRUE(report.bloodPressure.size() >= 15);
+        double sum = 0;
+        for (const BloodPressureData& bp : report.bloodPressure) {
+            sum += bp.pulseTransitTime;
+        }
+        measured[i] = (float)(sum / report.bloodPressure.size());
+        char line[120];
+        snprintf(line, sizeof(line), "PTT %.0f ms true, %.1f ms measured; %.1f BPM true, %.1f BPM measured",
+                 truth.meanPttMs(0, config.seconds), measured[i], truth.meanHeartRateBPM(config.seconds - 30, config.seconds),
+                 report.heartRateBPM);
+        TEST_MESSAGE(line);
+        // The PPG band-pass delays the upstroke by a fixed amount
+        TEST_ASSERT_TRUE(measured[i] > transits[i]);
+        TEST_ASSERT_TRUE(measured[i] < transits[i] + 80);
+    }
+    // So differences in PTT come through one for one
+    TEST_ASSERT_FLOAT_WITHIN(10, transits[1] - transits[0], measured[1] - measured[0]);
+}
+
+void test_body_composition_sees_the_cole_tissue() {
+    SyntheticConfig config;
+    config.seconds = 40;
+    config.sweepTimes = {10, 25};
+    SyntheticSignals signals(config);
+    SignalReplay replay;
+    replaySynthetic(signals, replay);
+    const ReplayReport& report = replay.getReport();
+
+    const std::vector<double>& ends = signals.getTruth().sweepEnds;
+    TEST_ASSERT_EQUAL(2, ends.size());
+    TEST_ASSERT_EQUAL(2, report.bodyComposition.size());
+    float resistance, reactance;
+    config.cole.impedanceAt(50000, resistance, reactance);
+    for (size_t i = 0; i < ends.size(); i++) {
+        const BodyComposition& result = report.bodyComposition[i];
+        TEST_ASSERT_EQUAL_UINT32((uint32_t)(config.startUs / 1000 + ends[i] * 1000 + 0.5), result.timestamp);
+        // The tissue's 50 kHz point reaches the analyzer intact
+        TEST_ASSERT_TRUE(result.measurementQuality > 60);
+        TEST_ASSERT_FLOAT_WITHIN(0.01f, resistance, result.resistance50kHz);
+        TEST_ASSERT_FLOAT_WITHIN(0.01f, reactance, result.reactance50kHz);
+        TEST_ASSERT_FLOAT_WITHIN(0.01f, atanf(reactance / resistance) * 180 / M_PI, result.phaseAngle);
+    }
+}
+
+void test_lead_off_and_motion_reach_the_quality_chain() {
+    SyntheticConfig config;
+    config.seconds = 60;
+    config.leadOff = {{15, 17}, {30, 31}};
+    SyntheticSignals clean(config);
+    SignalReplay cleanReplay;
+    replaySynthetic(clean, cleanReplay);
+    TEST_ASSERT_EQUAL_UINT32(2, cleanReplay.getReport().leadOffResets);
+
+    config.motion = {{40, 60}};
+    SyntheticSignals moving(config);
+    SignalReplay movingReplay;
+    replaySynthetic(moving, movingReplay);
+
+    float cleanScore = cleanReplay.getReport().ppgQuality.score;
+    float movingScore = movingReplay.getReport().ppgQuality.score;
+    char line[80];
+    snprintf(line, sizeof(line), "PPG SQI %.0f still, %.0f moving", cleanScore, movingScore);
+    TEST_MESSAGE(line);
+    TEST_ASSERT_TRUE(cleanScore >= SQI_MIN_SCORE);
+    TEST_ASSERT_TRUE(movingScore < cleanScore - 20);
+}
+
+void test_file_and_direct_feeds_agree() {
+    SyntheticConfig config;
+    config.seconds = 30;
+    config.sweepTimes = {5};
+    SyntheticSignals signals(config);
+
+    char path[] = "/tmp/biotrack_syntheticXXXXXX";
+    int fd = mkstemp(path);
+    if (fd >= 0) close(fd);
+    uint64_t written = signals.writeTo(path, true);
+    TEST_ASSERT_EQUAL_UINT64(30 * (ECG_STREAM_SAMPLE_RATE + PPG_STREAM_SAMPLE_RATE) + 5, written);
+
+    SignalReplay fromFile;
+    TEST_ASSERT_TRUE(fromFile.run(path));
+    remove(path);
+    SignalReplay direct;
+    replaySynthetic(signals, direct);
+
+    const ReplayReport& a = fromFile.getReport();
+    const ReplayReport& b = direct.getReport();
+    TEST_ASSERT_EQUAL_UINT64(a.totalRecords(), b.totalRecords());
+    TEST_ASSERT_EQUAL_UINT32(a.rPeaks, b.rPeaks);
+    TEST_ASSERT_EQUAL_UINT32(a.pulses, b.pulses);
+    TEST_ASSERT_EQUAL(a.bloodPressure.size(), b.bloodPressure.size());
+    TEST_ASSERT_EQUAL_FLOAT(a.bloodPressure.back().pulseTransitTime, b.bloodPressure.back().pulseTransitTime);
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_same_seed_gives_the_same_trace);
+    RUN_TEST(test_cole_model_limits);
+    RUN_TEST(test_rhythm_truth_has_hrv_and_compensated_ectopics);
+    RUN_TEST(test_replay_recovers_heart_rate_and_ptt);
+    RUN_TEST(test_body_composition_sees_the_cole_tissue);
+    RUN_TEST(test_lead_off_and_motion_reach_the_quality_chain);
+    RUN_TEST(test_file_and_direct_feeds_agree);
+    return UNITY_END();
+}